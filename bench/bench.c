@@ -0,0 +1,550 @@
+#define _POSIX_C_SOURCE 200809L
+// bench/bench.c
+// Throughput / latency benchmark of the table manager (make bench).
+//
+// For every table size and cache mode, a fresh table is built and each
+// workload is timed op by op:
+//   insert_seq  N inserts into an empty table
+//   get_seq     N gets in id order          get_rand     N gets, shuffled
+//   update_seq  N updates in id order       update_rand  N updates, shuffled
+//   scan        full tblmgr_scan passes (ops = rows visited)
+//   scan_par    the same with tblmgr_scan_parallel, one worker per CPU
+//   delete_rand N/2 deletes, shuffled
+//   insert_rand N/2 inserts refilling the scattered holes (free-space map)
+//   delete_seq  every remaining row, in id order
+//
+// Cache modes:
+//   warm  buffer pool sized for the whole table, pre-loaded by a scan
+//   cold  default pool; before each workload the pager is closed, the file's
+//         OS page cache dropped (posix_fadvise) and the pager reopened
+//
+// --io picks the pager's batched I/O backend (read-ahead of scans, flushes).
+//
+// Results: one record per (rows, cache, op) with ops/s and p50/p99/p999/max
+// latencies in nanoseconds, as JSON (default) or CSV.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Defaults
+// ─────────────────────────────────────────────────────────────────────────────
+#define BENCH_DEFAULT_ROWS    "10000,1000000"
+/* Every size keeps its record ids and latencies in memory (12 bytes a row) */
+#define BENCH_MAX_ROWS        100000000u
+#define BENCH_DEFAULT_DB      "bench/tmp_bench.db"
+#define BENCH_ROOT            1u
+#define BENCH_SCAN_PASSES     3
+#define BENCH_MAX_SIZES       8
+
+enum { CACHE_WARM = 1, CACHE_COLD = 2 };
+
+typedef struct BenchOpts {
+  size_t      rows[BENCH_MAX_SIZES];
+  size_t      nsizes;
+  int         cache_modes;   /* CACHE_WARM | CACHE_COLD */
+  int         csv;
+  const char* out_path;      /* NULL = stdout */
+  const char* db_path;
+  uint64_t    seed;
+  uint32_t    page_size;     /* page size of the bench file */
+  PioBackend  io_backend;    /* PagerConfig.io_backend */
+  bool        paranoid;      /* PagerConfig.paranoid (--validate every) */
+} BenchOpts;
+
+/* One timed workload */
+typedef struct Result {
+  size_t   rows;
+  const char* cache;
+  size_t   cache_pages;
+  uint32_t page_size;
+  const char* io;
+  const char* op;
+  uint64_t ops;
+  double   seconds;
+  uint32_t p50, p99, p999, max;   /* ns */
+} Result;
+
+/* State shared by the workloads of one run */
+typedef struct Run {
+  const BenchOpts* o;
+  Pager*      p;
+  PagerConfig cfg;
+  int         cold;
+  size_t      rows;
+  uint64_t*   ids;       /* live record ids, rows entries */
+  uint32_t*   lat;       /* per-op latencies (ns) */
+  uint64_t    rng;
+  FILE*       out;
+  size_t      nresults;
+} Run;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static void die(const char* what, int rc) {
+  fprintf(stderr, "bench: %s failed (rc=%d)\n", what, rc);
+  exit(1);
+}
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Records per leaf: header, one bitmap bit and TABLE_RECORD_SIZE bytes per slot */
+static inline size_t bench_leaf_capacity(uint32_t page_size) {
+  return ((size_t)page_size - TABLE_HDR_SIZE) * 8u / (TABLE_RECORD_SIZE * 8u + 1u);
+}
+
+static inline uint32_t clamp_ns(uint64_t ns) {
+  return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+/**
+ * @brief xorshift64* step: deterministic for a given --seed.
+ */
+static inline uint64_t rng_next(uint64_t* s) {
+  uint64_t x = *s;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *s = x;
+  return x * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * @brief Record generator: u32 serial, then pseudo-random payload bytes.
+ */
+static void make_record(uint8_t rec[TABLE_RECORD_SIZE], uint32_t serial, uint64_t* rng) {
+  for (size_t i = 0; i < TABLE_RECORD_SIZE; i += 8) {
+    const uint64_t v = rng_next(rng);
+    memcpy(rec + i, &v, 8);
+  }
+  rec[0] = (uint8_t)serial;
+  rec[1] = (uint8_t)(serial >> 8);
+  rec[2] = (uint8_t)(serial >> 16);
+  rec[3] = (uint8_t)(serial >> 24);
+}
+
+static void shuffle(uint64_t* a, size_t n, uint64_t* rng) {
+  for (size_t i = n; i > 1; i--) {
+    const size_t j = (size_t)(rng_next(rng) % i);
+    const uint64_t t = a[i - 1];
+    a[i - 1] = a[j];
+    a[j] = t;
+  }
+}
+
+static int cmp_u32(const void* a, const void* b) {
+  const uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Latency at quantile q of n sorted samples (nearest rank).
+ */
+static uint32_t quantile(const uint32_t* sorted, size_t n, double q) {
+  if (n == 0) return 0;
+  size_t rank = (size_t)(q * (double)n + 0.5);
+  if (rank == 0) rank = 1;
+  if (rank > n) rank = n;
+  return sorted[rank - 1];
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Pager lifecycle
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Write back and evict the database file from the OS page cache.
+ */
+static void drop_os_cache(const char* path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  (void)fsync(fd);
+#ifdef POSIX_FADV_DONTNEED
+  (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  close(fd);
+}
+
+static void run_open(Run* r) {
+  int rc = pager_open_ex(r->o->db_path, &r->cfg, &r->p);
+  if (rc != PAGER_OK) die("pager_open_ex", rc);
+}
+
+static void run_reopen_cold(Run* r) {
+  pager_close(r->p);
+  r->p = NULL;
+  drop_os_cache(r->o->db_path);
+  run_open(r);
+}
+
+static int count_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec;
+  (void)id;
+  (*(uint64_t*)ud)++;
+  return 0;
+}
+
+/**
+ * @brief Get the pool into the mode's starting state before a workload.
+ */
+static void run_prepare(Run* r) {
+  if (r->cold) {
+    run_reopen_cold(r);
+    return;
+  }
+  uint64_t n = 0;
+  int rc = tblmgr_scan(r->p, BENCH_ROOT, count_cb, &n);
+  if (rc != TABLE_OK) die("warm-up scan", rc);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Reporting
+// ─────────────────────────────────────────────────────────────────────────────
+static void emit(Run* r, const Result* res) {
+  const double ops_s = res->seconds > 0 ? (double)res->ops / res->seconds : 0.0;
+
+  if (r->o->csv) {
+    if (r->nresults == 0)
+      fprintf(r->out, "rows,cache,cache_pages,page_size,io,op,ops,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns,max_ns\n");
+    fprintf(r->out, "%zu,%s,%zu,%u,%s,%s,%llu,%.6f,%.1f,%u,%u,%u,%u\n",
+            res->rows, res->cache, res->cache_pages, res->page_size, res->io, res->op, (unsigned long long)res->ops,
+            res->seconds, ops_s, res->p50, res->p99, res->p999, res->max);
+  } else {
+    fprintf(r->out,
+            "%s  {\"rows\": %zu, \"cache\": \"%s\", \"cache_pages\": %zu, \"page_size\": %u, \"io\": \"%s\", \"op\": \"%s\", "
+            "\"ops\": %llu, \"seconds\": %.6f, \"ops_per_sec\": %.1f, "
+            "\"p50_ns\": %u, \"p99_ns\": %u, \"p999_ns\": %u, \"max_ns\": %u}",
+            r->nresults == 0 ? "[\n" : ",\n",
+            res->rows, res->cache, res->cache_pages, res->page_size, res->io, res->op,
+            (unsigned long long)res->ops, res->seconds, ops_s, res->p50, res->p99, res->p999, res->max);
+  }
+  fflush(r->out);
+  r->nresults++;
+
+  fprintf(stderr, "  %-12s %12.0f ops/s   p50 %7u ns   p99 %8u ns   p999 %9u ns\n",
+          res->op, ops_s, res->p50, res->p99, res->p999);
+}
+
+/**
+ * @brief Turn n latency samples (lat[]) and a wall time into a result line.
+ */
+static void report(Run* r, const char* op, size_t n, uint64_t ops, uint64_t wall_ns) {
+  qsort(r->lat, n, sizeof *r->lat, cmp_u32);
+  Result res = {
+    .rows = r->rows,
+    .cache = r->cold ? "cold" : "warm",
+    .cache_pages = r->cfg.cache_pages ? r->cfg.cache_pages : PAGER_DEFAULT_CACHE_PAGES,
+    .page_size = r->o->page_size,
+    .io = pio_backend_name(pager_io_backend(r->p)),
+    .op = op,
+    .ops = ops,
+    .seconds = (double)wall_ns / 1e9,
+    .p50 = quantile(r->lat, n, 0.50),
+    .p99 = quantile(r->lat, n, 0.99),
+    .p999 = quantile(r->lat, n, 0.999),
+    .max = n ? r->lat[n - 1] : 0,
+  };
+  emit(r, &res);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Workloads
+// ─────────────────────────────────────────────────────────────────────────────
+
+/* ids[from, from + n) receive the new record ids */
+static void bench_insert(Run* r, const char* op, size_t from, size_t n) {
+  uint8_t rec[TABLE_RECORD_SIZE];
+  const uint64_t t0 = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    make_record(rec, (uint32_t)(from + i), &r->rng);
+    const uint64_t s = now_ns();
+    int rc = tblmgr_insert(r->p, BENCH_ROOT, rec, &r->ids[from + i]);
+    r->lat[i] = clamp_ns(now_ns() - s);
+    if (rc != TABLE_OK) die("tblmgr_insert", rc);
+  }
+  report(r, op, n, n, now_ns() - t0);
+}
+
+static void bench_get(Run* r, const char* op, const uint64_t* order, size_t n) {
+  uint8_t rec[TABLE_RECORD_SIZE];
+  const uint64_t t0 = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t s = now_ns();
+    int rc = tblmgr_get(r->p, order[i], rec);
+    r->lat[i] = clamp_ns(now_ns() - s);
+    if (rc != TABLE_OK) die("tblmgr_get", rc);
+  }
+  report(r, op, n, n, now_ns() - t0);
+}
+
+static void bench_update(Run* r, const char* op, const uint64_t* order, size_t n) {
+  uint8_t rec[TABLE_RECORD_SIZE];
+  const uint64_t t0 = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    make_record(rec, (uint32_t)i, &r->rng);
+    const uint64_t s = now_ns();
+    int rc = tblmgr_update(r->p, order[i], rec);
+    r->lat[i] = clamp_ns(now_ns() - s);
+    if (rc != TABLE_OK) die("tblmgr_update", rc);
+  }
+  report(r, op, n, n, now_ns() - t0);
+}
+
+static void bench_delete(Run* r, const char* op, const uint64_t* order, size_t n) {
+  const uint64_t t0 = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t s = now_ns();
+    int rc = tblmgr_delete(r->p, order[i]);
+    r->lat[i] = clamp_ns(now_ns() - s);
+    if (rc != TABLE_OK) die("tblmgr_delete", rc);
+  }
+  report(r, op, n, n, now_ns() - t0);
+}
+
+static void bench_scan(Run* r) {
+  uint64_t visited = 0;
+  const uint64_t t0 = now_ns();
+  for (size_t i = 0; i < BENCH_SCAN_PASSES; i++) {
+    const uint64_t s = now_ns();
+    int rc = tblmgr_scan(r->p, BENCH_ROOT, count_cb, &visited);
+    r->lat[i] = clamp_ns(now_ns() - s);
+    if (rc != TABLE_OK) die("tblmgr_scan", rc);
+  }
+  if (visited != (uint64_t)r->rows * BENCH_SCAN_PASSES) die("scan row count", -1);
+  report(r, "scan", BENCH_SCAN_PASSES, visited, now_ns() - t0);
+}
+
+// Per-worker row counters for scan_par, summed by the merge hook
+static void* par_count_init(unsigned worker, void* ud) {
+  (void)worker;
+  (void)ud;
+  return calloc(1, sizeof(uint64_t));
+}
+
+static int par_count_merge(void* worker_data, void* ud) {
+  if (!worker_data) return TABLE_E_INVAL;
+  *(uint64_t*)ud += *(uint64_t*)worker_data;
+  free(worker_data);
+  return 0;
+}
+
+static void bench_scan_parallel(Run* r) {
+  uint64_t visited = 0;
+  TblParallelScan opts = {
+    .callback = count_cb, .worker_init = par_count_init,
+    .merge = par_count_merge, .user_data = &visited
+  };
+  const uint64_t t0 = now_ns();
+  for (size_t i = 0; i < BENCH_SCAN_PASSES; i++) {
+    const uint64_t s = now_ns();
+    int rc = tblmgr_scan_parallel(r->p, BENCH_ROOT, &opts);
+    r->lat[i] = clamp_ns(now_ns() - s);
+    if (rc != TABLE_OK) die("tblmgr_scan_parallel", rc);
+  }
+  if (visited != (uint64_t)r->rows * BENCH_SCAN_PASSES) die("scan_par row count", -1);
+  report(r, "scan_par", BENCH_SCAN_PASSES, visited, now_ns() - t0);
+}
+
+/**
+ * @brief All workloads for one table size in one cache mode, on a new file.
+ */
+static void run_one(Run* r, size_t rows, int cold) {
+  r->rows = rows;
+  r->cold = cold;
+  memset(&r->cfg, 0, sizeof r->cfg);
+  r->cfg.page_size = r->o->page_size;
+  r->cfg.io_backend = r->o->io_backend;
+  r->cfg.paranoid = r->o->paranoid;
+  if (!cold) {
+    // The table's leaves plus its free-space map pages, with some slack
+    const size_t leaves = rows / bench_leaf_capacity(r->o->page_size) + 1u;
+    r->cfg.cache_pages = leaves + leaves / 512u + 64u;
+    if (r->cfg.cache_pages < PAGER_MIN_CACHE_PAGES) r->cfg.cache_pages = PAGER_MIN_CACHE_PAGES;
+  }
+
+  remove(r->o->db_path);
+  run_open(r);
+  fprintf(stderr, "rows=%zu cache=%s page_size=%u io=%s\n", rows, cold ? "cold" : "warm",
+          r->o->page_size, pio_backend_name(pager_io_backend(r->p)));
+  int rc = tblmgr_create(r->p, BENCH_ROOT);
+  if (rc != TABLE_OK) die("tblmgr_create", rc);
+
+  uint64_t* order = (uint64_t*)malloc(rows * sizeof *order);
+  if (!order) die("malloc", -1);
+
+  bench_insert(r, "insert_seq", 0, rows);
+
+  run_prepare(r);
+  bench_get(r, "get_seq", r->ids, rows);
+  memcpy(order, r->ids, rows * sizeof *order);
+  shuffle(order, rows, &r->rng);
+  run_prepare(r);
+  bench_get(r, "get_rand", order, rows);
+
+  run_prepare(r);
+  bench_update(r, "update_seq", r->ids, rows);
+  run_prepare(r);
+  bench_update(r, "update_rand", order, rows);
+
+  run_prepare(r);
+  bench_scan(r);
+  run_prepare(r);
+  bench_scan_parallel(r);
+
+  // Delete a random half (its ids sit at the front of `order`), keep the
+  // other half in ids[0, keep), then refill the holes
+  const size_t half = rows / 2, keep = rows - half;
+  run_prepare(r);
+  bench_delete(r, "delete_rand", order, half);
+  memcpy(r->ids, order + half, keep * sizeof *order);
+  run_prepare(r);
+  bench_insert(r, "insert_rand", keep, half);
+
+  memcpy(order, r->ids, rows * sizeof *order);
+  qsort(order, rows, sizeof *order, cmp_u32);
+  run_prepare(r);
+  bench_delete(r, "delete_seq", order, rows);
+
+  free(order);
+  pager_close(r->p);
+  r->p = NULL;
+  remove(r->o->db_path);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Command line
+// ─────────────────────────────────────────────────────────────────────────────
+static void usage(const char* prog) {
+  fprintf(stderr,
+    "Usage: %s [--rows N[,N...]] [--cache warm|cold|both] [--format json|csv]\n"
+    "          [--out FILE] [--db FILE] [--seed N] [--page-size BYTES]\n"
+    "          [--io auto|sync|threads|io_uring] [--validate once|every]\n"
+    "Defaults: --rows " BENCH_DEFAULT_ROWS " --cache both --format json --db " BENCH_DEFAULT_DB
+    " --page-size 4096 --io auto --validate once\n",
+    prog);
+  exit(2);
+}
+
+static void parse_rows(BenchOpts* o, const char* list) {
+  char buf[256];
+  if (strlen(list) >= sizeof buf) die("--rows list too long", -1);
+  strcpy(buf, list);
+
+  o->nsizes = 0;
+  for (char* tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+    char* end = NULL;
+    unsigned long long v = strtoull(tok, &end, 10);
+    if (!end || *end != '\0' || v < 2 || o->nsizes == BENCH_MAX_SIZES) {
+      fprintf(stderr, "bench: bad --rows value '%s'\n", tok);
+      exit(2);
+    }
+    o->rows[o->nsizes++] = (size_t)v;
+  }
+  if (o->nsizes == 0) die("--rows is empty", -1);
+}
+
+static void parse_args(int argc, char** argv, BenchOpts* o) {
+  memset(o, 0, sizeof *o);
+  parse_rows(o, BENCH_DEFAULT_ROWS);
+  o->cache_modes = CACHE_WARM | CACHE_COLD;
+  o->db_path = BENCH_DEFAULT_DB;
+  o->seed = 0x9E3779B97F4A7C15ull;
+  o->page_size = PAGER_PAGE_SIZE;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!v) usage(argv[0]);
+    if (strcmp(a, "--rows") == 0) {
+      parse_rows(o, v);
+    } else if (strcmp(a, "--cache") == 0) {
+      if      (strcmp(v, "warm") == 0) o->cache_modes = CACHE_WARM;
+      else if (strcmp(v, "cold") == 0) o->cache_modes = CACHE_COLD;
+      else if (strcmp(v, "both") == 0) o->cache_modes = CACHE_WARM | CACHE_COLD;
+      else usage(argv[0]);
+    } else if (strcmp(a, "--format") == 0) {
+      if      (strcmp(v, "json") == 0) o->csv = 0;
+      else if (strcmp(v, "csv") == 0)  o->csv = 1;
+      else usage(argv[0]);
+    } else if (strcmp(a, "--out") == 0) {
+      o->out_path = v;
+    } else if (strcmp(a, "--db") == 0) {
+      o->db_path = v;
+    } else if (strcmp(a, "--seed") == 0) {
+      o->seed = strtoull(v, NULL, 10);
+      if (o->seed == 0) o->seed = 1;   // xorshift needs a non-zero state
+    } else if (strcmp(a, "--page-size") == 0) {
+      o->page_size = (uint32_t)strtoul(v, NULL, 10);
+      if (o->page_size < PAGER_MIN_PAGE_SIZE || o->page_size > PAGER_MAX_PAGE_SIZE ||
+          (o->page_size & (o->page_size - 1)) != 0) {
+        fprintf(stderr, "bench: --page-size must be a power of two from %u to %u\n",
+                PAGER_MIN_PAGE_SIZE, PAGER_MAX_PAGE_SIZE);
+        exit(2);
+      }
+    } else if (strcmp(a, "--io") == 0) {
+      if      (strcmp(v, "auto") == 0)     o->io_backend = PIO_BACKEND_AUTO;
+      else if (strcmp(v, "sync") == 0)     o->io_backend = PIO_BACKEND_SYNC;
+      else if (strcmp(v, "threads") == 0)  o->io_backend = PIO_BACKEND_THREADS;
+      else if (strcmp(v, "io_uring") == 0) o->io_backend = PIO_BACKEND_URING;
+      else usage(argv[0]);
+    } else if (strcmp(a, "--validate") == 0) {
+      if      (strcmp(v, "once") == 0)  o->paranoid = false;
+      else if (strcmp(v, "every") == 0) o->paranoid = true;
+      else usage(argv[0]);
+    } else {
+      usage(argv[0]);
+    }
+    i++;
+  }
+
+  for (size_t k = 0; k < o->nsizes; k++) {
+    if (o->rows[k] > BENCH_MAX_ROWS) {
+      fprintf(stderr, "bench: --rows %zu exceeds %u\n", o->rows[k], BENCH_MAX_ROWS);
+      exit(2);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  BenchOpts o;
+  parse_args(argc, argv, &o);
+
+  size_t max_rows = 0;
+  for (size_t i = 0; i < o.nsizes; i++)
+    if (o.rows[i] > max_rows) max_rows = o.rows[i];
+
+  Run r;
+  memset(&r, 0, sizeof r);
+  r.o = &o;
+  r.rng = o.seed;
+  r.ids = (uint64_t*)malloc(max_rows * sizeof *r.ids);
+  r.lat = (uint32_t*)malloc(max_rows * sizeof *r.lat);
+  if (!r.ids || !r.lat) die("malloc", -1);
+
+  r.out = o.out_path ? fopen(o.out_path, "w") : stdout;
+  if (!r.out) { perror(o.out_path); return 1; }
+
+  for (size_t i = 0; i < o.nsizes; i++) {
+    if (o.cache_modes & CACHE_WARM) run_one(&r, o.rows[i], 0);
+    if (o.cache_modes & CACHE_COLD) run_one(&r, o.rows[i], 1);
+  }
+  if (!o.csv) fprintf(r.out, r.nresults ? "\n]\n" : "[]\n");
+
+  if (r.out != stdout) fclose(r.out);
+  free(r.ids);
+  free(r.lat);
+  return 0;
+}
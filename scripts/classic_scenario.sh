@@ -42,43 +42,83 @@ write_record_file() {
   elif [ "$bytes" -gt 128 ]; then : > "$out.tmp"; head -c 128 "$out" > "$out.tmp"; mv "$out.tmp" "$out"; fi
 }
 
-echo "[1/10] cleanup"
+echo "[1/11] cleanup"
 rm -f "$DB"
 
-echo "[2/10] create table @page $ROOT"
+echo "[2/11] create table @page $ROOT"
 ./mdb "$DB" create $ROOT
 
-echo "[3/10] build 3 classic records (name/age/city/note) -> 128 bytes each"
+echo "[3/11] build 3 classic records (name/age/city/note) -> 128 bytes each"
 R1="$TMPDIR/alice.bin"; R2="$TMPDIR/bob.bin"; R3="$TMPDIR/carol.bin"
 write_record_file "$R1" "Alice" 30 "Paris" "Loves baguettes"
 write_record_file "$R2" "Bob"   25 "Lyon"  "Enjoys silk history"
 write_record_file "$R3" "Carol" 28 "Tokyo" "Karaoke on Fridays"
 
-echo "[4/10] insert them"
+echo "[4/11] insert them"
 ID1=$(./mdb "$DB" insert $ROOT "$R1"); echo "  Alice -> $ID1"
 ID2=$(./mdb "$DB" insert $ROOT "$R2"); echo "  Bob   -> $ID2"
 ID3=$(./mdb "$DB" insert $ROOT "$R3"); echo "  Carol -> $ID3"
 
-echo "[5/10] pretty list (table view)"
+echo "[5/11] pretty list (table view)"
 ./mdb "$DB" listf $ROOT "$SPEC"
 
-echo "[6/10] pretty get (Alice)"
+echo "[6/11] pretty get (Alice)"
 ./mdb "$DB" getf "$ID1" "$SPEC"
 
-echo "[7/10] update Bob’s note (and show table again)"
+echo "[7/11] hash index on name, B+tree index on age, then lookups"
+./mdb "$DB" index $ROOT "name:0:32:s"
+./mdb "$DB" index $ROOT "age:32:1:u8" btree
+[ "$(./mdb "$DB" find $ROOT name=Bob)" = "$ID2" ] || { echo "find Bob failed"; exit 1; }
+[ -z "$(./mdb "$DB" find $ROOT name=Dave)" ] || { echo "find Dave should be empty"; exit 1; }
+echo "  name=Bob -> $ID2"
+[ "$(./mdb "$DB" range $ROOT age 26 30 | tr '\n' ' ')" = "$ID3 $ID1 " ] || { echo "range age 26..30 failed"; exit 1; }
+[ "$(./mdb "$DB" top $ROOT age 1)" = "$ID1" ] || { echo "top age failed"; exit 1; }
+echo "  age in [26,30] -> $ID3 $ID1 (oldest: $ID1)"
+LISTF=$(./mdb "$DB" listf $ROOT "$SPEC" --where 'age=26..30,city^=Pa')
+echo "$LISTF" | grep -q "Alice" && echo "$LISTF" | grep -q "^1 row(s)$" || { echo "listf --where failed"; exit 1; }
+[ "$(./mdb "$DB" listf $ROOT "$SPEC" --where 'age<25' | tail -1)" = "0 row(s)" ] || { echo "listf --where age<25 failed"; exit 1; }
+echo "  listf --where age=26..30,city^=Pa -> Alice"
+[ "$(./mdb "$DB" listf $ROOT "name:0:32:s,age:32:1:u8" --format=csv --where 'age=30')" = "$(printf 'id,name,age\n%s,Alice,30' "$ID1")" ] || { echo "listf --format=csv failed"; exit 1; }
+./mdb "$DB" getf "$ID1" "$SPEC" --format=raw | cmp -s - "$R1" || { echo "getf --format=raw failed"; exit 1; }
+echo "  listf --format=csv / getf --format=raw -> Alice"
+AGG=$(./mdb "$DB" agg $ROOT "$SPEC" 'count,avg(age),max(age) by city' | grep '^| Paris')
+echo "$AGG" | grep -Eq '\| +1 \| +30\.00 \| +30 \|$' || { echo "agg by city failed: $AGG"; exit 1; }
+echo "  agg count,avg(age),max(age) by city -> Paris: 1, 30.00, 30"
+
+echo "[8/11] update Bob’s note (and show table again)"
 R2U="$TMPDIR/bob_update.bin"
 write_record_file "$R2U" "Bob" 25 "Lyon" "Now learning databases!"
 ./mdb "$DB" update "$ID2" "$R2U"
 ./mdb "$DB" listf $ROOT "$SPEC"
 
-echo "[8/10] delete Carol (and show table again)"
+echo "[9/11] delete Carol (and show table again)"
 ./mdb "$DB" delete "$ID3"
+[ -z "$(./mdb "$DB" find $ROOT name=Carol)" ] || { echo "index still lists Carol"; exit 1; }
+[ "$(./mdb "$DB" range $ROOT age 26 -)" = "$ID1" ] || { echo "age index still lists Carol"; exit 1; }
 ./mdb "$DB" listf $ROOT "$SPEC"
 
-echo "[9/10] validate integrity"
+echo "[10/11] validate integrity (and the catalog row count)"
 ./mdb "$DB" validate $ROOT
+[ "$(./mdb "$DB" count $ROOT)" = "2" ] || { echo "count after delete failed"; exit 1; }
+./mdb "$DB" tables
 
-echo "[10/10] persistence spot-check (re-read pretty table)"
+echo "[11/11] persistence spot-check (re-read pretty table, then one pipelined shell batch)"
 ./mdb "$DB" listf $ROOT "$SPEC"
+OUT=$(printf 'find %s name=Bob\nrange %s age 26 -\nget 0\nvalidate %s\n' $ROOT $ROOT $ROOT \
+      | ./mdb "$DB" shell 2>/dev/null | tr '\n' ' ')
+[ "$OUT" = "$ID2 %ok $ID1 %ok %err 1 ok %ok " ] || { echo "shell batch failed: $OUT"; exit 1; }
+echo "  shell: $OUT"
+TXN=$(printf 'begin\ndelete %s\ncount %s\nabort\ncount %s\n' "$ID1" $ROOT $ROOT \
+      | ./mdb "$DB" shell 2>/dev/null | tr '\n' ' ')
+[ "$TXN" = "%ok ok %ok 1 %ok %ok 2 %ok " ] || { echo "shell transaction failed: $TXN"; exit 1; }
+echo "  shell: begin / delete / abort -> $TXN"
+FAIL=$(printf 'begin\ndelete %s\nget 0\ncommit\ncount %s\n' "$ID1" $ROOT \
+      | ./mdb "$DB" shell 2>/dev/null | tr '\n' ' ')
+[ "$FAIL" = "%ok ok %ok %err 1 %err 1 2 %ok " ] || { echo "failed shell transaction was kept: $FAIL"; exit 1; }
+echo "  shell: begin / delete / failing get / commit -> $FAIL"
+STATS=$(./mdb --stats "$DB" validate $ROOT 2>&1 >/dev/null)
+echo "$STATS" | grep -Eq '^leaf_validations +[1-9]' && echo "$STATS" | grep -q '^validate ' \
+  || { echo "--stats failed: $STATS"; exit 1; }
+echo "  --stats validate -> $(echo "$STATS" | grep '^leaf_validations' | tr -s ' ')"
 
 echo "Classic example (pretty) done ✓"
@@ -0,0 +1,306 @@
+#include "agg.h"
+#include "arena.h"
+#include "table.h"
+#include "table_manager.h"
+#include "index_key.h"
+#include "crc32c.h"
+#include "endian_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Group table (open addressing on the key hash)
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct Slot {
+  AggGroup* g;
+  uint32_t  hash;
+} Slot;
+
+struct AggResult {
+  const AggSpec* spec;      // spec_copy (a worker table: the main result's)
+  AggSpec        spec_copy;
+  size_t         key_len;
+  Arena*         mem;       // holds the result and everything in it: &own or AggSpec.arena
+  Arena          own;
+  Slot*          slots;     // capacity is a power of two
+  size_t         cap, n;
+  AggGroup**     sorted;    // the groups in key order, once the scan is done
+};
+
+static inline bool is_int(uint8_t type) {
+  return type == INDEX_KEY_U8 || type == INDEX_KEY_U16 || type == INDEX_KEY_U32;
+}
+
+static inline uint32_t read_int(const uint8_t* rec, const AggField* f) {
+  const uint8_t* p = rec + f->off;
+  return f->len == 1 ? p[0] : f->len == 2 ? read_le_u16(p) : read_le_u32(p);
+}
+
+static inline bool field_ok(const AggField* f) {
+  IndexKey k = { .name = "agg", .off = f->off, .len = f->len, .type = f->type };
+  return index_key_valid(&k);
+}
+
+static void group_init(const AggSpec* s, AggGroup* g) {
+  g->rows = 0;
+  for (int k = 0; k < s->nfuncs; k++)
+    g->acc[k] = s->func[k] == AGG_MIN ? UINT64_MAX : 0;
+}
+
+static void group_fold(const AggSpec* s, AggGroup* g, const uint8_t* rec) {
+  g->rows++;
+  for (int k = 0; k < s->nfuncs; k++) {
+    switch (s->func[k]) {
+      case AGG_COUNT: g->acc[k]++; break;
+      case AGG_SUM:
+      case AGG_AVG:   g->acc[k] += read_int(rec, &s->arg[k]); break;
+      case AGG_MIN:   { const uint64_t v = read_int(rec, &s->arg[k]); if (v < g->acc[k]) g->acc[k] = v; } break;
+      case AGG_MAX:   { const uint64_t v = read_int(rec, &s->arg[k]); if (v > g->acc[k]) g->acc[k] = v; } break;
+    }
+  }
+}
+
+static void group_merge(const AggSpec* s, AggGroup* into, const AggGroup* from) {
+  into->rows += from->rows;
+  for (int k = 0; k < s->nfuncs; k++) {
+    switch (s->func[k]) {
+      case AGG_MIN: if (from->acc[k] < into->acc[k]) into->acc[k] = from->acc[k]; break;
+      case AGG_MAX: if (from->acc[k] > into->acc[k]) into->acc[k] = from->acc[k]; break;
+      default:      into->acc[k] += from->acc[k]; break;
+    }
+  }
+}
+
+static int table_grow(AggResult* r) {
+  const size_t cap = r->cap ? r->cap * 2u : 64u;
+  // The old table stays in the arena until the result goes
+  Slot* slots = arena_calloc(r->mem, cap * sizeof *slots);
+  if (!slots) return TABLE_E_INVAL;
+  for (size_t i = 0; i < r->cap; i++) {
+    if (!r->slots[i].g) continue;
+    size_t j = r->slots[i].hash & (cap - 1u);
+    while (slots[j].g) j = (j + 1u) & (cap - 1u);
+    slots[j] = r->slots[i];
+  }
+  r->slots = slots;
+  r->cap = cap;
+  return TABLE_OK;
+}
+
+/**
+ * @brief The group of `key` (key_len bytes), created on first use.
+ * @return The group, or NULL when out of memory.
+ */
+static AggGroup* group_get(AggResult* r, const uint8_t* key, uint32_t hash) {
+  if ((r->n + 1u) * 4u > r->cap * 3u && table_grow(r) != TABLE_OK) return NULL;
+
+  size_t j = hash & (r->cap - 1u);
+  for (; r->slots[j].g; j = (j + 1u) & (r->cap - 1u))
+    if (r->slots[j].hash == hash && memcmp(r->slots[j].g->key, key, r->key_len) == 0)
+      return r->slots[j].g;
+
+  AggGroup* g = arena_alloc(r->mem, sizeof *g + r->key_len);
+  if (!g) return NULL;
+  uint8_t* k = (uint8_t*)(g + 1);
+  memcpy(k, key, r->key_len);
+  g->key = k;
+  group_init(r->spec, g);
+  r->slots[j] = (Slot){ .g = g, .hash = hash };
+  r->n++;
+  return g;
+}
+
+/**
+ * @brief An empty result, carved from `into` (NULL: from a heap arena of its own).
+ */
+static AggResult* result_new(const AggSpec* spec, Arena* into) {
+  AggResult* r = into ? arena_calloc(into, sizeof *r) : calloc(1, sizeof *r);
+  if (!r) return NULL;
+  r->mem = into ? into : &r->own;
+  r->spec = spec;
+  r->key_len = agg_key_len(spec);
+  return r;
+}
+
+static int fold_cb(const void* record, uint64_t id, void* ud) {
+  (void)id;
+  AggResult* r = (AggResult*)ud;
+  if (!r) return TABLE_E_INVAL;   // a worker table could not be allocated
+  const AggSpec* s = r->spec;
+  const uint8_t* rec = (const uint8_t*)record;
+
+  uint8_t key[AGG_MAX_GROUP * TABLE_RECORD_SIZE];
+  size_t len = 0;
+  for (int i = 0; i < s->ngroup; i++) {
+    memcpy(key + len, rec + s->group[i].off, s->group[i].len);
+    len += s->group[i].len;
+  }
+  AggGroup* g = group_get(r, key, crc32c(0, key, len));
+  if (!g) return TABLE_E_INVAL;
+  group_fold(s, g, rec);
+  return 0;
+}
+
+static void* worker_new(unsigned worker, void* user_data) {
+  (void)worker;
+  // Worker tables fill in other threads: never in the caller's arena
+  return result_new(((AggResult*)user_data)->spec, NULL);
+}
+
+static int worker_merge(void* worker_data, void* user_data) {
+  AggResult* w = (AggResult*)worker_data;
+  AggResult* r = (AggResult*)user_data;
+  if (!w) return TABLE_E_INVAL;
+  int rc = TABLE_OK;
+  for (size_t i = 0; i < w->cap && rc == TABLE_OK; i++) {
+    if (!w->slots[i].g) continue;
+    AggGroup* g = group_get(r, w->slots[i].g->key, w->slots[i].hash);
+    if (!g) rc = TABLE_E_INVAL;
+    else    group_merge(r->spec, g, w->slots[i].g);
+  }
+  agg_free(w);
+  return rc;
+}
+
+static int group_cmp(const AggSpec* s, const AggGroup* x, const AggGroup* y) {
+  size_t off = 0;
+  for (int i = 0; i < s->ngroup; i++) {
+    IndexKey k = { .off = 0, .len = s->group[i].len, .type = s->group[i].type };
+    const int c = index_key_cmp(&k, x->key + off, y->key + off);
+    if (c) return c;
+    off += s->group[i].len;
+  }
+  return 0;
+}
+
+/**
+ * @brief Bottom-up merge sort of a[0..n) by key (qsort takes no context,
+ *        and results may be built in several threads at once).
+ */
+static int sort_groups(const AggSpec* s, Arena* mem, AggGroup** a, size_t n) {
+  if (n < 2) return TABLE_OK;
+  const ArenaMark m = arena_mark(mem);
+  AggGroup** tmp = arena_alloc(mem, n * sizeof *tmp);
+  if (!tmp) return TABLE_E_INVAL;
+  AggGroup** from = a;
+  AggGroup** to = tmp;
+  for (size_t width = 1; width < n; width *= 2) {
+    for (size_t lo = 0; lo < n; lo += 2 * width) {
+      const size_t mid = lo + width < n ? lo + width : n;
+      const size_t hi  = lo + 2 * width < n ? lo + 2 * width : n;
+      size_t i = lo, j = mid, k = lo;
+      while (i < mid && j < hi) to[k++] = group_cmp(s, from[j], from[i]) < 0 ? from[j++] : from[i++];
+      while (i < mid) to[k++] = from[i++];
+      while (j < hi)  to[k++] = from[j++];
+    }
+    AggGroup** t = from; from = to; to = t;
+  }
+  if (from != a) memcpy(a, from, n * sizeof *a);
+  arena_rewind(mem, m);
+  return TABLE_OK;
+}
+
+static int result_finish(AggResult* r) {
+  // Without GROUP BY there is always exactly one group
+  const uint8_t none = 0;
+  if (r->spec->ngroup == 0 && r->n == 0 && !group_get(r, &none, 0)) return TABLE_E_INVAL;
+
+  r->sorted = arena_alloc(r->mem, (r->n ? r->n : 1u) * sizeof *r->sorted);
+  if (!r->sorted) return TABLE_E_INVAL;
+  size_t k = 0;
+  for (size_t i = 0; i < r->cap; i++)
+    if (r->slots[i].g) r->sorted[k++] = r->slots[i].g;
+  return sort_groups(r->spec, r->mem, r->sorted, r->n);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+size_t agg_key_len(const AggSpec* spec) {
+  return agg_key_off(spec, spec->ngroup);
+}
+
+size_t agg_key_off(const AggSpec* spec, int k) {
+  size_t off = 0;
+  for (int i = 0; i < k && i < spec->ngroup; i++) off += spec->group[i].len;
+  return off;
+}
+
+int agg_run(Pager* pager, uint32_t root_page_no, const AggSpec* spec, AggResult** out) {
+  if (!pager || root_page_no == 0 || !spec || !out) return TABLE_E_INVAL;
+  *out = NULL;
+  if (spec->nfuncs < 1 || spec->nfuncs > AGG_MAX_FUNCS) return TABLE_E_INVAL;
+  if (spec->ngroup < 0 || spec->ngroup > AGG_MAX_GROUP) return TABLE_E_INVAL;
+  bool count_only = true;
+  for (int k = 0; k < spec->nfuncs; k++) {
+    if (spec->func[k] > AGG_AVG) return TABLE_E_INVAL;
+    if (spec->func[k] == AGG_COUNT) continue;
+    count_only = false;
+    if (!field_ok(&spec->arg[k]) || !is_int(spec->arg[k].type)) return TABLE_E_INVAL;
+  }
+  for (int i = 0; i < spec->ngroup; i++)
+    if (!field_ok(&spec->group[i])) return TABLE_E_INVAL;
+
+  AggResult* r = result_new(spec, spec->arena);
+  if (!r) return TABLE_E_INVAL;
+  r->spec_copy = *spec;
+  r->spec = &r->spec_copy;
+
+  // The fold reads the argument and GROUP BY fields only: a PAX table
+  // assembles just their columns
+  TblFields fields = { { 0, 0 } };
+  for (int k = 0; k < spec->nfuncs; k++)
+    if (spec->func[k] != AGG_COUNT) tblmgr_fields_add(&fields, spec->arg[k].off, spec->arg[k].len);
+  for (int i = 0; i < spec->ngroup; i++)
+    tblmgr_fields_add(&fields, spec->group[i].off, spec->group[i].len);
+
+  int rc;
+  if (count_only && spec->ngroup == 0 && !spec->where) {
+    // COUNT(*): the row count kept by the catalog (or the leaves' used
+    // counts along the chain), no record is read
+    uint64_t rows = 0;
+    const uint8_t none = 0;
+    rc = tblmgr_count(pager, root_page_no, &rows);
+    AggGroup* g = rc == TABLE_OK ? group_get(r, &none, 0) : NULL;
+    if (rc == TABLE_OK && !g) rc = TABLE_E_INVAL;
+    if (g) {
+      g->rows = rows;
+      for (int k = 0; k < spec->nfuncs; k++) g->acc[k] = rows;
+    }
+  } else if (spec->threads > 1) {
+    TblParallelScan opts = {
+      .threads = spec->threads, .callback = fold_cb, .worker_init = worker_new,
+      .merge = worker_merge, .user_data = r, .where = spec->where, .fields = &fields,
+    };
+    rc = tblmgr_scan_parallel(pager, root_page_no, &opts);
+  } else {
+    rc = tblmgr_scan_fields(pager, root_page_no, spec->where, &fields, fold_cb, r);
+  }
+
+  if (rc == TABLE_OK) rc = result_finish(r);
+  if (rc != TABLE_OK) { agg_free(r); return rc; }
+  *out = r;
+  return TABLE_OK;
+}
+
+size_t agg_group_count(const AggResult* r) {
+  return r ? r->n : 0;
+}
+
+const AggGroup* agg_group(const AggResult* r, size_t i) {
+  return r && r->sorted && i < r->n ? r->sorted[i] : NULL;
+}
+
+bool agg_value(const AggSpec* spec, const AggGroup* g, int k, double* out) {
+  if (!spec || !g || k < 0 || k >= spec->nfuncs || !out) return false;
+  if (spec->func[k] != AGG_COUNT && spec->func[k] != AGG_SUM && g->rows == 0) return false;
+  *out = spec->func[k] == AGG_AVG ? (double)g->acc[k] / (double)g->rows : (double)g->acc[k];
+  return true;
+}
+
+void agg_free(AggResult* r) {
+  if (!r) return;
+  if (r->mem != &r->own) return;   // in the caller's arena
+  arena_free(&r->own);
+  free(r);
+}
@@ -0,0 +1,116 @@
+#ifndef AGG_H
+
+#define AGG_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "pager.h"
+#include "predicate.h"
+#include "arena.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Aggregates over a table of 128-byte records
+ * COUNT(*), SUM, MIN, MAX and AVG of u8/u16/u32 fields, optionally per
+ * group of one or more fields (GROUP BY) and restricted by a scan
+ * predicate (predicate.h). Fields use the off:len:type vocabulary of
+ * index keys (index_key.h).
+ *
+ * Records are folded into a hash table of groups while the table is
+ * scanned (tblmgr_scan_fields, or tblmgr_scan_parallel with one table per
+ * worker, merged in worker order), asking for the fields they read only.
+ * The result, its groups and their keys live in an arena (arena.h): one
+ * of its own, freed as a whole by agg_free(), or the caller's
+ * (AggSpec.arena), so that a loop of queries rewinding it between runs
+ * stops allocating. A lone COUNT(*) without predicate or grouping is read
+ * from the table's row count and touches no record.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define AGG_MAX_FUNCS    8
+#define AGG_MAX_GROUP    4    // GROUP BY fields
+
+typedef enum AggFunc {
+  AGG_COUNT = 0,    /* rows; the field is ignored */
+  AGG_SUM,
+  AGG_MIN,
+  AGG_MAX,
+  AGG_AVG           /* SUM / COUNT */
+} AggFunc;
+
+typedef struct AggField {
+  uint16_t off, len;    // bytes [off, off+len) of the record
+  uint8_t  type;        // INDEX_KEY_* (FieldType numbering)
+} AggField;
+
+/**
+ * @brief What to compute. Zero-initialize, then set what you need.
+ */
+typedef struct AggSpec {
+  int            nfuncs;                  // 1..AGG_MAX_FUNCS
+  uint8_t        func[AGG_MAX_FUNCS];     // AggFunc
+  AggField       arg[AGG_MAX_FUNCS];      // field of each (integer types only)
+  int            ngroup;                  // 0..AGG_MAX_GROUP
+  AggField       group[AGG_MAX_GROUP];    // any type; the key is their bytes, in order
+  const TblPred* where;                   // optional filter
+  unsigned       threads;                 // 0 or 1: one scan; more: parallel scan
+  Arena*         arena;                   // optional: build the result in it (see agg_free)
+} AggSpec;
+
+/**
+ * @brief One group of the result.
+ */
+typedef struct AggGroup {
+  const uint8_t* key;                     // group fields' bytes, concatenated
+  uint64_t       rows;
+  uint64_t       acc[AGG_MAX_FUNCS];      // COUNT/SUM/AVG: sum, MIN/MAX: extreme
+} AggGroup;
+
+typedef struct AggResult AggResult;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Compute the aggregates of a fixed-size table.
+ *
+ * Without GROUP BY the result has exactly one group (rows = 0 on an empty
+ * table or when nothing matches). With GROUP BY it has one group per
+ * distinct key, in key order (numeric for u8/u16/u32 fields, memcmp
+ * otherwise, field by field).
+ *
+ * @param out  Receives the result; release it with agg_free().
+ * @return TABLE_OK, TABLE_E_INVAL for a bad spec (a non-integer argument,
+ *         a field outside the record), TABLE_E_BADKIND for a slotted
+ *         table, or the scan's error.
+ */
+int             agg_run(Pager* pager, uint32_t root_page_no, const AggSpec* spec, AggResult** out);
+
+/**
+ * @brief Groups of a result, and group i (0 <= i < agg_group_count).
+ */
+size_t          agg_group_count(const AggResult* r);
+const AggGroup* agg_group(const AggResult* r, size_t i);
+
+/**
+ * @brief Bytes of a group key, and the offset of GROUP BY field k in it.
+ */
+size_t          agg_key_len(const AggSpec* spec);
+size_t          agg_key_off(const AggSpec* spec, int k);
+
+/**
+ * @brief Value of aggregate k of a group as a number (AVG: the mean).
+ * @return false when it has no value: MIN, MAX or AVG over no row.
+ */
+bool            agg_value(const AggSpec* spec, const AggGroup* g, int k, double* out);
+
+/**
+ * @brief Free a result, its groups and their keys. A result built in
+ *        AggSpec.arena is left alone: it goes when that arena is rewound.
+ */
+void            agg_free(AggResult* r);
+
+#endif // AGG_H
@@ -0,0 +1,99 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+struct ArenaChunk {
+  ArenaChunk* next;
+  size_t      used, cap;
+  _Alignas(ARENA_ALIGN) uint8_t data[];
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Chunks
+// ─────────────────────────────────────────────────────────────────────────────
+void* arena_alloc(Arena* a, size_t n) {
+  if (!a || n > SIZE_MAX - ARENA_CHUNK) return NULL;
+  n = (n + ARENA_ALIGN - 1u) & ~(size_t)(ARENA_ALIGN - 1u);
+  ArenaChunk* c = a->cur;
+  if (!c || c->cap - c->used < n) {
+    // The chunks past `cur` are free: take the first one large enough
+    // (those skipped stay unused until a rewind), else add one after `cur`
+    c = a->cur ? a->cur->next : a->head;
+    while (c && c->cap < n) c = c->next;
+    if (!c) {
+      const size_t cap = n > ARENA_CHUNK ? n : ARENA_CHUNK;
+      c = malloc(sizeof *c + cap);
+      if (!c) return NULL;
+      c->cap = cap;
+      if (a->cur) { c->next = a->cur->next; a->cur->next = c; }
+      else        { c->next = a->head;      a->head = c; }
+    }
+    c->used = 0;
+    a->cur = c;
+  }
+  void* p = c->data + c->used;
+  c->used += n;
+  return p;
+}
+
+void* arena_calloc(Arena* a, size_t n) {
+  void* p = arena_alloc(a, n);
+  if (p) memset(p, 0, n);
+  return p;
+}
+
+ArenaMark arena_mark(const Arena* a) {
+  return (ArenaMark){ .chunk = a->cur, .used = a->cur ? a->cur->used : 0 };
+}
+
+void arena_rewind(Arena* a, ArenaMark m) {
+  a->cur = m.chunk;
+  if (m.chunk) m.chunk->used = m.used;
+}
+
+void arena_reset(Arena* a) {
+  a->cur = NULL;
+}
+
+void arena_free(Arena* a) {
+  for (ArenaChunk* c = a->head; c; ) {
+    ArenaChunk* next = c->next;
+    free(c);
+    c = next;
+  }
+  a->head = a->cur = NULL;
+}
+
+size_t arena_capacity(const Arena* a) {
+  size_t n = 0;
+  for (const ArenaChunk* c = a->head; c; c = c->next) n += c->cap;
+  return n;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Thread scratch
+// ─────────────────────────────────────────────────────────────────────────────
+static _Thread_local Arena* t_arena;
+static pthread_key_t  arena_key;
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+static void thread_arena_free(void* arg) {
+  Arena* a = (Arena*)arg;
+  arena_free(a);
+  free(a);
+}
+
+static void arena_key_init(void) {
+  pthread_key_create(&arena_key, thread_arena_free);
+}
+
+Arena* arena_thread(void) {
+  if (t_arena) return t_arena;
+  pthread_once(&arena_once, arena_key_init);
+  Arena* a = calloc(1, sizeof *a);
+  if (!a) return NULL;
+  pthread_setspecific(arena_key, a);
+  t_arena = a;
+  return a;
+}
@@ -0,0 +1,80 @@
+#ifndef ARENA_H
+
+#define ARENA_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Arena: bump allocation from large chunks, released all at once
+ *
+ * Allocations are carved from chunks of ARENA_CHUNK bytes (or one of their
+ * own size when larger) and never freed one by one. arena_rewind() gives
+ * back everything allocated since an arena_mark(), arena_reset() all of it,
+ * and both keep the chunks: an arena that is rewound after each operation
+ * stops calling malloc once it has grown to the operation's peak.
+ *
+ * An arena belongs to one thread at a time. arena_thread() hands each
+ * thread a scratch arena of its own, used by scans for their per-call
+ * buffers (mark on entry, rewind on exit, so calls can nest); it is freed
+ * when the thread exits. What a scan callback allocates there is gone once
+ * the scan returns: results that outlive it need an arena of their own.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define ARENA_CHUNK   (64u * 1024u)
+#define ARENA_ALIGN   16u          // alignment of every allocation
+
+typedef struct ArenaChunk ArenaChunk;
+
+/** @brief Zero-initialize (ARENA_INIT) before first use. */
+typedef struct Arena {
+  ArenaChunk* head;     // every chunk, in the order they fill
+  ArenaChunk* cur;      // the one allocations come from (NULL: none yet)
+} Arena;
+
+#define ARENA_INIT { NULL, NULL }
+
+/** @brief A point to rewind to: everything allocated after it goes. */
+typedef struct ArenaMark {
+  ArenaChunk* chunk;
+  size_t      used;
+} ArenaMark;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief n bytes (ARENA_ALIGN-aligned, uninitialized).
+ * @return NULL when out of memory.
+ */
+void*     arena_alloc(Arena* a, size_t n);
+
+/** @brief arena_alloc() of n zeroed bytes. */
+void*     arena_calloc(Arena* a, size_t n);
+
+/** @brief The current end of the arena. */
+ArenaMark arena_mark(const Arena* a);
+
+/** @brief Release everything allocated since `m` (the chunks stay). */
+void      arena_rewind(Arena* a, ArenaMark m);
+
+/** @brief Release every allocation (the chunks stay). */
+void      arena_reset(Arena* a);
+
+/** @brief Give the chunks back to the heap; the arena is empty again. */
+void      arena_free(Arena* a);
+
+/** @brief Bytes of chunks the arena holds, allocated or not. */
+size_t    arena_capacity(const Arena* a);
+
+/**
+ * @brief The calling thread's scratch arena, created on first use.
+ * @return NULL when out of memory.
+ */
+Arena*    arena_thread(void);
+
+#endif // ARENA_H
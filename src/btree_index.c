@@ -0,0 +1,836 @@
+#include "btree_index.h"
+#include "hash_index.h"
+#include "table_manager.h"
+#include "packed.h"
+#include "pax.h"
+#include "endian_util.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Validate a table leaf that records are written to in place: the
+ *        root of a fixed-size table, by rows (TABLE_LEAF) or columns (PAX).
+ */
+static int root_validate(const void* page, size_t page_size) {
+  return tbl_get_kind(page) == TABLE_PAGE_KIND_PAX ? pax_validate(page, page_size)
+                                                   : tbl_validate(page, page_size);
+}
+
+/* Node geometry derived from the key description */
+typedef struct Tree {
+  IndexKey key;
+  size_t   idsz;        /* record id bytes, TABLE_ID_SIZE of the file */
+  size_t   leaf_esz;    /* key + id */
+  size_t   inner_esz;   /* key + id + child */
+  uint16_t leaf_cap;
+  uint16_t inner_cap;
+} Tree;
+
+/* One interior level of a root-to-leaf descent */
+typedef struct PathStep {
+  uint32_t page;
+  uint16_t child;       /* index of the child taken (0 = first child) */
+} PathStep;
+
+enum { EDGE_NONE = 0, EDGE_LEFT = -1, EDGE_RIGHT = 1 };
+
+/* Largest entry: key + id + child; scratch room for a node plus one entry */
+#define BIDX_ENTRY_MAX  (TABLE_RECORD_SIZE + 8 + 4)
+#define BIDX_SCRATCH    (PAGER_MAX_PAGE_SIZE + BIDX_ENTRY_MAX)
+
+static void tree_init(Tree* t, const IndexKey* k, const Pager* p) {
+  const size_t page_size = pager_page_size(p);
+  t->key       = *k;
+  t->idsz      = TABLE_ID_SIZE(pager_format_version(p));
+  t->leaf_esz  = (size_t)k->len + t->idsz;
+  t->inner_esz = (size_t)k->len + t->idsz + 4u;
+  t->leaf_cap  = (uint16_t)((page_size - BIDX_NODE_HDR_SIZE) / t->leaf_esz);
+  t->inner_cap = (uint16_t)((page_size - BIDX_NODE_HDR_SIZE) / t->inner_esz);
+}
+
+/* Record id of an entry (leaf or interior), stored after the key */
+static inline uint64_t entry_id(const Tree* t, const uint8_t* e) {
+  return t->idsz == 8 ? read_le_u64(e + t->key.len) : read_le_u32(e + t->key.len);
+}
+
+static inline void entry_set_id(const Tree* t, uint8_t* e, uint64_t id) {
+  if (t->idsz == 8) write_le_u64(e + t->key.len, id);
+  else              write_le_u32(e + t->key.len, (uint32_t)id);
+}
+
+/* Child page of an interior entry, stored after the id */
+static inline uint8_t* entry_child(const Tree* t, uint8_t* e) {
+  return e + t->key.len + t->idsz;
+}
+
+static inline uint16_t node_count(const uint8_t* n) {
+  return read_le_u16(n + BIDX_NODE_COUNT_OFF);
+}
+
+static inline uint8_t* node_entry(uint8_t* n, uint16_t i, size_t esz) {
+  return n + BIDX_NODE_HDR_SIZE + (size_t)i * esz;
+}
+
+static inline const uint8_t* node_entry_c(const uint8_t* n, uint16_t i, size_t esz) {
+  return n + BIDX_NODE_HDR_SIZE + (size_t)i * esz;
+}
+
+/**
+ * @brief Order of entries: key first, record id to break ties.
+ */
+static int entry_cmp(const Tree* t, const uint8_t* ekey, uint64_t eid, const uint8_t* key, uint64_t id) {
+  const int c = index_key_cmp(&t->key, ekey, key);
+  if (c != 0) return c;
+  return (eid > id) - (eid < id);
+}
+
+/**
+ * @brief Binary search: first entry >= (key, id), or > (key, id) if upper.
+ */
+static uint16_t node_search(const Tree* t, const uint8_t* node, size_t esz,
+                            const uint8_t* key, uint64_t id, bool upper) {
+  uint16_t lo = 0, hi = node_count(node);
+  while (lo < hi) {
+    const uint16_t mid = (uint16_t)(lo + (hi - lo) / 2);
+    const uint8_t* e = node_entry_c(node, mid, esz);
+    const int c = entry_cmp(t, e, entry_id(t, e), key, id);
+    if (c < 0 || (upper && c == 0)) lo = (uint16_t)(mid + 1);
+    else                            hi = mid;
+  }
+  return lo;
+}
+
+static inline uint32_t inner_child(const Tree* t, const uint8_t* node, uint16_t i) {
+  if (i == 0) return read_le_u32(node + BIDX_NODE_NEXT_OFF);
+  return read_le_u32(node_entry_c(node, (uint16_t)(i - 1), t->inner_esz) + t->key.len + t->idsz);
+}
+
+static void meta_read_key(const uint8_t* meta, IndexKey* k) {
+  memset(k, 0, sizeof *k);
+  k->off  = read_le_u16(meta + BIDX_META_KEY_OFF_OFF);
+  k->len  = read_le_u16(meta + BIDX_META_KEY_LEN_OFF);
+  k->type = meta[BIDX_META_KEY_TYPE_OFF];
+  memcpy(k->name, meta + BIDX_META_NAME_OFF, INDEX_NAME_MAX - 1);
+}
+
+/**
+ * @brief Light header check done by every operation (bidx_validate goes deeper).
+ */
+static int meta_check(const uint8_t* meta, uint32_t page_count) {
+  if (read_le_u16(meta + BIDX_META_KIND_OFF) != TABLE_PAGE_KIND_BTREE_META)
+    return TABLE_E_BADKIND;
+
+  IndexKey k;
+  meta_read_key(meta, &k);
+  if (!index_key_valid(&k))
+    return TABLE_E_LAYOUT;
+
+  const uint32_t height = meta[BIDX_META_HEIGHT_OFF];
+  const uint32_t root   = read_le_u32(meta + BIDX_META_ROOT_OFF);
+  const uint32_t first  = read_le_u32(meta + BIDX_META_FIRST_LEAF_OFF);
+  if (height == 0 || height > BIDX_MAX_HEIGHT)
+    return TABLE_E_LAYOUT;
+  if (root == 0 || root >= page_count || first == 0 || first >= page_count)
+    return TABLE_E_LAYOUT;
+  return TABLE_OK;
+}
+
+static int pin_meta(Pager* p, uint32_t meta_page, uint8_t** out) {
+  if (!p || meta_page == 0 || meta_page >= pager_page_count(p)) return TABLE_E_INVAL;
+  if (pager_pin_mut(p, meta_page, (void**)out) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = meta_check(*out, pager_page_count(p));
+  if (rc != TABLE_OK) { pager_unpin(p, *out, false); *out = NULL; }
+  return rc;
+}
+
+/**
+ * @brief pin_meta() for lookups and validation: a shared pin, served from
+ *        the snapshot of a thread bound to one.
+ */
+static int pin_meta_c(Pager* p, uint32_t meta_page, const uint8_t** out) {
+  if (!p || meta_page == 0 || meta_page >= pager_page_count(p)) return TABLE_E_INVAL;
+  if (pager_pin(p, meta_page, (const void**)out) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = meta_check(*out, pager_page_count(p));
+  if (rc != TABLE_OK) { pager_unpin(p, *out, false); *out = NULL; }
+  return rc;
+}
+
+static bool node_ok(const Tree* t, const uint8_t* n, uint16_t level) {
+  const uint16_t kind = level == 0 ? TABLE_PAGE_KIND_BTREE_LEAF : TABLE_PAGE_KIND_BTREE_INNER;
+  const uint16_t cap  = level == 0 ? t->leaf_cap : t->inner_cap;
+  return read_le_u16(n + BIDX_NODE_KIND_OFF) == kind &&
+         read_le_u16(n + BIDX_NODE_KEY_LEN_OFF) == t->key.len &&
+         read_le_u16(n + BIDX_NODE_LEVEL_OFF) == level &&
+         node_count(n) <= cap &&
+         (level == 0 || node_count(n) > 0);
+}
+
+/**
+ * @brief Pin node page_no for writing, expected at `level`, and check its header.
+ */
+static int node_pin(Pager* p, const Tree* t, uint32_t page_no, uint16_t level, uint8_t** out) {
+  if (page_no == 0 || page_no >= pager_page_count(p)) return TABLE_E_LAYOUT;
+  if (pager_pin_mut(p, page_no, (void**)out) != PAGER_OK) return TABLE_E_INVAL;
+  if (!node_ok(t, *out, level)) {
+    pager_unpin(p, *out, false);
+    *out = NULL;
+    return TABLE_E_LAYOUT;
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief node_pin() for reading (see pin_meta_c).
+ */
+static int node_pin_c(Pager* p, const Tree* t, uint32_t page_no, uint16_t level, const uint8_t** out) {
+  if (page_no == 0 || page_no >= pager_page_count(p)) return TABLE_E_LAYOUT;
+  if (pager_pin(p, page_no, (const void**)out) != PAGER_OK) return TABLE_E_INVAL;
+  if (!node_ok(t, *out, level)) {
+    pager_unpin(p, *out, false);
+    *out = NULL;
+    return TABLE_E_LAYOUT;
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief Allocate an empty node at `level`; returned pinned.
+ */
+static int node_new(Pager* p, const Tree* t, uint16_t level, uint32_t* out_no, uint8_t** out) {
+  if (pager_alloc_page(p, out_no) != PAGER_OK) return TABLE_E_INVAL;
+  if (pager_pin_zero(p, *out_no, (void**)out) != PAGER_OK) return TABLE_E_INVAL;
+
+  uint8_t* n = *out;
+  write_le_u16(n + BIDX_NODE_KIND_OFF,
+               level == 0 ? TABLE_PAGE_KIND_BTREE_LEAF : TABLE_PAGE_KIND_BTREE_INNER);
+  write_le_u16(n + BIDX_NODE_KEY_LEN_OFF, t->key.len);
+  write_le_u16(n + BIDX_NODE_LEVEL_OFF, level);
+  return TABLE_OK;
+}
+
+/**
+ * @brief Walk from the root down to a leaf.
+ *
+ * EDGE_NONE follows (key, id): the child whose range contains it.
+ * EDGE_LEFT / EDGE_RIGHT take the first / last child at every level.
+ * `path` (optional) receives one step per interior level, root first.
+ */
+static int descend(Pager* p, const Tree* t, uint32_t root, uint8_t height,
+                   const uint8_t* key, uint64_t id, int edge,
+                   PathStep* path, uint32_t* out_leaf) {
+  uint32_t page = root;
+  for (uint16_t level = (uint16_t)(height - 1); level > 0; level--) {
+    const uint8_t* n = NULL;
+    int rc = node_pin_c(p, t, page, level, &n);
+    if (rc != TABLE_OK) return rc;
+
+    uint16_t i;
+    if (edge == EDGE_LEFT)       i = 0;
+    else if (edge == EDGE_RIGHT) i = node_count(n);
+    else                         i = node_search(t, n, t->inner_esz, key, id, true);
+
+    if (path) {
+      path[height - 1 - level].page = page;
+      path[height - 1 - level].child = i;
+    }
+    const uint32_t child = inner_child(t, n, i);
+    pager_unpin(p, n, false);
+    page = child;
+  }
+  *out_leaf = page;
+  return TABLE_OK;
+}
+
+/**
+ * @brief Insert `ent` (esz bytes) at position pos of a full node, then split
+ *        the count + 1 entries: [0, keep) stay in `node`, the rest go to `right`.
+ */
+static void split_entries(uint8_t* node, uint8_t* right, size_t esz, uint16_t count,
+                          uint16_t pos, const uint8_t* ent, uint16_t keep) {
+  uint8_t tmp[BIDX_SCRATCH];
+  uint8_t* base = node + BIDX_NODE_HDR_SIZE;
+
+  memcpy(tmp, base, (size_t)pos * esz);
+  memcpy(tmp + (size_t)pos * esz, ent, esz);
+  memcpy(tmp + (size_t)(pos + 1) * esz, base + (size_t)pos * esz, (size_t)(count - pos) * esz);
+
+  const uint16_t moved = (uint16_t)(count + 1 - keep);
+  memset(base, 0, (size_t)count * esz);
+  memcpy(base, tmp, (size_t)keep * esz);
+  memcpy(right + BIDX_NODE_HDR_SIZE, tmp + (size_t)keep * esz, (size_t)moved * esz);
+  write_le_u16(node + BIDX_NODE_COUNT_OFF, keep);
+  write_le_u16(right + BIDX_NODE_COUNT_OFF, moved);
+}
+
+static void node_insert_at(uint8_t* node, size_t esz, uint16_t pos, const uint8_t* ent) {
+  const uint16_t count = node_count(node);
+  uint8_t* at = node_entry(node, pos, esz);
+  memmove(at + esz, at, (size_t)(count - pos) * esz);
+  memcpy(at, ent, esz);
+  write_le_u16(node + BIDX_NODE_COUNT_OFF, (uint16_t)(count + 1));
+}
+
+/**
+ * @brief bidx_insert on an already pinned header page.
+ */
+static int insert_pinned(Pager* p, uint8_t* meta, const Tree* t, const uint8_t* key, uint64_t id) {
+  const uint8_t  height = meta[BIDX_META_HEIGHT_OFF];
+  const uint32_t root   = read_le_u32(meta + BIDX_META_ROOT_OFF);
+  const uint16_t len    = t->key.len;
+
+  PathStep path[BIDX_MAX_HEIGHT];
+  uint32_t leaf_no;
+  int rc = descend(p, t, root, height, key, id, EDGE_NONE, path, &leaf_no);
+  if (rc != TABLE_OK) return rc;
+
+  uint8_t* leaf = NULL;
+  if ((rc = node_pin(p, t, leaf_no, 0, &leaf)) != TABLE_OK) return rc;
+
+  const uint16_t count = node_count(leaf);
+  const uint16_t pos = node_search(t, leaf, t->leaf_esz, key, id, false);
+  if (pos < count) {
+    const uint8_t* e = node_entry_c(leaf, pos, t->leaf_esz);
+    if (entry_cmp(t, e, entry_id(t, e), key, id) == 0) {
+      pager_unpin(p, leaf, false);
+      return TABLE_E_INVAL;
+    }
+  }
+
+  uint8_t ent[BIDX_ENTRY_MAX];
+  if (t->idsz == 4 && id > UINT32_MAX) { pager_unpin(p, leaf, false); return TABLE_E_FULL; }   // version 1 file
+  memcpy(ent, key, len);
+  entry_set_id(t, ent, id);
+
+  if (count < t->leaf_cap) {
+    node_insert_at(leaf, t->leaf_esz, pos, ent);
+    pager_unpin(p, leaf, true);
+    write_le_u32(meta + BIDX_META_ENTRIES_OFF, read_le_u32(meta + BIDX_META_ENTRIES_OFF) + 1);
+    return TABLE_OK;
+  }
+
+  // (a) Split the leaf: the upper half moves to a new right sibling
+  uint32_t right_no;
+  uint8_t* right = NULL;
+  if ((rc = node_new(p, t, 0, &right_no, &right)) != TABLE_OK) { pager_unpin(p, leaf, false); return rc; }
+
+  split_entries(leaf, right, t->leaf_esz, count, pos, ent, (uint16_t)((count + 1) / 2));
+
+  const uint32_t old_next = read_le_u32(leaf + BIDX_NODE_NEXT_OFF);
+  write_le_u32(right + BIDX_NODE_NEXT_OFF, old_next);
+  write_le_u32(right + BIDX_NODE_PREV_OFF, leaf_no);
+  write_le_u32(leaf + BIDX_NODE_NEXT_OFF, right_no);
+
+  // The separator is the first entry of the new leaf
+  uint8_t sep[BIDX_ENTRY_MAX];
+  memcpy(sep, node_entry_c(right, 0, t->leaf_esz), t->leaf_esz);
+  pager_unpin(p, right, true);
+  pager_unpin(p, leaf, true);
+
+  if (old_next != 0) {
+    uint8_t* sib = NULL;
+    if ((rc = node_pin(p, t, old_next, 0, &sib)) != TABLE_OK) return rc;
+    write_le_u32(sib + BIDX_NODE_PREV_OFF, right_no);
+    pager_unpin(p, sib, true);
+  }
+
+  // (b) Push (separator, right) up until a parent has room
+  for (int d = height - 2; d >= 0 && right_no != 0; d--) {
+    const uint16_t level = (uint16_t)(height - 1 - d);
+    uint8_t* n = NULL;
+    if ((rc = node_pin(p, t, path[d].page, level, &n)) != TABLE_OK) return rc;
+
+    write_le_u32(entry_child(t, sep), right_no);
+    const uint16_t ncount = node_count(n);
+    if (ncount < t->inner_cap) {
+      node_insert_at(n, t->inner_esz, path[d].child, sep);
+      pager_unpin(p, n, true);
+      right_no = 0;
+      break;
+    }
+
+    uint8_t* nr = NULL;
+    uint32_t nr_no;
+    if ((rc = node_new(p, t, level, &nr_no, &nr)) != TABLE_OK) { pager_unpin(p, n, false); return rc; }
+
+    // Middle entry moves up: its child becomes the new node's first child
+    const uint16_t keep = (uint16_t)((ncount + 1) / 2);
+    uint8_t tmp[BIDX_SCRATCH];
+    uint8_t* base = n + BIDX_NODE_HDR_SIZE;
+    const size_t esz = t->inner_esz;
+    const uint16_t at = path[d].child;
+    memcpy(tmp, base, (size_t)at * esz);
+    memcpy(tmp + (size_t)at * esz, sep, esz);
+    memcpy(tmp + (size_t)(at + 1) * esz, base + (size_t)at * esz, (size_t)(ncount - at) * esz);
+
+    const uint16_t moved = (uint16_t)(ncount - keep);   // total - keep - 1
+    memset(base, 0, (size_t)ncount * esz);
+    memcpy(base, tmp, (size_t)keep * esz);
+    memcpy(nr + BIDX_NODE_HDR_SIZE, tmp + (size_t)(keep + 1) * esz, (size_t)moved * esz);
+    write_le_u16(n + BIDX_NODE_COUNT_OFF, keep);
+    write_le_u16(nr + BIDX_NODE_COUNT_OFF, moved);
+
+    const uint8_t* mid = tmp + (size_t)keep * esz;
+    write_le_u32(nr + BIDX_NODE_NEXT_OFF, read_le_u32(mid + len + t->idsz));
+    memcpy(sep, mid, t->leaf_esz);
+
+    pager_unpin(p, nr, true);
+    pager_unpin(p, n, true);
+    right_no = nr_no;
+  }
+
+  // (c) The root itself split: grow the tree by one level
+  if (right_no != 0) {
+    if (height >= BIDX_MAX_HEIGHT) return TABLE_E_FULL;
+
+    uint8_t* nroot = NULL;
+    uint32_t nroot_no;
+    if ((rc = node_new(p, t, height, &nroot_no, &nroot)) != TABLE_OK) return rc;
+    write_le_u32(nroot + BIDX_NODE_NEXT_OFF, root);
+    write_le_u32(entry_child(t, sep), right_no);
+    node_insert_at(nroot, t->inner_esz, 0, sep);
+    pager_unpin(p, nroot, true);
+
+    write_le_u32(meta + BIDX_META_ROOT_OFF, nroot_no);
+    meta[BIDX_META_HEIGHT_OFF] = (uint8_t)(height + 1);
+  }
+
+  write_le_u32(meta + BIDX_META_ENTRIES_OFF, read_le_u32(meta + BIDX_META_ENTRIES_OFF) + 1);
+  return TABLE_OK;
+}
+
+/**
+ * @brief Is `name` already used by an index of this table (any kind)?
+ */
+static int name_taken(Pager* p, uint32_t root_page_no, const char* name) {
+  uint32_t existing;
+  int rc = hidx_open(p, root_page_no, name, &existing);
+  if (rc == TABLE_E_NOTFOUND)
+    rc = bidx_open(p, root_page_no, name, &existing);
+  if (rc == TABLE_OK) return TABLE_E_INVAL;
+  return rc == TABLE_E_NOTFOUND ? TABLE_OK : rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief bidx_create() inside its write section.
+ */
+static int create_index(Pager* p, uint32_t root_page_no, const IndexKey* key, uint32_t* out_meta_page) {
+  if (!p || !index_key_valid(key) || root_page_no == 0 || root_page_no >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  int rc = name_taken(p, root_page_no, key->name);
+  if (rc != TABLE_OK) return rc;
+
+  uint8_t* root = NULL;
+  if (pager_pin_mut(p, root_page_no, (void**)&root) != PAGER_OK) return TABLE_E_INVAL;
+  rc = root_validate(root, pager_page_size(p));
+  const uint32_t owner = tbl_get_root_page(root);
+  if (rc == TABLE_OK && owner != 0 && owner != root_page_no) rc = TABLE_E_INVAL;
+  if (rc != TABLE_OK) { pager_unpin(p, root, false); return rc; }
+
+  Tree t;
+  tree_init(&t, key, p);
+
+  // (a) Header page + empty root leaf
+  uint32_t meta_no, leaf_no;
+  uint8_t* leaf = NULL;
+  if (pager_alloc_page(p, &meta_no) != PAGER_OK) { pager_unpin(p, root, false); return TABLE_E_INVAL; }
+  if ((rc = node_new(p, &t, 0, &leaf_no, &leaf)) != TABLE_OK) { pager_unpin(p, root, false); return rc; }
+  pager_unpin(p, leaf, true);
+
+  uint8_t* meta = NULL;
+  if (pager_pin_zero(p, meta_no, (void**)&meta) != PAGER_OK) { pager_unpin(p, root, false); return TABLE_E_INVAL; }
+  write_le_u16(meta + BIDX_META_KIND_OFF, TABLE_PAGE_KIND_BTREE_META);
+  write_le_u16(meta + BIDX_META_KEY_OFF_OFF, key->off);
+  write_le_u16(meta + BIDX_META_KEY_LEN_OFF, key->len);
+  meta[BIDX_META_KEY_TYPE_OFF] = key->type;
+  meta[BIDX_META_HEIGHT_OFF] = 1;
+  write_le_u32(meta + BIDX_META_TABLE_OFF, root_page_no);
+  write_le_u32(meta + BIDX_META_ROOT_OFF, leaf_no);
+  write_le_u32(meta + BIDX_META_FIRST_LEAF_OFF, leaf_no);
+  memcpy(meta + BIDX_META_NAME_OFF, key->name, strlen(key->name));
+
+  // (b) Index the existing records, stamping leaf ownership on the way
+  uint32_t page = root_page_no;
+  uint32_t hops = 0;
+  uint8_t* unpacked = NULL;
+  size_t unpacked_cap = 0;
+  while (page != 0 && rc == TABLE_OK) {
+    if (page >= pager_page_count(p) || ++hops > pager_page_count(p)) { rc = TABLE_E_LAYOUT; break; }
+
+    uint8_t* tl = NULL;
+    if (pager_pin_mut(p, page, (void**)&tl) != PAGER_OK) { rc = TABLE_E_INVAL; break; }
+    // Packed (packed.h) and PAX (pax.h) leaves are read from their decoded image
+    const uint16_t kind = tbl_get_kind(tl);
+    const bool packed = kind == TABLE_PAGE_KIND_PACKED, pax = kind == TABLE_PAGE_KIND_PAX;
+    rc = packed ? pkl_validate(tl, pager_page_size(p)) : root_validate(tl, pager_page_size(p));
+    if (rc == TABLE_OK && packed) rc = pkl_decode_buf(tl, &unpacked, &unpacked_cap);
+    if (rc == TABLE_OK && pax)    rc = pax_decode_buf(tl, &unpacked, &unpacked_cap);
+    if (rc != TABLE_OK) { pager_unpin(p, tl, false); break; }
+    const uint8_t* recs = packed || pax ? unpacked : tl;
+
+    tbl_set_root_page(tl, root_page_no);
+    TblSlotIter it;
+    tbl_slot_iter_init(&it, recs);
+    int i;
+    while (rc == TABLE_OK && (i = tbl_slot_iter_next(&it)) >= 0)
+      rc = insert_pinned(p, meta, &t, index_key_ptr(key, tbl_slot_ptr_c(recs, i)), TABLE_ID(page, i));
+    const uint32_t next = tbl_get_next_page(tl);
+    pager_unpin(p, tl, true);
+    page = next;
+  }
+  free(unpacked);
+
+  // (c) Link the index in front of the table's index list
+  if (rc == TABLE_OK) {
+    write_le_u32(meta + BIDX_META_NEXT_OFF, tbl_get_index_page(root));
+    tbl_set_index_page(root, meta_no);
+  }
+  pager_unpin(p, meta, true);
+  pager_unpin(p, root, true);
+  if (rc != TABLE_OK) return rc;
+
+  if (out_meta_page) *out_meta_page = meta_no;
+  return TABLE_OK;
+}
+
+int bidx_create(Pager* p, uint32_t root_page_no, const IndexKey* key, uint32_t* out_meta_page) {
+  // One write section for the build: snapshots see the table without it or with all of it
+  if (pager_write_begin(p) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = create_index(p, root_page_no, key, out_meta_page);
+  pager_write_end(p);
+  return rc;
+}
+
+int bidx_open(Pager* p, uint32_t root_page_no, const char* name, uint32_t* out_meta_page) {
+  if (!p || !name || root_page_no == 0 || root_page_no >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  const uint8_t* root = NULL;
+  if (pager_pin(p, root_page_no, (const void**)&root) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = root_validate(root, pager_page_size(p));
+  uint32_t idx = tbl_get_index_page(root);
+  pager_unpin(p, root, false);
+  if (rc != TABLE_OK) return rc;
+
+  uint32_t hops = 0;
+  while (idx != 0) {
+    if (idx >= pager_page_count(p) || ++hops > pager_page_count(p)) return TABLE_E_LAYOUT;
+
+    const uint8_t* meta = NULL;
+    if (pager_pin(p, idx, (const void**)&meta) != PAGER_OK) return TABLE_E_INVAL;
+    const bool match = read_le_u16(meta + BIDX_META_KIND_OFF) == TABLE_PAGE_KIND_BTREE_META &&
+                       strncmp((const char*)meta + BIDX_META_NAME_OFF, name, INDEX_NAME_MAX) == 0;
+    const uint32_t next = read_le_u32(meta + TABLE_INDEX_NEXT_OFF);
+    pager_unpin(p, meta, false);
+
+    if (match) {
+      if (out_meta_page) *out_meta_page = idx;
+      return TABLE_OK;
+    }
+    idx = next;
+  }
+  return TABLE_E_NOTFOUND;
+}
+
+int bidx_get_key(Pager* p, uint32_t meta_page, IndexKey* out_key) {
+  if (!out_key) return TABLE_E_INVAL;
+
+  const uint8_t* meta = NULL;
+  int rc = pin_meta_c(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+  meta_read_key(meta, out_key);
+  pager_unpin(p, meta, false);
+  return TABLE_OK;
+}
+
+int bidx_insert(Pager* p, uint32_t meta_page, const void* rec, uint64_t id) {
+  if (!rec) return TABLE_E_INVAL;
+
+  uint8_t* meta = NULL;
+  int rc = pin_meta(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  Tree t;
+  IndexKey k;
+  meta_read_key(meta, &k);
+  tree_init(&t, &k, p);
+
+  rc = insert_pinned(p, meta, &t, index_key_ptr(&k, rec), id);
+  pager_unpin(p, meta, true);
+  return rc;
+}
+
+int bidx_remove(Pager* p, uint32_t meta_page, const void* rec, uint64_t id) {
+  if (!rec) return TABLE_E_INVAL;
+
+  uint8_t* meta = NULL;
+  int rc = pin_meta(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  Tree t;
+  IndexKey k;
+  meta_read_key(meta, &k);
+  tree_init(&t, &k, p);
+  const uint8_t* key = index_key_ptr(&k, rec);
+
+  uint32_t leaf_no;
+  rc = descend(p, &t, read_le_u32(meta + BIDX_META_ROOT_OFF), meta[BIDX_META_HEIGHT_OFF],
+               key, id, EDGE_NONE, NULL, &leaf_no);
+
+  uint8_t* leaf = NULL;
+  if (rc == TABLE_OK) rc = node_pin(p, &t, leaf_no, 0, &leaf);
+  if (rc != TABLE_OK) { pager_unpin(p, meta, false); return rc; }
+
+  // No rebalancing: the leaf just shrinks, possibly to empty
+  const uint16_t count = node_count(leaf);
+  const uint16_t pos = node_search(&t, leaf, t.leaf_esz, key, id, false);
+  rc = TABLE_E_NOTFOUND;
+  if (pos < count) {
+    uint8_t* e = node_entry(leaf, pos, t.leaf_esz);
+    if (entry_cmp(&t, e, entry_id(&t, e), key, id) == 0) {
+      memmove(e, e + t.leaf_esz, (size_t)(count - pos - 1) * t.leaf_esz);
+      memset(node_entry(leaf, (uint16_t)(count - 1), t.leaf_esz), 0, t.leaf_esz);
+      write_le_u16(leaf + BIDX_NODE_COUNT_OFF, (uint16_t)(count - 1));
+      rc = TABLE_OK;
+    }
+  }
+  pager_unpin(p, leaf, rc == TABLE_OK);
+
+  if (rc == TABLE_OK)
+    write_le_u32(meta + BIDX_META_ENTRIES_OFF, read_le_u32(meta + BIDX_META_ENTRIES_OFF) - 1);
+  pager_unpin(p, meta, rc == TABLE_OK);
+  return rc;
+}
+
+int bidx_update(Pager* p, uint32_t meta_page, const void* old_rec, const void* new_rec, uint64_t id) {
+  if (!old_rec || !new_rec) return TABLE_E_INVAL;
+
+  IndexKey k;
+  int rc = bidx_get_key(p, meta_page, &k);
+  if (rc != TABLE_OK) return rc;
+  if (memcmp(index_key_ptr(&k, old_rec), index_key_ptr(&k, new_rec), k.len) == 0)
+    return TABLE_OK;
+
+  rc = bidx_remove(p, meta_page, old_rec, id);
+  if (rc != TABLE_OK) return rc;
+  return bidx_insert(p, meta_page, new_rec, id);
+}
+
+int bidx_cursor_open(Pager* p, uint32_t meta_page, const void* lo, const void* hi,
+                     bool reverse, BidxCursor* out) {
+  if (!out) return TABLE_E_INVAL;
+
+  const uint8_t* meta = NULL;
+  int rc = pin_meta_c(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  memset(out, 0, sizeof *out);
+  out->pager = p;
+  out->reverse = reverse;
+  meta_read_key(meta, &out->key);
+
+  Tree t;
+  tree_init(&t, &out->key, p);
+  const uint32_t root   = read_le_u32(meta + BIDX_META_ROOT_OFF);
+  const uint8_t  height = meta[BIDX_META_HEIGHT_OFF];
+  const uint32_t first  = read_le_u32(meta + BIDX_META_FIRST_LEAF_OFF);
+  pager_unpin(p, meta, false);
+
+  if (lo && hi && index_key_cmp(&t.key, lo, hi) > 0)
+    return TABLE_OK;   // empty range: leaf stays 0
+
+  const uint8_t* start = reverse ? hi : lo;
+  const uint8_t* bound = reverse ? lo : hi;
+  if (bound) {
+    out->has_bound = true;
+    memcpy(out->bound, bound, t.key.len);
+  }
+
+  if (!start) {
+    // Unbounded start: the outermost leaf on that side
+    if (!reverse) {
+      out->leaf = first;
+      out->pos = 0;
+      return TABLE_OK;
+    }
+    rc = descend(p, &t, root, height, NULL, 0, EDGE_RIGHT, NULL, &out->leaf);
+    out->pos = BIDX_POS_END;
+    return rc;
+  }
+
+  // (lo, id 0) sorts before every entry with key lo, (hi, UINT64_MAX) after
+  const uint64_t id = reverse ? UINT64_MAX : 0;
+  uint32_t leaf_no;
+  if ((rc = descend(p, &t, root, height, start, id, EDGE_NONE, NULL, &leaf_no)) != TABLE_OK)
+    return rc;
+
+  const uint8_t* leaf = NULL;
+  if ((rc = node_pin_c(p, &t, leaf_no, 0, &leaf)) != TABLE_OK) return rc;
+  const uint16_t pos = node_search(&t, leaf, t.leaf_esz, start, id, reverse);
+  pager_unpin(p, leaf, false);
+
+  out->leaf = leaf_no;
+  out->pos = reverse ? (int32_t)pos - 1 : (int32_t)pos;
+  return TABLE_OK;
+}
+
+int bidx_cursor_next(BidxCursor* cur, uint64_t* out_id, void* out_key) {
+  if (!cur || !cur->pager) return TABLE_E_INVAL;
+
+  Pager* p = cur->pager;
+  Tree t;
+  tree_init(&t, &cur->key, p);
+  uint32_t hops = 0;
+
+  while (cur->leaf != 0) {
+    if (++hops > pager_page_count(p)) return TABLE_E_LAYOUT;
+
+    const uint8_t* leaf = NULL;
+    int rc = node_pin_c(p, &t, cur->leaf, 0, &leaf);
+    if (rc != TABLE_OK) return rc;
+
+    const int32_t count = node_count(leaf);
+    if (cur->pos == BIDX_POS_END) cur->pos = count - 1;
+
+    // Step over exhausted (or emptied) leaves
+    if (cur->pos < 0 || cur->pos >= count) {
+      const uint32_t sib = read_le_u32(leaf + (cur->reverse ? BIDX_NODE_PREV_OFF : BIDX_NODE_NEXT_OFF));
+      pager_unpin(p, leaf, false);
+      cur->leaf = sib;
+      cur->pos = cur->reverse ? BIDX_POS_END : 0;
+      continue;
+    }
+
+    const uint8_t* e = node_entry_c(leaf, (uint16_t)cur->pos, t.leaf_esz);
+    if (cur->has_bound) {
+      const int c = index_key_cmp(&t.key, e, cur->bound);
+      if (cur->reverse ? c < 0 : c > 0) {
+        pager_unpin(p, leaf, false);
+        cur->leaf = 0;
+        break;
+      }
+    }
+
+    if (out_id) *out_id = entry_id(&t, e);
+    if (out_key) memcpy(out_key, e, t.key.len);
+    cur->pos += cur->reverse ? -1 : 1;
+    pager_unpin(p, leaf, false);
+    return TABLE_OK;
+  }
+  return TABLE_E_NOTFOUND;
+}
+
+int bidx_range(Pager* p, uint32_t meta_page, const void* lo, const void* hi, bool reverse,
+               int (*callback)(const void* record, uint64_t record_id, void* user_data),
+               void* user_data) {
+  if (!callback) return TABLE_E_INVAL;
+
+  BidxCursor cur;
+  int rc = bidx_cursor_open(p, meta_page, lo, hi, reverse, &cur);
+  if (rc != TABLE_OK) return rc;
+
+  uint8_t rec[TABLE_RECORD_SIZE];
+  uint64_t id;
+  while ((rc = bidx_cursor_next(&cur, &id, NULL)) == TABLE_OK) {
+    if (tblmgr_get(p, id, rec) != TABLE_OK) return TABLE_E_LAYOUT;
+    int cb_rc = callback(rec, id, user_data);
+    if (cb_rc != 0) return cb_rc;
+  }
+  return rc == TABLE_E_NOTFOUND ? TABLE_OK : rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Validation
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct CheckState {
+  Tree     t;
+  uint32_t first_leaf;    /* first leaf met, left to right */
+  uint32_t prev_leaf;     /* last leaf met */
+  uint32_t prev_next;     /* its right sibling link */
+  uint64_t entries;
+} CheckState;
+
+/**
+ * @brief Check the subtree at page_no: every entry within [lo, hi) (key + id
+ *        bounds, NULL = open) and strictly increasing; leaves in link order.
+ */
+static int check_node(Pager* p, CheckState* s, uint32_t page_no, uint16_t level,
+                      const uint8_t* lo, const uint8_t* hi) {
+  const Tree* t = &s->t;
+  const uint8_t* n = NULL;
+  int rc = node_pin_c(p, t, page_no, level, &n);
+  if (rc != TABLE_OK) return rc;
+
+  const size_t esz = level == 0 ? t->leaf_esz : t->inner_esz;
+  const uint16_t count = node_count(n);
+  for (uint16_t i = 0; i < count && rc == TABLE_OK; i++) {
+    const uint8_t* e = node_entry_c(n, i, esz);
+    const uint64_t id = entry_id(t, e);
+    if (i > 0) {
+      const uint8_t* prev = node_entry_c(n, (uint16_t)(i - 1), esz);
+      if (entry_cmp(t, prev, entry_id(t, prev), e, id) >= 0) rc = TABLE_E_LAYOUT;
+    }
+    if (lo && entry_cmp(t, e, id, lo, entry_id(t, lo)) < 0) rc = TABLE_E_LAYOUT;
+    if (hi && entry_cmp(t, e, id, hi, entry_id(t, hi)) >= 0) rc = TABLE_E_LAYOUT;
+  }
+
+  if (rc != TABLE_OK || level == 0) {
+    if (rc == TABLE_OK) {
+      if (read_le_u32(n + BIDX_NODE_PREV_OFF) != s->prev_leaf) rc = TABLE_E_LAYOUT;
+      if (s->prev_leaf == 0) s->first_leaf = page_no;
+      else if (s->prev_next != page_no) rc = TABLE_E_LAYOUT;
+      s->prev_leaf = page_no;
+      s->prev_next = read_le_u32(n + BIDX_NODE_NEXT_OFF);
+      s->entries += count;
+    }
+    pager_unpin(p, n, false);
+    return rc;
+  }
+  pager_unpin(p, n, false);
+
+  // Children one by one; bounds are copied out before the node is released
+  uint8_t child_lo[BIDX_ENTRY_MAX], child_hi[BIDX_ENTRY_MAX];
+  for (uint16_t i = 0; i <= count && rc == TABLE_OK; i++) {
+    if ((rc = node_pin_c(p, t, page_no, level, &n)) != TABLE_OK) break;
+    const uint32_t child = inner_child(t, n, i);
+    if (i > 0) memcpy(child_lo, node_entry_c(n, (uint16_t)(i - 1), esz), t->leaf_esz);
+    if (i < count) memcpy(child_hi, node_entry_c(n, i, esz), t->leaf_esz);
+    pager_unpin(p, n, false);
+
+    rc = check_node(p, s, child, (uint16_t)(level - 1),
+                    i > 0 ? child_lo : lo, i < count ? child_hi : hi);
+  }
+  return rc;
+}
+
+int bidx_validate(Pager* p, uint32_t meta_page) {
+  const uint8_t* meta = NULL;
+  int rc = pin_meta_c(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  CheckState s;
+  memset(&s, 0, sizeof s);
+  IndexKey k;
+  meta_read_key(meta, &k);
+  tree_init(&s.t, &k, p);
+
+  const uint8_t height = meta[BIDX_META_HEIGHT_OFF];
+  rc = check_node(p, &s, read_le_u32(meta + BIDX_META_ROOT_OFF), (uint16_t)(height - 1), NULL, NULL);
+
+  if (rc == TABLE_OK &&
+      (s.prev_next != 0 ||
+       s.first_leaf != read_le_u32(meta + BIDX_META_FIRST_LEAF_OFF) ||
+       s.entries != read_le_u32(meta + BIDX_META_ENTRIES_OFF)))
+    rc = TABLE_E_LAYOUT;
+  pager_unpin(p, meta, false);
+  return rc;
+}
@@ -0,0 +1,172 @@
+#ifndef BTREE_INDEX_H
+
+#define BTREE_INDEX_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "pager.h"
+#include "table.h"
+#include "index_key.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Secondary B+tree index (ordered)
+ *
+ * Header page: TABLE_PAGE_KIND_BTREE_META (0x0005), one per index, linked
+ * into the table's index list like a hash index (TABLE_INDEX_NEXT_OFF). It
+ * holds the key description, the root node and the tree height; it never
+ * moves, so the root can split without touching the index list.
+ *
+ * Entries are (key bytes, record id) pairs kept unique and sorted by key
+ * (index_key_cmp order) then id, so duplicate keys are allowed and every
+ * entry has one exact position.
+ *
+ * Leaf node: TABLE_PAGE_KIND_BTREE_LEAF (0x0007), entries back to back,
+ * doubly linked to its siblings in key order.
+ * Interior node: TABLE_PAGE_KIND_BTREE_INNER (0x0006), a first child then
+ * (separator key, separator id, child) triples; a child holds the entries
+ * >= its separator and < the next one.
+ *
+ * Deletes do not rebalance: a leaf may become empty and stays linked, range
+ * scans step over it. All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define BIDX_MAX_HEIGHT             16
+
+/* Header page offsets (bytes) */
+#define BIDX_META_KIND_OFF          0   /* u16 */
+#define BIDX_META_KEY_OFF_OFF       2   /* u16: key offset in the record */
+#define BIDX_META_KEY_LEN_OFF       4   /* u16: key length */
+#define BIDX_META_KEY_TYPE_OFF      6   /* u8 : INDEX_KEY_* */
+#define BIDX_META_HEIGHT_OFF        7   /* u8 : levels, 1 = the root is a leaf */
+#define BIDX_META_NEXT_OFF          8   /* u32: next index of the table (TABLE_INDEX_NEXT_OFF) */
+#define BIDX_META_TABLE_OFF         12  /* u32: root page of the indexed table */
+#define BIDX_META_ROOT_OFF          16  /* u32: root node */
+#define BIDX_META_ENTRIES_OFF       20  /* u32: indexed records */
+#define BIDX_META_FIRST_LEAF_OFF    24  /* u32: leftmost leaf */
+#define BIDX_META_NAME_OFF          32  /* char[32]: index (field) name */
+
+#define BIDX_NODE_HDR_SIZE          16
+
+/* Node page offsets (bytes) */
+#define BIDX_NODE_KIND_OFF          0   /* u16 */
+#define BIDX_NODE_COUNT_OFF         2   /* u16: entries (leaf) / separators (interior) */
+#define BIDX_NODE_KEY_LEN_OFF       4   /* u16: key length, as in the header */
+#define BIDX_NODE_LEVEL_OFF         6   /* u16: 0 = leaf */
+#define BIDX_NODE_NEXT_OFF          8   /* u32: leaf: right sibling / interior: first child */
+#define BIDX_NODE_PREV_OFF          12  /* u32: leaf: left sibling / interior: 0 */
+/* Leaf entry: key[len] + id; interior entry: key[len] + id + child u32. The
+ * id takes TABLE_ID_SIZE bytes (u64, or u32 in a version 1 file). */
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Range cursor
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Position inside a B+tree scan. Plain value, nothing to free.
+ *
+ * Stepping reads one leaf at a time; the scan ends at the first entry past
+ * the far bound, so leaves outside [lo, hi] are never read.
+ */
+typedef struct BidxCursor {
+  Pager*   pager;
+  IndexKey key;
+  uint32_t leaf;                        /* current leaf, 0 = exhausted */
+  int32_t  pos;                         /* next entry in `leaf` (BIDX_POS_END: its last) */
+  bool     reverse;                     /* descending key order */
+  bool     has_bound;
+  uint8_t  bound[TABLE_RECORD_SIZE];    /* hi (ascending) or lo (descending) key */
+} BidxCursor;
+
+#define BIDX_POS_END                INT32_MAX
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Create a B+tree index on `key` for the table rooted at root_page_no.
+ *
+ * Allocates the header page and an empty root leaf, indexes every record
+ * already in the table, then links the index into the table's index list so
+ * that tblmgr_insert / tblmgr_update / tblmgr_delete keep it up to date.
+ *
+ * @param p             Pager handle (read/write).
+ * @param root_page_no  Root leaf of the table.
+ * @param key           Key description; its name must be unique per table
+ *                      (across hash and B+tree indexes).
+ * @param out_meta_page Optional: receives the index header page.
+ * @return TABLE_OK, TABLE_E_INVAL (bad key, duplicate name, not a table root)
+ *         or another TABLE_E_* code.
+ */
+int bidx_create(Pager* p, uint32_t root_page_no, const IndexKey* key, uint32_t* out_meta_page);
+
+/**
+ * @brief Find the B+tree index called `name` on a table.
+ * @return TABLE_OK, or TABLE_E_NOTFOUND if the table has no such index.
+ */
+int bidx_open(Pager* p, uint32_t root_page_no, const char* name, uint32_t* out_meta_page);
+
+/**
+ * @brief Read the key description of an index.
+ */
+int bidx_get_key(Pager* p, uint32_t meta_page, IndexKey* out_key);
+
+/**
+ * @brief Add / remove the entry of record `id` (key taken from `rec`).
+ * bidx_insert returns TABLE_E_INVAL if the entry already exists,
+ * bidx_remove TABLE_E_NOTFOUND if it is missing.
+ */
+int bidx_insert(Pager* p, uint32_t meta_page, const void* rec, uint64_t id);
+int bidx_remove(Pager* p, uint32_t meta_page, const void* rec, uint64_t id);
+
+/**
+ * @brief Re-key record `id` after an update (no-op when the key is unchanged).
+ */
+int bidx_update(Pager* p, uint32_t meta_page, const void* old_rec, const void* new_rec, uint64_t id);
+
+/**
+ * @brief Position a cursor on the first entry of [lo, hi] (key.len bytes each).
+ *
+ * @param lo,hi    Inclusive bounds; NULL means unbounded on that side.
+ * @param reverse  Visit from hi down to lo instead.
+ * @return TABLE_OK (even if the range is empty) or a TABLE_E_* code.
+ */
+int bidx_cursor_open(Pager* p, uint32_t meta_page, const void* lo, const void* hi,
+                     bool reverse, BidxCursor* out);
+
+/**
+ * @brief Return the next entry of the range and advance.
+ *
+ * The index must not be modified while a cursor is open on it.
+ *
+ * @param out_id   Optional: receives the record id.
+ * @param out_key  Optional: receives the key bytes (key.len bytes).
+ * @return TABLE_OK, TABLE_E_NOTFOUND once the range is exhausted, or a
+ *         TABLE_E_* code.
+ */
+int bidx_cursor_next(BidxCursor* cur, uint64_t* out_id, void* out_key);
+
+/**
+ * @brief Visit the records with lo <= key <= hi in key order.
+ *
+ * The callback has the tblmgr_scan() signature; a non-zero return stops the
+ * scan and is returned. It must not modify the indexed table.
+ *
+ * @return TABLE_OK, the callback's value, or TABLE_E_LAYOUT if an entry
+ *         points at a missing record.
+ */
+int bidx_range(Pager* p, uint32_t meta_page, const void* lo, const void* hi, bool reverse,
+               int (*callback)(const void* record, uint64_t record_id, void* user_data),
+               void* user_data);
+
+/**
+ * @brief Check an index: header, node kinds and levels, key order against
+ *        the separators, leaf sibling links and entry count.
+ */
+int bidx_validate(Pager* p, uint32_t meta_page);
+
+#endif // BTREE_INDEX_H
@@ -0,0 +1,411 @@
+#include "catalog.h"
+#include "table.h"
+#include "endian_util.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static inline uint16_t entries_per_page(size_t page_size, size_t hdr, size_t entry) {
+  size_t n = (page_size - hdr) / entry;
+  return n > UINT16_MAX ? UINT16_MAX : (uint16_t)n;
+}
+
+static inline uint16_t cat_capacity(const Pager* p) {
+  return entries_per_page(pager_page_size(p), CAT_HDR_SIZE, CAT_ENTRY_SIZE);
+}
+
+static inline uint16_t dir_capacity(const Pager* p) {
+  return entries_per_page(pager_page_size(p), CAT_DIR_HDR_SIZE, 4u);
+}
+
+static inline uint8_t* cat_entry_ptr(uint8_t* page, uint16_t slot) {
+  return page + CAT_HDR_SIZE + (size_t)slot * CAT_ENTRY_SIZE;
+}
+
+static inline const uint8_t* cat_entry_ptr_c(const uint8_t* page, uint16_t slot) {
+  return page + CAT_HDR_SIZE + (size_t)slot * CAT_ENTRY_SIZE;
+}
+
+static inline uint8_t* dir_entry_ptr(uint8_t* page, uint16_t i) {
+  return page + CAT_DIR_HDR_SIZE + (size_t)i * 4u;
+}
+
+/**
+ * @brief Check kind, capacity and count of a catalog or directory page
+ *        (both share the kind / capacity / count header words).
+ */
+static int check_page(const Pager* p, const uint8_t* page, uint16_t kind) {
+  const uint16_t cap = kind == TABLE_PAGE_KIND_CATALOG ? cat_capacity(p) : dir_capacity(p);
+  if (read_le_u16(page + CAT_HDR_KIND_OFF) != kind)
+    return TABLE_E_BADKIND;
+  if (read_le_u16(page + CAT_HDR_CAPACITY_OFF) != cap ||
+      read_le_u16(page + CAT_HDR_COUNT_OFF) > cap)
+    return TABLE_E_LAYOUT;
+  return TABLE_OK;
+}
+
+static void decode_entry(const uint8_t* ent, uint32_t page_no, uint16_t slot, CatEntry* out) {
+  out->root     = read_le_u32(ent + CAT_ENT_ROOT_OFF);
+  out->tail     = read_le_u32(ent + CAT_ENT_TAIL_OFF);
+  out->leaves   = read_le_u32(ent + CAT_ENT_LEAVES_OFF);
+  out->dir      = read_le_u32(ent + CAT_ENT_DIR_OFF);
+  out->dir_tail = read_le_u32(ent + CAT_ENT_DIR_TAIL_OFF);
+  out->rows     = read_le_u64(ent + CAT_ENT_ROWS_OFF);
+  out->cat_page = page_no;
+  out->cat_slot = slot;
+}
+
+static void encode_entry(uint8_t* ent, const CatEntry* e) {
+  memset(ent, 0, CAT_ENTRY_SIZE);
+  write_le_u32(ent + CAT_ENT_ROOT_OFF, e->root);
+  write_le_u32(ent + CAT_ENT_TAIL_OFF, e->tail);
+  write_le_u32(ent + CAT_ENT_LEAVES_OFF, e->leaves);
+  write_le_u32(ent + CAT_ENT_DIR_OFF, e->dir);
+  write_le_u32(ent + CAT_ENT_DIR_TAIL_OFF, e->dir_tail);
+  write_le_u64(ent + CAT_ENT_ROWS_OFF, e->rows);
+}
+
+/**
+ * @brief Allocate and initialize an empty catalog or directory page.
+ */
+static int new_page(Pager* p, uint16_t kind, uint32_t root, uint32_t* out_no) {
+  uint32_t no;
+  if (pager_alloc_page(p, &no) != PAGER_OK) return TABLE_E_INVAL;
+
+  uint8_t* page = NULL;
+  if (pager_pin_zero(p, no, (void**)&page) != PAGER_OK) return TABLE_E_INVAL;
+  write_le_u16(page + CAT_HDR_KIND_OFF, kind);
+  write_le_u16(page + CAT_HDR_CAPACITY_OFF,
+               kind == TABLE_PAGE_KIND_CATALOG ? cat_capacity(p) : dir_capacity(p));
+  if (kind == TABLE_PAGE_KIND_DIRECTORY)
+    write_le_u32(page + CAT_DIR_ROOT_OFF, root);
+  pager_unpin(p, page, true);
+
+  *out_no = no;
+  return TABLE_OK;
+}
+
+/**
+ * @brief Walk the catalog chain. For each page the callback gets the pinned
+ *        page; a non-zero return stops the walk and is returned.
+ */
+static int walk_catalog(Pager* p, int (*visit)(Pager*, const uint8_t*, uint32_t, void*), void* ctx) {
+  uint32_t page_no = 0;
+  if (pager_get_catalog(p, &page_no) != PAGER_OK) return TABLE_E_INVAL;
+
+  const uint32_t page_count = pager_page_count(p);
+  uint32_t hops = 0;
+  while (page_no != 0) {
+    if (page_no >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* page = NULL;
+    if (pager_pin(p, page_no, (const void**)&page) != PAGER_OK) return TABLE_E_INVAL;
+    int rc = check_page(p, page, TABLE_PAGE_KIND_CATALOG);
+    if (rc == TABLE_OK)
+      rc = visit(p, page, page_no, ctx);
+    const uint32_t next = read_le_u32(page + CAT_HDR_NEXT_OFF);
+    pager_unpin(p, page, false);
+    if (rc != TABLE_OK) return rc;
+    page_no = next;
+  }
+  return TABLE_OK;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Lookup / iteration
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct FindCtx {
+  uint32_t  root;
+  CatEntry* out;
+} FindCtx;
+
+enum { WALK_FOUND = 1 };
+
+static int find_visit(Pager* p, const uint8_t* page, uint32_t page_no, void* ud) {
+  (void)p;
+  FindCtx* c = (FindCtx*)ud;
+  const uint16_t count = read_le_u16(page + CAT_HDR_COUNT_OFF);
+  for (uint16_t i = 0; i < count; i++) {
+    const uint8_t* ent = cat_entry_ptr_c(page, i);
+    if (read_le_u32(ent + CAT_ENT_ROOT_OFF) != c->root) continue;
+    decode_entry(ent, page_no, i, c->out);
+    return WALK_FOUND;
+  }
+  return TABLE_OK;
+}
+
+int cat_lookup(Pager* p, uint32_t root, CatEntry* out) {
+  if (!p || root == 0 || !out)
+    return TABLE_E_INVAL;
+
+  FindCtx c = { root, out };
+  const int rc = walk_catalog(p, find_visit, &c);
+  if (rc == WALK_FOUND) return TABLE_OK;
+  return rc == TABLE_OK ? TABLE_E_NOTFOUND : rc;
+}
+
+typedef struct EachCtx {
+  int (*callback)(const CatEntry*, void*);
+  void* user_data;
+  int   cb_rc;
+} EachCtx;
+
+static int each_visit(Pager* p, const uint8_t* page, uint32_t page_no, void* ud) {
+  (void)p;
+  EachCtx* c = (EachCtx*)ud;
+  const uint16_t count = read_le_u16(page + CAT_HDR_COUNT_OFF);
+  for (uint16_t i = 0; i < count; i++) {
+    CatEntry e;
+    decode_entry(cat_entry_ptr_c(page, i), page_no, i, &e);
+    c->cb_rc = c->callback(&e, c->user_data);
+    if (c->cb_rc != 0) return WALK_FOUND;
+  }
+  return TABLE_OK;
+}
+
+int cat_foreach(Pager* p, int (*callback)(const CatEntry* e, void* user_data), void* user_data) {
+  if (!p || !callback)
+    return TABLE_E_INVAL;
+
+  EachCtx c = { callback, user_data, 0 };
+  const int rc = walk_catalog(p, each_visit, &c);
+  return rc == WALK_FOUND ? c.cb_rc : rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Directory
+// ─────────────────────────────────────────────────────────────────────────────
+int cat_dir_append(Pager* p, CatEntry* e, const uint32_t* leaves, size_t count) {
+  if (!p || !e || (!leaves && count > 0))
+    return TABLE_E_INVAL;
+  if (count == 0)
+    return TABLE_OK;
+  if (e->dir_tail == 0 || e->dir_tail >= pager_page_count(p))
+    return TABLE_E_LAYOUT;
+
+  uint32_t dir_no = e->dir_tail;
+  uint8_t* dir = NULL;
+  if (pager_pin_mut(p, dir_no, (void**)&dir) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = check_page(p, dir, TABLE_PAGE_KIND_DIRECTORY);
+  if (rc != TABLE_OK) { pager_unpin(p, dir, false); return rc; }
+
+  const uint16_t cap = dir_capacity(p);
+  size_t done = 0;
+  while (done < count) {
+    uint16_t n = read_le_u16(dir + CAT_DIR_COUNT_OFF);
+    const size_t before = done;
+    while (done < count && n < cap)
+      write_le_u32(dir_entry_ptr(dir, n++), leaves[done++]);
+    write_le_u16(dir + CAT_DIR_COUNT_OFF, n);
+    if (done > before) {
+      e->tail = leaves[done - 1];
+      e->leaves += (uint32_t)(done - before);
+    }
+    if (done == count) break;
+
+    // Tail page is full: chain a fresh one after it
+    uint32_t next_no;
+    rc = new_page(p, TABLE_PAGE_KIND_DIRECTORY, e->root, &next_no);
+    if (rc != TABLE_OK) { pager_unpin(p, dir, true); return rc; }
+    write_le_u32(dir + CAT_DIR_NEXT_OFF, next_no);
+    pager_unpin(p, dir, true);
+
+    dir_no = next_no;
+    e->dir_tail = next_no;
+    if (pager_pin_mut(p, dir_no, (void**)&dir) != PAGER_OK) return TABLE_E_INVAL;
+  }
+  pager_unpin(p, dir, true);
+  return TABLE_OK;
+}
+
+int cat_dir_rewrite(Pager* p, CatEntry* e, const uint32_t* leaves, size_t n) {
+  if (!p || !e || !leaves || n == 0 || leaves[0] != e->root || n > UINT32_MAX)
+    return TABLE_E_INVAL;
+  if (e->dir == 0 || e->dir >= pager_page_count(p))
+    return TABLE_E_LAYOUT;
+
+  // Fill the existing pages front to back, then cut the chain after the
+  // last one used (or grow it through cat_dir_append)
+  const uint16_t cap = dir_capacity(p);
+  const uint32_t page_count = pager_page_count(p);
+  uint32_t dir_no = e->dir;
+  uint32_t hops = 0;
+  size_t done = 0;
+  while (true) {
+    if (dir_no >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+    uint8_t* dir = NULL;
+    if (pager_pin_mut(p, dir_no, (void**)&dir) != PAGER_OK) return TABLE_E_INVAL;
+    int rc = check_page(p, dir, TABLE_PAGE_KIND_DIRECTORY);
+    if (rc == TABLE_OK && read_le_u32(dir + CAT_DIR_ROOT_OFF) != e->root) rc = TABLE_E_LAYOUT;
+    if (rc != TABLE_OK) { pager_unpin(p, dir, false); return rc; }
+
+    uint16_t k = 0;
+    while (done < n && k < cap)
+      write_le_u32(dir_entry_ptr(dir, k++), leaves[done++]);
+    write_le_u16(dir + CAT_DIR_COUNT_OFF, k);
+    const uint32_t next = read_le_u32(dir + CAT_DIR_NEXT_OFF);
+    if (done == n) write_le_u32(dir + CAT_DIR_NEXT_OFF, 0);
+    pager_unpin(p, dir, true);
+
+    if (done == n || next == 0) {
+      e->dir_tail = dir_no;
+      e->tail = leaves[done - 1];
+      e->leaves = (uint32_t)done;
+      for (uint32_t spare = done == n ? next : 0; spare != 0; ) {
+        if (spare >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+        const uint8_t* sp = NULL;
+        if (pager_pin(p, spare, (const void**)&sp) != PAGER_OK) return TABLE_E_INVAL;
+        rc = check_page(p, sp, TABLE_PAGE_KIND_DIRECTORY);
+        const uint32_t after = read_le_u32(sp + CAT_DIR_NEXT_OFF);
+        pager_unpin(p, sp, false);
+        if (rc != TABLE_OK) return rc;
+        if (pager_free_page(p, spare) != PAGER_OK) return TABLE_E_INVAL;
+        spare = after;
+      }
+      return cat_dir_append(p, e, leaves + done, n - done);
+    }
+    dir_no = next;
+  }
+}
+
+/**
+ * @brief Fill `pages` (room for e->leaves + 1) from the directory of `e`.
+ */
+static int dir_read(Pager* p, const CatEntry* e, uint32_t* pages) {
+  // Directories are appended to before their entry is stored: read the
+  // first e->leaves pages, later ones belong to a newer entry
+  const uint32_t page_count = pager_page_count(p);
+  uint32_t dir_no = e->dir;
+  size_t n = 0;
+  uint32_t hops = 0;
+  while (dir_no != 0 && n < e->leaves) {
+    if (dir_no >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* dir = NULL;
+    if (pager_pin(p, dir_no, (const void**)&dir) != PAGER_OK) return TABLE_E_INVAL;
+    int rc = check_page(p, dir, TABLE_PAGE_KIND_DIRECTORY);
+    if (rc == TABLE_OK && read_le_u32(dir + CAT_DIR_ROOT_OFF) != e->root)
+      rc = TABLE_E_LAYOUT;
+    if (rc == TABLE_OK) {
+      const uint16_t count = read_le_u16(dir + CAT_DIR_COUNT_OFF);
+      for (uint16_t i = 0; i < count && n < e->leaves; i++)
+        pages[n++] = read_le_u32(dir + CAT_DIR_HDR_SIZE + (size_t)i * 4u);
+    }
+    const uint32_t next = read_le_u32(dir + CAT_DIR_NEXT_OFF);
+    pager_unpin(p, dir, false);
+    if (rc != TABLE_OK) return rc;
+    dir_no = next;
+  }
+  return n == e->leaves ? TABLE_OK : TABLE_E_LAYOUT;
+}
+
+int cat_dir_pages(Pager* p, const CatEntry* e, uint32_t** out, size_t* out_n) {
+  if (!p || !e || !out || !out_n)
+    return TABLE_E_INVAL;
+
+  uint32_t* pages = malloc(((size_t)e->leaves + 1) * sizeof *pages);
+  if (!pages) return TABLE_E_INVAL;
+  const int rc = dir_read(p, e, pages);
+  if (rc != TABLE_OK) { free(pages); return rc; }
+  *out = pages;
+  *out_n = e->leaves;
+  return TABLE_OK;
+}
+
+int cat_dir_pages_in(Pager* p, const CatEntry* e, Arena* a, uint32_t** out, size_t* out_n) {
+  if (!p || !e || !a || !out || !out_n)
+    return TABLE_E_INVAL;
+
+  uint32_t* pages = arena_alloc(a, ((size_t)e->leaves + 1) * sizeof *pages);
+  if (!pages) return TABLE_E_INVAL;
+  const int rc = dir_read(p, e, pages);
+  if (rc != TABLE_OK) return rc;
+  *out = pages;
+  *out_n = e->leaves;
+  return TABLE_OK;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Registration / update
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct RoomCtx {
+  uint32_t with_room;     // first catalog page with a free entry
+  uint32_t last;          // last page of the chain
+} RoomCtx;
+
+static int room_visit(Pager* p, const uint8_t* page, uint32_t page_no, void* ud) {
+  RoomCtx* c = (RoomCtx*)ud;
+  c->last = page_no;
+  if (c->with_room == 0 && read_le_u16(page + CAT_HDR_COUNT_OFF) < cat_capacity(p))
+    c->with_room = page_no;
+  return TABLE_OK;
+}
+
+int cat_add(Pager* p, uint32_t root, const uint32_t* leaves, size_t n, uint64_t rows, CatEntry* out) {
+  if (!p || root == 0 || !leaves || n == 0 || leaves[0] != root || n > UINT32_MAX)
+    return TABLE_E_INVAL;
+
+  CatEntry e;
+  int rc = cat_lookup(p, root, &e);
+  if (rc == TABLE_OK) return TABLE_E_INVAL;
+  if (rc != TABLE_E_NOTFOUND) return rc;
+
+  // Directory first: the entry only becomes visible once it is complete
+  memset(&e, 0, sizeof e);
+  e.root = root;
+  e.rows = rows;
+  rc = new_page(p, TABLE_PAGE_KIND_DIRECTORY, root, &e.dir);
+  if (rc != TABLE_OK) return rc;
+  e.dir_tail = e.dir;
+  rc = cat_dir_append(p, &e, leaves, n);
+  if (rc != TABLE_OK) return rc;
+
+  // A catalog page with room, or a fresh one at the end of the chain
+  RoomCtx room = { 0, 0 };
+  rc = walk_catalog(p, room_visit, &room);
+  if (rc != TABLE_OK) return rc;
+  if (room.with_room == 0) {
+    rc = new_page(p, TABLE_PAGE_KIND_CATALOG, 0, &room.with_room);
+    if (rc != TABLE_OK) return rc;
+
+    if (room.last == 0) {
+      if (pager_set_catalog(p, room.with_room) != PAGER_OK) return TABLE_E_INVAL;
+    } else {
+      uint8_t* last = NULL;
+      if (pager_pin_mut(p, room.last, (void**)&last) != PAGER_OK) return TABLE_E_INVAL;
+      write_le_u32(last + CAT_HDR_NEXT_OFF, room.with_room);
+      pager_unpin(p, last, true);
+    }
+  }
+
+  uint8_t* page = NULL;
+  if (pager_pin_mut(p, room.with_room, (void**)&page) != PAGER_OK) return TABLE_E_INVAL;
+  const uint16_t slot = read_le_u16(page + CAT_HDR_COUNT_OFF);
+  e.cat_page = room.with_room;
+  e.cat_slot = slot;
+  encode_entry(cat_entry_ptr(page, slot), &e);
+  write_le_u16(page + CAT_HDR_COUNT_OFF, (uint16_t)(slot + 1));
+  pager_unpin(p, page, true);
+
+  if (out) *out = e;
+  return TABLE_OK;
+}
+
+int cat_store(Pager* p, const CatEntry* e) {
+  if (!p || !e || e->cat_page == 0 || e->cat_page >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  uint8_t* page = NULL;
+  if (pager_pin_mut(p, e->cat_page, (void**)&page) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = check_page(p, page, TABLE_PAGE_KIND_CATALOG);
+  if (rc == TABLE_OK && (e->cat_slot >= read_le_u16(page + CAT_HDR_COUNT_OFF) ||
+                         read_le_u32(cat_entry_ptr(page, e->cat_slot) + CAT_ENT_ROOT_OFF) != e->root))
+    rc = TABLE_E_LAYOUT;
+  if (rc == TABLE_OK)
+    encode_entry(cat_entry_ptr(page, e->cat_slot), e);
+  pager_unpin(p, page, rc == TABLE_OK);
+  return rc;
+}
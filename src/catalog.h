@@ -0,0 +1,139 @@
+#ifndef CATALOG_H
+
+#define CATALOG_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include "pager.h"
+#include "arena.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Table catalog and page directories
+ *
+ * Catalog page: TABLE_PAGE_KIND_CATALOG (0x0008). The first one is recorded
+ * in the file header (pager_get_catalog); more are chained via `next` once
+ * it is full. Each entry describes one table: its root, its tail leaf, the
+ * number of leaves and rows, and its directory.
+ *
+ * Directory page: TABLE_PAGE_KIND_DIRECTORY (0x0009), one chain per table.
+ * Entries are the table's leaf pages in chain order, so page k of a table is
+ * found by reading one directory page instead of walking k leaves.
+ *
+ * The catalog is maintained by table_manager.c; entries are never removed.
+ * Tables written before the catalog existed have no entry until their next
+ * insert. All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define CAT_HDR_SIZE                16
+
+/* Catalog page header offsets (bytes) */
+#define CAT_HDR_KIND_OFF            0   /* u16 */
+#define CAT_HDR_CAPACITY_OFF        2   /* u16: max entries */
+#define CAT_HDR_COUNT_OFF           4   /* u16: entries in use */
+#define CAT_HDR_NEXT_OFF            8   /* u32: next catalog page (0 = none) */
+
+/* Catalog entry, CAT_ENTRY_SIZE bytes from CAT_HDR_SIZE */
+#define CAT_ENTRY_SIZE              32
+#define CAT_ENT_ROOT_OFF            0   /* u32: root leaf of the table */
+#define CAT_ENT_TAIL_OFF            4   /* u32: last leaf of the chain */
+#define CAT_ENT_LEAVES_OFF          8   /* u32: leaves in the chain */
+#define CAT_ENT_DIR_OFF             12  /* u32: first directory page */
+#define CAT_ENT_DIR_TAIL_OFF        16  /* u32: last directory page */
+#define CAT_ENT_ROWS_OFF            24  /* u64: records in the table */
+
+#define CAT_DIR_HDR_SIZE            16
+
+/* Directory page header offsets (bytes) */
+#define CAT_DIR_KIND_OFF            0   /* u16 */
+#define CAT_DIR_CAPACITY_OFF        2   /* u16: max entries */
+#define CAT_DIR_COUNT_OFF           4   /* u16: entries in use */
+#define CAT_DIR_NEXT_OFF            8   /* u32: next directory page (0 = none) */
+#define CAT_DIR_ROOT_OFF            12  /* u32: owning table */
+/* Entries: u32 leaf page numbers from CAT_DIR_HDR_SIZE, chain order. */
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Catalog entry (in memory)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Decoded catalog entry. cat_page / cat_slot locate it on disk so
+ *        that cat_store() does not search again.
+ */
+typedef struct CatEntry {
+  uint32_t root;
+  uint32_t tail;
+  uint32_t leaves;
+  uint32_t dir;
+  uint32_t dir_tail;
+  uint64_t rows;
+  uint32_t cat_page;
+  uint16_t cat_slot;
+} CatEntry;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Find the catalog entry of the table rooted at `root`.
+ * @return TABLE_OK, TABLE_E_NOTFOUND (file has no catalog or no such table)
+ *         or TABLE_E_BADKIND / TABLE_E_LAYOUT on a damaged catalog.
+ */
+int cat_lookup(Pager* p, uint32_t root, CatEntry* out);
+
+/**
+ * @brief Register a table: write its directory from `leaves` (chain order,
+ *        leaves[0] == root) and add its entry, creating the catalog if needed.
+ *
+ * @param rows  Records currently in the table.
+ * @param out   Optional: receives the new entry.
+ * @return TABLE_OK, TABLE_E_INVAL if the table is already registered, or
+ *         another TABLE_E_* code.
+ */
+int cat_add(Pager* p, uint32_t root, const uint32_t* leaves, size_t n, uint64_t rows, CatEntry* out);
+
+/**
+ * @brief Write an entry back at its location (tail, counts, directory).
+ */
+int cat_store(Pager* p, const CatEntry* e);
+
+/**
+ * @brief Append `count` leaves to the directory of `e` and update its tail
+ *        and leaf count in memory; the caller persists `e` with cat_store().
+ */
+int cat_dir_append(Pager* p, CatEntry* e, const uint32_t* leaves, size_t count);
+
+/**
+ * @brief Replace the whole directory of `e` with `leaves` (chain order,
+ *        leaves[0] == e->root), reusing its pages in order. Directory pages
+ *        no longer needed go to the pager's free list. Updates the tail,
+ *        leaf count and directory tail of `e` in memory; the caller persists
+ *        it with cat_store().
+ */
+int cat_dir_rewrite(Pager* p, CatEntry* e, const uint32_t* leaves, size_t n);
+
+/**
+ * @brief Read the leaf pages of a table from its directory.
+ *
+ * @param out    Receives a malloc'ed array of e->leaves page numbers (free
+ *               it); the count is checked against the directory.
+ * @return TABLE_OK, TABLE_E_LAYOUT if the directory disagrees with the entry.
+ */
+int cat_dir_pages(Pager* p, const CatEntry* e, uint32_t** out, size_t* out_n);
+
+/**
+ * @brief cat_dir_pages() into `a`: the array lives until the arena is
+ *        rewound past it (nothing to free).
+ */
+int cat_dir_pages_in(Pager* p, const CatEntry* e, Arena* a, uint32_t** out, size_t* out_n);
+
+/**
+ * @brief Visit every catalog entry in registration order. A non-zero
+ *        callback return stops the walk and is returned.
+ */
+int cat_foreach(Pager* p, int (*callback)(const CatEntry* e, void* user_data), void* user_data);
+
+#endif // CATALOG_H
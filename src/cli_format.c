@@ -1,7 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
 #include "cli_format.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
 
 // --- internal helpers ---------------------------------------------------------
 static void trim(char* s) {
@@ -26,7 +29,7 @@ static int parse_one_field(char* part, Field* out) {
   char* endptr = NULL;
   long off = strtol(b, &endptr, 10); if (*b=='\0' || *endptr) return -1;
   long len = strtol(c, &endptr, 10); if (*c=='\0' || *endptr) return -1;
-  if (off < 0 || off > 65535 || len < 0 || len > 65535) return -1;
+  if (off < 0 || len < 0 || off + len > TABLE_RECORD_SIZE) return -1;
   out->off = (uint16_t)off;
   out->len = (uint16_t)len;
 
@@ -73,76 +76,524 @@ int parse_spec(char* spec_in, FieldSpec* fs) {
 }
 
 static uint16_t rd_u16le(const unsigned char* p) { return (uint16_t)(p[0] | (p[1]<<8)); }
-static uint32_t rd_u32le(const unsigned char* p) { return (uint32_t)(p[0] | (p[1]<<8) | (p[2]<<16) | (p[3]<<24)); }
+static uint32_t rd_u32le(const unsigned char* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
 
-static void render_field(const Field* f, const unsigned char rec[128], char* out, size_t outsz) {
+static const char k_hex[] = "0123456789abcdef";
+
+// Decimal digits of v at out (20 bytes at most), returns their count
+static size_t fmt_u64(char* out, uint64_t v) {
+  char tmp[20];
+  size_t n = 0;
+  do { tmp[n++] = (char)('0' + v % 10u); v /= 10u; } while (v);
+  for (size_t i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+  return n;
+}
+
+// Bytes of a field that lie inside the 128-byte record
+static uint16_t field_len(const Field* f) {
+  if (f->off >= TABLE_RECORD_SIZE) return 0;
+  return f->len > TABLE_RECORD_SIZE - f->off ? (uint16_t)(TABLE_RECORD_SIZE - f->off) : f->len;
+}
+
+// Longest cell render_cell() writes: a 128-byte field in hex
+#define CELL_MAX 256
+
+// Text of a field at out (CELL_MAX bytes at most, not NUL-terminated),
+// returns its length. clip cuts strings and hex to the column width.
+static size_t render_cell(const Field* f, const unsigned char* rec, char* out, bool clip) {
   const unsigned char* base = rec + f->off;
+  const uint16_t len = field_len(f);
   switch (f->type) {
     case FT_STR: {
       size_t n = 0;
-      while (n < f->len && n + 1 < outsz) {
-        unsigned char c = base[n];
-        if (c == 0) break;
-        out[n++] = (char)c;
-      }
-      out[n] = 0;
-      for (ssize_t j = (ssize_t)n - 1; j >= 0; j--) {
-        if (out[j] == ' ') out[j] = 0; else break;
+      while (n < len && base[n]) n++;
+      while (n && base[n - 1] == ' ') n--;
+      if (clip && n > f->colw) n = f->colw;
+      memcpy(out, base, n);
+      return n;
+    }
+    case FT_HEX: {
+      size_t nb = clip ? (f->colw + 1u) / 2u : len;
+      if (nb > len) nb = len;
+      for (size_t i = 0; i < nb; i++) {
+        out[2 * i]     = k_hex[base[i] >> 4];
+        out[2 * i + 1] = k_hex[base[i] & 15u];
       }
-      if (strlen(out) > f->colw) out[f->colw] = 0;
-    } break;
+      return 2 * nb;
+    }
+    case FT_U8:  return len >= 1 ? fmt_u64(out, base[0]) : 0;
+    case FT_U16: return len >= 2 ? fmt_u64(out, rd_u16le(base)) : 0;
+    case FT_U32: return len >= 4 ? fmt_u64(out, rd_u32le(base)) : 0;
+  }
+  return 0;
+}
+
+static int hex_digit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+int encode_field_value(const Field* f, const char* text, unsigned char* out, size_t cap) {
+  if (!f || !text || !out || f->len > cap) return -1;
+
+  switch (f->type) {
+    case FT_STR: {
+      size_t n = strlen(text);
+      if (n > f->len) return -1;
+      memset(out, 0, f->len);
+      memcpy(out, text, n);
+    } return 0;
     case FT_HEX: {
-      size_t k = 0;
-      for (uint16_t i = 0; i < f->len && k + 2 < outsz; i++) {
-        k += (size_t)snprintf(out + k, outsz - k, "%02x", base[i]);
-        if (k >= (size_t)f->colw) break;
+      if (strlen(text) != (size_t)f->len * 2) return -1;
+      for (uint16_t i = 0; i < f->len; i++) {
+        int hi = hex_digit(text[2*i]), lo = hex_digit(text[2*i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        out[i] = (unsigned char)(hi << 4 | lo);
       }
-      out[k] = 0;
-    } break;
-    case FT_U8:  snprintf(out, outsz, "%u", (unsigned)base[0]); break;
-    case FT_U16: snprintf(out, outsz, "%u", (unsigned)rd_u16le(base)); break;
-    case FT_U32: snprintf(out, outsz, "%u", (unsigned)rd_u32le(base)); break;
+    } return 0;
+    case FT_U8: case FT_U16: case FT_U32: {
+      const uint16_t width = f->type == FT_U8 ? 1 : f->type == FT_U16 ? 2 : 4;
+      if (f->len != width || *text == '\0' || *text == '-') return -1;
+      char* end = NULL;
+      unsigned long long v = strtoull(text, &end, 10);
+      if (*end) return -1;
+      if (width < 4 && v >> (8 * width)) return -1;
+      if (v > UINT32_MAX) return -1;
+      for (uint16_t i = 0; i < width; i++) out[i] = (unsigned char)(v >> (8 * i));
+    } return 0;
   }
+  return -1;
 }
 
-static void print_hr(const FieldSpec* fs) {
-  printf("+--------+");
-  for (int i = 0; i < fs->n; i++) {
-    for (uint16_t k = 0; k < fs->f[i].colw + 2; k++) putchar('-');
+static const Field* find_field(const FieldSpec* fs, const char* name) {
+  for (int i = 0; i < fs->n; i++)
+    if (strcmp(fs->f[i].name, name) == 0) return &fs->f[i];
+  return NULL;
+}
+
+static int parse_one_term(char* part, const FieldSpec* fs, TblPred* pred) {
+  const size_t nl = strcspn(part, "=<>^");
+  if (part[nl] == '\0') return -1;
+
+  PredTerm t;
+  memset(&t, 0, sizeof t);
+  char* value = part + nl + 1;
+  switch (part[nl]) {
+    case '=': t.op = PRED_EQ; break;
+    case '<': t.op = PRED_LT; break;
+    case '>': t.op = PRED_GT; break;
+    case '^': if (*value != '=') return -1; value++; t.op = PRED_PREFIX; break;
+  }
+  part[nl] = 0;
+  trim(part);
+  trim(value);
+
+  const Field* f = find_field(fs, part);
+  if (!f) return -1;
+  t.off  = f->off;
+  t.len  = f->len;
+  t.type = (uint8_t)f->type;
+
+  if (t.op == PRED_PREFIX) {
+    const size_t n = strlen(value);
+    if (f->type != FT_STR || n == 0 || n > f->len) return -1;
+    memcpy(t.a, value, n);
+    t.n = (uint16_t)n;
+  } else {
+    char* dots = t.op == PRED_EQ ? strstr(value, "..") : NULL;
+    if (dots) {
+      *dots = 0;
+      t.op = PRED_BETWEEN;
+      if (encode_field_value(f, dots + 2, t.b, sizeof t.b) != 0) return -1;
+    }
+    if (encode_field_value(f, value, t.a, sizeof t.a) != 0) return -1;
+  }
+  return pred_add(pred, &t) == TABLE_OK ? 0 : -1;
+}
+
+int parse_where(char* text, const FieldSpec* fs, TblPred* pred) {
+  if (!text || !fs || !pred) return -1;
+  char* s = text;
+  for (;;) {
+    char* comma = strchr(s, ',');
+    if (comma) *comma = 0;
+    if (parse_one_term(s, fs, pred) != 0) return -1;
+    if (!comma) return 0;
+    s = comma + 1;
+  }
+}
+
+static int parse_one_agg(char* part, const FieldSpec* fs, AggQuery* q) {
+  trim(part);
+  const int k = q->spec.nfuncs;
+  if (k >= AGG_MAX_FUNCS) return -1;
+  if (strcmp(part, "count") == 0 || strcmp(part, "count(*)") == 0) {
+    q->spec.func[k] = AGG_COUNT;
+    snprintf(q->label[k], sizeof q->label[k], "count");
+    q->spec.nfuncs++;
+    return 0;
+  }
+
+  static const struct { const char* name; AggFunc func; } k_funcs[] = {
+    { "sum", AGG_SUM }, { "min", AGG_MIN }, { "max", AGG_MAX }, { "avg", AGG_AVG },
+  };
+  char* lp = strchr(part, '(');
+  const size_t plen = strlen(part);
+  if (!lp || plen < 2 || part[plen - 1] != ')') return -1;
+  *lp = 0;
+  part[plen - 1] = 0;
+  char* arg = lp + 1;
+  trim(part);
+  trim(arg);
+
+  for (size_t i = 0; i < sizeof k_funcs / sizeof k_funcs[0]; i++) {
+    if (strcmp(part, k_funcs[i].name) != 0) continue;
+    const Field* f = find_field(fs, arg);
+    if (!f || (f->type != FT_U8 && f->type != FT_U16 && f->type != FT_U32)) return -1;
+    q->spec.func[k] = (uint8_t)k_funcs[i].func;
+    q->spec.arg[k] = (AggField){ .off = f->off, .len = f->len, .type = (uint8_t)f->type };
+    snprintf(q->label[k], sizeof q->label[k], "%s(%s)", part, f->name);
+    q->spec.nfuncs++;
+    return 0;
+  }
+  return -1;
+}
+
+int parse_agg(char* text, const FieldSpec* fs, AggQuery* q) {
+  if (!text || !fs || !q) return -1;
+  memset(q, 0, sizeof *q);
+
+  char* by = strstr(text, " by ");
+  if (by) { *by = 0; by += 4; }
+
+  for (char* s = text; ; ) {
+    char* comma = strchr(s, ',');
+    if (comma) *comma = 0;
+    if (parse_one_agg(s, fs, q) != 0) return -1;
+    if (!comma) break;
+    s = comma + 1;
+  }
+
+  for (char* s = by; s; ) {
+    char* comma = strchr(s, ',');
+    if (comma) *comma = 0;
+    trim(s);
+    const Field* f = find_field(fs, s);
+    if (!f || q->spec.ngroup >= AGG_MAX_GROUP) return -1;
+    q->group[q->spec.ngroup] = f;
+    q->spec.group[q->spec.ngroup++] = (AggField){ .off = f->off, .len = f->len, .type = (uint8_t)f->type };
+    s = comma ? comma + 1 : NULL;
+  }
+  return 0;
+}
+
+static void print_rule(const uint16_t* w, int n) {
+  putchar('+');
+  for (int i = 0; i < n; i++) {
+    for (uint16_t k = 0; k < w[i] + 2; k++) putchar('-');
     putchar('+');
   }
   putchar('\n');
 }
 
-void print_header_spec(const FieldSpec* fs) {
-  print_hr(fs);
-  printf("| %-6s |", "ID");
-  for (int i = 0; i < fs->n; i++) {
-    printf(" %-*s |", fs->f[i].colw, fs->f[i].name);
+void print_agg(const AggQuery* q, const AggResult* r) {
+  const AggSpec* s = &q->spec;
+  uint16_t w[AGG_MAX_GROUP + AGG_MAX_FUNCS];
+  int n = 0;
+  for (int i = 0; i < s->ngroup; i++) w[n++] = q->group[i]->colw;
+  for (int k = 0; k < s->nfuncs; k++) {
+    const size_t len = strlen(q->label[k]);
+    w[n++] = (uint16_t)(len > 12 ? len : 12);
   }
+
+  print_rule(w, n);
+  putchar('|');
+  for (int i = 0; i < s->ngroup; i++) printf(" %-*s |", w[i], q->group[i]->name);
+  for (int k = 0; k < s->nfuncs; k++) printf(" %*s |", w[s->ngroup + k], q->label[k]);
   putchar('\n');
-  print_hr(fs);
+  print_rule(w, n);
+
+  const size_t groups = agg_group_count(r);
+  char cell[CELL_MAX + 1];
+  for (size_t gi = 0; gi < groups; gi++) {
+    const AggGroup* g = agg_group(r, gi);
+    putchar('|');
+    for (int i = 0; i < s->ngroup; i++) {
+      // The key holds the group fields back to back
+      Field f = *q->group[i];
+      f.off = (uint16_t)agg_key_off(s, i);
+      cell[render_cell(&f, g->key, cell, true)] = 0;
+      printf(" %-*s |", w[i], cell);
+    }
+    for (int k = 0; k < s->nfuncs; k++) {
+      double v = 0;
+      if (!agg_value(s, g, k, &v))    snprintf(cell, sizeof cell, "-");
+      else if (s->func[k] == AGG_AVG) snprintf(cell, sizeof cell, "%.2f", v);
+      else                            snprintf(cell, sizeof cell, "%" PRIu64, g->acc[k]);
+      printf(" %*s |", w[s->ngroup + k], cell);
+    }
+    putchar('\n');
+  }
+  print_rule(w, n);
+  printf("%zu group(s)\n", groups);
+}
+
+// --- buffered output ----------------------------------------------------------
+void outbuf_init(OutBuf* ob, FILE* out) {
+  ob->out = out;
+  ob->len = 0;
+}
+
+void outbuf_flush(OutBuf* ob) {
+  if (ob->len) fwrite(ob->buf, 1, ob->len, ob->out);
+  ob->len = 0;
+}
+
+// Room for n more bytes (n <= OUTBUF_SIZE); returns where they go
+static inline char* ob_reserve(OutBuf* ob, size_t n) {
+  if (OUTBUF_SIZE - ob->len < n) outbuf_flush(ob);
+  return ob->buf + ob->len;
+}
+
+static inline void ob_char(OutBuf* ob, char c) {
+  *ob_reserve(ob, 1) = c;
+  ob->len++;
+}
+
+static inline void ob_str(OutBuf* ob, const char* s) { outbuf_put(ob, s, strlen(s)); }
+
+static inline void ob_fill(OutBuf* ob, char c, size_t n) {
+  while (n) {
+    const size_t k = n < 64 ? n : 64;
+    memset(ob_reserve(ob, k), c, k);
+    ob->len += k;
+    n -= k;
+  }
+}
+
+void outbuf_put(OutBuf* ob, const void* data, size_t n) {
+  if (n >= OUTBUF_SIZE) {
+    outbuf_flush(ob);
+    fwrite(data, 1, n, ob->out);
+    return;
+  }
+  memcpy(ob_reserve(ob, n), data, n);
+  ob->len += n;
+}
+
+void outbuf_u64(OutBuf* ob, uint64_t v) {
+  ob->len += fmt_u64(ob_reserve(ob, 20), v);
+}
+
+// --- row formats --------------------------------------------------------------
+int parse_format(const char* name, OutFormat* fmt) {
+  static const struct { const char* name; OutFormat fmt; } k_formats[] = {
+    { "table", OUT_TABLE }, { "csv", OUT_CSV }, { "tsv", OUT_TSV }, { "jsonl", OUT_JSONL }, { "raw", OUT_RAW },
+  };
+  if (!name || !fmt) return -1;
+  for (size_t i = 0; i < sizeof k_formats / sizeof k_formats[0]; i++)
+    if (strcmp(name, k_formats[i].name) == 0) { *fmt = k_formats[i].fmt; return 0; }
+  return -1;
 }
 
-void print_row_spec(uint32_t id, const FieldSpec* fs, const unsigned char rec[128]) {
-  printf("| %6u |", id);
-  char cell[256];
+static bool is_text(FieldType t) { return t == FT_STR || t == FT_HEX; }
+
+// CSV value: quoted (quotes doubled) when it holds a comma, a quote or a line break
+static void put_csv(OutBuf* ob, const char* s, size_t n) {
+  bool quote = false;
+  for (size_t i = 0; i < n && !quote; i++)
+    quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+  if (!quote) { outbuf_put(ob, s, n); return; }
+  char* p = ob_reserve(ob, 2 * n + 2);
+  char* w = p;
+  *w++ = '"';
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] == '"') *w++ = '"';
+    *w++ = s[i];
+  }
+  *w++ = '"';
+  ob->len += (size_t)(w - p);
+}
+
+static void put_tsv(OutBuf* ob, const char* s, size_t n) {
+  char* p = ob_reserve(ob, 2 * n);
+  char* w = p;
+  for (size_t i = 0; i < n; i++) {
+    switch (s[i]) {
+      case '\t': *w++ = '\\'; *w++ = 't';  break;
+      case '\n': *w++ = '\\'; *w++ = 'n';  break;
+      case '\r': *w++ = '\\'; *w++ = 'r';  break;
+      case '\\': *w++ = '\\'; *w++ = '\\'; break;
+      default:   *w++ = s[i];
+    }
+  }
+  ob->len += (size_t)(w - p);
+}
+
+// JSON string, quotes included; other bytes are copied as they are
+static void put_json(OutBuf* ob, const char* s, size_t n) {
+  char* p = ob_reserve(ob, 6 * n + 2);
+  char* w = p;
+  *w++ = '"';
+  for (size_t i = 0; i < n; i++) {
+    const unsigned char c = (unsigned char)s[i];
+    if (c == '"' || c == '\\') { *w++ = '\\'; *w++ = (char)c; }
+    else if (c == '\n') { *w++ = '\\'; *w++ = 'n'; }
+    else if (c == '\t') { *w++ = '\\'; *w++ = 't'; }
+    else if (c == '\r') { *w++ = '\\'; *w++ = 'r'; }
+    else if (c < 0x20) {
+      memcpy(w, "\\u00", 4); w += 4;
+      *w++ = k_hex[c >> 4];
+      *w++ = k_hex[c & 15u];
+    } else {
+      *w++ = (char)c;
+    }
+  }
+  *w++ = '"';
+  ob->len += (size_t)(w - p);
+}
+
+static void put_hr(OutBuf* ob, const FieldSpec* fs) {
+  ob_str(ob, "+--------+");
   for (int i = 0; i < fs->n; i++) {
-    render_field(&fs->f[i], rec, cell, sizeof cell);
-    printf(" %-*s |", fs->f[i].colw, cell);
+    ob_fill(ob, '-', fs->f[i].colw + 2u);
+    ob_char(ob, '+');
   }
-  putchar('\n');
+  ob_char(ob, '\n');
+}
+
+void format_header(OutBuf* ob, OutFormat fmt, const FieldSpec* fs) {
+  switch (fmt) {
+    case OUT_TABLE:
+      put_hr(ob, fs);
+      ob_str(ob, "| ID     |");
+      for (int i = 0; i < fs->n; i++) {
+        const size_t n = strlen(fs->f[i].name);
+        ob_char(ob, ' ');
+        outbuf_put(ob, fs->f[i].name, n);
+        ob_fill(ob, ' ', n < fs->f[i].colw ? fs->f[i].colw - n : 0);
+        ob_str(ob, " |");
+      }
+      ob_char(ob, '\n');
+      put_hr(ob, fs);
+      break;
+    case OUT_CSV:
+    case OUT_TSV:
+      ob_str(ob, "id");
+      for (int i = 0; i < fs->n; i++) {
+        ob_char(ob, fmt == OUT_CSV ? ',' : '\t');
+        if (fmt == OUT_CSV) put_csv(ob, fs->f[i].name, strlen(fs->f[i].name));
+        else                put_tsv(ob, fs->f[i].name, strlen(fs->f[i].name));
+      }
+      ob_char(ob, '\n');
+      break;
+    case OUT_JSONL:
+    case OUT_RAW:
+      break;
+  }
+}
+
+static void table_row(OutBuf* ob, uint64_t id, const FieldSpec* fs, const unsigned char rec[128]) {
+  // "| %6" PRIu64 " |", then " %-*s |" per field
+  char* p = ob_reserve(ob, 32);
+  char* w = p;
+  char digits[20];
+  const size_t nd = fmt_u64(digits, id);
+  *w++ = '|';
+  *w++ = ' ';
+  if (nd < 6) { memset(w, ' ', 6 - nd); w += 6 - nd; }
+  memcpy(w, digits, nd); w += nd;
+  *w++ = ' ';
+  *w++ = '|';
+  ob->len += (size_t)(w - p);
+
+  for (int i = 0; i < fs->n; i++) {
+    const Field* f = &fs->f[i];
+    p = ob_reserve(ob, CELL_MAX + f->colw + 3u);
+    w = p;
+    *w++ = ' ';
+    const size_t n = render_cell(f, rec, w, true);
+    w += n;
+    if (n < f->colw) { memset(w, ' ', f->colw - n); w += f->colw - n; }
+    *w++ = ' ';
+    *w++ = '|';
+    ob->len += (size_t)(w - p);
+  }
+  ob_char(ob, '\n');
+}
+
+void format_row(OutBuf* ob, OutFormat fmt, uint64_t id, const FieldSpec* fs, const unsigned char rec[128]) {
+  char cell[CELL_MAX];
+  switch (fmt) {
+    case OUT_TABLE:
+      table_row(ob, id, fs, rec);
+      break;
+    case OUT_CSV:
+    case OUT_TSV:
+      outbuf_u64(ob, id);
+      for (int i = 0; i < fs->n; i++) {
+        const size_t n = render_cell(&fs->f[i], rec, cell, false);
+        ob_char(ob, fmt == OUT_CSV ? ',' : '\t');
+        if (fmt == OUT_CSV) put_csv(ob, cell, n);
+        else                put_tsv(ob, cell, n);
+      }
+      ob_char(ob, '\n');
+      break;
+    case OUT_JSONL:
+      ob_str(ob, "{\"id\":");
+      outbuf_u64(ob, id);
+      for (int i = 0; i < fs->n; i++) {
+        const Field* f = &fs->f[i];
+        const size_t n = render_cell(f, rec, cell, false);
+        ob_char(ob, ',');
+        put_json(ob, f->name, strlen(f->name));
+        ob_char(ob, ':');
+        if (is_text(f->type))  put_json(ob, cell, n);
+        else if (n)            outbuf_put(ob, cell, n);
+        else                   ob_str(ob, "null");
+      }
+      ob_str(ob, "}\n");
+      break;
+    case OUT_RAW:
+      outbuf_put(ob, rec, 128);
+      break;
+  }
+}
+
+void format_footer(OutBuf* ob, OutFormat fmt, const FieldSpec* fs, size_t rows) {
+  if (fmt != OUT_TABLE) return;
+  put_hr(ob, fs);
+  outbuf_u64(ob, rows);
+  ob_str(ob, " row(s)\n");
+}
+
+void print_header_spec(const FieldSpec* fs) {
+  OutBuf ob;
+  outbuf_init(&ob, stdout);
+  format_header(&ob, OUT_TABLE, fs);
+  outbuf_flush(&ob);
+}
+
+void print_row_spec(uint64_t id, const FieldSpec* fs, const unsigned char rec[128]) {
+  OutBuf ob;
+  outbuf_init(&ob, stdout);
+  table_row(&ob, id, fs, rec);
+  outbuf_flush(&ob);
 }
 
 void print_footer_spec(const FieldSpec* fs, size_t rows) {
-  (void)fs;
-  print_hr(fs);
-  printf("%zu row(s)\n", rows);
+  OutBuf ob;
+  outbuf_init(&ob, stdout);
+  format_footer(&ob, OUT_TABLE, fs, rows);
+  outbuf_flush(&ob);
 }
 
-int scan_cb_listf(const void* rec, uint32_t id, void* ud) {
+int scan_cb_listf(const void* rec, uint64_t id, void* ud) {
   ListfCtx* ctx = (ListfCtx*)ud;
-  print_row_spec(id, ctx->fs, (const unsigned char*)rec);
+  if (ctx->out) format_row(ctx->out, ctx->fmt, id, ctx->fs, (const unsigned char*)rec);
+  else          print_row_spec(id, ctx->fs, (const unsigned char*)rec);
   (*ctx->counter)++;
   return 0;
 }
@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
+#include "predicate.h"
+#include "agg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,23 +30,90 @@ typedef struct {
   int    n;
 } FieldSpec;
 
-// Parse "name:off:len:type[, ...]" into FieldSpec.
+// Parse "name:off:len:type[, ...]" into FieldSpec. Every field must lie
+// inside the record (off + len <= TABLE_RECORD_SIZE).
 // Mutates its input: pass a writable buffer, not a string literal.
 int parse_spec(char* spec_in, FieldSpec* fs);
 
-// Pretty table helpers for 128-byte records
+// Encode a field value typed on the command line into its record bytes
+// (f->len bytes: NUL-padded string, 2*len hex digits, or a decimal integer
+// stored LE) at out, which holds cap bytes. Returns 0, or -1 if the text
+// does not fit the field or the field does not fit out.
+int encode_field_value(const Field* f, const char* text, unsigned char* out, size_t cap);
+
+// Compile a --where expression over the fields of a spec into a predicate
+// (terms are ANDed to what `pred` already holds). Terms are separated by
+// commas: name=v, name<v, name>v, name=lo..hi (inclusive), name^=prefix
+// (s fields only). Values are typed as for encode_field_value().
+// Mutates its input like parse_spec(). Returns 0, or -1 on a bad term.
+int parse_where(char* text, const FieldSpec* fs, TblPred* pred);
+
+// An aggregate query over the fields of a spec (see parse_agg)
+typedef struct {
+  AggSpec      spec;
+  const Field* group[AGG_MAX_GROUP];   // spec columns of the GROUP BY fields
+  char         label[AGG_MAX_FUNCS][48];
+} AggQuery;
+
+// Parse "func[,func...] [by name[,name...]]" where func is count, sum(name),
+// min(name), max(name) or avg(name), names being spec fields (integer ones
+// for everything but count and "by"). Leaves q->spec.where and .threads
+// unset. Mutates its input like parse_spec(). Returns 0, or -1.
+int parse_agg(char* text, const FieldSpec* fs, AggQuery* q);
+
+// Print the groups of an aggregate as a table, GROUP BY columns first
+void print_agg(const AggQuery* q, const AggResult* r);
+
+// ----- Buffered output -----
+// Rows are rendered straight into a large buffer that is written out with
+// one fwrite when it fills up (and on outbuf_flush), instead of one stdio
+// call per field. No allocation: the buffer lives in the struct.
+#define OUTBUF_SIZE (64 * 1024)
+
+typedef struct {
+  FILE*  out;
+  size_t len;               // buffered bytes
+  char   buf[OUTBUF_SIZE];
+} OutBuf;
+
+void outbuf_init(OutBuf* ob, FILE* out);
+void outbuf_flush(OutBuf* ob);
+void outbuf_put(OutBuf* ob, const void* data, size_t n);
+void outbuf_u64(OutBuf* ob, uint64_t v);   // decimal
+
+// ----- Row output formats for 128-byte records -----
+//   table  the boxed table (default); strings and hex are cut to the column
+//   csv    RFC 4180, a header line of field names, quoted when needed
+//   tsv    a header line; tab, CR, LF and backslash escaped as \t \r \n \\ inside values
+//   jsonl  one object per row: {"id":N,"name":"...","age":30}
+//   raw    the 128-byte records back to back, nothing else
+// Strings stop at the first NUL and drop trailing blanks in every text
+// format; csv, tsv and jsonl print them and hex fields in full.
+typedef enum { OUT_TABLE, OUT_CSV, OUT_TSV, OUT_JSONL, OUT_RAW } OutFormat;
+
+// "table", "csv", "tsv", "jsonl" or "raw". Returns 0, or -1.
+int parse_format(const char* name, OutFormat* fmt);
+
+void format_header(OutBuf* ob, OutFormat fmt, const FieldSpec* fs);
+void format_row(OutBuf* ob, OutFormat fmt, uint64_t id, const FieldSpec* fs, const unsigned char rec[128]);
+void format_footer(OutBuf* ob, OutFormat fmt, const FieldSpec* fs, size_t rows);
+
+// Pretty table helpers for 128-byte records (table format, on stdout)
 void print_header_spec(const FieldSpec* fs);
-void print_row_spec(uint32_t id, const FieldSpec* fs, const unsigned char rec[128]);
+void print_row_spec(uint64_t id, const FieldSpec* fs, const unsigned char rec[128]);
 void print_footer_spec(const FieldSpec* fs, size_t rows);
 
-// Scan callback + context for listf (to be used with tblmgr_scan)
+// Scan callback + context for listf (to be used with tblmgr_scan).
+// Without an OutBuf, rows go to print_row_spec().
 typedef struct {
   const FieldSpec* fs;
   size_t*          counter;
+  OutBuf*          out;
+  OutFormat        fmt;
 } ListfCtx;
 
-// Signature must match: int (*callback)(const void* record, uint32_t id, void* user_data)
-int scan_cb_listf(const void* rec, uint32_t id, void* ud);
+// Signature must match: int (*callback)(const void* record, uint64_t id, void* user_data)
+int scan_cb_listf(const void* rec, uint64_t id, void* ud);
 
 #ifdef __cplusplus
 }
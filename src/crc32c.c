@@ -0,0 +1,107 @@
+#include "crc32c.h"
+#include "endian_util.h"
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  include <nmmintrin.h>
+#  define CRC32C_HW_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#  include <arm_acle.h>
+#  define CRC32C_HW_ARM 1
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Table-driven software implementation (reflected polynomial 0x82F63B78),
+// eight bytes per step ("slicing-by-8")
+// ─────────────────────────────────────────────────────────────────────────────
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t       crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+static int            crc_hw;    // 1: the CPU has the CRC32 instruction
+
+/**
+ * @brief Build the lookup tables and probe the CPU, once per process.
+ */
+static void crc_init(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1u) ? (c >> 1) ^ CRC32C_POLY : (c >> 1);
+    crc_table[0][i] = c;
+  }
+  for (uint32_t i = 0; i < 256; i++)
+    for (int t = 1; t < 8; t++)
+      crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFFu];
+
+#if defined(CRC32C_HW_X86)
+  __builtin_cpu_init();
+  crc_hw = __builtin_cpu_supports("sse4.2");
+#elif defined(CRC32C_HW_ARM)
+  crc_hw = 1;
+#endif
+}
+
+/**
+ * @brief Software update of a pre-inverted checksum.
+ */
+static uint32_t crc_sw(uint32_t c, const uint8_t* p, size_t len) {
+  for (; len >= 8; p += 8, len -= 8) {
+    const uint32_t lo = read_le_u32(p) ^ c;
+    const uint32_t hi = read_le_u32(p + 4);
+    c = crc_table[7][lo & 0xFFu]         ^ crc_table[6][(lo >> 8) & 0xFFu] ^
+        crc_table[5][(lo >> 16) & 0xFFu] ^ crc_table[4][lo >> 24]          ^
+        crc_table[3][hi & 0xFFu]         ^ crc_table[2][(hi >> 8) & 0xFFu] ^
+        crc_table[1][(hi >> 16) & 0xFFu] ^ crc_table[0][hi >> 24];
+  }
+  while (len--)
+    c = crc_table[0][(c ^ *p++) & 0xFFu] ^ (c >> 8);
+  return c;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Hardware implementation (SSE4.2 crc32 on x86-64, ARMv8 CRC extension)
+// ─────────────────────────────────────────────────────────────────────────────
+#if defined(CRC32C_HW_X86)
+__attribute__((target("sse4.2")))
+static uint32_t crc_hw_update(uint32_t c, const uint8_t* p, size_t len) {
+  uint64_t c64 = c;
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t w;
+    memcpy(&w, p, sizeof w);
+    c64 = _mm_crc32_u64(c64, w);
+  }
+  c = (uint32_t)c64;
+  while (len--)
+    c = _mm_crc32_u8(c, *p++);
+  return c;
+}
+#elif defined(CRC32C_HW_ARM)
+static uint32_t crc_hw_update(uint32_t c, const uint8_t* p, size_t len) {
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t w;
+    memcpy(&w, p, sizeof w);
+    c = __crc32cd(c, w);
+  }
+  while (len--)
+    c = __crc32cb(c, *p++);
+  return c;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t len) {
+  pthread_once(&crc_once, crc_init);
+
+  const uint8_t* p = (const uint8_t*)data;
+#if defined(CRC32C_HW_X86) || defined(CRC32C_HW_ARM)
+  if (crc_hw)
+    return ~crc_hw_update(~crc, p, len);
+#endif
+  return ~crc_sw(~crc, p, len);
+}
+
+uint32_t crc32c_portable(uint32_t crc, const void* data, size_t len) {
+  pthread_once(&crc_once, crc_init);
+  return ~crc_sw(~crc, (const uint8_t*)data, len);
+}
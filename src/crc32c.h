@@ -0,0 +1,29 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Update a CRC-32C (Castagnoli) checksum with `len` bytes.
+ *
+ * Start with crc = 0; feed consecutive chunks by passing the previous result.
+ * Standard parameters (reflected, init/xorout 0xFFFFFFFF are handled here):
+ * crc32c(0, "123456789", 9) == 0xE3069283.
+ *
+ * @param crc  Previous checksum (0 for the first chunk).
+ * @param data Bytes to hash.
+ * @param len  Number of bytes.
+ * Uses the CPU's CRC32 instruction when it has one (SSE4.2 on x86-64,
+ * the ARMv8 CRC extension), a table-driven loop otherwise.
+ *
+ * @return The updated checksum.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief Same as crc32c(), always with the table-driven loop (tests).
+ */
+uint32_t crc32c_portable(uint32_t crc, const void* data, size_t len);
+
+#endif /* CRC32C_H */
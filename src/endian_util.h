@@ -25,6 +25,16 @@ static inline uint32_t read_le_u32(const uint8_t* p) {
        | ((uint32_t)p[3] << 24);
 }
 
+/**
+ * @brief Read a 64-bit unsigned integer stored in little-endian order.
+ * @param p Pointer to the first byte.
+ * @return The 64-bit integer in host byte order.
+ */
+static inline uint64_t read_le_u64(const uint8_t* p) {
+  return (uint64_t)read_le_u32(p)
+       | ((uint64_t)read_le_u32(p + 4) << 32);
+}
+
 /**
  * @brief Write a 16-bit unsigned integer to memory in little-endian order.
  * @param p Pointer to destination buffer (at least 2 bytes).
@@ -47,4 +57,14 @@ static inline void write_le_u32(uint8_t* p, uint32_t v) {
   p[3] = (uint8_t)((v >> 24) & 0xFFu);
 }
 
+/**
+ * @brief Write a 64-bit unsigned integer to memory in little-endian order.
+ * @param p Pointer to destination buffer (at least 8 bytes).
+ * @param v The 64-bit integer to write.
+ */
+static inline void write_le_u64(uint8_t* p, uint64_t v) {
+  write_le_u32(p, (uint32_t)v);
+  write_le_u32(p + 4, (uint32_t)(v >> 32));
+}
+
 #endif /* ENDIAN_UTIL_H */
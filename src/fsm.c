@@ -0,0 +1,112 @@
+#include "fsm.h"
+#include "table.h"
+#include "endian_util.h"
+#include <string.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static inline size_t max_entries(size_t page_size) {
+  size_t n = (page_size - FSM_HDR_SIZE) / 4u;
+  return n > UINT16_MAX ? UINT16_MAX : n;
+}
+
+static inline uint8_t* entry_ptr(void* page, uint16_t idx) {
+  return (uint8_t*)page + FSM_HDR_SIZE + (size_t)idx * 4u;
+}
+
+static inline const uint8_t* entry_ptr_c(const void* page, uint16_t idx) {
+  return (const uint8_t*)page + FSM_HDR_SIZE + (size_t)idx * 4u;
+}
+
+static inline void set_count(void* page, uint16_t v) {
+  write_le_u16((uint8_t*)page + FSM_HDR_COUNT_OFF, v);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+int fsm_init(void* page, size_t page_size) {
+  if (!page || page_size <= FSM_HDR_SIZE)
+    return TABLE_E_INVAL;
+
+  size_t cap = max_entries(page_size);
+  if (cap == 0)
+    return TABLE_E_LAYOUT;
+
+  memset(page, 0, page_size);
+  uint8_t* base = (uint8_t*)page;
+  write_le_u16(base + FSM_HDR_KIND_OFF, TABLE_PAGE_KIND_FSM);
+  write_le_u16(base + FSM_HDR_CAPACITY_OFF, (uint16_t)cap);
+  return TABLE_OK;
+}
+
+int fsm_validate(const void* page, size_t page_size) {
+  if (!page || page_size <= FSM_HDR_SIZE)
+    return TABLE_E_INVAL;
+
+  const uint8_t* base = (const uint8_t*)page;
+  if (read_le_u16(base + FSM_HDR_KIND_OFF) != TABLE_PAGE_KIND_FSM)
+    return TABLE_E_BADKIND;
+
+  uint16_t cap = fsm_get_capacity(page);
+  if (cap == 0 || cap != max_entries(page_size))
+    return TABLE_E_LAYOUT;
+
+  if (fsm_get_count(page) > cap)
+    return TABLE_E_LAYOUT;
+
+  return TABLE_OK;
+}
+
+int fsm_push(void* page, uint32_t page_no) {
+  if (!page || page_no == 0)
+    return TABLE_E_INVAL;
+
+  uint16_t count = fsm_get_count(page);
+  if (count >= fsm_get_capacity(page))
+    return TABLE_E_FULL;
+
+  write_le_u32(entry_ptr(page, count), page_no);
+  set_count(page, (uint16_t)(count + 1));
+  return TABLE_OK;
+}
+
+uint32_t fsm_top(const void* page) {
+  uint16_t count = fsm_get_count(page);
+  if (count == 0)
+    return 0;
+  return read_le_u32(entry_ptr_c(page, (uint16_t)(count - 1)));
+}
+
+void fsm_pop(void* page) {
+  uint16_t count = fsm_get_count(page);
+  if (count == 0)
+    return;
+  write_le_u32(entry_ptr(page, (uint16_t)(count - 1)), 0);
+  set_count(page, (uint16_t)(count - 1));
+}
+
+uint16_t fsm_get_count(const void* page) {
+  return read_le_u16((const uint8_t*)page + FSM_HDR_COUNT_OFF);
+}
+
+uint16_t fsm_get_capacity(const void* page) {
+  return read_le_u16((const uint8_t*)page + FSM_HDR_CAPACITY_OFF);
+}
+
+uint32_t fsm_get_next(const void* page) {
+  return read_le_u32((const uint8_t*)page + FSM_HDR_NEXT_OFF);
+}
+
+void fsm_set_next(void* page, uint32_t next) {
+  write_le_u32((uint8_t*)page + FSM_HDR_NEXT_OFF, next);
+}
+
+uint32_t fsm_get_tail(const void* page) {
+  return read_le_u32((const uint8_t*)page + FSM_HDR_TAIL_OFF);
+}
+
+void fsm_set_tail(void* page, uint32_t tail) {
+  write_le_u32((uint8_t*)page + FSM_HDR_TAIL_OFF, tail);
+}
@@ -0,0 +1,77 @@
+#ifndef FSM_H
+
+#define FSM_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Free-space map page (FSM)
+ * - Page type: TABLE_PAGE_KIND_FSM (0x0002), see table.h
+ * - One FSM stack per table, referenced by the root leaf (TABLE_HDR_FSM_PAGE_OFF).
+ * - Entries are leaf pages of the table that still have a free slot.
+ * - When the head page is full a new head is pushed in front of it (next).
+ * - The head page also records the current tail of the leaf chain.
+ * All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define FSM_HDR_SIZE                16
+
+/* Header offsets (bytes) */
+#define FSM_HDR_KIND_OFF            0   /* u16 */
+#define FSM_HDR_CAPACITY_OFF        2   /* u16: max entries */
+#define FSM_HDR_COUNT_OFF           4   /* u16: entries in use */
+#define FSM_HDR_RESERVED_OFF        6   /* u16 */
+#define FSM_HDR_NEXT_OFF            8   /* u32: next FSM page (0 = none) */
+#define FSM_HDR_TAIL_OFF            12  /* u32: last leaf of the table chain */
+
+/* Entries: u32 page numbers starting at FSM_HDR_SIZE, stack order (top = last). */
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Initialize an empty FSM page in memory.
+ * @param[in,out] page      Page buffer of page_size bytes.
+ * @param[in]     page_size Page size in bytes (capacity is derived from it).
+ * @return TABLE_OK, or TABLE_E_INVAL / TABLE_E_LAYOUT on bad arguments.
+ */
+int      fsm_init(void* page, size_t page_size);
+
+/**
+ * @brief Validate an FSM page: kind, capacity against page_size, count bounds.
+ * @return TABLE_OK, TABLE_E_INVAL, TABLE_E_BADKIND or TABLE_E_LAYOUT.
+ */
+int      fsm_validate(const void* page, size_t page_size);
+
+/**
+ * @brief Push a page number on top of the stack.
+ * @return TABLE_OK, or TABLE_E_FULL if the page has no room left.
+ */
+int      fsm_push(void* page, uint32_t page_no);
+
+/**
+ * @brief Return the top entry without removing it (0 if empty).
+ */
+uint32_t fsm_top(const void* page);
+
+/**
+ * @brief Remove the top entry (no-op on an empty page).
+ */
+void     fsm_pop(void* page);
+
+/**
+ * @brief Header getters / setters.
+ */
+uint16_t fsm_get_count(const void* page);
+uint16_t fsm_get_capacity(const void* page);
+uint32_t fsm_get_next(const void* page);
+void     fsm_set_next(void* page, uint32_t next);
+uint32_t fsm_get_tail(const void* page);
+void     fsm_set_tail(void* page, uint32_t tail);
+
+#endif // FSM_H
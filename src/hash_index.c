@@ -0,0 +1,630 @@
+#include "hash_index.h"
+#include "btree_index.h"
+#include "table.h"
+#include "packed.h"
+#include "pax.h"
+#include "table_manager.h"
+#include "crc32c.h"
+#include "endian_util.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Validate a table leaf that records are written to in place: the
+ *        root of a fixed-size table, by rows (TABLE_LEAF) or columns (PAX).
+ */
+static int root_validate(const void* page, size_t page_size) {
+  return tbl_get_kind(page) == TABLE_PAGE_KIND_PAX ? pax_validate(page, page_size)
+                                                   : tbl_validate(page, page_size);
+}
+
+static inline uint32_t key_hash(const IndexKey* k, const void* key_bytes) {
+  return crc32c(0, key_bytes, k->len);
+}
+
+/**
+ * @brief Bucket of hash h: low `level` bits, one more bit for split buckets.
+ */
+static inline uint32_t bucket_of(const uint8_t* meta, uint32_t h) {
+  const uint32_t level = meta[HIDX_META_LEVEL_OFF];
+  const uint32_t split = read_le_u32(meta + HIDX_META_SPLIT_OFF);
+  uint32_t b = h & ((1u << level) - 1u);
+  if (b < split)
+    b = h & ((2u << level) - 1u);
+  return b;
+}
+
+static inline uint8_t* dir_slot(uint8_t* meta, uint32_t b) {
+  return meta + HIDX_META_SIZE + (size_t)b * 4u;
+}
+
+static inline uint32_t dir_get(const uint8_t* meta, uint32_t b) {
+  return read_le_u32(meta + HIDX_META_SIZE + (size_t)b * 4u);
+}
+
+/**
+ * @brief Bytes per bucket entry in this file: the id width follows the
+ *        file's format version (see TABLE_ID_SIZE).
+ */
+static inline size_t entry_size(const Pager* p) {
+  return HIDX_BKT_ENTRY_SIZE(pager_format_version(p));
+}
+
+static inline uint8_t* entry_ptr(uint8_t* bkt, size_t esz, uint16_t i) {
+  return bkt + HIDX_BUCKET_HDR_SIZE + (size_t)i * esz;
+}
+
+static inline const uint8_t* entry_ptr_c(const uint8_t* bkt, size_t esz, uint16_t i) {
+  return bkt + HIDX_BUCKET_HDR_SIZE + (size_t)i * esz;
+}
+
+static inline uint64_t entry_id(const uint8_t* e, size_t esz) {
+  return esz == 12 ? read_le_u64(e + 4) : read_le_u32(e + 4);
+}
+
+static inline void entry_set(uint8_t* e, size_t esz, uint32_t h, uint64_t id) {
+  write_le_u32(e, h);
+  if (esz == 12) write_le_u64(e + 4, id);
+  else           write_le_u32(e + 4, (uint32_t)id);
+}
+
+static inline uint16_t bkt_count(const uint8_t* bkt) {
+  return read_le_u16(bkt + HIDX_BKT_COUNT_OFF);
+}
+
+static inline uint16_t bkt_capacity(const Pager* p) {
+  size_t n = (pager_page_size(p) - HIDX_BUCKET_HDR_SIZE) / entry_size(p);
+  return n > UINT16_MAX ? UINT16_MAX : (uint16_t)n;
+}
+
+static void meta_read_key(const uint8_t* meta, IndexKey* k) {
+  memset(k, 0, sizeof *k);
+  k->off  = read_le_u16(meta + HIDX_META_KEY_OFF_OFF);
+  k->len  = read_le_u16(meta + HIDX_META_KEY_LEN_OFF);
+  k->type = meta[HIDX_META_KEY_TYPE_OFF];
+  memcpy(k->name, meta + HIDX_META_NAME_OFF, INDEX_NAME_MAX - 1);
+}
+
+/**
+ * @brief Light header check done by every operation (hidx_validate goes deeper).
+ */
+static int meta_check(const uint8_t* meta, size_t page_size) {
+  if (read_le_u16(meta + HIDX_META_KIND_OFF) != TABLE_PAGE_KIND_HASH_META)
+    return TABLE_E_BADKIND;
+
+  IndexKey k;
+  meta_read_key(meta, &k);
+  if (!index_key_valid(&k))
+    return TABLE_E_LAYOUT;
+
+  const uint32_t dircap  = read_le_u32(meta + HIDX_META_DIRCAP_OFF);
+  const uint32_t buckets = read_le_u32(meta + HIDX_META_BUCKETS_OFF);
+  const uint32_t level   = meta[HIDX_META_LEVEL_OFF];
+  const uint32_t split   = read_le_u32(meta + HIDX_META_SPLIT_OFF);
+  if (dircap != (page_size - HIDX_META_SIZE) / 4u || level > 30)
+    return TABLE_E_LAYOUT;
+  if (split >= (1u << level) || buckets != (1u << level) + split || buckets > dircap)
+    return TABLE_E_LAYOUT;
+  return TABLE_OK;
+}
+
+/**
+ * @brief Allocate and initialize an empty bucket page for bucket number b.
+ */
+static int bucket_new(Pager* p, uint32_t b, uint32_t* out_page) {
+  uint32_t no;
+  if (pager_alloc_page(p, &no) != PAGER_OK) return TABLE_E_INVAL;
+
+  uint8_t* bkt = NULL;
+  if (pager_pin_zero(p, no, (void**)&bkt) != PAGER_OK) return TABLE_E_INVAL;
+  write_le_u16(bkt + HIDX_BKT_KIND_OFF, TABLE_PAGE_KIND_HASH_BUCKET);
+  write_le_u16(bkt + HIDX_BKT_CAPACITY_OFF, bkt_capacity(p));
+  write_le_u32(bkt + HIDX_BKT_NO_OFF, b);
+  pager_unpin(p, bkt, true);
+
+  *out_page = no;
+  return TABLE_OK;
+}
+
+static bool bucket_ok(const Pager* p, const uint8_t* bkt, uint32_t b) {
+  return read_le_u16(bkt + HIDX_BKT_KIND_OFF) == TABLE_PAGE_KIND_HASH_BUCKET &&
+         read_le_u16(bkt + HIDX_BKT_CAPACITY_OFF) == bkt_capacity(p) &&
+         bkt_count(bkt) <= bkt_capacity(p) &&
+         read_le_u32(bkt + HIDX_BKT_NO_OFF) == b;
+}
+
+/**
+ * @brief Pin a bucket page of bucket b for writing and check its header.
+ */
+static int bucket_pin(Pager* p, uint32_t page_no, uint32_t b, uint8_t** out) {
+  if (page_no == 0 || page_no >= pager_page_count(p)) return TABLE_E_LAYOUT;
+  if (pager_pin_mut(p, page_no, (void**)out) != PAGER_OK) return TABLE_E_INVAL;
+  if (!bucket_ok(p, *out, b)) {
+    pager_unpin(p, *out, false);
+    *out = NULL;
+    return TABLE_E_LAYOUT;
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief bucket_pin() for lookups: a shared pin, served from the snapshot
+ *        of a thread bound to one.
+ */
+static int bucket_pin_c(Pager* p, uint32_t page_no, uint32_t b, const uint8_t** out) {
+  if (page_no == 0 || page_no >= pager_page_count(p)) return TABLE_E_LAYOUT;
+  if (pager_pin(p, page_no, (const void**)out) != PAGER_OK) return TABLE_E_INVAL;
+  if (!bucket_ok(p, *out, b)) {
+    pager_unpin(p, *out, false);
+    *out = NULL;
+    return TABLE_E_LAYOUT;
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief Store (h, id) in the first page of bucket b's chain with room,
+ *        chaining an overflow page when the whole chain is full.
+ */
+static int chain_add(Pager* p, uint32_t first_page, uint32_t b, uint32_t h, uint64_t id) {
+  const size_t esz = entry_size(p);
+  if (esz == 8 && id > UINT32_MAX) return TABLE_E_FULL;   // version 1 file
+  uint32_t page = first_page;
+  uint32_t hops = 0;
+
+  while (true) {
+    if (++hops > pager_page_count(p)) return TABLE_E_LAYOUT;
+
+    uint8_t* bkt = NULL;
+    int rc = bucket_pin(p, page, b, &bkt);
+    if (rc != TABLE_OK) return rc;
+
+    const uint16_t count = bkt_count(bkt);
+    if (count < read_le_u16(bkt + HIDX_BKT_CAPACITY_OFF)) {
+      entry_set(entry_ptr(bkt, esz, count), esz, h, id);
+      write_le_u16(bkt + HIDX_BKT_COUNT_OFF, (uint16_t)(count + 1));
+      pager_unpin(p, bkt, true);
+      return TABLE_OK;
+    }
+
+    uint32_t next = read_le_u32(bkt + HIDX_BKT_NEXT_OFF);
+    if (next == 0) {
+      rc = bucket_new(p, b, &next);
+      if (rc != TABLE_OK) { pager_unpin(p, bkt, false); return rc; }
+      write_le_u32(bkt + HIDX_BKT_NEXT_OFF, next);
+      pager_unpin(p, bkt, true);
+    } else {
+      pager_unpin(p, bkt, false);
+    }
+    page = next;
+  }
+}
+
+/**
+ * @brief Split the bucket under the split pointer (linear hashing step).
+ *
+ * Entries whose next hash bit is set move to the new bucket
+ * s + 2^level; the others are compacted at the front of the old chain.
+ * Emptied overflow pages stay linked as spare room for the bucket.
+ */
+static int split_one(Pager* p, uint8_t* meta) {
+  const uint32_t level = meta[HIDX_META_LEVEL_OFF];
+  const uint32_t s     = read_le_u32(meta + HIDX_META_SPLIT_OFF);
+  const uint32_t nb    = s + (1u << level);
+  const uint32_t mask  = (2u << level) - 1u;
+  const size_t   esz   = entry_size(p);
+
+  uint32_t new_page;
+  int rc = bucket_new(p, nb, &new_page);
+  if (rc != TABLE_OK) return rc;
+
+  // (a) Move entries out, compacting the kept ones in place
+  uint32_t wr_page = dir_get(meta, s);
+  uint8_t* wr = NULL;
+  uint16_t wr_n = 0;
+  if ((rc = bucket_pin(p, wr_page, s, &wr)) != TABLE_OK) return rc;
+
+  uint32_t rd_page = wr_page;
+  uint32_t hops = 0;
+  while (rd_page != 0) {
+    if (++hops > pager_page_count(p)) { rc = TABLE_E_LAYOUT; break; }
+
+    uint8_t* rd = NULL;
+    if ((rc = bucket_pin(p, rd_page, s, &rd)) != TABLE_OK) break;
+
+    const uint16_t n = bkt_count(rd);
+    for (uint16_t i = 0; i < n && rc == TABLE_OK; i++) {
+      const uint32_t h  = read_le_u32(entry_ptr_c(rd, esz, i));
+      const uint64_t id = entry_id(entry_ptr_c(rd, esz, i), esz);
+
+      if ((h & mask) == nb) {
+        rc = chain_add(p, new_page, nb, h, id);
+        continue;
+      }
+
+      // Keep: the write cursor never passes the read cursor
+      if (wr_n == read_le_u16(wr + HIDX_BKT_CAPACITY_OFF)) {
+        write_le_u16(wr + HIDX_BKT_COUNT_OFF, wr_n);
+        const uint32_t next = read_le_u32(wr + HIDX_BKT_NEXT_OFF);
+        pager_unpin(p, wr, true);
+        wr = NULL;
+        if ((rc = bucket_pin(p, next, s, &wr)) != TABLE_OK) break;
+        wr_page = next;
+        wr_n = 0;
+      }
+      entry_set(entry_ptr(wr, esz, wr_n), esz, h, id);
+      wr_n++;
+    }
+
+    const uint32_t next = read_le_u32(rd + HIDX_BKT_NEXT_OFF);
+    // Pages behind the write cursor have been fully consumed
+    if (rd_page != wr_page)
+      write_le_u16(rd + HIDX_BKT_COUNT_OFF, 0);
+    pager_unpin(p, rd, true);
+    if (rc != TABLE_OK) break;
+    rd_page = next;
+  }
+
+  if (wr) {
+    write_le_u16(wr + HIDX_BKT_COUNT_OFF, wr_n);
+    pager_unpin(p, wr, true);
+  }
+  if (rc != TABLE_OK) return rc;
+
+  // (b) Publish the new bucket and advance the split pointer
+  write_le_u32(dir_slot(meta, nb), new_page);
+  write_le_u32(meta + HIDX_META_BUCKETS_OFF, nb + 1);
+  if (s + 1 == (1u << level)) {
+    meta[HIDX_META_LEVEL_OFF] = (uint8_t)(level + 1);
+    write_le_u32(meta + HIDX_META_SPLIT_OFF, 0);
+  } else {
+    write_le_u32(meta + HIDX_META_SPLIT_OFF, s + 1);
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief hidx_insert on an already pinned header page.
+ */
+static int insert_pinned(Pager* p, uint8_t* meta, const void* rec, uint64_t id) {
+  IndexKey k;
+  meta_read_key(meta, &k);
+
+  const uint32_t h = key_hash(&k, index_key_ptr(&k, rec));
+  const uint32_t b = bucket_of(meta, h);
+  int rc = chain_add(p, dir_get(meta, b), b, h, id);
+  if (rc != TABLE_OK) return rc;
+
+  const uint32_t entries = read_le_u32(meta + HIDX_META_ENTRIES_OFF) + 1;
+  write_le_u32(meta + HIDX_META_ENTRIES_OFF, entries);
+
+  // Grow by one bucket once the average bucket is 3/4 full
+  const uint64_t buckets = read_le_u32(meta + HIDX_META_BUCKETS_OFF);
+  const uint64_t cap = bkt_capacity(p);
+  if ((uint64_t)entries * 4u > buckets * cap * 3u &&
+      buckets < read_le_u32(meta + HIDX_META_DIRCAP_OFF))
+    return split_one(p, meta);
+  return TABLE_OK;
+}
+
+static int pin_meta(Pager* p, uint32_t meta_page, uint8_t** out) {
+  if (!p || meta_page == 0 || meta_page >= pager_page_count(p)) return TABLE_E_INVAL;
+  if (pager_pin_mut(p, meta_page, (void**)out) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = meta_check(*out, pager_page_size(p));
+  if (rc != TABLE_OK) { pager_unpin(p, *out, false); *out = NULL; }
+  return rc;
+}
+
+/**
+ * @brief pin_meta() for lookups and validation (see bucket_pin_c).
+ */
+static int pin_meta_c(Pager* p, uint32_t meta_page, const uint8_t** out) {
+  if (!p || meta_page == 0 || meta_page >= pager_page_count(p)) return TABLE_E_INVAL;
+  if (pager_pin(p, meta_page, (const void**)out) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = meta_check(*out, pager_page_size(p));
+  if (rc != TABLE_OK) { pager_unpin(p, *out, false); *out = NULL; }
+  return rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief hidx_create() inside its write section.
+ */
+static int create_index(Pager* p, uint32_t root_page_no, const IndexKey* key, uint32_t* out_meta_page) {
+  if (!p || !index_key_valid(key) || root_page_no == 0 || root_page_no >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  // Names are unique across index kinds
+  uint32_t existing;
+  int rc = hidx_open(p, root_page_no, key->name, &existing);
+  if (rc == TABLE_E_NOTFOUND)
+    rc = bidx_open(p, root_page_no, key->name, &existing);
+  if (rc == TABLE_OK) return TABLE_E_INVAL;
+  if (rc != TABLE_E_NOTFOUND) return rc;
+
+  uint8_t* root = NULL;
+  if (pager_pin_mut(p, root_page_no, (void**)&root) != PAGER_OK) return TABLE_E_INVAL;
+  rc = root_validate(root, pager_page_size(p));
+  const uint32_t owner = tbl_get_root_page(root);
+  if (rc == TABLE_OK && owner != 0 && owner != root_page_no) rc = TABLE_E_INVAL;
+  if (rc != TABLE_OK) { pager_unpin(p, root, false); return rc; }
+
+  // (a) Header page + first bucket
+  uint32_t meta_no, bucket0;
+  if (pager_alloc_page(p, &meta_no) != PAGER_OK) { pager_unpin(p, root, false); return TABLE_E_INVAL; }
+  if ((rc = bucket_new(p, 0, &bucket0)) != TABLE_OK) { pager_unpin(p, root, false); return rc; }
+
+  uint8_t* meta = NULL;
+  if (pager_pin_zero(p, meta_no, (void**)&meta) != PAGER_OK) { pager_unpin(p, root, false); return TABLE_E_INVAL; }
+  write_le_u16(meta + HIDX_META_KIND_OFF, TABLE_PAGE_KIND_HASH_META);
+  write_le_u16(meta + HIDX_META_KEY_OFF_OFF, key->off);
+  write_le_u16(meta + HIDX_META_KEY_LEN_OFF, key->len);
+  meta[HIDX_META_KEY_TYPE_OFF] = key->type;
+  meta[HIDX_META_LEVEL_OFF] = 0;
+  write_le_u32(meta + HIDX_META_TABLE_OFF, root_page_no);
+  write_le_u32(meta + HIDX_META_BUCKETS_OFF, 1);
+  write_le_u32(meta + HIDX_META_DIRCAP_OFF, (uint32_t)((pager_page_size(p) - HIDX_META_SIZE) / 4u));
+  memcpy(meta + HIDX_META_NAME_OFF, key->name, strlen(key->name));
+  write_le_u32(dir_slot(meta, 0), bucket0);
+
+  // (b) Index the existing records, stamping leaf ownership on the way
+  // (update / delete find the table's indexes through it)
+  uint32_t page = root_page_no;
+  uint32_t hops = 0;
+  uint8_t* unpacked = NULL;
+  size_t unpacked_cap = 0;
+  while (page != 0 && rc == TABLE_OK) {
+    if (page >= pager_page_count(p) || ++hops > pager_page_count(p)) { rc = TABLE_E_LAYOUT; break; }
+
+    uint8_t* leaf = NULL;
+    if (pager_pin_mut(p, page, (void**)&leaf) != PAGER_OK) { rc = TABLE_E_INVAL; break; }
+    // Packed (packed.h) and PAX (pax.h) leaves are read from their decoded image
+    const uint16_t kind = tbl_get_kind(leaf);
+    const bool packed = kind == TABLE_PAGE_KIND_PACKED, pax = kind == TABLE_PAGE_KIND_PAX;
+    rc = packed ? pkl_validate(leaf, pager_page_size(p)) : root_validate(leaf, pager_page_size(p));
+    if (rc == TABLE_OK && packed) rc = pkl_decode_buf(leaf, &unpacked, &unpacked_cap);
+    if (rc == TABLE_OK && pax)    rc = pax_decode_buf(leaf, &unpacked, &unpacked_cap);
+    if (rc != TABLE_OK) { pager_unpin(p, leaf, false); break; }
+    const uint8_t* recs = packed || pax ? unpacked : leaf;
+
+    tbl_set_root_page(leaf, root_page_no);
+    TblSlotIter it;
+    tbl_slot_iter_init(&it, recs);
+    int i;
+    while (rc == TABLE_OK && (i = tbl_slot_iter_next(&it)) >= 0)
+      rc = insert_pinned(p, meta, tbl_slot_ptr_c(recs, i), TABLE_ID(page, i));
+    const uint32_t next = tbl_get_next_page(leaf);
+    pager_unpin(p, leaf, true);
+    page = next;
+  }
+  free(unpacked);
+
+  // (c) Link the index in front of the table's index list
+  if (rc == TABLE_OK) {
+    write_le_u32(meta + HIDX_META_NEXT_OFF, tbl_get_index_page(root));
+    tbl_set_index_page(root, meta_no);
+  }
+  pager_unpin(p, meta, true);
+  pager_unpin(p, root, true);
+  if (rc != TABLE_OK) return rc;
+
+  if (out_meta_page) *out_meta_page = meta_no;
+  return TABLE_OK;
+}
+
+int hidx_create(Pager* p, uint32_t root_page_no, const IndexKey* key, uint32_t* out_meta_page) {
+  // One write section for the build: snapshots see the table without it or with all of it
+  if (pager_write_begin(p) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = create_index(p, root_page_no, key, out_meta_page);
+  pager_write_end(p);
+  return rc;
+}
+
+int hidx_open(Pager* p, uint32_t root_page_no, const char* name, uint32_t* out_meta_page) {
+  if (!p || !name || root_page_no == 0 || root_page_no >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  const uint8_t* root = NULL;
+  if (pager_pin(p, root_page_no, (const void**)&root) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = root_validate(root, pager_page_size(p));
+  uint32_t idx = tbl_get_index_page(root);
+  pager_unpin(p, root, false);
+  if (rc != TABLE_OK) return rc;
+
+  uint32_t hops = 0;
+  while (idx != 0) {
+    if (idx >= pager_page_count(p) || ++hops > pager_page_count(p)) return TABLE_E_LAYOUT;
+
+    const uint8_t* meta = NULL;
+    if (pager_pin(p, idx, (const void**)&meta) != PAGER_OK) return TABLE_E_INVAL;
+    const bool match = read_le_u16(meta + HIDX_META_KIND_OFF) == TABLE_PAGE_KIND_HASH_META &&
+                       strncmp((const char*)meta + HIDX_META_NAME_OFF, name, INDEX_NAME_MAX) == 0;
+    const uint32_t next = read_le_u32(meta + TABLE_INDEX_NEXT_OFF);
+    pager_unpin(p, meta, false);
+
+    if (match) {
+      if (out_meta_page) *out_meta_page = idx;
+      return TABLE_OK;
+    }
+    idx = next;
+  }
+  return TABLE_E_NOTFOUND;
+}
+
+int hidx_get_key(Pager* p, uint32_t meta_page, IndexKey* out_key) {
+  if (!out_key) return TABLE_E_INVAL;
+
+  const uint8_t* meta = NULL;
+  int rc = pin_meta_c(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+  meta_read_key(meta, out_key);
+  pager_unpin(p, meta, false);
+  return TABLE_OK;
+}
+
+int hidx_insert(Pager* p, uint32_t meta_page, const void* rec, uint64_t id) {
+  if (!rec) return TABLE_E_INVAL;
+
+  uint8_t* meta = NULL;
+  int rc = pin_meta(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  rc = insert_pinned(p, meta, rec, id);
+  pager_unpin(p, meta, true);
+  return rc;
+}
+
+int hidx_remove(Pager* p, uint32_t meta_page, const void* rec, uint64_t id) {
+  if (!rec) return TABLE_E_INVAL;
+
+  uint8_t* meta = NULL;
+  int rc = pin_meta(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  IndexKey k;
+  meta_read_key(meta, &k);
+  const uint32_t h = key_hash(&k, index_key_ptr(&k, rec));
+  const uint32_t b = bucket_of(meta, h);
+  const size_t esz = entry_size(p);
+
+  uint32_t page = dir_get(meta, b);
+  uint32_t hops = 0;
+  rc = TABLE_E_NOTFOUND;
+  while (page != 0) {
+    if (++hops > pager_page_count(p)) { rc = TABLE_E_LAYOUT; break; }
+
+    uint8_t* bkt = NULL;
+    int brc = bucket_pin(p, page, b, &bkt);
+    if (brc != TABLE_OK) { rc = brc; break; }
+
+    const uint16_t n = bkt_count(bkt);
+    for (uint16_t i = 0; i < n; i++) {
+      const uint8_t* e = entry_ptr_c(bkt, esz, i);
+      if (read_le_u32(e) != h || entry_id(e, esz) != id)
+        continue;
+      // Order inside a bucket is irrelevant: move the last entry into the hole
+      memcpy(entry_ptr(bkt, esz, i), entry_ptr(bkt, esz, (uint16_t)(n - 1)), esz);
+      memset(entry_ptr(bkt, esz, (uint16_t)(n - 1)), 0, esz);
+      write_le_u16(bkt + HIDX_BKT_COUNT_OFF, (uint16_t)(n - 1));
+      rc = TABLE_OK;
+      break;
+    }
+
+    const uint32_t next = read_le_u32(bkt + HIDX_BKT_NEXT_OFF);
+    pager_unpin(p, bkt, rc == TABLE_OK);
+    if (rc == TABLE_OK) break;
+    page = next;
+  }
+
+  if (rc == TABLE_OK)
+    write_le_u32(meta + HIDX_META_ENTRIES_OFF, read_le_u32(meta + HIDX_META_ENTRIES_OFF) - 1);
+  pager_unpin(p, meta, rc == TABLE_OK);
+  return rc;
+}
+
+int hidx_update(Pager* p, uint32_t meta_page, const void* old_rec, const void* new_rec, uint64_t id) {
+  if (!old_rec || !new_rec) return TABLE_E_INVAL;
+
+  IndexKey k;
+  int rc = hidx_get_key(p, meta_page, &k);
+  if (rc != TABLE_OK) return rc;
+  if (memcmp(index_key_ptr(&k, old_rec), index_key_ptr(&k, new_rec), k.len) == 0)
+    return TABLE_OK;
+
+  rc = hidx_remove(p, meta_page, old_rec, id);
+  if (rc != TABLE_OK) return rc;
+  return hidx_insert(p, meta_page, new_rec, id);
+}
+
+int hidx_find(Pager* p, uint32_t meta_page, const void* key_bytes,
+              int (*callback)(const void* record, uint64_t record_id, void* user_data),
+              void* user_data) {
+  if (!key_bytes || !callback) return TABLE_E_INVAL;
+
+  const uint8_t* meta = NULL;
+  int rc = pin_meta_c(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  IndexKey k;
+  meta_read_key(meta, &k);
+  const uint32_t h = key_hash(&k, key_bytes);
+  const uint32_t b = bucket_of(meta, h);
+  uint32_t page = dir_get(meta, b);
+  pager_unpin(p, meta, false);
+
+  const size_t esz = entry_size(p);
+  uint64_t hits[(PAGER_MAX_PAGE_SIZE - HIDX_BUCKET_HDR_SIZE) / HIDX_BKT_ENTRY_SIZE(1)];
+  uint8_t rec[TABLE_RECORD_SIZE];
+  uint32_t hops = 0;
+
+  while (page != 0) {
+    if (++hops > pager_page_count(p)) return TABLE_E_LAYOUT;
+
+    const uint8_t* bkt = NULL;
+    if ((rc = bucket_pin_c(p, page, b, &bkt)) != TABLE_OK) return rc;
+
+    // Collect the hash hits first: confirming them reads other pages
+    size_t nhits = 0;
+    const uint16_t n = bkt_count(bkt);
+    for (uint16_t i = 0; i < n && nhits < sizeof hits / sizeof hits[0]; i++)
+      if (read_le_u32(entry_ptr_c(bkt, esz, i)) == h)
+        hits[nhits++] = entry_id(entry_ptr_c(bkt, esz, i), esz);
+    const uint32_t next = read_le_u32(bkt + HIDX_BKT_NEXT_OFF);
+    pager_unpin(p, bkt, false);
+
+    for (size_t i = 0; i < nhits; i++) {
+      if (tblmgr_get(p, hits[i], rec) != TABLE_OK) return TABLE_E_LAYOUT;
+      if (memcmp(index_key_ptr(&k, rec), key_bytes, k.len) != 0)
+        continue; // hash collision
+      int cb_rc = callback(rec, hits[i], user_data);
+      if (cb_rc != 0) return cb_rc;
+    }
+    page = next;
+  }
+  return TABLE_OK;
+}
+
+int hidx_validate(Pager* p, uint32_t meta_page) {
+  const uint8_t* meta = NULL;
+  int rc = pin_meta_c(p, meta_page, &meta);
+  if (rc != TABLE_OK) return rc;
+
+  const uint32_t buckets = read_le_u32(meta + HIDX_META_BUCKETS_OFF);
+  const size_t esz = entry_size(p);
+  uint64_t total = 0;
+
+  for (uint32_t b = 0; b < buckets && rc == TABLE_OK; b++) {
+    uint32_t page = dir_get(meta, b);
+    uint32_t hops = 0;
+    if (page == 0) { rc = TABLE_E_LAYOUT; break; }
+
+    while (page != 0 && rc == TABLE_OK) {
+      if (++hops > pager_page_count(p)) { rc = TABLE_E_LAYOUT; break; }
+
+      const uint8_t* bkt = NULL;
+      if ((rc = bucket_pin_c(p, page, b, &bkt)) != TABLE_OK) break;
+
+      const uint16_t n = bkt_count(bkt);
+      for (uint16_t i = 0; i < n; i++)
+        if (bucket_of(meta, read_le_u32(entry_ptr_c(bkt, esz, i))) != b) { rc = TABLE_E_LAYOUT; break; }
+      total += n;
+
+      const uint32_t next = read_le_u32(bkt + HIDX_BKT_NEXT_OFF);
+      pager_unpin(p, bkt, false);
+      page = next;
+    }
+  }
+
+  if (rc == TABLE_OK && total != read_le_u32(meta + HIDX_META_ENTRIES_OFF))
+    rc = TABLE_E_LAYOUT;
+  pager_unpin(p, meta, false);
+  return rc;
+}
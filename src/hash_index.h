@@ -0,0 +1,118 @@
+#ifndef HASH_INDEX_H
+
+#define HASH_INDEX_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include "pager.h"
+#include "index_key.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Secondary hash index (linear hashing)
+ *
+ * Header page: TABLE_PAGE_KIND_HASH_META (0x0003), one per index, linked into
+ * the table's index list (TABLE_HDR_INDEX_PAGE_OFF / TABLE_INDEX_NEXT_OFF).
+ * It holds the key description and a directory of bucket pages. Buckets
+ * split one at a time (split pointer) once the average bucket is 3/4 full,
+ * so a lookup reads the header, one bucket page (plus rare overflow pages)
+ * and the matching records.
+ *
+ * Bucket page: TABLE_PAGE_KIND_HASH_BUCKET (0x0004), entries are
+ * (hash u32, record id) pairs, the id taking TABLE_ID_SIZE bytes (u64, or
+ * u32 in a version 1 file); overflow pages are chained via `next`.
+ * The key bytes are not copied: a lookup confirms each hash hit against the
+ * record itself. All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define HIDX_META_SIZE              64
+
+/* Header page offsets (bytes) */
+#define HIDX_META_KIND_OFF          0   /* u16 */
+#define HIDX_META_KEY_OFF_OFF       2   /* u16: key offset in the record */
+#define HIDX_META_KEY_LEN_OFF       4   /* u16: key length */
+#define HIDX_META_KEY_TYPE_OFF      6   /* u8 : INDEX_KEY_* */
+#define HIDX_META_LEVEL_OFF         7   /* u8 : linear hashing level */
+#define HIDX_META_NEXT_OFF          8   /* u32: next index of the table (TABLE_INDEX_NEXT_OFF) */
+#define HIDX_META_TABLE_OFF         12  /* u32: root page of the indexed table */
+#define HIDX_META_SPLIT_OFF         16  /* u32: next bucket to split */
+#define HIDX_META_BUCKETS_OFF       20  /* u32: buckets in use = 2^level + split */
+#define HIDX_META_ENTRIES_OFF       24  /* u32: indexed records */
+#define HIDX_META_DIRCAP_OFF        28  /* u32: directory capacity */
+#define HIDX_META_NAME_OFF          32  /* char[32]: index (field) name */
+/* Directory: u32 bucket page numbers from HIDX_META_SIZE */
+
+#define HIDX_BUCKET_HDR_SIZE        16
+
+/* Bucket page offsets (bytes) */
+#define HIDX_BKT_KIND_OFF           0   /* u16 */
+#define HIDX_BKT_CAPACITY_OFF       2   /* u16: max entries */
+#define HIDX_BKT_COUNT_OFF          4   /* u16: entries in use */
+#define HIDX_BKT_NEXT_OFF           8   /* u32: overflow page (0 = none) */
+#define HIDX_BKT_NO_OFF             12  /* u32: bucket number */
+#define HIDX_BKT_ENTRY_SIZE(version) (4u + TABLE_ID_SIZE(version))  /* hash u32 + record id */
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Create a hash index on `key` for the table rooted at root_page_no.
+ *
+ * Allocates the header page and the first bucket, indexes every record
+ * already in the table, then links the index into the table's index list so
+ * that tblmgr_insert / tblmgr_update / tblmgr_delete keep it up to date.
+ *
+ * @param p             Pager handle (read/write).
+ * @param root_page_no  Root leaf of the table.
+ * @param key           Key description; its name must be unique per table.
+ * @param out_meta_page Optional: receives the index header page.
+ * @return TABLE_OK, TABLE_E_INVAL (bad key, duplicate name, not a table root)
+ *         or another TABLE_E_* code.
+ */
+int hidx_create(Pager* p, uint32_t root_page_no, const IndexKey* key, uint32_t* out_meta_page);
+
+/**
+ * @brief Find the hash index called `name` on a table.
+ * @return TABLE_OK, or TABLE_E_NOTFOUND if the table has no such index.
+ */
+int hidx_open(Pager* p, uint32_t root_page_no, const char* name, uint32_t* out_meta_page);
+
+/**
+ * @brief Read the key description of an index.
+ */
+int hidx_get_key(Pager* p, uint32_t meta_page, IndexKey* out_key);
+
+/**
+ * @brief Add / remove the entry of record `id` (key taken from `rec`).
+ * hidx_remove returns TABLE_E_NOTFOUND if the entry is missing.
+ */
+int hidx_insert(Pager* p, uint32_t meta_page, const void* rec, uint64_t id);
+int hidx_remove(Pager* p, uint32_t meta_page, const void* rec, uint64_t id);
+
+/**
+ * @brief Re-key record `id` after an update (no-op when the key is unchanged).
+ */
+int hidx_update(Pager* p, uint32_t meta_page, const void* old_rec, const void* new_rec, uint64_t id);
+
+/**
+ * @brief Visit every record whose key equals key_bytes (key.len bytes).
+ *
+ * The callback has the tblmgr_scan() signature; a non-zero return stops the
+ * lookup and is returned. It must not modify the indexed table.
+ *
+ * @return TABLE_OK, the callback's value, or TABLE_E_LAYOUT if an entry
+ *         points at a missing record.
+ */
+int hidx_find(Pager* p, uint32_t meta_page, const void* key_bytes,
+              int (*callback)(const void* record, uint64_t record_id, void* user_data),
+              void* user_data);
+
+/**
+ * @brief Check an index: header, directory, bucket chains and entry count.
+ */
+int hidx_validate(Pager* p, uint32_t meta_page);
+
+#endif // HASH_INDEX_H
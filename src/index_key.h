@@ -0,0 +1,82 @@
+#ifndef INDEX_KEY_H
+#define INDEX_KEY_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "table.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Index key description
+ * A key is the byte range [off, off+len) of a 128-byte record, described with
+ * the same off:len:type vocabulary as a FieldSpec column (cli_format.h).
+ * Type codes are stored on disk and use the FieldType numbering.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define INDEX_NAME_MAX   32   /* bytes, NUL-padded on disk */
+
+enum {
+  INDEX_KEY_STR = 0,   /* NUL-padded string (FT_STR) */
+  INDEX_KEY_HEX = 1,   /* raw bytes (FT_HEX) */
+  INDEX_KEY_U8  = 2,
+  INDEX_KEY_U16 = 3,   /* little-endian */
+  INDEX_KEY_U32 = 4    /* little-endian */
+};
+
+typedef struct IndexKey {
+  char     name[INDEX_NAME_MAX];
+  uint16_t off;
+  uint16_t len;
+  uint8_t  type;
+} IndexKey;
+
+/**
+ * @brief Check that a key fits in a record and that its length matches its type.
+ */
+static inline bool index_key_valid(const IndexKey* k) {
+  if (!k || k->len == 0 || (uint32_t)k->off + k->len > TABLE_RECORD_SIZE)
+    return false;
+  if (k->name[0] == '\0' || memchr(k->name, '\0', sizeof k->name) == NULL)
+    return false;
+  switch (k->type) {
+    case INDEX_KEY_STR:
+    case INDEX_KEY_HEX: return true;
+    case INDEX_KEY_U8:  return k->len == 1;
+    case INDEX_KEY_U16: return k->len == 2;
+    case INDEX_KEY_U32: return k->len == 4;
+    default:            return false;
+  }
+}
+
+/**
+ * @brief Compare two keys of the same description (memcmp order for
+ *        strings and raw bytes, numeric order for u8/u16/u32).
+ * @return <0, 0 or >0.
+ */
+static inline int index_key_cmp(const IndexKey* k, const uint8_t* a, const uint8_t* b) {
+  switch (k->type) {
+    case INDEX_KEY_U16: {
+      uint16_t x = (uint16_t)(a[0] | (a[1] << 8)), y = (uint16_t)(b[0] | (b[1] << 8));
+      return (x > y) - (x < y);
+    }
+    case INDEX_KEY_U32: {
+      uint32_t x = (uint32_t)a[0] | ((uint32_t)a[1] << 8) | ((uint32_t)a[2] << 16) | ((uint32_t)a[3] << 24);
+      uint32_t y = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+      return (x > y) - (x < y);
+    }
+    default:
+      return memcmp(a, b, k->len);
+  }
+}
+
+/**
+ * @brief Address of the key bytes inside a record.
+ */
+static inline const uint8_t* index_key_ptr(const IndexKey* k, const void* rec) {
+  return (const uint8_t*)rec + k->off;
+}
+
+#endif // INDEX_KEY_H
@@ -1,13 +1,26 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "cli_format.h"
 #include "pager.h"
 #include "table_manager.h"
 #include "table.h"
+#include "slotted.h"
+#include "packed.h"
+#include "pax.h"
+#include "endian_util.h"
+#include "catalog.h"
+#include "hash_index.h"
+#include "btree_index.h"
+#include "stats.h"
+#include "arena.h"
 
 static void die(const char* msg) { fprintf(stderr, "%s\n", msg); exit(2); }
 
@@ -20,123 +33,589 @@ static int read_file(const char* path, uint8_t* buf, size_t cap) {
   return 0;
 }
 
-static void cmd_create(Pager* p, uint32_t root) {
+// create <root> [page_size]: the page size only applies to a new file (see main)
+static int cmd_create(Pager* p, uint32_t root, uint32_t page_size) {
+  if (page_size != 0 && page_size != pager_page_size(p)) {
+    fprintf(stderr, "file already uses %zu-byte pages\n", pager_page_size(p));
+    return 1;
+  }
   int rc = tblmgr_create(p, root);
-  if (rc != TABLE_OK) { fprintf(stderr, "create failed rc=%d\n", rc); exit(1); }
+  if (rc != TABLE_OK) { fprintf(stderr, "create failed rc=%d\n", rc); return 1; }
   printf("created table at page %u\n", root);
+  return 0;
+}
+
+// vcreate <root> [page_size]: a table of variable-length records
+static int cmd_vcreate(Pager* p, uint32_t root, uint32_t page_size) {
+  if (page_size != 0 && page_size != pager_page_size(p)) {
+    fprintf(stderr, "file already uses %zu-byte pages\n", pager_page_size(p));
+    return 1;
+  }
+  int rc = tblmgr_create_var(p, root);
+  if (rc != TABLE_OK) { fprintf(stderr, "vcreate failed rc=%d\n", rc); return 1; }
+  printf("created variable-length table at page %u\n", root);
+  return 0;
+}
+
+// pcreate <root> <spec> [page_size]: a table stored by columns (PAX leaves),
+// one column per spec field; the bytes around the fields make columns too
+static int cmd_pcreate(Pager* p, uint32_t root, const char* spec_str, uint32_t page_size) {
+  if (page_size != 0 && page_size != pager_page_size(p)) {
+    fprintf(stderr, "file already uses %zu-byte pages\n", pager_page_size(p));
+    return 1;
+  }
+  char buf[512]; strncpy(buf, spec_str, sizeof buf - 1); buf[sizeof buf - 1] = 0;
+  FieldSpec fs;
+  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); return 2; }
+
+  PaxLayout layout;
+  pax_layout_init(&layout);
+  for (int i = 0; i < fs.n; i++)
+    if (pax_layout_add(&layout, fs.f[i].off, fs.f[i].len) != TABLE_OK) { fprintf(stderr, "bad spec (column %s)\n", fs.f[i].name); return 2; }
+
+  int rc = tblmgr_create_pax(p, root, &layout);
+  if (rc != TABLE_OK) { fprintf(stderr, "pcreate failed rc=%d\n", rc); return 1; }
+  printf("created PAX table at page %u (%u columns)\n", root, layout.n);
+  return 0;
 }
 
-static void cmd_insert(Pager* p, uint32_t root, const char* file128) {
+static int cmd_insert(Pager* p, uint32_t root, const char* file128) {
   uint8_t rec[128];
-  if (read_file(file128, rec, sizeof rec) != 0) exit(1);
-  uint32_t id = 0;
+  if (read_file(file128, rec, sizeof rec) != 0) return 1;
+  uint64_t id = 0;
   int rc = tblmgr_insert(p, root, rec, &id);
-  if (rc != TABLE_OK) { fprintf(stderr, "insert failed rc=%d\n", rc); exit(1); }
-  printf("%u\n", id);
+  if (rc != TABLE_OK) { fprintf(stderr, "insert failed rc=%d\n", rc); return 1; }
+  printf("%" PRIu64 "\n", id);
+  return 0;
+}
+
+// load <root> <file>: stream concatenated 128-byte records through the batch API
+static int cmd_load(Pager* p, uint32_t root, const char* path) {
+  enum { LOAD_CHUNK = 1024 };
+  FILE* f = fopen(path, "rb");
+  if (!f) { perror("fopen"); return 1; }
+
+  uint8_t* chunk = malloc((size_t)LOAD_CHUNK * TABLE_RECORD_SIZE);
+  uint64_t* ids = malloc(LOAD_CHUNK * sizeof *ids);
+  if (!chunk || !ids) { free(chunk); free(ids); fclose(f); fprintf(stderr, "out of memory\n"); return 1; }
+
+  size_t total = 0;
+  while (true) {
+    size_t n = fread(chunk, 1, (size_t)LOAD_CHUNK * TABLE_RECORD_SIZE, f);
+    if (n % TABLE_RECORD_SIZE != 0) {
+      fprintf(stderr, "trailing %zu bytes: file is not a multiple of %d\n",
+              n % TABLE_RECORD_SIZE, TABLE_RECORD_SIZE);
+      free(chunk); free(ids); fclose(f); return 1;
+    }
+    size_t recs = n / TABLE_RECORD_SIZE;
+    if (recs == 0) break;
+
+    // Ids are never 0: the ones left at 0 are the rows a failure kept out
+    memset(ids, 0, recs * sizeof *ids);
+    int rc = tblmgr_insert_batch(p, root, chunk, recs, ids);
+    if (rc != TABLE_OK) {
+      while (recs > 0 && ids[recs - 1] == 0) recs--;
+      fprintf(stderr, "load failed after %zu row(s) rc=%d\n", total + recs, rc);
+      free(chunk); free(ids); fclose(f); return 1;
+    }
+    total += recs;
+    if (recs < LOAD_CHUNK) break;
+  }
+
+  free(chunk);
+  free(ids);
+  fclose(f);
+  printf("loaded %zu row(s)\n", total);
+  return 0;
 }
 
-static void cmd_get(Pager* p, uint32_t id) {
+static int cmd_get(Pager* p, uint64_t id) {
   uint8_t rec[128];
   int rc = tblmgr_get(p, id, rec);
-  if (rc != TABLE_OK) { fprintf(stderr, "get failed rc=%d\n", rc); exit(1); }
+  if (rc != TABLE_OK) { fprintf(stderr, "get failed rc=%d\n", rc); return 1; }
   // dump as hex
   for (size_t i = 0; i < sizeof rec; i++) {
     printf("%02x", rec[i]);
     if ((i+1)%16==0) printf("\n"); else printf(" ");
   }
+  return 0;
+}
+
+// vinsert <root> <file>: the whole file is one record
+static int cmd_vinsert(Pager* p, uint32_t root, const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) { perror("fopen"); return 1; }
+  size_t cap = 4096, len = 0;
+  uint8_t* rec = malloc(cap);
+  while (rec) {
+    len += fread(rec + len, 1, cap - len, f);
+    if (len < cap) break;
+    uint8_t* grown = realloc(rec, cap * 2);
+    if (!grown) { free(rec); rec = NULL; break; }
+    rec = grown;
+    cap *= 2;
+  }
+  fclose(f);
+  if (!rec) { fprintf(stderr, "out of memory\n"); return 1; }
+
+  uint64_t id = 0;
+  int rc = tblmgr_insert_var(p, root, rec, len, &id);
+  free(rec);
+  if (rc != TABLE_OK) { fprintf(stderr, "vinsert failed rc=%d\n", rc); return 1; }
+  printf("%" PRIu64 "\n", id);
+  return 0;
+}
+
+static void print_hex(const void* data, size_t n) {
+  const unsigned char* p = (const unsigned char*)data;
+  for (size_t i = 0; i < n; i++) {
+    if ((i % 16) == 0) printf("%08zx  ", i);
+    printf("%02x%s", p[i], ((i+1)%8==0) ? "  " : " ");
+    if ((i % 16) == 15) printf("\n");
+  }
+  if ((n % 16) != 0) printf("\n");
 }
 
-static void cmd_update(Pager* p, uint32_t id, const char* file128) {
+// vget <id>: record of any length, as a hex dump
+static int cmd_vget(Pager* p, uint64_t id) {
+  size_t len = 0;
+  int rc = tblmgr_get_var(p, id, NULL, 0, &len);
+  if (rc != TABLE_OK && rc != TABLE_E_FULL) { fprintf(stderr, "vget failed rc=%d\n", rc); return 1; }
+  uint8_t* rec = malloc(len ? len : 1);
+  if (!rec) { fprintf(stderr, "out of memory\n"); return 1; }
+  rc = tblmgr_get_var(p, id, rec, len, &len);
+  if (rc != TABLE_OK) { free(rec); fprintf(stderr, "vget failed rc=%d\n", rc); return 1; }
+  printf("Row %" PRIu64 " (%zu bytes):\n", id, len);
+  print_hex(rec, len);
+  free(rec);
+  return 0;
+}
+
+static int cmd_update(Pager* p, uint64_t id, const char* file128) {
   uint8_t rec[128];
-  if (read_file(file128, rec, sizeof rec) != 0) exit(1);
+  if (read_file(file128, rec, sizeof rec) != 0) return 1;
   int rc = tblmgr_update(p, id, rec);
-  if (rc != TABLE_OK) { fprintf(stderr, "update failed rc=%d\n", rc); exit(1); }
+  if (rc != TABLE_OK) { fprintf(stderr, "update failed rc=%d\n", rc); return 1; }
   printf("ok\n");
+  return 0;
 }
 
-static void cmd_delete(Pager* p, uint32_t id) {
+static int cmd_delete(Pager* p, uint64_t id) {
   int rc = tblmgr_delete(p, id);
-  if (rc != TABLE_OK) { fprintf(stderr, "delete failed rc=%d\n", rc); exit(1); }
+  if (rc != TABLE_OK) { fprintf(stderr, "delete failed rc=%d\n", rc); return 1; }
   printf("ok\n");
+  return 0;
 }
 
-static int scan_cb(const void* rec, uint32_t id, void* ud) {
+// One id per line into an OutBuf
+static int scan_cb(const void* rec, uint64_t id, void* ud) {
   (void)rec;
-  FILE* out = (FILE*)ud;
-  fprintf(out, "%u\n", id);
+  OutBuf* out = (OutBuf*)ud;
+  outbuf_u64(out, id);
+  outbuf_put(out, "\n", 1);
   return 0;
 }
 
+static int cmd_scan(Pager* p, uint32_t root) {
+  OutBuf out;
+  outbuf_init(&out, stdout);
+  int rc = tblmgr_scan(p, root, scan_cb, &out);
+  outbuf_flush(&out);
+  if (rc != TABLE_OK) { fprintf(stderr, "scan failed rc=%d\n", rc); return 1; }
+  return 0;
+}
 
-static void cmd_scan(Pager* p, uint32_t root) {
-  int rc = tblmgr_scan(p, root, scan_cb, stdout);
-  if (rc != TABLE_OK) { fprintf(stderr, "scan failed rc=%d\n", rc); exit(1); }
+// vscan <root>: "<id> <length>" per record
+static int vscan_cb(const void* rec, size_t len, uint64_t id, void* ud) {
+  (void)rec;
+  fprintf((FILE*)ud, "%" PRIu64 " %zu\n", id, len);
+  return 0;
+}
+
+static int cmd_vscan(Pager* p, uint32_t root) {
+  int rc = tblmgr_scan_var(p, root, vscan_cb, stdout);
+  if (rc != TABLE_OK) { fprintf(stderr, "vscan failed rc=%d\n", rc); return 1; }
+  return 0;
 }
 
-static void cmd_validate(Pager* p, uint32_t root) {
+static int cmd_validate(Pager* p, uint32_t root) {
   int rc = tblmgr_validate_all(p, root);
-  if (rc != TABLE_OK) { fprintf(stderr, "validate failed rc=%d\n", rc); exit(1); }
+  if (rc != TABLE_OK) { fprintf(stderr, "validate failed rc=%d\n", rc); return 1; }
   printf("ok\n");
+  return 0;
+}
+
+static int cmd_count(Pager* p, uint32_t root) {
+  uint64_t rows = 0;
+  int rc = tblmgr_count(p, root, &rows);
+  if (rc != TABLE_OK) { fprintf(stderr, "count failed rc=%d\n", rc); return 1; }
+  printf("%" PRIu64 "\n", rows);
+  return 0;
+}
+
+// stats [reset]: engine counters of this process (see stats.h), then the
+// latency histograms that have samples (timing is on in the shell and
+// with --stats)
+static void print_stats(FILE* out) {
+  Stats st;
+  stats_read(&st);
+  if (!stats_enabled()) fprintf(out, "(built with STATS=0: no counters)\n");
+  for (int c = 0; c < STAT_COUNTERS; c++)
+    fprintf(out, "%-18s %" PRIu64 "\n", stats_counter_name((StatCounter)c), st.counters[c]);
+
+  const uint64_t hits = st.counters[STAT_CACHE_HITS], misses = st.counters[STAT_CACHE_MISSES];
+  if (hits + misses > 0)
+    fprintf(out, "%-18s %.2f%%\n", "cache_hit_rate", 100.0 * (double)hits / (double)(hits + misses));
+  if (st.counters[STAT_INSERTS] > 0)
+    fprintf(out, "%-18s %.2f\n", "pages_per_insert",
+            (double)st.counters[STAT_INSERT_PAGES] / (double)st.counters[STAT_INSERTS]);
+
+  for (int h = 0; h < STAT_HISTS; h++) {
+    const StatsHistogram* hg = &st.hists[h];
+    if (hg->count == 0) continue;
+    fprintf(out, "%-18s count=%" PRIu64 " avg_ns=%" PRIu64 " p50_ns<%" PRIu64 " p99_ns<%" PRIu64
+            " max_ns<%" PRIu64 "\n", stats_hist_name((StatHist)h), hg->count, hg->total_ns / hg->count,
+            stats_quantile(hg, 0.5), stats_quantile(hg, 0.99), stats_quantile(hg, 1.0));
+  }
+}
+
+static int cmd_stats(const char* arg) {
+  if (arg && strcmp(arg, "reset") != 0) {
+    fprintf(stderr, "unknown stats argument '%s'\n", arg);
+    return 2;
+  }
+  print_stats(stdout);
+  if (arg) stats_reset();
+  return 0;
+}
+
+// vacuum <root> [--compact|--pack[=<fill%>]]: with --compact or --pack, one
+// "moved <old> -> <new>" line per record that changed id, then the totals
+static void vacuum_remap_cb(uint64_t old_id, uint64_t new_id, void* ud) {
+  (void)ud;
+  printf("moved %" PRIu64 " -> %" PRIu64 "\n", old_id, new_id);
+}
+
+static int cmd_vacuum(Pager* p, uint32_t root, const char* mode) {
+  TblVacuum opts = { .mode = TBLMGR_VACUUM_STABLE, .remap = vacuum_remap_cb };
+  if (mode && strcmp(mode, "--compact") == 0) {
+    opts.mode = TBLMGR_VACUUM_COMPACT;
+  } else if (mode && (strcmp(mode, "--pack") == 0 || strncmp(mode, "--pack=", 7) == 0)) {
+    opts.mode = TBLMGR_VACUUM_PACK;
+    if (mode[6] == '=') {
+      char* end = NULL;
+      const unsigned long fill = strtoul(mode + 7, &end, 10);
+      if (end == mode + 7 || *end != 0 || fill < 1 || fill > 100) {
+        fprintf(stderr, "bad fill '%s' (1..100)\n", mode + 7);
+        return 2;
+      }
+      opts.pack_fill = (unsigned)fill;
+    }
+  } else if (mode) {
+    fprintf(stderr, "unknown vacuum mode '%s'\n", mode);
+    return 2;
+  }
+  TblVacuumStats st;
+  int rc = tblmgr_vacuum(p, root, &opts, &st);
+  if (rc != TABLE_OK) { fprintf(stderr, "vacuum failed rc=%d\n", rc); return 1; }
+  printf("records_moved=%u leaves_freed=%u leaves_packed=%u pages_released=%u free_pages=%u\n",
+         st.records_moved, st.leaves_freed, st.leaves_packed, st.pages_released, pager_free_count(p));
+  return 0;
+}
+
+// tables: one line per catalog entry
+static int tables_cb(const CatEntry* e, void* ud) {
+  (void)ud;
+  printf("root=%u leaves=%u rows=%" PRIu64 " tail=%u\n",
+         e->root, e->leaves, e->rows, e->tail);
+  return 0;
+}
+
+static int cmd_tables(Pager* p) {
+  int rc = cat_foreach(p, tables_cb, NULL);
+  if (rc != TABLE_OK) { fprintf(stderr, "tables failed rc=%d\n", rc); return 1; }
+  return 0;
 }
 
-// getf <id> <spec>
-static void cmd_getf(Pager* p, uint32_t id, const char* spec_str) {
+// getf <id> <spec> [--format=<fmt>]
+static int cmd_getf(Pager* p, uint64_t id, const char* spec_str, OutFormat fmt) {
   unsigned char rec[128];
-  if (tblmgr_get(p, id, rec) != TABLE_OK) { fprintf(stderr, "get %u failed\n", id); exit(1); }
+  if (tblmgr_get(p, id, rec) != TABLE_OK) { fprintf(stderr, "get %" PRIu64 " failed\n", id); return 1; }
 
   char buf[512]; strncpy(buf, spec_str, sizeof buf - 1); buf[sizeof buf - 1] = 0;
   FieldSpec fs;
-  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); exit(2); }
+  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); return 2; }
 
-  print_header_spec(&fs);
-  print_row_spec(id, &fs, rec);
-  print_footer_spec(&fs, 1);
+  OutBuf out;
+  outbuf_init(&out, stdout);
+  format_header(&out, fmt, &fs);
+  format_row(&out, fmt, id, &fs, rec);
+  format_footer(&out, fmt, &fs, 1);
+  outbuf_flush(&out);
+  return 0;
 }
 
-// listf <root> <spec>
-static void cmd_listf(Pager* p, uint32_t root, const char* spec_str) {
+// Compile the --where expressions of a command over its spec (ANDed)
+static int compile_where(const FieldSpec* fs, char** where, int nwhere, TblPred* pred) {
+  pred_init(pred);
+  for (int i = 0; i < nwhere; i++) {
+    char wbuf[512]; strncpy(wbuf, where[i], sizeof wbuf - 1); wbuf[sizeof wbuf - 1] = 0;
+    if (parse_where(wbuf, fs, pred) != 0) { fprintf(stderr, "bad --where: %s\n", where[i]); return 2; }
+  }
+  return 0;
+}
+
+// listf <root> <spec> [--where <expr>]... [--format=<fmt>]: the terms of
+// every --where are ANDed and tested on the raw records before any of them
+// is formatted; rows are rendered into one buffer, flushed as it fills. A
+// PAX table only assembles the columns of the spec
+static int cmd_listf(Pager* p, uint32_t root, const char* spec_str, char** where, int nwhere, OutFormat fmt) {
   char buf[512]; strncpy(buf, spec_str, sizeof buf - 1); buf[sizeof buf - 1] = 0;
   FieldSpec fs;
-  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); exit(2); }
+  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); return 2; }
+
+  TblPred pred;
+  if (compile_where(&fs, where, nwhere, &pred) != 0) return 2;
 
-  print_header_spec(&fs);
+  OutBuf out;
+  outbuf_init(&out, stdout);
+  format_header(&out, fmt, &fs);
   size_t n = 0;
-  ListfCtx ctx = { .fs = &fs, .counter = &n };
-  int rc = tblmgr_scan(p, root, scan_cb_listf, &ctx);
-  if (rc != TABLE_OK) { fprintf(stderr, "scan failed rc=%d\n", rc); exit(1); }
-  print_footer_spec(&fs, n);
+  ListfCtx ctx = { .fs = &fs, .counter = &n, .out = &out, .fmt = fmt };
+  TblFields fields = { { 0, 0 } };
+  for (int i = 0; i < fs.n; i++) tblmgr_fields_add(&fields, fs.f[i].off, fs.f[i].len);
+  int rc = tblmgr_scan_fields(p, root, nwhere ? &pred : NULL, &fields, scan_cb_listf, &ctx);
+  if (rc == TABLE_OK) format_footer(&out, fmt, &fs, n);
+  outbuf_flush(&out);
+  if (rc != TABLE_OK) { fprintf(stderr, "scan failed rc=%d\n", rc); return 1; }
+  return 0;
+}
+
+// agg <root> <spec> <expr> [--where <expr>]... [--threads <n>]
+static Arena agg_arena = ARENA_INIT;   // results of one command at a time
+
+static int cmd_agg(Pager* p, uint32_t root, const char* spec_str, const char* expr,
+                   char** where, int nwhere, unsigned threads) {
+  char buf[512]; strncpy(buf, spec_str, sizeof buf - 1); buf[sizeof buf - 1] = 0;
+  FieldSpec fs;
+  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); return 2; }
+
+  char ebuf[512]; strncpy(ebuf, expr, sizeof ebuf - 1); ebuf[sizeof ebuf - 1] = 0;
+  AggQuery q;
+  if (parse_agg(ebuf, &fs, &q) != 0) { fprintf(stderr, "bad aggregate: %s\n", expr); return 2; }
+  TblPred pred;
+  if (compile_where(&fs, where, nwhere, &pred) != 0) return 2;
+  q.spec.where = nwhere ? &pred : NULL;
+  q.spec.threads = threads;
+
+  // The result lives in agg_arena until printed: a shell session running
+  // the same query again allocates nothing
+  q.spec.arena = &agg_arena;
+  AggResult* res = NULL;
+  int rc = agg_run(p, root, &q.spec, &res);
+  if (rc == TABLE_OK) print_agg(&q, res);
+  arena_reset(&agg_arena);
+  if (rc != TABLE_OK) { fprintf(stderr, "agg failed rc=%d\n", rc); return 1; }
+  return 0;
+}
+
+// export-columnar <root> <spec> <dir> [--where <expr>]...: a column-per-file
+// snapshot. <dir>/<name>.col holds the raw bytes of one spec field, len
+// bytes per row, <dir>/_ids.col the record ids (u64 LE), both in scan order
+typedef struct {
+  const FieldSpec* fs;
+  FILE*            col[16];
+  FILE*            ids;
+  size_t           rows;
+} ExportCtx;
+
+static int export_cb(const void* rec, uint64_t id, void* ud) {
+  ExportCtx* x = (ExportCtx*)ud;
+  const unsigned char* r = (const unsigned char*)rec;
+  uint8_t le[8];
+  write_le_u64(le, id);
+  if (fwrite(le, 1, sizeof le, x->ids) != sizeof le) return 1;
+  for (int i = 0; i < x->fs->n; i++) {
+    const Field* f = &x->fs->f[i];
+    if (fwrite(r + f->off, 1, f->len, x->col[i]) != f->len) return 1;
+  }
+  x->rows++;
+  return 0;
+}
+
+static FILE* export_open(const char* dir, const char* name) {
+  char path[4096];
+  if (snprintf(path, sizeof path, "%s/%s.col", dir, name) >= (int)sizeof path) return NULL;
+  FILE* f = fopen(path, "wb");
+  if (!f) perror(path);
+  return f;
 }
 
+static int cmd_export_columnar(Pager* p, uint32_t root, const char* spec_str, const char* dir,
+                               char** where, int nwhere) {
+  char buf[512]; strncpy(buf, spec_str, sizeof buf - 1); buf[sizeof buf - 1] = 0;
+  FieldSpec fs;
+  if (parse_spec(buf, &fs) != 0) { fprintf(stderr, "bad spec\n"); return 2; }
+  for (int i = 0; i < fs.n; i++)
+    for (int j = 0; j < i; j++)
+      if (strcmp(fs.f[i].name, fs.f[j].name) == 0) { fprintf(stderr, "duplicate column %s\n", fs.f[i].name); return 2; }
+  TblPred pred;
+  if (compile_where(&fs, where, nwhere, &pred) != 0) return 2;
+  if (mkdir(dir, 0777) != 0 && errno != EEXIST) { perror(dir); return 1; }
+
+  ExportCtx x = { .fs = &fs };
+  TblFields fields = { { 0, 0 } };
+  int rc = (x.ids = export_open(dir, "_ids")) ? TABLE_OK : 1;
+  for (int i = 0; i < fs.n && rc == TABLE_OK; i++) {
+    tblmgr_fields_add(&fields, fs.f[i].off, fs.f[i].len);
+    if (!(x.col[i] = export_open(dir, fs.f[i].name))) rc = 1;
+  }
+  if (rc == TABLE_OK)
+    rc = tblmgr_scan_fields(p, root, nwhere ? &pred : NULL, &fields, export_cb, &x);
+
+  int close_failed = x.ids && fclose(x.ids) != 0;
+  for (int i = 0; i < fs.n; i++)
+    if (x.col[i] && fclose(x.col[i]) != 0) close_failed = 1;
+  if (rc == 1 || close_failed) { fprintf(stderr, "export failed: write error\n"); return 1; }
+  if (rc != TABLE_OK) { fprintf(stderr, "export failed rc=%d\n", rc); return 1; }
+  printf("exported %zu rows, %d columns to %s\n", x.rows, fs.n, dir);
+  return 0;
+}
+
+// index <root> <name:off:len:type> [hash|btree]: build an index on one field
+static int cmd_index(Pager* p, uint32_t root, const char* spec_str, const char* kind) {
+  const int btree = kind && strcmp(kind, "btree") == 0;
+  if (kind && !btree && strcmp(kind, "hash") != 0) { fprintf(stderr, "index kind must be hash or btree\n"); return 2; }
+
+  char buf[512]; strncpy(buf, spec_str, sizeof buf - 1); buf[sizeof buf - 1] = 0;
+  FieldSpec fs;
+  if (parse_spec(buf, &fs) != 0 || fs.n != 1) { fprintf(stderr, "bad spec (expected name:off:len:type)\n"); return 2; }
+
+  IndexKey key = {0};
+  memcpy(key.name, fs.f[0].name, sizeof key.name - 1);
+  key.off  = fs.f[0].off;
+  key.len  = fs.f[0].len;
+  key.type = (uint8_t)fs.f[0].type;
+
+  uint32_t meta = 0;
+  int rc = btree ? bidx_create(p, root, &key, &meta) : hidx_create(p, root, &key, &meta);
+  if (rc != TABLE_OK) { fprintf(stderr, "index failed rc=%d\n", rc); return 1; }
+  printf("created index %s at page %u\n", key.name, meta);
+  return 0;
+}
+
+// find <root> <field>=<value>: point lookup through the field's hash index,
+// or its B+tree index if it has no hash index
+static int cmd_find(Pager* p, uint32_t root, const char* expr) {
+  const char* eq = strchr(expr, '=');
+  if (!eq || eq == expr || (size_t)(eq - expr) >= INDEX_NAME_MAX) { fprintf(stderr, "expected <field>=<value>\n"); return 2; }
+
+  char name[INDEX_NAME_MAX] = {0};
+  memcpy(name, expr, (size_t)(eq - expr));
+
+  uint32_t meta = 0;
+  int btree = 0;
+  int rc = hidx_open(p, root, name, &meta);
+  if (rc == TABLE_E_NOTFOUND) { rc = bidx_open(p, root, name, &meta); btree = 1; }
+  if (rc == TABLE_E_NOTFOUND) { fprintf(stderr, "no index on '%s' (create one with: index)\n", name); return 1; }
+  IndexKey key;
+  if (rc == TABLE_OK) rc = btree ? bidx_get_key(p, meta, &key) : hidx_get_key(p, meta, &key);
+  if (rc != TABLE_OK) { fprintf(stderr, "find failed rc=%d\n", rc); return 1; }
+
+  Field f = { .off = key.off, .len = key.len, .type = (FieldType)key.type };
+  unsigned char kbytes[TABLE_RECORD_SIZE];
+  if (encode_field_value(&f, eq + 1, kbytes, sizeof kbytes) != 0) { fprintf(stderr, "bad value for '%s'\n", name); return 2; }
+
+  OutBuf out;
+  outbuf_init(&out, stdout);
+  rc = btree ? bidx_range(p, meta, kbytes, kbytes, false, scan_cb, &out)
+             : hidx_find(p, meta, kbytes, scan_cb, &out);
+  outbuf_flush(&out);
+  if (rc != TABLE_OK) { fprintf(stderr, "find failed rc=%d\n", rc); return 1; }
+  return 0;
+}
+
+typedef struct {
+  size_t  left;   // ids still to print (SIZE_MAX = all)
+  OutBuf* out;
+} RangeCtx;
+
+static int range_cb(const void* rec, uint64_t id, void* ud) {
+  RangeCtx* ctx = (RangeCtx*)ud;
+  scan_cb(rec, id, ctx->out);
+  return --ctx->left == 0 ? 1 : 0;
+}
+
+// Ordered walk of a field's B+tree index: ids with lo <= key <= hi ("-" =
+// unbounded), ascending or descending, at most `limit` of them
+static int btree_walk(Pager* p, uint32_t root, const char* name,
+                       const char* lo, const char* hi, bool reverse, size_t limit) {
+  uint32_t meta = 0;
+  int rc = bidx_open(p, root, name, &meta);
+  if (rc == TABLE_E_NOTFOUND) { fprintf(stderr, "no btree index on '%s' (create one with: index ... btree)\n", name); return 1; }
+  IndexKey key;
+  if (rc == TABLE_OK) rc = bidx_get_key(p, meta, &key);
+  if (rc != TABLE_OK) { fprintf(stderr, "range failed rc=%d\n", rc); return 1; }
+
+  Field f = { .off = key.off, .len = key.len, .type = (FieldType)key.type };
+  unsigned char lo_k[TABLE_RECORD_SIZE], hi_k[TABLE_RECORD_SIZE];
+  const int has_lo = strcmp(lo, "-") != 0, has_hi = strcmp(hi, "-") != 0;
+  if ((has_lo && encode_field_value(&f, lo, lo_k, sizeof lo_k) != 0) ||
+      (has_hi && encode_field_value(&f, hi, hi_k, sizeof hi_k) != 0)) { fprintf(stderr, "bad bound for '%s'\n", name); return 2; }
+  if (limit == 0) return 0;
 
-static void usage(const char* prog) {
+  OutBuf out;
+  outbuf_init(&out, stdout);
+  RangeCtx ctx = { limit, &out };
+  rc = bidx_range(p, meta, has_lo ? lo_k : NULL, has_hi ? hi_k : NULL, reverse, range_cb, &ctx);
+  outbuf_flush(&out);
+  if (rc != TABLE_OK && rc != 1) { fprintf(stderr, "range failed rc=%d\n", rc); return 1; }
+  return 0;
+}
+
+static int usage(const char* prog) {
   fprintf(stderr,
     "Usage:\n"
-    "  %s <db> create <root_page>\n"
+    "  %s <db> create <root_page> [page_size]\n"
     "  %s <db> insert <root_page> <file_128bytes>\n"
+    "  %s <db> load <root_page> <file_of_128byte_records>\n"
     "  %s <db> get <id>\n"
     "  %s <db> update <id> <file_128bytes>\n"
     "  %s <db> delete <id>\n"
     "  %s <db> scan <root_page>\n"
     "  %s <db> validate <root_page>\n"
-    "  %s <db> listf <root_page> <spec>\n"
-    "  %s <db> getf  <id>        <spec>\n",
+    "  %s <db> count <root_page>\n"
+    "  %s <db> vacuum <root_page> [--compact|--pack[=<fill%%>]]\n"
+    "  %s <db> vcreate <root_page> [page_size]\n"
+    "  %s <db> pcreate <root_page> <spec> [page_size]   (records stored by column)\n"
+    "  %s <db> vinsert <root_page> <file>\n"
+    "  %s <db> vget <id>\n"
+    "  %s <db> vscan <root_page>\n"
+    "  %s <db> tables\n"
+    "  %s <db> listf <root_page> <spec> [--where <expr>]... [--format=<fmt>]\n"
+    "  %s <db> getf  <id>        <spec> [--format=<fmt>]\n"
+    "  %s <db> agg   <root_page> <spec> <expr> [--where <expr>]... [--threads <n>]\n"
+    "  %s <db> export-columnar <root_page> <spec> <dir> [--where <expr>]...\n"
+    "  %s <db> index <root_page> <name:off:len:type> [hash|btree]\n"
+    "  %s <db> find  <root_page> <field>=<value>\n"
+    "  %s <db> range <root_page> <field> <lo|-> <hi|->\n"
+    "  %s <db> top   <root_page> <field> <n>\n"
+    "  %s <db> stats [reset]   (engine counters of this process)\n"
+    "  %s <db> shell   (the commands above, one per line on stdin, without <db>;\n"
+    "                   begin / commit / abort group them into one transaction;\n"
+    "                   commit aborts it if a command in it failed; a commit\n"
+    "                   is one write-ahead log commit, kept whole or not at all)\n"
+    "Options (before <db>):\n"
+    "  --paranoid   validate every table page on each access, not once per load\n"
+    "  --stats      print engine counters and latencies to stderr when done\n",
+    prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog,
     prog, prog, prog, prog, prog, prog, prog, prog, prog);
-  exit(2);
-}
-
-static void print_hex(const void* data, size_t n) {
-  const unsigned char* p = (const unsigned char*)data;
-  for (size_t i = 0; i < n; i++) {
-    if ((i % 16) == 0) printf("%08zx  ", i);
-    printf("%02x%s", p[i], ((i+1)%8==0) ? "  " : " ");
-    if ((i % 16) == 15) printf("\n");
-  }
-  if ((n % 16) != 0) printf("\n");
+  return 2;
 }
 
-static void cmd_inspect(Pager* p, uint32_t root) {
-  // buffer pour une page
-  unsigned char pagebuf[4096];
+static int cmd_inspect(Pager* p, uint32_t root) {
+  // page épinglée (pas de copie)
+  const unsigned char* pagebuf = NULL;
   uint32_t page_no = root;
   uint64_t hop = 0, total_used = 0;
   const uint64_t HOP_LIMIT = 1000000; // garde-fou contre boucles
@@ -147,118 +626,436 @@ static void cmd_inspect(Pager* p, uint32_t root) {
   while (page_no != 0) {
     if (++hop > HOP_LIMIT) { fprintf(stderr, "chain too long / loop?\n"); break; }
 
-    if (pager_read(p, page_no, pagebuf) != PAGER_OK) {
+    if (pager_pin(p, page_no, (const void**)&pagebuf) != PAGER_OK) {
       fprintf(stderr, "read page %u failed\n", page_no);
       break;
     }
     // valide & récupère les champs
-    if (tbl_validate(pagebuf) != TABLE_OK) {
+    const bool slotted = tbl_get_kind(pagebuf) == TABLE_PAGE_KIND_SLOTTED;
+    const bool packed  = tbl_get_kind(pagebuf) == TABLE_PAGE_KIND_PACKED;
+    const bool pax     = tbl_get_kind(pagebuf) == TABLE_PAGE_KIND_PAX;
+    if ((slotted ? spg_validate(pagebuf, pager_page_size(p))
+         : packed ? pkl_validate(pagebuf, pager_page_size(p))
+         : pax    ? pax_validate(pagebuf, pager_page_size(p))
+                  : tbl_validate(pagebuf, pager_page_size(p))) != TABLE_OK) {
       fprintf(stderr, "page %u invalid\n", page_no);
+      pager_unpin(p, pagebuf, false);
       break;
     }
 
     uint16_t kind        = tbl_get_kind(pagebuf);
-    uint16_t rec_size    = tbl_get_record_size(pagebuf);
-    uint16_t capacity    = tbl_get_capacity(pagebuf);
+    uint16_t rec_size    = slotted ? 0 : tbl_get_record_size(pagebuf);
+    uint16_t capacity    = slotted ? spg_get_slot_count(pagebuf) : tbl_get_capacity(pagebuf);
+    size_t   free_bytes  = slotted ? spg_free_space(pagebuf, pager_page_size(p)) : 0;
     uint16_t used        = tbl_get_used_count(pagebuf);
     uint32_t next        = tbl_get_next_page(pagebuf);
+    PaxLayout layout     = { 0 };
+    if (pax) pax_layout_of(pagebuf, &layout);
+    pager_unpin(p, pagebuf, false);
 
     if (page_no == root) printf("%u", page_no); else printf(" -> %u", page_no);
 
-    printf("\n  page %u: kind=%u rec_size=%u capacity=%u used=%u next=%u\n",
-           page_no, kind, rec_size, capacity, used, next);
+    if (slotted) {
+      printf("\n  page %u: kind=%u slots=%u free=%zu used=%u next=%u\n",
+             page_no, kind, capacity, free_bytes, used, next);
+    } else if (pax) {
+      printf("\n  page %u: kind=%u rec_size=%u capacity=%u used=%u next=%u columns=",
+             page_no, kind, rec_size, capacity, used, next);
+      for (unsigned c = 0; c < layout.n; c++)
+        printf("%s%u:%u", c ? "," : "", layout.start[c], pax_col_width(&layout, c));
+      printf("\n");
+    } else
+      printf("\n  page %u: kind=%u rec_size=%u capacity=%u used=%u next=%u\n",
+             page_no, kind, rec_size, capacity, used, next);
 
     total_used += used;
     if (next == 0) break;
     page_no = next;
   }
-  printf("\nTotal rows (sum used): %llu\n", (unsigned long long)total_used);
+  printf("\nTotal rows (sum used): %" PRIu64 "\n", total_used);
+  return 0;
 }
 
-static void cmd_dump_page(Pager* p, uint32_t page_no) {
-  unsigned char pagebuf[4096];
-  if (pager_read(p, page_no, pagebuf) != PAGER_OK) {
+static int cmd_dump_page(Pager* p, uint32_t page_no) {
+  const unsigned char* pagebuf = NULL;
+  if (pager_pin(p, page_no, (const void**)&pagebuf) != PAGER_OK) {
     fprintf(stderr, "read page %u failed\n", page_no);
-    exit(1);
+    return 1;
   }
-  printf("Page %u (4096 bytes):\n", page_no);
-  print_hex(pagebuf, sizeof pagebuf);
+  const size_t page_size = pager_page_size(p);
+  printf("Page %u (%zu bytes):\n", page_no, page_size);
+  print_hex(pagebuf, page_size);
+  pager_unpin(p, pagebuf, false);
+  return 0;
 }
 
-static void cmd_dump_row(Pager* p, uint32_t id) {
+static int cmd_dump_row(Pager* p, uint64_t id) {
   unsigned char rec[128];
   if (tblmgr_get(p, id, rec) != TABLE_OK) {
-    fprintf(stderr, "get %u failed\n", id);
-    exit(1);
+    fprintf(stderr, "get %" PRIu64 " failed\n", id);
+    return 1;
   }
-  printf("Row %u (128 bytes):\n", id);
+  printf("Row %" PRIu64 " (128 bytes):\n", id);
   print_hex(rec, sizeof rec);
+  return 0;
 }
 
-int main(int argc, char** argv) {
-  if (argc < 3) usage(argv[0]);
-  const char* db = argv[1];
-  const char* cmd = argv[2];
+static int is_read_only_cmd(const char* cmd) {
+  static const char* const ro[] = {
+    "get", "scan", "validate", "count", "tables", "inspect", "dump", "listf", "getf", "agg", "find",
+    "range", "top", "vget", "vscan", "stats", "export-columnar"
+  };
+  for (size_t i = 0; i < sizeof ro / sizeof ro[0]; i++)
+    if (strcmp(cmd, ro[i]) == 0) return 1;
+  return 0;
+}
 
-  Pager* p = NULL;
-  if (pager_open(db, &p) != PAGER_OK) die("pager_open failed");
+// Run one command on an open pager. argv is laid out as for main()
+// (argv[1] = db, argv[2] = command). Returns the process exit status:
+// 0 on success, 1 if the command failed, 2 on bad usage.
+static int run_command(Pager* p, int argc, char** argv) {
+  const char* cmd = argv[2];
 
   if (strcmp(cmd, "create")==0) {
-    if (argc != 4) usage(argv[0]);
+    if (argc != 4 && argc != 5) return usage(argv[0]);
     uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_create(p, root);
+    uint32_t page_size = argc == 5 ? (uint32_t)strtoul(argv[4], NULL, 10) : 0;
+    return cmd_create(p, root, page_size);
   } else if (strcmp(cmd, "insert")==0) {
-    if (argc != 5) usage(argv[0]);
+    if (argc != 5) return usage(argv[0]);
     uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_insert(p, root, argv[4]);
+    return cmd_insert(p, root, argv[4]);
+  } else if (strcmp(cmd, "load")==0) {
+    if (argc != 5) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_load(p, root, argv[4]);
   } else if (strcmp(cmd, "get")==0) {
-    if (argc != 4) usage(argv[0]);
-    uint32_t id = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_get(p, id);
+    if (argc != 4) return usage(argv[0]);
+    uint64_t id = strtoull(argv[3], NULL, 10);
+    return cmd_get(p, id);
   } else if (strcmp(cmd, "update")==0) {
-    if (argc != 5) usage(argv[0]);
-    uint32_t id = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_update(p, id, argv[4]);
+    if (argc != 5) return usage(argv[0]);
+    uint64_t id = strtoull(argv[3], NULL, 10);
+    return cmd_update(p, id, argv[4]);
   } else if (strcmp(cmd, "delete")==0) {
-    if (argc != 4) usage(argv[0]);
-    uint32_t id = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_delete(p, id);
+    if (argc != 4) return usage(argv[0]);
+    uint64_t id = strtoull(argv[3], NULL, 10);
+    return cmd_delete(p, id);
   } else if (strcmp(cmd, "scan")==0) {
-    if (argc != 4) usage(argv[0]);
+    if (argc != 4) return usage(argv[0]);
     uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_scan(p, root);
+    return cmd_scan(p, root);
   } else if (strcmp(cmd, "validate")==0) {
-    if (argc != 4) usage(argv[0]);
+    if (argc != 4) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_validate(p, root);
+  } else if (strcmp(cmd, "count")==0) {
+    if (argc != 4) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_count(p, root);
+  } else if (strcmp(cmd, "vacuum")==0) {
+    if (argc != 4 && argc != 5) return usage(argv[0]);
     uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_validate(p, root);
+    return cmd_vacuum(p, root, argc == 5 ? argv[4] : NULL);
+  } else if (strcmp(cmd, "vcreate")==0) {
+    if (argc != 4 && argc != 5) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    uint32_t page_size = argc == 5 ? (uint32_t)strtoul(argv[4], NULL, 10) : 0;
+    return cmd_vcreate(p, root, page_size);
+  } else if (strcmp(cmd, "pcreate")==0) {
+    if (argc != 5 && argc != 6) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    uint32_t page_size = argc == 6 ? (uint32_t)strtoul(argv[5], NULL, 10) : 0;
+    return cmd_pcreate(p, root, argv[4], page_size);
+  } else if (strcmp(cmd, "vinsert")==0) {
+    if (argc != 5) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_vinsert(p, root, argv[4]);
+  } else if (strcmp(cmd, "vget")==0) {
+    if (argc != 4) return usage(argv[0]);
+    uint64_t id = strtoull(argv[3], NULL, 10);
+    return cmd_vget(p, id);
+  } else if (strcmp(cmd, "vscan")==0) {
+    if (argc != 4) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_vscan(p, root);
+  } else if (strcmp(cmd, "tables")==0) {
+    if (argc != 3) return usage(argv[0]);
+    return cmd_tables(p);
   } else if (strcmp(cmd, "inspect")==0) {
-    if (argc != 4) usage(argv[0]);
+    if (argc != 4) return usage(argv[0]);
     uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
-    cmd_inspect(p, root);
+    return cmd_inspect(p, root);
   } else if (strcmp(cmd, "dump")==0) {
-    if (argc < 5) usage(argv[0]);
+    if (argc < 5) return usage(argv[0]);
     const char* what = argv[3];
     if (strcmp(what, "page")==0) {
       uint32_t pg = (uint32_t)strtoul(argv[4], NULL, 10);
-      cmd_dump_page(p, pg);
+      return cmd_dump_page(p, pg);
     } else if (strcmp(what, "row")==0) {
-      uint32_t id = (uint32_t)strtoul(argv[4], NULL, 10);
-      cmd_dump_row(p, id);
+      uint64_t id = strtoull(argv[4], NULL, 10);
+      return cmd_dump_row(p, id);
     }
+    return usage(argv[0]);
   } else if (strcmp(cmd, "listf")==0) {
-    if (argc != 5) usage(argv[0]);
+    if (argc < 5) return usage(argv[0]);
+    char* where[16];
+    int nwhere = 0;
+    OutFormat fmt = OUT_TABLE;
+    for (int i = 5; i < argc; i++) {
+      if (strncmp(argv[i], "--format=", 9) == 0) {
+        if (parse_format(argv[i] + 9, &fmt) != 0) return usage(argv[0]);
+      } else if (strcmp(argv[i], "--where") == 0 && i + 1 < argc && nwhere < (int)(sizeof where / sizeof where[0])) {
+        where[nwhere++] = argv[++i];
+      } else {
+        return usage(argv[0]);
+      }
+    }
     uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
     const char* spec = argv[4];
-    cmd_listf(p, root, spec);
+    return cmd_listf(p, root, spec, where, nwhere, fmt);
+  } else if (strcmp(cmd, "agg")==0) {
+    if (argc < 6 || (argc - 6) % 2 != 0) return usage(argv[0]);
+    char* where[16];
+    int nwhere = 0;
+    unsigned threads = 0;
+    for (int i = 6; i < argc; i += 2) {
+      if (strcmp(argv[i], "--threads") == 0) { threads = (unsigned)strtoul(argv[i + 1], NULL, 10); continue; }
+      if (strcmp(argv[i], "--where") != 0 || nwhere == (int)(sizeof where / sizeof where[0])) return usage(argv[0]);
+      where[nwhere++] = argv[i + 1];
+    }
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_agg(p, root, argv[4], argv[5], where, nwhere, threads);
+  } else if (strcmp(cmd, "export-columnar")==0) {
+    if (argc < 6 || (argc - 6) % 2 != 0) return usage(argv[0]);
+    char* where[16];
+    int nwhere = 0;
+    for (int i = 6; i < argc; i += 2) {
+      if (strcmp(argv[i], "--where") != 0 || nwhere == (int)(sizeof where / sizeof where[0])) return usage(argv[0]);
+      where[nwhere++] = argv[i + 1];
+    }
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_export_columnar(p, root, argv[4], argv[5], where, nwhere);
   } else if (strcmp(cmd, "getf")==0) {
-    if (argc != 5) usage(argv[0]);
-    uint32_t id = (uint32_t)strtoul(argv[3], NULL, 10);
+    if (argc != 5 && argc != 6) return usage(argv[0]);
+    OutFormat fmt = OUT_TABLE;
+    if (argc == 6 && (strncmp(argv[5], "--format=", 9) != 0 || parse_format(argv[5] + 9, &fmt) != 0)) return usage(argv[0]);
+    uint64_t id = strtoull(argv[3], NULL, 10);
     const char* spec = argv[4];
-    cmd_getf(p, id, spec);
-  } else {
-    usage(argv[0]);
+    return cmd_getf(p, id, spec, fmt);
+  } else if (strcmp(cmd, "index")==0) {
+    if (argc != 5 && argc != 6) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_index(p, root, argv[4], argc == 6 ? argv[5] : NULL);
+  } else if (strcmp(cmd, "find")==0) {
+    if (argc != 5) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return cmd_find(p, root, argv[4]);
+  } else if (strcmp(cmd, "range")==0) {
+    if (argc != 7) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return btree_walk(p, root, argv[4], argv[5], argv[6], false, SIZE_MAX);
+  } else if (strcmp(cmd, "top")==0) {
+    if (argc != 6) return usage(argv[0]);
+    uint32_t root = (uint32_t)strtoul(argv[3], NULL, 10);
+    return btree_walk(p, root, argv[4], "-", "-", true, (size_t)strtoul(argv[5], NULL, 10));
+  } else if (strcmp(cmd, "stats")==0) {
+    if (argc != 3 && argc != 4) return usage(argv[0]);
+    return cmd_stats(argc == 4 ? argv[3] : NULL);
+  }
+  return usage(argv[0]);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// shell: one long-running session over a single open pager
+//
+// Each stdin line is a command without the "<db>" prefix ("get 65536").
+// Words are split on blanks, "double quotes" keep blanks in one word, empty
+// lines and lines starting with '#' are skipped. Every reply ends with one
+// status line, "%ok" or "%err <status>" (status as the one-shot CLI would
+// exit with); error messages go to stderr.
+//
+// Requests may be pipelined: replies are buffered and only flushed when no
+// complete request is left in the input buffer, so a batch written in one go
+// is answered in one go. Extra verbs: "begin" (tblmgr_txn_begin), "commit"
+// (tblmgr_txn_commit, or pager_commit outside a transaction), "abort"
+// (tblmgr_txn_abort) and "quit". Once a command inside a transaction has
+// replied %err, "commit" aborts the transaction instead and replies %err,
+// so a change that stopped part way is never kept. The shell runs with the
+// WAL, so a crash during "commit" keeps all of the transaction or none of
+// it. A transaction left open at the end of the input is aborted.
+// ─────────────────────────────────────────────────────────────────────────────
+#define SHELL_LINE_MAX   4096
+#define SHELL_MAX_ARGS   16
+
+typedef struct {
+  int    fd;
+  size_t pos, len;            // unread input is buf[pos..len)
+  bool   eof;
+  char   buf[4 * SHELL_LINE_MAX];
+} LineReader;
+
+// Next input line, without its '\n', NUL-terminated in out.
+// Returns its length, -1 at end of input, -2 for an over-long line (skipped).
+static int shell_read_line(LineReader* r, char* out) {
+  bool too_long = false;
+  while (true) {
+    char* nl = memchr(r->buf + r->pos, '\n', r->len - r->pos);
+    if (nl || (r->eof && r->pos < r->len)) {
+      size_t n = nl ? (size_t)(nl - (r->buf + r->pos)) : r->len - r->pos;
+      if (!too_long && n < SHELL_LINE_MAX) {
+        memcpy(out, r->buf + r->pos, n);
+        out[n] = '\0';
+      }
+      r->pos += n + (nl ? 1 : 0);
+      return (too_long || n >= SHELL_LINE_MAX) ? -2 : (int)n;
+    }
+    if (r->eof) return too_long ? -2 : -1;
+
+    // No complete request buffered: the client waits for our replies
+    fflush(stdout);
+
+    if (r->pos > 0) {
+      memmove(r->buf, r->buf + r->pos, r->len - r->pos);
+      r->len -= r->pos;
+      r->pos = 0;
+    }
+    if (r->len == sizeof r->buf) { too_long = true; r->len = 0; }
+
+    ssize_t got = read(r->fd, r->buf + r->len, sizeof r->buf - r->len);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) r->eof = true; else r->len += (size_t)got;
+  }
+}
+
+// Split a line in place; returns the word count or -1 (too many words /
+// unterminated quote).
+static int shell_split(char* line, char** words, int max_words) {
+  int n = 0;
+  char* s = line;
+  while (true) {
+    while (*s == ' ' || *s == '\t' || *s == '\r') s++;
+    if (*s == '\0') return n;
+    if (n == max_words) return -1;
+    if (*s == '"') {
+      words[n++] = ++s;
+      char* q = strchr(s, '"');
+      if (!q) return -1;
+      *q = '\0';
+      s = q + 1;
+    } else {
+      words[n++] = s;
+      while (*s && *s != ' ' && *s != '\t' && *s != '\r') s++;
+      if (*s) *s++ = '\0';
+    }
   }
+}
+
+static int cmd_shell(Pager* p, const char* prog, const char* db) {
+  static LineReader in = { .fd = STDIN_FILENO };
+  static char line[SHELL_LINE_MAX];
+  bool txn_failed = false;   // a command of the open transaction replied %err
 
-  pager_close(p);
+  while (true) {
+    int n = shell_read_line(&in, line);
+    if (n == -1) break;
+
+    int rc;
+    char* argv[SHELL_MAX_ARGS + 2] = { (char*)prog, (char*)db };
+    int words = n == -2 ? -1 : shell_split(line, argv + 2, SHELL_MAX_ARGS);
+    if (words == 0 || (words > 0 && argv[2][0] == '#')) continue;
+
+    if (words < 0) {
+      if (n == -2) fprintf(stderr, "line too long (max %d bytes)\n", SHELL_LINE_MAX - 1);
+      else fprintf(stderr, "cannot parse line (unterminated quote or more than %d words)\n", SHELL_MAX_ARGS);
+      rc = 2;
+    } else if (strcmp(argv[2], "quit") == 0 || strcmp(argv[2], "exit") == 0) {
+      break;
+    } else if (strcmp(argv[2], "begin") == 0) {
+      rc = tblmgr_txn_begin(p) == TABLE_OK ? 0 : 1;
+      if (rc) fprintf(stderr, "begin failed (transaction already open?)\n");
+    } else if (strcmp(argv[2], "commit") == 0) {
+      if (pager_txn_active(p) && txn_failed) {
+        tblmgr_txn_abort(p);
+        fprintf(stderr, "transaction aborted: a command in it failed\n");
+        rc = 1;
+      } else {
+        rc = (pager_txn_active(p) ? tblmgr_txn_commit(p) == TABLE_OK : pager_commit(p) == PAGER_OK) ? 0 : 1;
+        if (rc) fprintf(stderr, "commit failed\n");
+      }
+      txn_failed = false;
+    } else if (strcmp(argv[2], "abort") == 0 || strcmp(argv[2], "rollback") == 0) {
+      rc = tblmgr_txn_abort(p) == TABLE_OK ? 0 : 1;
+      if (rc) fprintf(stderr, "no transaction to abort\n");
+      txn_failed = false;
+    } else if (strcmp(argv[2], "shell") == 0) {
+      fprintf(stderr, "already in a shell\n");
+      rc = 2;
+    } else {
+      rc = run_command(p, words + 2, argv);
+    }
+
+    if (rc != 0 && pager_txn_active(p)) txn_failed = true;
+    if (rc == 0) printf("%%ok\n"); else printf("%%err %d\n", rc);
+  }
+  fflush(stdout);
   return 0;
 }
+
+int main(int argc, char** argv) {
+  // Global options come before <db>; argv[0] moves up so commands keep their indexes
+  bool paranoid = false, show_stats = false;
+  while (argc > 1 && (strcmp(argv[1], "--paranoid") == 0 || strcmp(argv[1], "--stats") == 0)) {
+    if (argv[1][2] == 'p') paranoid = true;
+    else                   show_stats = true;
+    argv[1] = argv[0];
+    argv++;
+    argc--;
+  }
+  if (argc < 3) return usage(argv[0]);
+  const char* db = argv[1];
+  const char* cmd = argv[2];
+
+  // Read-only commands open the file read-only and map it instead of
+  // pread-ing every page
+  PagerConfig cfg = {0};
+  cfg.read_only = cfg.use_mmap = is_read_only_cmd(cmd);
+  cfg.paranoid = paranoid;
+  // The shell's transactions commit through the log (removed again at close)
+  cfg.wal = strcmp(cmd, "shell") == 0;
+  // A new file takes the page size given to create
+  if ((strcmp(cmd, "create")==0 || strcmp(cmd, "vcreate")==0) && argc == 5)
+    cfg.page_size = (uint32_t)strtoul(argv[4], NULL, 10);
+  if (strcmp(cmd, "pcreate")==0 && argc == 6)
+    cfg.page_size = (uint32_t)strtoul(argv[5], NULL, 10);
+
+  Pager* p = NULL;
+  int orc = pager_open_ex(db, &cfg, &p);
+  if (orc == PAGER_E_PAGESIZE) die("page size must be a power of two from 4096 to 65536");
+  if (orc == PAGER_E_RECOVERY) die("database needs recovery from its -wal log: open it once for writing (e.g. `mdb <db> shell </dev/null`)");
+  if (orc != PAGER_OK) die("pager_open failed");
+
+  // Timing reads the clock around each measured operation: only on demand
+  const bool shell = strcmp(cmd, "shell") == 0;
+  stats_set_timing(show_stats || shell);
+
+  int rc;
+  if (shell) {
+    if (argc != 3) { pager_close(p); return usage(argv[0]); }
+    rc = cmd_shell(p, argv[0], db);
+  } else {
+    rc = run_command(p, argc, argv);
+  }
+
+  // Changes reach the file here at the latest: a failed write-back fails the command
+  if (pager_close(p) != PAGER_OK) {
+    fprintf(stderr, "writing %s failed: changes may be lost\n", db);
+    if (rc == 0) rc = 1;
+  }
+  arena_free(&agg_arena);
+  if (show_stats) {
+    fflush(stdout);
+    print_stats(stderr);
+  }
+  return rc;
+}
@@ -0,0 +1,284 @@
+#include "packed.h"
+#include "table.h"
+#include "endian_util.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Largest supported page (PAGER_MAX_PAGE_SIZE) */
+#define PKL_MAX_PAGE 65536u
+
+/* Encoder result: the payload does not fit in the room given */
+#define PKL_NO_ROOM SIZE_MAX
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static inline size_t bitmap_bytes(size_t cap) {
+  return (cap + 7u) / 8u;
+}
+
+/**
+ * @brief Offset of the payload length word: first 4-byte boundary after the bitmap.
+ */
+static inline size_t len_off(size_t cap) {
+  return (TABLE_HDR_SIZE + bitmap_bytes(cap) + 3u) & ~(size_t)3u;
+}
+
+static inline size_t payload_off(size_t cap) {
+  return len_off(cap) + PKL_LEN_SIZE;
+}
+
+/**
+ * @brief Payload bytes available for `cap` records in a page.
+ */
+static inline size_t payload_room(size_t cap, size_t page_size) {
+  const size_t used = payload_off(cap) + TABLE_LEAF_CRC_SIZE;
+  return used < page_size ? page_size - used : 0;
+}
+
+/**
+ * @brief Run-length code one column: byte `col` of n records (stride
+ *        TABLE_RECORD_SIZE). Appends at out + len when out is not NULL; runs
+ *        never cross into the next column.
+ * @return The new payload length, or PKL_NO_ROOM past `limit` bytes.
+ */
+static size_t rle_column(const uint8_t* col, size_t n, uint8_t* out, size_t len, size_t limit) {
+  size_t r = 0, lit = 0;   // lit: literal bytes pending, ending before row r
+
+  while (r <= n) {
+    size_t run = 0;
+    if (r < n) {
+      const uint8_t b = col[r * TABLE_RECORD_SIZE];
+      run = 1;
+      while (run < PKL_RUN_MAX && r + run < n && col[(r + run) * TABLE_RECORD_SIZE] == b) run++;
+      if (run < PKL_RUN_MIN) {
+        r++;
+        if (++lit < PKL_LITERAL_MAX) continue;
+        run = 0;
+      }
+    }
+
+    // Flush the literal bytes before the run (or at a full literal, or the end)
+    if (lit > 0) {
+      if (len + 1u + lit > limit) return PKL_NO_ROOM;
+      if (out) {
+        out[len] = (uint8_t)(lit - 1u);
+        for (size_t i = 0; i < lit; i++)
+          out[len + 1u + i] = col[(r - lit + i) * TABLE_RECORD_SIZE];
+      }
+      len += 1u + lit;
+      lit = 0;
+    }
+    if (run == 0) {
+      if (r == n) break;
+      continue;
+    }
+
+    if (len + 2u > limit) return PKL_NO_ROOM;
+    if (out) {
+      out[len] = (uint8_t)(128u + run - PKL_RUN_MIN);
+      out[len + 1u] = col[r * TABLE_RECORD_SIZE];
+    }
+    len += 2u;
+    r += run;
+  }
+  return len;
+}
+
+/**
+ * @brief Payload of n records, written to `out` (NULL: only measured).
+ * @return Its length, or PKL_NO_ROOM past `limit` bytes.
+ */
+static size_t rle_encode(const uint8_t* recs, size_t n, uint8_t* out, size_t limit) {
+  size_t len = 0;
+  for (size_t j = 0; j < TABLE_RECORD_SIZE && len != PKL_NO_ROOM; j++)
+    len = rle_column(recs + j, n, out, len, limit);
+  return len;
+}
+
+/**
+ * @brief Walk a payload, checking it codes exactly `total` bytes.
+ */
+static bool rle_check(const uint8_t* in, size_t in_len, size_t total) {
+  size_t i = 0, k = 0;
+  while (i < in_len) {
+    const uint8_t c = in[i];
+    if (c < 128u) {
+      if (in_len - i < 2u + c) return false;
+      k += c + 1u;
+      i += 2u + c;
+    } else {
+      if (in_len - i < 2u) return false;
+      k += c - 128u + PKL_RUN_MIN;
+      i += 2u;
+    }
+    if (k > total) return false;
+  }
+  return k == total;
+}
+
+static inline bool fits(const uint8_t* recs, size_t n, size_t page_size) {
+  return rle_encode(recs, n, NULL, payload_room(n, page_size)) != PKL_NO_ROOM;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+size_t pkl_max_records(size_t page_size) {
+  return page_size / 8u;
+}
+
+size_t pkl_image_size(uint16_t capacity) {
+  return TABLE_HDR_SIZE + bitmap_bytes(capacity) + (size_t)capacity * TABLE_RECORD_SIZE;
+}
+
+size_t pkl_fit(const void* recs, size_t n, size_t page_size) {
+  if (!recs || page_size > PKL_MAX_PAGE) return 0;
+  if (n > pkl_max_records(page_size)) n = pkl_max_records(page_size);
+  const uint8_t* r = (const uint8_t*)recs;
+  if (n == 0 || fits(r, n, page_size)) return n;
+
+  // Largest prefix that fits: lo always does (or is 0), hi never does
+  size_t lo = 0, hi = n;
+  while (hi - lo > 1) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (fits(r, mid, page_size)) lo = mid;
+    else                         hi = mid;
+  }
+  return lo;
+}
+
+int pkl_build(void* page, size_t page_size, const void* recs, size_t n) {
+  if (!page || !recs || n == 0 || page_size > PKL_MAX_PAGE || n > pkl_max_records(page_size))
+    return TABLE_E_INVAL;
+  const size_t room = payload_room(n, page_size);
+  if (room == 0) return TABLE_E_FULL;
+
+  uint8_t* b = (uint8_t*)page;
+  memset(b, 0, page_size);
+  const size_t len = rle_encode((const uint8_t*)recs, n, b + payload_off(n), room);
+  if (len == PKL_NO_ROOM) {
+    memset(b, 0, page_size);
+    return TABLE_E_FULL;
+  }
+
+  write_le_u16(b + TABLE_HDR_KIND_OFF, TABLE_PAGE_KIND_PACKED);
+  write_le_u16(b + TABLE_HDR_RECORD_SIZE_OFF, TABLE_RECORD_SIZE);
+  write_le_u16(b + TABLE_HDR_CAPACITY_OFF, (uint16_t)n);
+  write_le_u16(b + TABLE_HDR_USED_COUNT_OFF, (uint16_t)n);
+  memset(b + TABLE_HDR_SIZE, 0xFF, n / 8u);
+  if (n % 8u) b[TABLE_HDR_SIZE + n / 8u] = (uint8_t)((1u << (n % 8u)) - 1u);
+  write_le_u32(b + len_off(n), (uint32_t)len);
+  return TABLE_OK;
+}
+
+int pkl_validate(const void* page, size_t page_size) {
+  if (!page || page_size <= TABLE_HDR_SIZE || page_size > PKL_MAX_PAGE)
+    return TABLE_E_INVAL;
+
+  const uint8_t* b = (const uint8_t*)page;
+  if (tbl_get_kind(b) != TABLE_PAGE_KIND_PACKED)
+    return TABLE_E_BADKIND;
+
+  const uint16_t cap = tbl_get_capacity(b);
+  const uint16_t used = tbl_get_used_count(b);
+  if (tbl_get_record_size(b) != TABLE_RECORD_SIZE || cap < 1 ||
+      cap > pkl_max_records(page_size) || used > cap)
+    return TABLE_E_LAYOUT;
+
+  const size_t room = payload_room(cap, page_size);
+  if (room == 0) return TABLE_E_LAYOUT;
+
+  // Bits past capacity can only live in the last byte
+  const uint8_t* bm = b + TABLE_HDR_SIZE;
+  size_t pop = 0;
+  for (size_t i = 0; i < bitmap_bytes(cap); i++)
+    pop += (size_t)__builtin_popcount(bm[i]);
+  if (pop != used || (cap % 8u && (bm[cap / 8u] >> (cap % 8u)) != 0))
+    return TABLE_E_BITMAP;
+
+  const uint32_t len = read_le_u32(b + len_off(cap));
+  if (len > room || !rle_check(b + payload_off(cap), len, (size_t)cap * TABLE_RECORD_SIZE))
+    return TABLE_E_LAYOUT;
+  return TABLE_OK;
+}
+
+void pkl_decode(const void* page, void* image) {
+  const uint8_t* b = (const uint8_t*)page;
+  uint8_t* img = (uint8_t*)image;
+  const uint16_t cap = tbl_get_capacity(b);
+  const size_t data = TABLE_HDR_SIZE + bitmap_bytes(cap);
+  memcpy(img, b, data);
+
+  // Column-major stream back into rows: (row, col) follows the byte count
+  const uint8_t* in = b + payload_off(cap);
+  const uint8_t* end = in + read_le_u32(b + len_off(cap));
+  uint8_t* col = img + data;
+  size_t row = 0;
+  while (in < end) {
+    const uint8_t c = *in++;
+    size_t count = c < 128u ? c + 1u : c - 128u + PKL_RUN_MIN;
+    const bool literal = c < 128u;
+    for (; count > 0; count--) {
+      col[row * TABLE_RECORD_SIZE] = literal ? *in++ : *in;
+      if (++row == cap) { row = 0; col++; }
+    }
+    if (!literal) in++;
+  }
+}
+
+int pkl_decode_buf(const void* page, uint8_t** buf, size_t* buf_cap) {
+  const size_t need = pkl_image_size(tbl_get_capacity(page));
+  if (need > *buf_cap) {
+    uint8_t* grown = realloc(*buf, need);
+    if (!grown) return TABLE_E_INVAL;
+    *buf = grown;
+    *buf_cap = need;
+  }
+  pkl_decode(page, *buf);
+  return TABLE_OK;
+}
+
+int pkl_repack(void* page, size_t page_size, void* image, void* scratch) {
+  if (!page || !image || page_size > PKL_MAX_PAGE) return TABLE_E_INVAL;
+  uint8_t* img = (uint8_t*)image;
+  const uint16_t cap = tbl_get_capacity(img);
+  for (int i = 0; i < cap; i++)
+    if (!tbl_slot_is_used(img, i)) memset(tbl_slot_ptr(img, i), 0, TABLE_RECORD_SIZE);
+
+  uint8_t* tmp = scratch ? scratch : malloc(page_size);
+  if (!tmp) return TABLE_E_INVAL;
+  int rc = pkl_build(tmp, page_size, img + TABLE_HDR_SIZE + bitmap_bytes(cap), cap);
+  if (rc == TABLE_OK) {
+    memcpy(tmp + TABLE_HDR_USED_COUNT_OFF, img + TABLE_HDR_USED_COUNT_OFF, 2);
+    memcpy(tmp + TABLE_HDR_NEXT_PAGE_OFF, (uint8_t*)page + TABLE_HDR_NEXT_PAGE_OFF,
+           TABLE_HDR_SIZE - TABLE_HDR_NEXT_PAGE_OFF);
+    memcpy(tmp + TABLE_HDR_SIZE, img + TABLE_HDR_SIZE, bitmap_bytes(cap));
+    memcpy(page, tmp, page_size);
+  }
+  if (!scratch) free(tmp);
+  return rc;
+}
+
+int pkl_record(const void* page, int slot, void* out) {
+  if (!page || !out || slot < 0 || slot >= tbl_get_capacity(page)) return TABLE_E_INVAL;
+  const uint8_t* b = (const uint8_t*)page;
+  const uint16_t cap = tbl_get_capacity(b);
+
+  // Byte j of the record sits at stream position j * cap + slot
+  uint8_t* rec = (uint8_t*)out;
+  const uint8_t* in = b + payload_off(cap);
+  const uint8_t* end = in + read_le_u32(b + len_off(cap));
+  size_t pos = 0, want = (size_t)slot, j = 0;
+  while (in < end && j < TABLE_RECORD_SIZE) {
+    const uint8_t c = *in++;
+    const bool literal = c < 128u;
+    const size_t count = literal ? c + 1u : c - 128u + PKL_RUN_MIN;
+    for (; j < TABLE_RECORD_SIZE && want < pos + count; j++, want += cap)
+      rec[j] = literal ? in[want - pos] : *in;
+    in += literal ? count : 1u;
+    pos += count;
+  }
+  return TABLE_OK;
+}
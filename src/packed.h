@@ -0,0 +1,107 @@
+#ifndef PACKED_H
+
+#define PACKED_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Packed leaf: fixed-size records, compressed
+ * - Page type: TABLE_PAGE_KIND_PACKED (0x000D), see table.h
+ * - Bytes 0..23 are a TABLE_LEAF header whose capacity is the number of
+ *   records packed (1..pkl_max_records()), followed by the slot bitmap as
+ *   in a TABLE_LEAF; the tbl_get/set_* and bitmap accessors work on it.
+ * - At the next 4-byte boundary: payload length (u32), then the payload:
+ *   the records column by column (byte 0 of every record, then byte 1...),
+ *   run-length coded. Control byte c < 128: c + 1 literal bytes follow;
+ *   c >= 128: the next byte repeats c - 128 + PKL_RUN_MIN times.
+ * - Written whole by vacuum (TBLMGR_VACUUM_PACK, see table_manager.h) and
+ *   read through pkl_decode() / pkl_record(); a delete only clears the
+ *   slot's bit, the bytes stay until the page is packed again.
+ * - Ends with a pager checksum, as a TABLE_LEAF (PAGER_CRC_PACKED_KIND).
+ * All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define PKL_LEN_SIZE                4   /* u32 payload length */
+#define PKL_LITERAL_MAX             128 /* bytes per literal run */
+#define PKL_RUN_MIN                 3   /* shorter repeats go into literals */
+#define PKL_RUN_MAX                 (127 + PKL_RUN_MIN)
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Most records one packed leaf may hold: page_size / 8 (512 for
+ *        4 KiB pages, about sixteen times a TABLE_LEAF), so slots fit in
+ *        16 bits.
+ */
+size_t pkl_max_records(size_t page_size);
+
+/**
+ * @brief Bytes of the TABLE_LEAF image pkl_decode() writes for a packed
+ *        leaf of `capacity` records: header, bitmap, records.
+ */
+size_t pkl_image_size(uint16_t capacity);
+
+/**
+ * @brief How many of the first records of `recs` fit in one packed leaf
+ *        (0 when not even one does, or n is 0).
+ * @param recs n records of TABLE_RECORD_SIZE bytes, back to back.
+ */
+size_t pkl_fit(const void* recs, size_t n, size_t page_size);
+
+/**
+ * @brief Write a packed leaf holding records 0..n-1 of `recs`, all live,
+ *        in the slots of the same number. next / root stay 0.
+ * @return TABLE_OK, TABLE_E_INVAL on bad arguments, or TABLE_E_FULL if
+ *         they do not fit (see pkl_fit).
+ */
+int pkl_build(void* page, size_t page_size, const void* recs, size_t n);
+
+/**
+ * @brief Validate a packed leaf: kind, header fields, bitmap against
+ *        used_count, and a payload that decodes to exactly `capacity`
+ *        records inside the page.
+ * @return TABLE_OK, TABLE_E_INVAL, TABLE_E_BADKIND, TABLE_E_LAYOUT or
+ *         TABLE_E_BITMAP.
+ */
+int pkl_validate(const void* page, size_t page_size);
+
+/**
+ * @brief Decode a validated packed leaf into a TABLE_LEAF image of
+ *        pkl_image_size() bytes (its kind word stays TABLE_PAGE_KIND_PACKED):
+ *        tbl_slot_ptr_c(), tbl_slot_word() and the slot iterator work on it.
+ *        Freed slots hold their old bytes.
+ */
+void pkl_decode(const void* page, void* image);
+
+/**
+ * @brief pkl_decode() into a heap buffer grown as needed (free() it).
+ * @return TABLE_OK, or TABLE_E_INVAL when out of memory.
+ */
+int pkl_decode_buf(const void* page, uint8_t** buf, size_t* buf_cap);
+
+/**
+ * @brief Pack a validated packed leaf again from its pkl_decode() image,
+ *        changed in place: the bitmap and used count come from the image,
+ *        the other header words stay. Freed slots are zeroed in `image`
+ *        first (their bytes compress to nothing). The new page is built
+ *        in `scratch` (page_size bytes, e.g. from pager_buf_get(); NULL:
+ *        a heap buffer for the call).
+ * @return TABLE_OK, TABLE_E_INVAL, or TABLE_E_FULL (page left unchanged)
+ *         if the records no longer fit.
+ */
+int pkl_repack(void* page, size_t page_size, void* image, void* scratch);
+
+/**
+ * @brief Copy out record `slot` of a validated packed leaf, live or not,
+ *        without decoding the others.
+ * @return TABLE_OK, or TABLE_E_INVAL if the slot is out of range.
+ */
+int pkl_record(const void* page, int slot, void* out);
+
+#endif // PACKED_H
@@ -1,13 +1,20 @@
+#define _POSIX_C_SOURCE 200809L
 #include "pager.h"
+#include "wal.h"
 #include "endian_util.h"
+#include "crc32c.h"
+#include "stats.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <stdint.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Defines (on-disk header layout)
@@ -17,17 +24,153 @@
 #define HDR_PAGESIZE_OFF   8   // u32 LE
 #define HDR_PAGECOUNT_OFF 12   // u32 LE
 #define HDR_FLAGS_OFF     16   // u32 LE
+#define HDR_CATALOG_OFF   20   // u32 LE
+#define HDR_FREELIST_OFF  24   // u32 LE
+#define HDR_FREECOUNT_OFF 28   // u32 LE
+#define FREE_NEXT_OFF      4   // u32 LE, in a free page
 #define FILE_MAGIC      "MDB1"
 #define FILE_MAGIC_LEN  4
-#define FILE_VERSION    1u
+#define FILE_VERSION    2u   // written to new files
+#define FILE_VERSION_MIN 1u  // oldest version still opened
+
+#define FRAME_NONE      UINT32_MAX   // empty hash bucket / end of chain
+#define PAGE_STATE_NEW  0xFFu        // loaded, checksum not looked at yet
+#define SEQ_MAX_GAP     4            // forward skip that still continues a run
+#define SLAB_BATCH      16           // page buffers carved per slab block
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Private type
+// Private types
 // ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief One slot of the buffer pool.
+ *
+ * A frame caches exactly one page. While pin_count > 0 the frame cannot be
+ * evicted; `ref` is the CLOCK reference bit, `dirty` means the cached image
+ * differs from the file and must be written back before reuse.
+ *
+ * Every pin also holds the frame's latch: shared for pager_pin(), exclusive
+ * for pager_pin_mut() / pager_pin_zero(). The latch is reentrant for the
+ * thread that holds it exclusively (owner), and a thread that shares it may
+ * upgrade once the other readers are gone. `loading` is set while the page
+ * is being read from the file with the pager lock dropped. `state` is a
+ * PagerPageState, or PAGE_STATE_NEW until the loaded image is checked.
+ */
+typedef struct Frame {
+  uint8_t*  data;
+  uint32_t  page_no;
+  uint32_t  pin_count;
+  uint32_t  hash_next;     // next frame index in the same bucket
+  uint32_t  readers;       // shared latch holders
+  uint32_t  excl_depth;    // nested exclusive pins of `owner` (0 = none)
+  uint32_t  excl_waiting;  // threads waiting for the exclusive latch
+  pthread_t owner;
+  bool      valid;
+  bool      dirty;
+  bool      ref;
+  bool      loading;
+  _Atomic uint8_t state;
+} Frame;
+
+/**
+ * @brief Copy of a page image kept for snapshots (pager_snapshot_begin).
+ *
+ * Snapshot `seq` sees the image a page had when it began, which is the
+ * copy with from < seq <= until: `until` is the snapshot sequence current
+ * when the page was changed, `from` the one of the copy before (0 if none
+ * is left). Copies are read-only, so their pins take no latch.
+ */
+typedef struct PageVersion {
+  struct PageVersion* next;   // same hash bucket (Pager.version_spare: next spare)
+  uint8_t*  data;             // page_size bytes, a slab buffer
+  uint32_t  page_no;
+  uint32_t  pins;
+  uint64_t  from, until;
+  _Atomic uint8_t state;      // PagerPageState, like Frame.state
+} PageVersion;
+
+struct PagerSnapshot {
+  Pager*         pager;
+  uint64_t       seq;
+  PagerSnapshot* next;        // Pager.snapshots, newest first
+};
+
 struct Pager {
     int fd;
     size_t page_size;
-    uint32_t page_count;
+    uint32_t version;              // file format version, from the header
+    _Atomic uint32_t page_count;   // read without the lock by pager_page_count()
+    _Atomic uint32_t catalog;      // header copy, read without the lock
+    uint32_t free_head;            // header copies of the free list
+    _Atomic uint32_t free_count;
+    off_t file_size;
+
+    // Buffer pool (fixed number of frames, CLOCK eviction)
+    uint8_t*  pool;         // frame_count * page_size bytes, one page-aligned block
+    Frame*    frames;
+    Frame**   flush_batch;  // frame_count entries, filled by flush_locked()
+    size_t    frame_count;
+    uint32_t* buckets;      // page_no hash -> first frame index
+    size_t    bucket_mask;
+    size_t    clock_hand;
+
+    bool      read_only;    // PagerConfig.read_only: the file is open O_RDONLY
+    // Optional read-only file mapping (PagerConfig.use_mmap, read-only pagers only)
+    bool      use_mmap;
+    uint8_t*  map;          // NULL when not mapped
+    size_t    map_len;      // bytes mapped: page_count pages, fixed at open
+    uint32_t  map_pins;     // outstanding pins served from the mapping
+    _Atomic uint8_t* map_state;   // PagerPageState of each mapped page
+
+    // Optional write-ahead log (PagerConfig.wal)
+    Wal*      wal;          // NULL in direct write-back mode
+    uint32_t  group_commit;
+    uint32_t  autocheckpoint;
+    uint32_t  unsynced;     // commits appended since the last log fsync
+
+    // Guards all of the above; latch and load waits sleep on latch_cv
+    pthread_mutex_t lock;
+    pthread_cond_t  latch_cv;
+
+    // Batched reads / writes (pager_prefetch, flush). io_lock serializes the
+    // queue and is taken after `lock` or on its own, never the other way.
+    PioQueue* io;
+    unsigned  io_depth;
+    pthread_mutex_t io_lock;
+
+    // Sequential read-ahead (PagerConfig.readahead, 0 = off)
+    uint32_t  readahead;
+    _Atomic uint64_t readahead_pages;   // pages announced to the kernel
+
+    bool      paranoid;     // PagerConfig.paranoid: nothing is ever trusted
+
+    // Snapshot reads (pager_snapshot_begin) and write sections
+    uint64_t       snap_seq;        // sequence of the newest snapshot
+    PagerSnapshot* snapshots;       // active ones, newest first
+    PageVersion**  versions;        // page copies hashed by page number (lazy)
+    size_t         version_mask;    // buckets - 1
+    _Atomic size_t version_count;
+    pthread_t      writer;          // thread in a write section
+    uint32_t       write_depth;     // its nesting (0 = none)
+
+    // Copies and snapshots no longer in use, kept for the next ones
+    PageVersion*   version_spare;
+    PagerSnapshot* snap_spare;
+
+    // Page buffers of pager_buf_get() and the snapshot copies: page-aligned,
+    // carved SLAB_BATCH at a time from blocks kept until close. slab_lock
+    // is taken on its own or after `lock`.
+    pthread_mutex_t slab_lock;
+    void*          slab_free;       // free buffers, linked through their first bytes
+    void**         slab_blocks;     // every block carved so far
+    size_t         slab_nblocks;
+
+    // Transaction (pager_txn_begin) of `writer`, the header fields and file
+    // size it started from, restored on abort, and the snapshot the other
+    // threads read through meanwhile
+    _Atomic bool   txn;
+    uint32_t       txn_page_count, txn_catalog, txn_free_head, txn_free_count;
+    off_t          txn_file_size;
+    PagerSnapshot* txn_snap;
 };
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -40,12 +183,15 @@ struct Pager {
 static int read_full(int fd, void* buf, size_t len, off_t base_offset) {
   size_t done = 0;
   ssize_t n = 0;
+  const uint64_t t0 = stats_start();
+  stats_add(STAT_FILE_READS, 1);
 
   while (done < len) {
     n = pread(fd, (char*)buf + done, len - done, base_offset + (off_t) done);
 
     if (n > 0) {
       done += n;
+      stats_add(STAT_BYTES_READ, (uint64_t)n);
     } else if (n == 0) {
       return PAGER_E_IO;
     } else if (errno == EINTR || errno == EAGAIN) {
@@ -55,6 +201,7 @@ static int read_full(int fd, void* buf, size_t len, off_t base_offset) {
     }
   }
 
+  stats_stop(STAT_H_FILE_READ, t0);
   return PAGER_OK;
 }
 
@@ -65,12 +212,15 @@ static int read_full(int fd, void* buf, size_t len, off_t base_offset) {
 static int write_full(int fd, const void* buf, size_t len, off_t base_offset) {
   size_t done = 0;
   ssize_t n = 0;
+  const uint64_t t0 = stats_start();
+  stats_add(STAT_FILE_WRITES, 1);
 
   while (done < len) {
     n = pwrite(fd, (const char*) buf + done, len - done, base_offset + (off_t) done);
 
     if (n > 0) {
       done += n;
+      stats_add(STAT_BYTES_WRITTEN, (uint64_t)n);
     } else if (n == 0) {
       return PAGER_E_IO;
     } else if (errno == EINTR || errno == EAGAIN) {
@@ -80,11 +230,20 @@ static int write_full(int fd, const void* buf, size_t len, off_t base_offset) {
     }
   }
 
+  stats_stop(STAT_H_FILE_WRITE, t0);
   return PAGER_OK;
 }
 
 /**
- * @brief Validate the 20-byte on-disk header and extract fields.
+ * @brief Page sizes a file may use: powers of two from 4 KiB to 64 KiB.
+ */
+static bool page_size_ok(uint32_t page_size) {
+  return page_size >= PAGER_MIN_PAGE_SIZE && page_size <= PAGER_MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1u)) == 0;
+}
+
+/**
+ * @brief Validate the on-disk header and extract fields.
  *        Checks magic/version/page_size/page_count/flags.
  */
 static int validate_header(const uint8_t hdr[PAGER_HDR_SIZE],
@@ -100,8 +259,9 @@ static int validate_header(const uint8_t hdr[PAGER_HDR_SIZE],
   const uint32_t page_count = read_le_u32(hdr + HDR_PAGECOUNT_OFF);
   const uint32_t flags      = read_le_u32(hdr + HDR_FLAGS_OFF);
 
-  if (version != FILE_VERSION)         return PAGER_E_VERSION;
-  if (page_size != PAGER_PAGE_SIZE)    return PAGER_E_PAGESIZE;
+  if (version < FILE_VERSION_MIN || version > FILE_VERSION)
+                                       return PAGER_E_VERSION;
+  if (!page_size_ok(page_size))        return PAGER_E_PAGESIZE;
   if (page_count < 1)                  return PAGER_E_META;
   if (flags != 0)                      return PAGER_E_META;
 
@@ -113,204 +273,2437 @@ static int validate_header(const uint8_t hdr[PAGER_HDR_SIZE],
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Public API
+// Buffer pool (internal)
 // ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Hash a page number into the bucket table (Fibonacci hashing).
+ */
+static inline size_t pool_bucket(const Pager* p, uint32_t page_no) {
+  return (size_t)((page_no * 2654435761u) & p->bucket_mask);
+}
 
 /**
- * @brief Open and validate a MiniDB file, returning an opaque Pager handle.
+ * @brief Allocate the frame array, the page-sized frame block and the
+ *        page_no -> frame hash table for `frame_count` frames.
  */
-int pager_open(const char* path, Pager** out) {
-    int rc = PAGER_OK;
-    int fd = -1;
-    Pager *p = NULL;
-    uint8_t header[PAGER_HDR_SIZE];
+static int pool_init(Pager* p, size_t frame_count) {
+  size_t nbuckets = 1;
+  while (nbuckets < frame_count) nbuckets <<= 1;
 
-    if (!path || !out)
-        return PAGER_E_INVAL;
+  if (frame_count > SIZE_MAX / p->page_size)
+    return PAGER_E_INVAL;
 
-    *out = NULL;
+  // Frames are aligned on the page size, as O_DIRECT transfers want them
+  void* pool = NULL;
+  if (posix_memalign(&pool, p->page_size, frame_count * p->page_size) != 0)
+    return PAGER_E_IO;
+  p->pool = memset(pool, 0, frame_count * p->page_size);
+  p->frames  = calloc(frame_count, sizeof *p->frames);
+  p->buckets = malloc(nbuckets * sizeof *p->buckets);
+  p->flush_batch = malloc(frame_count * sizeof *p->flush_batch);
+  if (!p->frames || !p->buckets || !p->flush_batch)
+    return PAGER_E_IO;
 
-    fd = open(path, O_RDWR | O_CREAT, 0644);
-    if (fd < 0) {
-        rc = PAGER_E_IO;
-        goto cleanup;
-    }
+  for (size_t i = 0; i < nbuckets; i++)
+    p->buckets[i] = FRAME_NONE;
 
-    {
-      struct stat st0;
-      if (fstat(fd, &st0) < 0) {
-        rc = PAGER_E_IO;
-        goto cleanup;
-      }
-      if (st0.st_size == 0) {
-        uint8_t init_hdr[PAGER_HDR_SIZE];
-        memcpy(init_hdr + HDR_MAGIC_OFF, FILE_MAGIC, FILE_MAGIC_LEN);
-        write_le_u32(init_hdr + HDR_VERSION_OFF, FILE_VERSION);
-        write_le_u32(init_hdr + HDR_PAGESIZE_OFF, PAGER_PAGE_SIZE);
-        write_le_u32(init_hdr + HDR_PAGECOUNT_OFF, 1u);
-        write_le_u32(init_hdr + HDR_FLAGS_OFF, 0u);
+  for (size_t i = 0; i < frame_count; i++) {
+    p->frames[i].data = p->pool + i * p->page_size;
+    p->frames[i].hash_next = FRAME_NONE;
+  }
 
-        rc = write_full(fd, init_hdr, PAGER_HDR_SIZE, 0);
-        if (rc != PAGER_OK) {
-          goto cleanup;
-        }
+  p->frame_count = frame_count;
+  p->bucket_mask = nbuckets - 1;
+  p->clock_hand  = 0;
+  return PAGER_OK;
+}
 
-        if (ftruncate(fd, (off_t)PAGER_PAGE_SIZE) != 0) {
-          rc = PAGER_E_IO;
-          goto cleanup;
-        }
-      }
+/**
+ * @brief Release the memory owned by the buffer pool (no write-back).
+ */
+static void pool_free(Pager* p) {
+  free(p->frames);
+  free(p->pool);
+  free(p->buckets);
+  free(p->flush_batch);
+  p->frames = NULL;
+  p->pool = NULL;
+  p->buckets = NULL;
+  p->flush_batch = NULL;
+  p->frame_count = 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Page buffer slab
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief A free page buffer, carving a new block when there is none.
+ * @return NULL when out of memory.
+ */
+static void* slab_get(Pager* p) {
+  pthread_mutex_lock(&p->slab_lock);
+  if (!p->slab_free) {
+    void** blocks = realloc(p->slab_blocks, (p->slab_nblocks + 1) * sizeof *blocks);
+    void* block = NULL;
+    if (!blocks || posix_memalign(&block, p->page_size, SLAB_BATCH * p->page_size) != 0) {
+      if (blocks) p->slab_blocks = blocks;
+      pthread_mutex_unlock(&p->slab_lock);
+      return NULL;
+    }
+    p->slab_blocks = blocks;
+    p->slab_blocks[p->slab_nblocks++] = block;
+    for (size_t i = SLAB_BATCH; i-- > 0; ) {
+      void* buf = (uint8_t*)block + i * p->page_size;
+      memcpy(buf, &p->slab_free, sizeof p->slab_free);
+      p->slab_free = buf;
     }
+  }
+  void* buf = p->slab_free;
+  memcpy(&p->slab_free, buf, sizeof p->slab_free);
+  pthread_mutex_unlock(&p->slab_lock);
+  return buf;
+}
 
-    rc = read_full(fd, header, PAGER_HDR_SIZE, 0);
-    if (rc != PAGER_OK)
-        goto cleanup;
+static void slab_put(Pager* p, void* buf) {
+  pthread_mutex_lock(&p->slab_lock);
+  memcpy(buf, &p->slab_free, sizeof p->slab_free);
+  p->slab_free = buf;
+  pthread_mutex_unlock(&p->slab_lock);
+}
 
-    uint32_t version    = 0;
-    uint32_t page_size  = 0;
-    uint32_t page_count = 0;
-    uint32_t flags      = 0;
+static void slab_release(Pager* p) {
+  for (size_t i = 0; i < p->slab_nblocks; i++)
+    free(p->slab_blocks[i]);
+  free(p->slab_blocks);
+  p->slab_blocks = NULL;
+  p->slab_nblocks = 0;
+  p->slab_free = NULL;
+}
 
-    if ((rc = validate_header(header, &version, &page_size, &page_count, &flags)) != PAGER_OK)
-      goto cleanup;
+/**
+ * @brief Return the frame currently caching page_no, or NULL on a miss.
+ */
+static Frame* pool_lookup(const Pager* p, uint32_t page_no) {
+  uint32_t idx = p->buckets[pool_bucket(p, page_no)];
+  while (idx != FRAME_NONE) {
+    Frame* f = &p->frames[idx];
+    if (f->page_no == page_no)
+      return f;
+    idx = f->hash_next;
+  }
+  return NULL;
+}
 
-    struct stat st;
-    if (fstat(fd, &st) < 0) {
-        rc = PAGER_E_IO;
-        goto cleanup;
-    }
+/**
+ * @brief Link frame `idx` into the bucket of its page_no.
+ */
+static void pool_hash_insert(Pager* p, uint32_t idx) {
+  size_t b = pool_bucket(p, p->frames[idx].page_no);
+  p->frames[idx].hash_next = p->buckets[b];
+  p->buckets[b] = idx;
+}
 
-    if ((uint64_t)page_count > (uint64_t)LLONG_MAX / (uint64_t)page_size) {
-        rc = PAGER_E_META;
-        goto cleanup;
+/**
+ * @brief Unlink frame `idx` from the bucket of its page_no.
+ */
+static void pool_hash_remove(Pager* p, uint32_t idx) {
+  size_t b = pool_bucket(p, p->frames[idx].page_no);
+  uint32_t* link = &p->buckets[b];
+  while (*link != FRAME_NONE) {
+    if (*link == idx) {
+      *link = p->frames[idx].hash_next;
+      p->frames[idx].hash_next = FRAME_NONE;
+      return;
     }
+    link = &p->frames[*link].hash_next;
+  }
+}
 
-    off_t need = (off_t)page_size * (off_t)page_count;
-    off_t filesize = st.st_size;
+// ─────────────────────────────────────────────────────────────────────────────
+// Page checksums (internal), see PAGER_CRC_PAGE_KIND
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Whether a page image carries a checksum (by its kind word).
+ */
+static inline bool page_sealed(const uint8_t* data) {
+  const uint16_t kind = read_le_u16(data);
+  return kind == PAGER_CRC_PAGE_KIND || kind == PAGER_CRC_PACKED_KIND || kind == PAGER_CRC_PAX_KIND;
+}
 
-    if (filesize < need) {
-        rc = PAGER_E_TRUNCATED;
-        goto cleanup;
-    }
+/**
+ * @brief Checksum verdict on a page image: CORRUPT, or UNCHECKED when it
+ *        matches or the page has none.
+ */
+static uint8_t page_verify(const Pager* p, const uint8_t* data) {
+  if (!page_sealed(data))
+    return PAGER_PAGE_UNCHECKED;
+  const size_t body = p->page_size - PAGER_CRC_SIZE;
+  const uint32_t want = read_le_u32(data + body);
+  if (want == 0)
+    return PAGER_PAGE_UNCHECKED;
+  stats_add(STAT_CHECKSUMS, 1);
+  if (crc32c(0, data, body) == want)
+    return PAGER_PAGE_UNCHECKED;
+  stats_add(STAT_CHECKSUM_ERRORS, 1);
+  return PAGER_PAGE_CORRUPT;
+}
 
-    p = calloc(1, sizeof *p);
-    if (!p) {
-        rc = PAGER_E_IO;
-        goto cleanup;
-    }
-    p->fd = fd;
-    fd = -1; // ownership transferred
-    p->page_size = page_size;
-    p->page_count = page_count;
-    *out = p;
+/**
+ * @brief State of an image, checking its checksum if nobody did yet.
+ */
+static uint8_t page_resolve(const Pager* p, _Atomic uint8_t* state, const uint8_t* data) {
+  uint8_t s = *state;
+  if (s != PAGE_STATE_NEW)
+    return s;
+  const uint8_t verdict = page_verify(p, data);
+  // Racing checkers reach the same verdict: keep whichever landed first
+  return atomic_compare_exchange_strong(state, &s, verdict) ? verdict : s;
+}
+
+/**
+ * @brief Stamp the checksum of a frame about to be written out. A corrupt
+ *        image keeps its stale checksum, so that it stays detectable.
+ */
+static void page_seal(const Pager* p, Frame* f) {
+  if (!page_sealed(f->data) || f->state == PAGER_PAGE_CORRUPT)
+    return;
+  const size_t body = p->page_size - PAGER_CRC_SIZE;
+  write_le_u32(f->data + body, crc32c(0, f->data, body));
+}
+
+/**
+ * @brief The file now holds a frame's image: its mapped page (if any) takes
+ *        over the frame's state.
+ */
+static void page_written(Pager* p, const Frame* f) {
+  if (p->map_state && (size_t)f->page_no < p->map_len / p->page_size)
+    p->map_state[f->page_no] = f->state;
+}
+
+/**
+ * @brief Write a dirty frame back to its page in the file, or append it to
+ *        the log (as part of the open transaction) in WAL mode.
+ */
+static int frame_write_back(Pager* p, Frame* f) {
+  if (!f->valid || !f->dirty)
     return PAGER_OK;
 
-cleanup:
-    if (fd >= 0)
-        close(fd);
-    free(p);
+  page_seal(p, f);
+  int rc;
+  if (p->wal) {
+    rc = wal_append(p->wal, f->page_no, f->data, 0);
+  } else {
+    off_t base = (off_t)f->page_no * (off_t)p->page_size;
+    rc = write_full(p->fd, f->data, p->page_size, base);
+    if (rc == PAGER_OK)
+      page_written(p, f);
+  }
+  if (rc != PAGER_OK)
     return rc;
+
+  f->dirty = false;
+  return PAGER_OK;
 }
 
 /**
- * @brief Read a full page by number into out_page_buf.
- *        Guards against out-of-range and arithmetic overflow.
+ * @brief Run a batch of requests on the pager's I/O queue.
  */
-int  pager_read(const Pager* p, uint32_t page_no, void* out_page_buf) {
-  if (!p || !out_page_buf)
-    return PAGER_E_INVAL;
+static int io_run(Pager* p, PioReq* reqs, size_t n) {
+  const uint64_t t0 = stats_start();
+  pthread_mutex_lock(&p->io_lock);
+  int rc = pio_run(p->io, reqs, n);
+  pthread_mutex_unlock(&p->io_lock);
+  if (n > 0) stats_stop(reqs[0].write ? STAT_H_FILE_WRITE : STAT_H_FILE_READ, t0);
+  for (size_t i = 0; i < n; i++) {
+    if (reqs[i].result != PAGER_OK) continue;
+    stats_add(reqs[i].write ? STAT_FILE_WRITES : STAT_FILE_READS, 1);
+    stats_add(reqs[i].write ? STAT_BYTES_WRITTEN : STAT_BYTES_READ, reqs[i].len);
+  }
+  return rc;
+}
 
-  if (page_no >= p->page_count)
-    return PAGER_E_RANGE;
+/**
+ * @brief Write dirty frames back to the file as one batch (no WAL).
+ *        Frames whose write failed stay dirty.
+ */
+static int frames_write_back(Pager* p, Frame** frames, size_t n) {
+  PioReq reqs[PIO_MAX_DEPTH];
+  int first = PAGER_OK;
+  for (size_t at = 0; at < n; at += PIO_MAX_DEPTH) {
+    const size_t k = n - at < PIO_MAX_DEPTH ? n - at : PIO_MAX_DEPTH;
+    for (size_t i = 0; i < k; i++) {
+      Frame* f = frames[at + i];
+      page_seal(p, f);
+      reqs[i] = (PioReq){ .fd = p->fd, .write = true, .buf = f->data, .len = p->page_size,
+                          .off = (off_t)f->page_no * (off_t)p->page_size };
+    }
+    int rc = io_run(p, reqs, k);
+    for (size_t i = 0; i < k; i++)
+      if (reqs[i].result == PAGER_OK) {
+        frames[at + i]->dirty = false;
+        page_written(p, frames[at + i]);
+      }
+    if (rc != PAGER_OK && first == PAGER_OK)
+      first = rc;
+  }
+  return first;
+}
 
-  if ((uint64_t) page_no > (UINT64_MAX / (uint64_t) p->page_size))
-    return PAGER_E_META;
+/**
+ * @brief Pick a victim frame with the CLOCK algorithm.
+ *
+ * Pinned frames are skipped, referenced frames get a second chance. A dirty
+ * victim is written back before being handed out (to the log in WAL mode,
+ * where a transaction's pages wait for its commit frame). The returned
+ * frame is detached from the hash table and marked invalid.
+ *
+ * @return PAGER_OK, PAGER_E_NOFRAME if every frame is pinned, or an I/O error.
+ */
+static int pool_evict(Pager* p, uint32_t* out_idx) {
+  // Two full sweeps: the first may only clear reference bits.
+  for (size_t step = 0; step < 2 * p->frame_count; step++) {
+    uint32_t idx = (uint32_t)p->clock_hand;
+    Frame* f = &p->frames[idx];
+    p->clock_hand = (p->clock_hand + 1) % p->frame_count;
+
+    if (f->pin_count > 0)
+      continue;
+
+    if (f->valid && f->ref) {
+      f->ref = false;
+      continue;
+    }
 
-  off_t base = (off_t)page_no * (off_t)p->page_size;
+    if (f->valid) {
+      int rc = frame_write_back(p, f);
+      if (rc != PAGER_OK)
+        return rc;
+      pool_hash_remove(p, idx);
+      f->valid = false;
+      stats_add(STAT_EVICTIONS, 1);
+    }
 
-  return read_full(p->fd, out_page_buf, p->page_size, base);
+    *out_idx = idx;
+    return PAGER_OK;
+  }
+  return PAGER_E_NOFRAME;
 }
 
-int pager_write(const Pager* p, uint32_t page_no, const void* page_buf) {
-  if (!p || !page_buf)
-    return PAGER_E_INVAL;
+// ─────────────────────────────────────────────────────────────────────────────
+// File mapping (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Return the mapped address of page_no, or NULL if it is not mapped.
+ *        A page with a newer image in the log is never served from the file.
+ */
+static inline const uint8_t* map_page(const Pager* p, uint32_t page_no) {
+  if (!p->map || wal_find(p->wal, page_no, NULL))
+    return NULL;
+  uint64_t end = ((uint64_t)page_no + 1u) * (uint64_t)p->page_size;
+  if (end > (uint64_t)p->map_len)
+    return NULL;
+  return p->map + (size_t)page_no * p->page_size;
+}
 
-      if ((uint64_t) page_no > (UINT64_MAX / (uint64_t) p->page_size))
-    return PAGER_E_META;
+/**
+ * @brief Map every page of a read-only pager, once at open: its page_count
+ *        never changes, so the mapping never has to grow or move. A failing
+ *        mmap simply leaves the pager in pread mode.
+ */
+static void map_open(Pager* p) {
+  const size_t len = (size_t)p->page_count * p->page_size;
+  if (!p->use_mmap || len == 0)
+    return;
 
-  off_t base = (off_t)page_no * (off_t)p->page_size;
+  // Every mapped page gets its checksum checked once
+  _Atomic uint8_t* state = malloc(len / p->page_size);
+  if (!state)
+    return;
+  for (size_t i = 0; i < len / p->page_size; i++)
+    atomic_init(&state[i], PAGE_STATE_NEW);
 
-  if (page_no >= p->page_count)
-    return PAGER_E_RANGE;
+  void* m = mmap(NULL, len, PROT_READ, MAP_SHARED, p->fd, 0);
+  if (m == MAP_FAILED) {
+    free(state);
+    return;
+  }
 
-  return write_full(p->fd, page_buf, p->page_size, base);
+  p->map = (uint8_t*)m;
+  p->map_len = len;
+  p->map_state = state;
 }
 
-int pager_alloc_page(Pager* p, uint32_t* out_page_no){
-  if (!p || !out_page_no)
-    return PAGER_E_INVAL;
+/**
+ * @brief Drop the mapping (pager_close).
+ */
+static void map_release(Pager* p) {
+  if (p->map)
+    munmap(p->map, p->map_len);
+  free(p->map_state);
+  p->map = NULL;
+  p->map_len = 0;
+  p->map_state = NULL;
+}
 
-  if (p->page_count == UINT32_MAX)
-    return PAGER_E_META;
+// ─────────────────────────────────────────────────────────────────────────────
+// Sequential read-ahead (internal, p->lock held)
+// ─────────────────────────────────────────────────────────────────────────────
+/* Misses of the calling thread on one pager. A miss just past the previous
+ * one continues the run; anything else starts a new one. */
+typedef struct SeqRun {
+  const Pager* p;
+  PagerAccess  access;
+  uint32_t     last;          // page of the previous miss
+  uint32_t     run;           // forward misses in a row
+  uint32_t     advised_end;   // read-ahead announced up to here (exclusive)
+} SeqRun;
 
-  uint32_t new_no = p->page_count;
+static _Thread_local SeqRun t_seq;
 
-  uint64_t result  = (uint64_t)new_no * (uint64_t) p->page_size;
+static SeqRun* seq_run(const Pager* p) {
+  if (t_seq.p != p)
+    t_seq = (SeqRun){ .p = p };
+  return &t_seq;
+}
 
-  if (result > (uint64_t)INT64_MAX ||
-      result + p->page_size > (uint64_t) INT64_MAX)
-    return PAGER_E_META;
+/**
+ * @brief Record a miss on page_no and return how many pages to announce
+ *        from *from on (0 = none): the next window of a sequential run,
+ *        once the reader is halfway through the previous one.
+ */
+static uint32_t seq_miss(Pager* p, uint32_t page_no, uint32_t* from) {
+  if (p->readahead == 0)
+    return 0;
+  SeqRun* s = seq_run(p);
+  if (s->access == PAGER_ACCESS_RANDOM)
+    return 0;
 
-  uint8_t *buffer = calloc(1, sizeof(uint8_t) * p->page_size);
-  if (!buffer)
-    return PAGER_E_IO;
+  if (s->run > 0 && page_no > s->last && page_no - s->last <= SEQ_MAX_GAP) {
+    s->run++;
+  } else {
+    s->run = 1;
+    s->advised_end = 0;
+  }
+  s->last = page_no;
+  if (s->run < PAGER_SEQ_TRIGGER && s->access != PAGER_ACCESS_SEQUENTIAL)
+    return 0;
+  if (s->advised_end > page_no && s->advised_end - page_no > p->readahead / 2)
+    return 0;
+
+  const uint32_t start = page_no + 1 > s->advised_end ? page_no + 1 : s->advised_end;
+  uint32_t end = p->page_count;
+  if (end - page_no > p->readahead)
+    end = page_no + 1 + p->readahead;
+  if (start >= end)
+    return 0;
+  s->advised_end = end;
+  p->readahead_pages += end - start;
+  stats_add(STAT_READAHEAD_PAGES, end - start);
+  *from = start;
+  return end - start;
+}
 
-  off_t base_offset = (off_t)new_no * (off_t)p->page_size;
-  uint8_t hdr_count[4];
+/**
+ * @brief Announce pages [from, from + n) to the kernel: through the mapping
+ *        `map` (map_len bytes) when given, else through the file. Advice
+ *        only, so failures are ignored.
+ */
+static void seq_advise(const Pager* p, const uint8_t* map, size_t map_len,
+                       uint32_t from, uint32_t n) {
+  const size_t off = (size_t)from * p->page_size;
+  size_t len = (size_t)n * p->page_size;
+  if (map) {
+    if (off >= map_len)
+      return;
+    if (len > map_len - off)
+      len = map_len - off;
+    (void)posix_madvise((void*)(map + off), len, POSIX_MADV_WILLNEED);
+  } else {
+    (void)posix_fadvise(p->fd, (off_t)off, (off_t)len, POSIX_FADV_WILLNEED);
+  }
+}
 
-  int rc = write_full(p->fd, buffer, p->page_size, base_offset);
-  if (rc != PAGER_OK) {
-    free(buffer);
+/**
+ * @brief Pin the frame caching page_no, faulting it in on a miss.
+ *
+ * Called with p->lock held. A read from the database file drops the lock
+ * while it runs (the frame is marked `loading`, other threads asking for the
+ * same page wait for it); log and mapping copies stay under the lock since a
+ * checkpoint could move the log's.
+ *
+ * @param load When false the caller is about to overwrite the whole page, so
+ *             a miss does not read the old image from disk.
+ */
+static int pool_fetch(Pager* p, uint32_t page_no, bool load, Frame** out) {
+  Frame* f;
+  while ((f = pool_lookup(p, page_no)) != NULL) {
+    f->pin_count++;
+    f->ref = true;
+    while (f->loading)
+      pthread_cond_wait(&p->latch_cv, &p->lock);
+    if (f->valid && f->page_no == page_no) {
+      stats_add(STAT_CACHE_HITS, 1);
+      *out = f;
+      return PAGER_OK;
+    }
+    f->pin_count--;   // its load failed: look again
+  }
+  if (load)
+    stats_add(STAT_CACHE_MISSES, 1);
+
+  uint32_t idx = 0;
+  int rc = pool_evict(p, &idx);
+  if (rc != PAGER_OK)
     return rc;
+
+  f = &p->frames[idx];
+  f->page_no   = page_no;
+  f->pin_count = 1;
+  f->valid     = true;
+  f->dirty     = false;
+  f->ref       = true;
+  f->state     = load ? PAGE_STATE_NEW : PAGER_PAGE_UNCHECKED;
+  pool_hash_insert(p, idx);
+
+  uint32_t wal_frame = 0;
+  if (load && wal_find(p->wal, page_no, &wal_frame)) {
+    rc = wal_read_frame(p->wal, wal_frame, f->data);
+  } else if (load) {
+    const uint8_t* mapped = map_page(p, page_no);
+    if (mapped) {
+      memcpy(f->data, mapped, p->page_size);
+    } else {
+      off_t base = (off_t)page_no * (off_t)p->page_size;
+      uint32_t ra_from = 0;
+      const uint32_t ra = seq_miss(p, page_no, &ra_from);
+      f->loading = true;
+      pthread_mutex_unlock(&p->lock);
+      if (ra)
+        seq_advise(p, NULL, 0, ra_from, ra);
+      rc = read_full(p->fd, f->data, p->page_size, base);
+      pthread_mutex_lock(&p->lock);
+      f->loading = false;
+      pthread_cond_broadcast(&p->latch_cv);
+    }
   }
-  p->page_count = p->page_count + 1;
-  write_le_u32(hdr_count, p->page_count);
 
-  rc = write_full(p->fd, hdr_count, 4, HDR_PAGECOUNT_OFF);
   if (rc != PAGER_OK) {
-    free(buffer);
+    pool_hash_remove(p, idx);
+    f->valid = false;
+    f->pin_count--;
     return rc;
   }
+  *out = f;
+  return PAGER_OK;
+}
+
+/**
+ * @brief Drop one pin on a frame, recording whether the caller modified it.
+ */
+static inline void pool_release(Frame* f, bool dirty) {
+  if (dirty)
+    f->dirty = true;
+  if (f->pin_count > 0)
+    f->pin_count--;
+}
 
-  free(buffer);
+/**
+ * @brief Take / drop the pager lock around one read-side entry point.
+ */
+static inline void pager_lock(Pager* p)   { pthread_mutex_lock(&p->lock); }
+static inline void pager_unlock(Pager* p) { pthread_mutex_unlock(&p->lock); }
 
-  *out_page_no = new_no;
-  return PAGER_OK;
+// ─────────────────────────────────────────────────────────────────────────────
+// Page latches (internal, p->lock held)
+// ─────────────────────────────────────────────────────────────────────────────
+#define PAGER_MAX_HELD_LATCHES  64   // distinct pages one thread may share at once
+
+/* Shared latches held by the calling thread, so that it can re-pin a page it
+ * already shares and upgrade it without waiting for itself. */
+typedef struct HeldLatch {
+  const Frame* f;
+  uint32_t     n;    // 0 = free slot
+} HeldLatch;
+
+static _Thread_local HeldLatch t_held[PAGER_MAX_HELD_LATCHES];
+static _Thread_local size_t    t_held_used;   // slots ever used (high-water mark)
+
+static HeldLatch* held_find(const Frame* f, bool add) {
+  HeldLatch* free_slot = NULL;
+  for (size_t i = 0; i < t_held_used; i++) {
+    if (t_held[i].n > 0 && t_held[i].f == f)
+      return &t_held[i];
+    if (t_held[i].n == 0 && !free_slot)
+      free_slot = &t_held[i];
+  }
+  if (!add)
+    return NULL;
+  if (!free_slot && t_held_used < PAGER_MAX_HELD_LATCHES)
+    free_slot = &t_held[t_held_used++];
+  if (free_slot)
+    free_slot->f = f;
+  return free_slot;
 }
 
+static inline bool latch_owned(const Frame* f) {
+  return f->excl_depth > 0 && pthread_equal(f->owner, pthread_self());
+}
 
 /**
- * @brief Return the page size used by this Pager.
+ * @brief Take the shared latch of a pinned frame.
+ *        Waiting writers go first, unless this thread already shares it.
  */
-size_t pager_page_size(const Pager* p) {
-  return p ? p->page_size : 0;
+static int latch_shared(Pager* p, Frame* f) {
+  if (latch_owned(f)) {
+    f->excl_depth++;
+    return PAGER_OK;
+  }
+  HeldLatch* h = held_find(f, true);
+  if (!h)
+    return PAGER_E_INVAL;
+  while (f->excl_depth > 0 || (f->excl_waiting > 0 && h->n == 0))
+    pthread_cond_wait(&p->latch_cv, &p->lock);
+  f->readers++;
+  h->n++;
+  return PAGER_OK;
 }
 
+/**
+ * @brief Take the exclusive latch of a pinned frame (reentrant for its owner).
+ */
+static void latch_exclusive(Pager* p, Frame* f) {
+  if (latch_owned(f)) {
+    f->excl_depth++;
+    return;
+  }
+  const HeldLatch* h = held_find(f, false);
+  const uint32_t mine = h ? h->n : 0;
+  f->excl_waiting++;
+  while (f->excl_depth > 0 || f->readers > mine)
+    pthread_cond_wait(&p->latch_cv, &p->lock);
+  f->excl_waiting--;
+  f->owner = pthread_self();
+  f->excl_depth = 1;
+}
 
 /**
- * @brief Return the number of pages in the file.
+ * @brief Drop one latch of the calling thread on a frame (shared ones first,
+ *        so that an upgraded page stays exclusive until its last release).
  */
-uint32_t pager_page_count(const Pager* p) {
-  return p ? p->page_count : 0;
+static int latch_release(Pager* p, Frame* f) {
+  HeldLatch* h = held_find(f, false);
+  if (h) {
+    h->n--;
+    f->readers--;
+  } else if (latch_owned(f)) {
+    f->excl_depth--;
+  } else {
+    return PAGER_E_INVAL;
+  }
+  pthread_cond_broadcast(&p->latch_cv);
+  return PAGER_OK;
 }
 
 /**
- * @brief Close the Pager and free resources.
+ * @brief Wait until no other thread holds a frame exclusively, so that its
+ *        image can be written out (flush / commit).
  */
-void pager_close(Pager* p) {
-    if (!p) return;
-    close(p->fd);
+static void latch_quiesce(Pager* p, Frame* f) {
+  while (f->valid && f->excl_depth > 0 && !latch_owned(f))
+    pthread_cond_wait(&p->latch_cv, &p->lock);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Snapshots (internal, p->lock held)
+// ─────────────────────────────────────────────────────────────────────────────
+/* Snapshot the calling thread reads through, and the page copies it pins
+ * (pager_unpin finds them here, as latches are found in t_held). */
+static _Thread_local PagerSnapshot* t_snap;
+static _Thread_local const Pager*   t_snap_pager;
+typedef struct VersionPin {
+  const Pager*   p;
+  PageVersion*   v;
+  const uint8_t* data;     // v->data (NULL = free slot)
+} VersionPin;
+
+static _Thread_local VersionPin t_vpins[PAGER_MAX_HELD_LATCHES];
+
+static inline PagerSnapshot* snap_of(const Pager* p) {
+  return t_snap_pager == p ? t_snap : NULL;
+}
+
+/**
+ * @brief Whether the calling thread may not change pages: the pager is
+ *        read-only, or the thread is bound to a snapshot.
+ */
+static inline bool writes_refused(const Pager* p) {
+  return p->read_only || snap_of(p);
+}
+
+static inline bool write_owned(const Pager* p) {
+  return p->write_depth > 0 && pthread_equal(p->writer, pthread_self());
+}
+
+/**
+ * @brief Snapshot the calling thread reads through: its own, or while a
+ *        transaction is open in another thread, the transaction's, so that
+ *        uncommitted pages stay out of sight (p->lock held).
+ */
+static inline const PagerSnapshot* read_snap(const Pager* p) {
+  const PagerSnapshot* s = snap_of(p);
+  return s || write_owned(p) ? s : p->txn_snap;
+}
+
+static PageVersion* version_find(const Pager* p, uint32_t page_no, uint64_t seq) {
+  if (!p->versions)
+    return NULL;
+  for (PageVersion* v = p->versions[page_no & p->version_mask]; v; v = v->next)
+    if (v->page_no == page_no && v->from < seq && seq <= v->until)
+      return v;
+  return NULL;
+}
+
+/**
+ * @brief Sequence the live image of a page dates from, as far as its copies
+ *        tell (0 when it has none). Changes made while no snapshot could see
+ *        them leave no trace, which only ever makes this older.
+ */
+static uint64_t version_newest(const Pager* p, uint32_t page_no) {
+  uint64_t newest = 0;
+  if (p->versions)
+    for (const PageVersion* v = p->versions[page_no & p->version_mask]; v; v = v->next)
+      if (v->page_no == page_no && v->until > newest)
+        newest = v->until;
+  return newest;
+}
+
+/**
+ * @brief Whether an active snapshot sees the live image of a page, so that
+ *        changing it requires a copy first.
+ */
+static inline bool snap_needs(const Pager* p, uint32_t page_no) {
+  return p->snapshots && p->snapshots->seq > version_newest(p, page_no);
+}
+
+/**
+ * @brief Copy a page image aside before it changes, if a snapshot needs it.
+ * @return PAGER_OK, or PAGER_E_IO when out of memory (the change must not
+ *         go ahead).
+ */
+static int version_save(Pager* p, uint32_t page_no, const uint8_t* data, uint8_t state) {
+  if (!snap_needs(p, page_no))
+    return PAGER_OK;
+
+  if (!p->versions) {
+    size_t buckets = 64;
+    while (buckets < p->frame_count)
+      buckets *= 2;
+    p->versions = calloc(buckets, sizeof *p->versions);
+    if (!p->versions)
+      return PAGER_E_IO;
+    p->version_mask = buckets - 1;
+  }
+
+  PageVersion* v = p->version_spare;
+  if (v)
+    p->version_spare = v->next;
+  else if (!(v = malloc(sizeof *v)))
+    return PAGER_E_IO;
+  v->data = slab_get(p);
+  if (!v->data) {
+    v->next = p->version_spare;
+    p->version_spare = v;
+    return PAGER_E_IO;
+  }
+  v->page_no = page_no;
+  v->pins    = 0;
+  v->from    = version_newest(p, page_no);
+  v->until   = p->snap_seq;
+  atomic_init(&v->state, state == PAGE_STATE_NEW ? PAGER_PAGE_UNCHECKED : state);
+  memcpy(v->data, data, p->page_size);
+
+  PageVersion** head = &p->versions[page_no & p->version_mask];
+  v->next = *head;
+  *head = v;
+  p->version_count++;
+  return PAGER_OK;
+}
+
+/**
+ * @brief Drop the copies no active snapshot sees (all of them with `all`,
+ *        at close). Pinned copies stay until a later pass.
+ */
+static void version_gc(Pager* p, bool all) {
+  if (!p->versions)
+    return;
+  for (size_t b = 0; b <= p->version_mask; b++) {
+    PageVersion** at = &p->versions[b];
+    while (*at) {
+      PageVersion* v = *at;
+      bool keep = !all && v->pins > 0;
+      for (const PagerSnapshot* s = all ? NULL : p->snapshots; s && !keep; s = s->next)
+        keep = v->from < s->seq && s->seq <= v->until;
+      if (keep) {
+        at = &v->next;
+        continue;
+      }
+      *at = v->next;
+      slab_put(p, v->data);
+      v->next = p->version_spare;
+      p->version_spare = v;
+      p->version_count--;
+    }
+  }
+}
+
+/**
+ * @brief Pin a copy for the calling thread.
+ */
+static int version_pin(const Pager* p, PageVersion* v, const void** out) {
+  for (size_t i = 0; i < PAGER_MAX_HELD_LATCHES; i++) {
+    if (!t_vpins[i].data) {
+      t_vpins[i] = (VersionPin){ .p = p, .v = v, .data = v->data };
+      v->pins++;
+      *out = v->data;
+      return PAGER_OK;
+    }
+  }
+  return PAGER_E_INVAL;
+}
+
+/**
+ * @brief The calling thread's pin of the copy at `page` on `p`, or NULL.
+ */
+static VersionPin* version_pinned(const Pager* p, const void* page) {
+  for (size_t i = 0; i < PAGER_MAX_HELD_LATCHES; i++)
+    if (t_vpins[i].data == page && t_vpins[i].p == p)
+      return &t_vpins[i];
+  return NULL;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Write-ahead log (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Replay "<path>-wal" into the database file.
+ *
+ * Runs before the header is validated, so that the header page itself is
+ * the committed one (only its page_size, which never changes, is read
+ * first). With keep == true the (now empty) log stays open for writing and
+ * is returned in *out; otherwise it is removed.
+ */
+/**
+ * @brief "<path>-wal", malloc'ed (NULL when out of memory).
+ */
+static char* wal_path_of(const char* path) {
+  size_t len = strlen(path);
+  char* wal_path = malloc(len + sizeof "-wal");
+  if (!wal_path)
+    return NULL;
+  memcpy(wal_path, path, len);
+  memcpy(wal_path + len, "-wal", sizeof "-wal");
+  return wal_path;
+}
+
+/**
+ * @brief Check that no log is waiting to be replayed into the file, for a
+ *        read-only open, which must not write: PAGER_E_RECOVERY if one is.
+ */
+static int wal_check_clean(const char* path) {
+  char* wal_path = wal_path_of(path);
+  if (!wal_path)
+    return PAGER_E_IO;
+  struct stat st;
+  const bool pending = stat(wal_path, &st) == 0 && st.st_size > 0;
+  free(wal_path);
+  return pending ? PAGER_E_RECOVERY : PAGER_OK;
+}
+
+static int wal_attach(const char* path, int db_fd, size_t page_size, bool keep, Wal** out) {
+  *out = NULL;
+
+  char* wal_path = wal_path_of(path);
+  if (!wal_path)
+    return PAGER_E_IO;
+
+  struct stat st;
+  if (!keep && stat(wal_path, &st) != 0) {
+    free(wal_path);
+    return PAGER_OK;   // direct mode, nothing to recover
+  }
+
+  Wal* w = NULL;
+  int rc = wal_open(wal_path, page_size, &w);
+  free(wal_path);
+  if (rc != PAGER_OK)
+    return rc;
+
+  if ((rc = wal_checkpoint(w, db_fd)) != PAGER_OK) {
+    wal_close(w, false);
+    return rc;
+  }
+
+  if (keep)
+    *out = w;
+  else
+    wal_close(w, true);
+  return PAGER_OK;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Open and validate a MiniDB file, returning an opaque Pager handle.
+ */
+int pager_open(const char* path, Pager** out) {
+    return pager_open_ex(path, NULL, out);
+}
+
+/**
+ * @brief Open a MiniDB file with explicit configuration (buffer pool size).
+ */
+int pager_open_ex(const char* path, const PagerConfig* cfg, Pager** out) {
+    int rc = PAGER_OK;
+    int fd = -1;
+    Pager *p = NULL;
+    Wal *wal = NULL;
+    uint8_t header[PAGER_HDR_SIZE];
+
+    if (!path || !out)
+        return PAGER_E_INVAL;
+
+    *out = NULL;
+
+    size_t cache_pages = PAGER_DEFAULT_CACHE_PAGES;
+    if (cfg && cfg->cache_pages != 0) {
+        if (cfg->cache_pages < PAGER_MIN_CACHE_PAGES)
+            return PAGER_E_INVAL;
+        cache_pages = cfg->cache_pages;
+    }
+
+    const uint32_t new_page_size = (cfg && cfg->page_size) ? cfg->page_size : PAGER_PAGE_SIZE;
+    if (!page_size_ok(new_page_size))
+        return PAGER_E_PAGESIZE;
+
+    const unsigned io_depth = (cfg && cfg->io_depth) ? cfg->io_depth : PAGER_DEFAULT_IO_DEPTH;
+    if (io_depth > PIO_MAX_DEPTH)
+        return PAGER_E_INVAL;
+
+    // Mapped pins carry no latch: only a file nobody writes through this
+    // pager may be mapped
+    const bool read_only = cfg && cfg->read_only;
+    if (cfg && ((cfg->use_mmap && !read_only) || (cfg->wal && read_only)))
+        return PAGER_E_INVAL;
+
+    fd = read_only ? open(path, O_RDONLY) : open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+
+    {
+      struct stat st0;
+      if (fstat(fd, &st0) < 0) {
+        rc = PAGER_E_IO;
+        goto cleanup;
+      }
+      if (st0.st_size == 0 && read_only) {
+        rc = PAGER_E_TRUNCATED;
+        goto cleanup;
+      }
+      if (st0.st_size == 0) {
+        uint8_t init_hdr[PAGER_HDR_SIZE];
+        memcpy(init_hdr + HDR_MAGIC_OFF, FILE_MAGIC, FILE_MAGIC_LEN);
+        write_le_u32(init_hdr + HDR_VERSION_OFF, FILE_VERSION);
+        write_le_u32(init_hdr + HDR_PAGESIZE_OFF, new_page_size);
+        write_le_u32(init_hdr + HDR_PAGECOUNT_OFF, 1u);
+        write_le_u32(init_hdr + HDR_FLAGS_OFF, 0u);
+        write_le_u32(init_hdr + HDR_CATALOG_OFF, 0u);
+        write_le_u32(init_hdr + HDR_FREELIST_OFF, 0u);
+        write_le_u32(init_hdr + HDR_FREECOUNT_OFF, 0u);
+
+        rc = write_full(fd, init_hdr, PAGER_HDR_SIZE, 0);
+        if (rc != PAGER_OK) {
+          goto cleanup;
+        }
+
+        if (ftruncate(fd, (off_t)new_page_size) != 0) {
+          rc = PAGER_E_IO;
+          goto cleanup;
+        }
+      }
+    }
+
+    // The log's frames are pages of the file's own size: read it first
+    uint32_t file_page_size = 0;
+    rc = read_full(fd, header, PAGER_HDR_SIZE, 0);
+    if (rc != PAGER_OK)
+        goto cleanup;
+    if ((rc = validate_header(header, NULL, &file_page_size, NULL, NULL)) != PAGER_OK)
+        goto cleanup;
+
+    // A log left behind is replayed into the file, which a read-only open
+    // cannot do: it refuses the file until a writable open has recovered it
+    rc = read_only ? wal_check_clean(path)
+                   : wal_attach(path, fd, file_page_size, cfg && cfg->wal, &wal);
+    if (rc != PAGER_OK)
+        goto cleanup;
+
+    rc = read_full(fd, header, PAGER_HDR_SIZE, 0);
+    if (rc != PAGER_OK)
+        goto cleanup;
+
+    uint32_t version    = 0;
+    uint32_t page_size  = 0;
+    uint32_t page_count = 0;
+    uint32_t flags      = 0;
+
+    if ((rc = validate_header(header, &version, &page_size, &page_count, &flags)) != PAGER_OK)
+      goto cleanup;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+
+    if ((uint64_t)page_count > (uint64_t)LLONG_MAX / (uint64_t)page_size) {
+        rc = PAGER_E_META;
+        goto cleanup;
+    }
+
+    off_t need = (off_t)page_size * (off_t)page_count;
+    off_t filesize = st.st_size;
+
+    if (filesize < need) {
+        rc = PAGER_E_TRUNCATED;
+        goto cleanup;
+    }
+
+    const uint32_t free_head  = read_le_u32(header + HDR_FREELIST_OFF);
+    const uint32_t free_count = read_le_u32(header + HDR_FREECOUNT_OFF);
+    if (free_head >= page_count || free_count >= page_count || (free_head == 0) != (free_count == 0)) {
+        rc = PAGER_E_META;
+        goto cleanup;
+    }
+
+    p = calloc(1, sizeof *p);
+    if (!p) {
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+    p->page_size = page_size;
+    p->version = version;
+    p->page_count = page_count;
+    p->catalog = read_le_u32(header + HDR_CATALOG_OFF);
+    p->free_head = free_head;
+    p->free_count = free_count;
+    p->file_size = filesize;
+    if (pthread_mutex_init(&p->lock, NULL) != 0) {
+        free(p);
+        p = NULL;
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+    if (pthread_cond_init(&p->latch_cv, NULL) != 0) {
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        p = NULL;
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+    if (pthread_mutex_init(&p->io_lock, NULL) != 0) {
+        pthread_cond_destroy(&p->latch_cv);
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        p = NULL;
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+    if (pthread_mutex_init(&p->slab_lock, NULL) != 0) {
+        pthread_mutex_destroy(&p->io_lock);
+        pthread_cond_destroy(&p->latch_cv);
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        p = NULL;
+        rc = PAGER_E_IO;
+        goto cleanup;
+    }
+
+    // An unavailable backend degrades to plain pread / pwrite
+    if (pio_open(cfg ? cfg->io_backend : PIO_BACKEND_AUTO, io_depth, &p->io) != PAGER_OK &&
+        (rc = pio_open(PIO_BACKEND_SYNC, 1, &p->io)) != PAGER_OK)
+        goto cleanup;
+    p->io_depth = pio_depth(p->io);
+    p->paranoid = cfg && cfg->paranoid;
+    p->readahead = PAGER_DEFAULT_READAHEAD;
+    if (cfg && cfg->readahead)
+        p->readahead = cfg->readahead == PAGER_READAHEAD_OFF ? 0 : cfg->readahead;
+
+    if ((rc = pool_init(p, cache_pages)) != PAGER_OK)
+        goto cleanup;
+
+    p->fd = fd;
+    fd = -1; // ownership transferred
+
+    p->wal = wal;
+    wal = NULL;
+    p->group_commit = (cfg && cfg->wal_group_commit) ? cfg->wal_group_commit
+                                                     : PAGER_DEFAULT_GROUP_COMMIT;
+    p->autocheckpoint = (cfg && cfg->wal_autocheckpoint) ? cfg->wal_autocheckpoint
+                                                         : PAGER_DEFAULT_AUTOCHECKPOINT;
+
+    p->read_only = read_only;
+    p->use_mmap = cfg && cfg->use_mmap;
+    map_open(p);
+
+    *out = p;
+    return PAGER_OK;
+
+cleanup:
+    wal_close(wal, false);
+    if (fd >= 0)
+        close(fd);
+    if (p) {
+        pool_free(p);
+        pio_close(p->io);
+        pthread_mutex_destroy(&p->slab_lock);
+        pthread_mutex_destroy(&p->io_lock);
+        pthread_cond_destroy(&p->latch_cv);
+        pthread_mutex_destroy(&p->lock);
+    }
+    free(p);
+    return rc;
+}
+
+/**
+ * @brief Read a full page by number into out_page_buf.
+ *        Guards against out-of-range and arithmetic overflow.
+ *        Served from the buffer pool; only a miss touches the file.
+ */
+static int read_page(Pager* p, uint32_t page_no, void* out_page_buf) {
+  if (page_no >= p->page_count)
+    return PAGER_E_RANGE;
+
+  if ((uint64_t) page_no > (UINT64_MAX / (uint64_t) p->page_size))
+    return PAGER_E_META;
+
+  // Mapped and not held in the pool: copy straight from the mapping
+  if (!pool_lookup(p, page_no)) {
+    const uint8_t* mapped = map_page(p, page_no);
+    if (mapped) {
+      memcpy(out_page_buf, mapped, p->page_size);
+      return PAGER_OK;
+    }
+  }
+
+  Frame* f = NULL;
+  int rc = pool_fetch(p, page_no, true, &f);
+  if (rc != PAGER_OK)
+    return rc;
+
+  // The copy must not overlap a writer holding the page
+  if ((rc = latch_shared(p, f)) == PAGER_OK) {
+    memcpy(out_page_buf, f->data, p->page_size);
+    latch_release(p, f);
+  }
+  pool_release(f, false);
+  return rc;
+}
+
+static int snap_pin(Pager* p, const PagerSnapshot* s, uint32_t page_no, const void** out);
+static int unpin_page(Pager* p, const void* page, bool dirty);
+
+int pager_read(Pager* p, uint32_t page_no, void* out_page_buf) {
+  if (!p || !out_page_buf)
+    return PAGER_E_INVAL;
+  stats_add(STAT_PAGE_READS, 1);
+
+  pager_lock(p);
+  int rc;
+  const PagerSnapshot* snap = read_snap(p);
+  if (snap) {
+    const void* page = NULL;
+    if ((rc = snap_pin(p, snap, page_no, &page)) == PAGER_OK) {
+      memcpy(out_page_buf, page, p->page_size);
+      (void)unpin_page(p, page, false);
+    }
+  } else {
+    rc = read_page(p, page_no, out_page_buf);
+  }
+  pager_unlock(p);
+  return rc;
+}
+
+/**
+ * @brief Copy a full page into its cached frame and mark it dirty.
+ *        The page reaches the file on eviction, pager_flush or pager_close.
+ */
+static int write_page(Pager* p, uint32_t page_no, const void* page_buf) {
+  if ((uint64_t) page_no > (UINT64_MAX / (uint64_t) p->page_size))
+    return PAGER_E_META;
+
+  if (page_no >= p->page_count)
+    return PAGER_E_RANGE;
+
+  // Whole-page overwrite: no need to fault the old image in on a miss,
+  // unless a snapshot still sees it
+  Frame* f = NULL;
+  const bool keep = snap_needs(p, page_no);
+  int rc = pool_fetch(p, page_no, keep, &f);
+  if (rc != PAGER_OK)
+    return rc;
+
+  latch_exclusive(p, f);
+  if (keep && (rc = version_save(p, page_no, f->data, page_resolve(p, &f->state, f->data))) != PAGER_OK) {
+    latch_release(p, f);
+    pool_release(f, false);
+    return rc;
+  }
+  memcpy(f->data, page_buf, p->page_size);
+  f->state = PAGER_PAGE_UNCHECKED;
+  latch_release(p, f);
+  pool_release(f, true);
+  return PAGER_OK;
+}
+
+int pager_write(Pager* p, uint32_t page_no, const void* page_buf) {
+  if (!p || !page_buf)
+    return PAGER_E_INVAL;
+  if (writes_refused(p))
+    return PAGER_E_READONLY;
+  stats_add(STAT_PAGE_WRITES, 1);
+
+  pager_lock(p);
+  int rc = write_page(p, page_no, page_buf);
+  pager_unlock(p);
+  return rc;
+}
+
+/**
+ * @brief Map a pointer handed out by pager_pin*() back to its frame.
+ * @return The frame, or NULL if `page` is not the start of a pool frame.
+ */
+static Frame* frame_of(const Pager* p, const void* page) {
+  const uint8_t* ptr = (const uint8_t*)page;
+  if (ptr < p->pool || ptr >= p->pool + p->frame_count * p->page_size)
+    return NULL;
+
+  size_t off = (size_t)(ptr - p->pool);
+  if (off % p->page_size != 0)
+    return NULL;
+
+  return &p->frames[off / p->page_size];
+}
+
+/**
+ * @brief Shared argument checks + pin and latch for the pager_pin* calls.
+ *
+ * The latch is taken after the pin, so the frame cannot be evicted while
+ * this thread waits for it.
+ *
+ * @param load       false: the page is rewritten from scratch (pager_pin_zero).
+ * @param exclusive  Latch mode.
+ */
+static int pin_page(Pager* p, uint32_t page_no, bool load, bool exclusive, uint8_t** out) {
+  *out = NULL;
+
+  if (exclusive && writes_refused(p))
+    return PAGER_E_READONLY;
+  if (page_no >= p->page_count)
+    return PAGER_E_RANGE;
+
+  // A snapshot that sees the old image needs it even when the caller does not
+  if (exclusive && !load && snap_needs(p, page_no))
+    load = true;
+
+  Frame* f = NULL;
+  int rc = pool_fetch(p, page_no, load, &f);
+  if (rc != PAGER_OK)
+    return rc;
+
+  if (exclusive) {
+    latch_exclusive(p, f);
+    // Check the image before the caller changes it (see pager_page_state),
+    // and copy it aside for the snapshots that still see it
+    const uint8_t state = page_resolve(p, &f->state, f->data);
+    if (load && (rc = version_save(p, page_no, f->data, state)) != PAGER_OK) {
+      latch_release(p, f);
+      pool_release(f, false);
+      return rc;
+    }
+  } else if ((rc = latch_shared(p, f)) != PAGER_OK) {
+    pool_release(f, false);
+    return rc;
+  }
+
+  *out = f->data;
+  return PAGER_OK;
+}
+
+/**
+ * @brief pager_pin() for a thread bound to snapshot `s`: its copy of the
+ *        page if the page changed since `s` began, else the live frame
+ *        (never the mapping, which changes under the pin on write-back).
+ */
+static int snap_pin(Pager* p, const PagerSnapshot* s, uint32_t page_no, const void** out) {
+  *out = NULL;
+  PageVersion* v = version_find(p, page_no, s->seq);
+  if (!v) {
+    uint8_t* data = NULL;
+    int rc = pin_page(p, page_no, true, false, &data);
+    if (rc != PAGER_OK)
+      return rc;
+    // A writer may have taken the page while this thread waited for its latch
+    if ((v = version_find(p, page_no, s->seq)) == NULL) {
+      *out = data;
+      return PAGER_OK;
+    }
+    (void)unpin_page(p, data, false);
+  }
+  return version_pin(p, v, out);
+}
+
+int pager_pin(Pager* p, uint32_t page_no, const void** out_page) {
+  if (!p || !out_page)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  const PagerSnapshot* snap = read_snap(p);
+  if (snap) {
+    int rc = snap_pin(p, snap, page_no, out_page);
+    pager_unlock(p);
+    return rc;
+  }
+  // Read-only pins of pages not held in the pool come from the mapping
+  if (page_no < p->page_count && p->use_mmap && !pool_lookup(p, page_no)) {
+    const uint8_t* mapped = map_page(p, page_no);
+    if (mapped) {
+      // The pin keeps the mapping in place while the lock is dropped
+      p->map_pins++;
+      *out_page = mapped;
+      const uint8_t* map = p->map;
+      const size_t map_len = p->map_len;
+      uint32_t ra_from = 0;
+      const uint32_t ra = seq_miss(p, page_no, &ra_from);
+      pager_unlock(p);
+      if (ra)
+        seq_advise(p, map, map_len, ra_from, ra);
+      return PAGER_OK;
+    }
+  }
+
+  uint8_t* data = NULL;
+  int rc = pin_page(p, page_no, true, false, &data);
+  pager_unlock(p);
+  *out_page = data;
+  return rc;
+}
+
+int pager_pin_mut(Pager* p, uint32_t page_no, void** out_page) {
+  if (!p || !out_page)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  uint8_t* data = NULL;
+  int rc = pin_page(p, page_no, true, true, &data);
+  pager_unlock(p);
+  *out_page = data;
+  return rc;
+}
+
+int pager_pin_zero(Pager* p, uint32_t page_no, void** out_page) {
+  if (!p || !out_page)
+    return PAGER_E_INVAL;
+
+  // The old image is discarded: never read it from the file.
+  pager_lock(p);
+  uint8_t* data = NULL;
+  int rc = pin_page(p, page_no, false, true, &data);
+  if (rc == PAGER_OK) {
+    memset(data, 0, p->page_size);
+    Frame* f = frame_of(p, data);
+    f->dirty = true;
+    f->state = PAGER_PAGE_UNCHECKED;
+  }
+  pager_unlock(p);
+  *out_page = data;
+  return rc;
+}
+
+static int unpin_page(Pager* p, const void* page, bool dirty) {
+  VersionPin* copy = version_pinned(p, page);
+  if (copy) {
+    if (dirty)
+      return PAGER_E_INVAL;   // copies are read-only
+    copy->v->pins--;
+    *copy = (VersionPin){0};
+    return PAGER_OK;
+  }
+
+  const uint8_t* ptr = (const uint8_t*)page;
+  if (p->map && ptr >= p->map && ptr < p->map + p->map_len) {
+    // Mapping pins are read-only and carry no frame state
+    if (dirty || p->map_pins == 0 || (size_t)(ptr - p->map) % p->page_size != 0)
+      return PAGER_E_INVAL;
+    p->map_pins--;
+    return PAGER_OK;
+  }
+
+  Frame* f = frame_of(p, page);
+  if (!f || !f->valid || f->pin_count == 0)
+    return PAGER_E_INVAL;
+
+  int rc = latch_release(p, f);
+  if (rc != PAGER_OK)
+    return rc;
+
+  pool_release(f, dirty);
+  return PAGER_OK;
+}
+
+int pager_unpin(Pager* p, const void* page, bool dirty) {
+  if (!p || !page)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  int rc = unpin_page(p, page, dirty);
+  pager_unlock(p);
+  return rc;
+}
+
+/**
+ * @brief State word of a pinned page: its frame's, its snapshot copy's or
+ *        its mapped page's. NULL for any other buffer.
+ */
+static _Atomic uint8_t* state_of(const Pager* p, const void* page) {
+  Frame* f = frame_of(p, page);
+  if (f)
+    return &f->state;
+  VersionPin* copy = version_pinned(p, page);
+  if (copy)
+    return &copy->v->state;
+  const uint8_t* ptr = (const uint8_t*)page;
+  if (p->use_mmap && p->map && ptr >= p->map && ptr < p->map + p->map_len &&
+      (size_t)(ptr - p->map) % p->page_size == 0)
+    return &p->map_state[(size_t)(ptr - p->map) / p->page_size];
+  return NULL;
+}
+
+PagerPageState pager_page_state(Pager* p, const void* page) {
+  if (!p || !page)
+    return PAGER_PAGE_UNCHECKED;
+  _Atomic uint8_t* state = state_of(p, page);
+  if (!state)
+    return PAGER_PAGE_UNCHECKED;
+  return (PagerPageState)page_resolve(p, state, (const uint8_t*)page);
+}
+
+void pager_page_trust(Pager* p, const void* page) {
+  if (!p || !page || p->paranoid)
+    return;
+  _Atomic uint8_t* state = state_of(p, page);
+  uint8_t expected = PAGER_PAGE_UNCHECKED;
+  if (state)
+    (void)atomic_compare_exchange_strong(state, &expected, PAGER_PAGE_TRUSTED);
+}
+
+/**
+ * @brief pager_prefetch(): claim a frame for each page worth reading
+ *        (pinned and `loading`, so pool_fetch waits for it and eviction
+ *        leaves it alone), read them all with the lock dropped, then
+ *        publish them unpinned.
+ */
+int pager_prefetch(Pager* p, const uint32_t* pages, size_t n) {
+  if (!p || (!pages && n > 0))
+    return PAGER_E_INVAL;
+
+  size_t cap = p->io_depth;
+  if (cap > p->frame_count / 4)
+    cap = p->frame_count / 4;
+
+  PioReq reqs[PIO_MAX_DEPTH];
+  Frame* claimed[PIO_MAX_DEPTH];
+  size_t k = 0;
+  int rc = PAGER_OK;
+
+  pager_lock(p);
+  for (size_t i = 0; i < n && k < cap; i++) {
+    const uint32_t page_no = pages[i];
+    if (page_no == 0 || page_no >= p->page_count || pool_lookup(p, page_no) ||
+        wal_find(p->wal, page_no, NULL) || map_page(p, page_no))
+      continue;
+
+    uint32_t idx = 0;
+    rc = pool_evict(p, &idx);
+    if (rc != PAGER_OK) {
+      if (rc == PAGER_E_NOFRAME) rc = PAGER_OK;   // a full pool is not an error here
+      break;
+    }
+    Frame* f = &p->frames[idx];
+    f->page_no   = page_no;
+    f->pin_count = 1;
+    f->valid     = true;
+    f->dirty     = false;
+    f->ref       = true;
+    f->loading   = true;
+    f->state     = PAGE_STATE_NEW;
+    pool_hash_insert(p, idx);
+
+    reqs[k] = (PioReq){ .fd = p->fd, .write = false, .buf = f->data, .len = p->page_size,
+                        .off = (off_t)page_no * (off_t)p->page_size };
+    claimed[k++] = f;
+  }
+  pager_unlock(p);
+
+  if (k > 0) {
+    int io_rc = io_run(p, reqs, k);
+    if (rc == PAGER_OK) rc = io_rc;
+  }
+
+  pager_lock(p);
+  for (size_t i = 0; i < k; i++) {
+    Frame* f = claimed[i];
+    f->loading = false;
+    f->pin_count--;
+    if (reqs[i].result != PAGER_OK) {
+      pool_hash_remove(p, (uint32_t)(f - p->frames));
+      f->valid = false;
+    }
+  }
+  if (k > 0)
+    pthread_cond_broadcast(&p->latch_cv);
+  pager_unlock(p);
+  return rc;
+}
+
+static int alloc_pages(Pager* p, uint32_t count, uint32_t* out_first_page_no);
+
+/**
+ * @brief Record the free list in the (pinned, exclusive) header page.
+ */
+static void free_list_store(Pager* p, uint8_t* hdr, uint32_t head, uint32_t count) {
+  write_le_u32(hdr + HDR_FREELIST_OFF, head);
+  write_le_u32(hdr + HDR_FREECOUNT_OFF, count);
+  p->free_head = head;
+  p->free_count = count;
+}
+
+/**
+ * @brief Take the head of the free list and zero it. The header is pinned
+ *        first, so that no other allocation sees the same head.
+ */
+static int free_list_pop(Pager* p, uint32_t* out_page_no) {
+  uint8_t* hdr = NULL;
+  int rc = pin_page(p, 0, true, true, &hdr);
+  if (rc != PAGER_OK)
+    return rc;
+
+  const uint32_t head = p->free_head;
+  uint8_t* page = NULL;
+  if (head == 0) {
+    rc = alloc_pages(p, 1, out_page_no);   // emptied meanwhile
+  } else if ((rc = pin_page(p, head, true, true, &page)) == PAGER_OK) {
+    const uint32_t next = read_le_u32(page + FREE_NEXT_OFF);
+    if (read_le_u16(page) != PAGER_FREE_PAGE_KIND || next >= p->page_count || p->free_count == 0)
+      rc = PAGER_E_META;
+    if (rc == PAGER_OK) {
+      memset(page, 0, p->page_size);
+      free_list_store(p, hdr, next, p->free_count - 1);
+      *out_page_no = head;
+    }
+    (void)unpin_page(p, page, rc == PAGER_OK);
+  }
+  (void)unpin_page(p, hdr, rc == PAGER_OK && head != 0);
+  return rc;
+}
+
+int pager_alloc_page(Pager* p, uint32_t* out_page_no){
+  if (!p || !out_page_no)
+    return PAGER_E_INVAL;
+  if (writes_refused(p))
+    return PAGER_E_READONLY;
+
+  pager_lock(p);
+  int rc = p->free_head != 0 ? free_list_pop(p, out_page_no)
+                             : alloc_pages(p, 1, out_page_no);
+  pager_unlock(p);
+  if (rc == PAGER_OK)
+    stats_add(STAT_PAGE_ALLOCS, 1);
+  return rc;
+}
+
+/**
+ * @brief Reserve, zero and account for `count` pages at the end of the file.
+ *
+ * The header page is pinned and latched first: both may drop the lock. From
+ * then on nothing does, so reading page_count, growing the file and
+ * publishing the new page_count form one atomic step under p->lock.
+ */
+static int alloc_pages(Pager* p, uint32_t count, uint32_t* out_first_page_no) {
+  Frame* hdr = NULL;
+  int rc = pool_fetch(p, 0, true, &hdr);
+  if (rc != PAGER_OK)
+    return rc;
+  latch_exclusive(p, hdr);
+
+  rc = PAGER_OK;
+  const uint32_t first = p->page_count;
+  const uint64_t result = (uint64_t)first * (uint64_t) p->page_size;
+  const uint64_t span   = (uint64_t)count * (uint64_t) p->page_size;
+
+  if (count > UINT32_MAX - first ||
+      result > (uint64_t)INT64_MAX ||
+      result + span > (uint64_t) INT64_MAX)
+    rc = PAGER_E_META;
+
+  // Bytes already present past page_count may be stale: zero them via the
+  // cache. Anything beyond the current file end reads back as zeros once
+  // the file is grown, so those pages need no frame at all.
+  const off_t begin = (off_t)result;
+  const off_t end   = (off_t)(result + span);
+  for (off_t off = begin; rc == PAGER_OK && off < end && off < p->file_size; off += (off_t)p->page_size) {
+    Frame* f = NULL;
+    rc = pool_fetch(p, (uint32_t)(off / (off_t)p->page_size), false, &f);
+    if (rc != PAGER_OK)
+      break;
+    memset(f->data, 0, p->page_size);
+    pool_release(f, true);
+  }
+
+  // One file extension for the whole group
+  if (rc == PAGER_OK && end > p->file_size) {
+    if (ftruncate(p->fd, end) != 0)
+      rc = PAGER_E_IO;
+    else
+      p->file_size = end;
+  }
+
+  // Patch page_count in the cached header page, once per group.
+  if (rc == PAGER_OK) {
+    p->page_count = first + count;
+    write_le_u32(hdr->data + HDR_PAGECOUNT_OFF, first + count);
+  }
+  latch_release(p, hdr);
+  pool_release(hdr, rc == PAGER_OK);
+  if (rc != PAGER_OK)
+    return rc;
+
+  *out_first_page_no = first;
+  return PAGER_OK;
+}
+
+int pager_alloc_pages(Pager* p, uint32_t count, uint32_t* out_first_page_no) {
+  if (!p || !out_first_page_no || count == 0)
+    return PAGER_E_INVAL;
+  if (writes_refused(p))
+    return PAGER_E_READONLY;
+
+  pager_lock(p);
+  int rc = alloc_pages(p, count, out_first_page_no);
+  pager_unlock(p);
+  if (rc == PAGER_OK)
+    stats_add(STAT_PAGE_ALLOCS, count);
+  return rc;
+}
+
+int pager_free_page(Pager* p, uint32_t page_no) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  if (page_no == 0 || page_no >= p->page_count) {
+    pager_unlock(p);
+    return PAGER_E_RANGE;
+  }
+  uint8_t* hdr = NULL;
+  uint8_t* page = NULL;
+  int rc = pin_page(p, 0, true, true, &hdr);
+  if (rc == PAGER_OK && (rc = pin_page(p, page_no, true, true, &page)) == PAGER_OK) {
+    if (read_le_u16(page) == PAGER_FREE_PAGE_KIND) {
+      rc = PAGER_E_INVAL;
+    } else {
+      memset(page, 0, p->page_size);
+      frame_of(p, page)->state = PAGER_PAGE_UNCHECKED;
+      write_le_u16(page, PAGER_FREE_PAGE_KIND);
+      write_le_u32(page + FREE_NEXT_OFF, p->free_head);
+      free_list_store(p, hdr, page_no, p->free_count + 1);
+    }
+    (void)unpin_page(p, page, rc == PAGER_OK);
+  }
+  if (hdr)
+    (void)unpin_page(p, hdr, rc == PAGER_OK);
+  pager_unlock(p);
+  return rc;
+}
+
+static int flush_locked(Pager* p);
+static int checkpoint_locked(Pager* p);
+
+/**
+ * @brief pager_trim(): mark the free pages, cut the free run at the end of
+ *        the file, relink the rest in ascending order, write everything out
+ *        and shrink the file. `hdr` is pinned exclusively throughout, which
+ *        keeps allocations out.
+ */
+static int trim_locked(Pager* p, uint8_t* hdr, uint32_t* out_released) {
+  if (p->free_count == 0)
+    return PAGER_OK;
+
+  const uint32_t page_count = p->page_count;
+  uint8_t* is_free = calloc(page_count, 1);
+  if (!is_free)
+    return PAGER_E_IO;
+
+  int rc = PAGER_OK;
+  uint32_t seen = 0;
+  for (uint32_t no = p->free_head; no != 0 && rc == PAGER_OK; ) {
+    const void* page = NULL;
+    if (no >= page_count || is_free[no] || ++seen > p->free_count) {
+      rc = PAGER_E_META;
+      break;
+    }
+    if ((rc = pin_page(p, no, true, false, (uint8_t**)&page)) != PAGER_OK)
+      break;
+    is_free[no] = 1;
+    const uint32_t next = read_le_u32((const uint8_t*)page + FREE_NEXT_OFF);
+    if (read_le_u16(page) != PAGER_FREE_PAGE_KIND)
+      rc = PAGER_E_META;
+    (void)unpin_page(p, page, false);
+    no = next;
+  }
+  if (rc == PAGER_OK && seen != p->free_count)
+    rc = PAGER_E_META;
+
+  uint32_t new_count = page_count;
+  while (rc == PAGER_OK && new_count > 1 && is_free[new_count - 1])
+    new_count--;
+  if (rc != PAGER_OK || new_count == page_count) {
+    free(is_free);
+    return rc;
+  }
+
+  // The pages going away must not be in use (a mapped pager never gets here)
+  for (size_t i = 0; i < p->frame_count && rc == PAGER_OK; i++) {
+    const Frame* f = &p->frames[i];
+    if (f->valid && f->page_no >= new_count && (f->pin_count > 0 || f->loading))
+      rc = PAGER_E_INVAL;
+  }
+
+  // Relink what stays, lowest page first
+  uint32_t head = 0, count = 0;
+  for (uint32_t no = new_count; rc == PAGER_OK && no-- > 1; ) {
+    if (!is_free[no])
+      continue;
+    uint8_t* page = NULL;
+    if ((rc = pin_page(p, no, true, true, &page)) != PAGER_OK)
+      break;
+    write_le_u32(page + FREE_NEXT_OFF, head);
+    (void)unpin_page(p, page, true);
+    head = no;
+    count++;
+  }
+  free(is_free);
+  if (rc != PAGER_OK)
+    return rc;
+
+  // Forget the cut pages' frames, then publish the shorter file
+  for (size_t i = 0; i < p->frame_count; i++) {
+    Frame* f = &p->frames[i];
+    if (f->valid && f->page_no >= new_count) {
+      pool_hash_remove(p, (uint32_t)i);
+      f->valid = false;
+      f->dirty = false;
+    }
+  }
+  free_list_store(p, hdr, head, count);
+  write_le_u32(hdr + HDR_PAGECOUNT_OFF, new_count);
+  p->page_count = new_count;
+  frame_of(p, hdr)->dirty = true;
+
+  // The header on disk must not count pages past the end of the file
+  rc = p->wal ? checkpoint_locked(p) : flush_locked(p);
+  if (rc != PAGER_OK)
+    return rc;
+  const off_t size = (off_t)new_count * (off_t)p->page_size;
+  if (ftruncate(p->fd, size) != 0)
+    return PAGER_E_IO;
+  p->file_size = size;
+  if (out_released)
+    *out_released = page_count - new_count;
+  return PAGER_OK;
+}
+
+int pager_trim(Pager* p, uint32_t* out_released) {
+  if (!p)
+    return PAGER_E_INVAL;
+  if (out_released)
+    *out_released = 0;
+
+  pager_lock(p);
+  if (p->txn) {
+    pager_unlock(p);   // the freed pages may come back on abort
+    return PAGER_OK;
+  }
+  uint8_t* hdr = NULL;
+  int rc = pin_page(p, 0, true, true, &hdr);
+  if (rc == PAGER_OK) {
+    rc = trim_locked(p, hdr, out_released);
+    (void)unpin_page(p, hdr, false);
+  }
+  pager_unlock(p);
+  return rc;
+}
+
+uint32_t pager_free_count(const Pager* p) {
+  return p ? p->free_count : 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Flush / commit (internal, p->lock held)
+// ─────────────────────────────────────────────────────────────────────────────
+static int commit_locked(Pager* p);
+static int sync_locked(Pager* p);
+
+/**
+ * @brief Write every dirty frame back to the file.
+ *        Data pages go first and the header page last, so the on-disk
+ *        page_count never covers pages that were not written yet.
+ */
+static int flush_locked(Pager* p) {
+  if (p->txn)
+    return PAGER_OK;   // written by pager_txn_commit()
+  if (p->wal)
+    return sync_locked(p);
+
+  // The batch is written with the lock held, so no latch can be taken
+  // meanwhile; wait out the other threads' exclusive latches first (each
+  // wait drops the lock, hence the new pass)
+  bool waited;
+  do {
+    waited = false;
+    for (size_t i = 0; i < p->frame_count; i++) {
+      Frame* f = &p->frames[i];
+      if (f->valid && f->dirty && f->excl_depth > 0 && !latch_owned(f)) {
+        latch_quiesce(p, f);
+        waited = true;
+      }
+    }
+  } while (waited);
+
+  Frame** batch = p->flush_batch;
+  Frame* hdr = NULL;
+  size_t n = 0;
+  for (size_t i = 0; i < p->frame_count; i++) {
+    Frame* f = &p->frames[i];
+    if (!f->valid || !f->dirty)
+      continue;
+    if (f->page_no == 0)
+      hdr = f;
+    else
+      batch[n++] = f;
+  }
+  int rc = frames_write_back(p, batch, n);
+  if (rc != PAGER_OK || !hdr)
+    return rc;
+  return frame_write_back(p, hdr);
+}
+
+/**
+ * @brief Append the open transaction to the log and seal it with a commit
+ *        frame (the header page, carrying page_count).
+ */
+static int commit_locked(Pager* p) {
+  if (!p->wal || p->txn)
+    return flush_locked(p);
+
+  bool pending = wal_frame_count(p->wal) != wal_committed_frames(p->wal);
+  Frame* hdr = NULL;
+  for (size_t i = 0; i < p->frame_count; i++) {
+    Frame* f = &p->frames[i];
+    latch_quiesce(p, f);
+    if (!f->valid || !f->dirty)
+      continue;
+    pending = true;
+    if (f->page_no == 0)
+      continue;
+    int rc = frame_write_back(p, f);
+    if (rc != PAGER_OK)
+      return rc;
+  }
+
+  if (!pending)
+    return PAGER_OK;   // empty transaction
+
+  int rc = pool_fetch(p, 0, true, &hdr);
+  if (rc != PAGER_OK)
+    return rc;
+  latch_quiesce(p, hdr);
+  rc = wal_append(p->wal, 0, hdr->data, p->page_count);
+  if (rc == PAGER_OK)
+    hdr->dirty = false;
+  pool_release(hdr, false);
+  if (rc != PAGER_OK)
+    return rc;
+
+  // Group commit: one fsync covers every commit appended since the last one
+  if (++p->unsynced >= p->group_commit) {
+    if ((rc = wal_sync(p->wal)) != PAGER_OK)
+      return rc;
+    p->unsynced = 0;
+  }
+
+  if (wal_frame_count(p->wal) >= p->autocheckpoint)
+    return checkpoint_locked(p);
+  return PAGER_OK;
+}
+
+static int sync_locked(Pager* p) {
+  if (!p->wal) {
+    int rc = flush_locked(p);
+    if (rc != PAGER_OK)
+      return rc;
+    return fsync(p->fd) == 0 ? PAGER_OK : PAGER_E_IO;
+  }
+
+  int rc = commit_locked(p);
+  if (rc != PAGER_OK)
+    return rc;
+  if (p->unsynced > 0) {
+    if ((rc = wal_sync(p->wal)) != PAGER_OK)
+      return rc;
+    p->unsynced = 0;
+  }
+  return PAGER_OK;
+}
+
+static int checkpoint_locked(Pager* p) {
+  if (!p->wal || p->txn)
+    return PAGER_OK;   // not while the log may hold uncommitted transaction pages
+
+  // Commit first; if that already checkpointed, the copy below is a no-op.
+  int rc = commit_locked(p);
+  if (rc != PAGER_OK)
+    return rc;
+
+  // wal_checkpoint fsyncs the log before touching the database file.
+  if ((rc = wal_checkpoint(p->wal, p->fd)) != PAGER_OK)
+    return rc;
+  p->unsynced = 0;
+
+  struct stat st;
+  if (fstat(p->fd, &st) == 0 && st.st_size > p->file_size)
+    p->file_size = st.st_size;
+  return PAGER_OK;
+}
+
+int pager_flush(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  int rc = flush_locked(p);
+  pager_unlock(p);
+  return rc;
+}
+
+int pager_commit(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  int rc = commit_locked(p);
+  pager_unlock(p);
+  return rc;
+}
+
+int pager_sync(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  int rc = sync_locked(p);
+  pager_unlock(p);
+  return rc;
+}
+
+int pager_checkpoint(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  int rc = checkpoint_locked(p);
+  pager_unlock(p);
+  return rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Transactions
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Open the snapshot the other threads read through while the
+ *        transaction is open: the pages it changes are copied aside first.
+ */
+static int txn_snap_begin(Pager* p) {
+  PagerSnapshot* s = p->snap_spare;
+  if (s)
+    p->snap_spare = s->next;
+  else if (!(s = malloc(sizeof *s)))
+    return PAGER_E_IO;
+  s->pager = p;
+  s->seq = ++p->snap_seq;
+  s->next = p->snapshots;
+  p->snapshots = s;
+  p->txn_snap = s;
+  return PAGER_OK;
+}
+
+static void txn_snap_end(Pager* p) {
+  PagerSnapshot* s = p->txn_snap;
+  if (!s)
+    return;
+  PagerSnapshot** at = &p->snapshots;
+  while (*at != s)
+    at = &(*at)->next;
+  *at = s->next;
+  p->txn_snap = NULL;
+  version_gc(p, false);
+  s->next = p->snap_spare;
+  p->snap_spare = s;
+}
+
+/**
+ * @brief Whether a frame holds a change of the open transaction: dirty, or
+ *        read back from a frame it spilled to the log.
+ */
+static bool txn_frame(const Pager* p, const Frame* f) {
+  uint32_t logged = 0;
+  return f->valid && (f->dirty || (wal_find(p->wal, f->page_no, &logged) &&
+                                   logged >= wal_committed_frames(p->wal)));
+}
+
+/**
+ * @brief Drop the frames a transaction changed, in the pool and in the log,
+ *        and restore the header fields it started from (p->lock held, no
+ *        page of it pinned by the caller). The header page itself is one
+ *        of those frames when it changed.
+ * @return PAGER_OK, or the error of the log rollback (the dirty frames are
+ *         then kept).
+ */
+static int txn_drop(Pager* p) {
+  bool waited;
+  do {
+    waited = false;
+    for (size_t i = 0; i < p->frame_count; i++) {
+      Frame* f = &p->frames[i];
+      if (txn_frame(p, f) && (f->pin_count > 0 || f->loading)) {
+        pthread_cond_wait(&p->latch_cv, &p->lock);
+        waited = true;
+        break;
+      }
+    }
+  } while (waited);
+
+  // Clean copies of spilled pages first: until the rollback they would
+  // read back the same
+  for (size_t i = 0; i < p->frame_count; i++) {
+    Frame* f = &p->frames[i];
+    if (!f->dirty && txn_frame(p, f)) {
+      pool_hash_remove(p, (uint32_t)i);
+      f->valid = false;
+    }
+  }
+  int rc = wal_rollback(p->wal);
+  if (rc != PAGER_OK)
+    return rc;
+  for (size_t i = 0; i < p->frame_count; i++) {
+    Frame* f = &p->frames[i];
+    if (f->valid && f->dirty) {
+      pool_hash_remove(p, (uint32_t)i);
+      f->valid = false;
+      f->dirty = false;
+    }
+  }
+  p->page_count = p->txn_page_count;
+  p->catalog    = p->txn_catalog;
+  p->free_head  = p->txn_free_head;
+  p->free_count = p->txn_free_count;
+  // Give back the room allocations added (nothing maps past page_count)
+  if (p->file_size > p->txn_file_size && ftruncate(p->fd, p->txn_file_size) == 0)
+    p->file_size = p->txn_file_size;
+  p->txn = false;
+  txn_snap_end(p);
+  return PAGER_OK;
+}
+
+/**
+ * @brief End the write section a transaction holds.
+ */
+static void txn_leave(Pager* p) {
+  if (--p->write_depth == 0)
+    pthread_cond_broadcast(&p->latch_cv);
+}
+
+int pager_txn_begin(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+  if (writes_refused(p))
+    return PAGER_E_READONLY;
+  if (!p->wal)
+    return PAGER_E_INVAL;   // the commit is one group of log frames
+
+  pager_lock(p);
+  if (write_owned(p)) {
+    pager_unlock(p);
+    return PAGER_E_INVAL;
+  }
+  while (p->write_depth > 0)
+    pthread_cond_wait(&p->latch_cv, &p->lock);
+  p->writer = pthread_self();
+  p->write_depth = 1;
+
+  // Nothing dirty or uncommitted is left from before: an abort drops
+  // exactly the transaction's pages
+  int rc = commit_locked(p);
+  if (rc == PAGER_OK)
+    rc = txn_snap_begin(p);
+  if (rc != PAGER_OK) {
+    txn_leave(p);
+    pager_unlock(p);
+    return rc;
+  }
+  p->txn_page_count = p->page_count;
+  p->txn_catalog    = p->catalog;
+  p->txn_free_head  = p->free_head;
+  p->txn_free_count = p->free_count;
+  p->txn_file_size  = p->file_size;
+  p->txn = true;
+  pager_unlock(p);
+  return PAGER_OK;
+}
+
+int pager_txn_commit(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  if (!p->txn || !write_owned(p)) {
+    pager_unlock(p);
+    return PAGER_E_INVAL;
+  }
+  p->txn = false;
+  int rc = commit_locked(p);
+  txn_snap_end(p);
+  txn_leave(p);
+  pager_unlock(p);
+  return rc;
+}
+
+int pager_txn_abort(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  if (!p->txn || !write_owned(p)) {
+    pager_unlock(p);
+    return PAGER_E_INVAL;
+  }
+  for (size_t i = 0; i < p->frame_count; i++) {
+    const Frame* f = &p->frames[i];
+    if (txn_frame(p, f) && (latch_owned(f) || held_find(f, false))) {
+      pager_unlock(p);
+      return PAGER_E_INVAL;   // waiting would be waiting for ourselves
+    }
+  }
+  int rc = txn_drop(p);
+  if (rc == PAGER_OK)
+    txn_leave(p);
+  pager_unlock(p);
+  return rc;
+}
+
+bool pager_txn_active(const Pager* p) {
+  return p && p->txn;
+}
+
+bool pager_txn_owned(Pager* p) {
+  if (!p || !p->txn)
+    return false;
+  pager_lock(p);
+  const bool owned = p->txn && write_owned(p);
+  pager_unlock(p);
+  return owned;
+}
+
+int pager_snapshot_begin(Pager* p, PagerSnapshot** out) {
+  if (!p || !out)
+    return PAGER_E_INVAL;
+  *out = NULL;
+
+  pager_lock(p);
+  if (write_owned(p)) {
+    pager_unlock(p);
+    return PAGER_E_READONLY;
+  }
+  PagerSnapshot* s = p->snap_spare;
+  if (s)
+    p->snap_spare = s->next;
+  else if (!(s = malloc(sizeof *s))) {
+    pager_unlock(p);
+    return PAGER_E_IO;
+  }
+  // Between write sections: the snapshot never sees half of one
+  while (p->write_depth > 0)
+    pthread_cond_wait(&p->latch_cv, &p->lock);
+  s->pager = p;
+  s->seq = ++p->snap_seq;
+  s->next = p->snapshots;
+  p->snapshots = s;
+  pager_unlock(p);
+
+  t_snap = s;
+  t_snap_pager = p;
+  *out = s;
+  return PAGER_OK;
+}
+
+int pager_snapshot_end(Pager* p, PagerSnapshot* s) {
+  if (!p || !s || s->pager != p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  PagerSnapshot** at = &p->snapshots;
+  while (*at && *at != s)
+    at = &(*at)->next;
+  if (!*at) {
+    pager_unlock(p);
+    return PAGER_E_INVAL;
+  }
+  *at = s->next;
+  version_gc(p, false);
+  if (t_snap == s) {
+    t_snap = NULL;
+    t_snap_pager = NULL;
+  }
+  s->next = p->snap_spare;
+  p->snap_spare = s;
+  pager_unlock(p);
+  return PAGER_OK;
+}
+
+int pager_snapshot_bind(Pager* p, PagerSnapshot* s) {
+  if (!p || (s && s->pager != p))
+    return PAGER_E_INVAL;
+  t_snap = s;
+  t_snap_pager = s ? p : NULL;
+  return PAGER_OK;
+}
+
+PagerSnapshot* pager_snapshot_current(const Pager* p) {
+  return p ? snap_of(p) : NULL;
+}
+
+size_t pager_snapshot_pages(const Pager* p) {
+  return p ? atomic_load(&p->version_count) : 0;
+}
+
+int pager_write_begin(Pager* p) {
+  if (!p)
+    return PAGER_E_INVAL;
+  if (writes_refused(p))
+    return PAGER_E_READONLY;
+
+  pager_lock(p);
+  if (!write_owned(p)) {
+    while (p->write_depth > 0)
+      pthread_cond_wait(&p->latch_cv, &p->lock);
+    p->writer = pthread_self();
+  }
+  p->write_depth++;
+  pager_unlock(p);
+  return PAGER_OK;
+}
+
+void pager_write_end(Pager* p) {
+  if (!p)
+    return;
+  pager_lock(p);
+  if (write_owned(p) && --p->write_depth == 0)
+    pthread_cond_broadcast(&p->latch_cv);
+  pager_unlock(p);
+}
+
+/**
+ * @brief Return the page size used by this Pager.
+ */
+size_t pager_page_size(const Pager* p) {
+  return p ? p->page_size : 0;
+}
+
+
+/**
+ * @brief Return the backend of the I/O queue (PIO_BACKEND_AUTO for NULL).
+ */
+PioBackend pager_io_backend(const Pager* p) {
+  return p ? pio_backend(p->io) : PIO_BACKEND_AUTO;
+}
+
+/**
+ * @brief Return how many reads or writes the I/O queue keeps in flight.
+ */
+unsigned pager_io_depth(const Pager* p) {
+  return p ? p->io_depth : 0;
+}
+
+PagerAccess pager_set_access(Pager* p, PagerAccess access) {
+  if (!p)
+    return PAGER_ACCESS_NORMAL;
+  SeqRun* s = seq_run(p);
+  const PagerAccess prev = s->access;
+  s->access = access;
+  s->run = 0;   // the next miss starts afresh
+  return prev;
+}
+
+uint64_t pager_readahead_pages(const Pager* p) {
+  return p ? p->readahead_pages : 0;
+}
+
+/**
+ * @brief Return the number of frames in the buffer pool.
+ */
+size_t pager_cache_pages(const Pager* p) {
+  return p ? p->frame_count : 0;
+}
+
+int pager_get_catalog(Pager* p, uint32_t* out_page_no) {
+  if (!p || !out_page_no)
+    return PAGER_E_INVAL;
+
+  if (!p->txn) {
+    *out_page_no = p->catalog;
+    return PAGER_OK;
+  }
+  pager_lock(p);
+  *out_page_no = p->txn_snap && read_snap(p) == p->txn_snap ? p->txn_catalog : p->catalog;
+  pager_unlock(p);
+  return PAGER_OK;
+}
+
+int pager_set_catalog(Pager* p, uint32_t page_no) {
+  if (!p)
+    return PAGER_E_INVAL;
+
+  pager_lock(p);
+  if (page_no >= p->page_count) {
+    pager_unlock(p);
+    return PAGER_E_RANGE;
+  }
+  uint8_t* hdr = NULL;
+  int rc = pin_page(p, 0, true, true, &hdr);
+  if (rc == PAGER_OK) {
+    write_le_u32(hdr + HDR_CATALOG_OFF, page_no);
+    p->catalog = page_no;
+    rc = unpin_page(p, hdr, true);
+  }
+  pager_unlock(p);
+  return rc;
+}
+
+uint32_t pager_format_version(const Pager* p) {
+  return p ? p->version : 0;
+}
+
+/**
+ * @brief Return the number of pages in the file.
+ */
+uint32_t pager_page_count(const Pager* p) {
+  return p ? p->page_count : 0;
+}
+
+/**
+ * @brief Flush dirty frames, close the Pager and free resources.
+ */
+int pager_close(Pager* p) {
+    if (!p) return PAGER_E_INVAL;
+    int rc = PAGER_OK;
+    if (p->txn) {
+      pthread_mutex_lock(&p->lock);
+      rc = txn_drop(p);   // never committed
+      pthread_mutex_unlock(&p->lock);
+    }
+    if (p->wal) {
+      // Keep the log if anything failed: the next open replays it (and
+      // drops a transaction that could not be rolled back).
+      if (rc == PAGER_OK)
+        rc = pager_checkpoint(p);
+      wal_close(p->wal, rc == PAGER_OK);
+      p->wal = NULL;
+    } else {
+      rc = pager_flush(p);
+    }
+    map_release(p);
+    pio_close(p->io);
+    if (close(p->fd) != 0 && rc == PAGER_OK)
+      rc = PAGER_E_IO;
+    if (t_seq.p == p)
+      t_seq = (SeqRun){0};   // a later pager may reuse the address
+    if (t_snap_pager == p) {
+      t_snap = NULL;
+      t_snap_pager = NULL;
+    }
+    for (size_t i = 0; i < PAGER_MAX_HELD_LATCHES; i++)
+      if (t_vpins[i].p == p)
+        t_vpins[i] = (VersionPin){0};
+    version_gc(p, true);
+    free(p->versions);
+    while (p->version_spare) {
+      PageVersion* v = p->version_spare;
+      p->version_spare = v->next;
+      free(v);
+    }
+    PagerSnapshot* lists[2] = { p->snapshots, p->snap_spare };
+    for (int l = 0; l < 2; l++)
+      while (lists[l]) {
+        PagerSnapshot* s = lists[l];
+        lists[l] = s->next;
+        free(s);
+      }
+    pool_free(p);
+    slab_release(p);
+    pthread_mutex_destroy(&p->slab_lock);
+    pthread_mutex_destroy(&p->io_lock);
+    pthread_cond_destroy(&p->latch_cv);
+    pthread_mutex_destroy(&p->lock);
     free(p);
+    return rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Page buffers
+// ─────────────────────────────────────────────────────────────────────────────
+int pager_buf_get(Pager* p, void** out) {
+  if (!p || !out)
+    return PAGER_E_INVAL;
+  *out = slab_get(p);
+  return *out ? PAGER_OK : PAGER_E_IO;
+}
+
+void pager_buf_put(Pager* p, void* buf) {
+  if (p && buf)
+    slab_put(p, buf);
+}
+
+size_t pager_buf_count(const Pager* p) {
+  if (!p)
+    return 0;
+  pthread_mutex_t* lock = (pthread_mutex_t*)&p->slab_lock;
+  pthread_mutex_lock(lock);
+  const size_t n = p->slab_nblocks * SLAB_BATCH;
+  pthread_mutex_unlock(lock);
+  return n;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -331,6 +2724,9 @@ const char* pager_errstr(int code) {
     case PAGER_E_TRUNCATED:return "truncated_file";
     case PAGER_E_RANGE:    return "page_out_of_range";
     case PAGER_E_INVAL:    return "invalid_argument";
+    case PAGER_E_NOFRAME:  return "no_free_frame";
+    case PAGER_E_READONLY: return "read_only";
+    case PAGER_E_RECOVERY: return "needs_recovery";
     default:               return "unknown";
   }
 }
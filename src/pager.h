@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "pio.h"
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Error codes (public)
@@ -21,21 +22,90 @@ typedef enum PagerError {
   PAGER_E_META = -5,
   PAGER_E_TRUNCATED = -6,
   PAGER_E_RANGE = -7,
-  PAGER_E_INVAL = -8
+  PAGER_E_INVAL = -8,
+  PAGER_E_NOFRAME = -9,
+  PAGER_E_READONLY = -10,  // write from a thread bound to a snapshot, or on a read-only pager
+  PAGER_E_RECOVERY = -11   // read-only open of a file whose log has not been replayed yet
 } PagerError;
 
 // ─────────────────────────────────────────────────────────────────────────────
-// On-disk format constants (v1)
+// On-disk format constants (v2)
 // ─────────────────────────────────────────────────────────────────────────────
-// Page 0 = header (20 bytes):
+// Page 0 = header (32 bytes):
 //   magic[0..3] = "MDB1"
-//   version[4..7] = 1
-//   page_size[8..11] = 4096
+//   version[4..7] = 2 for new files; version 1 files (32-bit record ids in
+//                   index entries, see table.h) are still opened
+//   page_size[8..11] = 4096 .. 65536, a power of two (chosen at creation)
 //   page_count[12..15] >= 1
 //   flags[16..19] = 0
+//   catalog[20..23] = first table catalog page (0 = none, see catalog.h)
+//   freelist[24..27] = first free page (0 = none)
+//   free_count[28..31] = pages on the free list
+//
+// Free page: kind[0..1] = PAGER_FREE_PAGE_KIND, next[4..7] = next free page
+// (0 = end), the rest zero. Files written before the free list read as
+// having none.
 enum {
-  PAGER_PAGE_SIZE = 4096,
-  PAGER_HDR_SIZE  = 20
+  PAGER_PAGE_SIZE     = 4096,     // default for new files
+  PAGER_MIN_PAGE_SIZE = 4096,
+  PAGER_MAX_PAGE_SIZE = 65536,
+  PAGER_HDR_SIZE      = 32
+};
+
+#define PAGER_FREE_PAGE_KIND 0x000C   // next to the TABLE_PAGE_KIND_* values
+
+// Page checksums: a page whose kind word (bytes 0..1) is PAGER_CRC_PAGE_KIND,
+// PAGER_CRC_PACKED_KIND or PAGER_CRC_PAX_KIND ends with a CRC-32C of its
+// first page_size - PAGER_CRC_SIZE bytes, u32 LE (0 = none recorded: pages
+// written before checksums). The pager stamps it each time it writes such a page out and
+// checks it the first time the loaded image is looked at (pager_page_state).
+// Only fixed-size table leaves, plain, packed or PAX, have the room for it
+// (table.h, packed.h, pax.h); files keep their format version.
+#define PAGER_CRC_PAGE_KIND   0x0001   // TABLE_PAGE_KIND_LEAF
+#define PAGER_CRC_PACKED_KIND 0x000D   // TABLE_PAGE_KIND_PACKED
+#define PAGER_CRC_PAX_KIND    0x000E   // TABLE_PAGE_KIND_PAX
+#define PAGER_CRC_SIZE       4
+
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Buffer pool defaults
+// ─────────────────────────────────────────────────────────────────────────────
+enum {
+  PAGER_DEFAULT_CACHE_PAGES = 256,  // 1 MiB of 4 KiB frames
+  PAGER_MIN_CACHE_PAGES     = 16
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Batched I/O defaults (PagerConfig.io_backend, see pio.h)
+// ─────────────────────────────────────────────────────────────────────────────
+enum {
+  PAGER_DEFAULT_IO_DEPTH = 32   // page reads / writes in flight
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sequential read-ahead (PagerConfig.readahead, pager_set_access)
+// ─────────────────────────────────────────────────────────────────────────────
+enum {
+  PAGER_DEFAULT_READAHEAD = 32,  // pages advised ahead of a sequential run
+  PAGER_SEQ_TRIGGER       = 3    // forward misses in a row that make a run
+};
+#define PAGER_READAHEAD_OFF UINT32_MAX
+
+/**
+ * @brief Access pattern of the calling thread, see pager_set_access().
+ */
+typedef enum PagerAccess {
+  PAGER_ACCESS_NORMAL = 0,   // read ahead once a sequential run is detected
+  PAGER_ACCESS_SEQUENTIAL,   // scanning: read ahead from the first miss
+  PAGER_ACCESS_RANDOM        // never read ahead
+} PagerAccess;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Write-ahead log defaults (PagerConfig.wal)
+// ─────────────────────────────────────────────────────────────────────────────
+enum {
+  PAGER_DEFAULT_GROUP_COMMIT   = 16,    // commits per fsync of the log
+  PAGER_DEFAULT_AUTOCHECKPOINT = 1024   // log frames before a checkpoint
 };
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -43,6 +113,57 @@ enum {
 // ─────────────────────────────────────────────────────────────────────────────
 typedef struct Pager Pager;
 
+/* Threads: every call except pager_open*() / pager_close() may be made from
+ * several threads on the same Pager. The pool bookkeeping sits behind an
+ * internal lock, which is dropped while a page is read from the file, and
+ * each pin holds a per-page reader/writer latch until its pager_unpin():
+ * shared for pager_pin() and pager_read(), exclusive for pager_pin_mut(),
+ * pager_pin_zero() and pager_write(). A thread may pin a page it already
+ * holds (in any mode) or upgrade a page it is the only one to share.
+ * Allocation reserves pages atomically and pager_page_count() is lock-free.
+ *
+ * The intended use is one writer thread plus any number of readers that pin
+ * one page at a time. Two threads that each hold a latch while waiting for
+ * the other's page deadlock, as with any latch protocol. Limits:
+ * - Pins served from the file mapping (PagerConfig.use_mmap) take no latch,
+ *   so the mapping is only allowed on a read-only pager (PagerConfig.read_only).
+ *   Another process writing the file meanwhile is not detected.
+ * - pager_flush / pager_commit write a page only once no other thread holds
+ *   it exclusively.
+ * Readers that need a consistent view of several pages while the writer
+ * goes on take a snapshot (pager_snapshot_begin); a writer that needs several
+ * changes to land together opens a transaction (pager_txn_begin). */
+
+/**
+ * @brief Options for pager_open_ex(). Zero-initialize, then set what you need.
+ */
+typedef struct PagerConfig {
+  size_t cache_pages;   // frames in the buffer pool (0 = PAGER_DEFAULT_CACHE_PAGES)
+  bool   read_only;     // open the file O_RDONLY: every change fails with
+                        // PAGER_E_READONLY (the file must exist; no wal)
+  bool   use_mmap;      // serve page reads from a file mapping (read_only only)
+  bool   wal;           // log page images to "<path>-wal" (see pager_commit)
+  uint32_t wal_group_commit;    // commits per fsync (0 = PAGER_DEFAULT_GROUP_COMMIT)
+  uint32_t wal_autocheckpoint;  // frames before checkpoint (0 = PAGER_DEFAULT_AUTOCHECKPOINT)
+  uint32_t page_size;   // page size of a new file (0 = PAGER_PAGE_SIZE); an
+                        // existing file keeps the size in its header
+  PioBackend io_backend;  // batched reads / writes (PIO_BACKEND_AUTO = best available)
+  unsigned   io_depth;    // requests in flight (0 = PAGER_DEFAULT_IO_DEPTH, max PIO_MAX_DEPTH)
+  uint32_t   readahead;   // pages read ahead of a sequential run (0 =
+                          // PAGER_DEFAULT_READAHEAD, PAGER_READAHEAD_OFF = never)
+  bool       paranoid;    // never report a page as trusted: callers validate
+                          // it on every access (see pager_page_state)
+} PagerConfig;
+
+/**
+ * @brief What the pager knows of a pinned page image, see pager_page_state().
+ */
+typedef enum PagerPageState {
+  PAGER_PAGE_UNCHECKED = 0,  // checksum fine or absent; not validated yet
+  PAGER_PAGE_TRUSTED,        // validated by a caller since it was loaded
+  PAGER_PAGE_CORRUPT         // its checksum does not match its bytes
+} PagerPageState;
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Public API
 // ─────────────────────────────────────────────────────────────────────────────
@@ -56,24 +177,55 @@ typedef struct Pager Pager;
 int         pager_open(const char* path, Pager** out);
 
 /**
- * @brief Close and free the Pager structure.
+ * @brief Same as pager_open(), with explicit configuration.
+ *
+ * Whatever the mode, a "<path>-wal" file left by a crash is replayed first:
+ * its committed transactions are copied into the database file. Without
+ * cfg->wal the log is then removed.
+ *
+ * @param path Path to the database file.
+ * @param cfg  Options (NULL = defaults). cache_pages must be 0 or
+ *             >= PAGER_MIN_CACHE_PAGES; page_size must be 0 or a power of
+ *             two in [PAGER_MIN_PAGE_SIZE, PAGER_MAX_PAGE_SIZE]
+ *             (PAGER_E_PAGESIZE otherwise). The pool holds cache_pages
+ *             frames of the file's page size. io_depth must be 0 or at
+ *             most PIO_MAX_DEPTH; an unavailable io_backend falls back to
+ *             PIO_BACKEND_SYNC. use_mmap requires read_only, which
+ *             excludes wal (PAGER_E_INVAL otherwise); a read-only open of
+ *             an empty file fails with PAGER_E_TRUNCATED, and of a file
+ *             with a log left to replay with PAGER_E_RECOVERY (a writable
+ *             open replays it). A read-only open never writes.
+ * @param out  Output pointer to receive an allocated Pager* on success.
+ * @return PAGER_OK or a negative PagerError code.
  */
-void        pager_close(Pager* p);
+int         pager_open_ex(const char* path, const PagerConfig* cfg, Pager** out);
 
 /**
- * @brief Read a page from the file.
+ * @brief Flush dirty pages, then close and free the Pager structure.
+ *        In WAL mode the log is checkpointed and removed.
+ *
+ * The Pager is freed whatever the result.
+ * @return PAGER_OK, PAGER_E_INVAL (NULL), or the error of the final flush
+ *         (or checkpoint) or close: changes made since the last flush may
+ *         not be in the file.
+ */
+int         pager_close(Pager* p);
+
+/**
+ * @brief Read a page (through the buffer pool).
  * @param p          Pager instance.
  * @param page_no    Page number (0-based).
  * @param out_page_buf Destination buffer (must be at least page_size bytes).
  * @return PAGER_OK or a negative PagerError code.
  */
-int         pager_read(const Pager* p, uint32_t page_no, void* out_page_buf);
+int         pager_read(Pager* p, uint32_t page_no, void* out_page_buf);
 
 /**
- * @brief Write one full page from memory to disk (Design A).
+ * @brief Write one full page (Design A, write-back).
  *
- * Writes exactly page_size bytes at offset page_no * page_size.
- * The pager must have been opened in read/write mode.
+ * Replaces the cached image of page_no with page_size bytes from page_buf
+ * and marks it dirty. The file is updated on eviction, pager_flush() or
+ * pager_close().
  *
  * @param[in] p         Pager handle (non-null).
  * @param[in] page_no   Page index (0-based, must be < page_count).
@@ -82,15 +234,86 @@ int         pager_read(const Pager* p, uint32_t page_no, void* out_page_buf);
  *         PAGER_E_INVAL for bad args,
  *         PAGER_E_RANGE if page_no >= page_count,
  *         PAGER_E_IO on I/O failure,
- *         PAGER_E_META if offset overflow detected.
+ *         PAGER_E_META if offset overflow detected,
+ *         PAGER_E_NOFRAME if every cache frame is pinned.
+ */
+int pager_write(Pager* p, uint32_t page_no, const void* page_buf);
+
+/**
+ * @brief Pin a page in the buffer pool for read-only, zero-copy access.
+ *
+ * The returned pointer addresses the cached frame itself (or, with
+ * PagerConfig.use_mmap, the file mapping when the page is not cached) and
+ * stays valid until the matching pager_unpin(). A pinned frame is never
+ * evicted and the mapping (read-only pagers only) is made once at open and
+ * never moves; callers must still keep pins short and always release them.
+ * A thread bound to a snapshot may get the snapshot's copy of the page
+ * instead (see pager_snapshot_begin).
+ *
+ * @param[in]  p        Pager handle.
+ * @param[in]  page_no  Page index (must be < page_count).
+ * @param[out] out_page Receives a pointer to page_size bytes.
+ * @return PAGER_OK, PAGER_E_INVAL, PAGER_E_RANGE, PAGER_E_IO or
+ *         PAGER_E_NOFRAME if every frame is already pinned.
+ */
+int pager_pin(Pager* p, uint32_t page_no, const void** out_page);
+
+/**
+ * @brief Pin a page for in-place modification.
+ *
+ * Same as pager_pin(), but the frame may be written through the returned
+ * pointer. Pass dirty = true to pager_unpin() if it was modified.
+ */
+int pager_pin_mut(Pager* p, uint32_t page_no, void** out_page);
+
+/**
+ * @brief Pin a page that is about to be rewritten from scratch.
+ *
+ * The frame is zero-filled and marked dirty without reading the old image
+ * from the file (typical right after pager_alloc_pages()).
+ */
+int pager_pin_zero(Pager* p, uint32_t page_no, void** out_page);
+
+/**
+ * @brief Release a pin taken by pager_pin() / pager_pin_mut() / pager_pin_zero().
+ *
+ * @param[in] p     Pager handle.
+ * @param[in] page  Pointer returned by the pin call.
+ * @param[in] dirty true if the page was modified while pinned.
+ * @return PAGER_OK, or PAGER_E_INVAL if `page` is not a pinned frame (or a
+ *         snapshot copy pinned by this thread, which cannot be dirty).
+ */
+int pager_unpin(Pager* p, const void* page, bool dirty);
+
+/**
+ * @brief State of a page pinned by the caller.
+ *
+ * The first call after the page was read from the file (or the log) checks
+ * its checksum, if it has one; the result holds until the page leaves the
+ * pool. An image given by pager_write() or pager_pin_zero() is UNCHECKED.
+ * Changes made through pager_pin_mut() keep the state: the writer is
+ * trusted to keep a trusted page valid. With PagerConfig.paranoid the
+ * state is never TRUSTED.
+ *
+ * Lock-free; the caller must hold the pin. A buffer that is not a pool
+ * frame or mapped page is always UNCHECKED.
  */
-int pager_write(const Pager* p, uint32_t page_no, const void* page_buf);
+PagerPageState pager_page_state(Pager* p, const void* page);
 
 /**
- * @brief Allocate a new blank page at the end of the file
+ * @brief Record that a caller validated a pinned page: pager_page_state()
+ *        reports it TRUSTED from now on, until it leaves the pool. No effect
+ *        on a CORRUPT page, a paranoid pager or a private buffer.
+ */
+void pager_page_trust(Pager* p, const void* page);
+
+/**
+ * @brief Allocate a new blank page: the head of the free list, or a new
+ *        one at the end of the file
  *
+ * - Reuses a page freed by pager_free_page() (zero-filled), else
  * - Extends the file by one page filled with zeros.
- * - Updates the in-memory and on-disk page_count.
+ * - Updates the in-memory page_count and the cached header page.
  * - Returns the new page number via out_page_no.
  *
  * @param[in,out] p           Pager handle (opened read/write).
@@ -99,12 +322,318 @@ int pager_write(const Pager* p, uint32_t page_no, const void* page_buf);
  */
 int pager_alloc_page(Pager* p, uint32_t* out_page_no);
 
+/**
+ * @brief Allocate `count` consecutive blank pages at the end of the file.
+ *
+ * Same contract as pager_alloc_page(), but the file is grown once and the
+ * header page_count is updated once for the whole group. The free list is
+ * not used, even for count == 1.
+ *
+ * @param[in,out] p                 Pager handle (opened read/write).
+ * @param[in]     count             Number of pages (>= 1).
+ * @param[out]    out_first_page_no Receives the first new page; the others follow.
+ * @return PAGER_OK on success or a negative PagerError on failure.
+ */
+int pager_alloc_pages(Pager* p, uint32_t count, uint32_t* out_first_page_no);
+
+/**
+ * @brief Put a page no longer in use on the file's free list.
+ *
+ * The page is overwritten with a free-page image; pager_alloc_page() hands
+ * it out again (zeroed) before growing the file. The caller must hold no
+ * pointer into it.
+ *
+ * @return PAGER_OK, PAGER_E_RANGE for page 0 or past page_count,
+ *         PAGER_E_INVAL if the page is already free, or PAGER_E_IO.
+ */
+int pager_free_page(Pager* p, uint32_t page_no);
+
+/**
+ * @brief Give the free pages at the end of the file back to the filesystem.
+ *
+ * The file loses its longest run of trailing free pages; the other free
+ * pages are relinked lowest first, so that allocation fills the front of
+ * the file. Everything is written out first (checkpointed in WAL mode),
+ * then the file is truncated.
+ *
+ * Inside a transaction (pager_txn_begin) nothing is released.
+ *
+ * @param out_released Optional: receives the number of pages dropped.
+ * @return PAGER_OK, PAGER_E_INVAL if one of those pages is still pinned,
+ *         PAGER_E_READONLY on a read-only pager, PAGER_E_META on a
+ *         damaged free list, or PAGER_E_IO.
+ */
+int pager_trim(Pager* p, uint32_t* out_released);
+
+/**
+ * @brief Pages on the free list.
+ */
+uint32_t pager_free_count(const Pager* p);
+
+/**
+ * @brief Load pages into the buffer pool ahead of use, several at a time.
+ *
+ * Pages not cached yet are read from the file through the I/O queue, up to
+ * pager_io_depth() of them in flight; they are left unpinned, so a later
+ * pager_pin() finds them in the pool. Pages already cached, served by the
+ * mapping or held in the log, page 0 and pages past page_count are skipped.
+ * At most pager_io_depth() pages (and a quarter of the pool) are loaded per
+ * call; the rest of `pages` is ignored. Safe to call from several threads.
+ *
+ * @return PAGER_OK, PAGER_E_INVAL, or PAGER_E_IO if a read failed (the page
+ *         is then simply not cached).
+ */
+int pager_prefetch(Pager* p, const uint32_t* pages, size_t n);
+
+/**
+ * @brief Tell the pager how the calling thread is about to read `p`.
+ *
+ * Cache misses that read the file are watched per thread: after
+ * PAGER_SEQ_TRIGGER misses on increasing pages (small gaps allowed), the
+ * next PagerConfig.readahead pages are announced to the kernel
+ * (posix_fadvise WILLNEED, or posix_madvise on the file mapping) and the
+ * window moves on as the reader gets halfway through it. SEQUENTIAL starts
+ * at the first miss, RANDOM turns it off. The hint applies to the calling
+ * thread and one pager at a time.
+ *
+ * @return The thread's previous hint for `p`, to restore when done.
+ */
+PagerAccess pager_set_access(Pager* p, PagerAccess access);
+
+/**
+ * @brief Pages announced to the kernel by sequential read-ahead so far, by
+ *        this pager (STAT_READAHEAD_PAGES counts them for the process).
+ */
+uint64_t pager_readahead_pages(const Pager* p);
+
+/**
+ * @brief Write all dirty cached pages back to the file.
+ *
+ * Data pages are written before the header page (page 0), as one batch
+ * through the I/O queue (pager_io_depth() writes in flight).
+ * In WAL mode this is pager_sync(): pages go to the log, not the file.
+ *
+ * @param[in] p Pager handle.
+ * @return PAGER_OK on success or a negative PagerError on failure.
+ */
+int pager_flush(Pager* p);
+
+/**
+ * @brief End a transaction: make every change so far atomic.
+ *
+ * In WAL mode the dirty pages are appended to the log, followed by the
+ * header page as the commit frame. Recovery replays a transaction only if
+ * its commit frame made it to disk, so a crash never leaves half of one.
+ * The log is fsynced once every `wal_group_commit` commits (group commit):
+ * a crash may lose the last few commits, never tear one. Once the log holds
+ * `wal_autocheckpoint` frames it is checkpointed into the database file.
+ *
+ * Without WAL this is pager_flush(). Inside a transaction (pager_txn_begin)
+ * nothing is written until it ends.
+ *
+ * @return PAGER_OK on success or a negative PagerError on failure.
+ */
+int pager_commit(Pager* p);
+
+/**
+ * @brief Commit, then make every commit durable (one fsync).
+ *
+ * WAL mode: fsyncs the log. Otherwise: pager_flush() + fsync of the file.
+ */
+int pager_sync(Pager* p);
+
+/**
+ * @brief Commit, sync and copy the log back into the database file.
+ *        The log is emptied afterwards. No-op without WAL.
+ */
+int pager_checkpoint(Pager* p);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Page buffers
+// ─────────────────────────────────────────────────────────────────────────────
+/* Scratch pages for callers that need a private page image (a page being
+ * rebuilt before it is copied into its frame, a copy for a snapshot). They
+ * come from a slab owned by the pager: page_size bytes aligned on the page
+ * size, like the pool's frames, so either can be handed to O_DIRECT reads
+ * and writes. The slab grows 16 buffers at a time and keeps what it grew
+ * until pager_close(), so once it covers the peak in use, getting and
+ * putting buffers makes no heap allocation. Safe from any thread. */
+
+/**
+ * @brief Borrow a page buffer (contents undefined).
+ * @return PAGER_OK, PAGER_E_INVAL, or PAGER_E_IO when out of memory.
+ */
+int pager_buf_get(Pager* p, void** out);
+
+/**
+ * @brief Give back a buffer from pager_buf_get().
+ */
+void pager_buf_put(Pager* p, void* buf);
+
+/**
+ * @brief Buffers the slab holds, in use or free (snapshot copies included).
+ */
+size_t pager_buf_count(const Pager* p);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Transactions
+// ─────────────────────────────────────────────────────────────────────────────
+/* A transaction groups changes that must reach the file together, and
+ * needs the write-ahead log (PagerConfig.wal). Between pager_txn_begin() and
+ * pager_txn_commit() dirty frames stay in the buffer pool, however often a
+ * page is changed; a frame evicted meanwhile goes to the log without a
+ * commit frame, so a transaction is not bounded by the pool. The commit
+ * logs the rest once, as one pager_commit(): one run of log frames sealed
+ * by a commit frame, which recovery replays whole or not at all.
+ * pager_txn_abort() drops them instead, frames in the pool and in the log,
+ * together with the pages allocated or freed meanwhile, so the file is left
+ * as it was at pager_txn_begin().
+ *
+ * The transaction is a write section of the thread that began it (see
+ * pager_write_begin): write sections of other threads, and snapshots, wait
+ * for its end, so a snapshot sees all of it or none. Other threads reading
+ * meanwhile see the pages as they were at pager_txn_begin(), through a
+ * snapshot of the transaction (its first change to a page copies the page
+ * aside). pager_flush(), pager_commit(), pager_sync() and
+ * pager_checkpoint() write nothing until the transaction ends, pager_trim()
+ * releases nothing, and pager_close() aborts it. */
+
+/**
+ * @brief Begin a transaction in the calling thread, after committing the
+ *        changes made so far (pager_commit). Waits for write sections in
+ *        other threads to end.
+ * @return PAGER_OK, PAGER_E_INVAL without a write-ahead log or if this
+ *         thread is already in a write section or transaction,
+ *         PAGER_E_READONLY from a thread bound to a snapshot or on a
+ *         read-only pager, or the error of the commit.
+ */
+int pager_txn_begin(Pager* p);
+
+/**
+ * @brief Log the transaction's pages as one commit (pager_commit) and end
+ *        it. On failure the transaction is over all the same, as after a
+ *        failed pager_commit().
+ * @return PAGER_OK, PAGER_E_INVAL if the calling thread has no transaction
+ *         open, PAGER_E_NOFRAME, or an I/O error.
+ */
+int pager_txn_commit(Pager* p);
+
+/**
+ * @brief Forget every change of the transaction and end it. Waits for
+ *        other threads to unpin the pages it changed.
+ * @return PAGER_OK, PAGER_E_INVAL if the calling thread has no
+ *         transaction open or still pins one of its pages, or PAGER_E_IO if
+ *         the log could not be rolled back (the transaction then stays open).
+ */
+int pager_txn_abort(Pager* p);
+
+/**
+ * @brief true while a transaction is open on `p` (in any thread).
+ */
+bool pager_txn_active(const Pager* p);
+
+/**
+ * @brief true if the calling thread has a transaction open on `p`: the only
+ *        thread that sees its changes.
+ */
+bool pager_txn_owned(Pager* p);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Snapshot reads
+// ─────────────────────────────────────────────────────────────────────────────
+/* A snapshot freezes the database as it was when the snapshot began. The
+ * threads bound to it see every page as of that point through pager_pin(),
+ * and pager_read(), while writers keep changing the live
+ * pages: the first time a page is pinned for writing after a snapshot began,
+ * its old image is copied aside (there is at most one copy per page and
+ * snapshot), and copies no active snapshot can see are dropped when a
+ * snapshot ends. Only pages nobody changed since the snapshot began are
+ * latched by its readers (for the duration of the pin, as usual); a copy is
+ * never written, so its readers do not hold up the writer.
+ *
+ * Snapshots begin between write sections (pager_write_begin), so they never
+ * see half of one. Snapshot pins bypass the file mapping and are served from
+ * the pool or the copies; they use the same pager_unpin() and must be
+ * released by the thread that took them, before the snapshot ends. */
+typedef struct PagerSnapshot PagerSnapshot;
+
+/**
+ * @brief Start a snapshot of the current state and bind it to the calling
+ *        thread (see pager_snapshot_bind). Waits for a write section in
+ *        another thread to end.
+ * @return PAGER_OK, PAGER_E_INVAL, PAGER_E_READONLY if the calling thread is
+ *         inside a write section, or PAGER_E_IO (out of memory).
+ */
+int pager_snapshot_begin(Pager* p, PagerSnapshot** out);
+
+/**
+ * @brief End a snapshot: unbind it from the calling thread and free the
+ *        page copies only it could see. Other threads must have unbound it.
+ */
+int pager_snapshot_end(Pager* p, PagerSnapshot* s);
+
+/**
+ * @brief Make the calling thread read through `s` (NULL: the live pages
+ *        again), e.g. a worker of a scan started under a snapshot. A bound
+ *        thread cannot write: pins for writing, pager_write(), allocation
+ *        and pager_free_page() fail with PAGER_E_READONLY.
+ */
+int pager_snapshot_bind(Pager* p, PagerSnapshot* s);
+
+/**
+ * @brief Snapshot the calling thread is bound to on `p`, or NULL.
+ */
+PagerSnapshot* pager_snapshot_current(const Pager* p);
+
+/**
+ * @brief Page images currently kept for snapshots.
+ */
+size_t pager_snapshot_pages(const Pager* p);
+
+/**
+ * @brief Bracket a change that spans several pages (an insert with its
+ *        index and catalog updates, a vacuum) so that no snapshot begins
+ *        in the middle of it. Sections nest within a thread; a section in
+ *        another thread waits for this one to end.
+ * @return PAGER_OK, PAGER_E_INVAL, or PAGER_E_READONLY from a thread bound
+ *         to a snapshot.
+ */
+int  pager_write_begin(Pager* p);
+void pager_write_end(Pager* p);
+
 /**
  * @brief Retrieve page geometry information.
  */
 size_t      pager_page_size(const Pager* p);
 uint32_t    pager_page_count(const Pager* p);
 
+/**
+ * @brief Format version recorded in the file header (1 or 2). It is set
+ *        when the file is created and never changes afterwards.
+ */
+uint32_t    pager_format_version(const Pager* p);
+
+/**
+ * @brief Number of frames in the buffer pool.
+ */
+size_t      pager_cache_pages(const Pager* p);
+
+/**
+ * @brief I/O queue backend in use (never PIO_BACKEND_AUTO) and its depth.
+ */
+PioBackend  pager_io_backend(const Pager* p);
+unsigned    pager_io_depth(const Pager* p);
+
+/**
+ * @brief Read / set the catalog page recorded in the file header.
+ *
+ * The pager only stores the page number (0 = no catalog yet); the catalog
+ * itself is managed by catalog.c. The header page is updated through the
+ * cache, like page_count, and the getter reads an in-memory copy.
+ */
+int         pager_get_catalog(Pager* p, uint32_t* out_page_no);
+int         pager_set_catalog(Pager* p, uint32_t page_no);
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Utilities
 // ─────────────────────────────────────────────────────────────────────────────
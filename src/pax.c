@@ -0,0 +1,225 @@
+#include "pax.h"
+#include "table.h"
+#include "endian_util.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static inline size_t bitmap_bytes(size_t cap) {
+  return (cap + 7u) / 8u;
+}
+
+/**
+ * @brief Offset of the column directory: right after the bitmap.
+ */
+static inline size_t dir_off(size_t cap) {
+  return TABLE_HDR_SIZE + bitmap_bytes(cap);
+}
+
+/**
+ * @brief Offset of the minipages: first 8-byte boundary after the directory.
+ */
+static inline size_t data_off(size_t cap, unsigned ncols) {
+  return (dir_off(cap) + 1u + ncols + 7u) & ~(size_t)7u;
+}
+
+static inline unsigned col_count(const uint8_t* page) {
+  return page[dir_off(tbl_get_capacity(page))];
+}
+
+static inline const uint8_t* col_starts(const uint8_t* page) {
+  return page + dir_off(tbl_get_capacity(page)) + 1u;
+}
+
+static inline unsigned col_end(const uint8_t* start, unsigned n, unsigned c) {
+  return c + 1u < n ? start[c + 1u] : TABLE_RECORD_SIZE;
+}
+
+/**
+ * @brief Starts ascending from 0, all inside the record.
+ */
+static bool layout_ok(const uint8_t* start, unsigned n) {
+  if (n < 1 || n > PAX_MAX_COLUMNS || start[0] != 0) return false;
+  for (unsigned c = 1; c < n; c++)
+    if (start[c] <= start[c - 1u] || start[c] >= TABLE_RECORD_SIZE) return false;
+  return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Layouts
+// ─────────────────────────────────────────────────────────────────────────────
+void pax_layout_init(PaxLayout* l) {
+  memset(l, 0, sizeof *l);
+  l->n = 1;
+}
+
+/**
+ * @brief Make `at` a column boundary (a no-op at 0, at the record's end,
+ *        or where one already is).
+ */
+static int layout_split(PaxLayout* l, unsigned at) {
+  if (at == 0 || at >= TABLE_RECORD_SIZE) return TABLE_OK;
+  unsigned c = 0;
+  while (c < l->n && l->start[c] < at) c++;
+  if (c < l->n && l->start[c] == at) return TABLE_OK;
+  if (l->n >= PAX_MAX_COLUMNS) return TABLE_E_FULL;
+  memmove(l->start + c + 1, l->start + c, l->n - c);
+  l->start[c] = (uint8_t)at;
+  l->n++;
+  return TABLE_OK;
+}
+
+int pax_layout_add(PaxLayout* l, uint16_t off, uint16_t len) {
+  if (!l || len == 0 || off >= TABLE_RECORD_SIZE || len > TABLE_RECORD_SIZE - off)
+    return TABLE_E_INVAL;
+  const PaxLayout before = *l;
+  int rc = layout_split(l, off);
+  if (rc == TABLE_OK) rc = layout_split(l, (unsigned)off + len);
+  if (rc != TABLE_OK) *l = before;
+  return rc;
+}
+
+void pax_layout_of(const void* page, PaxLayout* out) {
+  const uint8_t* b = (const uint8_t*)page;
+  memset(out, 0, sizeof *out);
+  out->n = (uint8_t)col_count(b);
+  memcpy(out->start, col_starts(b), out->n);
+}
+
+uint16_t pax_col_width(const PaxLayout* l, unsigned c) {
+  return c < l->n ? (uint16_t)(col_end(l->start, l->n, c) - l->start[c]) : 0;
+}
+
+uint16_t pax_capacity(size_t page_size, unsigned ncols) {
+  if (page_size <= TABLE_HDR_SIZE + TABLE_LEAF_CRC_SIZE) return 0;
+  size_t c = (page_size - TABLE_HDR_SIZE - TABLE_LEAF_CRC_SIZE) / TABLE_RECORD_SIZE;
+  if (c > UINT16_MAX) c = UINT16_MAX;
+  for (; c > 0; c--)
+    if (data_off(c, ncols) + c * TABLE_RECORD_SIZE + TABLE_LEAF_CRC_SIZE <= page_size)
+      return (uint16_t)c;
+  return 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Pages
+// ─────────────────────────────────────────────────────────────────────────────
+int pax_init(void* page, size_t page_size, const PaxLayout* layout) {
+  if (!page || !layout || !layout_ok(layout->start, layout->n)) return TABLE_E_INVAL;
+  const uint16_t cap = pax_capacity(page_size, layout->n);
+  if (cap == 0) return TABLE_E_LAYOUT;
+
+  uint8_t* b = (uint8_t*)page;
+  memset(b, 0, page_size);
+  write_le_u16(b + TABLE_HDR_KIND_OFF, TABLE_PAGE_KIND_PAX);
+  write_le_u16(b + TABLE_HDR_RECORD_SIZE_OFF, TABLE_RECORD_SIZE);
+  write_le_u16(b + TABLE_HDR_CAPACITY_OFF, cap);
+  b[dir_off(cap)] = layout->n;
+  memcpy(b + dir_off(cap) + 1u, layout->start, layout->n);
+  return TABLE_OK;
+}
+
+int pax_validate(const void* page, size_t page_size) {
+  if (!page || page_size <= TABLE_HDR_SIZE)
+    return TABLE_E_INVAL;
+
+  const uint8_t* b = (const uint8_t*)page;
+  if (tbl_get_kind(b) != TABLE_PAGE_KIND_PAX)
+    return TABLE_E_BADKIND;
+
+  // The directory sits after the bitmap: bound the capacity before reading it
+  const uint16_t cap = tbl_get_capacity(b);
+  const uint16_t used = tbl_get_used_count(b);
+  if (tbl_get_record_size(b) != TABLE_RECORD_SIZE || cap < 1 || used > cap ||
+      dir_off(cap) + 1u + PAX_MAX_COLUMNS > page_size)
+    return TABLE_E_LAYOUT;
+  const unsigned n = col_count(b);
+  if (!layout_ok(col_starts(b), n) || cap != pax_capacity(page_size, n))
+    return TABLE_E_LAYOUT;
+
+  // Bits past capacity can only live in the last byte
+  const uint8_t* bm = b + TABLE_HDR_SIZE;
+  size_t pop = 0;
+  for (size_t i = 0; i < bitmap_bytes(cap); i++)
+    pop += (size_t)__builtin_popcount(bm[i]);
+  if (pop != used || (cap % 8u && (bm[cap / 8u] >> (cap % 8u)) != 0))
+    return TABLE_E_BITMAP;
+  return TABLE_OK;
+}
+
+uint64_t pax_select(const void* page, const uint64_t bytes[2]) {
+  const uint8_t* b = (const uint8_t*)page;
+  const unsigned n = col_count(b);
+  const uint8_t* start = col_starts(b);
+  uint64_t cols = 0;
+  for (unsigned c = 0; c < n; c++)
+    for (unsigned k = start[c]; k < col_end(start, n, c); k++)
+      if (bytes[k / 64u] >> (k % 64u) & 1u) { cols |= UINT64_C(1) << c; break; }
+  return cols;
+}
+
+void pax_get(const void* page, int slot, void* out, uint64_t cols) {
+  const uint8_t* b = (const uint8_t*)page;
+  const uint16_t cap = tbl_get_capacity(b);
+  const unsigned n = col_count(b);
+  const uint8_t* start = col_starts(b);
+  const uint8_t* data = b + data_off(cap, n);
+  uint8_t* rec = (uint8_t*)out;
+  for (unsigned c = 0; c < n; c++) {
+    if (!(cols >> c & 1u)) continue;
+    const size_t w = col_end(start, n, c) - start[c];
+    memcpy(rec + start[c], data + (size_t)cap * start[c] + (size_t)slot * w, w);
+  }
+}
+
+void pax_put(void* page, int slot, const void* rec) {
+  uint8_t* b = (uint8_t*)page;
+  const uint16_t cap = tbl_get_capacity(b);
+  const unsigned n = col_count(b);
+  const uint8_t* start = col_starts(b);
+  uint8_t* data = b + data_off(cap, n);
+  const uint8_t* r = (const uint8_t*)rec;
+  for (unsigned c = 0; c < n; c++) {
+    const size_t w = col_end(start, n, c) - start[c];
+    memcpy(data + (size_t)cap * start[c] + (size_t)slot * w, r + start[c], w);
+  }
+}
+
+const uint8_t* pax_field(const void* page, uint16_t off, uint16_t len, size_t* stride) {
+  const uint8_t* b = (const uint8_t*)page;
+  const uint16_t cap = tbl_get_capacity(b);
+  const unsigned n = col_count(b);
+  const uint8_t* start = col_starts(b);
+  unsigned c = 0;
+  while (c + 1u < n && start[c + 1u] <= off) c++;
+  if ((unsigned)off + len > col_end(start, n, c)) return NULL;
+  *stride = col_end(start, n, c) - start[c];
+  return b + data_off(cap, n) + (size_t)cap * start[c] + (off - start[c]);
+}
+
+size_t pax_image_size(uint16_t capacity) {
+  return TABLE_HDR_SIZE + bitmap_bytes(capacity) + (size_t)capacity * TABLE_RECORD_SIZE;
+}
+
+void pax_decode(const void* page, void* image) {
+  const uint8_t* b = (const uint8_t*)page;
+  uint8_t* img = (uint8_t*)image;
+  const uint16_t cap = tbl_get_capacity(b);
+  memcpy(img, b, dir_off(cap));
+  for (int i = 0; i < cap; i++)
+    pax_get(b, i, tbl_slot_ptr(img, i), PAX_ALL_COLUMNS);
+}
+
+int pax_decode_buf(const void* page, uint8_t** buf, size_t* buf_cap) {
+  const size_t need = pax_image_size(tbl_get_capacity(page));
+  if (need > *buf_cap) {
+    uint8_t* grown = realloc(*buf, need);
+    if (!grown) return TABLE_E_INVAL;
+    *buf = grown;
+    *buf_cap = need;
+  }
+  pax_decode(page, *buf);
+  return TABLE_OK;
+}
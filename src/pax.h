@@ -0,0 +1,138 @@
+#ifndef PAX_H
+
+#define PAX_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* PAX leaf: fixed-size records, stored column by column
+ * - Page type: TABLE_PAGE_KIND_PAX (0x000E), see table.h
+ * - Bytes 0..23 are a TABLE_LEAF header, followed by the slot bitmap as in
+ *   a TABLE_LEAF; the tbl_get/set_* and bitmap accessors work on it.
+ * - Then the column directory: ncols (u8, 1..PAX_MAX_COLUMNS), then the
+ *   first record byte of each column (u8, ascending, the first 0). Column
+ *   c covers record bytes [start[c], start[c+1]), the last one up to
+ *   TABLE_RECORD_SIZE.
+ * - At the next 8-byte boundary, the minipages: column c of all `capacity`
+ *   slots, back to back, at capacity * start[c] bytes into the area. The
+ *   bytes of slot i sit at i * width(c) in its minipage, so one field is a
+ *   dense array a scan reads without touching the other columns.
+ * - Capacity is the largest that fits before the checksum: a TABLE_LEAF's
+ *   (31 slots on 4 KiB pages), or one less on large pages with many columns.
+ * - Ends with a pager checksum, as a TABLE_LEAF (PAGER_CRC_PAX_KIND).
+ * Each page carries its own directory; every leaf of a table created by
+ * tblmgr_create_pax() copies the root's.
+ * All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define PAX_MAX_COLUMNS             64  /* columns fit one bit each in a u64 */
+#define PAX_ALL_COLUMNS             UINT64_MAX
+
+/**
+ * @brief A column directory: n columns, column c starting at record byte
+ *        start[c].
+ */
+typedef struct PaxLayout {
+  uint8_t n;
+  uint8_t start[PAX_MAX_COLUMNS];
+} PaxLayout;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief One column covering the whole record.
+ */
+void     pax_layout_init(PaxLayout* l);
+
+/**
+ * @brief Split the columns so that record bytes [off, off+len) start and
+ *        end on column boundaries (the field becomes one or more columns
+ *        of its own).
+ * @return TABLE_OK, TABLE_E_INVAL for a field outside the record, or
+ *         TABLE_E_FULL past PAX_MAX_COLUMNS columns (layout unchanged).
+ */
+int      pax_layout_add(PaxLayout* l, uint16_t off, uint16_t len);
+
+/**
+ * @brief Read the directory of a validated PAX leaf.
+ */
+void     pax_layout_of(const void* page, PaxLayout* out);
+
+/**
+ * @brief Width in bytes of column c of a layout.
+ */
+uint16_t pax_col_width(const PaxLayout* l, unsigned c);
+
+/**
+ * @brief Slots of a PAX leaf with `ncols` columns (0 if none fit).
+ */
+uint16_t pax_capacity(size_t page_size, unsigned ncols);
+
+/**
+ * @brief Initialize an empty PAX leaf with the given layout (zeroes the page).
+ * @return TABLE_OK, TABLE_E_INVAL for a malformed layout (see the page
+ *         description), or TABLE_E_LAYOUT if the page is too small.
+ */
+int      pax_init(void* page, size_t page_size, const PaxLayout* layout);
+
+/**
+ * @brief Validate a PAX leaf: kind, header fields, capacity against the
+ *        directory, the directory itself, bitmap against used_count.
+ * @return TABLE_OK, TABLE_E_INVAL, TABLE_E_BADKIND, TABLE_E_LAYOUT or
+ *         TABLE_E_BITMAP.
+ */
+int      pax_validate(const void* page, size_t page_size);
+
+/**
+ * @brief Columns of a validated PAX leaf that hold any of the record
+ *        bytes in `bytes` (bit k of bytes[k / 64] = record byte k).
+ * @return One bit per column.
+ */
+uint64_t pax_select(const void* page, const uint64_t bytes[2]);
+
+/**
+ * @brief Assemble record `slot` of a validated PAX leaf from the columns
+ *        set in `cols` (PAX_ALL_COLUMNS: the whole record); the bytes of
+ *        the other columns in `out` are left alone.
+ */
+void     pax_get(const void* page, int slot, void* out, uint64_t cols);
+
+/**
+ * @brief Scatter a whole record into slot `slot` of a validated PAX leaf
+ *        (the bitmap is left to the caller).
+ */
+void     pax_put(void* page, int slot, const void* rec);
+
+/**
+ * @brief Record bytes [off, off+len) of slot 0 of a validated PAX leaf,
+ *        when one column holds all of them: slot i's follow at i * *stride.
+ * @return NULL when the field spans columns.
+ */
+const uint8_t* pax_field(const void* page, uint16_t off, uint16_t len, size_t* stride);
+
+/**
+ * @brief Bytes of the TABLE_LEAF image pax_decode() writes for a PAX leaf
+ *        of `capacity` slots: header, bitmap, records.
+ */
+size_t   pax_image_size(uint16_t capacity);
+
+/**
+ * @brief Decode a validated PAX leaf into a TABLE_LEAF image of
+ *        pax_image_size() bytes (its kind word stays TABLE_PAGE_KIND_PAX):
+ *        tbl_slot_ptr_c(), tbl_slot_word() and the slot iterator work on it.
+ */
+void     pax_decode(const void* page, void* image);
+
+/**
+ * @brief pax_decode() into a heap buffer grown as needed (free() it).
+ * @return TABLE_OK, or TABLE_E_INVAL when out of memory.
+ */
+int      pax_decode_buf(const void* page, uint8_t** buf, size_t* buf_cap);
+
+#endif // PAX_H
@@ -0,0 +1,548 @@
+#define _GNU_SOURCE
+#include "pio.h"
+#include "pager.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && !defined(PIO_NO_URING) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define PIO_HAVE_URING 1
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Private types
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief One in-flight request: `done` bytes are already transferred, `iov`
+ *        describes the rest (io_uring reads it when the entry is submitted).
+ */
+typedef struct PioSlot {
+  PioReq*      req;
+  size_t       done;
+  struct iovec iov;
+} PioSlot;
+
+#ifdef PIO_HAVE_URING
+/**
+ * @brief The three shared mappings of an io_uring instance.
+ */
+typedef struct Uring {
+  int                  fd;
+  uint8_t*             sq_map;
+  size_t               sq_map_len;
+  uint8_t*             cq_map;        // == sq_map with IORING_FEAT_SINGLE_MMAP
+  size_t               cq_map_len;
+  struct io_uring_sqe* sqes;
+  size_t               sqes_len;
+  uint32_t*            sq_head;
+  uint32_t*            sq_tail;
+  uint32_t*            sq_array;
+  uint32_t             sq_mask;
+  uint32_t             sq_entries;
+  uint32_t*            cq_head;
+  uint32_t*            cq_tail;
+  struct io_uring_cqe* cqes;
+  uint32_t             cq_mask;
+  unsigned             unsubmitted;   // entries queued since the last enter
+} Uring;
+#endif
+
+struct PioQueue {
+  PioBackend backend;
+  unsigned   depth;
+  unsigned   inflight;
+  PioSlot*   slots;       // depth entries
+  uint32_t*  free_slots;  // stack of unused slot indices
+  unsigned   nfree;
+
+  // Completed slots not reaped yet (SYNC, THREADS): FIFO of depth entries
+  uint32_t*  done;
+  unsigned   done_head, done_count;
+
+  // THREADS: FIFO of slots waiting for a worker, same size
+  uint32_t*  todo;
+  unsigned   todo_head, todo_count;
+  pthread_t  threads[PIO_MAX_THREADS];
+  unsigned   nthreads;
+  bool       stop;
+  pthread_mutex_t lock;
+  pthread_cond_t  work_cv;   // todo became non-empty, or stop
+  pthread_cond_t  done_cv;   // done became non-empty
+
+#ifdef PIO_HAVE_URING
+  Uring      ring;
+#endif
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Private helpers
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Blocking transfer of what is left of a slot (EINTR and short
+ *        transfers). Sets the request's result.
+ */
+static void slot_run(PioSlot* s) {
+  PioReq* r = s->req;
+  while (s->done < r->len) {
+    char* at = (char*)r->buf + s->done;
+    const off_t off = r->off + (off_t)s->done;
+    ssize_t n = r->write ? pwrite(r->fd, at, r->len - s->done, off)
+                         : pread(r->fd, at, r->len - s->done, off);
+    if (n > 0) {
+      s->done += (size_t)n;
+    } else if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    } else {
+      r->result = PAGER_E_IO;
+      return;
+    }
+  }
+  r->result = PAGER_OK;
+}
+
+static inline void fifo_push(uint32_t* fifo, unsigned cap, unsigned head, unsigned* count, uint32_t v) {
+  fifo[(head + *count) % cap] = v;
+  (*count)++;
+}
+
+static inline uint32_t fifo_pop(const uint32_t* fifo, unsigned cap, unsigned* head, unsigned* count) {
+  const uint32_t v = fifo[*head];
+  *head = (*head + 1) % cap;
+  (*count)--;
+  return v;
+}
+
+/**
+ * @brief Hand a finished slot back to the caller and recycle it.
+ */
+static PioReq* slot_finish(PioQueue* q, uint32_t idx) {
+  PioReq* r = q->slots[idx].req;
+  q->slots[idx].req = NULL;
+  q->free_slots[q->nfree++] = idx;
+  q->inflight--;
+  return r;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Thread-pool backend
+// ─────────────────────────────────────────────────────────────────────────────
+static void* pool_worker(void* arg) {
+  PioQueue* q = (PioQueue*)arg;
+  pthread_mutex_lock(&q->lock);
+  for (;;) {
+    while (q->todo_count == 0 && !q->stop)
+      pthread_cond_wait(&q->work_cv, &q->lock);
+    if (q->todo_count == 0)
+      break;
+    const uint32_t idx = fifo_pop(q->todo, q->depth, &q->todo_head, &q->todo_count);
+    pthread_mutex_unlock(&q->lock);
+    slot_run(&q->slots[idx]);
+    pthread_mutex_lock(&q->lock);
+    fifo_push(q->done, q->depth, q->done_head, &q->done_count, idx);
+    pthread_cond_signal(&q->done_cv);
+  }
+  pthread_mutex_unlock(&q->lock);
+  return NULL;
+}
+
+static int pool_start(PioQueue* q) {
+  if (pthread_mutex_init(&q->lock, NULL) != 0)
+    return PAGER_E_IO;
+  if (pthread_cond_init(&q->work_cv, NULL) != 0) {
+    pthread_mutex_destroy(&q->lock);
+    return PAGER_E_IO;
+  }
+  if (pthread_cond_init(&q->done_cv, NULL) != 0) {
+    pthread_cond_destroy(&q->work_cv);
+    pthread_mutex_destroy(&q->lock);
+    return PAGER_E_IO;
+  }
+
+  const unsigned want = q->depth < PIO_MAX_THREADS ? q->depth : PIO_MAX_THREADS;
+  while (q->nthreads < want &&
+         pthread_create(&q->threads[q->nthreads], NULL, pool_worker, q) == 0)
+    q->nthreads++;
+  return PAGER_OK;
+}
+
+static void pool_stop(PioQueue* q) {
+  pthread_mutex_lock(&q->lock);
+  q->stop = true;
+  pthread_cond_broadcast(&q->work_cv);
+  pthread_mutex_unlock(&q->lock);
+  for (unsigned i = 0; i < q->nthreads; i++)
+    pthread_join(q->threads[i], NULL);
+  pthread_cond_destroy(&q->done_cv);
+  pthread_cond_destroy(&q->work_cv);
+  pthread_mutex_destroy(&q->lock);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// io_uring backend
+// ─────────────────────────────────────────────────────────────────────────────
+#ifdef PIO_HAVE_URING
+static int uring_enter(Uring* u, unsigned to_submit, unsigned min_complete) {
+  const unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  for (;;) {
+    long n = syscall(__NR_io_uring_enter, u->fd, to_submit, min_complete, flags, NULL, 0);
+    if (n >= 0) {
+      u->unsubmitted -= (unsigned)n <= u->unsubmitted ? (unsigned)n : u->unsubmitted;
+      return PAGER_OK;
+    }
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      return PAGER_E_IO;
+  }
+}
+
+static void uring_close(Uring* u) {
+  if (u->sqes)
+    munmap(u->sqes, u->sqes_len);
+  if (u->cq_map && u->cq_map != u->sq_map)
+    munmap(u->cq_map, u->cq_map_len);
+  if (u->sq_map)
+    munmap(u->sq_map, u->sq_map_len);
+  if (u->fd >= 0)
+    close(u->fd);
+  memset(u, 0, sizeof *u);
+  u->fd = -1;
+}
+
+static int uring_open(Uring* u, unsigned depth) {
+  memset(u, 0, sizeof *u);
+  struct io_uring_params prm;
+  memset(&prm, 0, sizeof prm);
+  long fd = syscall(__NR_io_uring_setup, depth, &prm);
+  if (fd < 0) {
+    u->fd = -1;
+    return PAGER_E_IO;
+  }
+  u->fd = (int)fd;
+
+  u->sq_map_len = prm.sq_off.array + prm.sq_entries * sizeof(uint32_t);
+  u->cq_map_len = prm.cq_off.cqes + prm.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single = (prm.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single) {
+    if (u->cq_map_len > u->sq_map_len) u->sq_map_len = u->cq_map_len;
+    u->cq_map_len = u->sq_map_len;
+  }
+
+  void* m = mmap(NULL, u->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 u->fd, IORING_OFF_SQ_RING);
+  if (m == MAP_FAILED) { uring_close(u); return PAGER_E_IO; }
+  u->sq_map = (uint8_t*)m;
+
+  if (single) {
+    u->cq_map = u->sq_map;
+  } else {
+    m = mmap(NULL, u->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             u->fd, IORING_OFF_CQ_RING);
+    if (m == MAP_FAILED) { uring_close(u); return PAGER_E_IO; }
+    u->cq_map = (uint8_t*)m;
+  }
+
+  u->sqes_len = prm.sq_entries * sizeof(struct io_uring_sqe);
+  m = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+           u->fd, IORING_OFF_SQES);
+  if (m == MAP_FAILED) { uring_close(u); return PAGER_E_IO; }
+  u->sqes = (struct io_uring_sqe*)m;
+
+  u->sq_head    = (uint32_t*)(u->sq_map + prm.sq_off.head);
+  u->sq_tail    = (uint32_t*)(u->sq_map + prm.sq_off.tail);
+  u->sq_array   = (uint32_t*)(u->sq_map + prm.sq_off.array);
+  u->sq_mask    = *(uint32_t*)(u->sq_map + prm.sq_off.ring_mask);
+  u->sq_entries = prm.sq_entries;
+  u->cq_head    = (uint32_t*)(u->cq_map + prm.cq_off.head);
+  u->cq_tail    = (uint32_t*)(u->cq_map + prm.cq_off.tail);
+  u->cqes       = (struct io_uring_cqe*)(u->cq_map + prm.cq_off.cqes);
+  u->cq_mask    = *(uint32_t*)(u->cq_map + prm.cq_off.ring_mask);
+  return PAGER_OK;
+}
+
+/**
+ * @brief Queue the remainder of a slot as a READV / WRITEV entry; it reaches
+ *        the kernel with the next io_uring_enter.
+ */
+static int uring_queue(PioQueue* q, uint32_t idx) {
+  Uring* u = &q->ring;
+  const uint32_t tail = *u->sq_tail;
+  if (tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= u->sq_entries) {
+    int rc = uring_enter(u, u->unsubmitted, 0);
+    if (rc != PAGER_OK) return rc;
+  }
+
+  PioSlot* s = &q->slots[idx];
+  s->iov.iov_base = (char*)s->req->buf + s->done;
+  s->iov.iov_len  = s->req->len - s->done;
+
+  const uint32_t at = tail & u->sq_mask;
+  struct io_uring_sqe* sqe = &u->sqes[at];
+  memset(sqe, 0, sizeof *sqe);
+  sqe->opcode    = s->req->write ? IORING_OP_WRITEV : IORING_OP_READV;
+  sqe->fd        = s->req->fd;
+  sqe->addr      = (uint64_t)(uintptr_t)&s->iov;
+  sqe->len       = 1;
+  sqe->off       = (uint64_t)(s->req->off + (off_t)s->done);
+  sqe->user_data = idx;
+  u->sq_array[at] = at;
+  __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  u->unsubmitted++;
+  return PAGER_OK;
+}
+
+/**
+ * @brief Submit what is queued and wait for one completion; resume a short
+ *        or interrupted transfer instead of reporting it.
+ * @return The finished slot index, or a negative PagerError.
+ */
+static long uring_reap(PioQueue* q) {
+  Uring* u = &q->ring;
+  for (;;) {
+    uint32_t head = *u->cq_head;
+    if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+      int rc = uring_enter(u, u->unsubmitted, 1);
+      if (rc != PAGER_OK) return rc;
+      continue;
+    }
+
+    const struct io_uring_cqe* cqe = &u->cqes[head & u->cq_mask];
+    const uint32_t idx = (uint32_t)cqe->user_data;
+    const int res = cqe->res;
+    __atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+
+    PioSlot* s = &q->slots[idx];
+    if (res > 0) {
+      s->done += (size_t)res;
+      if (s->done < s->req->len) {
+        int rc = uring_queue(q, idx);
+        if (rc != PAGER_OK) { s->req->result = rc; return idx; }
+        continue;
+      }
+      s->req->result = PAGER_OK;
+    } else if (res == -EINTR || res == -EAGAIN) {
+      int rc = uring_queue(q, idx);
+      if (rc != PAGER_OK) { s->req->result = rc; return idx; }
+      continue;
+    } else {
+      s->req->result = PAGER_E_IO;   // error, or end of file on a read
+    }
+    return idx;
+  }
+}
+#endif // PIO_HAVE_URING
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+static int open_backend(PioQueue* q, PioBackend backend) {
+  q->backend = backend;
+  switch (backend) {
+    case PIO_BACKEND_SYNC:
+      q->depth = 1;
+      return PAGER_OK;
+    case PIO_BACKEND_THREADS: {
+      int rc = pool_start(q);
+      if (rc == PAGER_OK && q->nthreads == 0) {
+        pool_stop(q);
+        rc = PAGER_E_IO;
+      }
+      return rc;
+    }
+    case PIO_BACKEND_URING:
+#ifdef PIO_HAVE_URING
+      return uring_open(&q->ring, q->depth);
+#else
+      return PAGER_E_IO;
+#endif
+    default:
+      return PAGER_E_INVAL;
+  }
+}
+
+int pio_open(PioBackend backend, unsigned depth, PioQueue** out) {
+  if (!out || depth == 0 || depth > PIO_MAX_DEPTH)
+    return PAGER_E_INVAL;
+  *out = NULL;
+
+  PioQueue* q = calloc(1, sizeof *q);
+  if (!q)
+    return PAGER_E_IO;
+  q->slots      = calloc(depth, sizeof *q->slots);
+  q->free_slots = calloc(depth, sizeof *q->free_slots);
+  q->done       = calloc(depth, sizeof *q->done);
+  q->todo       = calloc(depth, sizeof *q->todo);
+  if (!q->slots || !q->free_slots || !q->done || !q->todo) {
+    free(q->slots); free(q->free_slots); free(q->done); free(q->todo);
+    free(q);
+    return PAGER_E_IO;
+  }
+#ifdef PIO_HAVE_URING
+  q->ring.fd = -1;
+#endif
+
+  int rc;
+  if (backend == PIO_BACKEND_AUTO) {
+    static const PioBackend order[] = { PIO_BACKEND_URING, PIO_BACKEND_THREADS, PIO_BACKEND_SYNC };
+    rc = PAGER_E_IO;
+    for (size_t i = 0; i < sizeof order / sizeof order[0] && rc != PAGER_OK; i++) {
+      q->depth = depth;
+      rc = open_backend(q, order[i]);
+    }
+  } else {
+    q->depth = depth;
+    rc = open_backend(q, backend);
+  }
+  if (rc != PAGER_OK) {
+    free(q->slots); free(q->free_slots); free(q->done); free(q->todo);
+    free(q);
+    return rc;
+  }
+
+  for (unsigned i = 0; i < q->depth; i++)
+    q->free_slots[q->nfree++] = q->depth - 1 - i;
+  *out = q;
+  return PAGER_OK;
+}
+
+void pio_close(PioQueue* q) {
+  if (!q)
+    return;
+  PioReq* r = NULL;
+  while (q->inflight > 0 && pio_complete(q, &r) == PAGER_OK) {}
+
+  if (q->backend == PIO_BACKEND_THREADS)
+    pool_stop(q);
+#ifdef PIO_HAVE_URING
+  if (q->backend == PIO_BACKEND_URING)
+    uring_close(&q->ring);
+#endif
+  free(q->slots);
+  free(q->free_slots);
+  free(q->done);
+  free(q->todo);
+  free(q);
+}
+
+PioBackend pio_backend(const PioQueue* q) {
+  return q ? q->backend : PIO_BACKEND_AUTO;
+}
+
+unsigned pio_depth(const PioQueue* q) {
+  return q ? q->depth : 0;
+}
+
+unsigned pio_inflight(const PioQueue* q) {
+  return q ? q->inflight : 0;
+}
+
+int pio_submit(PioQueue* q, PioReq* req) {
+  if (!q || !req || !req->buf || req->len == 0 || req->off < 0)
+    return PAGER_E_INVAL;
+  if (q->nfree == 0)
+    return PAGER_E_INVAL;
+
+  const uint32_t idx = q->free_slots[--q->nfree];
+  PioSlot* s = &q->slots[idx];
+  s->req  = req;
+  s->done = 0;
+  req->result = PAGER_OK;
+  q->inflight++;
+
+  switch (q->backend) {
+    case PIO_BACKEND_THREADS:
+      pthread_mutex_lock(&q->lock);
+      fifo_push(q->todo, q->depth, q->todo_head, &q->todo_count, idx);
+      pthread_cond_signal(&q->work_cv);
+      pthread_mutex_unlock(&q->lock);
+      return PAGER_OK;
+#ifdef PIO_HAVE_URING
+    case PIO_BACKEND_URING: {
+      int rc = uring_queue(q, idx);
+      if (rc != PAGER_OK) {
+        slot_finish(q, idx);
+        return rc;
+      }
+      return PAGER_OK;
+    }
+#endif
+    default:
+      slot_run(s);
+      fifo_push(q->done, q->depth, q->done_head, &q->done_count, idx);
+      return PAGER_OK;
+  }
+}
+
+int pio_complete(PioQueue* q, PioReq** out) {
+  if (!q || !out || q->inflight == 0)
+    return PAGER_E_INVAL;
+
+  uint32_t idx;
+  switch (q->backend) {
+    case PIO_BACKEND_THREADS:
+      pthread_mutex_lock(&q->lock);
+      while (q->done_count == 0)
+        pthread_cond_wait(&q->done_cv, &q->lock);
+      idx = fifo_pop(q->done, q->depth, &q->done_head, &q->done_count);
+      pthread_mutex_unlock(&q->lock);
+      break;
+#ifdef PIO_HAVE_URING
+    case PIO_BACKEND_URING: {
+      long got = uring_reap(q);
+      if (got < 0)
+        return (int)got;
+      idx = (uint32_t)got;
+      break;
+    }
+#endif
+    default:
+      idx = fifo_pop(q->done, q->depth, &q->done_head, &q->done_count);
+      break;
+  }
+
+  *out = slot_finish(q, idx);
+  return PAGER_OK;
+}
+
+int pio_run(PioQueue* q, PioReq* reqs, size_t n) {
+  if (!q || (!reqs && n > 0) || q->inflight > 0)
+    return PAGER_E_INVAL;
+
+  int first = PAGER_OK;
+  size_t next = 0;
+  while (next < n || q->inflight > 0) {
+    while (next < n && q->nfree > 0) {
+      int rc = pio_submit(q, &reqs[next]);
+      if (rc != PAGER_OK) {
+        reqs[next].result = rc;
+        if (first == PAGER_OK) first = rc;
+      }
+      next++;
+    }
+    if (q->inflight == 0)
+      continue;
+
+    PioReq* done = NULL;
+    int rc = pio_complete(q, &done);
+    if (rc != PAGER_OK)
+      return rc;
+    if (done->result != PAGER_OK && first == PAGER_OK)
+      first = done->result;
+  }
+  return first;
+}
+
+const char* pio_backend_name(PioBackend backend) {
+  switch (backend) {
+    case PIO_BACKEND_SYNC:    return "sync";
+    case PIO_BACKEND_THREADS: return "threads";
+    case PIO_BACKEND_URING:   return "io_uring";
+    default:                  return "auto";
+  }
+}
@@ -0,0 +1,115 @@
+#ifndef PIO_H
+
+#define PIO_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Batched file I/O: a submission / completion queue over pread / pwrite
+ *
+ * A queue keeps up to `depth` requests in flight. Backends:
+ * - PIO_BACKEND_URING:   Linux io_uring (raw system calls, no liburing);
+ *                        submissions are handed to the kernel in one
+ *                        io_uring_enter when the caller waits.
+ * - PIO_BACKEND_THREADS: a small pool of threads running blocking
+ *                        pread / pwrite, for systems without io_uring.
+ * - PIO_BACKEND_SYNC:    each request runs inside pio_submit (depth 1).
+ * PIO_BACKEND_AUTO picks the first one of these that can be set up. Build
+ * with -DPIO_NO_URING to leave io_uring out.
+ *
+ * A request completes once all of its `len` bytes are transferred (short
+ * transfers are resumed); its `result` is then PAGER_OK or PAGER_E_IO.
+ * Error codes are PagerError values (see pager.h). A queue is not
+ * thread-safe: one thread at a time submits and reaps.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define PIO_MAX_DEPTH    256   // requests in flight per queue
+#define PIO_MAX_THREADS  8     // workers of the thread-pool backend
+
+typedef enum PioBackend {
+  PIO_BACKEND_AUTO = 0,
+  PIO_BACKEND_SYNC,
+  PIO_BACKEND_THREADS,
+  PIO_BACKEND_URING
+} PioBackend;
+
+/**
+ * @brief One read or write of `len` bytes at `off`. The caller owns the
+ *        request and its buffer until the request is handed back.
+ */
+typedef struct PioReq {
+  int      fd;
+  bool     write;
+  void*    buf;
+  size_t   len;
+  off_t    off;
+  int      result;      // set on completion: PAGER_OK or PAGER_E_IO
+  void*    user_data;   // untouched by the queue
+} PioReq;
+
+typedef struct PioQueue PioQueue;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Set up a queue.
+ *
+ * @param backend  PIO_BACKEND_AUTO, or the backend to use.
+ * @param depth    Requests in flight, 1..PIO_MAX_DEPTH (SYNC always uses 1).
+ * @param out      Receives the queue.
+ * @return PAGER_OK, PAGER_E_INVAL, or PAGER_E_IO if the backend is not
+ *         available here.
+ */
+int        pio_open(PioBackend backend, unsigned depth, PioQueue** out);
+
+/**
+ * @brief Wait for the requests still in flight, then free the queue.
+ */
+void       pio_close(PioQueue* q);
+
+/**
+ * @brief Backend in use (never PIO_BACKEND_AUTO) and its depth.
+ */
+PioBackend pio_backend(const PioQueue* q);
+unsigned   pio_depth(const PioQueue* q);
+
+/**
+ * @brief Requests submitted and not reaped yet.
+ */
+unsigned   pio_inflight(const PioQueue* q);
+
+/**
+ * @brief Queue one request. It may start at once or when the caller next
+ *        waits in pio_complete().
+ * @return PAGER_OK, or PAGER_E_INVAL if `depth` requests are in flight.
+ */
+int        pio_submit(PioQueue* q, PioReq* req);
+
+/**
+ * @brief Wait for one request to complete and hand it back (any order).
+ * @return PAGER_OK (the request's own status is in its `result`), or
+ *         PAGER_E_INVAL if nothing is in flight.
+ */
+int        pio_complete(PioQueue* q, PioReq** out);
+
+/**
+ * @brief Run `n` requests on an idle queue, keeping it full, and wait for
+ *        all of them.
+ * @return PAGER_OK, the first failing request's result, or PAGER_E_INVAL.
+ */
+int        pio_run(PioQueue* q, PioReq* reqs, size_t n);
+
+/**
+ * @brief Name of a backend ("sync", "threads", "io_uring", "auto").
+ */
+const char* pio_backend_name(PioBackend backend);
+
+#endif // PIO_H
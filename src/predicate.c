@@ -0,0 +1,150 @@
+#include "predicate.h"
+#include "index_key.h"
+#include "endian_util.h"
+#include <string.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static inline uint32_t num_max(uint16_t len) {
+  return len == 1 ? 0xFFu : len == 2 ? 0xFFFFu : UINT32_MAX;
+}
+
+static inline uint32_t num_read(const uint8_t* f, uint16_t len) {
+  return len == 1 ? f[0] : len == 2 ? read_le_u16(f) : read_le_u32(f);
+}
+
+static inline int sign(int c) { return (c > 0) - (c < 0); }
+
+static bool bytes_ok(const PredCTerm* t, const uint8_t* f) {
+  if (t->has_lo && sign(memcmp(f, t->lo_b, t->len)) < t->lo_cmp) return false;
+  if (t->has_hi && sign(memcmp(f, t->hi_b, t->len)) > t->hi_cmp) return false;
+  return true;
+}
+
+/* Integer kernels: one unsigned compare per record (v - lo <= hi - lo),
+ * no branch on the value, so the loop runs over the whole word. */
+static uint64_t range_u8(const uint8_t* f, size_t stride, unsigned nrec, uint32_t lo, uint32_t span) {
+  uint64_t keep = 0;
+  for (unsigned j = 0; j < nrec; j++)
+    keep |= (uint64_t)((uint32_t)f[(size_t)j * stride] - lo <= span) << j;
+  return keep;
+}
+
+static uint64_t range_u16(const uint8_t* f, size_t stride, unsigned nrec, uint32_t lo, uint32_t span) {
+  uint64_t keep = 0;
+  for (unsigned j = 0; j < nrec; j++)
+    keep |= (uint64_t)((uint32_t)read_le_u16(f + (size_t)j * stride) - lo <= span) << j;
+  return keep;
+}
+
+static uint64_t range_u32(const uint8_t* f, size_t stride, unsigned nrec, uint32_t lo, uint32_t span) {
+  uint64_t keep = 0;
+  for (unsigned j = 0; j < nrec; j++)
+    keep |= (uint64_t)(read_le_u32(f + (size_t)j * stride) - lo <= span) << j;
+  return keep;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+void pred_init(TblPred* p) {
+  if (!p) return;
+  p->n = 0;
+  p->never = false;
+}
+
+int pred_add(TblPred* p, const PredTerm* term) {
+  if (!p || !term) return TABLE_E_INVAL;
+
+  // Same field rules as an index key (the name is not used here)
+  IndexKey k = { .name = "where", .off = term->off, .len = term->len, .type = term->type };
+  if (!index_key_valid(&k)) return TABLE_E_INVAL;
+  if (term->op > PRED_PREFIX) return TABLE_E_INVAL;
+  if (term->op == PRED_PREFIX && (term->type != INDEX_KEY_STR || term->n == 0 || term->n > term->len))
+    return TABLE_E_INVAL;
+  if (p->n >= PRED_MAX_TERMS) return TABLE_E_FULL;
+
+  PredCTerm* t = &p->t[p->n];
+  memset(t, 0, sizeof *t);
+  t->off = term->off;
+  t->len = term->op == PRED_PREFIX ? term->n : term->len;
+  t->numeric = term->type == INDEX_KEY_U8 || term->type == INDEX_KEY_U16 || term->type == INDEX_KEY_U32;
+
+  if (t->numeric) {
+    const uint32_t a = num_read(term->a, term->len), max = num_max(term->len);
+    switch (term->op) {
+      case PRED_EQ:      t->lo = a; t->hi = a; break;
+      case PRED_LT:      if (a == 0)   p->never = true; t->lo = 0;     t->hi = a - 1u; break;
+      case PRED_GT:      if (a == max) p->never = true; t->lo = a + 1u; t->hi = max;   break;
+      case PRED_BETWEEN: t->lo = a; t->hi = num_read(term->b, term->len); if (t->lo > t->hi) p->never = true; break;
+      default:           return TABLE_E_INVAL;
+    }
+  } else {
+    // memcmp sign against each bound: >= lo_cmp, <= hi_cmp
+    const bool lo = term->op != PRED_LT, hi = term->op != PRED_GT;
+    t->has_lo = lo;
+    t->has_hi = hi;
+    t->lo_cmp = term->op == PRED_GT ? 1 : 0;
+    t->hi_cmp = term->op == PRED_LT ? -1 : 0;
+    if (lo) memcpy(t->lo_b, term->a, t->len);
+    if (hi) memcpy(t->hi_b, term->op == PRED_BETWEEN ? term->b : term->a, t->len);
+  }
+  p->n++;
+  return TABLE_OK;
+}
+
+bool pred_match(const TblPred* p, const void* rec) {
+  if (!p) return true;
+  if (p->never) return false;
+  const uint8_t* r = (const uint8_t*)rec;
+  for (int i = 0; i < p->n; i++) {
+    const PredCTerm* t = &p->t[i];
+    if (t->numeric) {
+      if (num_read(r + t->off, t->len) - t->lo > t->hi - t->lo) return false;
+    } else if (!bytes_ok(t, r + t->off)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Clear the bits of the records failing one term; record j's field
+ *        is at f + j * stride.
+ */
+static uint64_t term_filter(const PredCTerm* t, const uint8_t* f, size_t stride, unsigned nrec, uint64_t bits) {
+  if (t->numeric) {
+    const uint32_t span = t->hi - t->lo;
+    switch (t->len) {
+      case 1:  return bits & range_u8(f, stride, nrec, t->lo, span);
+      case 2:  return bits & range_u16(f, stride, nrec, t->lo, span);
+      default: return bits & range_u32(f, stride, nrec, t->lo, span);
+    }
+  }
+  // One memcmp per candidate still standing
+  for (unsigned j = 0; j < nrec; j++)
+    if ((bits >> j & 1u) && !bytes_ok(t, f + (size_t)j * stride)) bits &= ~(UINT64_C(1) << j);
+  return bits;
+}
+
+uint64_t pred_filter(const TblPred* p, const uint8_t* recs, size_t stride, unsigned nrec, uint64_t bits) {
+  if (!p || bits == 0) return bits;
+  if (p->never || nrec == 0) return 0;
+  if (nrec < 64) bits &= (UINT64_C(1) << nrec) - 1u;
+
+  for (int i = 0; i < p->n && bits; i++)
+    bits = term_filter(&p->t[i], recs + p->t[i].off, stride, nrec, bits);
+  return bits;
+}
+
+uint64_t pred_filter_cols(const TblPred* p, const uint8_t* const* fields, const size_t* strides,
+                          unsigned nrec, uint64_t bits) {
+  if (!p || bits == 0) return bits;
+  if (p->never || nrec == 0) return 0;
+  if (nrec < 64) bits &= (UINT64_C(1) << nrec) - 1u;
+
+  for (int i = 0; i < p->n && bits; i++)
+    bits = term_filter(&p->t[i], fields[i], strides[i], nrec, bits);
+  return bits;
+}
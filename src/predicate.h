@@ -0,0 +1,106 @@
+#ifndef PREDICATE_H
+
+#define PREDICATE_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "table.h"
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Scan predicates over 128-byte records
+ * A predicate is an AND of terms. Each term tests one field, described with
+ * the off:len:type vocabulary of an index key (index_key.h): u8/u16/u32
+ * compare as little-endian integers, strings and raw bytes in memcmp order.
+ * Operands are given in the record encoding of the field (len bytes, the
+ * form encode_field_value() in cli_format.h produces).
+ *
+ * pred_add() compiles a term: integer tests become one inclusive range
+ * [lo, hi], byte tests a bounded memcmp. pred_filter() then runs the terms
+ * over up to 64 records of a leaf at once, one term at a time, so a scan
+ * decides on a whole bitmap word before it touches any callback.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define PRED_MAX_TERMS   16
+
+typedef enum PredOp {
+  PRED_EQ = 0,      /* field == a */
+  PRED_LT,          /* field <  a */
+  PRED_GT,          /* field >  a */
+  PRED_BETWEEN,     /* a <= field <= b */
+  PRED_PREFIX       /* strings: the first n bytes of the field are a[0..n) */
+} PredOp;
+
+/**
+ * @brief One test, as the caller describes it.
+ */
+typedef struct PredTerm {
+  uint16_t off, len;                 // field bytes [off, off+len) of the record
+  uint8_t  type;                     // INDEX_KEY_* (FieldType numbering)
+  uint8_t  op;                       // PredOp
+  uint16_t n;                        // PRED_PREFIX: bytes of `a` to match (1..len)
+  uint8_t  a[TABLE_RECORD_SIZE];     // operand, len bytes (n for PRED_PREFIX)
+  uint8_t  b[TABLE_RECORD_SIZE];     // PRED_BETWEEN: upper bound
+} PredTerm;
+
+/* A compiled term (filled by pred_add) */
+typedef struct PredCTerm {
+  uint16_t off, len;                 // bytes compared (len = n for a prefix)
+  bool     numeric;                  // u8/u16/u32: test lo <= v <= hi
+  uint32_t lo, hi;
+  int8_t   lo_cmp, hi_cmp;           // bytes: memcmp(field, lo) >= lo_cmp, (field, hi) <= hi_cmp
+  bool     has_lo, has_hi;
+  uint8_t  lo_b[TABLE_RECORD_SIZE], hi_b[TABLE_RECORD_SIZE];
+} PredCTerm;
+
+typedef struct TblPred {
+  int       n;
+  bool      never;                   // some term can match no value (e.g. u8 < 0)
+  PredCTerm t[PRED_MAX_TERMS];
+} TblPred;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Start an empty predicate (it matches every record).
+ */
+void     pred_init(TblPred* p);
+
+/**
+ * @brief Compile one term and AND it to the predicate.
+ * @return TABLE_OK; TABLE_E_INVAL for a field outside the record, a length
+ *         that does not fit the type, an unknown op or a prefix test on a
+ *         non-string field; TABLE_E_FULL past PRED_MAX_TERMS terms.
+ */
+int      pred_add(TblPred* p, const PredTerm* term);
+
+/**
+ * @brief Test one record.
+ */
+bool     pred_match(const TblPred* p, const void* rec);
+
+/**
+ * @brief Test records recs[0..nrec) (nrec <= 64), `stride` bytes apart.
+ *
+ * Only the records whose bit is set in `bits` count; the others are never
+ * dereferenced as matches but may be read, so all nrec records must lie in
+ * readable memory (a leaf's slot area).
+ *
+ * @return `bits` with the bits of the records that fail cleared.
+ */
+uint64_t pred_filter(const TblPred* p, const uint8_t* recs, size_t stride, unsigned nrec, uint64_t bits);
+
+/**
+ * @brief pred_filter() over fields stored apart from their records (the
+ *        minipages of a PAX leaf, see pax.h): term i reads the field of
+ *        record j at fields[i] + j * strides[i], same readability rule.
+ */
+uint64_t pred_filter_cols(const TblPred* p, const uint8_t* const* fields, const size_t* strides,
+                          unsigned nrec, uint64_t bits);
+
+#endif // PREDICATE_H
@@ -0,0 +1,280 @@
+#include "slotted.h"
+#include "table.h"
+#include "endian_util.h"
+#include <string.h>
+
+/* Largest supported page (PAGER_MAX_PAGE_SIZE): compaction scratch */
+#define SPG_SCRATCH 65536u
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Internal helpers
+// ─────────────────────────────────────────────────────────────────────────────
+static inline uint8_t* slot_ptr(void* page, int idx) {
+  return (uint8_t*)page + SPG_HDR_SIZE + (size_t)idx * SPG_SLOT_SIZE;
+}
+
+static inline const uint8_t* slot_ptr_c(const void* page, int idx) {
+  return (const uint8_t*)page + SPG_HDR_SIZE + (size_t)idx * SPG_SLOT_SIZE;
+}
+
+static inline uint16_t slot_offset(const void* page, int idx) {
+  return read_le_u16(slot_ptr_c(page, idx) + SPG_SLOT_OFFSET_OFF);
+}
+
+static inline uint16_t slot_length(const void* page, int idx) {
+  return read_le_u16(slot_ptr_c(page, idx) + SPG_SLOT_LENGTH_OFF);
+}
+
+static inline void slot_set(void* page, int idx, uint16_t offset, uint16_t length) {
+  write_le_u16(slot_ptr(page, idx) + SPG_SLOT_OFFSET_OFF, offset);
+  write_le_u16(slot_ptr(page, idx) + SPG_SLOT_LENGTH_OFF, length);
+}
+
+static inline uint16_t hdr_slot_count(const void* page) {
+  return read_le_u16((const uint8_t*)page + SPG_HDR_SLOT_COUNT_OFF);
+}
+
+static inline uint16_t hdr_heap_size(const void* page) {
+  return read_le_u16((const uint8_t*)page + SPG_HDR_HEAP_SIZE_OFF);
+}
+
+static inline uint16_t hdr_used_count(const void* page) {
+  return read_le_u16((const uint8_t*)page + SPG_HDR_USED_COUNT_OFF);
+}
+
+static inline void hdr_set_u16(void* page, size_t off, uint16_t v) {
+  write_le_u16((uint8_t*)page + off, v);
+}
+
+/**
+ * @brief End of the slot directory, i.e. start of the contiguous gap.
+ */
+static inline size_t dir_end(const void* page) {
+  return SPG_HDR_SIZE + (size_t)hdr_slot_count(page) * SPG_SLOT_SIZE;
+}
+
+/**
+ * @brief Bytes held by live records (stubs count as SPG_OVF_STUB_SIZE).
+ */
+static size_t live_bytes(const void* page) {
+  size_t n = 0;
+  const uint16_t slots = hdr_slot_count(page);
+  for (int i = 0; i < slots; i++)
+    if (slot_offset(page, i) != 0)
+      n += slot_length(page, i) & SPG_SLOT_LENGTH_MASK;
+  return n;
+}
+
+/**
+ * @brief First free directory entry, or slot_count when a new one is needed.
+ */
+static int first_free_slot(const void* page) {
+  const uint16_t slots = hdr_slot_count(page);
+  if (hdr_used_count(page) == slots) return slots;
+  for (int i = 0; i < slots; i++)
+    if (slot_offset(page, i) == 0) return i;
+  return slots;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+size_t spg_max_inline(size_t page_size) {
+  return page_size / 4u;
+}
+
+size_t spg_min_free(size_t page_size) {
+  return page_size / 32u;
+}
+
+int spg_init(void* page, size_t page_size) {
+  if (!page || page_size <= SPG_HDR_SIZE || page_size > SPG_SCRATCH)
+    return TABLE_E_INVAL;
+
+  memset(page, 0, page_size);
+  hdr_set_u16(page, SPG_HDR_KIND_OFF, TABLE_PAGE_KIND_SLOTTED);
+  return TABLE_OK;
+}
+
+int spg_validate(const void* page, size_t page_size) {
+  if (!page || page_size <= SPG_HDR_SIZE || page_size > SPG_SCRATCH)
+    return TABLE_E_INVAL;
+
+  if (read_le_u16((const uint8_t*)page + SPG_HDR_KIND_OFF) != TABLE_PAGE_KIND_SLOTTED)
+    return TABLE_E_BADKIND;
+
+  const size_t heap_start = page_size - hdr_heap_size(page);
+  if (hdr_heap_size(page) > page_size - SPG_HDR_SIZE || dir_end(page) > heap_start)
+    return TABLE_E_LAYOUT;
+
+  const size_t max_inline = spg_max_inline(page_size);
+  const uint16_t slots = hdr_slot_count(page);
+  size_t live = 0, bytes = 0;
+  for (int i = 0; i < slots; i++) {
+    const uint16_t off = slot_offset(page, i);
+    const uint16_t raw = slot_length(page, i);
+    if (off == 0) {
+      if (raw != 0) return TABLE_E_LAYOUT;
+      continue;
+    }
+    const size_t len = raw & SPG_SLOT_LENGTH_MASK;
+    if ((raw & SPG_SLOT_OVERFLOW) ? len != SPG_OVF_STUB_SIZE : (len == 0 || len > max_inline))
+      return TABLE_E_LAYOUT;
+    if (off < heap_start || off + len > page_size)
+      return TABLE_E_LAYOUT;
+    live++;
+    bytes += len;
+  }
+  // Trailing free entries are trimmed on delete
+  if (slots > 0 && slot_offset(page, slots - 1) == 0)
+    return TABLE_E_LAYOUT;
+  if (live != hdr_used_count(page) || bytes > hdr_heap_size(page))
+    return TABLE_E_LAYOUT;
+  return TABLE_OK;
+}
+
+size_t spg_free_space(const void* page, size_t page_size) {
+  const size_t heap_start = page_size - hdr_heap_size(page);
+  return heap_start - dir_end(page) + (hdr_heap_size(page) - live_bytes(page));
+}
+
+bool spg_fits(const void* page, size_t page_size, size_t len) {
+  const size_t slot = first_free_slot(page) == hdr_slot_count(page) ? SPG_SLOT_SIZE : 0;
+  return len + slot <= spg_free_space(page, page_size);
+}
+
+int spg_insert(void* page, size_t page_size, const void* rec, size_t len, bool overflow,
+               uint16_t* out_slot) {
+  if (!page || !rec || len == 0 || len > spg_max_inline(page_size) ||
+      (overflow && len != SPG_OVF_STUB_SIZE))
+    return TABLE_E_INVAL;
+
+  const int slot = first_free_slot(page);
+  const size_t need = len + (slot == hdr_slot_count(page) ? SPG_SLOT_SIZE : 0);
+  if (need > spg_free_space(page, page_size))
+    return TABLE_E_FULL;
+
+  // The holes make room but the gap does not: pack the heap first
+  if (page_size - hdr_heap_size(page) - dir_end(page) < need)
+    spg_compact(page, page_size);
+
+  const size_t off = page_size - hdr_heap_size(page) - len;
+  memcpy((uint8_t*)page + off, rec, len);
+  if (slot == hdr_slot_count(page))
+    hdr_set_u16(page, SPG_HDR_SLOT_COUNT_OFF, (uint16_t)(slot + 1));
+  slot_set(page, slot, (uint16_t)off, (uint16_t)(len | (overflow ? SPG_SLOT_OVERFLOW : 0)));
+  hdr_set_u16(page, SPG_HDR_HEAP_SIZE_OFF, (uint16_t)(page_size - off));
+  hdr_set_u16(page, SPG_HDR_USED_COUNT_OFF, (uint16_t)(hdr_used_count(page) + 1));
+
+  if (out_slot) *out_slot = (uint16_t)slot;
+  return TABLE_OK;
+}
+
+int spg_delete(void* page, size_t page_size, int slot) {
+  if (!page || slot < 0 || slot >= hdr_slot_count(page) || slot_offset(page, slot) == 0)
+    return TABLE_E_INVAL;
+
+  const uint16_t off = slot_offset(page, slot);
+  const uint16_t len = slot_length(page, slot) & SPG_SLOT_LENGTH_MASK;
+  memset((uint8_t*)page + off, 0, len);
+  slot_set(page, slot, 0, 0);
+  hdr_set_u16(page, SPG_HDR_USED_COUNT_OFF, (uint16_t)(hdr_used_count(page) - 1));
+
+  uint16_t slots = hdr_slot_count(page);
+
+  // The lowest record goes straight back to the gap: the heap now starts at
+  // the next live record (or the page end)
+  if (off == page_size - hdr_heap_size(page)) {
+    size_t start = page_size;
+    for (int i = 0; i < slots; i++) {
+      const size_t o = slot_offset(page, i);
+      if (o != 0 && o < start) start = o;
+    }
+    hdr_set_u16(page, SPG_HDR_HEAP_SIZE_OFF, (uint16_t)(page_size - start));
+  }
+
+  while (slots > 0 && slot_offset(page, slots - 1) == 0) slots--;
+  hdr_set_u16(page, SPG_HDR_SLOT_COUNT_OFF, slots);
+  return TABLE_OK;
+}
+
+void spg_compact(void* page, size_t page_size) {
+  uint8_t tmp[SPG_SCRATCH];
+  uint8_t* base = (uint8_t*)page;
+  const size_t heap_start = page_size - hdr_heap_size(page);
+  memcpy(tmp, base + heap_start, hdr_heap_size(page));
+
+  size_t end = page_size;
+  const uint16_t slots = hdr_slot_count(page);
+  for (int i = 0; i < slots; i++) {
+    const uint16_t off = slot_offset(page, i);
+    if (off == 0) continue;
+    const uint16_t raw = slot_length(page, i);
+    const size_t len = raw & SPG_SLOT_LENGTH_MASK;
+    end -= len;
+    memcpy(base + end, tmp + (off - heap_start), len);
+    slot_set(page, i, (uint16_t)end, raw);
+  }
+  memset(base + heap_start, 0, end - heap_start);
+  hdr_set_u16(page, SPG_HDR_HEAP_SIZE_OFF, (uint16_t)(page_size - end));
+}
+
+const void* spg_record(const void* page, int slot, uint16_t* out_len, bool* out_overflow) {
+  if (!page || slot < 0 || slot >= hdr_slot_count(page) || slot_offset(page, slot) == 0)
+    return NULL;
+  const uint16_t raw = slot_length(page, slot);
+  if (out_len) *out_len = raw & SPG_SLOT_LENGTH_MASK;
+  if (out_overflow) *out_overflow = (raw & SPG_SLOT_OVERFLOW) != 0;
+  return (const uint8_t*)page + slot_offset(page, slot);
+}
+
+uint16_t spg_get_slot_count(const void* page) {
+  return hdr_slot_count(page);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Overflow pages
+// ─────────────────────────────────────────────────────────────────────────────
+size_t spg_ovf_capacity(size_t page_size) {
+  return page_size - SPG_OVF_HDR_SIZE;
+}
+
+int spg_ovf_init(void* page, size_t page_size, uint32_t root) {
+  if (!page || page_size <= SPG_OVF_HDR_SIZE)
+    return TABLE_E_INVAL;
+
+  memset(page, 0, page_size);
+  uint8_t* base = (uint8_t*)page;
+  write_le_u16(base + SPG_OVF_KIND_OFF, TABLE_PAGE_KIND_OVERFLOW);
+  write_le_u32(base + SPG_OVF_ROOT_OFF, root);
+  return TABLE_OK;
+}
+
+int spg_ovf_validate(const void* page, size_t page_size) {
+  if (!page || page_size <= SPG_OVF_HDR_SIZE)
+    return TABLE_E_INVAL;
+
+  const uint8_t* base = (const uint8_t*)page;
+  if (read_le_u16(base + SPG_OVF_KIND_OFF) != TABLE_PAGE_KIND_OVERFLOW)
+    return TABLE_E_BADKIND;
+  const uint32_t len = spg_ovf_get_len(page);
+  if (len == 0 || len > spg_ovf_capacity(page_size))
+    return TABLE_E_LAYOUT;
+  return TABLE_OK;
+}
+
+uint32_t spg_ovf_get_len(const void* page) {
+  return read_le_u32((const uint8_t*)page + SPG_OVF_LEN_OFF);
+}
+
+void spg_ovf_set_len(void* page, uint32_t len) {
+  write_le_u32((uint8_t*)page + SPG_OVF_LEN_OFF, len);
+}
+
+uint32_t spg_ovf_get_next(const void* page) {
+  return read_le_u32((const uint8_t*)page + SPG_OVF_NEXT_OFF);
+}
+
+void spg_ovf_set_next(void* page, uint32_t next) {
+  write_le_u32((uint8_t*)page + SPG_OVF_NEXT_OFF, next);
+}
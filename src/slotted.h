@@ -0,0 +1,155 @@
+#ifndef SLOTTED_H
+
+#define SLOTTED_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Slotted page: variable-length records
+ * - Page type: TABLE_PAGE_KIND_SLOTTED (0x000A), see table.h
+ * - A slot directory grows up from the 24-byte header, the record heap grows
+ *   down from the end of the page. Entry i locates record i: (offset,
+ *   length), offset 0 = free slot. Record ids are (page << 16) | slot, as for
+ *   fixed-size leaves, and a slot keeps its record in place until deleted.
+ * - Header words 6..23 (used_count, next, root, fsm, index) sit where they
+ *   are in a TABLE_LEAF, so the tbl_get/set_* accessors for them work on
+ *   both kinds.
+ * - Deleting leaves a hole in the heap; spg_insert compacts the heap when
+ *   the contiguous gap is too small but the holes make room.
+ * - Records above spg_max_inline() bytes live on a chain of overflow pages
+ *   (TABLE_PAGE_KIND_OVERFLOW, 0x000B); the slot holds an SPG_OVF_STUB_SIZE
+ *   stub (total length, first overflow page) flagged SPG_SLOT_OVERFLOW.
+ * All multi-byte integers are little-endian on disk.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define SPG_HDR_SIZE                24
+
+/* Header offsets (bytes) */
+#define SPG_HDR_KIND_OFF            0   /* u16 */
+#define SPG_HDR_SLOT_COUNT_OFF      2   /* u16: directory entries (live or free) */
+#define SPG_HDR_HEAP_SIZE_OFF       4   /* u16: bytes from heap start to page end */
+#define SPG_HDR_USED_COUNT_OFF      6   /* u16: live records (as TABLE_HDR_USED_COUNT_OFF) */
+/* 8..23: next_page, root_page, fsm_page, index_page as in a TABLE_LEAF */
+
+/* Slot directory entry, SPG_SLOT_SIZE bytes from SPG_HDR_SIZE */
+#define SPG_SLOT_SIZE               4
+#define SPG_SLOT_OFFSET_OFF         0   /* u16: record offset in the page (0 = free) */
+#define SPG_SLOT_LENGTH_OFF         2   /* u16: record length | SPG_SLOT_OVERFLOW */
+#define SPG_SLOT_OVERFLOW           0x8000u
+#define SPG_SLOT_LENGTH_MASK        0x7FFFu
+
+/* Overflow record stub (slot payload) */
+#define SPG_OVF_STUB_SIZE           8
+#define SPG_OVF_STUB_LEN_OFF        0   /* u32: total record length */
+#define SPG_OVF_STUB_PAGE_OFF       4   /* u32: first overflow page */
+
+/* Overflow page */
+#define SPG_OVF_HDR_SIZE            16
+#define SPG_OVF_KIND_OFF            0   /* u16 */
+#define SPG_OVF_LEN_OFF             4   /* u32: payload bytes on this page */
+#define SPG_OVF_NEXT_OFF            8   /* u32: next overflow page (0 = last) */
+#define SPG_OVF_ROOT_OFF            12  /* u32: owning table */
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API (error codes are TableError values, see table.h)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Largest record stored in the page itself; longer ones overflow.
+ *        A quarter of the page, so that a page on the free-space map of a
+ *        table rarely turns an insert away.
+ */
+size_t spg_max_inline(size_t page_size);
+
+/**
+ * @brief Free bytes (spg_free_space) below which a page leaves its table's
+ *        free-space map: 1/32 of the page.
+ */
+size_t spg_min_free(size_t page_size);
+
+/**
+ * @brief Initialize an empty slotted page in memory (no slots, empty heap).
+ * @return TABLE_OK, or TABLE_E_INVAL on bad arguments.
+ */
+int spg_init(void* page, size_t page_size);
+
+/**
+ * @brief Validate a slotted page: kind, directory and heap bounds, every
+ *        live record inside the heap, live count against used_count.
+ * @return TABLE_OK, TABLE_E_INVAL, TABLE_E_BADKIND or TABLE_E_LAYOUT.
+ */
+int spg_validate(const void* page, size_t page_size);
+
+/**
+ * @brief Bytes available to records and new slots once the heap is compacted.
+ */
+size_t spg_free_space(const void* page, size_t page_size);
+
+/**
+ * @brief Whether a record of `len` bytes can be inserted (compacting if needed).
+ */
+bool spg_fits(const void* page, size_t page_size, size_t len);
+
+/**
+ * @brief Store a record in the first free slot (or a new one).
+ *
+ * @param rec       Record bytes (an overflow stub when `overflow`).
+ * @param len       1..spg_max_inline(page_size) bytes.
+ * @param overflow  Flag the slot as an overflow stub.
+ * @param out_slot  Receives the slot index.
+ * @return TABLE_OK, TABLE_E_INVAL, or TABLE_E_FULL if the page has no room.
+ */
+int spg_insert(void* page, size_t page_size, const void* rec, size_t len, bool overflow,
+               uint16_t* out_slot);
+
+/**
+ * @brief Free a live slot. Its heap bytes become a hole (reclaimed at once
+ *        when the record was the lowest one); trailing free slots are trimmed.
+ * @return TABLE_OK, or TABLE_E_INVAL if the slot is not live.
+ */
+int spg_delete(void* page, size_t page_size, int slot);
+
+/**
+ * @brief Rewrite the live records back to back at the end of the page.
+ */
+void spg_compact(void* page, size_t page_size);
+
+/**
+ * @brief Locate a live record.
+ * @param out_len       Receives its stored length (SPG_OVF_STUB_SIZE for a stub).
+ * @param out_overflow  Optional: receives whether the slot is an overflow stub.
+ * @return Pointer into the page, or NULL if the slot is free or out of range.
+ */
+const void* spg_record(const void* page, int slot, uint16_t* out_len, bool* out_overflow);
+
+/**
+ * @brief Number of directory entries (live or free).
+ */
+uint16_t spg_get_slot_count(const void* page);
+
+/**
+ * @brief Initialize an overflow page owned by `root` (empty, no next page).
+ */
+int spg_ovf_init(void* page, size_t page_size, uint32_t root);
+
+/**
+ * @brief Validate an overflow page: kind and payload length.
+ * @return TABLE_OK, TABLE_E_INVAL, TABLE_E_BADKIND or TABLE_E_LAYOUT.
+ */
+int spg_ovf_validate(const void* page, size_t page_size);
+
+/**
+ * @brief Overflow page payload capacity, and header getters / setters.
+ */
+size_t   spg_ovf_capacity(size_t page_size);
+uint32_t spg_ovf_get_len(const void* page);
+void     spg_ovf_set_len(void* page, uint32_t len);
+uint32_t spg_ovf_get_next(const void* page);
+void     spg_ovf_set_next(void* page, uint32_t next);
+
+#endif // SLOTTED_H
@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+static const char* const counter_names[STAT_COUNTERS] = {
+  [STAT_PAGE_READS]       = "page_reads",
+  [STAT_PAGE_WRITES]      = "page_writes",
+  [STAT_CACHE_HITS]       = "cache_hits",
+  [STAT_CACHE_MISSES]     = "cache_misses",
+  [STAT_EVICTIONS]        = "evictions",
+  [STAT_FILE_READS]       = "file_reads",
+  [STAT_FILE_WRITES]      = "file_writes",
+  [STAT_BYTES_READ]       = "bytes_read",
+  [STAT_BYTES_WRITTEN]    = "bytes_written",
+  [STAT_READAHEAD_PAGES]  = "readahead_pages",
+  [STAT_PAGE_ALLOCS]      = "page_allocs",
+  [STAT_CHECKSUMS]        = "checksums",
+  [STAT_CHECKSUM_ERRORS]  = "checksum_errors",
+  [STAT_LEAF_VALIDATIONS] = "leaf_validations",
+  [STAT_INSERTS]          = "inserts",
+  [STAT_INSERT_PAGES]     = "insert_pages",
+};
+
+static const char* const hist_names[STAT_HISTS] = {
+  [STAT_H_FILE_READ]  = "file_read",
+  [STAT_H_FILE_WRITE] = "file_write",
+  [STAT_H_VALIDATE]   = "validate",
+  [STAT_H_INSERT]     = "insert",
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Shared helpers
+// ─────────────────────────────────────────────────────────────────────────────
+bool stats_enabled(void) {
+#ifdef STATS_DISABLED
+  return false;
+#else
+  return true;
+#endif
+}
+
+const char* stats_counter_name(StatCounter c) {
+  return (unsigned)c < STAT_COUNTERS ? counter_names[c] : "?";
+}
+
+const char* stats_hist_name(StatHist h) {
+  return (unsigned)h < STAT_HISTS ? hist_names[h] : "?";
+}
+
+uint64_t stats_quantile(const StatsHistogram* h, double q) {
+  if (!h || h->count == 0) return 0;
+  if (q > 1.0) q = 1.0;
+  uint64_t want = (uint64_t)(q * (double)h->count + 0.999999);
+  if (want == 0) want = 1;
+  uint64_t seen = 0;
+  for (int b = 0; b < STATS_BUCKETS; b++) {
+    seen += h->buckets[b];
+    if (seen >= want) return (uint64_t)2 << b;
+  }
+  return (uint64_t)2 << (STATS_BUCKETS - 1);
+}
+
+#ifdef STATS_DISABLED
+
+void stats_set_timing(bool on) { (void)on; }
+void stats_read(Stats* out) { if (out) memset(out, 0, sizeof *out); }
+void stats_reset(void) {}
+
+#else
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Thread blocks
+// ─────────────────────────────────────────────────────────────────────────────
+_Thread_local StatsBlock* stats_tls;
+_Atomic bool stats_timing;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static StatsBlock*     stats_live;      // blocks of running threads
+static Stats           stats_retired;   // what exited threads counted
+static Stats           stats_base;      // totals at the last stats_reset()
+static pthread_key_t   stats_key;
+static pthread_once_t  stats_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Add one block to a set of totals (stats_lock held).
+ */
+static void block_sum(const StatsBlock* b, Stats* into) {
+  for (int c = 0; c < STAT_COUNTERS; c++)
+    into->counters[c] += atomic_load_explicit(&b->counters[c], memory_order_relaxed);
+  for (int h = 0; h < STAT_HISTS; h++) {
+    StatsHistogram* t = &into->hists[h];
+    t->count += atomic_load_explicit(&b->hist_count[h], memory_order_relaxed);
+    t->total_ns += atomic_load_explicit(&b->hist_total[h], memory_order_relaxed);
+    for (int k = 0; k < STATS_BUCKETS; k++)
+      t->buckets[k] += atomic_load_explicit(&b->buckets[h][k], memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Thread exit: fold the block into the retired totals and drop it.
+ */
+static void block_retire(void* arg) {
+  StatsBlock* b = (StatsBlock*)arg;
+  pthread_mutex_lock(&stats_lock);
+  block_sum(b, &stats_retired);
+  if (b->prev) b->prev->next = b->next;
+  else         stats_live = b->next;
+  if (b->next) b->next->prev = b->prev;
+  pthread_mutex_unlock(&stats_lock);
+  free(b);
+}
+
+static void stats_key_init(void) {
+  pthread_key_create(&stats_key, block_retire);
+}
+
+StatsBlock* stats_block_new(void) {
+  pthread_once(&stats_once, stats_key_init);
+  StatsBlock* b = calloc(1, sizeof *b);
+  if (!b) return NULL;   // out of memory: this thread's counts are lost
+
+  pthread_mutex_lock(&stats_lock);
+  b->next = stats_live;
+  if (stats_live) stats_live->prev = b;
+  stats_live = b;
+  pthread_mutex_unlock(&stats_lock);
+  pthread_setspecific(stats_key, b);
+  stats_tls = b;
+  return b;
+}
+
+void stats_hist_add(StatsBlock* b, StatHist h, uint64_t ns) {
+  int k = ns == 0 ? 0 : 63 - __builtin_clzll(ns);
+  if (k >= STATS_BUCKETS) k = STATS_BUCKETS - 1;
+  stats_bump(&b->hist_count[h], 1);
+  stats_bump(&b->hist_total[h], ns);
+  stats_bump(&b->buckets[h][k], 1);
+}
+
+uint64_t stats_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec + 1u;  // never 0
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+void stats_set_timing(bool on) {
+  atomic_store(&stats_timing, on);
+}
+
+/**
+ * @brief Totals since the start of the process (stats_lock held).
+ */
+static void totals(Stats* out) {
+  *out = stats_retired;
+  for (const StatsBlock* b = stats_live; b; b = b->next)
+    block_sum(b, out);
+}
+
+void stats_read(Stats* out) {
+  if (!out) return;
+  pthread_mutex_lock(&stats_lock);
+  totals(out);
+  for (int c = 0; c < STAT_COUNTERS; c++)
+    out->counters[c] -= stats_base.counters[c];
+  for (int h = 0; h < STAT_HISTS; h++) {
+    StatsHistogram* t = &out->hists[h];
+    const StatsHistogram* base = &stats_base.hists[h];
+    t->count -= base->count;
+    t->total_ns -= base->total_ns;
+    for (int k = 0; k < STATS_BUCKETS; k++)
+      t->buckets[k] -= base->buckets[k];
+  }
+  pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_reset(void) {
+  pthread_mutex_lock(&stats_lock);
+  totals(&stats_base);
+  pthread_mutex_unlock(&stats_lock);
+}
+
+#endif // STATS_DISABLED
@@ -0,0 +1,157 @@
+#ifndef STATS_H
+
+#define STATS_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Engine statistics: hot-path counters and latency histograms
+ *
+ * Every thread counts into a block of its own (no shared cache lines, no
+ * locked instructions); stats_read() adds up the blocks of the live threads
+ * and what the exited ones left behind. Counters are process-wide: all the
+ * pagers of a process count into the same totals.
+ *
+ * Histograms time a few measured operations (file reads and writes, leaf
+ * validation, inserts) in nanoseconds, bucketed by powers of two. Reading
+ * the clock costs more than a counter, so timing is off until
+ * stats_set_timing(true).
+ *
+ * Build with -DSTATS_DISABLED (make STATS=0) to compile every counter and
+ * timer out: the API stays, stats_read() then reports zeros.
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define STATS_BUCKETS  40   // histogram bucket b: [2^b, 2^(b+1)) ns, the last is open
+
+typedef enum StatCounter {
+  STAT_PAGE_READS = 0,    // pager_read calls
+  STAT_PAGE_WRITES,       // pager_write calls
+  STAT_CACHE_HITS,        // pins served from the buffer pool
+  STAT_CACHE_MISSES,      // pins that had to load the page (file, mapping, log)
+  STAT_EVICTIONS,         // frames taken from another page
+  STAT_FILE_READS,        // reads issued to the database file
+  STAT_FILE_WRITES,       // writes issued to the database file
+  STAT_BYTES_READ,
+  STAT_BYTES_WRITTEN,
+  STAT_READAHEAD_PAGES,   // pages announced ahead of a sequential scan
+  STAT_PAGE_ALLOCS,       // pages handed out by pager_alloc_page(s)
+  STAT_CHECKSUMS,         // page checksums verified
+  STAT_CHECKSUM_ERRORS,   // ... that did not match
+  STAT_LEAF_VALIDATIONS,  // full validations of a table leaf
+  STAT_INSERTS,           // fixed-size records inserted
+  STAT_INSERT_PAGES,      // leaves visited finding room for them
+  STAT_COUNTERS
+} StatCounter;
+
+typedef enum StatHist {
+  STAT_H_FILE_READ = 0,   // one file read (pread)
+  STAT_H_FILE_WRITE,      // one file write (pwrite or a batch of them)
+  STAT_H_VALIDATE,        // a full leaf validation
+  STAT_H_INSERT,          // one tblmgr_insert / tblmgr_insert_batch call
+  STAT_HISTS
+} StatHist;
+
+typedef struct StatsHistogram {
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t buckets[STATS_BUCKETS];
+} StatsHistogram;
+
+/** @brief Totals returned by stats_read(). */
+typedef struct Stats {
+  uint64_t       counters[STAT_COUNTERS];
+  StatsHistogram hists[STAT_HISTS];
+} Stats;
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+
+/** @brief Whether counters were compiled in (not built with STATS_DISABLED). */
+bool stats_enabled(void);
+
+/** @brief Turn latency histograms on or off (off at start). */
+void stats_set_timing(bool on);
+
+/**
+ * @brief Totals of every thread since the start of the process, or since
+ *        the last stats_reset().
+ */
+void stats_read(Stats* out);
+
+/**
+ * @brief Start counting from zero again. Threads keep counting into their
+ *        blocks; the current totals become the base stats_read() subtracts.
+ */
+void stats_reset(void);
+
+/** @brief Short name of a counter or histogram ("cache_hits", "file_read"). */
+const char* stats_counter_name(StatCounter c);
+const char* stats_hist_name(StatHist h);
+
+/**
+ * @brief Upper bound, in nanoseconds, of the bucket holding quantile q
+ *        (0 < q <= 1) of a histogram; 0 when it is empty.
+ */
+uint64_t stats_quantile(const StatsHistogram* h, double q);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Recording (inline: the hot paths of pager.c and table_manager.c)
+// ─────────────────────────────────────────────────────────────────────────────
+#ifndef STATS_DISABLED
+
+/* One thread's block; only its owner writes it, stats_read() reads it */
+typedef struct StatsBlock {
+  _Atomic uint64_t counters[STAT_COUNTERS];
+  _Atomic uint64_t hist_count[STAT_HISTS];
+  _Atomic uint64_t hist_total[STAT_HISTS];
+  _Atomic uint64_t buckets[STAT_HISTS][STATS_BUCKETS];
+  struct StatsBlock* prev;
+  struct StatsBlock* next;
+} StatsBlock;
+
+extern _Thread_local StatsBlock* stats_tls;
+extern _Atomic bool stats_timing;
+
+StatsBlock* stats_block_new(void);
+void stats_hist_add(StatsBlock* b, StatHist h, uint64_t ns);
+uint64_t stats_now_ns(void);
+
+/* Single writer: a relaxed load and store, no read-modify-write */
+static inline void stats_bump(_Atomic uint64_t* c, uint64_t n) {
+  atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+/** @brief Add n to a counter of the calling thread. */
+static inline void stats_add(StatCounter c, uint64_t n) {
+  StatsBlock* b = stats_tls ? stats_tls : stats_block_new();
+  if (b) stats_bump(&b->counters[c], n);
+}
+
+/** @brief Start of a timed operation: 0 while timing is off. */
+static inline uint64_t stats_start(void) {
+  return atomic_load_explicit(&stats_timing, memory_order_relaxed) ? stats_now_ns() : 0;
+}
+
+/** @brief End of a timed operation begun at `start` (stats_start()). */
+static inline void stats_stop(StatHist h, uint64_t start) {
+  if (start == 0) return;
+  StatsBlock* b = stats_tls ? stats_tls : stats_block_new();
+  if (b) stats_hist_add(b, h, stats_now_ns() - start);
+}
+
+#else
+
+static inline void stats_add(StatCounter c, uint64_t n) { (void)c; (void)n; }
+static inline uint64_t stats_start(void) { return 0; }
+static inline void stats_stop(StatHist h, uint64_t start) { (void)h; (void)start; }
+
+#endif // STATS_DISABLED
+
+#endif // STATS_H
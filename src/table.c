@@ -2,13 +2,6 @@
 #include "endian_util.h"
 #include <string.h>
 
-// ─────────────────────────────────────────────────────────────────────────────
-// Defines
-// ─────────────────────────────────────────────────────────────────────────────
-#ifndef TABLE_PAGE_SIZE
-#define TABLE_PAGE_SIZE 4096
-#endif
-
 // ───────────── Header accessors ─────────────
 static inline uint16_t hdr_kind(const void* page);
 static inline void hdr_set_kind(void* page, uint16_t v);
@@ -27,18 +20,22 @@ static inline uint8_t* bitmap_ptr(void* page);
 static inline const uint8_t* bitmap_ptr_c(const void* page);
 static inline size_t bitmap_size_bytes(uint16_t capacity);
 static inline size_t bitmap_popcount(const uint8_t* bm, size_t nbytes);
+static inline uint64_t bitmap_word(const uint8_t* bm, size_t nbytes, size_t w);
+static inline uint64_t bitmap_valid_mask(uint16_t capacity, size_t w);
+static inline unsigned word_popcount(uint64_t x);
+static inline unsigned word_ctz(uint64_t x);
 
 // ───────────── Data helpers ─────────────
 static inline size_t data_offset(uint16_t capacity);
-static int compute_capacity(int record_size);
+static int compute_capacity(size_t page_size, int record_size);
 
-int tbl_init_leaf(void* page, uint16_t record_size) {
-  if (!page || record_size != TABLE_RECORD_SIZE)
+int tbl_init_leaf(void* page, size_t page_size, uint16_t record_size) {
+  if (!page || record_size != TABLE_RECORD_SIZE || page_size <= TABLE_HDR_SIZE)
     return TABLE_E_INVAL;
 
-  memset(page, 0, TABLE_PAGE_SIZE);
+  memset(page, 0, page_size);
 
-  uint16_t capacity = (uint16_t) compute_capacity(record_size);
+  uint16_t capacity = (uint16_t) compute_capacity(page_size, record_size);
   if (!capacity)
     return TABLE_E_LAYOUT;
 
@@ -52,8 +49,8 @@ int tbl_init_leaf(void* page, uint16_t record_size) {
   return TABLE_OK;
 }
 
-int tbl_validate(const void* page) {
-  if (!page)
+int tbl_validate(const void* page, size_t page_size) {
+  if (!page || page_size <= TABLE_HDR_SIZE)
     return TABLE_E_INVAL;
 
   if (hdr_kind(page) != TABLE_PAGE_KIND_LEAF)
@@ -65,7 +62,7 @@ int tbl_validate(const void* page) {
 
   uint16_t cap = hdr_capacity(page);
 
-  if (cap < 1 || cap != compute_capacity(record_size))
+  if (cap < 1 || cap != compute_capacity(page_size, record_size))
     return TABLE_E_LAYOUT;
 
   uint16_t used = hdr_used_count(page);
@@ -78,18 +75,14 @@ int tbl_validate(const void* page) {
   if (bm_pop != used)
     return TABLE_E_BITMAP;
 
-  size_t total = data_offset(cap) + (size_t)(cap * record_size);
-  if (total > TABLE_PAGE_SIZE)
+  size_t total = data_offset(cap) + (size_t)(cap * record_size) + TABLE_LEAF_CRC_SIZE;
+  if (total > page_size)
     return TABLE_E_LAYOUT;
 
-  uint16_t valid_bits_last = (uint16_t)(cap & 7u);
-  if (valid_bits_last != 0) {
-    const uint8_t* bm = bitmap_ptr_c(page);
-    uint8_t last_byte = bm[bm_bytes - 1];
-    uint8_t invalid_mask = (uint8_t)(0xFFu << valid_bits_last);
-    if ((last_byte & invalid_mask) != 0)
-      return TABLE_E_BITMAP;
-  }
+  // Bits past capacity can only live in the last word
+  const size_t last_w = (cap - 1u) / 64u;
+  if (bitmap_word(bitmap_ptr_c(page), bm_bytes, last_w) & ~bitmap_valid_mask(cap, last_w))
+    return TABLE_E_BITMAP;
   return TABLE_OK;
 }
 
@@ -106,17 +99,11 @@ int tbl_slot_find_free(const void* page) {
   const uint8_t *bm = bitmap_ptr_c(page);
   size_t bm_bytes = bitmap_size_bytes(cap);
 
-  for (size_t i = 0; i < bm_bytes; i++) {
-    if (bm[i] != 0xFF) {
-      for (int j = 0; j < 8; j++) {
-        if ((bm[i] & (1u << j)) == 0) {
-          size_t idx = i * 8 + j;
-          if (idx < cap) {
-            return idx;
-          }
-        }
-      }
-    }
+  // 64 slots per step: the first clear bit below capacity
+  for (size_t w = 0; w * 8u < bm_bytes; w++) {
+    uint64_t free_bits = ~bitmap_word(bm, bm_bytes, w) & bitmap_valid_mask(cap, w);
+    if (free_bits)
+      return (int)(w * 64u + word_ctz(free_bits));
   }
   return -1;
 }
@@ -239,6 +226,30 @@ void tbl_set_next_page(void* page, uint32_t next_page) {
   hdr_set_next_page(page, next_page);
 }
 
+uint32_t tbl_get_root_page(const void* page) {
+  return read_le_u32((const uint8_t*)page + TABLE_HDR_ROOT_PAGE_OFF);
+}
+
+void tbl_set_root_page(void* page, uint32_t root_page) {
+  write_le_u32((uint8_t*)page + TABLE_HDR_ROOT_PAGE_OFF, root_page);
+}
+
+uint32_t tbl_get_fsm_page(const void* page) {
+  return read_le_u32((const uint8_t*)page + TABLE_HDR_FSM_PAGE_OFF);
+}
+
+void tbl_set_fsm_page(void* page, uint32_t fsm_page) {
+  write_le_u32((uint8_t*)page + TABLE_HDR_FSM_PAGE_OFF, fsm_page);
+}
+
+uint32_t tbl_get_index_page(const void* page) {
+  return read_le_u32((const uint8_t*)page + TABLE_HDR_INDEX_PAGE_OFF);
+}
+
+void tbl_set_index_page(void* page, uint32_t index_page) {
+  write_le_u32((uint8_t*)page + TABLE_HDR_INDEX_PAGE_OFF, index_page);
+}
+
 int tbl_slot_is_used(const void* page, int idx) {
   if (!page || idx < 0)
     return 0;
@@ -256,6 +267,38 @@ int tbl_slot_is_used(const void* page, int idx) {
   return (bm[byte] & bit_mask) != 0;
 }
 
+void tbl_slot_iter_init(TblSlotIter* it, const void* page) {
+  it->bitmap = bitmap_ptr_c(page);
+  it->capacity = hdr_capacity(page);
+  it->base = 0;
+  it->bits = it->capacity
+           ? bitmap_word(it->bitmap, bitmap_size_bytes(it->capacity), 0) & bitmap_valid_mask(it->capacity, 0)
+           : 0;
+}
+
+int tbl_slot_iter_next(TblSlotIter* it) {
+  const size_t nbytes = bitmap_size_bytes(it->capacity);
+
+  while (it->bits == 0) {
+    const size_t w = it->base / 64u + 1u;
+    if (w * 8u >= nbytes)
+      return -1;
+    it->base = (uint16_t)(w * 64u);
+    it->bits = bitmap_word(it->bitmap, nbytes, w) & bitmap_valid_mask(it->capacity, w);
+  }
+
+  const int idx = (int)(it->base + word_ctz(it->bits));
+  it->bits &= it->bits - 1u;   // clear the lowest set bit
+  return idx;
+}
+
+uint64_t tbl_slot_word(const void* page, unsigned w) {
+  const uint16_t cap = hdr_capacity(page);
+  if ((size_t)w * 64u >= cap)
+    return 0;
+  return bitmap_word(bitmap_ptr_c(page), bitmap_size_bytes(cap), w) & bitmap_valid_mask(cap, w);
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Header accessors (internal)
 // ─────────────────────────────────────────────────────────────────────────────
@@ -341,13 +384,13 @@ static inline void hdr_set_next_page(void* page, uint32_t v) {
 }
 
 /**
- * @brief Zero out all reserved header fields.
+ * @brief Zero out the ownership, free-space and index words.
  */
 static inline void hdr_clear_reserved(void* page) {
   uint8_t* base = (uint8_t*)page;
-  write_le_u32(base + TABLE_HDR_RESERVED0_OFF, 0);
-  write_le_u32(base + TABLE_HDR_RESERVED1_OFF, 0);
-  write_le_u32(base + TABLE_HDR_RESERVED2_OFF, 0);
+  write_le_u32(base + TABLE_HDR_ROOT_PAGE_OFF, 0);
+  write_le_u32(base + TABLE_HDR_FSM_PAGE_OFF, 0);
+  write_le_u32(base + TABLE_HDR_INDEX_PAGE_OFF, 0);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -388,16 +431,57 @@ static inline size_t bitmap_size_bytes(uint16_t capacity) {
  */
 static inline size_t bitmap_popcount(const uint8_t* bm, size_t nbytes) {
   size_t count = 0;
-  for (size_t i = 0; i < nbytes; i++) {
-    uint8_t byte = bm[i];
-    while (byte) {
-      count += byte & 1u;
-      byte >>= 1;
-    }
-  }
+  for (size_t w = 0; w * 8u < nbytes; w++)
+    count += word_popcount(bitmap_word(bm, nbytes, w));
   return count;
 }
 
+/**
+ * @brief Load bitmap word w (slots [64w, 64w + 64)) as a host integer.
+ *
+ * Bit k of the result is slot 64w + k, matching the LSB-first byte layout;
+ * bytes past the end of the bitmap read as zero.
+ */
+static inline uint64_t bitmap_word(const uint8_t* bm, size_t nbytes, size_t w) {
+  const size_t off = w * 8u;
+  const size_t n = nbytes - off < 8u ? nbytes - off : 8u;
+  uint64_t v = 0;
+  for (size_t k = 0; k < n; k++)
+    v |= (uint64_t)bm[off + k] << (8u * k);
+  return v;
+}
+
+/**
+ * @brief Mask of the bits of word w that map to slots below capacity.
+ */
+static inline uint64_t bitmap_valid_mask(uint16_t capacity, size_t w) {
+  const size_t first = w * 64u;
+  if (capacity <= first) return 0;
+  if (capacity - first >= 64u) return ~(uint64_t)0;
+  return ((uint64_t)1 << (capacity - first)) - 1u;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+static inline unsigned word_popcount(uint64_t x) { return (unsigned)__builtin_popcountll(x); }
+static inline unsigned word_ctz(uint64_t x)      { return (unsigned)__builtin_ctzll(x); }
+#else
+static inline unsigned word_popcount(uint64_t x) {
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return (unsigned)((x * 0x0101010101010101ull) >> 56);
+}
+
+/**
+ * @brief Index of the lowest set bit; x must be non-zero.
+ */
+static inline unsigned word_ctz(uint64_t x) {
+  unsigned n = 0;
+  while ((x & 1u) == 0) { x >>= 1; n++; }
+  return n;
+}
+#endif
+
 /**
  * @brief Compute the byte offset where record data begins.
  */
@@ -405,11 +489,13 @@ static inline size_t data_offset(uint16_t capacity) {
   return TABLE_HDR_SIZE + bitmap_size_bytes(capacity);
 }
 
-static int compute_capacity(int record_size) {
-  if (record_size <= 0 || record_size > TABLE_PAGE_SIZE)
+static int compute_capacity(size_t page_size, int record_size) {
+  if (record_size <= 0 || (size_t)record_size > page_size || page_size <= TABLE_HDR_SIZE)
     return 0;
 
-  size_t available = TABLE_PAGE_SIZE - TABLE_HDR_SIZE;
+  // The checksum trailer fits in the slack of every supported page size:
+  // reserving it costs no slot
+  size_t available = page_size - TABLE_HDR_SIZE - TABLE_LEAF_CRC_SIZE;
 
   if (available < (size_t) record_size)
     return 0;
@@ -422,10 +508,10 @@ static int compute_capacity(int record_size) {
   for (size_t c = guess; c > 0; c--) {
     size_t bitmap_bytes = (c + 7) / 8;
 
-    size_t total = TABLE_HDR_SIZE + bitmap_bytes + (size_t) (c * record_size);
+    size_t total = TABLE_HDR_SIZE + bitmap_bytes + (size_t) (c * record_size) + TABLE_LEAF_CRC_SIZE;
 
-    if (total <= TABLE_PAGE_SIZE)
-      return c;
+    if (total <= page_size)
+      return c > UINT16_MAX ? 0 : (int)c;
   }
   return 0;
 }
@@ -6,17 +6,36 @@
 // Libraries
 // ─────────────────────────────────────────────────────────────────────────────
 #include <stdint.h>
+#include <stddef.h>
 
 // ─────────────────────────────────────────────────────────────────────────────
 /* Public constants (V1)
  * - Page type: TABLE_PAGE_KIND_LEAF (0x0001)
  * - Record size fixed at 128 B (TABLE_RECORD_SIZE)
  * - Header is 24 B; all multi-byte integers are little-endian on disk.
+ * - Capacity is derived from the file's page size (4 KiB: 31 slots,
+ *   16 KiB: 127, 64 KiB: 511), so the slot index always fits in 16 bits.
+ * - The last TABLE_LEAF_CRC_SIZE bytes of a leaf hold its checksum, kept by
+ *   the pager (PAGER_CRC_PAGE_KIND in pager.h); the record area stops
+ *   before them.
  */
 // ─────────────────────────────────────────────────────────────────────────────
 #define TABLE_PAGE_KIND_LEAF        0x0001
+#define TABLE_PAGE_KIND_FSM         0x0002  /* free-space map, see fsm.h */
+#define TABLE_PAGE_KIND_HASH_META   0x0003  /* hash index header, see hash_index.h */
+#define TABLE_PAGE_KIND_HASH_BUCKET 0x0004  /* hash index bucket */
+#define TABLE_PAGE_KIND_BTREE_META  0x0005  /* B+tree index header, see btree.h */
+#define TABLE_PAGE_KIND_BTREE_INNER 0x0006  /* B+tree interior node */
+#define TABLE_PAGE_KIND_BTREE_LEAF  0x0007  /* B+tree leaf node */
+#define TABLE_PAGE_KIND_CATALOG     0x0008  /* table catalog, see catalog.h */
+#define TABLE_PAGE_KIND_DIRECTORY   0x0009  /* leaf directory of one table */
+#define TABLE_PAGE_KIND_SLOTTED     0x000A  /* variable-length records, see slotted.h */
+#define TABLE_PAGE_KIND_OVERFLOW    0x000B  /* tail of a record too long for its page */
+#define TABLE_PAGE_KIND_PACKED      0x000D  /* compressed fixed-size records, see packed.h */
+#define TABLE_PAGE_KIND_PAX         0x000E  /* fixed-size records by column, see pax.h */
 #define TABLE_RECORD_SIZE           128
 #define TABLE_HDR_SIZE              24
+#define TABLE_LEAF_CRC_SIZE         4   /* u32 at page_size - 4: CRC-32C, 0 = none */
 
 /* Header offsets (bytes) */
 #define TABLE_HDR_KIND_OFF          0   /* u16 */
@@ -24,9 +43,29 @@
 #define TABLE_HDR_CAPACITY_OFF      4   /* u16 */
 #define TABLE_HDR_USED_COUNT_OFF    6   /* u16 */
 #define TABLE_HDR_NEXT_PAGE_OFF     8   /* u32 */
-#define TABLE_HDR_RESERVED0_OFF     12  /* u32 */
-#define TABLE_HDR_RESERVED1_OFF     16  /* u32 */
-#define TABLE_HDR_RESERVED2_OFF     20  /* u32 */
+#define TABLE_HDR_ROOT_PAGE_OFF     12  /* u32: root page of the owning table (0 = unknown) */
+#define TABLE_HDR_FSM_PAGE_OFF      16  /* u32: root only, free-space map head (0 = none) */
+#define TABLE_HDR_INDEX_PAGE_OFF    20  /* u32: root only, first index header page (0 = none) */
+
+/* Secondary indexes of a table form a list: the root points at the first
+ * index header page, and every index header page stores the next one at
+ * TABLE_INDEX_NEXT_OFF (u32, 0 = end), whatever its index kind.
+ */
+#define TABLE_INDEX_NEXT_OFF        8
+
+/* Record ids: id = (page << 16) | slot in 64 bits, so every page the pager
+ * can address holds records; ids below 2^32 keep the value they had when
+ * ids were 32-bit. Index entries store an id in TABLE_ID_SIZE(version)
+ * bytes, version being the file's format version (see pager.h): files of
+ * version 1 keep 4-byte ids, so their table leaves stay at or below
+ * TABLE_ID_V1_MAX_PAGE.
+ */
+#define TABLE_ID(page, slot)        ((((uint64_t)(page)) << 16) | (uint16_t)(slot))
+#define TABLE_ID_PAGE(id)           ((uint32_t)((uint64_t)(id) >> 16))
+#define TABLE_ID_SLOT(id)           ((uint16_t)((id) & 0xFFFFu))
+#define TABLE_ID_MAX                TABLE_ID(UINT32_MAX, 0xFFFFu)
+#define TABLE_ID_V1_MAX_PAGE        0xFFFFu
+#define TABLE_ID_SIZE(version)      ((version) >= 2 ? 8u : 4u)
 
 /* Bitmap: placed immediately after header; size = ceil(capacity/8).
  * Bit ordering: LSB-first within each byte (bit 0 => slot 0).
@@ -41,7 +80,11 @@ typedef enum {
   TABLE_E_BADKIND = -2,
   TABLE_E_LAYOUT = -3,
   TABLE_E_BITMAP = -4,
-  TABLE_E_FULL = -5
+  TABLE_E_FULL = -5,
+  TABLE_E_NOTFOUND = -6,
+  TABLE_E_CORRUPT = -7,   /* page checksum mismatch */
+  TABLE_E_IO = -8,        /* the pager could not read or write the file */
+  TABLE_E_NOFRAME = -9    /* every buffer pool frame is pinned */
 } TableError;
 
 
@@ -55,25 +98,27 @@ typedef enum {
  * Sets header fields, computes capacity, clears bitmap, and resets counters.
  * The record size must be 128 bytes in V1.
  *
- * @param[in,out] page         Pointer to a 4 KiB page buffer.
+ * @param[in,out] page         Pointer to a page buffer of page_size bytes.
+ * @param[in]     page_size    Page size of the file (capacity is derived from it).
  * @param[in]     record_size  Record size (must be 128 for V1).
  * @return TABLE_OK on success or a negative TableError on failure.
  */
-int   tbl_init_leaf(void* page, uint16_t record_size /*=128*/);
+int   tbl_init_leaf(void* page, size_t page_size, uint16_t record_size /*=128*/);
 
 /**
  * @brief Validate the internal consistency of a TABLE_LEAF page.
  * Checks header fields, recomputed capacity, used_count bounds, bitmap popcount
- * equality, geometry (header + bitmap + data fits in page), and that high bits
+ * equality, geometry (header + bitmap + data + checksum fit in page), and that high bits
  * beyond capacity in the last bitmap byte are zero (LSB-first layout).
- * @param[in] page Non-null pointer to a 4 KiB page.
+ * @param[in] page      Non-null pointer to a page of page_size bytes.
+ * @param[in] page_size Page size of the file.
  * @return TABLE_OK on success,
  *         TABLE_E_INVAL (bad args),
  *         TABLE_E_BADKIND (wrong kind),
  *         TABLE_E_LAYOUT (record_size/capacity/geometry issues),
  *         TABLE_E_BITMAP (bitmap popcount or extra bits set).
  */
-int   tbl_validate(const void* page);
+int   tbl_validate(const void* page, size_t page_size);
 
 /**
  * @brief Find the first free slot (bit = 0) scanning LSB-first.
@@ -156,6 +201,25 @@ uint16_t tbl_get_kind(const void* page);
  */
 void tbl_set_next_page(void* page, uint32_t next_page);
 
+/**
+ * @brief Retrieve / set the root page of the table owning this leaf.
+ * A root page records itself; 0 means the page predates ownership tracking.
+ */
+uint32_t tbl_get_root_page(const void* page);
+void tbl_set_root_page(void* page, uint32_t root_page);
+
+/**
+ * @brief Retrieve / set the free-space map head page (meaningful on roots only).
+ */
+uint32_t tbl_get_fsm_page(const void* page);
+void tbl_set_fsm_page(void* page, uint32_t fsm_page);
+
+/**
+ * @brief Retrieve / set the first index header page (meaningful on roots only).
+ */
+uint32_t tbl_get_index_page(const void* page);
+void tbl_set_index_page(void* page, uint32_t index_page);
+
 /**
  * @brief Check if a slot is currently used (bit = 1).
  * @param[in] page Page buffer (TABLE_LEAF).
@@ -164,5 +228,35 @@ void tbl_set_next_page(void* page, uint32_t next_page);
  */
 int tbl_slot_is_used(const void* page, int idx);
 
+/**
+ * @brief Iterator over the used slots of a leaf, in slot order.
+ *
+ * Walks the set bits of the bitmap a 64-bit word at a time instead of
+ * probing every slot. The page must stay pinned and unmodified while the
+ * iterator is in use.
+ */
+typedef struct TblSlotIter {
+  const uint8_t* bitmap;
+  uint16_t       capacity;
+  uint16_t       base;   /* first slot of the current word */
+  uint64_t       bits;   /* used slots of the current word not yet returned */
+} TblSlotIter;
+
+/**
+ * @brief Start iterating a validated leaf page.
+ */
+void tbl_slot_iter_init(TblSlotIter* it, const void* page);
+
+/**
+ * @brief Next used slot index, or -1 when all have been visited.
+ */
+int tbl_slot_iter_next(TblSlotIter* it);
+
+/**
+ * @brief Used slots [64*w, 64*w + 64) of a validated leaf page as one word
+ *        (bit j = slot 64*w + j); 0 past the capacity.
+ */
+uint64_t tbl_slot_word(const void* page, unsigned w);
+
 
 #endif //TABLE_H
\ No newline at end of file
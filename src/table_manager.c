@@ -1,27 +1,386 @@
+#define _POSIX_C_SOURCE 200809L
 #include "table_manager.h"
 #include <string.h>
 #include "table.h"
+#include "fsm.h"
+#include "slotted.h"
+#include "packed.h"
+#include "pax.h"
+#include "catalog.h"
+#include "hash_index.h"
+#include "btree_index.h"
+#include "endian_util.h"
+#include "stats.h"
+#include "arena.h"
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Record id helpers: id = TABLE_ID(page, slot), see table.h
+// ─────────────────────────────────────────────────────────────────────────────
+// An id past TABLE_ID_MAX maps to page 0, which every caller rejects
+static inline uint32_t id_page(uint64_t id) { return id > TABLE_ID_MAX ? 0 : TABLE_ID_PAGE(id); }
+static inline uint16_t id_slot(uint64_t id) { return TABLE_ID_SLOT(id); }
+static inline uint64_t make_id(uint32_t page, uint32_t slot) {
+  return TABLE_ID(page, slot);
+}
 
-int tblmgr_create(Pager* pager, uint32_t first_page_num) {
+/**
+ * @brief Whether `page` may hold records of this file: a version 1 file
+ *        stores 4-byte ids in its indexes (see TABLE_ID_SIZE).
+ */
+static inline bool leaf_page_ok(const Pager* p, uint32_t page) {
+  return pager_format_version(p) >= 2 || page <= TABLE_ID_V1_MAX_PAGE;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Leaf kinds (internal): fixed-size TABLE_LEAF, its read-mostly PACKED
+// form, column-wise PAX, or variable-length SLOTTED
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Validate a pinned table leaf of any kind, whatever the pager
+ *        knows of it. A checksum mismatch is reported as TABLE_E_CORRUPT.
+ */
+static int leaf_validate_full(Pager* p, const void* buf) {
+  if (pager_page_state(p, buf) == PAGER_PAGE_CORRUPT)
+    return TABLE_E_CORRUPT;
+  const uint64_t t0 = stats_start();
+  int rc;
+  switch (tbl_get_kind(buf)) {
+    case TABLE_PAGE_KIND_LEAF:    rc = tbl_validate(buf, pager_page_size(p)); break;
+    case TABLE_PAGE_KIND_SLOTTED: rc = spg_validate(buf, pager_page_size(p)); break;
+    case TABLE_PAGE_KIND_PACKED:  rc = pkl_validate(buf, pager_page_size(p)); break;
+    case TABLE_PAGE_KIND_PAX:     rc = pax_validate(buf, pager_page_size(p)); break;
+    default:                      return TABLE_E_BADKIND;
+  }
+  stats_add(STAT_LEAF_VALIDATIONS, 1);
+  stats_stop(STAT_H_VALIDATE, t0);
+  return rc;
+}
+
+/**
+ * @brief Validate a pinned table leaf of any kind once per stay in the
+ *        buffer pool: a page validated since it was loaded is trusted by
+ *        the pager and only has its kind checked (PagerConfig.paranoid
+ *        checks every access in full).
+ */
+static int leaf_validate(Pager* p, const void* buf) {
+  const uint16_t kind = tbl_get_kind(buf);
+  if (kind != TABLE_PAGE_KIND_LEAF && kind != TABLE_PAGE_KIND_SLOTTED &&
+      kind != TABLE_PAGE_KIND_PACKED && kind != TABLE_PAGE_KIND_PAX)
+    return TABLE_E_BADKIND;
+  if (pager_page_state(p, buf) == PAGER_PAGE_TRUSTED)
+    return TABLE_OK;
+  const int rc = leaf_validate_full(p, buf);
+  if (rc == TABLE_OK)
+    pager_page_trust(p, buf);
+  return rc;
+}
+
+/**
+ * @brief leaf_validate() for a leaf that must hold fixed-size records
+ *        written in place, by rows or by columns (inserts, the root).
+ */
+static int leaf_check(Pager* p, const void* buf) {
+  if (tbl_get_kind(buf) != TABLE_PAGE_KIND_LEAF && tbl_get_kind(buf) != TABLE_PAGE_KIND_PAX)
+    return TABLE_E_BADKIND;
+  return leaf_validate(p, buf);
+}
+
+/**
+ * @brief leaf_check() that also takes a packed leaf (readers, update, delete).
+ */
+static int leaf_check_fixed(Pager* p, const void* buf) {
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_PACKED)
+    return leaf_validate(p, buf);
+  return leaf_check(p, buf);
+}
+
+/**
+ * @brief Whether a leaf of `kind` belongs in a table whose root has
+ *        `table_kind`: the same kind, or packed leaves in a fixed-size table.
+ */
+static inline bool leaf_kind_ok(uint16_t table_kind, uint16_t kind) {
+  return kind == table_kind ||
+         (table_kind == TABLE_PAGE_KIND_LEAF && kind == TABLE_PAGE_KIND_PACKED);
+}
+
+/**
+ * @brief Memory of one call, taken from the calling thread's arena
+ *        (arena.h) and given back all at once by scratch_end(): calls
+ *        nest, and none of them reaches malloc once the arena has grown.
+ */
+typedef struct Scratch {
+  Arena*    a;        // NULL when the thread's arena could not be created
+  ArenaMark m;
+} Scratch;
+
+static inline Scratch scratch_begin(void) {
+  Arena* a = arena_thread();
+  return (Scratch){ .a = a, .m = a ? arena_mark(a) : (ArenaMark){ 0 } };
+}
+
+/** @brief NULL when out of memory. */
+static inline void* scratch_alloc(Scratch* s, size_t n) { return arena_alloc(s->a, n); }
+static inline void* scratch_calloc(Scratch* s, size_t n) { return arena_calloc(s->a, n); }
+
+static inline void scratch_end(Scratch* s) {
+  if (s->a) arena_rewind(s->a, s->m);
+}
+
+/**
+ * @brief Scratch image for packed and PAX leaves, reused from leaf to leaf
+ *        (a larger one is taken from `mem` when a leaf needs it).
+ */
+typedef struct LeafScratch {
+  Scratch* mem;
+  uint8_t* buf;
+  size_t   cap;
+} LeafScratch;
+
+/**
+ * @brief The records of a validated fixed-size leaf as a TABLE_LEAF image:
+ *        the page itself, or a packed or PAX leaf decoded into `s`.
+ */
+static int leaf_records(const uint8_t* buf, LeafScratch* s, const uint8_t** out) {
+  const uint16_t kind = tbl_get_kind(buf);
+  if (kind != TABLE_PAGE_KIND_PACKED && kind != TABLE_PAGE_KIND_PAX) { *out = buf; return TABLE_OK; }
+  const uint16_t cap = tbl_get_capacity(buf);
+  const size_t need = kind == TABLE_PAGE_KIND_PAX ? pax_image_size(cap) : pkl_image_size(cap);
+  if (need > s->cap) {
+    uint8_t* grown = scratch_alloc(s->mem, need);
+    if (!grown) return TABLE_E_INVAL;
+    s->buf = grown;
+    s->cap = need;
+  }
+  if (kind == TABLE_PAGE_KIND_PAX) pax_decode(buf, s->buf);
+  else                             pkl_decode(buf, s->buf);
+  *out = s->buf;
+  return TABLE_OK;
+}
+
+/**
+ * @brief Copy out record `slot` of a validated fixed-size leaf of any kind.
+ */
+static void leaf_rec_get(const uint8_t* buf, int slot, void* out) {
+  switch (tbl_get_kind(buf)) {
+    case TABLE_PAGE_KIND_PACKED: pkl_record(buf, slot, out); break;
+    case TABLE_PAGE_KIND_PAX:    pax_get(buf, slot, out, PAX_ALL_COLUMNS); break;
+    default:                     memcpy(out, tbl_slot_ptr_c(buf, slot), TABLE_RECORD_SIZE); break;
+  }
+}
+
+/**
+ * @brief Store record `slot` of a validated leaf written in place
+ *        (TABLE_LEAF or PAX); NULL zeroes it. The bitmap is left alone.
+ */
+static void leaf_rec_put(uint8_t* buf, int slot, const void* rec) {
+  static const uint8_t zero[TABLE_RECORD_SIZE];
+  if (!rec) rec = zero;
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_PAX) pax_put(buf, slot, rec);
+  else                                          memcpy(tbl_slot_ptr(buf, slot), rec, TABLE_RECORD_SIZE);
+}
+
+/**
+ * @brief Open the pager write section of one public change (see
+ *        pager_write_begin): snapshots begin before or after it, never
+ *        in the middle. Fails from a thread bound to a snapshot.
+ */
+static int write_begin(Pager* p) {
+  return pager_write_begin(p) == PAGER_OK ? TABLE_OK : TABLE_E_INVAL;
+}
+
+/**
+ * @brief Whether a validated leaf belongs on its table's free-space map: a
+ *        free slot for fixed-size records, spg_min_free() bytes for slotted,
+ *        never for a packed leaf (only vacuum writes those).
+ */
+static bool leaf_has_room(const Pager* p, const void* buf) {
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_PACKED)
+    return false;
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_SLOTTED)
+    return spg_free_space(buf, pager_page_size(p)) >= spg_min_free(pager_page_size(p));
+  return tbl_get_used_count(buf) < tbl_get_capacity(buf);
+}
+
+/**
+ * @brief Initialize an empty leaf of the given kind in a zeroed frame
+ *        (`layout`: the columns of a PAX leaf, ignored otherwise).
+ */
+static int leaf_init(const Pager* p, void* buf, uint16_t kind, const PaxLayout* layout) {
+  if (kind == TABLE_PAGE_KIND_SLOTTED) return spg_init(buf, pager_page_size(p));
+  if (kind == TABLE_PAGE_KIND_PAX)     return pax_init(buf, pager_page_size(p), layout);
+  return tbl_init_leaf(buf, pager_page_size(p), TABLE_RECORD_SIZE);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Catalog maintenance (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Collect the page numbers of a table's chain, root first, and
+ *        optionally its row count.
+ *        A chain longer than the file (a loop) is reported as TABLE_E_LAYOUT.
+ */
+static int chain_walk(Pager* pager, uint32_t root_page_no, uint32_t** out, size_t* out_n,
+                      uint64_t* out_rows) {
+  const uint32_t page_count = pager_page_count(pager);
+  size_t cap = 64, n = 0;
+  uint32_t* pages = malloc(cap * sizeof *pages);
+  if (!pages) return TABLE_E_INVAL;
+
+  uint64_t rows = 0;
+  uint32_t page = root_page_no;
+  while (page != 0) {
+    if (page >= page_count || n >= page_count) { free(pages); return TABLE_E_LAYOUT; }
+    if (n == cap) {
+      uint32_t* grown = realloc(pages, 2 * cap * sizeof *pages);
+      if (!grown) { free(pages); return TABLE_E_INVAL; }
+      pages = grown;
+      cap *= 2;
+    }
+    pages[n++] = page;
+
+    const uint8_t* buf = NULL;
+    if (pager_pin(pager, page, (const void**)&buf) != PAGER_OK) { free(pages); return TABLE_E_INVAL; }
+    const int rc = leaf_validate(pager, buf);
+    rows += tbl_get_used_count(buf);
+    page = tbl_get_next_page(buf);
+    pager_unpin(pager, buf, false);
+    if (rc != TABLE_OK) { free(pages); return rc; }
+  }
+
+  *out = pages;
+  *out_n = n;
+  if (out_rows) *out_rows = rows;
+  return TABLE_OK;
+}
+
+static int chain_pages(Pager* pager, uint32_t root_page_no, uint32_t** out, size_t* out_n,
+                       uint64_t* out_rows) {
+  const PagerAccess prev = pager_set_access(pager, PAGER_ACCESS_SEQUENTIAL);
+  const int rc = chain_walk(pager, root_page_no, out, out_n, out_rows);
+  pager_set_access(pager, prev);
+  return rc;
+}
+
+/**
+ * @brief Catalog entry of a table, registering it first if it has none (new
+ *        tables, and tables written before the catalog existed: one chain walk).
+ */
+static int table_catalog(Pager* p, uint32_t root_page_no, CatEntry* out) {
+  int rc = cat_lookup(p, root_page_no, out);
+  if (rc != TABLE_E_NOTFOUND) return rc;
+
+  uint32_t* pages = NULL;
+  size_t npages = 0;
+  uint64_t rows = 0;
+  rc = chain_pages(p, root_page_no, &pages, &npages, &rows);
+  if (rc != TABLE_OK) return rc;
+  rc = cat_add(p, root_page_no, pages, npages, rows, out);
+  free(pages);
+  return rc;
+}
+
+/**
+ * @brief Leaf pages of a table in chain order, in `mem`: from its directory
+ *        when the table is in the catalog, by walking the chain otherwise.
+ */
+static int table_pages(Pager* p, uint32_t root_page_no, Scratch* mem, uint32_t** out, size_t* out_n) {
+  CatEntry cat;
+  int rc = cat_lookup(p, root_page_no, &cat);
+  if (rc == TABLE_OK) return cat_dir_pages_in(p, &cat, mem->a, out, out_n);
+  if (rc != TABLE_E_NOTFOUND) return rc;
+
+  uint32_t* chain = NULL;
+  size_t n = 0;
+  rc = chain_pages(p, root_page_no, &chain, &n, NULL);
+  if (rc != TABLE_OK) return rc;
+  *out = scratch_alloc(mem, n * sizeof *chain);
+  if (*out) memcpy(*out, chain, n * sizeof *chain);
+  *out_n = n;
+  free(chain);
+  return *out ? TABLE_OK : TABLE_E_INVAL;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Read-ahead (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Leaves a chain walk is about to visit, taken from the table's
+ *        directory, loaded `window` at a time with pager_prefetch() so that
+ *        several reads are in flight instead of one per leaf.
+ */
+typedef struct ReadAhead {
+  Pager*    pager;
+  uint32_t* pages;    // in the walk's scratch; NULL when the table has no catalog entry
+  size_t    n;
+  size_t    next;     // first leaf not requested yet
+  size_t    window;
+} ReadAhead;
+
+/**
+ * @brief Leaves per pager_prefetch() call: the I/O depth, within a quarter
+ *        of the pool.
+ */
+static size_t prefetch_window(const Pager* p) {
+  size_t w = pager_io_depth(p);
+  if (w > pager_cache_pages(p) / 4) w = pager_cache_pages(p) / 4;
+  return w;
+}
+
+static void ra_open(ReadAhead* ra, Pager* p, uint32_t root_page_no, Scratch* mem) {
+  memset(ra, 0, sizeof *ra);
+  ra->pager = p;
+  ra->window = prefetch_window(p);
+
+  CatEntry cat;
+  if (ra->window > 1 && cat_lookup(p, root_page_no, &cat) == TABLE_OK && cat.leaves > 1 &&
+      cat_dir_pages_in(p, &cat, mem->a, &ra->pages, &ra->n) != TABLE_OK) {
+    ra->pages = NULL;
+    ra->n = 0;
+  }
+}
+
+/**
+ * @brief The walk reached leaf k of the chain (a hint: a chain that
+ *        disagrees with the directory only wastes the reads).
+ */
+static void ra_visit(ReadAhead* ra, size_t k) {
+  if (k < ra->next || k >= ra->n)
+    return;
+  const size_t w = ra->n - k < ra->window ? ra->n - k : ra->window;
+  (void)pager_prefetch(ra->pager, ra->pages + k, w);
+  ra->next = k + w;
+}
+
+/**
+ * @brief tblmgr_create() / _var() / _pax(): the root is a leaf of `kind`
+ *        (with the columns of `layout` for PAX).
+ */
+static int create_table(Pager* pager, uint32_t first_page_num, uint16_t kind, const PaxLayout* layout) {
   if (!pager || first_page_num == 0)
     return TABLE_E_INVAL;
+  if (!leaf_page_ok(pager, first_page_num))
+    return TABLE_E_FULL;
 
-  while (first_page_num >= pager_page_count(pager)) {
-    uint32_t new_no;
-    int rc = pager_alloc_page(pager, &new_no);
+  // Grow the file up to the requested page (free pages are not it)
+  const uint32_t page_count = pager_page_count(pager);
+  if (first_page_num >= page_count) {
+    uint32_t first;
+    int rc = pager_alloc_pages(pager, first_page_num + 1 - page_count, &first);
     if (rc != PAGER_OK) {
       return TABLE_E_INVAL;
     }
   }
 
   size_t page_sz = pager_page_size(pager);
-  uint8_t *buf = malloc(page_sz);
-  if (!buf) return TABLE_E_INVAL;
+  uint8_t *buf = NULL;
 
-  int rc = pager_read(pager, first_page_num, buf);
-  if (rc < 0) { free(buf); return TABLE_E_INVAL; }
+  int rc = pager_pin_mut(pager, first_page_num, (void**)&buf);
+  if (rc < 0) return TABLE_E_INVAL;
 
   bool all_zero = true;
   for (size_t i = 0; i < page_sz; i++) {
@@ -32,156 +391,1054 @@ int tblmgr_create(Pager* pager, uint32_t first_page_num) {
   }
 
   if (all_zero) {
-    rc = tbl_init_leaf(buf, TABLE_RECORD_SIZE);
-    if (rc != TABLE_OK) { free(buf); return rc; }
+    rc = leaf_init(pager, buf, kind, layout);
+    if (rc != TABLE_OK) { pager_unpin(pager, buf, true); return rc; }
+    tbl_set_root_page(buf, first_page_num);
 
-    rc = tbl_validate(buf);
-    if (rc != TABLE_OK) { free(buf); return rc; }
+    rc = leaf_validate(pager, buf);
+    pager_unpin(pager, buf, true);
+    if (rc != TABLE_OK) return rc;
 
-    rc = pager_write(pager, first_page_num, buf);
-    if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
-
-    free(buf);
-    return TABLE_OK;
+    CatEntry cat;
+    return table_catalog(pager, first_page_num, &cat);
   }
 
-  rc = tbl_validate(buf);
-  if (rc != TABLE_OK) { free(buf); return rc; }
+  rc = leaf_validate(pager, buf);
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
 
-  if (tbl_get_record_size(buf) == TABLE_RECORD_SIZE &&
+  bool same_layout = tbl_get_kind(buf) == kind &&
+      (kind == TABLE_PAGE_KIND_SLOTTED || tbl_get_record_size(buf) == TABLE_RECORD_SIZE);
+  if (same_layout && kind == TABLE_PAGE_KIND_PAX) {
+    PaxLayout have;
+    pax_layout_of(buf, &have);
+    same_layout = have.n == layout->n && memcmp(have.start, layout->start, have.n) == 0;
+  }
+  if (same_layout &&
       tbl_get_used_count(buf)  == 0 &&
       tbl_get_next_page(buf)   == 0) {
-    free(buf);
-    return TABLE_OK;
+    pager_unpin(pager, buf, false);
+    CatEntry cat;
+    return table_catalog(pager, first_page_num, &cat);
   }
 
-  free(buf);
+  pager_unpin(pager, buf, false);
   return TABLE_E_INVAL;
 }
 
-int tblmgr_insert(Pager* p, uint32_t root_page_no, const void* rec_128b, uint32_t* out_id)
-{
-  if (!p || root_page_no < 1 || !rec_128b) {
-    return TABLE_E_INVAL;
+int tblmgr_create(Pager* pager, uint32_t first_page_num) {
+  int rc = write_begin(pager);
+  if (rc != TABLE_OK) return rc;
+  rc = create_table(pager, first_page_num, TABLE_PAGE_KIND_LEAF, NULL);
+  pager_write_end(pager);
+  return rc;
+}
+
+int tblmgr_create_var(Pager* pager, uint32_t first_page_num) {
+  int rc = write_begin(pager);
+  if (rc != TABLE_OK) return rc;
+  rc = create_table(pager, first_page_num, TABLE_PAGE_KIND_SLOTTED, NULL);
+  pager_write_end(pager);
+  return rc;
+}
+
+int tblmgr_create_pax(Pager* pager, uint32_t first_page_num, const PaxLayout* layout) {
+  if (!layout) return TABLE_E_INVAL;
+  int rc = write_begin(pager);
+  if (rc != TABLE_OK) return rc;
+  rc = create_table(pager, first_page_num, TABLE_PAGE_KIND_PAX, layout);
+  pager_write_end(pager);
+  return rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Page allocation (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Allocate `count` pages for a chain: pages from the pager's free
+ *        list first, then one group at the end of the file for the rest.
+ */
+static int alloc_page_run(Pager* p, uint32_t count, uint32_t* pages) {
+  uint32_t got = 0;
+  while (got < count && pager_free_count(p) > 0) {
+    if (pager_alloc_page(p, &pages[got]) != PAGER_OK) return TABLE_E_INVAL;
+    got++;
   }
+  if (got < count) {
+    uint32_t first;
+    if (pager_alloc_pages(p, count - got, &first) != PAGER_OK) return TABLE_E_INVAL;
+    for (uint32_t k = 0; got < count; k++) pages[got++] = first + k;
+  }
+  return TABLE_OK;
+}
 
-  const size_t pgsz = pager_page_size(p);
-  uint8_t* buf = malloc(pgsz);
-  if (!buf) return TABLE_E_INVAL;
+// ─────────────────────────────────────────────────────────────────────────────
+// Free-space map maintenance (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Record that page_no has a free slot in its table's FSM.
+ *
+ * A full head FSM page gets a new head pushed in front of it; the root's
+ * FSM pointer is then updated and *root_dirty is set.
+ */
+static int fsm_note_free(Pager* p, uint8_t* rootbuf, uint32_t page_no, bool* root_dirty) {
+  const uint32_t head_no = tbl_get_fsm_page(rootbuf);
+  if (head_no == 0)
+    return TABLE_OK; // no map yet: built on the next insert
+
+  uint8_t* head = NULL;
+  if (pager_pin_mut(p, head_no, (void**)&head) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = fsm_validate(head, pager_page_size(p));
+  if (rc != TABLE_OK) { pager_unpin(p, head, false); return rc; }
+
+  if (fsm_push(head, page_no) == TABLE_OK) {
+    pager_unpin(p, head, true);
+    return TABLE_OK;
+  }
+
+  // Head is full: chain a fresh head in front of it
+  uint32_t new_no;
+  if (pager_alloc_page(p, &new_no) != PAGER_OK) { pager_unpin(p, head, false); return TABLE_E_INVAL; }
+
+  uint8_t* nh = NULL;
+  if (pager_pin_zero(p, new_no, (void**)&nh) != PAGER_OK) { pager_unpin(p, head, false); return TABLE_E_INVAL; }
 
+  rc = fsm_init(nh, pager_page_size(p));
+  if (rc == TABLE_OK) {
+    fsm_set_next(nh, head_no);
+    fsm_set_tail(nh, fsm_get_tail(head));
+    rc = fsm_push(nh, page_no);
+  }
+  pager_unpin(p, nh, true);
+  pager_unpin(p, head, false);
+  if (rc != TABLE_OK) return rc;
+
+  tbl_set_fsm_page(rootbuf, new_no);
+  *root_dirty = true;
+  return TABLE_OK;
+}
+
+/**
+ * @brief Build the FSM of a table that does not have one yet.
+ *
+ * Walks the chain once, stamps every leaf with its owning root, pushes the
+ * leaves that have room and records the tail. Used on the first insert into
+ * a table (including tables written before the FSM existed).
+ */
+static int fsm_build(Pager* p, uint32_t root_page_no, uint8_t* rootbuf) {
+  uint32_t fsm_no;
+  if (pager_alloc_page(p, &fsm_no) != PAGER_OK) return TABLE_E_INVAL;
+
+  uint8_t* fsm = NULL;
+  if (pager_pin_zero(p, fsm_no, (void**)&fsm) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = fsm_init(fsm, pager_page_size(p));
+  pager_unpin(p, fsm, true);
+  if (rc != TABLE_OK) return rc;
+
+  tbl_set_root_page(rootbuf, root_page_no);
+  tbl_set_fsm_page(rootbuf, fsm_no);
+
+  const uint32_t page_count = pager_page_count(p);
   uint32_t page = root_page_no;
+  uint32_t tail = root_page_no;
+  bool dummy = false;
 
-  // insert loop
-  while (true) {
-    int rc = pager_read(p, page, buf);
-    if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+  while (page != 0) {
+    if (page >= page_count) return TABLE_E_LAYOUT;
 
-    // Validate the table/leaf format
-    rc = tbl_validate(buf);
-    if (rc != TABLE_OK) { free(buf); return rc; }
+    uint8_t* buf = NULL;
+    if (pager_pin_mut(p, page, (void**)&buf) != PAGER_OK) return TABLE_E_INVAL;
 
-    const uint16_t cap  = tbl_get_capacity(buf);
-    const uint16_t used = tbl_get_used_count(buf);
+    rc = leaf_validate(p, buf);
+    if (rc != TABLE_OK) { pager_unpin(p, buf, false); return rc; }
+
+    tbl_set_root_page(buf, root_page_no);
+    const bool has_room = leaf_has_room(p, buf);
     const uint32_t next = tbl_get_next_page(buf);
+    pager_unpin(p, buf, true);
 
-    // if there's space, insert here
-    if (used < cap) {
-      int idx = tbl_slot_find_free(buf);
-      if (idx < 0) { free(buf); return TABLE_E_LAYOUT; }
+    if (has_room) {
+      rc = fsm_note_free(p, rootbuf, page, &dummy);
+      if (rc != TABLE_OK) return rc;
+    }
 
-      void *dst = tbl_slot_ptr(buf, (uint16_t) idx);
-      if (!dst) { free(buf); return TABLE_E_INVAL; }
+    tail = page;
+    page = next;
+  }
 
-      memcpy(dst, rec_128b, TABLE_RECORD_SIZE);
+  // The head may have changed while pushing: record the tail on the final head
+  if (pager_pin_mut(p, tbl_get_fsm_page(rootbuf), (void**)&fsm) != PAGER_OK) return TABLE_E_INVAL;
+  fsm_set_tail(fsm, tail);
+  pager_unpin(p, fsm, true);
+  return TABLE_OK;
+}
 
-      tbl_slot_mark_used(buf, (uint16_t)idx);
+/**
+ * @brief Append `count` fresh leaves after the chain tail and push them on
+ *        the FSM head, first new leaf on top.
+ *
+ * The tail comes from the catalog entry, so no chain walk is needed. The
+ * pages come from the free list, the rest as one group (single file
+ * extension and header update), and are initialized straight in their
+ * frames; they are added to the table's directory and `cat` is updated
+ * (the caller stores it).
+ *
+ * @param head Pinned (mutable) FSM head page with room for `count` entries.
+ * @param kind Leaf kind of the table (TABLE_PAGE_KIND_LEAF, _PAX or
+ *             _SLOTTED); new PAX leaves copy the tail's columns.
+ */
+static int fsm_append_leaves(Pager* p, uint32_t root_page_no, uint8_t* head, uint32_t count,
+                             CatEntry* cat, uint16_t kind) {
+  const uint32_t tail = cat->tail;
+
+  // (a) The recorded tail must end the chain
+  uint8_t* tailbuf = NULL;
+  if (tail == 0 || tail >= pager_page_count(p)) return TABLE_E_LAYOUT;
+  if (pager_pin_mut(p, tail, (void**)&tailbuf) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = leaf_validate(p, tailbuf);
+  if (rc == TABLE_OK && (!leaf_kind_ok(kind, tbl_get_kind(tailbuf)) || tbl_get_next_page(tailbuf) != 0))
+    rc = TABLE_E_LAYOUT;
+  if (rc != TABLE_OK) { pager_unpin(p, tailbuf, false); return rc; }
+
+  PaxLayout layout;
+  if (kind == TABLE_PAGE_KIND_PAX) pax_layout_of(tailbuf, &layout);
+
+  Scratch mem = scratch_begin();
+  uint32_t* added = scratch_alloc(&mem, (size_t)count * sizeof *added);
+  if (!added) { pager_unpin(p, tailbuf, false); return TABLE_E_INVAL; }
+
+  // (b) Allocate the pages and initialize each leaf, already chained
+  rc = alloc_page_run(p, count, added);
+  if (rc != TABLE_OK) { scratch_end(&mem); pager_unpin(p, tailbuf, false); return rc; }
+
+  // A version 1 file cannot give ids to leaves past TABLE_ID_V1_MAX_PAGE:
+  // those pages go back to the free list and the group shrinks
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (leaf_page_ok(p, added[i])) added[kept++] = added[i];
+    else                           pager_free_page(p, added[i]);
+  }
+  if (kept == 0) { scratch_end(&mem); pager_unpin(p, tailbuf, false); return TABLE_E_FULL; }
+  count = kept;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint8_t* newbuf = NULL;
+    if (pager_pin_zero(p, added[i], (void**)&newbuf) != PAGER_OK) { scratch_end(&mem); pager_unpin(p, tailbuf, false); return TABLE_E_INVAL; }
+
+    rc = leaf_init(p, newbuf, kind, &layout);
+    tbl_set_root_page(newbuf, root_page_no);
+    tbl_set_next_page(newbuf, (i + 1 < count) ? added[i + 1] : 0);
+    pager_unpin(p, newbuf, true);
+    if (rc != TABLE_OK) { scratch_end(&mem); pager_unpin(p, tailbuf, false); return rc; }
+  }
+
+  // (c) Link the old tail to the new leaves, then record them in the directory
+  tbl_set_next_page(tailbuf, added[0]);
+  pager_unpin(p, tailbuf, true);
+
+  rc = cat_dir_append(p, cat, added, count);
+  if (rc != TABLE_OK) { scratch_end(&mem); return rc; }
+
+  fsm_set_tail(head, added[count - 1]);
+  for (uint32_t i = count; i > 0 && rc == TABLE_OK; i--)
+    rc = fsm_push(head, added[i - 1]);
+  scratch_end(&mem);
+  return rc;
+}
 
-      rc = pager_write(p, page, buf);
-      if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+/**
+ * @brief Pin (mutable) and validate the FSM head of a table, first dropping
+ *        empty heads that have older heads behind them (the tail is carried
+ *        over). Sets *root_dirty when the root's FSM pointer moves.
+ */
+static int fsm_pin_head(Pager* p, uint8_t* rootbuf, bool* root_dirty, uint8_t** out_head) {
+  while (true) {
+    const uint32_t head_no = tbl_get_fsm_page(rootbuf);
+    if (head_no == 0 || head_no >= pager_page_count(p)) return TABLE_E_LAYOUT;
+
+    uint8_t* head = NULL;
+    if (pager_pin_mut(p, head_no, (void**)&head) != PAGER_OK) return TABLE_E_INVAL;
 
-      // Compose a 32-bit logical record ID: (page << 16) | slot
-      if (out_id)
-        *out_id = (page << 16) | (uint32_t)idx;
+    int rc = fsm_validate(head, pager_page_size(p));
+    if (rc != TABLE_OK) { pager_unpin(p, head, false); return rc; }
 
-      free(buf);
+    if (fsm_get_count(head) != 0 || fsm_get_next(head) == 0) {
+      *out_head = head;
       return TABLE_OK;
     }
 
-    // if the page is full, follow the linked chain if possible
-    if (next != 0) {
-      page = next;
+    const uint32_t next_no = fsm_get_next(head);
+    uint8_t* next = NULL;
+    if (pager_pin_mut(p, next_no, (void**)&next) != PAGER_OK) { pager_unpin(p, head, false); return TABLE_E_INVAL; }
+    fsm_set_tail(next, fsm_get_tail(head));
+    pager_unpin(p, next, true);
+    pager_unpin(p, head, false);
+    tbl_set_fsm_page(rootbuf, next_no);
+    *root_dirty = true;
+  }
+}
+
+/**
+ * @brief Adjust the catalog row count of a table (no-op if not cataloged).
+ */
+static int catalog_add_rows(Pager* p, uint32_t root_page_no, int64_t delta) {
+  CatEntry cat;
+  int rc = cat_lookup(p, root_page_no, &cat);
+  if (rc == TABLE_E_NOTFOUND) return TABLE_OK;
+  if (rc != TABLE_OK) return rc;
+  cat.rows = (delta < 0 && cat.rows < (uint64_t)-delta) ? 0 : cat.rows + (uint64_t)delta;
+  return cat_store(p, &cat);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Secondary index maintenance (internal)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief First index header page of the table owning `leaf` (0 = none).
+ *
+ * @param leaf    Pinned, validated leaf page.
+ * @param page_no Its page number (a root records itself as owner).
+ */
+static uint32_t table_index_head(Pager* p, const uint8_t* leaf, uint32_t page_no) {
+  const uint32_t owner = tbl_get_root_page(leaf);
+  if (owner == 0 || owner >= pager_page_count(p))
+    return 0; // unowned leaves predate indexes: hidx_create stamps them
+  if (owner == page_no)
+    return tbl_get_index_page(leaf);
+
+  const uint8_t* root = NULL;
+  if (pager_pin(p, owner, (const void**)&root) != PAGER_OK) return 0;
+  uint32_t head = 0;
+  if (leaf_check(p, root) == TABLE_OK && tbl_get_root_page(root) == owner)
+    head = tbl_get_index_page(root);
+  pager_unpin(p, root, false);
+  return head;
+}
+
+/**
+ * @brief Apply one record change to the index whose header page is idx;
+ *        its next index header page goes to *out_next.
+ */
+static int index_apply_one(Pager* p, uint32_t idx, const void* old_rec,
+                           const void* new_rec, uint64_t id, uint32_t* out_next) {
+  const uint8_t* hdr = NULL;
+  if (pager_pin(p, idx, (const void**)&hdr) != PAGER_OK) return TABLE_E_INVAL;
+  const uint16_t kind = read_le_u16(hdr);
+  *out_next = read_le_u32(hdr + TABLE_INDEX_NEXT_OFF);
+  pager_unpin(p, hdr, false);
+
+  switch (kind) {
+    case TABLE_PAGE_KIND_HASH_META:
+      if (old_rec && new_rec) return hidx_update(p, idx, old_rec, new_rec, id);
+      if (new_rec)            return hidx_insert(p, idx, new_rec, id);
+      return hidx_remove(p, idx, old_rec, id);
+    case TABLE_PAGE_KIND_BTREE_META:
+      if (old_rec && new_rec) return bidx_update(p, idx, old_rec, new_rec, id);
+      if (new_rec)            return bidx_insert(p, idx, new_rec, id);
+      return bidx_remove(p, idx, old_rec, id);
+    default:
+      return TABLE_E_BADKIND;
+  }
+}
+
+/**
+ * @brief Propagate one record change to every index of a table, all or
+ *        nothing: if one index fails, the ones before it are changed back.
+ *
+ * old_rec == NULL means an insert, new_rec == NULL a delete, both an update.
+ */
+static int indexes_apply(Pager* p, uint32_t index_head, const void* old_rec,
+                         const void* new_rec, uint64_t id) {
+  uint32_t idx = index_head;
+  uint32_t hops = 0;
+  int rc = TABLE_OK;
+
+  while (idx != 0) {
+    if (idx >= pager_page_count(p) || ++hops > pager_page_count(p)) { rc = TABLE_E_LAYOUT; break; }
+    uint32_t next = 0;
+    rc = index_apply_one(p, idx, old_rec, new_rec, id, &next);
+    if (rc != TABLE_OK) break;
+    idx = next;
+  }
+  if (rc == TABLE_OK)
+    return TABLE_OK;
+
+  // Undo the indexes in front of the failed one: the same walk reaches idx
+  for (uint32_t undo = index_head; undo != idx && undo != 0; ) {
+    uint32_t next = 0;
+    if (index_apply_one(p, undo, new_rec, old_rec, id, &next) != TABLE_OK) break;
+    undo = next;
+  }
+  return rc;
+}
+
+/**
+ * @brief Re-key a record that moves from old_id to new_id in every index of
+ *        its table; if that fails, the indexes keep old_id.
+ */
+static int indexes_move(Pager* p, uint32_t index_head, const void* rec,
+                        uint64_t old_id, uint64_t new_id) {
+  if (index_head == 0)
+    return TABLE_OK;
+  int rc = indexes_apply(p, index_head, rec, NULL, old_id);
+  if (rc != TABLE_OK)
+    return rc;
+  rc = indexes_apply(p, index_head, NULL, rec, new_id);
+  if (rc != TABLE_OK)
+    indexes_apply(p, index_head, NULL, rec, old_id);
+  return rc;
+}
+
+static int insert_batch(Pager* p, uint32_t root_page_no,
+                        const void* recs, size_t n, uint64_t* out_ids)
+{
+  if (!p || root_page_no < 1 || !recs) {
+    return TABLE_E_INVAL;
+  }
+
+  if (root_page_no >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  if (n == 0)
+    return TABLE_OK;
+
+  uint8_t* rootbuf = NULL;
+  int rc = pager_pin_mut(p, root_page_no, (void**)&rootbuf);
+  if (rc != PAGER_OK) return TABLE_E_INVAL;
+
+  rc = leaf_check(p, rootbuf);
+  if (rc != TABLE_OK) { pager_unpin(p, rootbuf, false); return rc; }
+
+  const uint32_t owner = tbl_get_root_page(rootbuf);
+  if (owner != 0 && owner != root_page_no) { pager_unpin(p, rootbuf, false); return TABLE_E_INVAL; }
+
+  const uint16_t kind = tbl_get_kind(rootbuf);
+  const uint16_t leaf_cap = tbl_get_capacity(rootbuf);
+  const uint32_t index_head = tbl_get_index_page(rootbuf);
+  const uint8_t* src = (const uint8_t*)recs;
+  size_t done = 0;
+
+  bool root_dirty = false;
+  if (tbl_get_fsm_page(rootbuf) == 0) {
+    rc = fsm_build(p, root_page_no, rootbuf);
+    root_dirty = true;
+    if (rc != TABLE_OK) { pager_unpin(p, rootbuf, true); return rc; }
+  }
+
+  CatEntry cat;
+  rc = table_catalog(p, root_page_no, &cat);
+  if (rc != TABLE_OK) { pager_unpin(p, rootbuf, root_dirty); return rc; }
+
+  // insert loop: fill the page on top of the FSM, skipping stale entries
+  rc = TABLE_OK;
+  while (done < n) {
+    uint8_t* head = NULL;
+    rc = fsm_pin_head(p, rootbuf, &root_dirty, &head);
+    if (rc != TABLE_OK) break;
+
+    // No page with room anywhere: grow the chain by as many leaves as the
+    // rest of the batch needs, bounded by one FSM page and by a quarter of
+    // the buffer pool (so new leaves are still cached when they get filled)
+    if (fsm_get_count(head) == 0) {
+      size_t want = (n - done + leaf_cap - 1) / leaf_cap;
+      size_t group = pager_cache_pages(p) / 4;
+      if (want > group) want = group;
+      if (want > fsm_get_capacity(head)) want = fsm_get_capacity(head);
+      if (want == 0) want = 1;
+      rc = fsm_append_leaves(p, root_page_no, head, (uint32_t)want, &cat, kind);
+      if (rc != TABLE_OK) { pager_unpin(p, head, true); break; }
+    }
+
+    const uint32_t page = fsm_top(head);
+    if (page == 0 || page >= pager_page_count(p)) {
+      fsm_pop(head);
+      pager_unpin(p, head, true);
       continue;
     }
 
-    // End of chain and page is full → allocate and link a new page
-    // (a) Allocate a new physical page
-    uint32_t new_page;
-    rc = pager_alloc_page(p, &new_page);
-    if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+    uint8_t* buf = NULL;
+    if (pager_pin_mut(p, page, (void**)&buf) != PAGER_OK) { pager_unpin(p, head, false); rc = TABLE_E_INVAL; break; }
+    stats_add(STAT_INSERT_PAGES, 1);
+
+    // Stale entry (not ours, corrupt or already full): discard and retry
+    if (leaf_check(p, buf) != TABLE_OK ||
+        tbl_get_kind(buf) != kind ||
+        tbl_get_root_page(buf) != root_page_no ||
+        tbl_get_used_count(buf) >= tbl_get_capacity(buf)) {
+      pager_unpin(p, buf, false);
+      fsm_pop(head);
+      pager_unpin(p, head, true);
+      continue;
+    }
+
+    // There's space: fill as many slots as possible, in place in the frame
+    const uint16_t cap = tbl_get_capacity(buf);
+    while (done < n && tbl_get_used_count(buf) < cap) {
+      int idx = tbl_slot_find_free(buf);
+      if (idx < 0) { rc = TABLE_E_LAYOUT; break; }
+
+      const uint8_t* rec = src + done * TABLE_RECORD_SIZE;
+      leaf_rec_put(buf, idx, rec);
+      tbl_slot_mark_used(buf, (uint16_t)idx);
+
+      // A record its indexes could not take is not inserted
+      const uint64_t id = make_id(page, (uint32_t)idx);
+      if (index_head != 0) {
+        rc = indexes_apply(p, index_head, NULL, rec, id);
+        if (rc != TABLE_OK) {
+          leaf_rec_put(buf, idx, NULL);
+          tbl_slot_mark_free(buf, idx);
+          break;
+        }
+      }
+      if (out_ids)
+        out_ids[done] = id;
+      done++;
+    }
+
+    // A page that just became full leaves the map
+    const bool now_full = tbl_get_used_count(buf) >= cap;
+    if (now_full)
+      fsm_pop(head);
+
+    pager_unpin(p, buf, true);
+    pager_unpin(p, head, now_full);
+    if (rc != TABLE_OK) break;
+  }
+
+  // Rows and leaves added so far, even after a failure
+  cat.rows += done;
+  stats_add(STAT_INSERTS, done);
+  const int cat_rc = cat_store(p, &cat);
+  if (rc == TABLE_OK) rc = cat_rc;
+
+  pager_unpin(p, rootbuf, root_dirty);
+  return rc;
+}
 
-    // (b) Prepare a fresh leaf page
-    uint8_t* newbuf = calloc(1, pgsz);
-    if (!newbuf) { free(buf); return TABLE_E_INVAL; }
+int tblmgr_insert(Pager* p, uint32_t root_page_no, const void* rec_128b, uint64_t* out_id)
+{
+  return tblmgr_insert_batch(p, root_page_no, rec_128b, 1, out_id);
+}
 
-    rc = tbl_init_leaf(newbuf, TABLE_RECORD_SIZE);
-    if (rc != TABLE_OK) { free(newbuf); free(buf); return rc; }
+int tblmgr_insert_batch(Pager* p, uint32_t root_page_no,
+                        const void* recs, size_t n, uint64_t* out_ids)
+{
+  const uint64_t t0 = stats_start();
+  int rc = write_begin(p);
+  if (rc != TABLE_OK) return rc;
+  rc = insert_batch(p, root_page_no, recs, n, out_ids);
+  pager_write_end(p);
+  stats_stop(STAT_H_INSERT, t0);
+  return rc;
+}
 
-    // Write the new page to disk before linking it
-    rc = pager_write(p, new_page, newbuf);
-    if (rc != PAGER_OK) { free(newbuf); free(buf); return TABLE_E_INVAL; }
-    free(newbuf);
+// ─────────────────────────────────────────────────────────────────────────────
+// Variable-length records (slotted leaves)
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Write `len` bytes to a fresh chain of overflow pages.
+ */
+static int ovf_write(Pager* p, uint32_t root_page_no, const uint8_t* rec, size_t len,
+                     uint32_t* out_first) {
+  const size_t chunk = spg_ovf_capacity(pager_page_size(p));
+  const size_t count = (len + chunk - 1) / chunk;
+  if (count > UINT32_MAX - pager_page_count(p)) return TABLE_E_INVAL;
+
+  Scratch mem = scratch_begin();
+  uint32_t* pages = scratch_alloc(&mem, count * sizeof *pages);
+  if (!pages) return TABLE_E_INVAL;
+  int rc = alloc_page_run(p, (uint32_t)count, pages);
+  if (rc != TABLE_OK) { scratch_end(&mem); return rc; }
+
+  for (size_t i = 0; i < count && rc == TABLE_OK; i++) {
+    uint8_t* buf = NULL;
+    if (pager_pin_zero(p, pages[i], (void**)&buf) != PAGER_OK) { rc = TABLE_E_INVAL; break; }
+    const size_t n = len - i * chunk < chunk ? len - i * chunk : chunk;
+    rc = spg_ovf_init(buf, pager_page_size(p), root_page_no);
+    spg_ovf_set_len(buf, (uint32_t)n);
+    spg_ovf_set_next(buf, i + 1 < count ? pages[i + 1] : 0);
+    memcpy(buf + SPG_OVF_HDR_SIZE, rec + i * chunk, n);
+    pager_unpin(p, buf, true);
+  }
+  if (rc == TABLE_OK) *out_first = pages[0];
+  else for (size_t i = 0; i < count; i++) pager_free_page(p, pages[i]);
+  scratch_end(&mem);
+  return rc;
+}
 
-    // (c) Link the old full page to the new page
-    tbl_set_next_page(buf, new_page);
-    rc = pager_write(p, page, buf);
-    if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+/**
+ * @brief Put every page of an overflow chain on the pager's free list.
+ */
+static int ovf_free(Pager* p, uint32_t page) {
+  const uint32_t page_count = pager_page_count(p);
+  uint32_t hops = 0;
+  while (page != 0) {
+    if (page >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* buf = NULL;
+    if (pager_pin(p, page, (const void**)&buf) != PAGER_OK) return TABLE_E_INVAL;
+    const int rc = spg_ovf_validate(buf, pager_page_size(p));
+    const uint32_t next = spg_ovf_get_next(buf);
+    pager_unpin(p, buf, false);
+    if (rc != TABLE_OK) return rc;
+    if (pager_free_page(p, page) != PAGER_OK) return TABLE_E_INVAL;
+    page = next;
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief Follow the overflow chain of a stub, copying it into out (NULL:
+ *        only check that the chain holds exactly the stub's length).
+ */
+static int ovf_read(Pager* p, const uint8_t* stub, uint8_t* out) {
+  const uint32_t total = read_le_u32(stub + SPG_OVF_STUB_LEN_OFF);
+  const uint32_t page_count = pager_page_count(p);
+  uint32_t page = read_le_u32(stub + SPG_OVF_STUB_PAGE_OFF);
+  size_t done = 0;
+
+  while (done < total) {
+    if (page == 0 || page >= page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* buf = NULL;
+    if (pager_pin(p, page, (const void**)&buf) != PAGER_OK) return TABLE_E_INVAL;
+    int rc = spg_ovf_validate(buf, pager_page_size(p));
+    const uint32_t n = spg_ovf_get_len(buf);
+    if (rc == TABLE_OK && n > total - done) rc = TABLE_E_LAYOUT;
+    if (rc == TABLE_OK && out) memcpy(out + done, buf + SPG_OVF_HDR_SIZE, n);
+    page = spg_ovf_get_next(buf);
+    pager_unpin(p, buf, false);
+    if (rc != TABLE_OK) return rc;
+    done += n;
+  }
+  return page == 0 ? TABLE_OK : TABLE_E_LAYOUT;
+}
 
-    // Now continue on the new page in the next loop iteration
-    page = new_page;
+/**
+ * @brief Pin (mutable) a leaf that can take `len` more bytes: validated,
+ *        slotted and owned by the table. Returns NULL otherwise.
+ */
+static uint8_t* pin_slotted_with_room(Pager* p, uint32_t root_page_no, uint32_t page, size_t len) {
+  if (page == 0 || page >= pager_page_count(p)) return NULL;
+  uint8_t* buf = NULL;
+  if (pager_pin_mut(p, page, (void**)&buf) != PAGER_OK) return NULL;
+  if (spg_validate(buf, pager_page_size(p)) != TABLE_OK || tbl_get_root_page(buf) != root_page_no ||
+      !spg_fits(buf, pager_page_size(p), len)) {
+    pager_unpin(p, buf, false);
+    return NULL;
   }
+  return buf;
+}
+
+static int insert_var(Pager* p, uint32_t root_page_no, const void* rec, size_t len, uint64_t* out_id)
+{
+  if (!p || root_page_no < 1 || !rec || len == 0 || len > UINT32_MAX)
+    return TABLE_E_INVAL;
+
+  if (root_page_no >= pager_page_count(p))
+    return TABLE_E_INVAL;
+
+  uint8_t* rootbuf = NULL;
+  if (pager_pin_mut(p, root_page_no, (void**)&rootbuf) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = spg_validate(rootbuf, pager_page_size(p));
+  if (rc != TABLE_OK) { pager_unpin(p, rootbuf, false); return rc; }
+
+  const uint32_t owner = tbl_get_root_page(rootbuf);
+  if (owner != root_page_no) { pager_unpin(p, rootbuf, false); return TABLE_E_INVAL; }
+
+  bool root_dirty = false;
+  if (tbl_get_fsm_page(rootbuf) == 0) {
+    rc = fsm_build(p, root_page_no, rootbuf);
+    root_dirty = true;
+    if (rc != TABLE_OK) { pager_unpin(p, rootbuf, true); return rc; }
+  }
+
+  CatEntry cat;
+  rc = table_catalog(p, root_page_no, &cat);
+  if (rc != TABLE_OK) { pager_unpin(p, rootbuf, root_dirty); return rc; }
+
+  // What goes into the slot: the record itself, or a stub for its overflow chain
+  const size_t ps = pager_page_size(p);
+  const bool overflow = len > spg_max_inline(ps);
+  uint8_t stub[SPG_OVF_STUB_SIZE];
+  const uint8_t* payload = (const uint8_t*)rec;
+  size_t stored = len;
+  uint32_t first = 0;
+  if (overflow) {
+    rc = ovf_write(p, root_page_no, (const uint8_t*)rec, len, &first);
+    if (rc != TABLE_OK) { pager_unpin(p, rootbuf, root_dirty); return rc; }
+    write_le_u32(stub + SPG_OVF_STUB_LEN_OFF, (uint32_t)len);
+    write_le_u32(stub + SPG_OVF_STUB_PAGE_OFF, first);
+    payload = stub;
+    stored = sizeof stub;
+  }
+
+  uint32_t placed = 0;   // the leaf holding the new slot, once inserted
+  uint16_t slot = 0;
+  while (true) {
+    uint8_t* head = NULL;
+    rc = fsm_pin_head(p, rootbuf, &root_dirty, &head);
+    if (rc != TABLE_OK) break;
+
+    if (fsm_get_count(head) == 0) {
+      rc = fsm_append_leaves(p, root_page_no, head, 1, &cat, TABLE_PAGE_KIND_SLOTTED);
+      if (rc != TABLE_OK) { pager_unpin(p, head, true); break; }
+    }
+
+    // Stale entry (not ours, corrupt or below the fill threshold): discard
+    const uint32_t top = fsm_top(head);
+    uint8_t* buf = NULL;
+    if (top != 0 && top < pager_page_count(p) && pager_pin_mut(p, top, (void**)&buf) == PAGER_OK &&
+        (spg_validate(buf, ps) != TABLE_OK || tbl_get_root_page(buf) != root_page_no ||
+         !leaf_has_room(p, buf))) {
+      pager_unpin(p, buf, false);
+      buf = NULL;
+    }
+    if (!buf) {
+      fsm_pop(head);
+      pager_unpin(p, head, true);
+      continue;
+    }
+
+    // Too long for the top page: try the tail, else open a new leaf on top
+    // of the map (dropping the top entry if the head page is full)
+    uint32_t page = top;
+    if (!spg_fits(buf, ps, stored)) {
+      pager_unpin(p, buf, false);
+      buf = cat.tail != top ? pin_slotted_with_room(p, root_page_no, cat.tail, stored) : NULL;
+      page = cat.tail;
+      if (!buf) {
+        if (fsm_get_count(head) == fsm_get_capacity(head)) fsm_pop(head);
+        rc = fsm_append_leaves(p, root_page_no, head, 1, &cat, TABLE_PAGE_KIND_SLOTTED);
+        pager_unpin(p, head, true);
+        if (rc != TABLE_OK) break;
+        continue;
+      }
+    }
+
+    rc = spg_insert(buf, ps, payload, stored, overflow, &slot);
+    if (rc == TABLE_OK) placed = page;
+
+    // The top page leaves the map once it is below the fill threshold
+    const bool popped = page == top && !leaf_has_room(p, buf);
+    if (popped) fsm_pop(head);
+    pager_unpin(p, buf, rc == TABLE_OK);
+    pager_unpin(p, head, popped);
+    break;
+  }
+
+  if (rc == TABLE_OK) {
+    cat.rows++;
+    rc = cat_store(p, &cat);
+    if (rc != TABLE_OK) cat.rows--;
+  }
+  if (rc != TABLE_OK) {
+    // Undo the slot and the chain it pointed to; keep leaves added before
+    // the failure
+    uint8_t* buf = NULL;
+    if (placed && pager_pin_mut(p, placed, (void**)&buf) == PAGER_OK) {
+      spg_delete(buf, ps, slot);
+      pager_unpin(p, buf, true);
+    }
+    if (first != 0) ovf_free(p, first);
+    cat_store(p, &cat);
+  } else if (out_id) {
+    *out_id = make_id(placed, slot);
+  }
+  pager_unpin(p, rootbuf, root_dirty);
+  return rc;
+}
+
+int tblmgr_insert_var(Pager* p, uint32_t root_page_no, const void* rec, size_t len, uint64_t* out_id)
+{
+  int rc = write_begin(p);
+  if (rc != TABLE_OK) return rc;
+  rc = insert_var(p, root_page_no, rec, len, out_id);
+  pager_write_end(p);
+  return rc;
+}
+
+int tblmgr_get_var(Pager* pager, uint64_t id, void* out, size_t cap, size_t* out_len) {
+  if (!pager || !out_len || (!out && cap != 0)) return TABLE_E_INVAL;
+
+  const uint32_t page_no  = id_page(id);
+  const uint16_t slot_idx = id_slot(id);
+
+  const uint32_t page_count = pager_page_count(pager);
+  if (page_no == 0 || page_no >= page_count) return TABLE_E_INVAL;
+
+  const uint8_t* buf = NULL;
+  if (pager_pin(pager, page_no, (const void**)&buf) != PAGER_OK) return TABLE_E_INVAL;
+
+  int rc = leaf_validate(pager, buf);
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
+
+  const uint8_t* src = NULL;
+  size_t len = 0;
+  bool overflow = false;
+  uint8_t unpacked[TABLE_RECORD_SIZE];
+  if (tbl_get_kind(buf) != TABLE_PAGE_KIND_SLOTTED) {
+    if (slot_idx < tbl_get_capacity(buf) && tbl_slot_is_used(buf, slot_idx)) {
+      leaf_rec_get(buf, slot_idx, unpacked);
+      src = unpacked;
+    }
+    len = TABLE_RECORD_SIZE;
+  } else {
+    uint16_t stored = 0;
+    src = spg_record(buf, slot_idx, &stored, &overflow);
+    len = overflow && src ? read_le_u32(src + SPG_OVF_STUB_LEN_OFF) : stored;
+  }
+  if (!src) { pager_unpin(pager, buf, false); return TABLE_E_INVAL; }
+
+  *out_len = len;
+  if (len > cap) { pager_unpin(pager, buf, false); return TABLE_E_FULL; }
+
+  if (overflow) rc = ovf_read(pager, src, (uint8_t*)out);
+  else          memcpy(out, src, len);
+  pager_unpin(pager, buf, false);
+  return rc;
+}
+
+int tblmgr_scan_var(Pager* pager,
+                    uint32_t root_page_no,
+                    int (*callback)(const void* record,
+                                    size_t len,
+                                    uint64_t record_id,
+                                    void* user_data),
+                    void* user_data)
+{
+  if (!pager || root_page_no == 0 || !callback)
+    return TABLE_E_INVAL;
+
+  Scratch mem = scratch_begin();
+  uint8_t* scratch = NULL;   // overflowed records are assembled here
+  size_t scratch_cap = 0;
+  LeafScratch packed = { .mem = &mem };
+  uint32_t page = root_page_no;
+  int rc = TABLE_OK;
+
+  ReadAhead ra;
+  ra_open(&ra, pager, root_page_no, &mem);
+  const PagerAccess prev = pager_set_access(pager, PAGER_ACCESS_SEQUENTIAL);
+
+  for (size_t leaf = 0; page != 0 && rc == TABLE_OK; leaf++) {
+    ra_visit(&ra, leaf);
+    const uint8_t* buf = NULL;
+    if (pager_pin(pager, page, (const void**)&buf) != PAGER_OK) { rc = TABLE_E_INVAL; break; }
+
+    rc = leaf_validate(pager, buf);
+    const uint32_t next = tbl_get_next_page(buf);
+    if (rc == TABLE_OK && next >= pager_page_count(pager)) rc = TABLE_E_LAYOUT;
+
+    if (rc == TABLE_OK && tbl_get_kind(buf) != TABLE_PAGE_KIND_SLOTTED) {
+      const uint8_t* recs = NULL;
+      rc = leaf_records(buf, &packed, &recs);
+      TblSlotIter it;
+      tbl_slot_iter_init(&it, recs);
+      int i;
+      while (rc == TABLE_OK && (i = tbl_slot_iter_next(&it)) >= 0)
+        rc = callback(tbl_slot_ptr_c(recs, i), TABLE_RECORD_SIZE, make_id(page, (uint32_t)i), user_data);
+    } else if (rc == TABLE_OK) {
+      const uint16_t slots = spg_get_slot_count(buf);
+      for (int i = 0; i < slots && rc == TABLE_OK; i++) {
+        uint16_t stored = 0;
+        bool overflow = false;
+        const uint8_t* rec = spg_record(buf, i, &stored, &overflow);
+        if (!rec) continue;
+
+        size_t len = stored;
+        if (overflow) {
+          len = read_le_u32(rec + SPG_OVF_STUB_LEN_OFF);
+          if (len > scratch_cap) {
+            uint8_t* grown = scratch_alloc(&mem, len);
+            if (!grown) { rc = TABLE_E_INVAL; break; }
+            scratch = grown;
+            scratch_cap = len;
+          }
+          rc = ovf_read(pager, rec, scratch);
+          if (rc != TABLE_OK) break;
+          rec = scratch;
+        }
+        rc = callback(rec, len, make_id(page, (uint32_t)i), user_data);
+      }
+    }
+
+    pager_unpin(pager, buf, false);
+    page = next;
+  }
+
+  pager_set_access(pager, prev);
+  scratch_end(&mem);
+  return rc;
+}
+
+/**
+ * @brief Hand the records of a validated leaf that satisfy `where` (all of
+ *        them when NULL) to the callback, in slot order.
+ *
+ * The predicate filters a bitmap word of 64 slots at a time, straight on
+ * the records in the frame; only the surviving bits reach the callback.
+ */
+static int visit_leaf(const uint8_t* buf, uint32_t page, const TblPred* where,
+                      int (*callback)(const void*, uint64_t, void*), void* user_data) {
+  const uint16_t cap = tbl_get_capacity(buf);
+  const size_t stride = tbl_get_record_size(buf);
+
+  for (unsigned w = 0; (size_t)w * 64u < cap; w++) {
+    uint64_t bits = tbl_slot_word(buf, w);
+    if (bits == 0) continue;
+
+    const unsigned base = w * 64u;
+    if (where) {
+      const unsigned nrec = cap - base < 64u ? cap - base : 64u;
+      bits = pred_filter(where, (const uint8_t*)tbl_slot_ptr_c(buf, (int)base), stride, nrec, bits);
+    }
+    for (unsigned j = 0; j < 64u && (bits >> j) != 0; j++) {
+      if (!(bits >> j & 1u)) continue;
+      const int rc = callback(tbl_slot_ptr_c(buf, (int)(base + j)), make_id(page, base + j), user_data);
+      if (rc != 0) return rc;
+    }
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief visit_leaf() for a validated PAX leaf: each predicate term runs
+ *        on the minipage of its field, and only the matches are assembled,
+ *        from the columns in `cols`, into one scratch record. A term whose
+ *        field spans columns sends the leaf through its decoded image.
+ */
+static int visit_pax(const uint8_t* buf, uint32_t page, const TblPred* where, uint64_t cols,
+                     LeafScratch* s, int (*callback)(const void*, uint64_t, void*), void* user_data) {
+  const uint8_t* field[PRED_MAX_TERMS];
+  size_t stride[PRED_MAX_TERMS];
+  const int nterms = where ? where->n : 0;
+  for (int i = 0; i < nterms; i++) {
+    field[i] = pax_field(buf, where->t[i].off, where->t[i].len, &stride[i]);
+    if (!field[i]) {
+      const uint8_t* img = NULL;
+      const int rc = leaf_records(buf, s, &img);
+      return rc == TABLE_OK ? visit_leaf(img, page, where, callback, user_data) : rc;
+    }
+  }
+
+  // Bytes of the columns not assembled stay 0 for the whole leaf
+  uint8_t rec[TABLE_RECORD_SIZE] = { 0 };
+  const uint16_t cap = tbl_get_capacity(buf);
+  for (unsigned w = 0; (size_t)w * 64u < cap; w++) {
+    uint64_t bits = tbl_slot_word(buf, w);
+    if (bits == 0) continue;
+
+    const unsigned base = w * 64u;
+    if (where) {
+      const uint8_t* at[PRED_MAX_TERMS];
+      for (int i = 0; i < nterms; i++) at[i] = field[i] + (size_t)base * stride[i];
+      const unsigned nrec = cap - base < 64u ? cap - base : 64u;
+      bits = pred_filter_cols(where, at, stride, nrec, bits);
+    }
+    for (unsigned j = 0; j < 64u && (bits >> j) != 0; j++) {
+      if (!(bits >> j & 1u)) continue;
+      pax_get(buf, (int)(base + j), rec, cols);
+      const int rc = callback(rec, make_id(page, base + j), user_data);
+      if (rc != 0) return rc;
+    }
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief Visit a validated fixed-size leaf of any kind: in the frame, by
+ *        columns for PAX (only the columns holding `fields`, NULL = all),
+ *        or from the decoded image of a packed leaf.
+ */
+static int scan_leaf(const uint8_t* buf, uint32_t page, const TblPred* where, const TblFields* fields,
+                     LeafScratch* s, int (*callback)(const void*, uint64_t, void*), void* user_data) {
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_PAX) {
+    const uint64_t cols = fields ? pax_select(buf, fields->bytes) : PAX_ALL_COLUMNS;
+    return visit_pax(buf, page, where, cols, s, callback, user_data);
+  }
+  const uint8_t* recs = NULL;
+  const int rc = leaf_records(buf, s, &recs);
+  return rc == TABLE_OK ? visit_leaf(recs, page, where, callback, user_data) : rc;
+}
+
+void tblmgr_fields_add(TblFields* f, uint16_t off, uint16_t len) {
+  if (!f) return;
+  for (unsigned k = off; k < (unsigned)off + len && k < TABLE_RECORD_SIZE; k++)
+    f->bytes[k / 64u] |= UINT64_C(1) << (k % 64u);
 }
 
 int tblmgr_scan(Pager* pager,
                 uint32_t root_page_no,
                 int (*callback)(const void* record,
-                                uint32_t record_id,
+                                uint64_t record_id,
                                 void* user_data),
                 void* user_data)
+{
+  return tblmgr_scan_where(pager, root_page_no, NULL, callback, user_data);
+}
+
+int tblmgr_scan_where(Pager* pager,
+                      uint32_t root_page_no,
+                      const TblPred* where,
+                      int (*callback)(const void* record,
+                                      uint64_t record_id,
+                                      void* user_data),
+                      void* user_data)
+{
+  return tblmgr_scan_fields(pager, root_page_no, where, NULL, callback, user_data);
+}
+
+int tblmgr_scan_fields(Pager* pager,
+                       uint32_t root_page_no,
+                       const TblPred* where,
+                       const TblFields* fields,
+                       int (*callback)(const void* record,
+                                       uint64_t record_id,
+                                       void* user_data),
+                       void* user_data)
 {
   if (!pager || root_page_no == 0 || !callback)
     return TABLE_E_INVAL;
 
-  const size_t pgsz = pager_page_size(pager);
-  uint8_t* buf = (uint8_t*)malloc(pgsz);
-  if (!buf) return TABLE_E_INVAL;
-
   uint32_t page = root_page_no;
+  int rc = TABLE_OK;
+  Scratch mem = scratch_begin();
+  LeafScratch scratch = { .mem = &mem };
 
-  while (true) {
-    // read current page
-    int rc = pager_read(pager, page, buf);
-    if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+  // The leaves to come are read ahead, several at a time: from the catalog
+  // directory when there is one, else by the kernel following the chain
+  ReadAhead ra;
+  ra_open(&ra, pager, root_page_no, &mem);
+  const PagerAccess prev = pager_set_access(pager, PAGER_ACCESS_SEQUENTIAL);
+
+  for (size_t leaf = 0; rc == TABLE_OK; leaf++) {
+    ra_visit(&ra, leaf);
+
+    // pin current page (records are handed out straight from the frame,
+    // from the scratch image of a packed leaf, or assembled from the
+    // columns of a PAX leaf)
+    const uint8_t* buf = NULL;
+    if (pager_pin(pager, page, (const void**)&buf) != PAGER_OK) { rc = TABLE_E_INVAL; break; }
 
     // Validate table leaf page
-    rc = tbl_validate(buf);
-    if (rc != TABLE_OK) { free(buf); return rc; }
+    rc = leaf_check_fixed(pager, buf);
+    if (rc != TABLE_OK) { pager_unpin(pager, buf, false); break; }
 
-    const uint16_t cap  = tbl_get_capacity(buf);
     const uint32_t next = tbl_get_next_page(buf);
 
     const uint32_t page_count = pager_page_count(pager);
-    if (next >= page_count && next != 0) { free(buf); return TABLE_E_LAYOUT; }
-    // Visit all used slots and invoke the callback
-    for (uint16_t i = 0; i < cap; i++) {
-      if (!tbl_slot_is_used(buf, i))
-        continue;
+    if (next >= page_count && next != 0) { pager_unpin(pager, buf, false); rc = TABLE_E_LAYOUT; break; }
+    // Visit the used slots that pass the predicate and invoke the callback
+    rc = scan_leaf(buf, page, where, fields, &scratch, callback, user_data);
 
-      const void* rec = tbl_slot_ptr(buf, i);
-      uint32_t id = (page << 16) | (uint32_t)i;
-
-      int cb_rc = callback(rec, id, user_data);
-      if (cb_rc != 0) { free(buf); return cb_rc; }
-    }
+    pager_unpin(pager, buf, false);
 
     if (next == 0)
       break;
@@ -189,85 +1446,692 @@ int tblmgr_scan(Pager* pager,
     page = next;
   }
 
-  free(buf);
-  return TABLE_OK;
+  pager_set_access(pager, prev);
+  scratch_end(&mem);
+  return rc;
 }
 
-int tblmgr_delete(Pager* pager, uint32_t id) {
+// ─────────────────────────────────────────────────────────────────────────────
+// Parallel scan
+// ─────────────────────────────────────────────────────────────────────────────
+typedef struct ParScan {
+  Pager*                  pager;
+  const TblParallelScan*  opts;
+  const uint32_t*         pages;    // the leaves, in chain order
+  size_t                  window;   // leaves per read-ahead batch
+  PagerSnapshot*          snap;     // the caller's snapshot, shared by every worker
+  atomic_int              stop;     // set by the first failing worker
+  atomic_int              result;   // its status (TABLE_OK otherwise)
+} ParScan;
+
+typedef struct ParWorker {
+  ParScan*  scan;
+  size_t    first, end;             // slice [first, end) of scan->pages
+  void*     data;                   // per-worker state handed to the callback
+  pthread_t thread;
+  bool      started;
+} ParWorker;
+
+static void par_fail(ParScan* s, int rc) {
+  int expected = TABLE_OK;
+  atomic_compare_exchange_strong(&s->result, &expected, rc);
+  atomic_store(&s->stop, 1);
+}
+
+static void* par_worker_main(void* arg) {
+  ParWorker* w = (ParWorker*)arg;
+  ParScan* s = w->scan;
+
+  size_t ahead = w->first;   // first leaf of the slice not read ahead yet
+  Scratch mem = scratch_begin();
+  LeafScratch scratch = { .mem = &mem };
+  const PagerAccess prev = pager_set_access(s->pager, PAGER_ACCESS_SEQUENTIAL);
+  PagerSnapshot* prev_snap = pager_snapshot_current(s->pager);
+  (void)pager_snapshot_bind(s->pager, s->snap);
+  for (size_t k = w->first; k < w->end && !atomic_load_explicit(&s->stop, memory_order_relaxed); k++) {
+    if (k >= ahead && s->window > 1) {
+      ahead = w->end - k < s->window ? w->end : k + s->window;
+      (void)pager_prefetch(s->pager, s->pages + k, ahead - k);
+    }
+    const uint32_t page = s->pages[k];
+    const uint8_t* buf = NULL;
+    if (pager_pin(s->pager, page, (const void**)&buf) != PAGER_OK) { par_fail(s, TABLE_E_INVAL); break; }
+    const int v_rc = leaf_check_fixed(s->pager, buf);
+    if (v_rc != TABLE_OK) { pager_unpin(s->pager, buf, false); par_fail(s, v_rc); break; }
+
+    const int cb_rc = scan_leaf(buf, page, s->opts->where, s->opts->fields, &scratch,
+                                s->opts->callback, w->data);
+    pager_unpin(s->pager, buf, false);
+    if (cb_rc != 0) { par_fail(s, cb_rc); break; }
+  }
+  scratch_end(&mem);
+  (void)pager_snapshot_bind(s->pager, prev_snap);
+  pager_set_access(s->pager, prev);
+  return NULL;
+}
+
+static unsigned par_thread_count(const Pager* pager, unsigned wanted, size_t pages) {
+  if (wanted == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    wanted = online > 0 ? (unsigned)online : 1u;
+  }
+  if (wanted > TBLMGR_MAX_SCAN_THREADS) wanted = TBLMGR_MAX_SCAN_THREADS;
+  // Every worker holds one pin: leave most of the pool to everybody else
+  const size_t frames = pager_cache_pages(pager) / 2;
+  if (wanted > frames) wanted = (unsigned)frames;
+  if (wanted > pages) wanted = (unsigned)pages;
+  return wanted ? wanted : 1u;
+}
+
+int tblmgr_scan_parallel(Pager* pager, uint32_t root_page_no, const TblParallelScan* opts) {
+  if (!pager || root_page_no == 0 || !opts || !opts->callback)
+    return TABLE_E_INVAL;
+
+  Scratch mem = scratch_begin();
+  uint32_t* pages = NULL;
+  size_t npages = 0;
+  int rc = table_pages(pager, root_page_no, &mem, &pages, &npages);
+  if (rc != TABLE_OK) { scratch_end(&mem); return rc; }
+
+  // Only the owner of an open transaction sees its changes: it scans alone
+  const unsigned nthreads = pager_txn_owned(pager) ? 1u : par_thread_count(pager, opts->threads, npages);
+  ParWorker* workers = scratch_calloc(&mem, nthreads * sizeof *workers);
+  if (!workers) { scratch_end(&mem); return TABLE_E_INVAL; }
+
+  // Each worker reads its slice ahead; the batches share the pool
+  ParScan s = { .pager = pager, .opts = opts, .pages = pages,
+                .window = prefetch_window(pager) / nthreads,
+                .snap = pager_snapshot_current(pager) };
+  atomic_init(&s.stop, 0);
+  atomic_init(&s.result, TABLE_OK);
+
+  // Contiguous slices in chain order: worker k gets the k-th one
+  for (unsigned k = 0; k < nthreads; k++) {
+    workers[k].scan  = &s;
+    workers[k].first = npages * k / nthreads;
+    workers[k].end   = npages * (k + 1) / nthreads;
+    workers[k].data  = opts->worker_init ? opts->worker_init(k, opts->user_data) : opts->user_data;
+  }
+
+  // Worker 0 runs on the calling thread; a thread that cannot be started
+  // has its slice run there too
+  for (unsigned k = 1; k < nthreads; k++)
+    workers[k].started = pthread_create(&workers[k].thread, NULL, par_worker_main, &workers[k]) == 0;
+  par_worker_main(&workers[0]);
+  for (unsigned k = 1; k < nthreads; k++) {
+    if (workers[k].started) pthread_join(workers[k].thread, NULL);
+    else par_worker_main(&workers[k]);
+  }
+
+  rc = atomic_load(&s.result);
+  for (unsigned k = 0; k < nthreads; k++) {
+    if (!opts->merge) continue;
+    const int m_rc = opts->merge(workers[k].data, opts->user_data);
+    if (rc == TABLE_OK && m_rc != 0) rc = m_rc;
+  }
+
+  scratch_end(&mem);
+  return rc;
+}
+
+/**
+ * @brief Put a leaf back on its owner's free-space map (after a delete).
+ */
+static int fsm_note_free_owner(Pager* pager, uint32_t owner, uint32_t page_no) {
+  uint8_t* rootbuf = NULL;
+  if (pager_pin_mut(pager, owner, (void**)&rootbuf) != PAGER_OK) return TABLE_E_INVAL;
+  if (leaf_validate(pager, rootbuf) != TABLE_OK || tbl_get_root_page(rootbuf) != owner) {
+    pager_unpin(pager, rootbuf, false);
+    return TABLE_OK; // ownership word is stale: nothing to maintain
+  }
+
+  bool root_dirty = false;
+  int rc = fsm_note_free(pager, rootbuf, page_no, &root_dirty);
+  pager_unpin(pager, rootbuf, root_dirty);
+  return rc;
+}
+
+/**
+ * @brief tblmgr_delete() on a slotted leaf, pinned (mutable) by the caller
+ *        and released here. Overflow pages of the record are freed.
+ */
+static int delete_var(Pager* pager, uint8_t* buf, uint32_t page_no, uint16_t slot_idx) {
+  int rc = spg_validate(buf, pager_page_size(pager));
+  bool overflow = false;
+  const uint8_t* rec = rc == TABLE_OK ? spg_record(buf, slot_idx, NULL, &overflow) : NULL;
+  if (rc == TABLE_OK && !rec) rc = TABLE_E_INVAL;
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
+
+  const uint32_t ovf_first = overflow ? read_le_u32(rec + SPG_OVF_STUB_PAGE_OFF) : 0;
+  const bool had_room = leaf_has_room(pager, buf);
+  spg_delete(buf, pager_page_size(pager), slot_idx);
+  const bool has_room = leaf_has_room(pager, buf);
+  const uint32_t owner = tbl_get_root_page(buf);
+  pager_unpin(pager, buf, true);
+
+  if (ovf_first != 0 && (rc = ovf_free(pager, ovf_first)) != TABLE_OK)
+    return rc;
+
+  if (owner == 0 || owner >= pager_page_count(pager))
+    return TABLE_OK;
+
+  rc = catalog_add_rows(pager, owner, -1);
+  if (rc != TABLE_OK) return rc;
+
+  // Back above the fill threshold: the page returns to the map
+  return had_room || !has_room ? TABLE_OK : fsm_note_free_owner(pager, owner, page_no);
+}
+
+static int delete_record(Pager* pager, uint64_t id) {
   if (!pager)
     return TABLE_E_INVAL;
 
-  const uint32_t page_no  = id >> 16;
-  const uint16_t slot_idx = (uint16_t)(id & 0xFFFF);
+  const uint32_t page_no  = id_page(id);
+  const uint16_t slot_idx = id_slot(id);
 
   // Page 0 is the file header; must be >= 1 and strictly less than page_count
   const uint32_t pcnt = pager_page_count(pager);
   if (page_no == 0 || page_no >= pcnt)
     return TABLE_E_INVAL;
 
-  const size_t pgsz = pager_page_size(pager);
-  uint8_t* buf = (uint8_t*)malloc(pgsz);
-  if (!buf) return TABLE_E_INVAL;
+  // Pin page and validate table leaf layout
+  uint8_t* buf = NULL;
+  int rc = pager_pin_mut(pager, page_no, (void**)&buf);
+  if (rc != PAGER_OK) return TABLE_E_INVAL;
 
-  // Read page and validate table leaf layout
-  int rc = pager_read(pager, page_no, buf);
-  if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_SLOTTED)
+    return delete_var(pager, buf, page_no, slot_idx);
 
-  rc = tbl_validate(buf);
-  if (rc != TABLE_OK) { free(buf); return rc; }
+  rc = leaf_check_fixed(pager, buf);
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
 
   // Basic invariants and slot bounds
   const uint16_t cap = tbl_get_capacity(buf);
-  if (slot_idx >= cap) { free(buf); return TABLE_E_INVAL; }
+  if (slot_idx >= cap) { pager_unpin(pager, buf, false); return TABLE_E_INVAL; }
 
   // Must be currently used to delete it
   if (!tbl_slot_is_used(buf, slot_idx)) {
-    free(buf);
+    pager_unpin(pager, buf, false);
     return TABLE_E_INVAL;
   }
 
-  // Reset the slot
-  void* rec_ptr = tbl_slot_ptr(buf, slot_idx);
-  if (rec_ptr) {
-    memset(rec_ptr, 0, TABLE_RECORD_SIZE);
+  // Drop the record from the table's indexes first: they need its key
+  // (a packed leaf decodes it; its bytes stay until the leaf is repacked)
+  const bool packed = tbl_get_kind(buf) == TABLE_PAGE_KIND_PACKED;
+  const uint32_t index_head = table_index_head(pager, buf, page_no);
+  if (index_head != 0) {
+    uint8_t old[TABLE_RECORD_SIZE];
+    leaf_rec_get(buf, slot_idx, old);
+    rc = indexes_apply(pager, index_head, old, NULL, id);
+    if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
   }
 
-  // Mark slot free
+  // Reset the slot
+  if (!packed)
+    leaf_rec_put(buf, slot_idx, NULL);
+
+  // Mark slot free; the frame is persisted by the pager
+  const bool was_full = tbl_get_used_count(buf) >= cap;
+  const uint32_t owner = tbl_get_root_page(buf);
   tbl_slot_mark_free(buf, slot_idx);
+  pager_unpin(pager, buf, true);
 
-  // Persist updated page
-  rc = pager_write(pager, page_no, buf);
-  free(buf);
-  if (rc != PAGER_OK) return TABLE_E_INVAL;
+  if (owner == 0 || owner >= pcnt)
+    return TABLE_OK;
+
+  rc = catalog_add_rows(pager, owner, -1);
+  if (rc != TABLE_OK) return rc;
+
+  // A full page regained room: put it back on its table's free-space map
+  // (packed leaves never go on it)
+  if (!was_full || packed)
+    return TABLE_OK;
+  return fsm_note_free_owner(pager, owner, page_no);
+}
 
+int tblmgr_delete(Pager* pager, uint64_t id) {
+  int rc = write_begin(pager);
+  if (rc != TABLE_OK) return rc;
+  rc = delete_record(pager, id);
+  pager_write_end(pager);
+  return rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Vacuum
+// ─────────────────────────────────────────────────────────────────────────────
+enum { VAC_NO_ROOM = 1 };
+
+/**
+ * @brief Pin (mutable) and validate a leaf of a table of `kind`.
+ */
+static int vac_pin_leaf(Pager* p, uint32_t page_no, uint16_t kind, uint8_t** out) {
+  if (page_no == 0 || page_no >= pager_page_count(p)) return TABLE_E_LAYOUT;
+  if (pager_pin_mut(p, page_no, (void**)out) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = leaf_validate(p, *out);
+  if (rc == TABLE_OK && !leaf_kind_ok(kind, tbl_get_kind(*out))) rc = TABLE_E_LAYOUT;
+  if (rc != TABLE_OK) { pager_unpin(p, *out, false); *out = NULL; }
+  return rc;
+}
+
+/**
+ * @brief Move the first live record of `src` into `dst` (both pinned
+ *        mutable, src not empty), re-keying the table's indexes.
+ * @return TABLE_OK, VAC_NO_ROOM if dst cannot take it, or TABLE_E_*.
+ */
+static int vac_move(Pager* p, uint32_t index_head, uint8_t* dst, uint32_t dst_no,
+                    uint8_t* src, uint32_t src_no, uint64_t* old_id, uint64_t* new_id) {
+  const size_t ps = pager_page_size(p);
+
+  if (tbl_get_kind(src) == TABLE_PAGE_KIND_SLOTTED) {
+    const uint16_t slots = spg_get_slot_count(src);
+    for (int i = 0; i < slots; i++) {
+      uint16_t stored = 0;
+      bool overflow = false;
+      const uint8_t* rec = spg_record(src, i, &stored, &overflow);
+      if (!rec) continue;
+      if (!spg_fits(dst, ps, stored)) return VAC_NO_ROOM;
+
+      uint16_t slot = 0;
+      int rc = spg_insert(dst, ps, rec, stored, overflow, &slot);
+      if (rc != TABLE_OK) return rc;
+      spg_delete(src, ps, i);
+      *old_id = make_id(src_no, (uint32_t)i);
+      *new_id = make_id(dst_no, slot);
+      return TABLE_OK;
+    }
+    return TABLE_E_LAYOUT;   // used_count said otherwise
+  }
+
+  if (tbl_get_used_count(dst) >= tbl_get_capacity(dst)) return VAC_NO_ROOM;
+  TblSlotIter it;
+  tbl_slot_iter_init(&it, src);
+  const int from = tbl_slot_iter_next(&it);
+  const int to = tbl_slot_find_free(dst);
+  if (from < 0 || to < 0) return TABLE_E_LAYOUT;
+
+  *old_id = make_id(src_no, (uint32_t)from);
+  *new_id = make_id(dst_no, (uint32_t)to);
+  uint8_t rec[TABLE_RECORD_SIZE];
+  leaf_rec_get(src, from, rec);
+
+  // The indexes first: if they cannot follow, the record stays where it is
+  const int rc = indexes_move(p, index_head, rec, *old_id, *new_id);
+  if (rc != TABLE_OK) return rc;
+
+  leaf_rec_put(dst, to, rec);
+  tbl_slot_mark_used(dst, to);
+  leaf_rec_put(src, from, NULL);
+  tbl_slot_mark_free(src, from);
   return TABLE_OK;
 }
 
-int tblmgr_validate_all(Pager* pager, uint32_t first_page_num) {
-  if (!pager || first_page_num == 0)
+/**
+ * @brief TBLMGR_VACUUM_COMPACT: move records from the last leaves into the
+ *        free room of the first ones until the two ends meet. Packed
+ *        leaves are stepped over.
+ */
+static int vac_compact(Pager* p, uint16_t kind, uint32_t index_head, const uint32_t* pages, size_t n,
+                       const TblVacuum* opts, TblVacuumStats* st) {
+  if (n < 2) return TABLE_OK;
+
+  size_t d = 0, s = n - 1;
+  uint8_t* dst = NULL;
+  uint8_t* src = NULL;
+  bool dst_dirty = false, src_dirty = false;
+  int rc = TABLE_OK;
+  while (d < s) {
+    if (!dst && (rc = vac_pin_leaf(p, pages[d], kind, &dst)) != TABLE_OK) break;
+    if (tbl_get_kind(dst) == TABLE_PAGE_KIND_PACKED) {
+      pager_unpin(p, dst, false);
+      dst = NULL;
+      d++;
+      continue;
+    }
+    if (!src && (rc = vac_pin_leaf(p, pages[s], kind, &src)) != TABLE_OK) break;
+
+    if (tbl_get_used_count(src) == 0 || tbl_get_kind(src) == TABLE_PAGE_KIND_PACKED) {
+      pager_unpin(p, src, src_dirty);
+      src = NULL;
+      src_dirty = false;
+      s--;
+      continue;
+    }
+
+    uint64_t old_id = 0, new_id = 0;
+    rc = vac_move(p, index_head, dst, pages[d], src, pages[s], &old_id, &new_id);
+    if (rc == VAC_NO_ROOM) {
+      rc = TABLE_OK;
+      pager_unpin(p, dst, dst_dirty);
+      dst = NULL;
+      dst_dirty = false;
+      d++;
+      continue;
+    }
+    if (rc != TABLE_OK) break;
+    dst_dirty = src_dirty = true;
+    st->records_moved++;
+    if (opts->remap) opts->remap(old_id, new_id, opts->user_data);
+  }
+  if (dst) pager_unpin(p, dst, dst_dirty);
+  if (src) pager_unpin(p, src, src_dirty);
+  return rc;
+}
+
+/**
+ * @brief State of TBLMGR_VACUUM_PACK: the records taken from cold leaves and
+ *        not packed yet, the emptied cold leaves not rewritten yet, and the
+ *        new directory order.
+ */
+typedef struct VacPack {
+  uint8_t*  recs;       // pending records, chain order
+  uint64_t* ids;        // their ids
+  size_t    pending, max;
+  uint32_t* spare;      // emptied cold leaves, chain order
+  size_t    spare_head, n_spare;
+  uint32_t* out;        // leaves of the table, packed ones included
+  size_t    n_out, cap_out;
+} VacPack;
+
+static int vac_pack_push(VacPack* vp, uint32_t page) {
+  if (vp->n_out == vp->cap_out) {
+    const size_t cap = vp->cap_out ? 2 * vp->cap_out : 16;
+    uint32_t* grown = realloc(vp->out, cap * sizeof *grown);
+    if (!grown) return TABLE_E_INVAL;
+    vp->out = grown;
+    vp->cap_out = cap;
+  }
+  vp->out[vp->n_out++] = page;
+  return TABLE_OK;
+}
+
+/**
+ * @brief The next page to pack into: the first emptied cold leaf left, else
+ *        a new page linked after the last leaf of vp->out. Returned pinned
+ *        (mutable), with the chain link it must keep in *next.
+ */
+static int vac_pack_target(Pager* p, VacPack* vp, uint32_t* page_no, uint8_t** buf, uint32_t* next) {
+  if (vp->spare_head < vp->n_spare) {
+    *page_no = vp->spare[vp->spare_head++];
+    int rc = vac_pin_leaf(p, *page_no, TABLE_PAGE_KIND_LEAF, buf);
+    if (rc == TABLE_OK) *next = tbl_get_next_page(*buf);
+    return rc;
+  }
+
+  if (pager_alloc_page(p, page_no) != PAGER_OK) return TABLE_E_INVAL;
+  if (!leaf_page_ok(p, *page_no)) { pager_free_page(p, *page_no); return TABLE_E_FULL; }
+  uint8_t* prev = NULL;
+  int rc = vac_pin_leaf(p, vp->out[vp->n_out - 1], TABLE_PAGE_KIND_LEAF, &prev);
+  if (rc != TABLE_OK) return rc;
+  if (pager_pin_zero(p, *page_no, (void**)buf) != PAGER_OK) { pager_unpin(p, prev, false); return TABLE_E_INVAL; }
+  *next = tbl_get_next_page(prev);
+  tbl_set_next_page(prev, *page_no);
+  pager_unpin(p, prev, true);
+  return vac_pack_push(vp, *page_no);
+}
+
+/**
+ * @brief Write the pending records into packed leaves, as many per leaf as
+ *        fit; stops once fewer than a full leaf's worth is pending unless
+ *        `all`. The indexes follow every record whose id changed.
+ */
+static int vac_pack_flush(Pager* p, uint32_t root_page_no, uint32_t index_head, VacPack* vp,
+                          bool all, const TblVacuum* opts, TblVacuumStats* st) {
+  const size_t ps = pager_page_size(p);
+  while (vp->pending > 0 && (all || vp->pending >= vp->max)) {
+    const size_t fit = pkl_fit(vp->recs, vp->pending, ps);
+    if (fit == 0) return TABLE_E_LAYOUT;
+
+    uint32_t page_no = 0, next = 0;
+    uint8_t* buf = NULL;
+    int rc = vac_pack_target(p, vp, &page_no, &buf, &next);
+    if (rc != TABLE_OK) return rc;
+    rc = pkl_build(buf, ps, vp->recs, fit);
+    tbl_set_root_page(buf, root_page_no);
+    tbl_set_next_page(buf, next);
+    pager_unpin(p, buf, true);
+    if (rc != TABLE_OK) return rc;
+    st->leaves_packed++;
+
+    for (size_t i = 0; i < fit; i++) {
+      const uint8_t* rec = vp->recs + i * TABLE_RECORD_SIZE;
+      const uint64_t old_id = vp->ids[i];
+      const uint64_t new_id = make_id(page_no, (uint32_t)i);
+      if (old_id == new_id) continue;
+      if ((rc = indexes_move(p, index_head, rec, old_id, new_id)) != TABLE_OK) return rc;
+      st->records_moved++;
+      if (opts->remap) opts->remap(old_id, new_id, opts->user_data);
+    }
+
+    vp->pending -= fit;
+    memmove(vp->recs, vp->recs + fit * TABLE_RECORD_SIZE, vp->pending * TABLE_RECORD_SIZE);
+    memmove(vp->ids, vp->ids + fit, vp->pending * sizeof *vp->ids);
+  }
+  return TABLE_OK;
+}
+
+/**
+ * @brief Take the records of a cold leaf (pinned mutable) into vp, leaving
+ *        it empty: it is packed into later, or freed by vac_unlink_empty().
+ */
+static void vac_pack_take(VacPack* vp, uint8_t* buf, uint32_t page_no) {
+  TblSlotIter it;
+  tbl_slot_iter_init(&it, buf);
+  int i;
+  while ((i = tbl_slot_iter_next(&it)) >= 0) {
+    memcpy(vp->recs + vp->pending * TABLE_RECORD_SIZE, tbl_slot_ptr_c(buf, i), TABLE_RECORD_SIZE);
+    vp->ids[vp->pending++] = make_id(page_no, (uint32_t)i);
+    memset(tbl_slot_ptr(buf, i), 0, TABLE_RECORD_SIZE);
+    tbl_slot_mark_free(buf, i);
+  }
+  vp->spare[vp->n_spare++] = page_no;
+}
+
+/**
+ * @brief TBLMGR_VACUUM_PACK: move the records of the cold leaves (neither
+ *        the root nor the tail, not packed, filled to opts->pack_fill) into
+ *        packed leaves, written over the cold leaves themselves in chain
+ *        order (new pages only when the records do not compress). `pages`
+ *        is replaced by the new directory order; the cold leaves left over
+ *        are empty, for vac_unlink_empty().
+ */
+static int vac_pack(Pager* p, uint32_t root_page_no, uint32_t index_head, uint32_t** pages,
+                    size_t* n, const TblVacuum* opts, TblVacuumStats* st) {
+  if (*n < 3) return TABLE_OK;
+
+  const size_t ps = pager_page_size(p);
+  const unsigned fill = opts->pack_fill == 0 || opts->pack_fill > 100 ? 100 : opts->pack_fill;
+  const size_t leaf_cap = (ps - TABLE_HDR_SIZE) / TABLE_RECORD_SIZE;  // bound on one leaf's records
+  VacPack vp = { .max = pkl_max_records(ps) };
+  vp.recs = malloc((vp.max + leaf_cap) * TABLE_RECORD_SIZE);
+  vp.ids = malloc((vp.max + leaf_cap) * sizeof *vp.ids);
+  vp.spare = malloc(*n * sizeof *vp.spare);
+  int rc = vp.recs && vp.ids && vp.spare ? TABLE_OK : TABLE_E_INVAL;
+
+  for (size_t k = 0; k < *n && rc == TABLE_OK; k++) {
+    // What is still pending goes in before the tail
+    if (k == *n - 1) rc = vac_pack_flush(p, root_page_no, index_head, &vp, true, opts, st);
+    if (rc == TABLE_OK) rc = vac_pack_push(&vp, (*pages)[k]);
+    if (rc != TABLE_OK || k == 0 || k == *n - 1) continue;
+
+    uint8_t* buf = NULL;
+    if ((rc = vac_pin_leaf(p, (*pages)[k], TABLE_PAGE_KIND_LEAF, &buf)) != TABLE_OK) break;
+    const uint16_t used = tbl_get_used_count(buf);
+    const bool cold = tbl_get_kind(buf) == TABLE_PAGE_KIND_LEAF && used > 0 &&
+                      (size_t)used * 100u >= (size_t)fill * tbl_get_capacity(buf);
+    if (cold) vac_pack_take(&vp, buf, (*pages)[k]);
+    pager_unpin(p, buf, cold);
+    if (cold) rc = vac_pack_flush(p, root_page_no, index_head, &vp, false, opts, st);
+  }
+
+  free(vp.recs);
+  free(vp.ids);
+  free(vp.spare);
+  if (rc != TABLE_OK) { free(vp.out); return rc; }
+  free(*pages);
+  *pages = vp.out;
+  *n = vp.n_out;
+  return TABLE_OK;
+}
+
+/**
+ * @brief Drop the empty leaves after the root from the chain and free them.
+ *        `pages` is rewritten in place with the leaves kept (*n updated).
+ */
+static int vac_unlink_empty(Pager* p, uint16_t kind, uint32_t* pages, size_t* n, TblVacuumStats* st) {
+  uint32_t* dropped = malloc(*n * sizeof *dropped);
+  if (!dropped) return TABLE_E_INVAL;
+
+  size_t kept = 1, nd = 0;
+  int rc = TABLE_OK;
+  for (size_t k = 1; k < *n && rc == TABLE_OK; k++) {
+    uint8_t* buf = NULL;
+    if ((rc = vac_pin_leaf(p, pages[k], kind, &buf)) != TABLE_OK) break;
+    const bool empty = tbl_get_used_count(buf) == 0;
+    pager_unpin(p, buf, false);
+    if (empty) dropped[nd++] = pages[k];
+    else       pages[kept++] = pages[k];
+  }
+
+  // Relink the survivors in directory order
+  for (size_t k = 0; k < kept && rc == TABLE_OK && nd > 0; k++) {
+    uint8_t* buf = NULL;
+    if ((rc = vac_pin_leaf(p, pages[k], kind, &buf)) != TABLE_OK) break;
+    const uint32_t next = k + 1 < kept ? pages[k + 1] : 0;
+    const bool relink = tbl_get_next_page(buf) != next;
+    if (relink) tbl_set_next_page(buf, next);
+    pager_unpin(p, buf, relink);
+  }
+
+  for (size_t k = 0; k < nd && rc == TABLE_OK; k++) {
+    if (pager_free_page(p, dropped[k]) != PAGER_OK) rc = TABLE_E_INVAL;
+    else st->leaves_freed++;
+  }
+  free(dropped);
+  if (rc == TABLE_OK) *n = kept;
+  return rc;
+}
+
+/**
+ * @brief Free the table's FSM pages; the next insert rebuilds the map.
+ */
+static int vac_drop_fsm(Pager* p, uint8_t* rootbuf) {
+  const uint32_t page_count = pager_page_count(p);
+  uint32_t fsm_no = tbl_get_fsm_page(rootbuf);
+  uint32_t hops = 0;
+  tbl_set_fsm_page(rootbuf, 0);
+  while (fsm_no != 0) {
+    if (fsm_no >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* fsm = NULL;
+    if (pager_pin(p, fsm_no, (const void**)&fsm) != PAGER_OK) return TABLE_E_INVAL;
+    const int rc = fsm_validate(fsm, pager_page_size(p));
+    const uint32_t next = fsm_get_next(fsm);
+    pager_unpin(p, fsm, false);
+    if (rc != TABLE_OK) return rc;
+    if (pager_free_page(p, fsm_no) != PAGER_OK) return TABLE_E_INVAL;
+    fsm_no = next;
+  }
+  return TABLE_OK;
+}
+
+static int vacuum_table(Pager* pager, uint32_t root_page_no, const TblVacuum* opts, TblVacuumStats* out_stats) {
+  static const TblVacuum defaults = { .mode = TBLMGR_VACUUM_STABLE };
+  if (!opts) opts = &defaults;
+  if (!pager || root_page_no == 0 || root_page_no >= pager_page_count(pager) ||
+      (opts->mode != TBLMGR_VACUUM_STABLE && opts->mode != TBLMGR_VACUUM_COMPACT &&
+       opts->mode != TBLMGR_VACUUM_PACK))
     return TABLE_E_INVAL;
 
-  const size_t pgsz = pager_page_size(pager);
-  uint8_t* buf = (uint8_t*)malloc(pgsz);
-  if (!buf) return TABLE_E_INVAL;
+  TblVacuumStats st = { 0 };
+  uint8_t* rootbuf = NULL;
+  if (pager_pin_mut(pager, root_page_no, (void**)&rootbuf) != PAGER_OK) return TABLE_E_INVAL;
+  int rc = leaf_validate(pager, rootbuf);
+  const uint32_t owner = tbl_get_root_page(rootbuf);
+  if (rc == TABLE_OK && owner != root_page_no && owner != 0) rc = TABLE_E_INVAL;
+  if (rc == TABLE_OK && opts->mode == TBLMGR_VACUUM_PACK &&
+      tbl_get_kind(rootbuf) != TABLE_PAGE_KIND_LEAF)
+    rc = TABLE_E_INVAL;
+
+  CatEntry cat;
+  uint32_t* pages = NULL;
+  size_t n = 0;
+  if (rc == TABLE_OK) rc = table_catalog(pager, root_page_no, &cat);
+  if (rc == TABLE_OK) rc = cat_dir_pages(pager, &cat, &pages, &n);
+
+  bool root_dirty = false;
+  if (rc == TABLE_OK) {
+    const uint16_t kind = tbl_get_kind(rootbuf);
+    if (opts->mode == TBLMGR_VACUUM_COMPACT)
+      rc = vac_compact(pager, kind, tbl_get_index_page(rootbuf), pages, n, opts, &st);
+    else if (opts->mode == TBLMGR_VACUUM_PACK)
+      rc = vac_pack(pager, root_page_no, tbl_get_index_page(rootbuf), &pages, &n, opts, &st);
+    if (rc == TABLE_OK)
+      rc = vac_unlink_empty(pager, kind, pages, &n, &st);
+
+    // The free-space map lists leaves that moved or went away: rebuilt
+    // lazily; the directory follows the new chain
+    if (rc == TABLE_OK && (st.leaves_freed > 0 || st.records_moved > 0)) {
+      root_dirty = true;
+      rc = vac_drop_fsm(pager, rootbuf);
+      if (rc == TABLE_OK) rc = cat_dir_rewrite(pager, &cat, pages, n);
+      if (rc == TABLE_OK) rc = cat_store(pager, &cat);
+    }
+  }
+  free(pages);
+  pager_unpin(pager, rootbuf, root_dirty);
+
+  // Whatever ended up free at the end of the file goes back to the filesystem
+  if (rc == TABLE_OK && pager_trim(pager, &st.pages_released) != PAGER_OK)
+    rc = TABLE_E_INVAL;
+  if (out_stats) *out_stats = st;
+  return rc;
+}
 
+int tblmgr_vacuum(Pager* pager, uint32_t root_page_no, const TblVacuum* opts, TblVacuumStats* out_stats) {
+  int rc = write_begin(pager);
+  if (rc != TABLE_OK) return rc;
+  rc = vacuum_table(pager, root_page_no, opts, out_stats);
+  pager_write_end(pager);
+  return rc;
+}
+
+static int validate_all(Pager* pager, uint32_t first_page_num) {
   const uint32_t page_count = pager_page_count(pager);
   uint32_t page = first_page_num;
+  uint16_t kind = 0;
 
   while (true) {
     // Range check before read (avoid reading header or out-of-range)
-    if (page == 0 || page >= page_count) { free(buf); return TABLE_E_LAYOUT; }
-
-    // Read page
-    int prc = pager_read(pager, page, buf);
-    if (prc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
-
-    // Validate table/leaf page invariants
-    int trc = tbl_validate(buf);
-    if (trc != TABLE_OK) { free(buf); return trc; }
+    if (page == 0 || page >= page_count) return TABLE_E_LAYOUT;
+
+    // Pin page
+    const uint8_t* buf = NULL;
+    int prc = pager_pin(pager, page, (const void**)&buf);
+    if (prc != PAGER_OK) return TABLE_E_INVAL;
+
+    // Validate table/leaf page invariants; every leaf has the root's kind
+    // (or is packed, in a fixed-size table)
+    int trc = leaf_validate(pager, buf);
+    if (kind == 0) kind = tbl_get_kind(buf);
+    if (trc == TABLE_OK && kind == TABLE_PAGE_KIND_PACKED) trc = TABLE_E_LAYOUT;
+    if (trc == TABLE_OK && !leaf_kind_ok(kind, tbl_get_kind(buf))) trc = TABLE_E_LAYOUT;
+
+    // Overflow chains of slotted leaves hold exactly the recorded lengths
+    if (trc == TABLE_OK && kind == TABLE_PAGE_KIND_SLOTTED) {
+      const uint16_t slots = spg_get_slot_count(buf);
+      for (int i = 0; i < slots && trc == TABLE_OK; i++) {
+        bool overflow = false;
+        const uint8_t* rec = spg_record(buf, i, NULL, &overflow);
+        if (rec && overflow) trc = ovf_read(pager, rec, NULL);
+      }
+    }
 
     // Get next page and perform basic sanity checks
     const uint32_t next = tbl_get_next_page(buf);
+    pager_unpin(pager, buf, false);
+
+    if (trc != TABLE_OK) return trc;
 
     if (next == 0) {
       // End of chain
@@ -275,77 +2139,235 @@ int tblmgr_validate_all(Pager* pager, uint32_t first_page_num) {
     }
 
     // next must be within file page range
-    if (next >= page_count) { free(buf); return TABLE_E_LAYOUT; }
+    if (next >= page_count) return TABLE_E_LAYOUT;
 
     page = next;
   }
 
-  free(buf);
-  return TABLE_OK;
+  // Free-space map pages of the table (if any) must be well formed too
+  const uint8_t* root = NULL;
+  if (pager_pin(pager, first_page_num, (const void**)&root) != PAGER_OK) return TABLE_E_INVAL;
+  uint32_t fsm_no = tbl_get_fsm_page(root);
+  uint32_t idx_no = tbl_get_index_page(root);
+  pager_unpin(pager, root, false);
+
+  uint32_t hops = 0;
+  while (fsm_no != 0) {
+    if (fsm_no >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* fsm = NULL;
+    if (pager_pin(pager, fsm_no, (const void**)&fsm) != PAGER_OK) return TABLE_E_INVAL;
+    int frc = fsm_validate(fsm, pager_page_size(pager));
+    const uint32_t next = fsm_get_next(fsm);
+    pager_unpin(pager, fsm, false);
+
+    if (frc != TABLE_OK) return frc;
+    fsm_no = next;
+  }
+
+  // And so must its secondary indexes
+  hops = 0;
+  while (idx_no != 0) {
+    if (idx_no >= page_count || ++hops > page_count) return TABLE_E_LAYOUT;
+
+    const uint8_t* hdr = NULL;
+    if (pager_pin(pager, idx_no, (const void**)&hdr) != PAGER_OK) return TABLE_E_INVAL;
+    const uint16_t kind = read_le_u16(hdr);
+    const uint32_t next = read_le_u32(hdr + TABLE_INDEX_NEXT_OFF);
+    pager_unpin(pager, hdr, false);
+
+    int irc;
+    switch (kind) {
+      case TABLE_PAGE_KIND_HASH_META:  irc = hidx_validate(pager, idx_no); break;
+      case TABLE_PAGE_KIND_BTREE_META: irc = bidx_validate(pager, idx_no); break;
+      default:                         irc = TABLE_E_BADKIND; break;
+    }
+    if (irc != TABLE_OK) return irc;
+    idx_no = next;
+  }
+
+  // Its catalog entry (if any) must describe exactly this chain
+  CatEntry cat;
+  int crc = cat_lookup(pager, first_page_num, &cat);
+  if (crc == TABLE_E_NOTFOUND) return TABLE_OK;
+  if (crc != TABLE_OK) return crc;
+
+  uint32_t* chain = NULL;
+  uint32_t* dir = NULL;
+  size_t n_chain = 0, n_dir = 0;
+  uint64_t rows = 0;
+  crc = chain_pages(pager, first_page_num, &chain, &n_chain, &rows);
+  if (crc == TABLE_OK)
+    crc = cat_dir_pages(pager, &cat, &dir, &n_dir);
+  if (crc == TABLE_OK &&
+      (n_dir != n_chain || memcmp(dir, chain, n_chain * sizeof *chain) != 0 ||
+       cat.tail != chain[n_chain - 1] || cat.rows != rows))
+    crc = TABLE_E_LAYOUT;
+  free(chain);
+  free(dir);
+  return crc;
+}
+
+int tblmgr_validate_all(Pager* pager, uint32_t first_page_num) {
+  if (!pager || first_page_num == 0)
+    return TABLE_E_INVAL;
+
+  const PagerAccess prev = pager_set_access(pager, PAGER_ACCESS_SEQUENTIAL);
+  const int rc = validate_all(pager, first_page_num);
+  pager_set_access(pager, prev);
+  return rc;
 }
 
-int tblmgr_get(Pager* pager, uint32_t id, void* out_rec128) {
+int tblmgr_count(Pager* pager, uint32_t root_page_no, uint64_t* out_rows) {
+  if (!pager || root_page_no == 0 || !out_rows)
+    return TABLE_E_INVAL;
+
+  CatEntry cat;
+  int rc = cat_lookup(pager, root_page_no, &cat);
+  if (rc == TABLE_OK) { *out_rows = cat.rows; return TABLE_OK; }
+  if (rc != TABLE_E_NOTFOUND) return rc;
+
+  // Not in the catalog (file written before it existed): count the chain
+  uint32_t* pages = NULL;
+  size_t npages = 0;
+  rc = chain_pages(pager, root_page_no, &pages, &npages, out_rows);
+  free(pages);
+  return rc;
+}
+
+int tblmgr_get(Pager* pager, uint64_t id, void* out_rec128) {
   if (!pager || !out_rec128) return TABLE_E_INVAL;
 
-  const uint32_t page_no  = id >> 16;
-  const uint16_t slot_idx = (uint16_t)(id & 0xFFFF);
+  const uint32_t page_no  = id_page(id);
+  const uint16_t slot_idx = id_slot(id);
 
   const uint32_t page_count = pager_page_count(pager);
   if (page_no == 0 || page_no >= page_count) return TABLE_E_INVAL;
 
-  const size_t page_sz = pager_page_size(pager);
-  uint8_t* buf = (uint8_t*)malloc(page_sz);
-  if (!buf) return TABLE_E_INVAL;
-
-  int rc = pager_read(pager, page_no, buf);
-  if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+  const uint8_t* buf = NULL;
+  int rc = pager_pin(pager, page_no, (const void**)&buf);
+  if (rc != PAGER_OK) return TABLE_E_INVAL;
 
-  rc = tbl_validate(buf);
-  if (rc != TABLE_OK) { free(buf); return rc; }
+  rc = leaf_check_fixed(pager, buf);
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
 
   const uint16_t cap = tbl_get_capacity(buf);
-  if (slot_idx >= cap) { free(buf); return TABLE_E_INVAL; }
-  if (!tbl_slot_is_used(buf, slot_idx)) { free(buf); return TABLE_E_INVAL; }
-
-  const void* src = tbl_slot_ptr(buf, slot_idx);
-  if (!src) { free(buf); return TABLE_E_INVAL; }
+  if (slot_idx >= cap) { pager_unpin(pager, buf, false); return TABLE_E_INVAL; }
+  if (!tbl_slot_is_used(buf, slot_idx)) { pager_unpin(pager, buf, false); return TABLE_E_INVAL; }
 
-  memcpy(out_rec128, src, TABLE_RECORD_SIZE);
-  free(buf);
+  // A packed leaf decodes just this record, a PAX leaf gathers its columns
+  leaf_rec_get(buf, slot_idx, out_rec128);
+  pager_unpin(pager, buf, false);
   return TABLE_OK;
 }
 
-int tblmgr_update(Pager* pager, uint32_t id, const void* rec_128b) {
+/**
+ * @brief tblmgr_update() on a packed leaf, pinned (mutable) and validated
+ *        by the caller and released here: the leaf is decoded, changed and
+ *        packed again. TABLE_E_FULL (indexes restored) when it no longer fits.
+ */
+static int update_packed(Pager* pager, uint8_t* buf, uint32_t page_no, uint16_t slot_idx,
+                         uint64_t id, const void* rec_128b) {
+  Scratch mem = scratch_begin();
+  LeafScratch img = { .mem = &mem };
+  const uint8_t* recs = NULL;
+  void* tmp = NULL;   // the page is packed again in a pager buffer first
+  int rc = leaf_records(buf, &img, &recs);
+  if (rc == TABLE_OK && pager_buf_get(pager, &tmp) != PAGER_OK) rc = TABLE_E_INVAL;
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); scratch_end(&mem); return rc; }
+
+  uint8_t old[TABLE_RECORD_SIZE];
+  memcpy(old, tbl_slot_ptr_c(img.buf, slot_idx), TABLE_RECORD_SIZE);
+  const uint32_t index_head = table_index_head(pager, buf, page_no);
+  if (index_head != 0) rc = indexes_apply(pager, index_head, old, rec_128b, id);
+
+  bool dirty = false;
+  if (rc == TABLE_OK) {
+    memcpy(tbl_slot_ptr(img.buf, slot_idx), rec_128b, TABLE_RECORD_SIZE);
+    rc = pkl_repack(buf, pager_page_size(pager), img.buf, tmp);
+    dirty = rc == TABLE_OK;
+    if (rc != TABLE_OK && index_head != 0 &&
+        indexes_apply(pager, index_head, rec_128b, old, id) != TABLE_OK)
+      rc = TABLE_E_INVAL;
+  }
+  pager_unpin(pager, buf, dirty);
+  pager_buf_put(pager, tmp);
+  scratch_end(&mem);
+  return rc;
+}
+
+static int update_record(Pager* pager, uint64_t id, const void* rec_128b) {
   if (!pager || !rec_128b) return TABLE_E_INVAL;
 
-  const uint32_t page_no  = id >> 16;
-  const uint16_t slot_idx = (uint16_t)(id & 0xFFFF);
+  const uint32_t page_no  = id_page(id);
+  const uint16_t slot_idx = id_slot(id);
 
   const uint32_t page_count = pager_page_count(pager);
   if (page_no == 0 || page_no >= page_count) return TABLE_E_INVAL;
 
-  const size_t page_sz = pager_page_size(pager);
-  uint8_t* buf = (uint8_t*)malloc(page_sz);
-  if (!buf) return TABLE_E_INVAL;
-
-  int rc = pager_read(pager, page_no, buf);
-  if (rc != PAGER_OK) { free(buf); return TABLE_E_INVAL; }
+  uint8_t* buf = NULL;
+  int rc = pager_pin_mut(pager, page_no, (void**)&buf);
+  if (rc != PAGER_OK) return TABLE_E_INVAL;
 
-  rc = tbl_validate(buf);
-  if (rc != TABLE_OK) { free(buf); return rc; }
+  rc = leaf_check_fixed(pager, buf);
+  if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
 
   const uint16_t cap = tbl_get_capacity(buf);
-  if (slot_idx >= cap) { free(buf); return TABLE_E_INVAL; }
-  if (!tbl_slot_is_used(buf, slot_idx)) { free(buf); return TABLE_E_INVAL; }
+  if (slot_idx >= cap) { pager_unpin(pager, buf, false); return TABLE_E_INVAL; }
+  if (!tbl_slot_is_used(buf, slot_idx)) { pager_unpin(pager, buf, false); return TABLE_E_INVAL; }
+
+  if (tbl_get_kind(buf) == TABLE_PAGE_KIND_PACKED)
+    return update_packed(pager, buf, page_no, slot_idx, id, rec_128b);
+
+  const uint32_t index_head = table_index_head(pager, buf, page_no);
+  if (index_head != 0) {
+    uint8_t old[TABLE_RECORD_SIZE];
+    leaf_rec_get(buf, slot_idx, old);
+    rc = indexes_apply(pager, index_head, old, rec_128b, id);
+    if (rc != TABLE_OK) { pager_unpin(pager, buf, false); return rc; }
+  }
 
-  const void* dst = tbl_slot_ptr(buf, slot_idx);
-  if (!dst) { free(buf); return TABLE_E_INVAL; }
+  leaf_rec_put(buf, slot_idx, rec_128b);
+  pager_unpin(pager, buf, true);
 
-  memcpy((void *) dst, rec_128b, TABLE_RECORD_SIZE);
+  return TABLE_OK;
+}
 
-  rc = pager_write(pager, page_no, buf);
-  free(buf);
-  if (rc != PAGER_OK) return TABLE_E_INVAL;
+int tblmgr_update(Pager* pager, uint64_t id, const void* rec_128b) {
+  int rc = write_begin(pager);
+  if (rc != TABLE_OK) return rc;
+  rc = update_record(pager, id, rec_128b);
+  pager_write_end(pager);
+  return rc;
+}
 
-  return TABLE_OK;
+// ─────────────────────────────────────────────────────────────────────────────
+// Transactions
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Map the result of a pager_txn_* call: running out of frames and
+ *        failing on the file keep their own codes, the rest is misuse.
+ */
+static int txn_result(int rc) {
+  switch (rc) {
+    case PAGER_OK:        return TABLE_OK;
+    case PAGER_E_NOFRAME: return TABLE_E_NOFRAME;
+    case PAGER_E_IO:      return TABLE_E_IO;
+    default:              return TABLE_E_INVAL;
+  }
+}
+
+int tblmgr_txn_begin(Pager* pager) {
+  if (!pager) return TABLE_E_INVAL;
+  return txn_result(pager_txn_begin(pager));
+}
+
+int tblmgr_txn_commit(Pager* pager) {
+  if (!pager) return TABLE_E_INVAL;
+  return txn_result(pager_txn_commit(pager));
+}
+
+int tblmgr_txn_abort(Pager* pager) {
+  if (!pager) return TABLE_E_INVAL;
+  return txn_result(pager_txn_abort(pager));
 }
@@ -2,8 +2,11 @@
 #define TABLE_MANAGER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "pager.h"
 #include "table.h"
+#include "predicate.h"
+#include "pax.h"
 
 /**
  * @brief Initialize (or open-idempotent) the first leaf page of a table.
@@ -23,6 +26,9 @@
  *   the operation is idempotent and returns TABLE_OK without rewriting.
  * - Otherwise (non-zero and not a valid empty leaf), the function refuses to
  *   overwrite and returns an error (e.g., TABLE_E_INVAL or TABLE_E_LAYOUT).
+ * - On success the table is registered in the file's catalog (catalog.h)
+ *   if it is not there yet; this allocates its first directory page and,
+ *   for the first table of a file, the catalog page.
  *
  * @param pager           Open Pager instance (read/write).
  * @param first_page_num  Page number to initialize as the first leaf (MUST be >= 1).
@@ -31,33 +37,137 @@
 
 int tblmgr_create(Pager* pager, uint32_t first_page_num);
 
+/**
+ * @brief Same as tblmgr_create(), for a table of variable-length records:
+ *        its leaves are slotted pages (see slotted.h).
+ *
+ * Such a table is written with tblmgr_insert_var() and read with
+ * tblmgr_get_var() / tblmgr_scan_var(); tblmgr_delete(), tblmgr_count() and
+ * tblmgr_validate_all() work on both kinds. The fixed-size calls
+ * (tblmgr_insert, tblmgr_get, tblmgr_update, tblmgr_scan, indexes) reject
+ * it with TABLE_E_BADKIND.
+ */
+int tblmgr_create_var(Pager* pager, uint32_t first_page_num);
+
+/**
+ * @brief Same as tblmgr_create(), for a table whose leaves store their
+ *        records column by column (PAX leaves, see pax.h).
+ *
+ * Every leaf of the table gets the root's column layout. The table holds
+ * 128-byte records and takes every fixed-size call; scans with a predicate
+ * test each field in its own column, and tblmgr_scan_fields() assembles
+ * only the columns a callback reads. Reopening an existing empty PAX root
+ * is idempotent only with the same layout. Vacuum packing
+ * (TBLMGR_VACUUM_PACK) rejects these tables.
+ *
+ * @param layout  Column directory (pax_layout_init / pax_layout_add).
+ */
+int tblmgr_create_pax(Pager* pager, uint32_t first_page_num, const PaxLayout* layout);
+
 /**
  * @brief Insert a new 128-byte record into the table, allocating pages as needed.
  *
- * This function finds the first page with a free slot, or allocates a new
- * leaf page at the end of the file if all existing pages are full.
- * The new record is copied into the first free slot, and the used count
- * and bitmap are updated accordingly.
+ * The target page is taken from the table's free-space map (see fsm.h), so
+ * no chain walk is needed; if no page has room, a new leaf is allocated and
+ * linked after the tail recorded in the catalog (see catalog.h), which also
+ * keeps the table's directory and row count. The map is built, and a table
+ * missing from the catalog registered, on the first insert that needs it. The record is copied into the first free slot, and
+ * the used count and bitmap are updated accordingly.
  *
  * @param p            Pointer to the Pager managing the file.
  * @param root_page_no Page number of the first leaf page of the table.
  * @param rec_128b     Pointer to the 128-byte record to insert.
- * @param out_id       Optional pointer to receive the global record index.
- *                     This is a zero-based index across all pages in the table.
- *                     If NULL, the index is not returned.
- * @return TABLE_OK on success, TABLE_E_* on error.
+ * @param out_id       Optional pointer to receive the record id,
+ *                     TABLE_ID(page, slot) (see table.h).
+ *                     If NULL, the id is not returned.
+ * @return TABLE_OK on success, TABLE_E_FULL if a version 1 file would need
+ *         a leaf past TABLE_ID_V1_MAX_PAGE, TABLE_E_* on error.
 */
-int tblmgr_insert(Pager* p, uint32_t root_page_no, const void* rec_128b, uint32_t* out_id);
+int tblmgr_insert(Pager* p, uint32_t root_page_no, const void* rec_128b, uint64_t* out_id);
+
+/**
+ * @brief Insert n consecutive 128-byte records in one call.
+ *
+ * Same placement rules as tblmgr_insert(), but each target page is pinned
+ * once and filled with as many records as fit, and missing leaves are
+ * allocated as one group (one file extension, one header page_count update
+ * per group). On error, records [0..k) are inserted, each with its index
+ * entries and counted in the catalog, and the rest are not: out_ids[0..k)
+ * receive their ids and out_ids[k..n) are left as they were.
+ *
+ * @param p            Pointer to the Pager managing the file.
+ * @param root_page_no Page number of the first leaf page of the table.
+ * @param recs         n * 128 bytes of records, back to back.
+ * @param n            Number of records (0 is a no-op).
+ * @param out_ids      Optional array of n entries receiving the record ids.
+ * @return TABLE_OK on success, TABLE_E_* on error.
+ */
+int tblmgr_insert_batch(Pager* p, uint32_t root_page_no,
+                        const void* recs, size_t n, uint64_t* out_ids);
+
+/**
+ * @brief Insert one variable-length record into a table made by tblmgr_create_var().
+ *
+ * The target leaf is taken from the free-space map like tblmgr_insert();
+ * a slotted leaf stays on the map while it has spg_min_free() bytes left.
+ * A record that does not fit there goes to the tail leaf, then to a new
+ * one. Records longer than spg_max_inline() are written to a chain of
+ * overflow pages, and the slot keeps a stub pointing at it.
+ *
+ * @param rec     Record bytes.
+ * @param len     1 .. UINT32_MAX bytes.
+ * @param out_id  Optional: receives the record id, TABLE_ID(page, slot).
+ * @return TABLE_OK, TABLE_E_BADKIND if the table is not slotted, or TABLE_E_*.
+ */
+int tblmgr_insert_var(Pager* p, uint32_t root_page_no, const void* rec, size_t len, uint64_t* out_id);
+
+/**
+ * @brief Read a record of either table kind (fixed-size records are 128 bytes).
+ *
+ * @param out      Buffer of cap bytes (may be NULL when cap is 0).
+ * @param out_len  Receives the record length, also when it exceeds cap.
+ * @return TABLE_OK, TABLE_E_FULL if the record is longer than cap (nothing
+ *         is copied: retry with *out_len bytes), or TABLE_E_*.
+ */
+int tblmgr_get_var(Pager* pager, uint64_t id, void* out, size_t cap, size_t* out_len);
+
+/**
+ * @brief Scan a table of either kind, handing each record with its length.
+ *
+ * Same order and concurrency rules as tblmgr_scan(). An overflowed record
+ * is assembled into a scratch buffer that is only valid during the callback.
+ */
+int tblmgr_scan_var(Pager* pager,
+                    uint32_t root_page_no,
+                    int (*callback)(const void* record,
+                                    size_t len,
+                                    uint64_t record_id,
+                                    void* user_data),
+                    void* user_data);
 
 /**
  * @brief Scan all records in the table, invoking a callback for each.
  *
  * The callback is invoked with a pointer to the record data,
- * the global record index, and the user_data pointer.
+ * its record id, and the user_data pointer.
  * If the callback returns a non-zero value, the scan is aborted
  * and that value is returned by tblmgr_scan().
  * If the scan completes successfully, TABLE_OK is returned.
  *
+ * Pages are pinned (shared) one at a time, so scans and tblmgr_get() may run
+ * in several threads while one writer inserts, updates or deletes: each
+ * page is seen either before or after a write, never halfway. Rows added by
+ * the writer during the scan may or may not be visited. With a concurrent
+ * writer the callback must not pin other pages (e.g. call tblmgr_get()),
+ * since it runs with the current page pinned.
+ *
+ * For a consistent view, scan from a thread bound to a snapshot
+ * (pager_snapshot_begin): every page, the table's directory included, is
+ * then seen as it was when the snapshot began, whatever the writer does
+ * meanwhile. Each change below (create, insert, update, delete, vacuum,
+ * index builds) is one pager write section, so a snapshot holds all of it
+ * or none; the changes fail with TABLE_E_INVAL from a snapshot's thread.
+ *
  * @param p            Pointer to the Pager managing the file.
  * @param root_page_no Page number of the first leaf page of the table.
  * @param callback     Function pointer to the callback to invoke for each record.
@@ -67,27 +177,209 @@ int tblmgr_insert(Pager* p, uint32_t root_page_no, const void* rec_128b, uint32_
 int tblmgr_scan(Pager* pager,
                 uint32_t root_page_no,
                 int (*callback)(const void* record,
-                                uint32_t record_id,
+                                uint64_t record_id,
                                 void* user_data),
                 void* user_data);
 
+/**
+ * @brief tblmgr_scan() restricted to the records that satisfy a predicate.
+ *
+ * The predicate (predicate.h) runs on the records in the pinned leaf, one
+ * bitmap word (64 slots) at a time, before any callback: the callback only
+ * sees the matches, in tblmgr_scan() order. A NULL predicate matches every
+ * record.
+ *
+ * @param where  Compiled predicate, or NULL.
+ * @return As tblmgr_scan().
+ */
+int tblmgr_scan_where(Pager* pager,
+                      uint32_t root_page_no,
+                      const TblPred* where,
+                      int (*callback)(const void* record,
+                                      uint64_t record_id,
+                                      void* user_data),
+                      void* user_data);
+
+/**
+ * @brief Record bytes a scan callback reads: bit k of bytes[k / 64] stands
+ *        for byte k. Zero-initialize, then add fields.
+ */
+typedef struct TblFields {
+  uint64_t bytes[2];
+} TblFields;
+
+/**
+ * @brief Add record bytes [off, off+len) (clipped to the record).
+ */
+void tblmgr_fields_add(TblFields* f, uint16_t off, uint16_t len);
+
+/**
+ * @brief tblmgr_scan_where() handing the callback only the bytes in
+ *        `fields` (NULL: the whole record).
+ *
+ * Leaves that store records by rows hand out the whole record anyway. A
+ * PAX leaf copies just the columns holding those bytes into a scratch
+ * record; the other bytes read as 0. The predicate may test any field.
+ *
+ * @return As tblmgr_scan().
+ */
+int tblmgr_scan_fields(Pager* pager,
+                       uint32_t root_page_no,
+                       const TblPred* where,
+                       const TblFields* fields,
+                       int (*callback)(const void* record,
+                                       uint64_t record_id,
+                                       void* user_data),
+                       void* user_data);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Parallel scan
+// ─────────────────────────────────────────────────────────────────────────────
+#define TBLMGR_MAX_SCAN_THREADS 64
+
+/**
+ * @brief Options for tblmgr_scan_parallel(). Zero-initialize, then set what you need.
+ */
+typedef struct TblParallelScan {
+  unsigned threads;   // workers (0 = one per online CPU), capped by the pool size
+  // Called for each record, concurrently from the workers, with that
+  // worker's state. A non-zero return stops every worker.
+  int   (*callback)(const void* record, uint64_t record_id, void* worker_data);
+  // Optional: build worker k's state (default: user_data, shared by all).
+  // Called on the calling thread before any worker starts.
+  void* (*worker_init)(unsigned worker, void* user_data);
+  // Optional reduce hook: called on the calling thread once per worker, in
+  // worker order, after every worker is done (also after a failure, so that
+  // it can release the state).
+  int   (*merge)(void* worker_data, void* user_data);
+  void* user_data;
+  // Optional: only records matching it reach the callback (see tblmgr_scan_where)
+  const TblPred* where;
+  // Optional: the record bytes the callback reads (see tblmgr_scan_fields)
+  const TblFields* fields;
+} TblParallelScan;
+
+/**
+ * @brief Scan all records of a table with a pool of worker threads.
+ *
+ * The leaf pages are listed from the table's directory (see catalog.h),
+ * or by walking the chain once for a table that predates it, then cut
+ * into contiguous slices, one per worker; worker k visits slice k in chain order. Merging
+ * the workers in order therefore yields the records in tblmgr_scan() order.
+ * Worker 0 runs on the calling thread.
+ *
+ * The workers only pin pages read-only (see the thread notes in pager.h).
+ * Pages are captured when the scan starts: rows a concurrent writer appends
+ * on new pages are not visited. Started from a thread bound to a snapshot,
+ * every worker reads through that snapshot. Started from the thread of an
+ * open transaction, the scan runs on that thread alone, the only one that
+ * sees the transaction's changes.
+ *
+ * @param pager        Pager managing the file.
+ * @param root_page_no First leaf page of the table.
+ * @param opts         Callbacks and thread count (opts->callback is required).
+ * @return TABLE_OK, the first non-zero callback or merge value, or TABLE_E_*.
+ */
+int tblmgr_scan_parallel(Pager* pager, uint32_t root_page_no, const TblParallelScan* opts);
+
+/**
+ * @brief Number of records in a table (COUNT(*)).
+ *
+ * Read from the table's catalog entry (see catalog.h) without touching its
+ * leaves; a table that predates the catalog is counted along its chain.
+ *
+ * @param pager        Pager managing the file.
+ * @param root_page_no First leaf page of the table.
+ * @param out_rows     Receives the record count.
+ * @return TABLE_OK or a TABLE_E_* code.
+ */
+int tblmgr_count(Pager* pager, uint32_t root_page_no, uint64_t* out_rows);
+
 /**
  * @brief Delete (free) a record at the given global index.
  *
  * This optional helper computes the page and local slot index,
- * marks the slot as free, and updates the used count.
+ * marks the slot as free, and updates the used count. A page that was full
+ * is pushed back onto its table's free-space map. Works on both table kinds;
+ * the overflow pages of a variable-length record go to the pager's free
+ * list. The leaf itself stays in the chain until tblmgr_vacuum().
  *
  * @param pager  Pointer to the Pager managing the file.
- * @param id     Global record index (across pages).
+ * @param id     Record id, TABLE_ID(page, slot).
  * @return TABLE_OK on success, TABLE_E_* on error.
  */
-int tblmgr_delete(Pager* pager, uint32_t id);
+int tblmgr_delete(Pager* pager, uint64_t id);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Vacuum
+// ─────────────────────────────────────────────────────────────────────────────
+typedef enum TblVacuumMode {
+  TBLMGR_VACUUM_STABLE = 0,   // ids never change: only empty leaves are dropped
+  TBLMGR_VACUUM_COMPACT,      // records move into earlier leaves: ids change
+  TBLMGR_VACUUM_PACK          // records of cold leaves move into packed leaves: ids change
+} TblVacuumMode;
+
+/**
+ * @brief Options for tblmgr_vacuum(). Zero-initialize, then set what you need.
+ */
+typedef struct TblVacuum {
+  TblVacuumMode mode;
+  // COMPACT, PACK: called for every record that moves, once the table's own
+  // indexes point at its new id, so that ids kept elsewhere can follow.
+  void  (*remap)(uint64_t old_id, uint64_t new_id, void* user_data);
+  void* user_data;
+  // PACK: least fill of a leaf worth packing, in percent of its slots
+  // (0 = 100: full leaves only)
+  unsigned pack_fill;
+} TblVacuum;
+
+typedef struct TblVacuumStats {
+  uint32_t records_moved;
+  uint32_t leaves_freed;     // leaves unlinked and put on the free list
+  uint32_t leaves_packed;    // packed leaves written (PACK)
+  uint32_t pages_released;   // pages cut from the end of the file (pager_trim)
+} TblVacuumStats;
+
+/**
+ * @brief Give the room left by deletes back to the file.
+ *
+ * COMPACT first moves records from the last leaves of the chain into the
+ * free slots (or heap space) of the first ones; their ids change, the
+ * table's indexes are re-keyed and opts->remap reports each move.
+ *
+ * PACK (fixed-size tables only, not PAX ones) compresses the cold part of
+ * the table: the records of every leaf but the root and the tail filled to
+ * opts->pack_fill move, in chain order, into as few packed leaves as they
+ * fit (see packed.h), written over the first of those leaves; the rest
+ * end up empty and are freed. Ids change as for COMPACT. Packed leaves are
+ * read like any other; a delete frees the slot but the leaf never takes
+ * inserts again, and an update that no longer fits fails with
+ * TABLE_E_FULL. Leaves already packed are left alone (COMPACT skips them
+ * too). A PACK that fails part way may have emptied leaves it had not
+ * rewritten yet: run it in a transaction (tblmgr_txn_begin) to abort it.
+ *
+ * All modes then unlink the empty leaves after the root and put them on the
+ * pager's free list (see pager_free_page), drop the free-space map (the
+ * next insert rebuilds it), rewrite the table's directory and finally
+ * pager_trim() the file. A table that predates the catalog is registered
+ * first.
+ *
+ * Overflow chains stay where they are (only their stubs move). Vacuum is a
+ * writer operation: no other thread may use the table meanwhile.
+ *
+ * @param opts       NULL = TBLMGR_VACUUM_STABLE.
+ * @param out_stats  Optional: what was done (also filled on failure).
+ * @return TABLE_OK or a TABLE_E_* code.
+ */
+int tblmgr_vacuum(Pager* pager, uint32_t root_page_no, const TblVacuum* opts, TblVacuumStats* out_stats);
 
 /**
  * @brief Validate all pages of the table.
  *
  * This is a debugging utility that walks all linked pages and
- * runs tbl_validate() on each of them.
+ * runs tbl_validate() on each of them, then checks the table's FSM and
+ * index pages and that its catalog entry (if any) matches the chain:
+ * directory order, tail and row count.
  *
  * @param pager Pointer to the Pager managing the file.
  * @param first_page_num First page number of the table.
@@ -101,11 +393,11 @@ int tblmgr_validate_all(Pager* pager, uint32_t first_page_num);
  * This function computes the page and local slot index,
  * reads the page, and copies the record data into out_rec128.
  * @param pager Pointer to the Pager managing the file.
- * @param id    Global record index (across pages).
+ * @param id    Record id, TABLE_ID(page, slot).
  * @param out_rec128 Pointer to a 128-byte buffer to receive the record data.
  * @return TABLE_OK on success, TABLE_E_* on error.
  */
-int tblmgr_get(Pager* pager, uint32_t id, void* out_rec128);
+int tblmgr_get(Pager* pager, uint64_t id, void* out_rec128);
 
 
 /**
@@ -114,10 +406,52 @@ int tblmgr_get(Pager* pager, uint32_t id, void* out_rec128);
  * This function computes the page and local slot index,
  * reads the page, updates the record data, and writes back the page.
  * @param pager Pointer to the Pager managing the file.
- * @param id    Global record index (across pages).
+ * @param id    Record id, TABLE_ID(page, slot).
  * @param rec_128b Pointer to a 128-byte buffer containing the new record data.
- * @return TABLE_OK on success, TABLE_E_* on error.
+ * @return TABLE_OK on success, TABLE_E_* on error (TABLE_E_FULL: the record
+ *         sits in a packed leaf that cannot take the new bytes, see
+ *         TBLMGR_VACUUM_PACK; delete and insert it instead).
+ */
+int tblmgr_update(Pager* pager, uint64_t id, const void* rec_128b);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Transactions
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Group the changes that follow (inserts, updates, deletes, vacuum,
+ *        index builds, on any table) into one transaction of the pager (see
+ *        pager_txn_begin).
+ *
+ * The pager must have its write-ahead log (PagerConfig.wal). Every page
+ * they touch is changed in the buffer pool, once however many rows land on
+ * it (pages evicted meanwhile go to the log uncommitted), and logged once
+ * by tblmgr_txn_commit() as one commit that recovery replays whole or not
+ * at all; tblmgr_txn_abort() leaves the file, catalog and indexes as they
+ * were at tblmgr_txn_begin(). Changes from other threads wait for the
+ * transaction to end, and their reads see none of it until then. A change
+ * that fails inside the transaction may have done part of its work: abort
+ * to undo it.
+ *
+ * @return TABLE_OK, TABLE_E_INVAL (no write-ahead log, already in a
+ *         transaction or a change, bound to a snapshot), or TABLE_E_NOFRAME
+ *         / TABLE_E_IO if the pending changes could not be committed.
+ */
+int tblmgr_txn_begin(Pager* pager);
+
+/**
+ * @brief Log every page the transaction changed as one commit and end it
+ *        (over even when the commit fails).
+ * @return TABLE_OK, TABLE_E_INVAL (no transaction open in this thread), or
+ *         TABLE_E_NOFRAME / TABLE_E_IO (the commit failed).
+ */
+int tblmgr_txn_commit(Pager* pager);
+
+/**
+ * @brief Drop every change of the transaction and end it.
+ * @return TABLE_OK, TABLE_E_INVAL (no transaction open in this thread, or
+ *         one of its pages is still pinned by it), or TABLE_E_IO (the log
+ *         could not be rolled back; the transaction stays open).
  */
-int tblmgr_update(Pager* pager, uint32_t id, const void* rec_128b);
+int tblmgr_txn_abort(Pager* pager);
 
 #endif // TABLE_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,491 @@
+#define _POSIX_C_SOURCE 200809L
+#include "wal.h"
+#include "pager.h"
+#include "crc32c.h"
+#include "endian_util.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Defines (on-disk layout)
+// ─────────────────────────────────────────────────────────────────────────────
+#define WAL_MAGIC          "MDBW"
+#define WAL_MAGIC_LEN      4
+#define WAL_VERSION        1u
+
+#define WAL_HDR_VERSION_OFF   4
+#define WAL_HDR_PAGESIZE_OFF  8
+#define WAL_HDR_SALT_OFF      12
+#define WAL_HDR_CRC_OFF       28
+
+#define WAL_FR_PAGE_OFF       0
+#define WAL_FR_COMMIT_OFF     4
+#define WAL_FR_SALT_OFF       8
+#define WAL_FR_CRC_OFF        12
+
+#define SLOT_EMPTY  UINT32_MAX   // never a valid page number (page_no < page_count)
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Private types
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief Open log + in-memory index page_no -> latest frame.
+ *
+ * The index is an open-addressing table (linear probing, power-of-two size,
+ * load factor <= 1/2). It covers every appended frame, committed or not, so
+ * the pager always reads back its own writes.
+ */
+struct Wal {
+  int       fd;
+  char*     path;
+  size_t    page_size;
+  uint32_t  salt;
+  uint32_t  frame_count;      // frames in the file
+  uint32_t  committed;        // frames up to and including the last commit
+  uint32_t  commit_pages;     // page_count recorded by the last commit
+
+  uint32_t* idx_page;         // SLOT_EMPTY = free slot
+  uint32_t* idx_frame;
+  size_t    idx_mask;
+  size_t    idx_used;
+
+  uint8_t*  buf;              // WAL_FRAME_HDR_SIZE + page_size scratch
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Private helpers
+// ─────────────────────────────────────────────────────────────────────────────
+/**
+ * @brief pread/pwrite loops (EINTR and short transfers).
+ */
+static int wal_read_full(int fd, void* buf, size_t len, off_t off) {
+  size_t done = 0;
+  while (done < len) {
+    ssize_t n = pread(fd, (char*)buf + done, len - done, off + (off_t)done);
+    if (n > 0)
+      done += (size_t)n;
+    else if (n < 0 && (errno == EINTR || errno == EAGAIN))
+      continue;
+    else
+      return PAGER_E_IO;
+  }
+  return PAGER_OK;
+}
+
+static int wal_write_full(int fd, const void* buf, size_t len, off_t off) {
+  size_t done = 0;
+  while (done < len) {
+    ssize_t n = pwrite(fd, (const char*)buf + done, len - done, off + (off_t)done);
+    if (n > 0)
+      done += (size_t)n;
+    else if (n < 0 && (errno == EINTR || errno == EAGAIN))
+      continue;
+    else
+      return PAGER_E_IO;
+  }
+  return PAGER_OK;
+}
+
+static inline off_t frame_offset(const Wal* w, uint32_t frame) {
+  return (off_t)WAL_HDR_SIZE + (off_t)frame * (off_t)(WAL_FRAME_HDR_SIZE + w->page_size);
+}
+
+/**
+ * @brief Checksum of a frame: header bytes 0..11, then the page image.
+ */
+static uint32_t frame_crc(const uint8_t* hdr, const void* page, size_t page_size) {
+  uint32_t c = crc32c(0, hdr, WAL_FR_CRC_OFF);
+  return crc32c(c, page, page_size);
+}
+
+static inline size_t idx_slot(const Wal* w, uint32_t page_no) {
+  return (size_t)((page_no * 2654435761u) & w->idx_mask);
+}
+
+static int idx_alloc(Wal* w, size_t cap) {
+  uint32_t* pages  = malloc(cap * sizeof *pages);
+  uint32_t* frames = malloc(cap * sizeof *frames);
+  if (!pages || !frames) {
+    free(pages);
+    free(frames);
+    return PAGER_E_IO;
+  }
+  for (size_t i = 0; i < cap; i++)
+    pages[i] = SLOT_EMPTY;
+
+  free(w->idx_page);
+  free(w->idx_frame);
+  w->idx_page  = pages;
+  w->idx_frame = frames;
+  w->idx_mask  = cap - 1;
+  w->idx_used  = 0;
+  return PAGER_OK;
+}
+
+static void idx_put_nogrow(Wal* w, uint32_t page_no, uint32_t frame) {
+  size_t i = idx_slot(w, page_no);
+  while (w->idx_page[i] != SLOT_EMPTY && w->idx_page[i] != page_no)
+    i = (i + 1) & w->idx_mask;
+  if (w->idx_page[i] == SLOT_EMPTY) {
+    w->idx_page[i] = page_no;
+    w->idx_used++;
+  }
+  w->idx_frame[i] = frame;
+}
+
+/**
+ * @brief Record `frame` as the latest image of page_no (doubling when half full).
+ */
+static int idx_put(Wal* w, uint32_t page_no, uint32_t frame) {
+  if ((w->idx_used + 1) * 2 > w->idx_mask + 1) {
+    size_t    old_cap    = w->idx_mask + 1;
+    uint32_t* old_pages  = w->idx_page;
+    uint32_t* old_frames = w->idx_frame;
+    w->idx_page = NULL;
+    w->idx_frame = NULL;
+    if (idx_alloc(w, old_cap * 2) != PAGER_OK) {
+      w->idx_page  = old_pages;
+      w->idx_frame = old_frames;
+      return PAGER_E_IO;
+    }
+    for (size_t i = 0; i < old_cap; i++)
+      if (old_pages[i] != SLOT_EMPTY)
+        idx_put_nogrow(w, old_pages[i], old_frames[i]);
+    free(old_pages);
+    free(old_frames);
+  }
+  idx_put_nogrow(w, page_no, frame);
+  return PAGER_OK;
+}
+
+static void idx_clear(Wal* w) {
+  for (size_t i = 0; i <= w->idx_mask; i++)
+    w->idx_page[i] = SLOT_EMPTY;
+  w->idx_used = 0;
+}
+
+/**
+ * @brief Truncate the file and write a fresh header with a new salt.
+ */
+static int wal_reset(Wal* w) {
+  uint8_t hdr[WAL_HDR_SIZE];
+  memset(hdr, 0, sizeof hdr);
+
+  w->salt = w->salt * 1103515245u + 12345u + (uint32_t)time(NULL);
+  memcpy(hdr, WAL_MAGIC, WAL_MAGIC_LEN);
+  write_le_u32(hdr + WAL_HDR_VERSION_OFF, WAL_VERSION);
+  write_le_u32(hdr + WAL_HDR_PAGESIZE_OFF, (uint32_t)w->page_size);
+  write_le_u32(hdr + WAL_HDR_SALT_OFF, w->salt);
+  write_le_u32(hdr + WAL_HDR_CRC_OFF, crc32c(0, hdr, WAL_HDR_CRC_OFF));
+
+  if (ftruncate(w->fd, 0) != 0)
+    return PAGER_E_IO;
+  int rc = wal_write_full(w->fd, hdr, sizeof hdr, 0);
+  if (rc != PAGER_OK)
+    return rc;
+  if (fsync(w->fd) != 0)
+    return PAGER_E_IO;
+
+  w->frame_count  = 0;
+  w->committed    = 0;
+  w->commit_pages = 0;
+  idx_clear(w);
+  return PAGER_OK;
+}
+
+/**
+ * @brief Check the header of an existing log; PAGER_OK if it can be replayed.
+ */
+static int wal_check_header(Wal* w) {
+  uint8_t hdr[WAL_HDR_SIZE];
+  int rc = wal_read_full(w->fd, hdr, sizeof hdr, 0);
+  if (rc != PAGER_OK)
+    return rc;
+
+  if (memcmp(hdr, WAL_MAGIC, WAL_MAGIC_LEN) != 0)
+    return PAGER_E_MAGIC;
+  if (read_le_u32(hdr + WAL_HDR_CRC_OFF) != crc32c(0, hdr, WAL_HDR_CRC_OFF))
+    return PAGER_E_META;
+  if (read_le_u32(hdr + WAL_HDR_VERSION_OFF) != WAL_VERSION)
+    return PAGER_E_VERSION;
+  if (read_le_u32(hdr + WAL_HDR_PAGESIZE_OFF) != (uint32_t)w->page_size)
+    return PAGER_E_PAGESIZE;
+
+  w->salt = read_le_u32(hdr + WAL_HDR_SALT_OFF);
+  return PAGER_OK;
+}
+
+/**
+ * @brief Scan the frames of an existing log and index the committed ones.
+ *
+ * Frames are only promoted when their commit frame is reached, so a
+ * transaction cut short by a crash leaves no trace. The first frame with a
+ * wrong salt or checksum (torn write, leftovers of an older log) ends the
+ * scan; the file is then truncated right after the last commit.
+ */
+static int wal_recover(Wal* w, off_t file_size) {
+  size_t    frame_size = WAL_FRAME_HDR_SIZE + w->page_size;
+  uint32_t* pending    = NULL;
+  size_t    npending   = 0;
+  size_t    cap        = 0;
+  int       rc         = PAGER_OK;
+
+  for (uint32_t frame = 0; ; frame++) {
+    off_t off = frame_offset(w, frame);
+    if (off + (off_t)frame_size > file_size)
+      break;
+    if ((rc = wal_read_full(w->fd, w->buf, frame_size, off)) != PAGER_OK)
+      goto done;
+
+    const uint8_t* hdr = w->buf;
+    if (read_le_u32(hdr + WAL_FR_SALT_OFF) != w->salt ||
+        read_le_u32(hdr + WAL_FR_CRC_OFF) != frame_crc(hdr, hdr + WAL_FRAME_HDR_SIZE, w->page_size))
+      break;
+
+    if (npending == cap) {
+      size_t ncap = cap ? cap * 2 : 64;
+      uint32_t* grown = realloc(pending, ncap * sizeof *grown);
+      if (!grown) {
+        rc = PAGER_E_IO;
+        goto done;
+      }
+      pending = grown;
+      cap = ncap;
+    }
+    pending[npending++] = read_le_u32(hdr + WAL_FR_PAGE_OFF);
+
+    uint32_t commit = read_le_u32(hdr + WAL_FR_COMMIT_OFF);
+    if (commit != 0) {
+      uint32_t first = frame + 1 - (uint32_t)npending;
+      for (size_t i = 0; i < npending; i++)
+        if ((rc = idx_put(w, pending[i], first + (uint32_t)i)) != PAGER_OK)
+          goto done;
+      npending = 0;
+      w->committed    = frame + 1;
+      w->commit_pages = commit;
+    }
+  }
+
+  w->frame_count = w->committed;
+  if (ftruncate(w->fd, frame_offset(w, w->committed)) != 0)
+    rc = PAGER_E_IO;
+
+done:
+  free(pending);
+  return rc;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Public API
+// ─────────────────────────────────────────────────────────────────────────────
+int wal_open(const char* path, size_t page_size, Wal** out) {
+  if (!path || !out || page_size == 0)
+    return PAGER_E_INVAL;
+
+  *out = NULL;
+
+  Wal* w = calloc(1, sizeof *w);
+  if (!w)
+    return PAGER_E_IO;
+  w->fd = -1;
+  w->page_size = page_size;
+  w->salt = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+
+  int rc = PAGER_E_IO;
+  w->path = strdup(path);
+  w->buf = malloc(WAL_FRAME_HDR_SIZE + page_size);
+  if (!w->path || !w->buf || idx_alloc(w, 64) != PAGER_OK)
+    goto fail;
+
+  w->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (w->fd < 0)
+    goto fail;
+
+  struct stat st;
+  if (fstat(w->fd, &st) < 0)
+    goto fail;
+
+  // A missing, foreign or damaged header means there is nothing to replay.
+  if (st.st_size >= WAL_HDR_SIZE && wal_check_header(w) == PAGER_OK)
+    rc = wal_recover(w, st.st_size);
+  else
+    rc = wal_reset(w);
+  if (rc != PAGER_OK)
+    goto fail;
+
+  *out = w;
+  return PAGER_OK;
+
+fail:
+  wal_close(w, false);
+  return rc;
+}
+
+void wal_close(Wal* w, bool remove_file) {
+  if (!w)
+    return;
+  if (w->fd >= 0)
+    close(w->fd);
+  if (remove_file && w->path)
+    unlink(w->path);
+  free(w->path);
+  free(w->idx_page);
+  free(w->idx_frame);
+  free(w->buf);
+  free(w);
+}
+
+int wal_append(Wal* w, uint32_t page_no, const void* page, uint32_t commit_page_count) {
+  if (!w || !page || page_no == SLOT_EMPTY)
+    return PAGER_E_INVAL;
+
+  if (w->frame_count == UINT32_MAX)
+    return PAGER_E_META;
+
+  uint8_t* hdr = w->buf;
+  write_le_u32(hdr + WAL_FR_PAGE_OFF, page_no);
+  write_le_u32(hdr + WAL_FR_COMMIT_OFF, commit_page_count);
+  write_le_u32(hdr + WAL_FR_SALT_OFF, w->salt);
+  memcpy(hdr + WAL_FRAME_HDR_SIZE, page, w->page_size);
+  write_le_u32(hdr + WAL_FR_CRC_OFF, frame_crc(hdr, hdr + WAL_FRAME_HDR_SIZE, w->page_size));
+
+  uint32_t frame = w->frame_count;
+  int rc = wal_write_full(w->fd, hdr, WAL_FRAME_HDR_SIZE + w->page_size, frame_offset(w, frame));
+  if (rc != PAGER_OK)
+    return rc;
+  if ((rc = idx_put(w, page_no, frame)) != PAGER_OK)
+    return rc;
+
+  w->frame_count = frame + 1;
+  if (commit_page_count != 0) {
+    w->committed    = w->frame_count;
+    w->commit_pages = commit_page_count;
+  }
+  return PAGER_OK;
+}
+
+bool wal_find(const Wal* w, uint32_t page_no, uint32_t* out_frame) {
+  if (!w || w->idx_used == 0)
+    return false;
+
+  size_t i = idx_slot(w, page_no);
+  while (w->idx_page[i] != SLOT_EMPTY) {
+    if (w->idx_page[i] == page_no) {
+      if (out_frame)
+        *out_frame = w->idx_frame[i];
+      return true;
+    }
+    i = (i + 1) & w->idx_mask;
+  }
+  return false;
+}
+
+int wal_read_frame(const Wal* w, uint32_t frame, void* out_page) {
+  if (!w || !out_page)
+    return PAGER_E_INVAL;
+  if (frame >= w->frame_count)
+    return PAGER_E_RANGE;
+
+  off_t off = frame_offset(w, frame) + WAL_FRAME_HDR_SIZE;
+  return wal_read_full(w->fd, out_page, w->page_size, off);
+}
+
+int wal_sync(Wal* w) {
+  if (!w)
+    return PAGER_E_INVAL;
+  return fsync(w->fd) == 0 ? PAGER_OK : PAGER_E_IO;
+}
+
+int wal_checkpoint(Wal* w, int db_fd) {
+  if (!w || db_fd < 0)
+    return PAGER_E_INVAL;
+  if (w->committed != w->frame_count)
+    return PAGER_E_INVAL;
+  if (w->frame_count == 0)
+    return PAGER_OK;
+
+  // The log must be durable before the database file is overwritten:
+  // a crash mid-checkpoint is then repaired by replaying it again.
+  int rc = wal_sync(w);
+  if (rc != PAGER_OK)
+    return rc;
+
+  uint8_t* page = w->buf + WAL_FRAME_HDR_SIZE;
+  for (size_t i = 0; i <= w->idx_mask; i++) {
+    uint32_t page_no = w->idx_page[i];
+    if (page_no == SLOT_EMPTY)
+      continue;
+    if ((rc = wal_read_frame(w, w->idx_frame[i], page)) != PAGER_OK)
+      return rc;
+    off_t off = (off_t)page_no * (off_t)w->page_size;
+    if ((rc = wal_write_full(db_fd, page, w->page_size, off)) != PAGER_OK)
+      return rc;
+  }
+
+  // Pages allocated but never logged still have to exist in the file.
+  struct stat st;
+  off_t need = (off_t)w->commit_pages * (off_t)w->page_size;
+  if (fstat(db_fd, &st) < 0)
+    return PAGER_E_IO;
+  if (st.st_size < need && ftruncate(db_fd, need) != 0)
+    return PAGER_E_IO;
+
+  if (fsync(db_fd) != 0)
+    return PAGER_E_IO;
+
+  return wal_reset(w);
+}
+
+int wal_rollback(Wal* w) {
+  if (!w)
+    return PAGER_E_INVAL;
+  if (w->frame_count == w->committed)
+    return PAGER_OK;
+
+  // The index may point past the last commit: rebuild it aside from the
+  // committed frame headers, and only swap it in once complete
+  const size_t old_mask  = w->idx_mask;
+  const size_t old_used  = w->idx_used;
+  uint32_t* old_pages  = w->idx_page;
+  uint32_t* old_frames = w->idx_frame;
+  w->idx_page = NULL;
+  w->idx_frame = NULL;
+  int rc = idx_alloc(w, old_mask + 1);
+  for (uint32_t frame = 0; rc == PAGER_OK && frame < w->committed; frame++) {
+    rc = wal_read_full(w->fd, w->buf, WAL_FRAME_HDR_SIZE, frame_offset(w, frame));
+    if (rc == PAGER_OK)
+      rc = idx_put(w, read_le_u32(w->buf + WAL_FR_PAGE_OFF), frame);
+  }
+  if (rc == PAGER_OK && ftruncate(w->fd, frame_offset(w, w->committed)) != 0)
+    rc = PAGER_E_IO;
+  if (rc != PAGER_OK) {
+    free(w->idx_page);
+    free(w->idx_frame);
+    w->idx_page  = old_pages;
+    w->idx_frame = old_frames;
+    w->idx_mask  = old_mask;
+    w->idx_used  = old_used;
+    return rc;
+  }
+  free(old_pages);
+  free(old_frames);
+  w->frame_count = w->committed;
+  return PAGER_OK;
+}
+
+uint32_t wal_frame_count(const Wal* w) {
+  return w ? w->frame_count : 0;
+}
+
+uint32_t wal_committed_frames(const Wal* w) {
+  return w ? w->committed : 0;
+}
+
+uint32_t wal_commit_page_count(const Wal* w) {
+  return w ? w->commit_pages : 0;
+}
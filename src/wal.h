@@ -0,0 +1,111 @@
+#ifndef WAL_H
+
+#define WAL_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Libraries
+// ─────────────────────────────────────────────────────────────────────────────
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+/* Write-ahead log (page images), file "<db>-wal"
+ *
+ * Header (32 bytes):
+ *   magic[0..3]      = "MDBW"
+ *   version[4..7]    = 1
+ *   page_size[8..11]
+ *   salt[12..15]     changes on every reset; frames must carry the same salt
+ *   reserved[16..27] = 0
+ *   crc[28..31]      CRC-32C of bytes 0..27
+ *
+ * Frame (16-byte header + page_size bytes):
+ *   page_no[0..3]
+ *   commit[4..7]     0 for an ordinary frame; for the last frame of a
+ *                    transaction, the database page_count after it
+ *   salt[8..11]
+ *   crc[12..15]      CRC-32C of bytes 0..11 followed by the page image
+ *
+ * Recovery replays transactions up to the last valid commit frame; a torn
+ * or foreign frame ends the log. All integers are little-endian.
+ * Error codes are PagerError values (see pager.h).
+ */
+// ─────────────────────────────────────────────────────────────────────────────
+#define WAL_HDR_SIZE        32
+#define WAL_FRAME_HDR_SIZE  16
+
+typedef struct Wal Wal;
+
+/**
+ * @brief Open (or create) a WAL file and load its committed frames.
+ *
+ * An existing log with a bad header or foreign page size is discarded.
+ * Frames after the last valid commit frame are ignored.
+ *
+ * @param path      WAL file path.
+ * @param page_size Database page size.
+ * @param out       Receives the Wal handle.
+ * @return PAGER_OK or a negative PagerError code.
+ */
+int      wal_open(const char* path, size_t page_size, Wal** out);
+
+/**
+ * @brief Close the log; remove_file deletes it (only safe after a checkpoint).
+ */
+void     wal_close(Wal* w, bool remove_file);
+
+/**
+ * @brief Append one page image.
+ * @param commit_page_count 0 for an ordinary frame, or the database
+ *                          page_count to mark the end of a transaction.
+ */
+int      wal_append(Wal* w, uint32_t page_no, const void* page, uint32_t commit_page_count);
+
+/**
+ * @brief Look up the most recent frame holding page_no.
+ * @return true and *out_frame on a hit.
+ */
+bool     wal_find(const Wal* w, uint32_t page_no, uint32_t* out_frame);
+
+/**
+ * @brief Copy the page image of frame `frame` into out_page.
+ */
+int      wal_read_frame(const Wal* w, uint32_t frame, void* out_page);
+
+/**
+ * @brief fsync the log: every commit appended so far becomes durable.
+ */
+int      wal_sync(Wal* w);
+
+/**
+ * @brief Copy the latest image of every logged page into the database file,
+ *        fsync it, then reset the log to an empty one with a new salt.
+ *
+ * Every frame must belong to a committed transaction.
+ *
+ * @param w     Wal handle.
+ * @param db_fd Database file descriptor (opened read/write).
+ * @return PAGER_OK, PAGER_E_INVAL if uncommitted frames remain, or PAGER_E_IO.
+ */
+int      wal_checkpoint(Wal* w, int db_fd);
+
+/**
+ * @brief Drop the frames appended since the last commit (an aborted
+ *        transaction), so that every page reads back as last committed.
+ * @return PAGER_OK, or PAGER_E_IO (the log is then left as it was).
+ */
+int      wal_rollback(Wal* w);
+
+/**
+ * @brief Number of frames in the log / frames covered by a commit.
+ */
+uint32_t wal_frame_count(const Wal* w);
+uint32_t wal_committed_frames(const Wal* w);
+
+/**
+ * @brief Database page_count recorded by the last commit (0 = none yet).
+ */
+uint32_t wal_commit_page_count(const Wal* w);
+
+#endif // WAL_H
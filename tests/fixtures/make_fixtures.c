@@ -128,8 +128,8 @@ int main(void) {
         return 1;
     }
 
-    // bad_version.db: version = 2, 3 pages
-    if (create_db("tests/fixtures/bad_version.db", FILE_MAGIC, 2, PAGE_SIZE, 3, 0, true) != 0) {
+    // bad_version.db: version = 3 (newer than the pager), 3 pages
+    if (create_db("tests/fixtures/bad_version.db", FILE_MAGIC, 3, PAGE_SIZE, 3, 0, true) != 0) {
         fprintf(stderr, "Failed to create bad_version.db\n");
         return 1;
     }
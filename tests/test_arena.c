@@ -0,0 +1,246 @@
+// tests/test_arena.c
+// Arena allocator: alignment, growth past a chunk, mark / rewind / reset
+// reusing the chunks, per-thread scratch arenas; the pager's slab of page
+// buffers; and scans, inserts and updates that stop allocating once warm.
+
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "arena.h"
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+
+// ---- allocation -------------------------------------------------------------
+static void test_alloc(void) {
+  Arena a = ARENA_INIT;
+  assert(arena_capacity(&a) == 0 && arena_alloc(NULL, 8) == NULL);
+
+  // Every allocation is aligned and distinct, in one chunk while they fit
+  uint8_t* prev = NULL;
+  for (size_t n = 1; n < 200; n += 7) {
+    uint8_t* q = arena_alloc(&a, n);
+    assert(q && (uintptr_t)q % ARENA_ALIGN == 0);
+    assert(!prev || q >= prev + 1);
+    memset(q, 0xAB, n);
+    prev = q;
+  }
+  assert(arena_capacity(&a) == ARENA_CHUNK);
+
+  uint8_t* z = arena_calloc(&a, 100);
+  assert(z);
+  for (int i = 0; i < 100; i++) assert(z[i] == 0);
+
+  // Larger than a chunk: a chunk of its own size
+  uint8_t* big = arena_alloc(&a, 3 * ARENA_CHUNK);
+  assert(big && (uintptr_t)big % ARENA_ALIGN == 0);
+  memset(big, 1, 3 * ARENA_CHUNK);
+  assert(arena_capacity(&a) == 4 * (size_t)ARENA_CHUNK);
+
+  arena_free(&a);
+  assert(arena_capacity(&a) == 0);
+  assert(arena_alloc(&a, 16) != NULL);
+  arena_free(&a);
+}
+
+// ---- mark / rewind / reset --------------------------------------------------
+static void test_rewind(void) {
+  Arena a = ARENA_INIT;
+  void* keep = arena_alloc(&a, 64);
+  assert(keep);
+
+  // What follows a mark comes back at the same address after a rewind
+  const ArenaMark m = arena_mark(&a);
+  void* first = arena_alloc(&a, 1000);
+  arena_rewind(&a, m);
+  assert(arena_alloc(&a, 1000) == first);
+  arena_rewind(&a, m);
+
+  // Nested marks, across chunks: a warm arena stops growing
+  size_t cap = 0;
+  for (int round = 0; round < 10; round++) {
+    const ArenaMark outer = arena_mark(&a);
+    for (int i = 0; i < 5; i++) assert(arena_alloc(&a, ARENA_CHUNK / 3));
+    const ArenaMark inner = arena_mark(&a);
+    assert(arena_alloc(&a, 2 * ARENA_CHUNK));
+    arena_rewind(&a, inner);
+    assert(arena_alloc(&a, 100));
+    arena_rewind(&a, outer);
+    if (round == 0) cap = arena_capacity(&a);
+    assert(arena_capacity(&a) == cap);
+  }
+  assert(cap > ARENA_CHUNK);
+
+  // Reset starts over from the first chunk, which is kept
+  arena_reset(&a);
+  assert(arena_capacity(&a) == cap);
+  assert(arena_alloc(&a, 64) == keep);
+  arena_free(&a);
+}
+
+// ---- per-thread scratch -----------------------------------------------------
+static void* thread_arena_main(void* arg) {
+  Arena* a = arena_thread();
+  assert(a && a == arena_thread());
+  assert(arena_alloc(a, 4 * ARENA_CHUNK));
+  *(Arena**)arg = a;
+  return NULL;   // freed by the thread's exit
+}
+
+static void test_thread_arena(void) {
+  Arena* mine = arena_thread();
+  assert(mine && mine == arena_thread());
+  Arena* theirs[4] = { 0 };
+  pthread_t t[4];
+  for (int i = 0; i < 4; i++) assert(pthread_create(&t[i], NULL, thread_arena_main, &theirs[i]) == 0);
+  for (int i = 0; i < 4; i++) {
+    pthread_join(t[i], NULL);
+    assert(theirs[i] && theirs[i] != mine);
+  }
+}
+
+// ---- pager page buffers -----------------------------------------------------
+static void test_pager_buffers(void) {
+  const char* tmp = "tests/tmp_arena_bufs.db";
+  remove(tmp);
+  Pager* p = NULL;
+  PagerConfig cfg = { .page_size = 8192 };
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  const size_t ps = pager_page_size(p);
+  assert(pager_buf_get(NULL, NULL) == PAGER_E_INVAL);
+
+  // Aligned on the page size, distinct, grown a slab at a time
+  enum { N = 20 };
+  void* bufs[N];
+  for (int i = 0; i < N; i++) {
+    assert(pager_buf_get(p, &bufs[i]) == PAGER_OK);
+    assert((uintptr_t)bufs[i] % ps == 0);
+    memset(bufs[i], i, ps);
+    for (int j = 0; j < i; j++) assert(bufs[j] != bufs[i]);
+  }
+  const size_t count = pager_buf_count(p);
+  assert(count >= N);
+  for (int i = 0; i < N; i++) assert(((uint8_t*)bufs[i])[ps - 1] == (uint8_t)i);
+
+  // Given back, they are handed out again: the slab stays its size
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < N; i++) pager_buf_put(p, bufs[i]);
+    for (int i = 0; i < N; i++) assert(pager_buf_get(p, &bufs[i]) == PAGER_OK);
+    assert(pager_buf_count(p) == count);
+  }
+  for (int i = 0; i < N; i++) pager_buf_put(p, bufs[i]);
+  pager_buf_put(p, NULL);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- the engine in steady state ---------------------------------------------
+static int count_cb(const void* rec, uint64_t id, void* user) {
+  (void)rec; (void)id;
+  (*(uint64_t*)user)++;
+  return 0;
+}
+
+static int count_var_cb(const void* rec, size_t len, uint64_t id, void* user) {
+  (void)rec; (void)len; (void)id;
+  (*(uint64_t*)user)++;
+  return 0;
+}
+
+typedef struct { uint64_t* ids; size_t n; } IdList;
+
+static int collect_cb(const void* rec, uint64_t id, void* user) {
+  (void)rec;
+  IdList* l = (IdList*)user;
+  l->ids[l->n++] = id;
+  return 0;
+}
+
+static int never_cb(const void* rec, uint64_t id, void* user) {
+  (void)rec; (void)id; (void)user;
+  return 0;
+}
+
+// Compressible rows, so that vacuum PACK has leaves to write
+static void make_row(uint8_t rec[TABLE_RECORD_SIZE], uint32_t i) {
+  memset(rec, 0, TABLE_RECORD_SIZE);
+  memcpy(rec, &i, sizeof i);
+  snprintf((char*)rec + 4, 28, "row%u", i);
+}
+
+static void test_steady_state(void) {
+  const char* tmp = "tests/tmp_arena_engine.db";
+  remove(tmp);
+  Pager* p = NULL;
+  PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+
+  enum { CAP = 31, N = 12 * CAP };
+  uint8_t (*recs)[TABLE_RECORD_SIZE] = malloc((size_t)N * TABLE_RECORD_SIZE);
+  uint64_t* ids = malloc((N + 8) * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) make_row(recs[i], i);
+
+  const uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  assert(tblmgr_insert_batch(p, root, recs, N, NULL) == TABLE_OK);
+  TblVacuum pack = { .mode = TBLMGR_VACUUM_PACK };
+  TblVacuumStats st;
+  assert(tblmgr_vacuum(p, root, &pack, &st) == TABLE_OK && st.leaves_packed > 0);
+
+  // Records past a page go to overflow chains, read back through scratch
+  const uint32_t vroot = pager_page_count(p);
+  assert(tblmgr_create_var(p, vroot) == TABLE_OK);
+  const size_t big = 3 * pager_page_size(p);
+  uint8_t* blob = calloc(1, big);
+  assert(blob);
+  for (int i = 0; i < 8; i++) assert(tblmgr_insert_var(p, vroot, blob, i % 2 ? big : 40, NULL) == TABLE_OK);
+
+  // One warm-up round grows the arena and the slab to their peak; the same
+  // work afterwards fits in what they hold
+  const TblParallelScan par = { .threads = 2, .callback = never_cb };
+  Arena* a = arena_thread();
+  assert(a);
+  size_t cap = 0, bufs = 0;
+  for (int round = 0; round < 5; round++) {
+    uint64_t n = 0, vn = 0;
+    assert(tblmgr_scan(p, root, count_cb, &n) == TABLE_OK && n == N + (uint64_t)round);
+    assert(tblmgr_scan_var(p, vroot, count_var_cb, &vn) == TABLE_OK && vn == 8);
+    assert(tblmgr_scan_parallel(p, root, &par) == TABLE_OK);
+
+    // An update rewrites a packed leaf through a pager buffer (the leaf
+    // after the root); an insert takes a plain one
+    IdList all = { ids, 0 };
+    assert(tblmgr_scan(p, root, collect_cb, &all) == TABLE_OK);
+    uint8_t rec[TABLE_RECORD_SIZE];
+    assert(tblmgr_get(p, ids[CAP], rec) == TABLE_OK);
+    rec[TABLE_RECORD_SIZE - 1] = (uint8_t)round;
+    assert(tblmgr_update(p, ids[CAP], rec) == TABLE_OK);
+    assert(tblmgr_insert(p, root, recs[round], NULL) == TABLE_OK);
+
+    if (round == 0) { cap = arena_capacity(a); bufs = pager_buf_count(p); }
+    assert(arena_capacity(a) == cap);
+    assert(pager_buf_count(p) == bufs);
+  }
+  assert(cap > 0);
+
+  free(blob);
+  free(ids);
+  free(recs);
+  pager_close(p);
+  remove(tmp);
+}
+
+int main(void) {
+  test_alloc();
+  test_rewind();
+  test_thread_arena();
+  test_pager_buffers();
+  test_steady_state();
+  printf("All arena tests passed.\n");
+  return 0;
+}
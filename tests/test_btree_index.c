@@ -0,0 +1,264 @@
+// tests/test_btree_index.c
+// Secondary B+tree index: build on an existing table, ordered range scans in
+// both directions, upkeep by insert / update / delete, node splits and
+// validation.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+#include "hash_index.h"
+#include "btree_index.h"
+
+// ---- helpers ----------------------------------------------------------------
+// Record layout: [0..3] u32 serial, [4..35] name (NUL-padded), [36..37] u16 age
+static void make_row(uint8_t rec[128], uint32_t serial, const char* name, uint16_t age) {
+  memset(rec, 0, 128);
+  rec[0] = (uint8_t)serial;
+  rec[1] = (uint8_t)(serial >> 8);
+  rec[2] = (uint8_t)(serial >> 16);
+  rec[3] = (uint8_t)(serial >> 24);
+  memcpy(rec + 4, name, strlen(name) < 32 ? strlen(name) : 32);
+  rec[36] = (uint8_t)age;
+  rec[37] = (uint8_t)(age >> 8);
+}
+
+static uint16_t row_age(const uint8_t* rec) {
+  return (uint16_t)(rec[36] | (rec[37] << 8));
+}
+
+static IndexKey key_of(const char* name, uint16_t off, uint16_t len, uint8_t type) {
+  IndexKey k;
+  memset(&k, 0, sizeof k);
+  strncpy(k.name, name, sizeof k.name - 1);
+  k.off = off;
+  k.len = len;
+  k.type = type;
+  return k;
+}
+
+typedef struct {
+  size_t   hits;
+  size_t   limit;      /* stop after this many (0 = no limit) */
+  uint32_t last_age;
+  int      order_ok;
+  int      descending;
+} RangeCtx;
+
+static int range_cb(const void* rec, uint64_t id, void* ud) {
+  (void)id;
+  RangeCtx* ctx = (RangeCtx*)ud;
+  const uint32_t age = row_age((const uint8_t*)rec);
+  if (ctx->hits > 0 && (ctx->descending ? age > ctx->last_age : age < ctx->last_age))
+    ctx->order_ok = 0;
+  ctx->last_age = age;
+  ctx->hits++;
+  return (ctx->limit && ctx->hits == ctx->limit) ? 1 : 0;
+}
+
+static size_t range_u16(Pager* p, uint32_t meta, int lo, int hi, int desc, RangeCtx* out) {
+  uint8_t lo_k[2] = { (uint8_t)lo, (uint8_t)(lo >> 8) };
+  uint8_t hi_k[2] = { (uint8_t)hi, (uint8_t)(hi >> 8) };
+  RangeCtx ctx = { .order_ok = 1, .descending = desc };
+  if (out) ctx.limit = out->limit;
+  int rc = bidx_range(p, meta, lo < 0 ? NULL : lo_k, hi < 0 ? NULL : hi_k, desc != 0, range_cb, &ctx);
+  assert(rc == TABLE_OK || (ctx.limit && rc == 1));
+  assert(ctx.order_ok);
+  if (out) *out = ctx;
+  return ctx.hits;
+}
+
+typedef struct {
+  size_t   hits;
+  uint16_t lo, hi;
+} CountCtx;
+
+static int count_cb(const void* rec, uint64_t id, void* ud) {
+  (void)id;
+  CountCtx* c = (CountCtx*)ud;
+  const uint16_t age = row_age((const uint8_t*)rec);
+  if (age >= c->lo && age <= c->hi) c->hits++;
+  return 0;
+}
+
+// Reference answer from a full scan
+static size_t scan_count(Pager* p, uint32_t root, uint16_t lo, uint16_t hi) {
+  CountCtx c = { 0, lo, hi };
+  assert(tblmgr_scan(p, root, count_cb, &c) == TABLE_OK);
+  return c.hits;
+}
+
+static Pager* fresh_table(const char* path, uint32_t* out_root) {
+  remove(path);
+  Pager* p = NULL;
+  assert(pager_open(path, &p) == PAGER_OK && p);
+  *out_root = 1;
+  assert(tblmgr_create(p, 1) == TABLE_OK);
+  return p;
+}
+
+static uint8_t meta_height(Pager* p, uint32_t meta) {
+  const uint8_t* page = NULL;
+  assert(pager_pin(p, meta, (const void**)&page) == PAGER_OK);
+  const uint8_t h = page[BIDX_META_HEIGHT_OFF];
+  assert(pager_unpin(p, page, false) == PAGER_OK);
+  return h;
+}
+
+// ---- tests -----------------------------------------------------------------
+static void test_build_and_range(void) {
+  const char* tmp = "tests/tmp_bidx_build.db";
+  uint32_t root;
+  Pager* p = fresh_table(tmp, &root);
+
+  // Rows exist before the index: bidx_create must pick them up
+  const uint16_t ages[] = { 31, 20, 25, 40, 25, 19, 30 };
+  uint64_t ids[7];
+  uint8_t rec[128];
+  for (uint32_t i = 0; i < 7; i++) {
+    make_row(rec, i, "row", ages[i]);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+
+  IndexKey age_key = key_of("age", 36, 2, INDEX_KEY_U16);
+  uint32_t meta = 0;
+  assert(bidx_create(p, root, &age_key, &meta) == TABLE_OK && meta != 0);
+  assert(bidx_create(p, root, &age_key, NULL) == TABLE_E_INVAL && "duplicate name");
+  assert(hidx_create(p, root, &age_key, NULL) == TABLE_E_INVAL && "name taken by a B+tree");
+
+  IndexKey name_key = key_of("name", 4, 32, INDEX_KEY_STR);
+  assert(hidx_create(p, root, &name_key, NULL) == TABLE_OK);
+  name_key.off = 0;
+  assert(bidx_create(p, root, &name_key, NULL) == TABLE_E_INVAL && "name taken by a hash index");
+
+  uint32_t found = 0;
+  assert(bidx_open(p, root, "age", &found) == TABLE_OK && found == meta);
+  assert(bidx_open(p, root, "name", &found) == TABLE_E_NOTFOUND && "hash index is another kind");
+
+  IndexKey back;
+  assert(bidx_get_key(p, meta, &back) == TABLE_OK);
+  assert(back.off == 36 && back.len == 2 && back.type == INDEX_KEY_U16 && strcmp(back.name, "age") == 0);
+
+  // BETWEEN 20 AND 30, both directions, open bounds, empty ranges
+  assert(range_u16(p, meta, 20, 30, 0, NULL) == 4);
+  assert(range_u16(p, meta, 20, 30, 1, NULL) == 4);
+  assert(range_u16(p, meta, -1, -1, 0, NULL) == 7);
+  assert(range_u16(p, meta, 26, -1, 0, NULL) == 3);
+  assert(range_u16(p, meta, -1, 24, 1, NULL) == 2);
+  assert(range_u16(p, meta, 32, 39, 0, NULL) == 0);
+  assert(range_u16(p, meta, 30, 20, 0, NULL) == 0);
+
+  // Top-2 by age
+  RangeCtx top = { .limit = 2 };
+  assert(range_u16(p, meta, -1, -1, 1, &top) == 2 && top.last_age == 31);
+
+  // Cursor: entries come back with their ids, duplicates in id order
+  uint8_t k25[2] = { 25, 0 };
+  BidxCursor cur;
+  assert(bidx_cursor_open(p, meta, k25, k25, false, &cur) == TABLE_OK);
+  uint64_t id_a = 0, id_b = 0;
+  uint8_t kb[2];
+  assert(bidx_cursor_next(&cur, &id_a, kb) == TABLE_OK && kb[0] == 25);
+  assert(bidx_cursor_next(&cur, &id_b, NULL) == TABLE_OK);
+  assert(id_a == (ids[2] < ids[4] ? ids[2] : ids[4]) && id_b == (ids[2] < ids[4] ? ids[4] : ids[2]));
+  assert(bidx_cursor_next(&cur, NULL, NULL) == TABLE_E_NOTFOUND);
+
+  // Maintenance: insert, update (re-key), delete
+  make_row(rec, 100, "new", 22);
+  uint64_t nid;
+  assert(tblmgr_insert(p, root, rec, &nid) == TABLE_OK);
+  assert(range_u16(p, meta, 20, 30, 0, NULL) == 5);
+
+  make_row(rec, 3, "row", 28);            // 40 -> 28
+  assert(tblmgr_update(p, ids[3], rec) == TABLE_OK);
+  assert(range_u16(p, meta, 20, 30, 0, NULL) == 6);
+  assert(range_u16(p, meta, 40, 40, 0, NULL) == 0);
+
+  assert(tblmgr_delete(p, ids[1]) == TABLE_OK);   // age 20
+  assert(range_u16(p, meta, 20, 20, 0, NULL) == 0);
+  assert(range_u16(p, meta, 20, 30, 0, NULL) == 5);
+
+  assert(bidx_validate(p, meta) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  pager_close(p);
+
+  // Persistence: the index is found again through the table root
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(bidx_open(p, root, "age", &found) == TABLE_OK && found == meta);
+  assert(range_u16(p, meta, 20, 30, 0, NULL) == 5);
+  pager_close(p);
+  remove(tmp);
+}
+
+static void test_splits_and_many_rows(void) {
+  const char* tmp = "tests/tmp_bidx_split.db";
+  uint32_t root;
+  Pager* p = fresh_table(tmp, &root);
+
+  IndexKey age  = key_of("age", 36, 2, INDEX_KEY_U16);
+  IndexKey name = key_of("name", 4, 32, INDEX_KEY_STR);
+  uint32_t m_age = 0, m_name = 0;
+  assert(bidx_create(p, root, &age, &m_age) == TABLE_OK);
+  assert(bidx_create(p, root, &name, &m_name) == TABLE_OK);
+
+  // Scrambled keys so that splits happen all over the tree; 32-byte string
+  // keys give a small fanout and a three-level tree
+  const uint32_t N = 20000;
+  uint8_t* recs = (uint8_t*)malloc((size_t)N * 128);
+  uint64_t* ids = (uint64_t*)malloc(N * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) {
+    const uint32_t v = (i * 7919u) % N;
+    char nm[32];
+    snprintf(nm, sizeof nm, "user-%08u", v);
+    make_row(recs + (size_t)i * 128, i, nm, (uint16_t)(v % 1000));
+  }
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+
+  assert(meta_height(p, m_name) >= 3);
+  assert(bidx_validate(p, m_age) == TABLE_OK);
+  assert(bidx_validate(p, m_name) == TABLE_OK);
+
+  assert(range_u16(p, m_age, 100, 199, 0, NULL) == scan_count(p, root, 100, 199));
+  assert(range_u16(p, m_age, 0, 999, 1, NULL) == N);
+
+  // Names come back in strictly increasing order
+  BidxCursor cur;
+  assert(bidx_cursor_open(p, m_name, NULL, NULL, false, &cur) == TABLE_OK);
+  uint8_t prev[32] = {0}, k[32];
+  size_t n = 0;
+  while (bidx_cursor_next(&cur, NULL, k) == TABLE_OK) {
+    assert(n == 0 || memcmp(prev, k, 32) < 0);
+    memcpy(prev, k, 32);
+    n++;
+  }
+  assert(n == N);
+
+  // Delete most rows: leaves empty out but stay linked and scannable
+  for (uint32_t i = 0; i < N; i++)
+    if (i % 10 != 0) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+
+  assert(bidx_validate(p, m_age) == TABLE_OK);
+  assert(bidx_validate(p, m_name) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  assert(range_u16(p, m_age, 100, 199, 0, NULL) == scan_count(p, root, 100, 199));
+  assert(range_u16(p, m_age, 500, 999, 1, NULL) == scan_count(p, root, 500, 999));
+  assert(range_u16(p, m_age, -1, -1, 0, NULL) == N / 10);
+
+  free(recs);
+  free(ids);
+  pager_close(p);
+  remove(tmp);
+}
+
+int main(void) {
+  test_build_and_range();
+  test_splits_and_many_rows();
+  printf("All btree_index tests passed.\n");
+  return 0;
+}
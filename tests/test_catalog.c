@@ -0,0 +1,239 @@
+// tests/test_catalog.c
+// Table catalog and page directories: registration by tblmgr_create, row
+// and leaf accounting through insert / delete, directory and catalog page
+// chaining, tables that predate the catalog, and validation.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+#include "catalog.h"
+
+// ---- helpers ----------------------------------------------------------------
+static void make_record(uint8_t rec[128], uint32_t tag) {
+  memset(rec, 0, 128);
+  memcpy(rec, &tag, sizeof tag);
+  for (int i = 4; i < 128; i++) rec[i] = (uint8_t)(tag + i);
+}
+
+static Pager* fresh_db(const char* path) {
+  remove(path);
+  Pager* p = NULL;
+  assert(pager_open(path, &p) == PAGER_OK && p);
+  return p;
+}
+
+static void insert_rows(Pager* p, uint32_t root, uint32_t first_tag, size_t n, uint64_t* ids) {
+  uint8_t* recs = malloc(n * 128);
+  assert(recs);
+  for (size_t i = 0; i < n; i++) make_record(recs + i * 128, first_tag + (uint32_t)i);
+  assert(tblmgr_insert_batch(p, root, recs, n, ids) == TABLE_OK);
+  free(recs);
+}
+
+// Leaves of a table, walked along the chain
+static size_t walk_chain(Pager* p, uint32_t root, uint32_t* out, size_t cap) {
+  size_t n = 0;
+  for (uint32_t page = root; page != 0; ) {
+    const uint8_t* buf = NULL;
+    assert(pager_pin(p, page, (const void**)&buf) == PAGER_OK);
+    assert(n < cap);
+    out[n++] = page;
+    page = tbl_get_next_page(buf);
+    assert(pager_unpin(p, buf, false) == PAGER_OK);
+  }
+  return n;
+}
+
+static int count_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec; (void)id;
+  (*(uint64_t*)ud)++;
+  return 0;
+}
+
+static void* par_init(unsigned worker, void* ud) {
+  (void)worker; (void)ud;
+  uint64_t* c = malloc(sizeof *c);
+  assert(c);
+  *c = 0;
+  return c;
+}
+
+static int par_merge(void* wd, void* ud) {
+  *(uint64_t*)ud += *(uint64_t*)wd;
+  free(wd);
+  return 0;
+}
+
+// ---- tests -----------------------------------------------------------------
+static void test_register_and_count(void) {
+  const char* tmp = "tests/tmp_catalog_count.db";
+  Pager* p = fresh_db(tmp);
+
+  uint32_t cat_page = 1;
+  assert(pager_get_catalog(p, &cat_page) == PAGER_OK && cat_page == 0 && "new file: no catalog");
+
+  assert(tblmgr_create(p, 1) == TABLE_OK);
+  assert(pager_get_catalog(p, &cat_page) == PAGER_OK && cat_page != 0);
+  assert(tblmgr_create(p, 1) == TABLE_OK && "idempotent create registers once");
+
+  CatEntry e;
+  assert(cat_lookup(p, 1, &e) == TABLE_OK);
+  assert(e.root == 1 && e.tail == 1 && e.leaves == 1 && e.rows == 0 && e.dir != 0);
+  assert(cat_lookup(p, 2, &e) == TABLE_E_NOTFOUND);
+
+  // Rows and leaves follow inserts and deletes
+  const size_t N = 5000;
+  uint64_t* ids = malloc(N * sizeof *ids);
+  assert(ids);
+  insert_rows(p, 1, 0, N, ids);
+
+  uint64_t rows = 0;
+  assert(tblmgr_count(p, 1, &rows) == TABLE_OK && rows == N);
+
+  uint32_t chain[512];
+  const size_t nchain = walk_chain(p, 1, chain, 512);
+  assert(cat_lookup(p, 1, &e) == TABLE_OK);
+  assert(e.leaves == nchain && e.tail == chain[nchain - 1]);
+
+  for (size_t i = 0; i < N; i += 50) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  assert(tblmgr_count(p, 1, &rows) == TABLE_OK && rows == N - N / 50);
+
+  uint64_t scanned = 0;
+  assert(tblmgr_scan(p, 1, count_cb, &scanned) == TABLE_OK && scanned == rows);
+  assert(tblmgr_validate_all(p, 1) == TABLE_OK);
+  pager_close(p);
+
+  // Persistence
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(tblmgr_count(p, 1, &rows) == TABLE_OK && rows == N - N / 50);
+  assert(tblmgr_validate_all(p, 1) == TABLE_OK);
+  pager_close(p);
+
+  free(ids);
+  remove(tmp);
+}
+
+static void test_directory_chaining(void) {
+  const char* tmp = "tests/tmp_catalog_dir.db";
+  Pager* p = fresh_db(tmp);
+  assert(tblmgr_create(p, 1) == TABLE_OK);
+
+  // More leaves than one directory page holds
+  const size_t N = 40000;
+  insert_rows(p, 1, 0, N, NULL);
+
+  CatEntry e;
+  assert(cat_lookup(p, 1, &e) == TABLE_OK);
+  assert(e.rows == N && e.dir_tail != e.dir && "directory spans several pages");
+
+  uint32_t* dir = NULL;
+  size_t ndir = 0;
+  assert(cat_dir_pages(p, &e, &dir, &ndir) == TABLE_OK && ndir == e.leaves);
+
+  uint32_t* chain = malloc(4096 * sizeof *chain);
+  assert(chain);
+  const size_t nchain = walk_chain(p, 1, chain, 4096);
+  assert(nchain == ndir && memcmp(chain, dir, nchain * sizeof *chain) == 0);
+  free(chain);
+  free(dir);
+
+  // The parallel scan takes its page list from the directory
+  uint64_t total = 0;
+  TblParallelScan opts = { .threads = 4, .callback = count_cb, .worker_init = par_init,
+                           .merge = par_merge, .user_data = &total };
+  assert(tblmgr_scan_parallel(p, 1, &opts) == TABLE_OK && total == N);
+
+  assert(tblmgr_validate_all(p, 1) == TABLE_OK);
+  pager_close(p);
+  remove(tmp);
+}
+
+typedef struct {
+  uint32_t expect_root[200];
+  size_t   seen;
+} ListCtx;
+
+static int list_cb(const CatEntry* e, void* ud) {
+  ListCtx* c = (ListCtx*)ud;
+  assert(c->seen < 200 && e->root == c->expect_root[c->seen]);
+  assert(e->leaves == 1 && e->rows == 1);
+  c->seen++;
+  return 0;
+}
+
+static void test_many_tables(void) {
+  const char* tmp = "tests/tmp_catalog_many.db";
+  Pager* p = fresh_db(tmp);
+
+  // More tables than one catalog page holds: the catalog chains
+  ListCtx ctx = { .seen = 0 };
+  uint8_t rec[128];
+  for (uint32_t t = 0; t < 200; t++) {
+    const uint32_t root = pager_page_count(p);
+    assert(tblmgr_create(p, root) == TABLE_OK);
+    make_record(rec, t);
+    assert(tblmgr_insert(p, root, rec, NULL) == TABLE_OK);
+    ctx.expect_root[t] = root;
+  }
+
+  assert(cat_foreach(p, list_cb, &ctx) == TABLE_OK && ctx.seen == 200);
+
+  CatEntry e;
+  assert(cat_lookup(p, ctx.expect_root[0], &e) == TABLE_OK);
+  const uint32_t first_cat = e.cat_page;
+  assert(cat_lookup(p, ctx.expect_root[199], &e) == TABLE_OK && e.cat_page != first_cat);
+
+  for (uint32_t t = 0; t < 200; t += 37)
+    assert(tblmgr_validate_all(p, ctx.expect_root[t]) == TABLE_OK);
+  pager_close(p);
+  remove(tmp);
+}
+
+static void test_table_without_entry(void) {
+  const char* tmp = "tests/tmp_catalog_legacy.db";
+  Pager* p = fresh_db(tmp);
+  assert(tblmgr_create(p, 1) == TABLE_OK);
+  insert_rows(p, 1, 0, 700, NULL);
+
+  // Forget the catalog, as in a file written before it existed
+  assert(pager_set_catalog(p, 0) == PAGER_OK);
+  CatEntry e;
+  assert(cat_lookup(p, 1, &e) == TABLE_E_NOTFOUND);
+
+  uint64_t rows = 0;
+  assert(tblmgr_count(p, 1, &rows) == TABLE_OK && rows == 700 && "counted along the chain");
+  assert(tblmgr_validate_all(p, 1) == TABLE_OK);
+
+  // The next insert registers the table with its existing rows
+  insert_rows(p, 1, 700, 300, NULL);
+  assert(cat_lookup(p, 1, &e) == TABLE_OK && e.rows == 1000);
+  assert(tblmgr_count(p, 1, &rows) == TABLE_OK && rows == 1000);
+  assert(tblmgr_validate_all(p, 1) == TABLE_OK);
+
+  // A catalog that disagrees with the chain is reported
+  e.rows++;
+  assert(cat_store(p, &e) == TABLE_OK);
+  assert(tblmgr_validate_all(p, 1) == TABLE_E_LAYOUT);
+  e.rows--;
+  e.tail = 1;
+  assert(cat_store(p, &e) == TABLE_OK);
+  assert(tblmgr_validate_all(p, 1) == TABLE_E_LAYOUT);
+
+  pager_close(p);
+  remove(tmp);
+}
+
+int main(void) {
+  test_register_and_count();
+  test_directory_chaining();
+  test_many_tables();
+  test_table_without_entry();
+  printf("All catalog tests passed.\n");
+  return 0;
+}
@@ -0,0 +1,215 @@
+// tests/test_cli_format.c
+// CLI row output: the buffered writer (flushes across its size, large
+// writes, decimal formatting), format names, and the table/csv/tsv/jsonl/raw
+// renderings of a record holding characters each format has to escape.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "cli_format.h"
+
+// ---- helpers ----------------------------------------------------------------
+// Everything written to f since it was opened, NUL-terminated (caller frees)
+static char* slurp(FILE* f, size_t* len) {
+  long n = ftell(f);
+  assert(n >= 0);
+  char* s = malloc((size_t)n + 1);
+  assert(s);
+  rewind(f);
+  assert(fread(s, 1, (size_t)n, f) == (size_t)n);
+  s[n] = 0;
+  if (len) *len = (size_t)n;
+  return s;
+}
+
+// Layout: name s[16] @0, age u8 @16, code u16 @18, tag u32 @20, blob hex[4] @24
+static void make_spec(FieldSpec* fs) {
+  char spec[] = "name:0:16:s,age:16:1:u8,code:18:2:u16,tag:20:4:u32,blob:24:4:hex";
+  assert(parse_spec(spec, fs) == 0);
+  assert(fs->n == 5);
+}
+
+static void make_record(unsigned char rec[128], const char* name) {
+  memset(rec, 0, 128);
+  memcpy(rec, name, strlen(name));
+  rec[16] = 42;
+  rec[18] = 0x39; rec[19] = 0x30;                              // 12345
+  rec[20] = 0xFF; rec[21] = 0xFF; rec[22] = 0xFF; rec[23] = 0xFF;  // 4294967295
+  rec[24] = 0xDE; rec[25] = 0xAD; rec[26] = 0x00; rec[27] = 0x0F;
+}
+
+// One header, row and footer in fmt
+static char* render(OutFormat fmt, uint64_t id, const char* name, size_t* len) {
+  FieldSpec fs;
+  make_spec(&fs);
+  unsigned char rec[128];
+  make_record(rec, name);
+
+  FILE* f = tmpfile();
+  assert(f);
+  OutBuf* ob = malloc(sizeof *ob);
+  assert(ob);
+  outbuf_init(ob, f);
+  format_header(ob, fmt, &fs);
+  format_row(ob, fmt, id, &fs, rec);
+  format_footer(ob, fmt, &fs, 1);
+  outbuf_flush(ob);
+  char* s = slurp(f, len);
+  fclose(f);
+  free(ob);
+  return s;
+}
+
+// ---- tests ------------------------------------------------------------------
+static void test_outbuf(void) {
+  FILE* f = tmpfile();
+  assert(f);
+  OutBuf* ob = malloc(sizeof *ob);
+  assert(ob);
+  outbuf_init(ob, f);
+
+  // Decimal edge values, then enough small writes to flush several times
+  outbuf_u64(ob, 0);
+  outbuf_put(ob, " ", 1);
+  outbuf_u64(ob, UINT64_MAX);
+  outbuf_put(ob, "\n", 1);
+  const size_t lines = 3 * OUTBUF_SIZE / 8;
+  for (size_t i = 0; i < lines; i++) {
+    outbuf_u64(ob, 1000000u + i);
+    outbuf_put(ob, "\n", 1);
+  }
+  // A write larger than the buffer goes through in one piece
+  char* big = malloc(OUTBUF_SIZE + 7);
+  assert(big);
+  memset(big, 'x', OUTBUF_SIZE + 7);
+  outbuf_put(ob, big, OUTBUF_SIZE + 7);
+  outbuf_flush(ob);
+  assert(ob->len == 0);
+
+  size_t len = 0;
+  char* s = slurp(f, &len);
+  assert(strncmp(s, "0 18446744073709551615\n", 23) == 0);
+  char* p = s + 23;
+  for (size_t i = 0; i < lines; i++) {
+    char want[16];
+    snprintf(want, sizeof want, "%zu\n", 1000000u + i);
+    assert(strncmp(p, want, 8) == 0);
+    p += 8;
+  }
+  assert((size_t)(p - s) + OUTBUF_SIZE + 7 == len);
+  for (size_t i = 0; i < OUTBUF_SIZE + 7; i++) assert(p[i] == 'x');
+
+  free(s);
+  free(big);
+  free(ob);
+  fclose(f);
+}
+
+static void test_parse_format(void) {
+  OutFormat fmt = OUT_TABLE;
+  assert(parse_format("csv", &fmt) == 0 && fmt == OUT_CSV);
+  assert(parse_format("tsv", &fmt) == 0 && fmt == OUT_TSV);
+  assert(parse_format("jsonl", &fmt) == 0 && fmt == OUT_JSONL);
+  assert(parse_format("raw", &fmt) == 0 && fmt == OUT_RAW);
+  assert(parse_format("table", &fmt) == 0 && fmt == OUT_TABLE);
+  assert(parse_format("json", &fmt) == -1 && fmt == OUT_TABLE);
+  assert(parse_format("", &fmt) == -1);
+  assert(parse_format(NULL, &fmt) == -1);
+}
+
+static void test_parse_spec_bounds(void) {
+  FieldSpec fs;
+  char whole[] = "all:0:128:hex";
+  assert(parse_spec(whole, &fs) == 0 && fs.n == 1 && fs.f[0].len == 128);
+  char last[] = "a:0:4:u32,z:127:1:u8";
+  assert(parse_spec(last, &fs) == 0 && fs.n == 2);
+
+  // Fields past the end of the record are rejected
+  char* bad[] = { "name:0:400:s", "a:0:129:hex", "z:128:1:u8", "a:0:4:u32,b:100:40:s", "x:65535:65535:s" };
+  for (size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+    char buf[64];
+    snprintf(buf, sizeof buf, "%s", bad[i]);
+    assert(parse_spec(buf, &fs) == -1);
+  }
+
+  // Values are encoded only into a destination that holds the field
+  char spec[] = "name:0:128:s";
+  assert(parse_spec(spec, &fs) == 0);
+  unsigned char out[TABLE_RECORD_SIZE];
+  assert(encode_field_value(&fs.f[0], "abc", out, sizeof out) == 0);
+  assert(memcmp(out, "abc", 4) == 0 && out[127] == 0);
+  assert(encode_field_value(&fs.f[0], "abc", out, 64) == -1);
+  const Field wide = { .name = "w", .off = 0, .len = 400, .type = FT_STR };
+  assert(encode_field_value(&wide, "abc", out, sizeof out) == -1);
+
+  TblPred pred;
+  pred_init(&pred);
+  char where[] = "name=abc";
+  assert(parse_where(where, &fs, &pred) == 0 && pred.n == 1);
+}
+
+static void test_table(void) {
+  char* s = render(OUT_TABLE, 65536, "Alice  ", NULL);
+  const char* want =
+    "+--------+------------------+-----+-------+------------+----------+\n"
+    "| ID     | name             | age | code  | tag        | blob     |\n"
+    "+--------+------------------+-----+-------+------------+----------+\n"
+    "|  65536 | Alice            | 42  | 12345 | 4294967295 | dead000f |\n"
+    "+--------+------------------+-----+-------+------------+----------+\n"
+    "1 row(s)\n";
+  assert(strcmp(s, want) == 0);
+  free(s);
+
+  // Ids wider than the column push the row out, as printf("%6") did
+  s = render(OUT_TABLE, 12345678, "Bob", NULL);
+  assert(strstr(s, "\n| 12345678 | Bob              | 42  |"));
+  free(s);
+}
+
+static void test_text_formats(void) {
+  char* s = render(OUT_CSV, 7, "a,\"b\"", NULL);
+  assert(strcmp(s, "id,name,age,code,tag,blob\n"
+                   "7,\"a,\"\"b\"\"\",42,12345,4294967295,dead000f\n") == 0);
+  free(s);
+  s = render(OUT_CSV, 7, "plain", NULL);
+  assert(strcmp(s, "id,name,age,code,tag,blob\n7,plain,42,12345,4294967295,dead000f\n") == 0);
+  free(s);
+
+  s = render(OUT_TSV, 7, "a\tb\\c\nd", NULL);
+  assert(strcmp(s, "id\tname\tage\tcode\ttag\tblob\n"
+                   "7\ta\\tb\\\\c\\nd\t42\t12345\t4294967295\tdead000f\n") == 0);
+  free(s);
+
+  s = render(OUT_JSONL, 65537, "q\"\\\x01", NULL);
+  assert(strcmp(s, "{\"id\":65537,\"name\":\"q\\\"\\\\\\u0001\",\"age\":42,"
+                   "\"code\":12345,\"tag\":4294967295,\"blob\":\"dead000f\"}\n") == 0);
+  free(s);
+
+  // A 16-byte string with no NUL is printed whole (the table would not cut it either)
+  s = render(OUT_CSV, 1, "0123456789abcdef", NULL);
+  assert(strstr(s, "\n1,0123456789abcdef,42,"));
+  free(s);
+}
+
+static void test_raw(void) {
+  size_t len = 0;
+  char* s = render(OUT_RAW, 9, "Carol", &len);
+  unsigned char rec[128];
+  make_record(rec, "Carol");
+  assert(len == 128);
+  assert(memcmp(s, rec, 128) == 0);
+  free(s);
+}
+
+int main(void) {
+  test_outbuf();
+  test_parse_format();
+  test_parse_spec_bounds();
+  test_table();
+  test_text_formats();
+  test_raw();
+  printf("All cli_format tests passed.\n");
+  return 0;
+}
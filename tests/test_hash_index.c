@@ -0,0 +1,196 @@
+// tests/test_hash_index.c
+// Secondary hash index: build on an existing table, point lookups, upkeep by
+// insert / update / delete, bucket splits and validation.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+#include "hash_index.h"
+
+// ---- helpers ----------------------------------------------------------------
+// Record layout: [0..3] u32 serial, [4..35] name (NUL-padded), [36] u8 bucket
+static void make_row(uint8_t rec[128], uint32_t serial, const char* name) {
+  memset(rec, 0, 128);
+  rec[0] = (uint8_t)serial;
+  rec[1] = (uint8_t)(serial >> 8);
+  rec[2] = (uint8_t)(serial >> 16);
+  rec[3] = (uint8_t)(serial >> 24);
+  strncpy((char*)rec + 4, name, 32);
+  rec[36] = (uint8_t)(serial % 7);
+}
+
+static IndexKey key_of(const char* name, uint16_t off, uint16_t len, uint8_t type) {
+  IndexKey k;
+  memset(&k, 0, sizeof k);
+  strncpy(k.name, name, sizeof k.name - 1);
+  k.off = off;
+  k.len = len;
+  k.type = type;
+  return k;
+}
+
+typedef struct {
+  size_t   hits;
+  uint64_t last_id;
+} FindCtx;
+
+static int find_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec;
+  FindCtx* ctx = (FindCtx*)ud;
+  ctx->hits++;
+  ctx->last_id = id;
+  return 0;
+}
+
+static size_t find_u32(Pager* p, uint32_t meta, uint32_t v, uint64_t* out_id) {
+  uint8_t k[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+  FindCtx ctx = {0};
+  assert(hidx_find(p, meta, k, find_cb, &ctx) == TABLE_OK);
+  if (out_id) *out_id = ctx.last_id;
+  return ctx.hits;
+}
+
+static size_t find_name(Pager* p, uint32_t meta, const char* name) {
+  uint8_t k[32] = {0};
+  memcpy(k, name, strlen(name));
+  FindCtx ctx = {0};
+  assert(hidx_find(p, meta, k, find_cb, &ctx) == TABLE_OK);
+  return ctx.hits;
+}
+
+static Pager* fresh_table(const char* path, uint32_t* out_root) {
+  remove(path);
+  Pager* p = NULL;
+  assert(pager_open(path, &p) == PAGER_OK && p);
+  *out_root = 1;
+  assert(tblmgr_create(p, 1) == TABLE_OK);
+  return p;
+}
+
+// ---- tests -----------------------------------------------------------------
+static void test_build_and_find(void) {
+  const char* tmp = "tests/tmp_hidx_build.db";
+  uint32_t root;
+  Pager* p = fresh_table(tmp, &root);
+
+  // Rows exist before the index: hidx_create must pick them up
+  const char* names[] = { "Alice", "Bob", "Carol", "Bob" };
+  uint64_t ids[4];
+  uint8_t rec[128];
+  for (uint32_t i = 0; i < 4; i++) {
+    make_row(rec, 100 + i, names[i]);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+
+  IndexKey name_key = key_of("name", 4, 32, INDEX_KEY_STR);
+  uint32_t meta = 0;
+  assert(hidx_create(p, root, &name_key, &meta) == TABLE_OK && meta != 0);
+  assert(hidx_create(p, root, &name_key, NULL) == TABLE_E_INVAL && "duplicate name");
+
+  IndexKey bad = key_of("bad", 120, 16, INDEX_KEY_STR);
+  assert(hidx_create(p, root, &bad, NULL) == TABLE_E_INVAL && "key past the record");
+  bad = key_of("bad", 0, 3, INDEX_KEY_U32);
+  assert(hidx_create(p, root, &bad, NULL) == TABLE_E_INVAL && "u32 key must be 4 bytes");
+
+  uint32_t found = 0;
+  assert(hidx_open(p, root, "name", &found) == TABLE_OK && found == meta);
+  assert(hidx_open(p, root, "city", &found) == TABLE_E_NOTFOUND);
+
+  IndexKey back;
+  assert(hidx_get_key(p, meta, &back) == TABLE_OK);
+  assert(back.off == 4 && back.len == 32 && back.type == INDEX_KEY_STR && strcmp(back.name, "name") == 0);
+
+  assert(find_name(p, meta, "Alice") == 1);
+  assert(find_name(p, meta, "Bob") == 2);
+  assert(find_name(p, meta, "Dave") == 0);
+
+  // Maintenance: insert, update (re-key), delete
+  make_row(rec, 200, "Dave");
+  uint64_t dave;
+  assert(tblmgr_insert(p, root, rec, &dave) == TABLE_OK);
+  assert(find_name(p, meta, "Dave") == 1);
+
+  make_row(rec, 101, "Robert");
+  assert(tblmgr_update(p, ids[1], rec) == TABLE_OK);
+  assert(find_name(p, meta, "Bob") == 1);
+  assert(find_name(p, meta, "Robert") == 1);
+
+  make_row(rec, 999, "Robert");   // same key, other bytes: entry untouched
+  assert(tblmgr_update(p, ids[1], rec) == TABLE_OK);
+  assert(find_name(p, meta, "Robert") == 1);
+
+  assert(tblmgr_delete(p, ids[0]) == TABLE_OK);
+  assert(find_name(p, meta, "Alice") == 0);
+
+  assert(hidx_validate(p, meta) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  pager_close(p);
+
+  // Persistence: the index is found again through the table root
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(hidx_open(p, root, "name", &found) == TABLE_OK && found == meta);
+  assert(find_name(p, meta, "Dave") == 1);
+  pager_close(p);
+  remove(tmp);
+}
+
+static void test_splits_and_many_rows(void) {
+  const char* tmp = "tests/tmp_hidx_split.db";
+  uint32_t root;
+  Pager* p = fresh_table(tmp, &root);
+
+  IndexKey serial = key_of("serial", 0, 4, INDEX_KEY_U32);
+  IndexKey bucket = key_of("bucket", 36, 1, INDEX_KEY_U8);
+  uint32_t m_serial = 0, m_bucket = 0;
+  assert(hidx_create(p, root, &serial, &m_serial) == TABLE_OK);
+  assert(hidx_create(p, root, &bucket, &m_bucket) == TABLE_OK);
+
+  // Enough rows for several bucket splits and overflow chains (7 distinct
+  // values for the u8 key: long duplicate chains)
+  const uint32_t N = 6000;
+  uint8_t* recs = (uint8_t*)malloc((size_t)N * 128);
+  uint64_t* ids = (uint64_t*)malloc(N * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) make_row(recs + (size_t)i * 128, i, "row");
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+
+  for (uint32_t i = 0; i < N; i += 37) {
+    uint64_t id = 0;
+    assert(find_u32(p, m_serial, i, &id) == 1);
+    assert(id == ids[i]);
+  }
+  assert(find_u32(p, m_serial, N + 5, NULL) == 0);
+
+  uint8_t b3 = 3;
+  FindCtx ctx = {0};
+  assert(hidx_find(p, m_bucket, &b3, find_cb, &ctx) == TABLE_OK);
+  assert(ctx.hits == (N - 3 + 6) / 7);
+
+  // Delete every other row and check both indexes followed
+  for (uint32_t i = 0; i < N; i += 2)
+    assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  assert(find_u32(p, m_serial, 10, NULL) == 0);
+  assert(find_u32(p, m_serial, 11, NULL) == 1);
+
+  assert(hidx_validate(p, m_serial) == TABLE_OK);
+  assert(hidx_validate(p, m_bucket) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+
+  free(recs);
+  free(ids);
+  pager_close(p);
+  remove(tmp);
+}
+
+int main(void) {
+  test_build_and_find();
+  test_splits_and_many_rows();
+  printf("All hash_index tests passed.\n");
+  return 0;
+}
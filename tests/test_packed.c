@@ -0,0 +1,232 @@
+// tests/test_packed.c
+// Packed leaves: round trips of compressible, incompressible and run-heavy
+// records, how many fit, single-record decoding, repacking after deletes
+// and updates (and refusing what no longer fits), and validation of
+// damaged pages.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "table.h"
+#include "packed.h"
+#include "endian_util.h"
+
+enum { PS = 4096 };
+
+// ---- helpers ----------------------------------------------------------------
+// What archival rows look like: u32 tag, short NUL-padded strings, a small age
+static void make_row(uint8_t rec[128], uint32_t tag) {
+  static const char* cities[] = { "Paris", "Lyon", "Tokyo", "Oslo" };
+  memset(rec, 0, 128);
+  write_le_u32(rec, tag);
+  snprintf((char*)rec + 4, 28, "user%u", tag);
+  rec[32] = (uint8_t)(20 + tag % 50);
+  memcpy(rec + 33, cities[tag % 4], strlen(cities[tag % 4]));
+}
+
+// Bytes that do not compress
+static void make_noise(uint8_t rec[128], uint32_t tag) {
+  uint32_t x = tag * 2654435761u + 1u;
+  for (int i = 0; i < 128; i++) {
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    rec[i] = (uint8_t)x;
+  }
+}
+
+// Column j repeats each value j + 1 times: runs of every length
+static void make_runs(uint8_t rec[128], uint32_t tag) {
+  for (uint32_t j = 0; j < 128; j++) rec[j] = (uint8_t)(tag / (j + 1));
+}
+
+static uint8_t* make_recs(size_t n, void (*make)(uint8_t*, uint32_t)) {
+  uint8_t* recs = malloc(n * 128);
+  assert(recs);
+  for (size_t i = 0; i < n; i++) make(recs + i * 128, (uint32_t)i);
+  return recs;
+}
+
+// Build, validate, then read every record back both ways
+static void round_trip(const uint8_t* recs, size_t n, size_t ps) {
+  uint8_t* page = malloc(ps);
+  assert(page);
+  assert(pkl_build(page, ps, recs, n) == TABLE_OK);
+  assert(pkl_validate(page, ps) == TABLE_OK);
+  assert(tbl_get_kind(page) == TABLE_PAGE_KIND_PACKED);
+  assert(tbl_get_capacity(page) == n && tbl_get_used_count(page) == n);
+  assert(tbl_get_next_page(page) == 0 && tbl_get_root_page(page) == 0);
+
+  uint8_t* img = NULL;
+  size_t img_cap = 0;
+  assert(pkl_decode_buf(page, &img, &img_cap) == TABLE_OK);
+  assert(img_cap == pkl_image_size((uint16_t)n));
+  TblSlotIter it;
+  tbl_slot_iter_init(&it, img);
+  size_t seen = 0;
+  int i;
+  while ((i = tbl_slot_iter_next(&it)) >= 0) {
+    assert((size_t)i == seen++);
+    assert(memcmp(tbl_slot_ptr_c(img, i), recs + (size_t)i * 128, 128) == 0);
+  }
+  assert(seen == n);
+
+  uint8_t rec[128];
+  for (size_t k = 0; k < n; k++) {
+    assert(pkl_record(page, (int)k, rec) == TABLE_OK);
+    assert(memcmp(rec, recs + k * 128, 128) == 0);
+  }
+  assert(pkl_record(page, (int)n, rec) == TABLE_E_INVAL);
+  free(img);
+  free(page);
+}
+
+// ---- tests ------------------------------------------------------------------
+static void test_compressible(void) {
+  const size_t max = pkl_max_records(PS);
+  assert(max == 512);
+  uint8_t* recs = make_recs(max, make_row);
+
+  // Several TABLE_LEAFs' worth of rows share one page
+  const size_t fit = pkl_fit(recs, max, PS);
+  assert(fit > 8 * 31 && fit < max);
+  round_trip(recs, fit, PS);
+
+  uint8_t page[PS];
+  assert(pkl_build(page, PS, recs, fit + 1) == TABLE_E_FULL);
+  assert(pkl_fit(recs, 10, PS) == 10);
+  round_trip(recs, 1, PS);
+  free(recs);
+
+  // Zero records compress to almost nothing: capped by pkl_max_records
+  uint8_t* zeros = calloc(max + 5, 128);
+  assert(zeros);
+  assert(pkl_fit(zeros, max + 5, PS) == max);
+  round_trip(zeros, max, PS);
+  assert(pkl_build(page, PS, zeros, max + 1) == TABLE_E_INVAL);
+  assert(pkl_build(page, PS, zeros, 0) == TABLE_E_INVAL);
+  free(zeros);
+}
+
+static void test_incompressible(void) {
+  uint8_t* recs = make_recs(64, make_noise);
+  const size_t fit = pkl_fit(recs, 64, PS);
+  assert(fit >= 1 && fit < 31);
+  round_trip(recs, fit, PS);
+  uint8_t page[PS];
+  assert(pkl_build(page, PS, recs, fit + 1) == TABLE_E_FULL);
+  free(recs);
+}
+
+static void test_runs(void) {
+  // Runs of 1..128 in one column each, across the literal / run limits
+  const size_t ps = 16384;
+  const size_t n = 512;
+  uint8_t* recs = make_recs(n, make_runs);
+  const size_t fit = pkl_fit(recs, n, ps);
+  assert(fit == n);
+  round_trip(recs, n, ps);
+  free(recs);
+}
+
+static void test_repack(void) {
+  uint8_t* recs = make_recs(120, make_row);
+  uint8_t page[PS];
+  assert(pkl_build(page, PS, recs, 120) == TABLE_OK);
+  tbl_set_next_page(page, 77);
+  tbl_set_root_page(page, 5);
+
+  // A delete only clears the bit: the bytes are still there
+  assert(tbl_slot_mark_free(page, 7) == TABLE_OK);
+  assert(pkl_validate(page, PS) == TABLE_OK);
+  uint8_t rec[128];
+  assert(pkl_record(page, 7, rec) == TABLE_OK && memcmp(rec, recs + 7 * 128, 128) == 0);
+
+  // Repacking an update drops them, keeps the links and the bitmap
+  uint8_t* img = malloc(pkl_image_size(120));
+  assert(img);
+  pkl_decode(page, img);
+  make_row(tbl_slot_ptr(img, 9), 9000);
+  assert(pkl_repack(page, PS, img, NULL) == TABLE_OK);
+  assert(pkl_validate(page, PS) == TABLE_OK);
+  assert(tbl_get_next_page(page) == 77 && tbl_get_root_page(page) == 5);
+  assert(tbl_get_used_count(page) == 119 && !tbl_slot_is_used(page, 7));
+  static const uint8_t zero[128];
+  assert(pkl_record(page, 7, rec) == TABLE_OK && memcmp(rec, zero, 128) == 0);
+  make_row(recs + 9 * 128, 9000);
+  for (int i = 0; i < 120; i++) {
+    if (i == 7) continue;
+    assert(pkl_record(page, i, rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+  }
+
+  // A page filled to the brim cannot take incompressible records
+  free(recs);
+  recs = make_recs(512, make_row);
+  const size_t full = pkl_fit(recs, 512, PS);
+  uint8_t* big = malloc(pkl_image_size((uint16_t)full));
+  assert(big);
+  assert(pkl_build(page, PS, recs, full) == TABLE_OK);
+  uint8_t before[PS];
+  memcpy(before, page, PS);
+  pkl_decode(page, big);
+  make_noise(tbl_slot_ptr(big, 0), 1);
+  make_noise(tbl_slot_ptr(big, 1), 2);
+  uint8_t scratch[PS];   // the caller's buffer this time
+  assert(pkl_repack(page, PS, big, scratch) == TABLE_E_FULL);
+  assert(memcmp(page, before, PS) == 0);
+  free(big);
+  free(img);
+  free(recs);
+}
+
+static void test_validate(void) {
+  uint8_t* recs = make_recs(40, make_row);
+  uint8_t page[PS], bad[PS];
+  assert(pkl_build(page, PS, recs, 40) == TABLE_OK);
+  const size_t len_off = (TABLE_HDR_SIZE + 5 + 3) & ~(size_t)3;
+
+  memcpy(bad, page, PS);
+  write_le_u16(bad + TABLE_HDR_KIND_OFF, TABLE_PAGE_KIND_LEAF);
+  assert(pkl_validate(bad, PS) == TABLE_E_BADKIND);
+
+  memcpy(bad, page, PS);
+  write_le_u16(bad + TABLE_HDR_USED_COUNT_OFF, 39);
+  assert(pkl_validate(bad, PS) == TABLE_E_BITMAP);
+
+  memcpy(bad, page, PS);
+  write_le_u16(bad + TABLE_HDR_USED_COUNT_OFF, 41);
+  assert(pkl_validate(bad, PS) == TABLE_E_LAYOUT);   // used > capacity
+
+  memcpy(bad, page, PS);
+  write_le_u16(bad + TABLE_HDR_CAPACITY_OFF, 38);    // slots 38, 39 set past it
+  write_le_u16(bad + TABLE_HDR_USED_COUNT_OFF, 38);
+  assert(pkl_validate(bad, PS) == TABLE_E_BITMAP);
+
+  memcpy(bad, page, PS);
+  write_le_u32(bad + len_off, PS);
+  assert(pkl_validate(bad, PS) == TABLE_E_LAYOUT);
+
+  memcpy(bad, page, PS);
+  write_le_u32(bad + len_off, read_le_u32(page + len_off) - 1);
+  assert(pkl_validate(bad, PS) == TABLE_E_LAYOUT);
+
+  memcpy(bad, page, PS);
+  bad[len_off + 4] ^= 0x80;          // first control byte: literal <-> run
+  assert(pkl_validate(bad, PS) == TABLE_E_LAYOUT);
+
+  memcpy(bad, page, PS);
+  write_le_u16(bad + TABLE_HDR_CAPACITY_OFF, 0);
+  assert(pkl_validate(bad, PS) == TABLE_E_LAYOUT);
+  assert(pkl_validate(NULL, PS) == TABLE_E_INVAL);
+  free(recs);
+}
+
+int main(void) {
+  test_compressible();
+  test_incompressible();
+  test_runs();
+  test_repack();
+  test_validate();
+  printf("All packed tests passed.\n");
+  return 0;
+}
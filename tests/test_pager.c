@@ -1,11 +1,17 @@
 // tests/test_all.c
 // Black-box tests for pager_open / pager_read / getters / close.
 
+#define _POSIX_C_SOURCE 200809L
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/resource.h>
 #include "pager.h"
 
 // Local copy of header offsets for validation via pager_read(page 0).
@@ -90,6 +96,440 @@ static void test_truncated(void) {
     assert(p == NULL);
 }
 
+static void test_cache_write_back_and_evict(void) {
+    // Small pool (16 frames) over 64 pages: forces CLOCK eviction of dirty frames.
+    const char* tmp = "tests/tmp_pager_cache.db";
+    remove(tmp);
+
+    PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+    Pager* p = NULL;
+    int rc = pager_open_ex(tmp, &cfg, &p);
+    assert(rc == PAGER_OK && p);
+
+    size_t ps = pager_page_size(p);
+    uint8_t* buf = (uint8_t*)malloc(ps);
+    assert(buf);
+
+    const uint32_t N = 64;
+    for (uint32_t i = 0; i < N; i++) {
+        uint32_t no = 0;
+        assert(pager_alloc_page(p, &no) == PAGER_OK);
+        assert(no == i + 1);
+        memset(buf, (int)(no & 0xFF), ps);
+        assert(pager_write(p, no, buf) == PAGER_OK);
+    }
+    assert(pager_page_count(p) == N + 1);
+
+    // Re-read everything through the (now cycling) pool.
+    for (uint32_t no = 1; no <= N; no++) {
+        assert(pager_read(p, no, buf) == PAGER_OK);
+        assert(buf[0] == (uint8_t)no && buf[ps - 1] == (uint8_t)no);
+    }
+
+    assert(pager_flush(p) == PAGER_OK);
+    pager_close(p);
+
+    // Reopen with default config: data and page_count must be on disk.
+    p = NULL;
+    rc = pager_open(tmp, &p);
+    assert(rc == PAGER_OK && p);
+    assert(pager_page_count(p) == N + 1);
+    assert(pager_read(p, N, buf) == PAGER_OK);
+    assert(buf[0] == (uint8_t)N && "evicted/flushed page must persist");
+
+    free(buf);
+    pager_close(p);
+    remove(tmp);
+}
+
+static void test_cache_config_invalid(void) {
+    PagerConfig cfg = { .cache_pages = 1 };
+    Pager* p = NULL;
+    int rc = pager_open_ex("tests/fixtures/valid.db", &cfg, &p);
+    assert(rc == PAGER_E_INVAL && p == NULL && "cache below minimum must be rejected");
+}
+
+static void test_page_size_option(void) {
+    const char* tmp = "tests/tmp_pager_pagesize.db";
+    remove(tmp);
+
+    // Not a power of two, or outside [4096, 65536]: rejected, no file created
+    const uint32_t bad[] = { 2048, 12288, 131072 };
+    for (size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+        PagerConfig cfg = { .page_size = bad[i] };
+        Pager* p = NULL;
+        assert(pager_open_ex(tmp, &cfg, &p) == PAGER_E_PAGESIZE && p == NULL);
+        FILE* f = fopen(tmp, "rb");
+        assert(f == NULL && "rejected size must not create the file");
+    }
+
+    PagerConfig cfg = { .page_size = 16384 };
+    Pager* p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    assert(pager_page_size(p) == 16384 && pager_page_count(p) == 1);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 2, &first) == PAGER_OK && first == 1);
+    uint8_t* w = NULL;
+    assert(pager_pin_mut(p, 2, (void**)&w) == PAGER_OK);
+    memset(w, 0xA5, 16384);
+    assert(pager_unpin(p, w, true) == PAGER_OK);
+    pager_close(p);
+
+    // An existing file keeps its own size whatever the config asks for
+    cfg.page_size = 65536;
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    assert(pager_page_size(p) == 16384 && pager_page_count(p) == 3);
+    const uint8_t* r = NULL;
+    assert(pager_pin(p, 2, (const void**)&r) == PAGER_OK);
+    assert(r[0] == 0xA5 && r[16383] == 0xA5);
+    assert(pager_unpin(p, r, false) == PAGER_OK);
+    pager_close(p);
+
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && pager_page_size(p) == 16384);
+    pager_close(p);
+    remove(tmp);
+}
+
+// The write-back at close is where changes reach the file: its failure is
+// reported, not swallowed
+static void test_close_reports_write_error(void) {
+    const char* tmp = "tests/tmp_pager_close.db";
+    remove(tmp);
+    assert(pager_close(NULL) == PAGER_E_INVAL);
+
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 4, &first) == PAGER_OK);
+    assert(pager_close(p) == PAGER_OK);
+
+    // Writes past the first page now fail (EFBIG, SIGXFSZ ignored)
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    uint8_t* w = NULL;
+    assert(pager_pin_mut(p, 3, (void**)&w) == PAGER_OK);
+    memset(w, 0x3C, pager_page_size(p));
+    assert(pager_unpin(p, w, true) == PAGER_OK);
+    struct rlimit old, lim;
+    assert(getrlimit(RLIMIT_FSIZE, &old) == 0);
+    lim = old;
+    lim.rlim_cur = pager_page_size(p);
+    void (*prev)(int) = signal(SIGXFSZ, SIG_IGN);
+    assert(setrlimit(RLIMIT_FSIZE, &lim) == 0);
+    assert(pager_close(p) == PAGER_E_IO);
+    assert(setrlimit(RLIMIT_FSIZE, &old) == 0);
+    signal(SIGXFSZ, prev);
+    remove(tmp);
+}
+
+static void test_pin_unpin(void) {
+    const char* tmp = "tests/tmp_pager_pin.db";
+    remove(tmp);
+
+    PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+    Pager* p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+
+    const uint32_t N = PAGER_MIN_CACHE_PAGES + 1;
+    for (uint32_t i = 0; i < N; i++) {
+        uint32_t no = 0;
+        assert(pager_alloc_page(p, &no) == PAGER_OK);
+    }
+
+    // Modify in place through a mutable pin, then observe via pager_read.
+    void* w = NULL;
+    assert(pager_pin_mut(p, 1, &w) == PAGER_OK && w);
+    memset(w, 0x5A, pager_page_size(p));
+    assert(pager_unpin(p, w, true) == PAGER_OK);
+    assert(pager_unpin(p, w, false) == PAGER_E_INVAL && "double unpin must fail");
+
+    const void* r = NULL;
+    assert(pager_pin(p, 1, &r) == PAGER_OK && r == w && "same frame on a hit");
+    assert(((const uint8_t*)r)[100] == 0x5A);
+    assert(pager_unpin(p, r, false) == PAGER_OK);
+
+    // Pin every frame: the next miss has nothing to evict.
+    const void* pins[PAGER_MIN_CACHE_PAGES];
+    for (uint32_t i = 0; i < PAGER_MIN_CACHE_PAGES; i++)
+        assert(pager_pin(p, i, &pins[i]) == PAGER_OK);
+    assert(pager_pin(p, N, &r) == PAGER_E_NOFRAME);
+    for (uint32_t i = 0; i < PAGER_MIN_CACHE_PAGES; i++)
+        assert(pager_unpin(p, pins[i], false) == PAGER_OK);
+    assert(pager_pin(p, N, &r) == PAGER_OK);
+    assert(pager_unpin(p, r, false) == PAGER_OK);
+
+    uint8_t stray[16];
+    assert(pager_unpin(p, stray, false) == PAGER_E_INVAL);
+    assert(pager_pin(p, pager_page_count(p), &r) == PAGER_E_RANGE);
+
+    pager_close(p);
+    remove(tmp);
+}
+
+static void test_alloc_pages_group(void) {
+    // ok_extra.db has one stale page past page_count: it must come back zeroed.
+    const char* tmp = "tests/tmp_pager_group.db";
+    FILE* in = fopen("tests/fixtures/ok_extra.db", "rb");
+    FILE* out = fopen(tmp, "wb");
+    assert(in && out);
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof chunk, in)) > 0) fwrite(chunk, 1, n, out);
+    fclose(in);
+    fclose(out);
+
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    const uint32_t before = pager_page_count(p);
+
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 0, &first) == PAGER_E_INVAL);
+    assert(pager_alloc_pages(p, 10, &first) == PAGER_OK);
+    assert(first == before);
+    assert(pager_page_count(p) == before + 10);
+
+    uint8_t* buf = (uint8_t*)malloc(pager_page_size(p));
+    assert(buf);
+    for (uint32_t i = 0; i < 10; i++) {
+        assert(pager_read(p, first + i, buf) == PAGER_OK);
+        for (size_t k = 0; k < pager_page_size(p); k++) assert(buf[k] == 0);
+    }
+    free(buf);
+    pager_close(p);
+
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    assert(pager_page_count(p) == before + 10 && "page_count persisted once");
+    pager_close(p);
+    remove(tmp);
+}
+
+static void test_mmap_read_path(void) {
+    const char* tmp = "tests/tmp_pager_mmap.db";
+    remove(tmp);
+
+    // Build a file with 40 tagged pages
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    size_t ps = pager_page_size(p);
+    uint8_t* buf = (uint8_t*)malloc(ps);
+    assert(buf);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 40, &first) == PAGER_OK && first == 1);
+    for (uint32_t no = 1; no <= 40; no++) {
+        memset(buf, (int)no, ps);
+        assert(pager_write(p, no, buf) == PAGER_OK);
+    }
+    pager_close(p);
+
+    // The mapping is only for read-only pagers, which take no log
+    PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES, .use_mmap = true };
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_E_INVAL && !p);
+    cfg.read_only = true;
+    cfg.wal = true;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_E_INVAL && !p);
+    cfg.wal = false;
+    assert(pager_open_ex("tests/tmp_pager_mmap_none.db", &cfg, &p) != PAGER_OK && !p);
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+
+    // Clean pages come from the mapping, more of them than the pool holds
+    const void* pins[40];
+    for (uint32_t no = 1; no <= 40; no++) {
+        assert(pager_pin(p, no, &pins[no - 1]) == PAGER_OK);
+        assert(((const uint8_t*)pins[no - 1])[ps - 1] == (uint8_t)no);
+    }
+    assert(pager_unpin(p, pins[0], true) == PAGER_E_INVAL && "mapping pins are read-only");
+    for (uint32_t i = 0; i < 40; i++)
+        assert(pager_unpin(p, pins[i], false) == PAGER_OK);
+    assert(pager_read(p, 7, buf) == PAGER_OK && buf[10] == 7);
+
+    // Nothing can change the mapped bytes under a pin
+    void* w = NULL;
+    uint32_t extra = 0;
+    assert(pager_write(p, 7, buf) == PAGER_E_READONLY);
+    assert(pager_pin_mut(p, 7, &w) == PAGER_E_READONLY && !w);
+    assert(pager_pin_zero(p, 7, &w) == PAGER_E_READONLY);
+    assert(pager_alloc_page(p, &extra) == PAGER_E_READONLY);
+    assert(pager_free_page(p, 7) == PAGER_E_READONLY);
+    assert(pager_set_catalog(p, 3) == PAGER_E_READONLY);
+    assert(pager_txn_begin(p) == PAGER_E_READONLY);
+    assert(pager_write_begin(p) == PAGER_E_READONLY);
+    assert(pager_flush(p) == PAGER_OK);
+    assert(pager_page_count(p) == 41);
+
+    // Without the mapping, a read-only pager reads through the pool
+    pager_close(p);
+    cfg.use_mmap = false;
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    const void* ptr = NULL;
+    assert(pager_pin(p, 8, &ptr) == PAGER_OK && ((const uint8_t*)ptr)[10] == 8);
+    assert(pager_unpin(p, ptr, false) == PAGER_OK);
+    assert(pager_write(p, 8, buf) == PAGER_E_READONLY);
+
+    free(buf);
+    pager_close(p);
+    remove(tmp);
+}
+
+static void read_pages(Pager* p, uint32_t from, uint32_t to, int step) {
+    for (int64_t no = from; step > 0 ? no <= to : no >= to; no += step) {
+        const void* page = NULL;
+        assert(pager_pin(p, (uint32_t)no, &page) == PAGER_OK);
+        assert(((const uint8_t*)page)[100] == (uint8_t)no);
+        assert(pager_unpin(p, page, false) == PAGER_OK);
+    }
+}
+
+static void test_sequential_read_ahead(void) {
+    const char* tmp = "tests/tmp_pager_seq.db";
+    remove(tmp);
+
+    enum { N = 200 };
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    uint8_t* buf = (uint8_t*)malloc(pager_page_size(p));
+    assert(buf);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, N, &first) == PAGER_OK && first == 1);
+    for (uint32_t no = 1; no <= N; no++) {
+        memset(buf, (int)no, pager_page_size(p));
+        assert(pager_write(p, no, buf) == PAGER_OK);
+    }
+    free(buf);
+    pager_close(p);
+
+    PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    assert(pager_readahead_pages(p) == 0);
+
+    // Scattered misses never read ahead
+    read_pages(p, N, 1, -7);
+    assert(pager_readahead_pages(p) == 0);
+
+    // A forward run does once it is PAGER_SEQ_TRIGGER misses long, and
+    // keeps one window ahead of the reader up to the end of the file
+    read_pages(p, 1, PAGER_SEQ_TRIGGER - 1, 1);
+    assert(pager_readahead_pages(p) == 0);
+    read_pages(p, PAGER_SEQ_TRIGGER, N - 1, 1);
+    assert(pager_readahead_pages(p) == N - PAGER_SEQ_TRIGGER);
+
+    // RANDOM turns it off, SEQUENTIAL starts at the first miss
+    assert(pager_set_access(p, PAGER_ACCESS_RANDOM) == PAGER_ACCESS_NORMAL);
+    read_pages(p, 1, 60, 2);
+    assert(pager_readahead_pages(p) == N - PAGER_SEQ_TRIGGER);
+    assert(pager_set_access(p, PAGER_ACCESS_SEQUENTIAL) == PAGER_ACCESS_RANDOM);
+    read_pages(p, 100, 100, 1);
+    assert(pager_readahead_pages(p) == N - PAGER_SEQ_TRIGGER + PAGER_DEFAULT_READAHEAD);
+    assert(pager_set_access(p, PAGER_ACCESS_NORMAL) == PAGER_ACCESS_SEQUENTIAL);
+    pager_close(p);
+
+    // Off by configuration; mapped pins are advised through the mapping
+    cfg.readahead = PAGER_READAHEAD_OFF;
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    read_pages(p, 1, N - 1, 1);
+    assert(pager_readahead_pages(p) == 0);
+    pager_close(p);
+
+    cfg.readahead = 16;
+    cfg.read_only = cfg.use_mmap = true;
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    read_pages(p, 1, N - 1, 1);
+    assert(pager_readahead_pages(p) == N - PAGER_SEQ_TRIGGER);
+    pager_close(p);
+    remove(tmp);
+}
+
+static void test_free_list_and_trim(void) {
+    const char* tmp = "tests/tmp_pager_free.db";
+    remove(tmp);
+    remove("tests/tmp_pager_free.db-wal");
+
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    const size_t ps = pager_page_size(p);
+    uint8_t* buf = (uint8_t*)malloc(ps);
+    assert(buf);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 10, &first) == PAGER_OK && first == 1);
+    for (uint32_t no = 1; no <= 10; no++) {
+        memset(buf, (int)no, ps);
+        assert(pager_write(p, no, buf) == PAGER_OK);
+    }
+
+    assert(pager_free_page(p, 0) == PAGER_E_RANGE);
+    assert(pager_free_page(p, 11) == PAGER_E_RANGE);
+    assert(pager_free_page(p, 3) == PAGER_OK);
+    assert(pager_free_page(p, 9) == PAGER_OK);
+    assert(pager_free_page(p, 9) == PAGER_E_INVAL && "double free");
+    assert(pager_free_count(p) == 2);
+    assert(pager_read(p, 9, buf) == PAGER_OK && buf[0] == PAGER_FREE_PAGE_KIND && buf[ps - 1] == 0);
+
+    // Allocation takes the last freed page first, zeroed; the group call
+    // always appends
+    uint32_t no = 0;
+    assert(pager_alloc_page(p, &no) == PAGER_OK && no == 9);
+    assert(pager_read(p, 9, buf) == PAGER_OK && buf[0] == 0 && buf[ps - 1] == 0);
+    assert(pager_alloc_pages(p, 1, &no) == PAGER_OK && no == 11);
+    assert(pager_free_count(p) == 1 && pager_page_count(p) == 12);
+
+    // Nothing free at the end: trim is a no-op
+    uint32_t released = 99;
+    assert(pager_trim(p, &released) == PAGER_OK && released == 0);
+    pager_close(p);
+
+    // The list survives a reopen; freeing the tail lets trim shrink the file
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && pager_free_count(p) == 1);
+    assert(pager_free_page(p, 11) == PAGER_OK);
+    assert(pager_free_page(p, 10) == PAGER_OK);
+    assert(pager_free_page(p, 5) == PAGER_OK);
+
+    const void* pinned = NULL;
+    assert(pager_pin(p, 10, &pinned) == PAGER_OK);
+    assert(pager_trim(p, NULL) == PAGER_E_INVAL && "a pinned page cannot go");
+    assert(pager_unpin(p, pinned, false) == PAGER_OK);
+    assert(pager_trim(p, &released) == PAGER_OK && released == 2);
+    assert(pager_page_count(p) == 10 && pager_free_count(p) == 2);
+    assert(pager_read(p, 10, buf) == PAGER_E_RANGE);
+    pager_close(p);
+
+    FILE* f = fopen(tmp, "rb");
+    assert(f);
+    assert(fseek(f, 0, SEEK_END) == 0 && ftell(f) == (long)(10 * ps));
+    fclose(f);
+
+    // What stays free is handed out lowest first, then the file grows again
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && pager_page_count(p) == 10);
+    assert(pager_alloc_page(p, &no) == PAGER_OK && no == 3);
+    assert(pager_alloc_page(p, &no) == PAGER_OK && no == 5);
+    assert(pager_alloc_page(p, &no) == PAGER_OK && no == 10);
+    assert(pager_read(p, 8, buf) == PAGER_OK && buf[0] == 8);
+    pager_close(p);
+
+    // WAL mode: the shorter file is checkpointed before it is cut
+    PagerConfig cfg = { .wal = true };
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    assert(pager_free_page(p, 10) == PAGER_OK && pager_commit(p) == PAGER_OK);
+    assert(pager_trim(p, &released) == PAGER_OK && released == 1);
+    pager_close(p);
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK);
+    assert(pager_page_count(p) == 10 && pager_free_count(p) == 0);
+    pager_close(p);
+
+    free(buf);
+    remove(tmp);
+}
+
 static void test_ok_extra(void) {
     // File can be larger than header's page_count * page_size.
     Pager* p = NULL;
@@ -98,6 +538,416 @@ static void test_ok_extra(void) {
     pager_close(p);
 }
 
+static void test_latch_reentrancy(void) {
+    const char* tmp = "tests/tmp_pager_latch.db";
+    remove(tmp);
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 2, &first) == PAGER_OK && first == 1);
+
+    // The exclusive holder may pin its page again, in either mode
+    void* w = NULL;
+    const void* r = NULL;
+    void* w2 = NULL;
+    assert(pager_pin_mut(p, 1, &w) == PAGER_OK);
+    assert(pager_pin(p, 1, &r) == PAGER_OK && r == w);
+    assert(pager_pin_mut(p, 1, &w2) == PAGER_OK && w2 == w);
+    assert(pager_unpin(p, w2, true) == PAGER_OK);
+    assert(pager_unpin(p, r, false) == PAGER_OK);
+    assert(pager_unpin(p, w, true) == PAGER_OK);
+
+    // A sharer can upgrade when it is the only reader
+    assert(pager_pin(p, 2, &r) == PAGER_OK);
+    assert(pager_pin_mut(p, 2, &w) == PAGER_OK && w == r);
+    memset(w, 0x11, pager_page_size(p));
+    assert(pager_unpin(p, r, false) == PAGER_OK);
+    assert(pager_unpin(p, w, true) == PAGER_OK);
+    assert(pager_unpin(p, w, false) == PAGER_E_INVAL);
+
+    pager_close(p);
+    remove(tmp);
+}
+
+// ---- threads: one writer rewrites whole pages, readers must never see a mix
+enum { LATCH_PAGES = 48, LATCH_WRITES = 3000, LATCH_READERS = 3, ALLOC_THREADS = 4, ALLOC_EACH = 200 };
+
+typedef struct {
+    Pager*     p;
+    atomic_int done;
+    atomic_int reads;
+} LatchCtx;
+
+static void* latch_writer(void* arg) {
+    LatchCtx* c = (LatchCtx*)arg;
+    const size_t ps = pager_page_size(c->p);
+    for (uint32_t i = 0; i < LATCH_WRITES; i++) {
+        uint8_t* w = NULL;
+        assert(pager_pin_mut(c->p, 1 + (i * 7u) % LATCH_PAGES, (void**)&w) == PAGER_OK);
+        memset(w, (uint8_t)(i + 1), ps / 2);
+        memset(w + ps / 2, (uint8_t)(i + 1), ps / 2);
+        assert(pager_unpin(c->p, w, true) == PAGER_OK);
+    }
+    atomic_store(&c->done, 1);
+    return NULL;
+}
+
+static void* latch_reader(void* arg) {
+    LatchCtx* c = (LatchCtx*)arg;
+    const size_t ps = pager_page_size(c->p);
+    uint8_t* copy = (uint8_t*)malloc(ps);
+    assert(copy);
+    uint32_t k = 0;
+    while (!atomic_load(&c->done)) {
+        const uint32_t no = 1 + (k++ * 13u) % LATCH_PAGES;
+        const uint8_t* r = NULL;
+        assert(pager_pin(c->p, no, (const void**)&r) == PAGER_OK);
+        for (size_t i = 1; i < ps; i++) assert(r[i] == r[0] && "torn page under a shared pin");
+        assert(pager_unpin(c->p, r, false) == PAGER_OK);
+
+        assert(pager_read(c->p, no, copy) == PAGER_OK);
+        for (size_t i = 1; i < ps; i++) assert(copy[i] == copy[0] && "torn page copy");
+        atomic_fetch_add(&c->reads, 1);
+    }
+    free(copy);
+    return NULL;
+}
+
+static void* alloc_worker(void* arg) {
+    Pager* p = (Pager*)arg;
+    uint32_t* got = (uint32_t*)malloc(ALLOC_EACH * sizeof *got);
+    assert(got);
+    for (int i = 0; i < ALLOC_EACH; i++)
+        assert(pager_alloc_page(p, &got[i]) == PAGER_OK);
+    return got;
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    const uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void test_concurrent_latches_and_alloc(void) {
+    const char* tmp = "tests/tmp_pager_threads.db";
+    remove(tmp);
+
+    // Small pool: readers and the writer keep evicting and faulting pages in
+    PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+    Pager* p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, LATCH_PAGES, &first) == PAGER_OK && first == 1);
+
+    LatchCtx c = { .p = p };
+    pthread_t wr, rd[LATCH_READERS];
+    for (int i = 0; i < LATCH_READERS; i++)
+        assert(pthread_create(&rd[i], NULL, latch_reader, &c) == 0);
+    assert(pthread_create(&wr, NULL, latch_writer, &c) == 0);
+    assert(pthread_join(wr, NULL) == 0);
+    for (int i = 0; i < LATCH_READERS; i++)
+        assert(pthread_join(rd[i], NULL) == 0);
+    assert(atomic_load(&c.reads) > 0);
+
+    // Concurrent allocations hand out distinct pages and keep the count exact
+    const uint32_t before = pager_page_count(p);
+    pthread_t al[ALLOC_THREADS];
+    uint32_t all[ALLOC_THREADS * ALLOC_EACH];
+    for (int i = 0; i < ALLOC_THREADS; i++)
+        assert(pthread_create(&al[i], NULL, alloc_worker, p) == 0);
+    for (int i = 0; i < ALLOC_THREADS; i++) {
+        void* got = NULL;
+        assert(pthread_join(al[i], &got) == 0 && got);
+        memcpy(all + i * ALLOC_EACH, got, ALLOC_EACH * sizeof(uint32_t));
+        free(got);
+    }
+    qsort(all, ALLOC_THREADS * ALLOC_EACH, sizeof all[0], cmp_u32);
+    for (int i = 0; i < ALLOC_THREADS * ALLOC_EACH; i++)
+        assert(all[i] == before + (uint32_t)i);
+    assert(pager_page_count(p) == before + ALLOC_THREADS * ALLOC_EACH);
+
+    pager_close(p);
+
+    // The last image of every page made it to the file
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    assert(pager_page_count(p) == before + ALLOC_THREADS * ALLOC_EACH);
+    const uint8_t* r = NULL;
+    assert(pager_pin(p, 1, (const void**)&r) == PAGER_OK);
+    const uint32_t last = ((LATCH_WRITES - 1) / LATCH_PAGES) * LATCH_PAGES;   // last write to page 1
+    assert(r[0] == (uint8_t)(last + 1) && r[pager_page_size(p) - 1] == r[0]);
+    assert(pager_unpin(p, r, false) == PAGER_OK);
+    pager_close(p);
+    remove(tmp);
+}
+
+// ---- snapshots: copies on first write, per-snapshot views, write sections
+static uint8_t pinned_byte(Pager* p, uint32_t no) {
+    const void* page = NULL;
+    assert(pager_pin(p, no, &page) == PAGER_OK);
+    const uint8_t v = ((const uint8_t*)page)[100];
+    assert(pager_unpin(p, page, false) == PAGER_OK);
+    return v;
+}
+
+static void fill(Pager* p, uint32_t no, int v) {
+    uint8_t* w = NULL;
+    assert(pager_pin_mut(p, no, (void**)&w) == PAGER_OK);
+    memset(w, v, pager_page_size(p));
+    assert(pager_unpin(p, w, true) == PAGER_OK);
+}
+
+typedef struct {
+    Pager*     p;
+    atomic_int begun;
+} SnapWaitCtx;
+
+static void* snapshot_waiter(void* arg) {
+    SnapWaitCtx* c = (SnapWaitCtx*)arg;
+    PagerSnapshot* s = NULL;
+    assert(pager_snapshot_begin(c->p, &s) == PAGER_OK);
+    atomic_store(&c->begun, 1);
+    assert(pager_snapshot_end(c->p, s) == PAGER_OK);
+    return NULL;
+}
+
+static void test_snapshots(void) {
+    const char* tmp = "tests/tmp_pager_snap.db";
+    remove(tmp);
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    const size_t ps = pager_page_size(p);
+    uint8_t* buf = malloc(ps);
+    assert(buf);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 8, &first) == PAGER_OK && first == 1);
+    for (uint32_t no = 1; no <= 8; no++) fill(p, no, (int)no);
+    assert(pager_flush(p) == PAGER_OK);
+
+    // A bound thread reads, never writes
+    PagerSnapshot* s1 = NULL;
+    assert(pager_snapshot_begin(p, &s1) == PAGER_OK && s1);
+    assert(pager_snapshot_current(p) == s1);
+    void* w = NULL;
+    assert(pager_pin_mut(p, 3, &w) == PAGER_E_READONLY);
+    assert(pager_write(p, 3, buf) == PAGER_E_READONLY);
+    assert(pager_free_page(p, 3) == PAGER_E_READONLY);
+    assert(pager_alloc_page(p, &first) == PAGER_E_READONLY);
+    assert(pager_write_begin(p) == PAGER_E_READONLY);
+    assert(pinned_byte(p, 3) == 3 && pager_snapshot_pages(p) == 0);
+
+    // The live pages change: the first change of each page copies it once
+    assert(pager_snapshot_bind(p, NULL) == PAGER_OK);
+    fill(p, 3, 0xA3);
+    fill(p, 3, 0xB3);
+    memset(buf, 0xA4, ps);
+    assert(pager_write(p, 4, buf) == PAGER_OK);
+    assert(pager_free_page(p, 5) == PAGER_OK);
+    assert(pager_pin_zero(p, 6, &w) == PAGER_OK && pager_unpin(p, w, true) == PAGER_OK);
+    assert(pager_snapshot_pages(p) == 5);   // pages 3 to 6 and the header (free list)
+    assert(pinned_byte(p, 3) == 0xB3 && pinned_byte(p, 6) == 0);
+
+    // ... while the snapshot still sees them as they were, by every read call
+    assert(pager_snapshot_bind(p, s1) == PAGER_OK);
+    assert(pinned_byte(p, 3) == 3 && pinned_byte(p, 6) == 6 && pinned_byte(p, 7) == 7);
+    assert(pager_read(p, 4, buf) == PAGER_OK && buf[0] == 4 && buf[ps - 1] == 4);
+    const void* ptr = NULL;
+    assert(pager_pin(p, 5, &ptr) == PAGER_OK && ((const uint8_t*)ptr)[0] == 5);
+    assert(pager_unpin(p, ptr, false) == PAGER_OK);
+    const void* copy = NULL;
+    assert(pager_pin(p, 3, &copy) == PAGER_OK);
+    assert(pager_page_state(p, copy) == PAGER_PAGE_UNCHECKED);
+    pager_page_trust(p, copy);
+    assert(pager_page_state(p, copy) == PAGER_PAGE_TRUSTED);
+    assert(pager_unpin(p, copy, true) == PAGER_E_INVAL && "copies are read-only");
+    assert(pager_unpin(p, copy, false) == PAGER_OK);
+    assert(pager_unpin(p, copy, false) == PAGER_E_INVAL);
+
+    // A second snapshot sees the state after those changes
+    PagerSnapshot* s2 = NULL;
+    assert(pager_snapshot_begin(p, &s2) == PAGER_OK && pager_snapshot_current(p) == s2);
+    assert(pager_snapshot_bind(p, NULL) == PAGER_OK);
+    fill(p, 3, 0xC3);
+    fill(p, 7, 0xC7);
+    assert(pager_snapshot_pages(p) == 7);
+    assert(pager_snapshot_bind(p, s2) == PAGER_OK);
+    assert(pinned_byte(p, 3) == 0xB3 && pinned_byte(p, 7) == 7);
+    assert(pager_snapshot_bind(p, s1) == PAGER_OK);
+    assert(pinned_byte(p, 3) == 3 && pinned_byte(p, 7) == 7);
+
+    // Ending the first drops the copies only it could see
+    assert(pager_snapshot_end(p, s1) == PAGER_OK && pager_snapshot_current(p) == NULL);
+    assert(pager_snapshot_pages(p) == 2);   // page 3 after its first change, page 7
+    assert(pager_snapshot_end(p, s2) == PAGER_OK);
+    assert(pager_snapshot_pages(p) == 0);
+    assert(pinned_byte(p, 3) == 0xC3);
+
+    // Snapshots begin between write sections, which nest
+    assert(pager_write_begin(p) == PAGER_OK);
+    assert(pager_write_begin(p) == PAGER_OK);
+    PagerSnapshot* s3 = NULL;
+    assert(pager_snapshot_begin(p, &s3) == PAGER_E_READONLY && !s3);
+    SnapWaitCtx c = { .p = p };
+    atomic_init(&c.begun, 0);
+    pthread_t waiter;
+    assert(pthread_create(&waiter, NULL, snapshot_waiter, &c) == 0);
+    pager_write_end(p);
+    nanosleep(&(struct timespec){ .tv_nsec = 20000000 }, NULL);
+    assert(atomic_load(&c.begun) == 0);
+    pager_write_end(p);
+    pthread_join(waiter, NULL);
+    assert(atomic_load(&c.begun) == 1);
+
+    // Closing with a snapshot open releases it
+    assert(pager_snapshot_begin(p, &s3) == PAGER_OK);
+    assert(pager_snapshot_bind(p, NULL) == PAGER_OK);
+    fill(p, 1, 0xD1);
+    assert(pager_snapshot_pages(p) == 1);
+    pager_close(p);
+
+    free(buf);
+    remove(tmp);
+}
+
+// Byte `off` of page `no` as the database file holds it (-1 past its end)
+static int file_byte(const char* path, size_t ps, uint32_t no, size_t off) {
+    FILE* f = fopen(path, "rb");
+    assert(f);
+    int c = fseek(f, (long)(no * ps + off), SEEK_SET) == 0 ? fgetc(f) : EOF;
+    fclose(f);
+    return c == EOF ? -1 : c;
+}
+
+static long file_len(const char* path) {
+    FILE* f = fopen(path, "rb");
+    assert(f);
+    assert(fseek(f, 0, SEEK_END) == 0);
+    long n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+// Another thread's view of a page and of the catalog
+typedef struct {
+    Pager*   p;
+    uint32_t page;
+    uint8_t  seen;
+    uint32_t catalog;
+    bool     owned;
+} TxnReadCtx;
+
+static void* txn_reader(void* arg) {
+    TxnReadCtx* c = arg;
+    c->seen = pinned_byte(c->p, c->page);
+    uint8_t buf[PAGER_PAGE_SIZE];
+    assert(pager_read(c->p, c->page, buf) == PAGER_OK && buf[100] == c->seen);
+    assert(pager_get_catalog(c->p, &c->catalog) == PAGER_OK);
+    c->owned = pager_txn_owned(c->p);
+    return NULL;
+}
+
+static uint8_t txn_read_elsewhere(Pager* p, uint32_t page, uint32_t* out_catalog) {
+    TxnReadCtx c = { .p = p, .page = page, .owned = true };
+    pthread_t t;
+    assert(pthread_create(&t, NULL, txn_reader, &c) == 0);
+    pthread_join(t, NULL);
+    assert(!c.owned);
+    if (out_catalog) *out_catalog = c.catalog;
+    return c.seen;
+}
+
+static void test_transactions(void) {
+    const char* tmp = "tests/tmp_pager_txn.db";
+    remove(tmp);
+    remove("tests/tmp_pager_txn.db-wal");
+
+    // Without the log a commit could not be atomic: no transaction
+    Pager* p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    const size_t ps = pager_page_size(p);
+    uint32_t first = 0;
+    assert(pager_alloc_pages(p, 8, &first) == PAGER_OK && first == 1);
+    for (uint32_t no = 1; no <= 8; no++) fill(p, no, (int)no);
+    assert(pager_txn_begin(p) == PAGER_E_INVAL && !pager_txn_active(p));
+    pager_close(p);
+
+    PagerConfig small = { .cache_pages = PAGER_MIN_CACHE_PAGES, .wal = true };
+    p = NULL;
+    assert(pager_open_ex(tmp, &small, &p) == PAGER_OK && p);
+    fill(p, 1, 0x11);   // dirty when the transaction begins: committed by it
+
+    assert(pager_txn_commit(p) == PAGER_E_INVAL && pager_txn_abort(p) == PAGER_E_INVAL);
+    assert(!pager_txn_active(p) && !pager_txn_owned(p));
+    assert(pager_txn_begin(p) == PAGER_OK && pager_txn_active(p) && pager_txn_owned(p));
+    assert(pager_txn_begin(p) == PAGER_E_INVAL && "one at a time");
+    PagerSnapshot* s = NULL;
+    assert(pager_snapshot_begin(p, &s) == PAGER_E_READONLY);
+
+    // Repeated changes stay in the pool; flush, commit, checkpoint and trim
+    // write nothing
+    for (int i = 0; i < 50; i++) fill(p, 2, 0xA0 + i % 2);
+    uint32_t no = 0;
+    assert(pager_alloc_pages(p, 3, &no) == PAGER_OK && no == 9);
+    fill(p, 10, 0xAA);
+    assert(pager_free_page(p, 11) == PAGER_OK && pager_free_count(p) == 1);
+    assert(pager_set_catalog(p, 3) == PAGER_OK);
+    uint32_t released = 99;
+    assert(pager_trim(p, &released) == PAGER_OK && released == 0);
+    assert(pager_flush(p) == PAGER_OK && pager_commit(p) == PAGER_OK);
+    assert(pager_checkpoint(p) == PAGER_OK);
+    assert(file_byte(tmp, ps, 1, 100) == 1 && file_byte(tmp, ps, 2, 100) == 2);
+
+    // Other threads see the pages and the catalog as they were at begin
+    uint32_t cat = 99;
+    assert(txn_read_elsewhere(p, 2, &cat) == 2 && cat == 0);
+    assert(txn_read_elsewhere(p, 1, NULL) == 0x11);
+    assert(pinned_byte(p, 2) == 0xA1);
+    assert(pager_get_catalog(p, &cat) == PAGER_OK && cat == 3);
+
+    // More pages than the pool holds: the evicted ones go to the log,
+    // uncommitted, and still read back as changed
+    for (uint32_t k = 3; k <= 8; k++) fill(p, k, 0xB0);
+    assert(pager_alloc_pages(p, 20, &no) == PAGER_OK && no == 12);
+    for (uint32_t k = 12; k < 32; k++) fill(p, k, 0xB1);
+    assert(pinned_byte(p, 3) == 0xB0 && pinned_byte(p, 2) == 0xA1 && pinned_byte(p, 12) == 0xB1);
+    assert(txn_read_elsewhere(p, 3, NULL) == 3 && txn_read_elsewhere(p, 2, NULL) == 2);
+
+    // Abort: every page, the header fields and the file size come back
+    const void* held = NULL;
+    assert(pager_pin(p, 2, &held) == PAGER_OK);
+    assert(pager_txn_abort(p) == PAGER_E_INVAL && pager_txn_active(p));
+    assert(pager_unpin(p, held, false) == PAGER_OK);
+    assert(pager_txn_abort(p) == PAGER_OK && !pager_txn_active(p));
+    assert(pager_page_count(p) == 9 && pager_free_count(p) == 0);
+    assert(pager_get_catalog(p, &cat) == PAGER_OK && cat == 0);
+    assert(file_len(tmp) == (long)(9 * ps));
+    assert(pinned_byte(p, 1) == 0x11 && pinned_byte(p, 2) == 2 && pinned_byte(p, 3) == 3);
+    assert(pinned_byte(p, 8) == 8);
+    assert(pager_read(p, 9, (uint8_t[PAGER_PAGE_SIZE]){0}) == PAGER_E_RANGE);
+    assert(pager_snapshot_pages(p) == 0 && "the transaction's copies are gone");
+
+    // Commit: one logged transaction, then visible everywhere
+    assert(pager_txn_begin(p) == PAGER_OK);
+    for (int i = 0; i < 50; i++) fill(p, 2, 0xC0 + i % 2);
+    assert(pager_alloc_page(p, &no) == PAGER_OK && no == 9);
+    fill(p, 9, 0xC9);
+    assert(txn_read_elsewhere(p, 2, NULL) == 2);
+    assert(pager_txn_commit(p) == PAGER_OK && !pager_txn_active(p));
+    assert(txn_read_elsewhere(p, 2, NULL) == 0xC1);
+    assert(pager_checkpoint(p) == PAGER_OK);
+    assert(file_byte(tmp, ps, 2, 100) == 0xC1 && file_byte(tmp, ps, 9, 100) == 0xC9);
+
+    // Closing with a transaction open aborts it
+    assert(pager_txn_begin(p) == PAGER_OK);
+    fill(p, 3, 0xDD);
+    assert(pager_alloc_page(p, &no) == PAGER_OK && no == 10);
+    pager_close(p);
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK);
+    assert(pager_page_count(p) == 10 && pinned_byte(p, 3) == 3 && pinned_byte(p, 1) == 0x11);
+    pager_close(p);
+    remove(tmp);
+}
+
 int main(void) {
     test_open_ok_and_read_header();
     test_read_oob();
@@ -107,6 +957,19 @@ int main(void) {
     test_bad_flags();
     test_truncated();
     test_ok_extra();
+    test_cache_write_back_and_evict();
+    test_cache_config_invalid();
+    test_page_size_option();
+    test_pin_unpin();
+    test_close_reports_write_error();
+    test_alloc_pages_group();
+    test_mmap_read_path();
+    test_sequential_read_ahead();
+    test_free_list_and_trim();
+    test_latch_reentrancy();
+    test_concurrent_latches_and_alloc();
+    test_snapshots();
+    test_transactions();
     printf("All pager tests passed.\n");
     return 0;
 }
@@ -0,0 +1,338 @@
+// tests/test_pax.c
+// PAX leaves: building layouts from fields, capacity, init and validation
+// of damaged pages, scattering and gathering records (whole or by column),
+// field arrays, column selection, decoding, and predicates run on the
+// minipages agreeing with the same predicates run on whole records.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "table.h"
+#include "pax.h"
+#include "predicate.h"
+#include "index_key.h"
+#include "endian_util.h"
+
+enum { PS = 4096 };
+
+// ---- helpers ----------------------------------------------------------------
+// u32 tag, name, age, city: the fields the layout is built from
+static void make_row(uint8_t rec[128], uint32_t tag) {
+  static const char* cities[] = { "Paris", "Lyon", "Tokyo", "Oslo" };
+  memset(rec, 0, 128);
+  write_le_u32(rec, tag);
+  snprintf((char*)rec + 4, 28, "user%u", tag);
+  rec[32] = (uint8_t)(20 + tag % 50);
+  memcpy(rec + 33, cities[tag % 4], strlen(cities[tag % 4]));
+  for (int i = 49; i < 128; i++) rec[i] = (uint8_t)(tag + i);
+}
+
+static void row_layout(PaxLayout* l) {
+  pax_layout_init(l);
+  assert(pax_layout_add(l, 0, 4) == TABLE_OK);
+  assert(pax_layout_add(l, 4, 28) == TABLE_OK);
+  assert(pax_layout_add(l, 32, 1) == TABLE_OK);
+  assert(pax_layout_add(l, 33, 16) == TABLE_OK);
+}
+
+// A full page of rows, every slot used
+static void fill(uint8_t* page, const PaxLayout* l) {
+  assert(pax_init(page, PS, l) == TABLE_OK);
+  uint8_t rec[128];
+  for (int i = 0; i < tbl_get_capacity(page); i++) {
+    make_row(rec, (uint32_t)i);
+    pax_put(page, i, rec);
+    assert(tbl_slot_mark_used(page, i) == TABLE_OK);
+  }
+}
+
+static void set_bit(uint64_t bytes[2], unsigned k) {
+  bytes[k / 64u] |= UINT64_C(1) << (k % 64u);
+}
+
+// ---- layouts ----------------------------------------------------------------
+static void test_layouts(void) {
+  PaxLayout l;
+  pax_layout_init(&l);
+  assert(l.n == 1 && l.start[0] == 0 && pax_col_width(&l, 0) == 128 && pax_col_width(&l, 1) == 0);
+
+  // Each field starts and ends on a boundary, gaps become columns of their own
+  assert(pax_layout_add(&l, 32, 1) == TABLE_OK);
+  assert(l.n == 3 && l.start[1] == 32 && l.start[2] == 33);
+  assert(pax_layout_add(&l, 0, 4) == TABLE_OK);
+  assert(l.n == 4 && l.start[1] == 4);
+  assert(pax_layout_add(&l, 4, 28) == TABLE_OK && l.n == 4);   // already boundaries
+  assert(pax_layout_add(&l, 120, 8) == TABLE_OK && l.n == 5);  // ends the record
+  assert(pax_col_width(&l, 0) == 4 && pax_col_width(&l, 1) == 28 && pax_col_width(&l, 2) == 1);
+  assert(pax_col_width(&l, 3) == 87 && pax_col_width(&l, 4) == 8);
+
+  // Overlapping fields split each other
+  assert(pax_layout_add(&l, 2, 4) == TABLE_OK);
+  assert(l.n == 7 && l.start[1] == 2 && l.start[2] == 4 && l.start[3] == 6);
+
+  // Fields outside the record
+  const PaxLayout before = l;
+  assert(pax_layout_add(&l, 0, 0) == TABLE_E_INVAL);
+  assert(pax_layout_add(&l, 128, 1) == TABLE_E_INVAL);
+  assert(pax_layout_add(&l, 100, 29) == TABLE_E_INVAL);
+  assert(memcmp(&l, &before, sizeof l) == 0);
+
+  // One column per byte pair stops at PAX_MAX_COLUMNS; a field that would
+  // need two more columns than fit leaves the layout as it was
+  pax_layout_init(&l);
+  for (uint16_t off = 2; l.n + 2 <= PAX_MAX_COLUMNS; off += 2)
+    assert(pax_layout_add(&l, off, 1) == TABLE_OK);
+  assert(l.n == PAX_MAX_COLUMNS - 1);
+  assert(pax_layout_add(&l, 64, 64) == TABLE_OK && l.n == PAX_MAX_COLUMNS);
+  const PaxLayout full = l;
+  assert(pax_layout_add(&l, 101, 1) == TABLE_E_FULL);
+  assert(memcmp(&l, &full, sizeof l) == 0);
+  assert(pax_layout_add(&l, 2, 1) == TABLE_OK && l.n == PAX_MAX_COLUMNS);
+}
+
+// ---- capacity, init, validation ---------------------------------------------
+static void test_capacity(void) {
+  assert(pax_capacity(PS, 1) == 31 && pax_capacity(PS, PAX_MAX_COLUMNS) == 31);
+  assert(pax_capacity(1024, 5) == 7);
+  assert(pax_capacity(TABLE_HDR_SIZE + 16, 1) == 0);
+  for (size_t ps = 512; ps <= 65536; ps *= 2) {
+    const uint16_t cap = pax_capacity(ps, PAX_MAX_COLUMNS);
+    const uint16_t leaf = (uint16_t)((ps - TABLE_HDR_SIZE - TABLE_LEAF_CRC_SIZE) / 128);
+    assert(cap <= leaf && cap + 1 >= leaf);
+  }
+
+  PaxLayout l;
+  row_layout(&l);
+  uint8_t* page = malloc(PS);
+  assert(page);
+  assert(pax_init(page, PS, &l) == TABLE_OK);
+  assert(tbl_get_kind(page) == TABLE_PAGE_KIND_PAX && tbl_get_record_size(page) == 128);
+  assert(tbl_get_capacity(page) == 31 && tbl_get_used_count(page) == 0);
+  assert(pax_validate(page, PS) == TABLE_OK);
+  assert(tbl_validate(page, PS) == TABLE_E_BADKIND);
+
+  PaxLayout back;
+  pax_layout_of(page, &back);
+  assert(back.n == 5 && memcmp(back.start, l.start, 5) == 0);
+
+  // Malformed layouts, and a page too small for one slot
+  PaxLayout bad = l;
+  bad.start[0] = 1;
+  assert(pax_init(page, PS, &bad) == TABLE_E_INVAL);
+  bad = l;
+  bad.start[3] = bad.start[2];
+  assert(pax_init(page, PS, &bad) == TABLE_E_INVAL);
+  bad.n = 0;
+  assert(pax_init(page, PS, &bad) == TABLE_E_INVAL);
+  assert(pax_init(page, 64, &l) == TABLE_E_LAYOUT);
+  free(page);
+}
+
+static void test_validate(void) {
+  PaxLayout l;
+  row_layout(&l);
+  uint8_t* page = malloc(PS);
+  uint8_t* orig = malloc(PS);
+  assert(page && orig);
+  fill(orig, &l);
+  assert(pax_validate(orig, PS) == TABLE_OK);
+  const size_t dir = TABLE_HDR_SIZE + 4;   // after the 31-slot bitmap
+
+  // Kind, record size, capacity
+  memcpy(page, orig, PS);
+  write_le_u16(page + TABLE_HDR_KIND_OFF, TABLE_PAGE_KIND_LEAF);
+  assert(pax_validate(page, PS) == TABLE_E_BADKIND);
+  memcpy(page, orig, PS);
+  write_le_u16(page + TABLE_HDR_RECORD_SIZE_OFF, 64);
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  memcpy(page, orig, PS);
+  write_le_u16(page + TABLE_HDR_CAPACITY_OFF, 30);
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  write_le_u16(page + TABLE_HDR_CAPACITY_OFF, 60000);
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+
+  // The directory
+  memcpy(page, orig, PS);
+  page[dir] = 0;
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  page[dir] = PAX_MAX_COLUMNS + 1;
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  memcpy(page, orig, PS);
+  page[dir + 1] = 4;                       // first column must start at 0
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  memcpy(page, orig, PS);
+  page[dir + 3] = page[dir + 2];           // not ascending
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  memcpy(page, orig, PS);
+  page[dir + 5] = 128;                     // past the record
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+
+  // The bitmap: against used_count, and bits past capacity
+  memcpy(page, orig, PS);
+  write_le_u16(page + TABLE_HDR_USED_COUNT_OFF, 30);
+  assert(pax_validate(page, PS) == TABLE_E_BITMAP);
+  write_le_u16(page + TABLE_HDR_USED_COUNT_OFF, 32);
+  assert(pax_validate(page, PS) == TABLE_E_LAYOUT);
+  memcpy(page, orig, PS);
+  assert(tbl_slot_mark_free(page, 3) == TABLE_OK);
+  page[TABLE_HDR_SIZE + 3] |= 0x80;        // bit 31: past the last slot
+  write_le_u16(page + TABLE_HDR_USED_COUNT_OFF, 31);
+  assert(pax_validate(page, PS) == TABLE_E_BITMAP);
+
+  assert(pax_validate(NULL, PS) == TABLE_E_INVAL && pax_validate(orig, TABLE_HDR_SIZE) == TABLE_E_INVAL);
+  free(page);
+  free(orig);
+}
+
+// ---- records and columns ----------------------------------------------------
+static void test_records(void) {
+  PaxLayout l;
+  row_layout(&l);
+  uint8_t* page = malloc(PS);
+  assert(page);
+  fill(page, &l);
+  assert(pax_validate(page, PS) == TABLE_OK && tbl_get_used_count(page) == 31);
+
+  uint8_t rec[128], want[128];
+  for (int i = 0; i < 31; i++) {
+    make_row(want, (uint32_t)i);
+    memset(rec, 0xEE, sizeof rec);
+    pax_get(page, i, rec, PAX_ALL_COLUMNS);
+    assert(memcmp(rec, want, 128) == 0);
+  }
+
+  // Only the asked columns are written: tag (0) and city (3)
+  make_row(want, 17);
+  memset(rec, 0xEE, sizeof rec);
+  pax_get(page, 17, rec, UINT64_C(1) << 0 | UINT64_C(1) << 3);
+  assert(memcmp(rec, want, 4) == 0 && memcmp(rec + 33, want + 33, 16) == 0);
+  for (int k = 4; k < 33; k++) assert(rec[k] == 0xEE);
+  for (int k = 49; k < 128; k++) assert(rec[k] == 0xEE);
+  pax_get(page, 17, rec, 0);
+  assert(rec[0] == want[0]);
+
+  // An overwrite changes that slot only
+  make_row(rec, 9000);
+  pax_put(page, 5, rec);
+  pax_get(page, 5, want, PAX_ALL_COLUMNS);
+  assert(memcmp(rec, want, 128) == 0);
+  make_row(want, 6);
+  pax_get(page, 6, rec, PAX_ALL_COLUMNS);
+  assert(memcmp(rec, want, 128) == 0);
+
+  // Field arrays: one column each, slot i at i * stride
+  size_t stride = 0;
+  const uint8_t* tags = pax_field(page, 0, 4, &stride);
+  assert(tags && stride == 4 && read_le_u32(tags + 7 * stride) == 7 && read_le_u32(tags + 5 * stride) == 9000);
+  const uint8_t* ages = pax_field(page, 32, 1, &stride);
+  assert(ages && stride == 1 && ages[12] == 32);
+  const uint8_t* names = pax_field(page, 8, 4, &stride);   // inside the name column
+  assert(names && stride == 28 && memcmp(names + 10 * stride, "10", 2) == 0);
+  const uint8_t* tail = pax_field(page, 127, 1, &stride);
+  assert(tail && stride == 79 && tail[3 * stride] == (uint8_t)(3 + 127));
+  assert(pax_field(page, 30, 4, &stride) == NULL);         // name and age
+  assert(pax_field(page, 0, 128, &stride) == NULL);
+
+  // Columns holding any of the bytes
+  uint64_t bytes[2] = { 0, 0 };
+  assert(pax_select(page, bytes) == 0);
+  set_bit(bytes, 2);
+  set_bit(bytes, 40);
+  assert(pax_select(page, bytes) == (UINT64_C(1) << 0 | UINT64_C(1) << 3));
+  set_bit(bytes, 100);
+  assert(pax_select(page, bytes) == (UINT64_C(1) << 0 | UINT64_C(1) << 3 | UINT64_C(1) << 4));
+  bytes[0] = bytes[1] = UINT64_MAX;
+  assert(pax_select(page, bytes) == 0x1F);
+
+  // The decoded image reads like a TABLE_LEAF
+  assert(tbl_slot_mark_free(page, 20) == TABLE_OK);
+  assert(pax_image_size(31) == TABLE_HDR_SIZE + 4 + 31 * 128);
+  uint8_t* img = NULL;
+  size_t img_cap = 0;
+  assert(pax_decode_buf(page, &img, &img_cap) == TABLE_OK && img_cap == pax_image_size(31));
+  assert(tbl_get_kind(img) == TABLE_PAGE_KIND_PAX && tbl_get_used_count(img) == 30);
+  assert(!tbl_slot_is_used(img, 20) && tbl_slot_is_used(img, 21));
+  assert(tbl_slot_word(img, 0) == (0x7FFFFFFFull & ~(1ull << 20)));
+  for (int i = 0; i < 31; i++) {
+    pax_get(page, i, rec, PAX_ALL_COLUMNS);
+    assert(memcmp(tbl_slot_ptr_c(img, i), rec, 128) == 0);
+  }
+  free(img);
+  free(page);
+}
+
+// ---- predicates on minipages ------------------------------------------------
+static PredTerm term(uint16_t off, uint16_t len, uint8_t type, PredOp op, const void* a, const void* b) {
+  PredTerm t;
+  memset(&t, 0, sizeof t);
+  t.off = off; t.len = len; t.type = type; t.op = (uint8_t)op;
+  memcpy(t.a, a, op == PRED_PREFIX ? strlen((const char*)a) : len);
+  if (b) memcpy(t.b, b, len);
+  if (op == PRED_PREFIX) t.n = (uint16_t)strlen((const char*)a);
+  return t;
+}
+
+// pred_filter_cols over the minipages must agree with pred_filter on the
+// decoded records
+static void check_cols(const TblPred* p, const PredTerm* terms, int n, const uint8_t* page, const uint8_t* img) {
+  const uint8_t* fields[PRED_MAX_TERMS];
+  size_t strides[PRED_MAX_TERMS];
+  for (int i = 0; i < n; i++) {
+    fields[i] = pax_field(page, terms[i].off, terms[i].len, &strides[i]);
+    assert(fields[i]);
+  }
+  const uint64_t bits = tbl_slot_word(img, 0);
+  const uint64_t want = pred_filter(p, (const uint8_t*)tbl_slot_ptr_c(img, 0), 128, 31, bits);
+  assert(pred_filter_cols(p, fields, strides, 31, bits) == want);
+  assert(pred_filter_cols(p, fields, strides, 31, bits & 0x5555) == (want & 0x5555));
+}
+
+static void test_predicates(void) {
+  PaxLayout l;
+  row_layout(&l);
+  uint8_t* page = malloc(PS);
+  assert(page);
+  fill(page, &l);
+  assert(tbl_slot_mark_free(page, 8) == TABLE_OK);
+  uint8_t* img = malloc(pax_image_size(31));
+  assert(img);
+  pax_decode(page, img);
+
+  const uint32_t lo = 5, hi = 25;
+  const uint8_t age = 30;
+  PredTerm terms[3] = {
+    term(0, 4, INDEX_KEY_U32, PRED_BETWEEN, &lo, &hi),
+    term(33, 16, INDEX_KEY_STR, PRED_PREFIX, "Pa", NULL),
+    term(32, 1, INDEX_KEY_U8, PRED_LT, &age, NULL),
+  };
+  TblPred p;
+  for (int n = 0; n <= 3; n++) {
+    pred_init(&p);
+    for (int i = 0; i < n; i++) assert(pred_add(&p, &terms[i]) == TABLE_OK);
+    check_cols(&p, terms, n, page, img);
+  }
+
+  // tag in [5, 25] and city "Pa...": tags 8 (freed), 12, 16, 20, 24
+  pred_init(&p);
+  assert(pred_add(&p, &terms[0]) == TABLE_OK && pred_add(&p, &terms[1]) == TABLE_OK);
+  const uint8_t* fields[2];
+  size_t strides[2];
+  fields[0] = pax_field(page, 0, 4, &strides[0]);
+  fields[1] = pax_field(page, 33, 16, &strides[1]);
+  const uint64_t paris = pred_filter_cols(&p, fields, strides, 31, tbl_slot_word(page, 0));
+  assert(paris == (1ull << 12 | 1ull << 16 | 1ull << 20 | 1ull << 24));
+  free(img);
+  free(page);
+}
+
+int main(void) {
+  test_layouts();
+  test_capacity();
+  test_validate();
+  test_records();
+  test_predicates();
+  printf("All PAX tests passed.\n");
+  return 0;
+}
@@ -0,0 +1,260 @@
+// tests/test_pio.c
+// Batched I/O queue: every backend writes and reads back a set of pages
+// through pio_run and through explicit submit / complete, queue-depth
+// limits, failing requests, and the pager paths built on it
+// (pager_prefetch, batched flush).
+
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "pio.h"
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+
+#define PAGE 4096u
+
+// ---- helpers ----------------------------------------------------------------
+static void fill(uint8_t* buf, size_t len, uint32_t tag) {
+  for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)(tag * 131u + i);
+}
+
+static int open_tmp(const char* path) {
+  remove(path);
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  assert(fd >= 0);
+  return fd;
+}
+
+static const PioBackend k_backends[] = { PIO_BACKEND_SYNC, PIO_BACKEND_THREADS, PIO_BACKEND_URING };
+
+// ---- tests -----------------------------------------------------------------
+static void test_run_roundtrip(PioBackend backend) {
+  const char* tmp = "tests/tmp_pio_run.bin";
+  PioQueue* q = NULL;
+  int rc = pio_open(backend, 8, &q);
+  if (backend == PIO_BACKEND_URING && rc == PAGER_E_IO) {
+    printf("  (io_uring not available here, skipped)\n");
+    return;
+  }
+  assert(rc == PAGER_OK && q);
+  assert(pio_backend(q) == backend);
+  assert(pio_depth(q) == (backend == PIO_BACKEND_SYNC ? 1u : 8u));
+
+  const int fd = open_tmp(tmp);
+  enum { N = 100 };
+  uint8_t* data = malloc((size_t)N * PAGE);
+  uint8_t* back = calloc(N, PAGE);
+  PioReq reqs[N];
+  assert(data && back);
+
+  // Written in reverse order, more requests than the depth
+  for (int i = 0; i < N; i++) {
+    fill(data + (size_t)i * PAGE, PAGE, (uint32_t)i);
+    const int page = N - 1 - i;
+    reqs[i] = (PioReq){ .fd = fd, .write = true, .buf = data + (size_t)i * PAGE,
+                        .len = PAGE, .off = (off_t)page * PAGE };
+  }
+  assert(pio_run(q, reqs, N) == PAGER_OK);
+  for (int i = 0; i < N; i++) assert(reqs[i].result == PAGER_OK);
+
+  for (int i = 0; i < N; i++)
+    reqs[i] = (PioReq){ .fd = fd, .buf = back + (size_t)i * PAGE, .len = PAGE,
+                        .off = (off_t)(N - 1 - i) * PAGE };
+  assert(pio_run(q, reqs, N) == PAGER_OK);
+  assert(memcmp(data, back, (size_t)N * PAGE) == 0);
+  assert(pio_inflight(q) == 0);
+
+  free(data);
+  free(back);
+  close(fd);
+  pio_close(q);
+  remove(tmp);
+}
+
+static void test_submit_complete(PioBackend backend) {
+  const char* tmp = "tests/tmp_pio_queue.bin";
+  PioQueue* q = NULL;
+  if (pio_open(backend, 4, &q) != PAGER_OK) return;   // io_uring: see above
+
+  const int fd = open_tmp(tmp);
+  uint8_t bufs[4][PAGE];
+  PioReq reqs[5];
+  const unsigned depth = pio_depth(q);
+  for (unsigned i = 0; i < depth; i++) {
+    fill(bufs[i], PAGE, 100 + i);
+    reqs[i] = (PioReq){ .fd = fd, .write = true, .buf = bufs[i], .len = PAGE,
+                        .off = (off_t)i * PAGE, .user_data = &bufs[i] };
+    assert(pio_submit(q, &reqs[i]) == PAGER_OK);
+  }
+  assert(pio_inflight(q) == depth);
+
+  // The queue is full until something is reaped
+  reqs[4] = (PioReq){ .fd = fd, .write = true, .buf = bufs[0], .len = PAGE, .off = 0 };
+  assert(pio_submit(q, &reqs[4]) == PAGER_E_INVAL);
+  assert(pio_run(q, reqs, 1) == PAGER_E_INVAL && "pio_run wants an idle queue");
+
+  unsigned seen = 0;
+  for (unsigned i = 0; i < depth; i++) {
+    PioReq* done = NULL;
+    assert(pio_complete(q, &done) == PAGER_OK && done);
+    assert(done->result == PAGER_OK && done->user_data == done->buf);
+    seen |= 1u << (done - reqs);
+  }
+  assert(seen == (1u << depth) - 1u && "every request handed back once");
+  PioReq* none = NULL;
+  assert(pio_complete(q, &none) == PAGER_E_INVAL);
+
+  // Failing requests: a read past the end of the file, a bad descriptor
+  uint8_t buf[PAGE];
+  PioReq bad[2] = {
+    { .fd = fd, .buf = buf, .len = PAGE, .off = (off_t)64 * PAGE },
+    { .fd = -1, .buf = buf, .len = PAGE, .off = 0 },
+  };
+  assert(pio_run(q, bad, 2) == PAGER_E_IO);
+  assert(bad[0].result == PAGER_E_IO && bad[1].result == PAGER_E_IO);
+
+  // A read across the end of the file fails too, a read just before it works
+  PioReq edge = { .fd = fd, .buf = buf, .len = PAGE, .off = (off_t)depth * PAGE - 100 };
+  assert(pio_run(q, &edge, 1) == PAGER_E_IO);
+  edge.off = (off_t)(depth - 1) * PAGE;
+  assert(pio_run(q, &edge, 1) == PAGER_OK && memcmp(buf, bufs[depth - 1], PAGE) == 0);
+
+  close(fd);
+  pio_close(q);
+  remove(tmp);
+}
+
+static void test_open_args(void) {
+  PioQueue* q = NULL;
+  assert(pio_open(PIO_BACKEND_THREADS, 0, &q) == PAGER_E_INVAL);
+  assert(pio_open(PIO_BACKEND_THREADS, PIO_MAX_DEPTH + 1, &q) == PAGER_E_INVAL);
+  assert(pio_open((PioBackend)42, 4, &q) == PAGER_E_INVAL);
+  assert(pio_open(PIO_BACKEND_AUTO, 16, &q) == PAGER_OK && q);
+  assert(pio_backend(q) != PIO_BACKEND_AUTO);
+  printf("  auto backend: %s\n", pio_backend_name(pio_backend(q)));
+  pio_close(q);
+
+  PagerConfig cfg = {0};
+  cfg.io_depth = PIO_MAX_DEPTH + 1;
+  Pager* p = NULL;
+  assert(pager_open_ex("tests/tmp_pio_args.db", &cfg, &p) == PAGER_E_INVAL);
+  remove("tests/tmp_pio_args.db");
+}
+
+static void test_pager_prefetch(PioBackend backend) {
+  const char* tmp = "tests/tmp_pio_prefetch.db";
+  remove(tmp);
+  PagerConfig cfg = {0};
+  cfg.io_backend = backend;
+  cfg.cache_pages = 64;
+  Pager* p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+
+  // 200 pages written through the pool: more than it holds, so the flush
+  // at close pushes out a batch and evictions the rest
+  enum { N = 200 };
+  uint32_t first = 0;
+  assert(pager_alloc_pages(p, N, &first) == PAGER_OK && first == 1);
+  for (uint32_t i = 0; i < N; i++) {
+    void* buf = NULL;
+    assert(pager_pin_zero(p, first + i, &buf) == PAGER_OK);
+    fill(buf, PAGE, first + i);
+    assert(pager_unpin(p, buf, true) == PAGER_OK);
+  }
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  uint32_t pages[N + 2];
+  for (uint32_t i = 0; i < N; i++) pages[i] = first + i;
+  pages[N] = 0;            // skipped: header
+  pages[N + 1] = 100000;   // skipped: past page_count
+  assert(pager_prefetch(p, pages + N, 2) == PAGER_OK);
+  assert(pager_prefetch(p, NULL, 0) == PAGER_OK);
+  assert(pager_prefetch(NULL, pages, 1) == PAGER_E_INVAL);
+
+  // Prefetched pages come from the pool: overwrite them in the file behind
+  // the pager's back and the cached images still show up
+  const size_t window = pager_io_depth(p) < 16 ? pager_io_depth(p) : 16;
+  assert(pager_prefetch(p, pages, window) == PAGER_OK);
+  const int fd = open(tmp, O_RDWR);
+  assert(fd >= 0);
+  uint8_t junk[PAGE];
+  memset(junk, 0xEE, sizeof junk);
+  for (size_t i = 0; i <= window; i++)
+    assert(pwrite(fd, junk, PAGE, (off_t)pages[i] * PAGE) == (ssize_t)PAGE);
+  close(fd);
+
+  uint8_t want[PAGE];
+  for (size_t i = 0; i < window; i++) {
+    const void* buf = NULL;
+    assert(pager_pin(p, pages[i], &buf) == PAGER_OK);
+    fill(want, PAGE, pages[i]);
+    assert(memcmp(buf, want, PAGE) == 0);
+    assert(pager_unpin(p, buf, false) == PAGER_OK);
+  }
+  // The next page was not prefetched: it reads the file
+  const void* buf = NULL;
+  assert(pager_pin(p, pages[window], &buf) == PAGER_OK);
+  assert(memcmp(buf, junk, PAGE) == 0);
+  assert(pager_unpin(p, buf, false) == PAGER_OK);
+
+  // A window larger than a quarter of the pool is cut short, not an error
+  assert(pager_prefetch(p, pages + 20, N - 20) == PAGER_OK);
+  pager_close(p);
+  remove(tmp);
+}
+
+static int count_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec; (void)id;
+  (*(uint64_t*)ud)++;
+  return 0;
+}
+
+static void test_scan_read_ahead(PioBackend backend) {
+  const char* tmp = "tests/tmp_pio_scan.db";
+  remove(tmp);
+  PagerConfig cfg = {0};
+  cfg.io_backend = backend;
+  cfg.cache_pages = 64;
+  Pager* p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  assert(tblmgr_create(p, 1) == TABLE_OK);
+
+  const size_t N = 20000;   // ~650 leaves, ten times the pool
+  uint8_t* recs = calloc(N, TABLE_RECORD_SIZE);
+  assert(recs);
+  assert(tblmgr_insert_batch(p, 1, recs, N, NULL) == TABLE_OK);
+  free(recs);
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  uint64_t n = 0;
+  assert(tblmgr_scan(p, 1, count_cb, &n) == TABLE_OK && n == N);
+  n = 0;
+  TblParallelScan opts = { .threads = 1, .callback = count_cb, .user_data = &n };
+  assert(tblmgr_scan_parallel(p, 1, &opts) == TABLE_OK && n == N);
+  assert(tblmgr_validate_all(p, 1) == TABLE_OK);
+  pager_close(p);
+  remove(tmp);
+}
+
+int main(void) {
+  test_open_args();
+  for (size_t i = 0; i < sizeof k_backends / sizeof k_backends[0]; i++) {
+    printf("  backend %s\n", pio_backend_name(k_backends[i]));
+    test_run_roundtrip(k_backends[i]);
+    test_submit_complete(k_backends[i]);
+    test_pager_prefetch(k_backends[i]);
+    test_scan_read_ahead(k_backends[i]);
+  }
+  printf("All pio tests passed.\n");
+  return 0;
+}
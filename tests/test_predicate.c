@@ -0,0 +1,258 @@
+// tests/test_predicate.c
+// Scan predicates: term compilation and its errors, the word-at-a-time
+// filter against the one-record test, and filtered table scans
+// (tblmgr_scan_where, parallel scans with a predicate) on pages of more
+// than one bitmap word.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+#include "index_key.h"
+#include "predicate.h"
+
+// ---- helpers ----------------------------------------------------------------
+// Layout: tag u32 @0, age u8 @4, code u16 @6, name s[16] @8, city s[16] @24
+static const char* const k_cities[] = { "Paris", "Pau", "Lyon", "Tokyo" };
+
+static void make_record(uint8_t rec[128], uint32_t tag) {
+  memset(rec, 0, 128);
+  rec[0] = (uint8_t)tag; rec[1] = (uint8_t)(tag >> 8); rec[2] = (uint8_t)(tag >> 16); rec[3] = (uint8_t)(tag >> 24);
+  rec[4] = (uint8_t)(tag % 100);
+  const uint16_t code = (uint16_t)(tag * 7u);
+  rec[6] = (uint8_t)code; rec[7] = (uint8_t)(code >> 8);
+  snprintf((char*)rec + 8, 16, "user%05u", tag);
+  memcpy(rec + 24, k_cities[tag % 4], strlen(k_cities[tag % 4]));
+}
+
+static uint32_t rec_tag(const uint8_t* rec) {
+  return (uint32_t)rec[0] | ((uint32_t)rec[1] << 8) | ((uint32_t)rec[2] << 16) | ((uint32_t)rec[3] << 24);
+}
+
+static PredTerm term_num(uint16_t off, uint16_t len, PredOp op, uint32_t a, uint32_t b) {
+  PredTerm t;
+  memset(&t, 0, sizeof t);
+  t.off = off; t.len = len; t.op = (uint8_t)op;
+  t.type = len == 1 ? INDEX_KEY_U8 : len == 2 ? INDEX_KEY_U16 : INDEX_KEY_U32;
+  for (uint16_t i = 0; i < len; i++) { t.a[i] = (uint8_t)(a >> (8 * i)); t.b[i] = (uint8_t)(b >> (8 * i)); }
+  return t;
+}
+
+static PredTerm term_str(uint16_t off, uint16_t len, PredOp op, const char* a, const char* b) {
+  PredTerm t;
+  memset(&t, 0, sizeof t);
+  t.off = off; t.len = len; t.op = (uint8_t)op; t.type = INDEX_KEY_STR;
+  memcpy(t.a, a, strlen(a));
+  if (b) memcpy(t.b, b, strlen(b));
+  if (op == PRED_PREFIX) t.n = (uint16_t)strlen(a);
+  return t;
+}
+
+static void add(TblPred* p, PredTerm t) {
+  assert(pred_add(p, &t) == TABLE_OK);
+}
+
+// pred_filter over recs[0..n) must agree with pred_match on each record
+static uint64_t filter_checked(const TblPred* p, const uint8_t* recs, unsigned n) {
+  const uint64_t all = n == 64 ? ~UINT64_C(0) : (UINT64_C(1) << n) - 1u;
+  const uint64_t bits = pred_filter(p, recs, 128, n, all);
+  for (unsigned j = 0; j < n; j++)
+    assert(((bits >> j) & 1u) == (uint64_t)pred_match(p, recs + (size_t)j * 128));
+  // Records left out of the input mask never come back
+  assert((pred_filter(p, recs, 128, n, all & 0x5555555555555555ull) & ~0x5555555555555555ull) == 0);
+  return bits;
+}
+
+// ---- tests -----------------------------------------------------------------
+static void test_compile(void) {
+  TblPred p;
+  pred_init(&p);
+  PredTerm t = term_num(126, 4, PRED_EQ, 1, 0);                 // past the record
+  assert(pred_add(&p, &t) == TABLE_E_INVAL);
+  t = term_num(4, 1, PRED_EQ, 1, 0); t.len = 2;                  // u8 of 2 bytes
+  assert(pred_add(&p, &t) == TABLE_E_INVAL);
+  t = term_num(4, 1, PRED_PREFIX, 1, 0); t.n = 1;                // prefix on an integer
+  assert(pred_add(&p, &t) == TABLE_E_INVAL);
+  t = term_str(8, 16, PRED_PREFIX, "user", NULL); t.n = 17;      // prefix longer than the field
+  assert(pred_add(&p, &t) == TABLE_E_INVAL);
+  t = term_str(8, 16, PRED_EQ, "x", NULL); t.op = 42;            // unknown op
+  assert(pred_add(&p, &t) == TABLE_E_INVAL);
+  assert(pred_add(NULL, &t) == TABLE_E_INVAL && pred_add(&p, NULL) == TABLE_E_INVAL);
+  assert(p.n == 0);
+
+  for (int i = 0; i < PRED_MAX_TERMS; i++) add(&p, term_num(4, 1, PRED_LT, 200, 0));
+  t = term_num(4, 1, PRED_LT, 200, 0);
+  assert(pred_add(&p, &t) == TABLE_E_FULL);
+
+  // An empty or absent predicate matches everything
+  uint8_t rec[128];
+  make_record(rec, 7);
+  pred_init(&p);
+  assert(pred_match(&p, rec) && pred_match(NULL, rec));
+  assert(pred_filter(&p, rec, 128, 1, 1u) == 1u && pred_filter(NULL, rec, 128, 1, 1u) == 1u);
+}
+
+static void test_filter(void) {
+  enum { N = 64 };
+  uint8_t* recs = malloc((size_t)N * 128);
+  assert(recs);
+  for (uint32_t i = 0; i < N; i++) make_record(recs + (size_t)i * 128, 1000 + i);
+
+  TblPred p;
+  // Integers of each width: =, <, >, BETWEEN
+  pred_init(&p); add(&p, term_num(4, 1, PRED_EQ, 10, 0));
+  assert(filter_checked(&p, recs, N) == UINT64_C(1) << 10);
+  pred_init(&p); add(&p, term_num(4, 1, PRED_LT, 5, 0));
+  assert(filter_checked(&p, recs, N) == 0x1Fu);
+  pred_init(&p); add(&p, term_num(0, 4, PRED_GT, 1060, 0));
+  assert(filter_checked(&p, recs, N) == UINT64_C(0x7) << 61);
+  pred_init(&p); add(&p, term_num(6, 2, PRED_BETWEEN, 7000, 7069));
+  assert(filter_checked(&p, recs, N) == 0x3FFu);
+
+  // Bounds that no value passes
+  pred_init(&p); add(&p, term_num(4, 1, PRED_LT, 0, 0));
+  assert(filter_checked(&p, recs, N) == 0 && p.never);
+  pred_init(&p); add(&p, term_num(4, 1, PRED_GT, 255, 0));
+  assert(filter_checked(&p, recs, N) == 0);
+  pred_init(&p); add(&p, term_num(0, 4, PRED_BETWEEN, 1050, 1040));
+  assert(filter_checked(&p, recs, N) == 0);
+  pred_init(&p); add(&p, term_num(0, 4, PRED_GT, 0, 0)); add(&p, term_num(0, 4, PRED_LT, UINT32_MAX, 0));
+  assert(filter_checked(&p, recs, N) == ~UINT64_C(0));
+
+  // Strings: prefix, equality on the padded field, memcmp order
+  pred_init(&p); add(&p, term_str(24, 16, PRED_PREFIX, "Pa", NULL));
+  assert(filter_checked(&p, recs, N) == 0x3333333333333333ull);
+  pred_init(&p); add(&p, term_str(24, 16, PRED_EQ, "Pau", NULL));
+  assert(filter_checked(&p, recs, N) == 0x2222222222222222ull);
+  pred_init(&p); add(&p, term_str(24, 16, PRED_LT, "Paris", NULL));
+  assert(filter_checked(&p, recs, N) == 0x4444444444444444ull);    // Lyon
+  pred_init(&p); add(&p, term_str(24, 16, PRED_GT, "Pau", NULL));
+  assert(filter_checked(&p, recs, N) == 0x8888888888888888ull);    // Tokyo
+  pred_init(&p); add(&p, term_str(8, 16, PRED_BETWEEN, "user01010", "user01019"));
+  assert(filter_checked(&p, recs, N) == UINT64_C(0x3FF) << 10);
+
+  // Terms are ANDed
+  pred_init(&p);
+  add(&p, term_str(24, 16, PRED_PREFIX, "Pa", NULL));
+  add(&p, term_num(4, 1, PRED_BETWEEN, 20, 39));
+  assert(filter_checked(&p, recs, N) == (0x3333333333333333ull & (UINT64_C(0xFFFFF) << 20)));
+
+  // Fewer records than a word: bits past nrec are dropped
+  pred_init(&p); add(&p, term_num(4, 1, PRED_LT, 200, 0));
+  assert(pred_filter(&p, recs, 128, 31, ~UINT64_C(0)) == (UINT64_C(1) << 31) - 1u);
+  assert(pred_filter(&p, recs, 128, 0, ~UINT64_C(0)) == 0);
+  free(recs);
+}
+
+typedef struct {
+  uint64_t ids[4096];
+  size_t   n;
+  size_t   stop_after;   // 0 = never
+} Collect;
+
+static int collect_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec;
+  Collect* c = (Collect*)ud;
+  assert(c->n < sizeof c->ids / sizeof c->ids[0]);
+  c->ids[c->n++] = id;
+  return c->stop_after && c->n == c->stop_after ? 42 : 0;
+}
+
+typedef struct {
+  const TblPred* pred;
+  Collect*       out;
+} RefCtx;
+
+static int reference_cb(const void* rec, uint64_t id, void* ud) {
+  RefCtx* r = (RefCtx*)ud;
+  return pred_match(r->pred, rec) ? collect_cb(rec, id, r->out) : 0;
+}
+
+static void expect_same(Pager* p, uint32_t root, const TblPred* pred) {
+  static Collect want, got, par;
+  memset(&want, 0, sizeof want);
+  memset(&got, 0, sizeof got);
+  memset(&par, 0, sizeof par);
+  RefCtx ref = { .pred = pred, .out = &want };
+  assert(tblmgr_scan(p, root, reference_cb, &ref) == TABLE_OK);
+  assert(tblmgr_scan_where(p, root, pred, collect_cb, &got) == TABLE_OK);
+  assert(got.n == want.n && memcmp(got.ids, want.ids, want.n * sizeof want.ids[0]) == 0);
+
+  // One worker keeps the order, and the parallel path filters the same way
+  TblParallelScan opts = { .threads = 1, .callback = collect_cb, .user_data = &par, .where = pred };
+  assert(tblmgr_scan_parallel(p, root, &opts) == TABLE_OK);
+  assert(par.n == want.n && memcmp(par.ids, want.ids, want.n * sizeof want.ids[0]) == 0);
+}
+
+static void test_scan_where(void) {
+  const char* tmp = "tests/tmp_predicate.db";
+  remove(tmp);
+  PagerConfig cfg = {0};
+  cfg.page_size = 16384;   // 127 slots: two bitmap words per leaf
+  Pager* p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  const uint32_t root = 1;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  enum { N = 1000 };
+  uint8_t* recs = malloc((size_t)N * 128);
+  uint64_t* ids = malloc(N * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) make_record(recs + (size_t)i * 128, i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  // Holes in both words of several leaves
+  for (uint32_t i = 0; i < N; i += 3) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+
+  TblPred pred;
+  pred_init(&pred);
+  expect_same(p, root, &pred);
+  expect_same(p, root, NULL);
+
+  add(&pred, term_num(4, 1, PRED_BETWEEN, 10, 19));
+  expect_same(p, root, &pred);
+  add(&pred, term_str(24, 16, PRED_PREFIX, "Pa", NULL));
+  expect_same(p, root, &pred);
+
+  // Expected rows: live (i % 3 != 0), age 10..19, city Paris or Pau
+  size_t expected = 0;
+  for (uint32_t i = 0; i < N; i++)
+    if (i % 3 != 0 && i % 100 >= 10 && i % 100 <= 19 && i % 4 < 2) expected++;
+  Collect* got = calloc(1, sizeof *got);
+  assert(got);
+  assert(tblmgr_scan_where(p, root, &pred, collect_cb, got) == TABLE_OK && got->n == expected);
+  for (size_t k = 0; k < got->n; k++) {
+    uint8_t rec[128];
+    assert(tblmgr_get(p, got->ids[k], rec) == TABLE_OK && pred_match(&pred, rec));
+    const uint32_t tag = rec_tag(rec);
+    assert(tag % 3 != 0 && tag % 100 >= 10 && tag % 100 <= 19 && tag % 4 < 2);
+  }
+
+  // A callback's non-zero return stops the scan and is returned
+  memset(got, 0, sizeof *got);
+  got->stop_after = 2;
+  assert(tblmgr_scan_where(p, root, &pred, collect_cb, got) == 42 && got->n == 2);
+
+  pred_init(&pred);
+  add(&pred, term_num(0, 4, PRED_GT, N, 0));
+  expect_same(p, root, &pred);
+  assert(tblmgr_scan_where(NULL, root, &pred, collect_cb, got) == TABLE_E_INVAL);
+  assert(tblmgr_scan_where(p, root, &pred, NULL, got) == TABLE_E_INVAL);
+
+  free(got);
+  free(recs);
+  free(ids);
+  pager_close(p);
+  remove(tmp);
+}
+
+int main(void) {
+  test_compile();
+  test_filter();
+  test_scan_where();
+  printf("All predicate tests passed.\n");
+  return 0;
+}
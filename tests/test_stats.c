@@ -0,0 +1,178 @@
+// tests/test_stats.c
+// Engine statistics: per-thread counters added up across live and exited
+// threads, reset, histogram buckets and quantiles, the timing switch, and
+// what the pager and table manager count for a small workload.
+
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "stats.h"
+#include "pager.h"
+#include "table.h"
+#include "table_manager.h"
+
+#ifndef STATS_DISABLED
+static uint64_t counter(StatCounter c) {
+  Stats st;
+  stats_read(&st);
+  return st.counters[c];
+}
+
+// ---- threads ----------------------------------------------------------------
+enum { THREADS = 4, PER_THREAD = 1000 };
+
+typedef struct {
+  pthread_barrier_t counted, done;
+} ThreadSync;
+
+static void* counting_thread(void* arg) {
+  ThreadSync* sync = (ThreadSync*)arg;
+  for (int i = 0; i < PER_THREAD; i++) stats_add(STAT_INSERTS, 1);
+  stats_add(STAT_BYTES_READ, 7);
+  pthread_barrier_wait(&sync->counted);
+  pthread_barrier_wait(&sync->done);   // stay alive until main has read
+  return NULL;
+}
+
+static void test_threads(void) {
+  stats_reset();
+  ThreadSync sync;
+  pthread_barrier_init(&sync.counted, NULL, THREADS + 1);
+  pthread_barrier_init(&sync.done, NULL, THREADS + 1);
+  pthread_t t[THREADS];
+  for (int i = 0; i < THREADS; i++) assert(pthread_create(&t[i], NULL, counting_thread, &sync) == 0);
+
+  // Live blocks, then the same totals once the threads have exited
+  pthread_barrier_wait(&sync.counted);
+  assert(counter(STAT_INSERTS) == THREADS * PER_THREAD);
+  assert(counter(STAT_BYTES_READ) == THREADS * 7);
+  pthread_barrier_wait(&sync.done);
+  for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+  assert(counter(STAT_INSERTS) == THREADS * PER_THREAD);
+
+  stats_add(STAT_INSERTS, 5);
+  assert(counter(STAT_INSERTS) == THREADS * PER_THREAD + 5);
+  pthread_barrier_destroy(&sync.counted);
+  pthread_barrier_destroy(&sync.done);
+}
+
+static void test_reset(void) {
+  stats_add(STAT_EVICTIONS, 3);
+  stats_reset();
+  Stats st;
+  stats_read(&st);
+  for (int c = 0; c < STAT_COUNTERS; c++) assert(st.counters[c] == 0);
+  for (int h = 0; h < STAT_HISTS; h++) assert(st.hists[h].count == 0);
+  stats_add(STAT_EVICTIONS, 2);
+  assert(counter(STAT_EVICTIONS) == 2);
+  assert(strcmp(stats_counter_name(STAT_CACHE_HITS), "cache_hits") == 0);
+  assert(strcmp(stats_hist_name(STAT_H_VALIDATE), "validate") == 0);
+}
+
+static void test_histograms(void) {
+  stats_reset();
+  stats_set_timing(false);
+  assert(stats_start() == 0);
+  stats_stop(STAT_H_INSERT, 0);
+
+  stats_set_timing(true);
+  const uint64_t t0 = stats_start();
+  assert(t0 != 0);
+  stats_stop(STAT_H_INSERT, t0);
+  stats_set_timing(false);
+
+  // 99 samples in [512, 1024) ns, one in [2^19, 2^20)
+  stats_add(STAT_INSERTS, 0);   // makes sure this thread has a block
+  for (int i = 0; i < 99; i++) stats_hist_add(stats_tls, STAT_H_VALIDATE, 1000);
+  stats_hist_add(stats_tls, STAT_H_VALIDATE, 1000000);
+  Stats st;
+  stats_read(&st);
+  assert(st.hists[STAT_H_INSERT].count == 1);
+  const StatsHistogram* h = &st.hists[STAT_H_VALIDATE];
+  assert(h->count == 100 && h->total_ns == 99 * 1000 + 1000000);
+  assert(h->buckets[9] == 99 && h->buckets[19] == 1);
+  assert(stats_quantile(h, 0.5) == 1024 && stats_quantile(h, 0.99) == 1024);
+  assert(stats_quantile(h, 1.0) == (1u << 20));
+  StatsHistogram empty = { 0 };
+  assert(stats_quantile(&empty, 0.5) == 0);
+}
+
+// ---- what the engine counts -------------------------------------------------
+static void test_engine_counters(void) {
+  const char* tmp = "tests/tmp_stats.db";
+  remove(tmp);
+  Pager* p = NULL;
+  PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+
+  enum { LEAVES = 40, N = LEAVES * 31 };
+  uint8_t* recs = calloc(N, TABLE_RECORD_SIZE);
+  assert(recs);
+  for (uint32_t i = 0; i < N; i++) memcpy(recs + (size_t)i * TABLE_RECORD_SIZE, &i, sizeof i);
+
+  const uint32_t root = pager_page_count(p);
+  stats_reset();
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  for (uint32_t i = 0; i < N; i += 31)
+    assert(tblmgr_insert_batch(p, root, recs + (size_t)i * TABLE_RECORD_SIZE, 31, NULL) == TABLE_OK);
+  assert(pager_flush(p) == PAGER_OK);
+
+  Stats st;
+  stats_read(&st);
+  const size_t ps = pager_page_size(p);
+  assert(st.counters[STAT_INSERTS] == N);
+  assert(st.counters[STAT_INSERT_PAGES] >= LEAVES);   // the root, then one leaf per batch
+  assert(st.counters[STAT_PAGE_ALLOCS] >= LEAVES - 1);
+  assert(st.counters[STAT_CACHE_HITS] > 0);
+  assert(st.counters[STAT_EVICTIONS] > 0 && "the pool cannot hold every leaf");
+  assert(st.counters[STAT_FILE_WRITES] > 0 && st.counters[STAT_BYTES_WRITTEN] % ps == 0);
+  pager_close(p);
+
+  // A cold scan loads, checksums and validates every leaf once
+  p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK);
+  stats_reset();
+  uint64_t count = 0;
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == N);
+  stats_read(&st);
+  assert(st.counters[STAT_CACHE_MISSES] >= LEAVES && st.counters[STAT_FILE_READS] >= LEAVES);
+  assert(st.counters[STAT_BYTES_READ] >= LEAVES * ps);
+  assert(st.counters[STAT_CHECKSUMS] >= LEAVES && st.counters[STAT_CHECKSUM_ERRORS] == 0);
+  assert(st.counters[STAT_LEAF_VALIDATIONS] >= LEAVES);
+  assert(st.counters[STAT_INSERTS] == 0);
+
+  uint8_t* page = malloc(ps);
+  assert(page);
+  const uint64_t reads = counter(STAT_PAGE_READS), writes = counter(STAT_PAGE_WRITES);
+  assert(pager_read(p, root, page) == PAGER_OK && pager_write(p, root, page) == PAGER_OK);
+  assert(counter(STAT_PAGE_READS) == reads + 1 && counter(STAT_PAGE_WRITES) == writes + 1);
+  pager_close(p);
+  free(page);
+  free(recs);
+  remove(tmp);
+}
+
+#endif // STATS_DISABLED
+
+int main(void) {
+#ifdef STATS_DISABLED
+  Stats st;
+  stats_add(STAT_INSERTS, 1);
+  stats_read(&st);
+  assert(!stats_enabled() && st.counters[STAT_INSERTS] == 0);
+  printf("Stats compiled out (STATS=0): nothing to count.\n");
+#else
+  assert(stats_enabled());
+  test_threads();
+  test_reset();
+  test_histograms();
+  test_engine_counters();
+  printf("All stats tests passed.\n");
+#endif
+  return 0;
+}
@@ -1,5 +1,6 @@
 // tests/test_table.c
-// Unit tests for table leaf page: init, validate, bitmap invariants, find_free.
+// Unit tests for table leaf page: init, validate, bitmap invariants, find_free,
+// used-slot iterator.
 
 #include <assert.h>
 #include <stdint.h>
@@ -7,6 +8,7 @@
 #include <string.h>
 
 #include "../src/table.h"
+#include "../src/fsm.h"
 #include "../src/endian_util.h"
 
 #ifndef TABLE_PAGE_SIZE
@@ -27,9 +29,9 @@ static inline void hdr_set_u16(uint8_t* page, size_t off, uint16_t v) {
 
 static void test_init_and_validate_ok(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    int rc = tbl_init_leaf(page, TABLE_RECORD_SIZE);
+    int rc = tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE);
     assert(rc == TABLE_OK && "tbl_init_leaf should succeed for V1");
-    assert(tbl_validate(page) == TABLE_OK && "validate must pass after init");
+    assert(tbl_validate(page, TABLE_PAGE_SIZE) == TABLE_OK && "validate must pass after init");
 
     // Capacity should be >0 (spec V1: 31 for record_size=128)
     uint16_t cap = hdr_get_u16(page, TABLE_HDR_CAPACITY_OFF);
@@ -38,7 +40,7 @@ static void test_init_and_validate_ok(void) {
 
 static void test_find_free_basic(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     // On empty page, first free is 0
     int idx = tbl_slot_find_free(page);
@@ -57,20 +59,20 @@ static void test_find_free_basic(void) {
 
 static void test_validate_popcount_mismatch(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     // Set two bits in bitmap but lie in used_count (=1)
     uint8_t* bm = page_bitmap(page);
     bm[0] |= 0x03; // bits 0 and 1
     hdr_set_u16(page, TABLE_HDR_USED_COUNT_OFF, 1);
 
-    int rc = tbl_validate(page);
+    int rc = tbl_validate(page, TABLE_PAGE_SIZE);
     assert(rc == TABLE_E_BITMAP && "validate must fail when popcount != used_count");
 }
 
 static void test_validate_last_byte_extra_bits(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     // Compute capacity & bitmap size
     uint16_t cap = hdr_get_u16(page, TABLE_HDR_CAPACITY_OFF);
@@ -83,7 +85,7 @@ static void test_validate_last_byte_extra_bits(void) {
         // Example: for valid_bits_last=7, set bit7 (10000000)
         bm[bm_bytes - 1] |= (uint8_t)(0xFFu << valid_bits_last);
         // Keep used_count unchanged → validate should flag E_BITMAP due to invalid MSB bits
-        int rc = tbl_validate(page);
+        int rc = tbl_validate(page, TABLE_PAGE_SIZE);
         assert(rc == TABLE_E_BITMAP && "invalid MSB beyond capacity must fail validation");
     } else {
         // If cap is multiple of 8, nothing to test here
@@ -93,7 +95,7 @@ static void test_validate_last_byte_extra_bits(void) {
 
 static void test_find_free_full_page(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     uint16_t cap = hdr_get_u16(page, TABLE_HDR_CAPACITY_OFF);
     size_t bm_bytes = (cap + 7u) / 8u;
@@ -112,14 +114,14 @@ static void test_find_free_full_page(void) {
     hdr_set_u16(page, TABLE_HDR_USED_COUNT_OFF, cap);
 
     // Validate OK then find_free must return -1
-    assert(tbl_validate(page) == TABLE_OK);
+    assert(tbl_validate(page, TABLE_PAGE_SIZE) == TABLE_OK);
     int idx = tbl_slot_find_free(page);
     assert(idx == -1 && "no free slot when all valid bits are 1");
 }
 
 static void test_mark_used_basic_and_twice(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     // slot 0 free → mark_used OK
     int rc = tbl_slot_mark_used(page, 0);
@@ -136,7 +138,7 @@ static void test_mark_used_basic_and_twice(void) {
 
 static void test_mark_used_last_slot_and_full(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     uint16_t cap = read_le_u16(page + TABLE_HDR_CAPACITY_OFF);
 
@@ -155,7 +157,7 @@ static void test_mark_used_last_slot_and_full(void) {
 
 static void test_mark_free_basic_and_twice(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     // Pose un slot puis libère-le
     assert(tbl_slot_mark_used(page, 3) == TABLE_OK);
@@ -172,14 +174,14 @@ static void test_mark_free_basic_and_twice(void) {
 
 static void test_mark_free_when_empty(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
     // used == 0 → libérer n’importe quel idx valide doit échouer
     assert(tbl_slot_mark_free(page, 0) == TABLE_E_INVAL);
 }
 
 static void test_slot_ptr_addresses(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     uint16_t cap = read_le_u16(page + TABLE_HDR_CAPACITY_OFF);
     uint16_t rec = read_le_u16(page + TABLE_HDR_RECORD_SIZE_OFF);
@@ -204,7 +206,7 @@ static void test_slot_ptr_addresses(void) {
 
 static void test_getters_basic(void) {
     uint8_t page[TABLE_PAGE_SIZE];
-    assert(tbl_init_leaf(page, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
 
     // Les getters doivent refléter les champs header
     assert(tbl_get_record_size(page) == TABLE_RECORD_SIZE);
@@ -222,6 +224,102 @@ static void test_getters_basic(void) {
     assert(tbl_get_next_page(page) == 42);
 }
 
+static void test_slot_iter_and_find_free_words(void) {
+    uint8_t page[TABLE_PAGE_SIZE];
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
+    uint16_t cap = tbl_get_capacity(page);
+
+    // Empty page: nothing to visit
+    TblSlotIter it;
+    tbl_slot_iter_init(&it, page);
+    assert(tbl_slot_iter_next(&it) == -1);
+
+    // Sparse pattern including the first and the last slot
+    const int used[] = { 0, 7, 8, 13, cap - 1 };
+    for (size_t i = 0; i < sizeof used / sizeof used[0]; i++)
+        assert(tbl_slot_mark_used(page, used[i]) == TABLE_OK);
+    assert(tbl_validate(page, TABLE_PAGE_SIZE) == TABLE_OK);
+
+    tbl_slot_iter_init(&it, page);
+    for (size_t i = 0; i < sizeof used / sizeof used[0]; i++)
+        assert(tbl_slot_iter_next(&it) == used[i]);
+    assert(tbl_slot_iter_next(&it) == -1);
+    assert(tbl_slot_iter_next(&it) == -1 && "stays exhausted");
+
+    // Same answer as probing every slot
+    size_t visited = 0;
+    tbl_slot_iter_init(&it, page);
+    for (int i = 0; i < cap; i++) {
+        if (tbl_slot_is_used(page, i)) {
+            assert(tbl_slot_iter_next(&it) == i);
+            visited++;
+        }
+    }
+    assert(visited == tbl_get_used_count(page));
+
+    // First free slot after the used slot 0
+    assert(tbl_slot_find_free(page) == 1);
+    for (int i = 1; i < 7; i++) assert(tbl_slot_mark_used(page, i) == TABLE_OK);
+    assert(tbl_slot_find_free(page) == 9);
+
+    // Only the last slot left: found at the word's top valid bit
+    for (int i = 9; i < cap - 1; i++)
+        if (!tbl_slot_is_used(page, i)) assert(tbl_slot_mark_used(page, i) == TABLE_OK);
+    assert(tbl_slot_mark_free(page, cap - 1) == TABLE_OK);
+    assert(tbl_slot_find_free(page) == cap - 1);
+    assert(tbl_validate(page, TABLE_PAGE_SIZE) == TABLE_OK);
+}
+
+static void test_fsm_push_pop_full(void) {
+    uint8_t page[TABLE_PAGE_SIZE];
+    assert(fsm_init(page, sizeof page) == TABLE_OK);
+    assert(fsm_validate(page, sizeof page) == TABLE_OK);
+    assert(fsm_get_count(page) == 0 && fsm_top(page) == 0);
+
+    uint16_t cap = fsm_get_capacity(page);
+    assert(cap == (TABLE_PAGE_SIZE - FSM_HDR_SIZE) / 4);
+
+    // Stack order: last pushed is on top
+    assert(fsm_push(page, 7) == TABLE_OK);
+    assert(fsm_push(page, 9) == TABLE_OK);
+    assert(fsm_top(page) == 9);
+    fsm_pop(page);
+    assert(fsm_top(page) == 7 && fsm_get_count(page) == 1);
+    assert(fsm_push(page, 0) == TABLE_E_INVAL && "page 0 is never a leaf");
+
+    for (uint16_t i = 1; i < cap; i++)
+        assert(fsm_push(page, 100u + i) == TABLE_OK);
+    assert(fsm_push(page, 5) == TABLE_E_FULL);
+
+    // Wrong kind / count beyond capacity must be rejected
+    hdr_set_u16(page, FSM_HDR_COUNT_OFF, (uint16_t)(cap + 1));
+    assert(fsm_validate(page, sizeof page) == TABLE_E_LAYOUT);
+    assert(tbl_init_leaf(page, TABLE_PAGE_SIZE, TABLE_RECORD_SIZE) == TABLE_OK);
+    assert(fsm_validate(page, sizeof page) == TABLE_E_BADKIND);
+}
+
+static void test_page_sizes(void) {
+    // Capacity follows the page size; a page validates only at its own size
+    static uint8_t page[65536];
+    const struct { size_t size; uint16_t cap; } cases[] = {
+        { 4096, 31 }, { 16384, 127 }, { 65536, 511 },
+    };
+    for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+        assert(tbl_init_leaf(page, cases[i].size, TABLE_RECORD_SIZE) == TABLE_OK);
+        assert(tbl_get_capacity(page) == cases[i].cap);
+        assert(tbl_validate(page, cases[i].size) == TABLE_OK);
+        for (int k = 0; k < cases[i].cap; k++) {
+            assert(tbl_slot_find_free(page) == k);
+            assert(tbl_slot_mark_used(page, k) == TABLE_OK);
+        }
+        assert(tbl_slot_find_free(page) == -1);
+        assert(tbl_validate(page, cases[i].size) == TABLE_OK);
+        const uint8_t* last = tbl_slot_ptr(page, cases[i].cap - 1);
+        assert(last && last + TABLE_RECORD_SIZE <= page + cases[i].size);
+    }
+    assert(tbl_validate(page, 4096) == TABLE_E_LAYOUT && "64K page read as 4K");
+}
+
 int main(void) {
     test_init_and_validate_ok();
     test_find_free_basic();
@@ -234,6 +332,9 @@ int main(void) {
     test_mark_free_when_empty();
     test_slot_ptr_addresses();
     test_getters_basic();
+    test_slot_iter_and_find_free_words();
+    test_fsm_push_pop_full();
+    test_page_sizes();
     printf("All table tests passed.\n");
     return 0;
 }
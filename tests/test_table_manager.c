@@ -14,10 +14,15 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "pager.h"
 #include "table_manager.h"
 #include "table.h"
+#include "hash_index.h"
+#include "btree_index.h"
+#include "crc32c.h"
 
 // ---- small file copy helper (for tmp db from fixtures) ----------------------
 static int copy_file(const char* src, const char* dst) {
@@ -54,11 +59,11 @@ static void make_record_alt(uint8_t rec[128], uint32_t tag) {
 // ---- scan callback used by tests -------------------------------------------
 typedef struct {
   size_t seen;
-  uint32_t forbid_id;   // 0 if none
+  uint64_t forbid_id;   // 0 if none
   int forbid_seen;      // set to 1 if forbid_id is encountered
 } ScanCtx;
 
-static int count_and_check_cb(const void* rec, uint32_t id, void* user_data) {
+static int count_and_check_cb(const void* rec, uint64_t id, void* user_data) {
   (void)rec;
   ScanCtx* ctx = (ScanCtx*)user_data;
   ctx->seen++;
@@ -90,7 +95,7 @@ static void test_table_manager_e2e(void) {
   assert(buf);
   rc = pager_read(p, root, buf);
   assert(rc == PAGER_OK);
-  assert(tbl_validate(buf) == TABLE_OK);
+  assert(tbl_validate(buf, pager_page_size(p)) == TABLE_OK);
 
   uint16_t cap = tbl_get_capacity(buf);
   assert(cap >= 1);
@@ -99,13 +104,13 @@ static void test_table_manager_e2e(void) {
   // 5) Insert cap + 3 records to force chain growth
   //    Keep their IDs and payloads for later verification.
   const size_t N = (size_t)cap + 3;
-  uint32_t* ids = (uint32_t*)malloc(N * sizeof(uint32_t));
+  uint64_t* ids = (uint64_t*)malloc(N * sizeof(uint64_t));
   assert(ids);
 
   for (size_t i = 0; i < N; i++) {
     uint8_t rec[128];
     make_record(rec, (uint32_t)i);
-    uint32_t id = 0;
+    uint64_t id = 0;
     rc = tblmgr_insert(p, root, rec, &id);
     assert(rc == TABLE_OK);
     assert(id != 0);
@@ -156,13 +161,1562 @@ static void test_table_manager_e2e(void) {
   assert(rc == TABLE_OK);
 
   // 10) cleanup
+  free(ids);
   pager_close(p);
   // remove tmp file
   remove(tmp);
 }
 
+// ---- free-space map: freed slots are reused without growing the chain ------
+static void test_insert_reuses_freed_page(void) {
+  const char* tmp = "tests/tmp_tblmgr_fsm.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+
+  uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  // Fill three leaves completely
+  const size_t cap = 31;
+  const size_t N = 3 * cap;
+  uint64_t* ids = (uint64_t*)malloc(N * sizeof(uint64_t));
+  assert(ids);
+  for (size_t i = 0; i < N; i++) {
+    uint8_t rec[128];
+    make_record(rec, (uint32_t)i);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+  assert((ids[0] >> 16) == root && "first leaf is the root");
+  assert((ids[N - 1] >> 16) != root);
+
+  // Free a slot on the (full) root page: the next insert must land there
+  const uint32_t pages_before = pager_page_count(p);
+  assert(tblmgr_delete(p, ids[5]) == TABLE_OK);
+
+  uint8_t rec[128];
+  make_record(rec, 1000);
+  uint64_t id = 0;
+  assert(tblmgr_insert(p, root, rec, &id) == TABLE_OK);
+  assert(id == ids[5] && "freed slot must be reused");
+  assert(pager_page_count(p) == pages_before && "no page allocated");
+
+  // Table was full again: next insert opens exactly one new leaf
+  assert(tblmgr_insert(p, root, rec, &id) == TABLE_OK);
+  assert(pager_page_count(p) == pages_before + 1);
+  assert((id >> 16) == pages_before);
+
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  free(ids);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- tables without ownership/FSM words get their map built on insert -----
+static void test_fsm_rebuilt_for_legacy_table(void) {
+  const char* tmp = "tests/tmp_tblmgr_legacy.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+
+  uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  // Exactly one full leaf (V1 capacity = 31)
+  uint32_t first = 0;
+  for (uint32_t i = 0; i < 31; i++) {
+    uint8_t rec[128];
+    make_record(rec, i);
+    uint64_t id = 0;
+    assert(tblmgr_insert(p, root, rec, &id) == TABLE_OK);
+    if (i == 0) first = id;
+  }
+
+  // Wipe the words (and the catalog) a pre-FSM file would not have
+  for (uint32_t pg = root; pg != 0; ) {
+    void* buf = NULL;
+    assert(pager_pin_mut(p, pg, &buf) == PAGER_OK);
+    tbl_set_root_page(buf, 0);
+    tbl_set_fsm_page(buf, 0);
+    uint32_t next = tbl_get_next_page(buf);
+    assert(pager_unpin(p, buf, true) == PAGER_OK);
+    pg = next;
+  }
+  assert(pager_set_catalog(p, 0) == PAGER_OK);
+
+  // Delete on the legacy root, then insert: map rebuilt, root slot found
+  assert(tblmgr_delete(p, first) == TABLE_OK);
+  uint8_t rec[128];
+  make_record(rec, 99);
+  uint64_t id = 0;
+  assert(tblmgr_insert(p, root, rec, &id) == TABLE_OK);
+  assert(id == first);
+
+  ScanCtx ctx = {0};
+  assert(tblmgr_scan(p, root, count_and_check_cb, &ctx) == TABLE_OK);
+  assert(ctx.seen == 31);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- batched insert: page-at-a-time fill, grouped allocation --------------
+static void test_insert_batch(void) {
+  const char* tmp = "tests/tmp_tblmgr_batch.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+
+  uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  const size_t N = 1000;
+  uint8_t* recs = (uint8_t*)malloc(N * 128);
+  uint64_t* ids = (uint64_t*)malloc(N * sizeof(uint64_t));
+  assert(recs && ids);
+  for (size_t i = 0; i < N; i++) make_record(recs + i * 128, (uint32_t)i);
+
+  assert(tblmgr_insert_batch(p, root, recs, 0, NULL) == TABLE_OK);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+
+  // root + catalog + directory + FSM page + exactly enough leaves for N
+  // (capacity 31)
+  const uint32_t leaves = (uint32_t)((N + 30) / 31);
+  assert(pager_page_count(p) == root + 3 + leaves);
+
+  for (size_t i = 0; i < N; i += 97) {
+    uint8_t out[128];
+    assert(tblmgr_get(p, ids[i], out) == TABLE_OK);
+    assert(memcmp(out, recs + i * 128, 128) == 0);
+  }
+
+  // Holes left by deletes are filled first by the next batch
+  assert(tblmgr_delete(p, ids[3]) == TABLE_OK);
+  assert(tblmgr_delete(p, ids[500]) == TABLE_OK);
+  uint64_t again[2];
+  assert(tblmgr_insert_batch(p, root, recs, 2, again) == TABLE_OK);
+  assert((again[0] == ids[3] || again[0] == ids[500]) && again[0] != again[1]);
+
+  ScanCtx ctx = {0};
+  assert(tblmgr_scan(p, root, count_and_check_cb, &ctx) == TABLE_OK);
+  assert(ctx.seen == N);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+
+  free(recs);
+  free(ids);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- page sizes above the 4 KiB default ------------------------------------
+static void test_large_pages(void) {
+  const struct { uint32_t size; uint32_t cap; } cases[] = { { 16384, 127 }, { 65536, 511 } };
+  const char* tmp = "tests/tmp_tblmgr_pagesize.db";
+  char wal[64];
+  snprintf(wal, sizeof wal, "%s-wal", tmp);
+
+  for (size_t c = 0; c < sizeof cases / sizeof cases[0]; c++) {
+    remove(tmp);
+    remove(wal);
+    PagerConfig cfg = { .page_size = cases[c].size, .wal = true };
+    Pager* p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    assert(pager_page_size(p) == cases[c].size);
+
+    const uint32_t root = pager_page_count(p);
+    assert(tblmgr_create(p, root) == TABLE_OK);
+
+    const size_t N = 3000;
+    uint8_t* recs = (uint8_t*)malloc(N * 128);
+    uint64_t* ids = (uint64_t*)malloc(N * sizeof(uint64_t));
+    assert(recs && ids);
+    for (size_t i = 0; i < N; i++) make_record(recs + i * 128, (uint32_t)i);
+    assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+
+    // Leaves hold cap records each: root + catalog + directory + FSM + leaves
+    const uint32_t leaves = (uint32_t)((N + cases[c].cap - 1) / cases[c].cap);
+    assert(pager_page_count(p) == root + 3 + leaves);
+    assert((ids[cases[c].cap - 1] >> 16) == root && (ids[cases[c].cap] >> 16) != root);
+
+    assert(tblmgr_delete(p, ids[7]) == TABLE_OK);
+    assert(pager_commit(p) == PAGER_OK);
+    pager_close(p);
+
+    // Reopened with the default config: the header decides the page size
+    p = NULL;
+    assert(pager_open(tmp, &p) == PAGER_OK && p);
+    assert(pager_page_size(p) == cases[c].size);
+    for (size_t i = 8; i < N; i += 89) {
+      uint8_t out[128];
+      assert(tblmgr_get(p, ids[i], out) == TABLE_OK);
+      assert(memcmp(out, recs + i * 128, 128) == 0);
+    }
+    ScanCtx ctx = { .forbid_id = ids[7] };
+    assert(tblmgr_scan(p, root, count_and_check_cb, &ctx) == TABLE_OK);
+    assert(ctx.seen == N - 1 && ctx.forbid_seen == 0);
+    assert(tblmgr_validate_all(p, root) == TABLE_OK);
+    pager_close(p);
+
+    free(recs);
+    free(ids);
+  }
+  remove(tmp);
+  remove(wal);
+}
+
+// ---- parallel scan ----------------------------------------------------------
+typedef struct {
+  uint64_t* ids;
+  size_t    n;
+} IdList;
+
+static int collect_cb(const void* rec, uint64_t id, void* user_data) {
+  (void)rec;
+  IdList* l = (IdList*)user_data;
+  l->ids[l->n++] = id;
+  return 0;
+}
+
+typedef struct {
+  size_t   cap;        // room in each worker's list
+  IdList   merged;     // worker lists concatenated in worker order
+  unsigned inits, merges;
+} ParCtx;
+
+static void* par_init(unsigned worker, void* user_data) {
+  (void)worker;
+  ParCtx* ctx = (ParCtx*)user_data;
+  IdList* l = (IdList*)calloc(1, sizeof *l);
+  assert(l);
+  l->ids = (uint64_t*)malloc(ctx->cap * sizeof(uint64_t));
+  assert(l->ids);
+  ctx->inits++;
+  return l;
+}
+
+static int par_merge(void* worker_data, void* user_data) {
+  IdList* l = (IdList*)worker_data;
+  ParCtx* ctx = (ParCtx*)user_data;
+  memcpy(ctx->merged.ids + ctx->merged.n, l->ids, l->n * sizeof(uint64_t));
+  ctx->merged.n += l->n;
+  ctx->merges++;
+  free(l->ids);
+  free(l);
+  return 0;
+}
+
+static int stop_at_778_cb(const void* rec, uint64_t id, void* user_data) {
+  (void)id; (void)user_data;
+  const uint8_t* r = (const uint8_t*)rec;
+  return (r[0] | (r[1] << 8)) == 778 ? 42 : 0;
+}
+
+// Parallel result, merged in worker order, must equal the serial scan
+static void check_parallel_matches(Pager* p, uint32_t root, unsigned threads, const IdList* serial) {
+  ParCtx ctx = { .cap = serial->n };
+  ctx.merged.ids = (uint64_t*)malloc(serial->n * sizeof(uint64_t));
+  assert(ctx.merged.ids);
+
+  TblParallelScan opts = {
+    .threads = threads, .callback = collect_cb,
+    .worker_init = par_init, .merge = par_merge, .user_data = &ctx
+  };
+  assert(tblmgr_scan_parallel(p, root, &opts) == TABLE_OK);
+  assert(ctx.inits >= 1 && ctx.inits == ctx.merges);
+  assert(threads == 0 || ctx.inits <= threads);
+  assert(ctx.merged.n == serial->n);
+  assert(memcmp(ctx.merged.ids, serial->ids, serial->n * sizeof(uint64_t)) == 0);
+  free(ctx.merged.ids);
+}
+
+static void test_scan_parallel(void) {
+  const char* tmp = "tests/tmp_tblmgr_par.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  const size_t N = 5000;
+  uint8_t* recs = (uint8_t*)malloc(N * 128);
+  uint64_t* ids = (uint64_t*)malloc(N * sizeof(uint64_t));
+  assert(recs && ids);
+  for (size_t i = 0; i < N; i++) make_record(recs + i * 128, (uint32_t)i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  for (size_t i = 0; i < N; i += 7) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+
+  IdList serial = { (uint64_t*)malloc(N * sizeof(uint64_t)), 0 };
+  assert(serial.ids);
+  assert(tblmgr_scan(p, root, collect_cb, &serial) == TABLE_OK);
+  assert(serial.n == N - (N + 6) / 7);
+
+  check_parallel_matches(p, root, 1, &serial);
+  check_parallel_matches(p, root, 3, &serial);
+  check_parallel_matches(p, root, 8, &serial);
+  check_parallel_matches(p, root, 0, &serial);
+
+  // A failing callback stops the scan and its value is returned
+  TblParallelScan stop = { .threads = 4, .callback = stop_at_778_cb };
+  assert(tblmgr_scan_parallel(p, root, &stop) == 42);
+
+  TblParallelScan none = {0};
+  assert(tblmgr_scan_parallel(p, root, NULL) == TABLE_E_INVAL);
+  assert(tblmgr_scan_parallel(p, root, &none) == TABLE_E_INVAL);
+  pager_close(p);
+
+  // Small pool: the worker count is capped so that pins never run out
+  PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES };
+  p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  check_parallel_matches(p, root, TBLMGR_MAX_SCAN_THREADS, &serial);
+  pager_close(p);
+
+  free(serial.ids);
+  free(recs);
+  free(ids);
+  remove(tmp);
+}
+
+// ---- readers running while a writer inserts ----------------------------------
+enum { RW_INITIAL = 3000, RW_INSERTS = 12000, RW_READERS = 3 };
+
+typedef struct {
+  Pager*          p;
+  uint32_t        root;
+  const uint64_t* ids;      // the RW_INITIAL rows present before the writer starts
+  atomic_int      done;
+  atomic_int      gets, scans;
+} RwCtx;
+
+static int record_is_whole(const uint8_t* rec) {
+  const uint32_t tag = (uint32_t)rec[0] | ((uint32_t)rec[1] << 8) | ((uint32_t)rec[2] << 16) | ((uint32_t)rec[3] << 24);
+  for (int i = 4; i < 128; i++)
+    if (rec[i] != (uint8_t)(tag + i)) return 0;
+  return 1;
+}
+
+static int whole_cb(const void* rec, uint64_t id, void* user_data) {
+  (void)id;
+  assert(record_is_whole((const uint8_t*)rec) && "torn record during scan");
+  (*(size_t*)user_data)++;
+  return 0;
+}
+
+static void* rw_reader(void* arg) {
+  RwCtx* c = (RwCtx*)arg;
+  uint32_t k = 0;
+  while (!atomic_load(&c->done)) {
+    for (int i = 0; i < 64; i++) {
+      const uint32_t tag = (k++ * 7919u) % RW_INITIAL;
+      uint8_t out[128], want[128];
+      assert(tblmgr_get(c->p, c->ids[tag], out) == TABLE_OK);
+      make_record(want, tag);
+      assert(memcmp(out, want, 128) == 0);
+      atomic_fetch_add(&c->gets, 1);
+    }
+    size_t seen = 0;
+    assert(tblmgr_scan(c->p, c->root, whole_cb, &seen) == TABLE_OK);
+    assert(seen >= RW_INITIAL && seen <= RW_INITIAL + RW_INSERTS);
+    atomic_fetch_add(&c->scans, 1);
+  }
+  return NULL;
+}
+
+static void test_readers_during_insert(void) {
+  const char* tmp = "tests/tmp_tblmgr_rw.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+
+  // Small pool: the readers keep faulting leaves in while the writer evicts
+  PagerConfig cfg = { .cache_pages = 64 };
+  Pager* p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  uint8_t rec[128];
+  uint64_t* ids = (uint64_t*)malloc(RW_INITIAL * sizeof(uint64_t));
+  assert(ids);
+  for (uint32_t i = 0; i < RW_INITIAL; i++) {
+    make_record(rec, i);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+
+  RwCtx c = { .p = p, .root = root, .ids = ids };
+  pthread_t rd[RW_READERS];
+  for (int i = 0; i < RW_READERS; i++)
+    assert(pthread_create(&rd[i], NULL, rw_reader, &c) == 0);
+
+  // Single writer: new rows at the end of the chain, pages allocated on the way
+  for (uint32_t i = 0; i < RW_INSERTS; i++) {
+    make_record(rec, RW_INITIAL + i);
+    assert(tblmgr_insert(p, root, rec, NULL) == TABLE_OK);
+  }
+  atomic_store(&c.done, 1);
+  for (int i = 0; i < RW_READERS; i++)
+    assert(pthread_join(rd[i], NULL) == 0);
+  assert(atomic_load(&c.gets) > 0 && atomic_load(&c.scans) > 0);
+
+  size_t seen = 0;
+  assert(tblmgr_scan(p, root, whole_cb, &seen) == TABLE_OK && seen == RW_INITIAL + RW_INSERTS);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+
+  free(ids);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- snapshot scans while a writer updates every row -------------------------
+enum { SN_ROWS = 1000, SN_ROUNDS = 40, SN_READERS = 2 };
+
+static uint32_t rd_u32(const uint8_t* b) {
+  return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+// A row of generation `gen`: tag in bytes 0..3, gen in bytes 4..7
+static void make_gen_record(uint8_t rec[128], uint32_t tag, uint32_t gen) {
+  make_record(rec, tag);
+  memcpy(rec + 4, &gen, 4);
+}
+
+typedef struct {
+  uint32_t gen[SN_ROWS];   // generation seen per original row
+  size_t   rows;           // every row visited, appended ones included
+  uint64_t sum;            // order-independent digest of (id, record)
+} SnapView;
+
+static uint64_t row_digest(uint64_t id, const uint8_t* rec) {
+  return (id * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)rd_u32(rec) << 32 | rd_u32(rec + 4));
+}
+
+static int snap_view_cb(const void* rec, uint64_t id, void* ud) {
+  SnapView* v = (SnapView*)ud;
+  const uint8_t* r = (const uint8_t*)rec;
+  const uint32_t tag = rd_u32(r);
+  if (tag < SN_ROWS) v->gen[tag] = rd_u32(r + 4);
+  v->rows++;
+  v->sum += row_digest(id, r);
+  return 0;
+}
+
+typedef struct {
+  atomic_size_t   rows;
+  atomic_uint_fast64_t sum;
+} SnapParView;
+
+static int snap_par_cb(const void* rec, uint64_t id, void* ud) {
+  SnapParView* v = (SnapParView*)ud;
+  atomic_fetch_add(&v->rows, 1);
+  atomic_fetch_add(&v->sum, row_digest(id, (const uint8_t*)rec));
+  return 0;
+}
+
+typedef struct {
+  Pager*     p;
+  uint32_t   root;
+  uint64_t   first_id;
+  atomic_int done;
+  atomic_int snapshots;
+} SnapCtx;
+
+static void* snap_reader(void* arg) {
+  SnapCtx* c = (SnapCtx*)arg;
+  SnapView* a = malloc(sizeof *a);
+  SnapView* b = malloc(sizeof *b);
+  assert(a && b);
+  do {
+    PagerSnapshot* s = NULL;
+    assert(pager_snapshot_begin(c->p, &s) == PAGER_OK);
+    memset(a, 0, sizeof *a);
+    assert(tblmgr_scan(c->p, c->root, snap_view_cb, a) == TABLE_OK);
+
+    // Rows updated in tag order: a prefix of generation g, the rest g - 1
+    uint32_t boundaries = 0;
+    for (uint32_t t = 1; t < SN_ROWS; t++) {
+      assert(a->gen[t] == a->gen[t - 1] || a->gen[t] + 1 == a->gen[t - 1]);
+      boundaries += a->gen[t] != a->gen[t - 1];
+    }
+    assert(boundaries <= 1);
+    assert(a->rows >= SN_ROWS && a->rows - SN_ROWS <= a->gen[0]);
+
+    // Repeatable: the same rows again, serially and from every worker
+    memset(b, 0, sizeof *b);
+    assert(tblmgr_scan(c->p, c->root, snap_view_cb, b) == TABLE_OK);
+    assert(b->rows == a->rows && b->sum == a->sum && memcmp(b->gen, a->gen, sizeof a->gen) == 0);
+    SnapParView pv;
+    atomic_init(&pv.rows, 0);
+    atomic_init(&pv.sum, 0);
+    TblParallelScan opts = { .threads = 3, .callback = snap_par_cb, .user_data = &pv };
+    assert(tblmgr_scan_parallel(c->p, c->root, &opts) == TABLE_OK);
+    assert(atomic_load(&pv.rows) == a->rows && atomic_load(&pv.sum) == a->sum);
+
+    uint8_t rec[128];
+    assert(tblmgr_get(c->p, c->first_id, rec) == TABLE_OK && rd_u32(rec + 4) == a->gen[0]);
+    assert(tblmgr_update(c->p, c->first_id, rec) == TABLE_E_INVAL && "snapshots are read-only");
+    assert(pager_snapshot_end(c->p, s) == PAGER_OK);
+    atomic_fetch_add(&c->snapshots, 1);
+  } while (!atomic_load(&c->done));
+  free(a);
+  free(b);
+  return NULL;
+}
+
+static void test_snapshot_scans(void) {
+  const char* tmp = "tests/tmp_tblmgr_snap.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  const uint32_t root = 1;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  uint8_t rec[128];
+  uint64_t ids[SN_ROWS];
+  for (uint32_t t = 0; t < SN_ROWS; t++) {
+    make_gen_record(rec, t, 0);
+    assert(tblmgr_insert(p, root, rec, &ids[t]) == TABLE_OK);
+  }
+
+  SnapCtx c = { .p = p, .root = root, .first_id = ids[0] };
+  atomic_init(&c.done, 0);
+  atomic_init(&c.snapshots, 0);
+  pthread_t rd[SN_READERS];
+  for (int i = 0; i < SN_READERS; i++)
+    assert(pthread_create(&rd[i], NULL, snap_reader, &c) == 0);
+
+  // Round g rewrites every row in tag order, then appends one
+  for (uint32_t g = 1; g <= SN_ROUNDS; g++) {
+    for (uint32_t t = 0; t < SN_ROWS; t++) {
+      make_gen_record(rec, t, g);
+      assert(tblmgr_update(p, ids[t], rec) == TABLE_OK);
+    }
+    make_gen_record(rec, SN_ROWS + g, g);
+    assert(tblmgr_insert(p, root, rec, NULL) == TABLE_OK);
+  }
+  atomic_store(&c.done, 1);
+  for (int i = 0; i < SN_READERS; i++)
+    assert(pthread_join(rd[i], NULL) == 0);
+  assert(atomic_load(&c.snapshots) >= SN_READERS);
+  assert(pager_snapshot_pages(p) == 0);
+
+  SnapView* v = calloc(1, sizeof *v);
+  assert(v);
+  assert(tblmgr_scan(p, root, snap_view_cb, v) == TABLE_OK);
+  assert(v->rows == SN_ROWS + SN_ROUNDS && v->gen[0] == SN_ROUNDS && v->gen[SN_ROWS - 1] == SN_ROUNDS);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  free(v);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- vacuum: empty leaves go, records move in COMPACT mode -----------------
+typedef struct {
+  uint64_t old_id[512];
+  uint64_t new_id[512];
+  size_t   n;
+} RemapLog;
+
+static void remap_cb(uint64_t old_id, uint64_t new_id, void* ud) {
+  RemapLog* log = (RemapLog*)ud;
+  assert(log->n < 512);
+  log->old_id[log->n] = old_id;
+  log->new_id[log->n] = new_id;
+  log->n++;
+}
+
+static int find_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec;
+  *(uint32_t*)ud = id;
+  return 0;
+}
+
+static void test_vacuum(void) {
+  const char* tmp = "tests/tmp_tblmgr_vacuum.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+
+  const uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  enum { CAP = 31, N = 10 * CAP };
+  uint8_t* recs = malloc((size_t)N * 128);
+  uint64_t* ids = malloc(N * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) make_record(recs + (size_t)i * 128, i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t meta = 0;
+  assert(hidx_create(p, root, &tag, &meta) == TABLE_OK);
+
+  // Keep the first two leaves and every 5th record after them, except on
+  // the last leaf, which empties completely
+  bool kept[N];
+  uint64_t rows = 0;
+  for (uint32_t i = 0; i < N; i++) {
+    kept[i] = i < 2 * CAP || (i % 5 == 0 && i < 9 * CAP);
+    if (kept[i]) rows++;
+    else assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  }
+
+  // STABLE: only the empty leaf goes, every id still works
+  TblVacuumStats st;
+  assert(tblmgr_vacuum(p, root, NULL, &st) == TABLE_OK);
+  assert(st.leaves_freed == 1 && st.records_moved == 0);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  uint8_t rec[128];
+  for (uint32_t i = 0; i < N; i++) {
+    if (!kept[i]) continue;
+    assert(tblmgr_get(p, ids[i], rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+  }
+
+  // COMPACT: the sparse leaves are folded into the earliest free slots
+  RemapLog log = { .n = 0 };
+  TblVacuum opts = { .mode = TBLMGR_VACUUM_COMPACT, .remap = remap_cb, .user_data = &log };
+  const uint32_t free_before = pager_free_count(p);
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_OK);
+  assert(st.records_moved == log.n && log.n > 0);
+  assert(st.leaves_freed == 9 - (rows + CAP - 1) / CAP);
+  assert(pager_free_count(p) >= free_before + st.leaves_freed - st.pages_released);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+
+  uint64_t count = 0;
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == rows);
+  for (uint32_t i = 0; i < N; i++) {
+    if (!kept[i]) continue;
+    uint64_t id = ids[i];
+    for (size_t k = 0; k < log.n; k++)
+      if (log.old_id[k] == id) { id = log.new_id[k]; break; }
+    assert(tblmgr_get(p, id, rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+    uint32_t found = 0;
+    assert(hidx_find(p, meta, &i, find_cb, &found) == TABLE_OK && found == id && "index follows the move");
+  }
+  assert(hidx_validate(p, meta) == TABLE_OK);
+
+  // New leaves come from the free list before the file grows
+  const uint32_t pages = pager_page_count(p);
+  assert(tblmgr_insert_batch(p, root, recs, 2 * CAP, NULL) == TABLE_OK);
+  assert(pager_page_count(p) == pages);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+
+  // A table whose last leaves empty out gives its tail back to the file
+  const uint32_t root2 = pager_page_count(p);
+  assert(tblmgr_create(p, root2) == TABLE_OK);
+  assert(tblmgr_insert_batch(p, root2, recs, N, ids) == TABLE_OK);
+  for (uint32_t i = CAP; i < N; i++) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  const uint32_t pages2 = pager_page_count(p);
+  assert(tblmgr_vacuum(p, root2, NULL, &st) == TABLE_OK);
+  assert(st.leaves_freed == 9 && st.pages_released > 0);
+  assert(pager_page_count(p) == pages2 - st.pages_released);
+  assert(tblmgr_validate_all(p, root2) == TABLE_OK);
+  assert(tblmgr_vacuum(p, root2, &opts, &st) == TABLE_OK && st.leaves_freed == 0);
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && tblmgr_validate_all(p, root2) == TABLE_OK);
+  assert(tblmgr_count(p, root2, &count) == TABLE_OK && count == CAP);
+  pager_close(p);
+  free(recs);
+  free(ids);
+  remove(tmp);
+}
+
+// ---- 64-bit record ids -------------------------------------------------------
+typedef struct {
+  size_t   hits;
+  uint64_t id;
+} FindCtx;
+
+static int find_one_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec;
+  FindCtx* c = (FindCtx*)ud;
+  c->hits++;
+  c->id = id;
+  return 0;
+}
+
+// Rewrite the format version of a closed file (files made before 64-bit ids)
+static void set_file_version(const char* path, uint32_t version) {
+  FILE* f = fopen(path, "r+b");
+  assert(f);
+  const uint8_t v[4] = { (uint8_t)version, (uint8_t)(version >> 8), (uint8_t)(version >> 16), (uint8_t)(version >> 24) };
+  assert(fseek(f, 4, SEEK_SET) == 0 && fwrite(v, 1, 4, f) == 4);
+  fclose(f);
+}
+
+static void test_wide_ids(void) {
+  const char* tmp = "tests/tmp_tblmgr_wide.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(pager_format_version(p) == 2);
+
+  // A table past page 65535 (the file is sparse up to it)
+  const uint32_t root = 70000;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t hmeta = 0, bmeta = 0;
+  assert(hidx_create(p, root, &tag, &hmeta) == TABLE_OK);
+  const IndexKey tag2 = { .name = "tag2", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  assert(bidx_create(p, root, &tag2, &bmeta) == TABLE_OK);
+
+  enum { N = 100 };
+  uint8_t rec[128], out[128];
+  uint64_t ids[N];
+  for (uint32_t i = 0; i < N; i++) {
+    make_record(rec, i);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+  assert(ids[0] == TABLE_ID(root, 0) && ids[0] > UINT32_MAX);
+  assert(TABLE_ID_PAGE(ids[N - 1]) > root);
+
+  for (uint32_t i = 0; i < N; i++) {
+    make_record(rec, i);
+    assert(tblmgr_get(p, ids[i], out) == TABLE_OK && memcmp(rec, out, 128) == 0);
+  }
+  // Both index kinds hand the 64-bit id back
+  const uint8_t key[4] = { 77, 0, 0, 0 };
+  FindCtx fc = {0};
+  assert(hidx_find(p, hmeta, key, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[77]);
+  fc = (FindCtx){0};
+  assert(bidx_range(p, bmeta, key, key, false, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[77]);
+
+  make_record_alt(rec, 5);
+  assert(tblmgr_update(p, ids[5], rec) == TABLE_OK);
+  assert(tblmgr_delete(p, ids[6]) == TABLE_OK);
+  assert(tblmgr_get(p, ids[6], out) != TABLE_OK);
+  assert(tblmgr_get(p, TABLE_ID_MAX + 1, out) == TABLE_E_INVAL);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  assert(hidx_validate(p, hmeta) == TABLE_OK && bidx_validate(p, bmeta) == TABLE_OK);
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(tblmgr_get(p, ids[5], out) == TABLE_OK && memcmp(rec, out, 128) == 0);
+  uint64_t rows = 0;
+  assert(tblmgr_count(p, root, &rows) == TABLE_OK && rows == N - 1);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- changes that an index refuses ----------------------------------------------
+// Header page of the second index in the chain of the table at root
+static uint32_t second_index_page(Pager* p, uint32_t root) {
+  const uint8_t* rb = NULL;
+  assert(pager_pin(p, root, (const void**)&rb) == PAGER_OK);
+  const uint32_t head = tbl_get_index_page(rb);
+  pager_unpin(p, rb, false);
+  const uint8_t* hdr = NULL;
+  assert(pager_pin(p, head, (const void**)&hdr) == PAGER_OK);
+  const uint32_t second = rd_u32(hdr + TABLE_INDEX_NEXT_OFF);
+  pager_unpin(p, hdr, false);
+  assert(second != 0);
+  return second;
+}
+
+// Swap the page kind of an index header with kind[2]: an unknown kind makes
+// every change to that index fail, the swap back restores it
+static void swap_index_kind(Pager* p, uint32_t page, uint8_t kind[2]) {
+  uint8_t* hdr = NULL;
+  assert(pager_pin_mut(p, page, (void**)&hdr) == PAGER_OK);
+  for (int i = 0; i < 2; i++) {
+    const uint8_t b = hdr[i];
+    hdr[i] = kind[i];
+    kind[i] = b;
+  }
+  pager_unpin(p, hdr, true);
+}
+
+static void test_batch_index_failure(void) {
+  const char* tmp = "tests/tmp_tblmgr_batchidx.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  const uint32_t root = 1;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  const IndexKey tag2 = { .name = "tag2", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t hmeta = 0, bmeta = 0;
+  assert(hidx_create(p, root, &tag, &hmeta) == TABLE_OK);
+  assert(bidx_create(p, root, &tag2, &bmeta) == TABLE_OK);
+
+  enum { N = 10 };
+  uint8_t recs[N][128];
+  uint64_t ids[N];
+  for (uint32_t i = 0; i < N; i++) make_record(recs[i], i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+
+  // The second index of the chain is made unreadable: the first takes the
+  // key, then has to give it back
+  const uint32_t second = second_index_page(p, root);
+  assert(second == hmeta || second == bmeta);
+  uint8_t kind[2] = { 0xEE, 0xEE };
+  swap_index_kind(p, second, kind);
+
+  uint8_t more[3][128];
+  uint64_t more_ids[3] = { 7, 7, 7 };
+  for (uint32_t i = 0; i < 3; i++) make_record(more[i], N + i);
+  assert(tblmgr_insert_batch(p, root, more, 3, more_ids) == TABLE_E_BADKIND);
+  assert(more_ids[0] == 7 && more_ids[1] == 7 && more_ids[2] == 7);
+  swap_index_kind(p, second, kind);
+
+  // Nothing of the refused batch is left: rows, count and both indexes agree
+  uint64_t rows = 0;
+  assert(tblmgr_count(p, root, &rows) == TABLE_OK && rows == N);
+  SnapView* v = calloc(1, sizeof *v);
+  assert(v);
+  assert(tblmgr_scan(p, root, snap_view_cb, v) == TABLE_OK && v->rows == N);
+  free(v);
+  const uint8_t key[4] = { N, 0, 0, 0 };
+  FindCtx fc = {0};
+  assert(hidx_find(p, hmeta, key, find_one_cb, &fc) == TABLE_OK && fc.hits == 0);
+  assert(bidx_range(p, bmeta, key, key, false, find_one_cb, &fc) == TABLE_OK && fc.hits == 0);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  assert(hidx_validate(p, hmeta) == TABLE_OK && bidx_validate(p, bmeta) == TABLE_OK);
+
+  // The freed slot takes the next insert
+  uint64_t id = 0;
+  assert(tblmgr_insert(p, root, more[0], &id) == TABLE_OK);
+  assert(hidx_find(p, hmeta, key, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == id);
+  pager_close(p);
+  remove(tmp);
+}
+
+// A COMPACT move the indexes refuse leaves the record where it was
+static void test_vacuum_index_failure(void) {
+  const char* tmp = "tests/tmp_tblmgr_vacidx.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  const uint32_t root = 1;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  const IndexKey tag2 = { .name = "tag2", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t hmeta = 0, bmeta = 0;
+  assert(hidx_create(p, root, &tag, &hmeta) == TABLE_OK);
+  assert(bidx_create(p, root, &tag2, &bmeta) == TABLE_OK);
+
+  // Three leaves; the middle one empties, so the last one's records would move
+  enum { CAP = 31, N = 3 * CAP };
+  uint8_t recs[N][128];
+  uint64_t ids[N];
+  for (uint32_t i = 0; i < N; i++) make_record(recs[i], i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  for (uint32_t i = CAP; i < 2 * CAP; i++) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+
+  const uint32_t second = second_index_page(p, root);
+  uint8_t kind[2] = { 0xEE, 0xEE };
+  swap_index_kind(p, second, kind);
+  TblVacuum opts = { .mode = TBLMGR_VACUUM_COMPACT };
+  TblVacuumStats st;
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_E_BADKIND);
+  swap_index_kind(p, second, kind);
+
+  // Every record is still at its id, and both indexes say so
+  uint8_t rec[128];
+  for (uint32_t i = 0; i < N; i++) {
+    if (i >= CAP && i < 2 * CAP) continue;
+    assert(tblmgr_get(p, ids[i], rec) == TABLE_OK && memcmp(rec, recs[i], 128) == 0);
+    FindCtx fc = {0};
+    assert(hidx_find(p, hmeta, recs[i], find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[i]);
+    fc = (FindCtx){0};
+    assert(bidx_range(p, bmeta, recs[i], recs[i], false, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[i]);
+  }
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  assert(hidx_validate(p, hmeta) == TABLE_OK && bidx_validate(p, bmeta) == TABLE_OK);
+
+  // With the index back, the same vacuum goes through
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_OK && st.records_moved > 0);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  assert(hidx_validate(p, hmeta) == TABLE_OK && bidx_validate(p, bmeta) == TABLE_OK);
+  uint64_t rows = 0;
+  assert(tblmgr_count(p, root, &rows) == TABLE_OK && rows == 2 * CAP);
+  pager_close(p);
+  remove(tmp);
+}
+
+// ---- index lookups inside a snapshot ---------------------------------------
+typedef struct {
+  Pager*   p;
+  uint32_t root;
+  uint32_t tag;
+} IdxWriter;
+
+static void* idx_writer(void* arg) {
+  IdxWriter* w = (IdxWriter*)arg;
+  uint8_t rec[128];
+  make_record(rec, w->tag);
+  assert(tblmgr_insert(w->p, w->root, rec, NULL) == TABLE_OK);
+  return NULL;
+}
+
+static void test_snapshot_index_lookups(void) {
+  const char* tmp = "tests/tmp_tblmgr_snapidx.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  const uint32_t root = 1;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  const IndexKey tag2 = { .name = "tag2", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t hmeta = 0, bmeta = 0;
+  assert(hidx_create(p, root, &tag, &hmeta) == TABLE_OK);
+  assert(bidx_create(p, root, &tag2, &bmeta) == TABLE_OK);
+
+  enum { N = 300 };
+  uint8_t rec[128];
+  uint64_t ids[N];
+  for (uint32_t i = 0; i < N; i++) {
+    make_record(rec, i);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+
+  // Every lookup and validate path reads through the snapshot; a row added
+  // by another thread meanwhile stays out of it
+  PagerSnapshot* s = NULL;
+  assert(pager_snapshot_begin(p, &s) == PAGER_OK);
+  IdxWriter w = { .p = p, .root = root, .tag = N };
+  pthread_t t;
+  assert(pthread_create(&t, NULL, idx_writer, &w) == 0);
+  assert(pthread_join(t, NULL) == 0);
+
+  IndexKey got;
+  assert(hidx_get_key(p, hmeta, &got) == TABLE_OK && strcmp(got.name, "tag") == 0);
+  assert(bidx_get_key(p, bmeta, &got) == TABLE_OK && strcmp(got.name, "tag2") == 0);
+  const uint8_t key[4] = { 123, 0, 0, 0 }, added[4] = { N & 0xFF, N >> 8, 0, 0 };
+  FindCtx fc = {0};
+  assert(hidx_find(p, hmeta, key, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[123]);
+  fc = (FindCtx){0};
+  assert(bidx_range(p, bmeta, key, key, false, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[123]);
+  fc = (FindCtx){0};
+  assert(hidx_find(p, hmeta, added, find_one_cb, &fc) == TABLE_OK && fc.hits == 0);
+  assert(bidx_range(p, bmeta, added, added, false, find_one_cb, &fc) == TABLE_OK && fc.hits == 0);
+
+  BidxCursor cur;
+  assert(bidx_cursor_open(p, bmeta, NULL, NULL, false, &cur) == TABLE_OK);
+  uint64_t id = 0;
+  size_t n = 0;
+  while (bidx_cursor_next(&cur, &id, NULL) == TABLE_OK) assert(id == ids[n++]);
+  assert(n == N);
+  assert(hidx_validate(p, hmeta) == TABLE_OK && bidx_validate(p, bmeta) == TABLE_OK);
+  assert(pager_snapshot_end(p, s) == PAGER_OK);
+
+  // Back on the live pages: the new row is found
+  fc = (FindCtx){0};
+  assert(hidx_find(p, hmeta, added, find_one_cb, &fc) == TABLE_OK && fc.hits == 1);
+  fc = (FindCtx){0};
+  assert(bidx_range(p, bmeta, added, added, false, find_one_cb, &fc) == TABLE_OK && fc.hits == 1);
+  assert(hidx_validate(p, hmeta) == TABLE_OK && bidx_validate(p, bmeta) == TABLE_OK);
+  pager_close(p);
+  remove(tmp);
+}
+
+static void test_version1_file(void) {
+  const char* tmp = "tests/tmp_tblmgr_v1.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  pager_close(p);
+  set_file_version(tmp, 1);
+
+  // Version 1 files still open; their leaves must stay below page 65536
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(pager_format_version(p) == 1);
+  assert(tblmgr_create(p, 70000) == TABLE_E_FULL);
+
+  // Create near the limit: the file grows past page 65535 but only the
+  // leaves below it take rows
+  const uint32_t root = 65500;
+  assert(tblmgr_create(p, root) == TABLE_OK);
+
+  enum { N = 2000 };
+  uint8_t* recs = malloc((size_t)N * 128);
+  uint64_t ids[N];
+  assert(recs);
+  for (uint32_t i = 0; i < N; i++) make_record(recs + (size_t)i * 128, i);
+  // The batch stops once no leaf is left; the rows before it stay
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_E_FULL);
+  uint64_t rows = 0;
+  assert(tblmgr_count(p, root, &rows) == TABLE_OK && rows > 0 && rows < N);
+  for (uint64_t i = 0; i < rows; i++) assert(TABLE_ID_PAGE(ids[i]) <= TABLE_ID_V1_MAX_PAGE);
+  assert(TABLE_ID_PAGE(ids[rows - 1]) == TABLE_ID_V1_MAX_PAGE);
+  assert(pager_page_count(p) > TABLE_ID_V1_MAX_PAGE + 1);
+
+  // Index pages may lie past 65535; only the ids they hold are narrow
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t meta = 0;
+  assert(hidx_create(p, root, &tag, &meta) == TABLE_OK && meta > TABLE_ID_V1_MAX_PAGE);
+  const uint8_t key[4] = { 40, 0, 0, 0 };
+  FindCtx fc = {0};
+  assert(hidx_find(p, meta, key, find_one_cb, &fc) == TABLE_OK && fc.hits == 1 && fc.id == ids[40]);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+
+  // A freed slot takes new rows again
+  assert(tblmgr_delete(p, ids[3]) == TABLE_OK);
+  assert(tblmgr_insert(p, root, recs, &ids[3]) == TABLE_OK && TABLE_ID_PAGE(ids[3]) == root);
+  assert(tblmgr_insert(p, root, recs, &ids[4]) == TABLE_E_FULL);
+  pager_close(p);
+  free(recs);
+  remove(tmp);
+}
+
+// Read or overwrite `len` bytes of a closed file at `off`
+static void file_bytes(const char* path, long off, void* buf, size_t len, bool write) {
+  FILE* f = fopen(path, "r+b");
+  assert(f);
+  assert(fseek(f, off, SEEK_SET) == 0);
+  assert((write ? fwrite(buf, 1, len, f) : fread(buf, 1, len, f)) == len);
+  fclose(f);
+}
+
+// State of a leaf as the pager sees it right now
+static PagerPageState leaf_state(Pager* p, uint32_t page) {
+  const void* buf = NULL;
+  assert(pager_pin(p, page, &buf) == PAGER_OK);
+  const PagerPageState s = pager_page_state(p, buf);
+  assert(pager_unpin(p, buf, false) == PAGER_OK);
+  return s;
+}
+
+static void test_page_checksums(void) {
+  const char* tmp = "tests/tmp_tblmgr_crc.db";
+  remove(tmp);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  const uint32_t root = 1;
+  const size_t ps = pager_page_size(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  enum { N = 10 };
+  uint8_t rec[128], out[128];
+  uint64_t ids[N];
+  for (uint32_t i = 0; i < N; i++) {
+    make_record(rec, i);
+    assert(tblmgr_insert(p, root, rec, &ids[i]) == TABLE_OK);
+  }
+  pager_close(p);
+
+  // Write-back stamped the trailer
+  uint8_t* page = malloc(ps);
+  assert(page);
+  file_bytes(tmp, (long)(root * ps), page, ps, false);
+  const uint32_t crc = (uint32_t)page[ps - 4] | (uint32_t)page[ps - 3] << 8 |
+                       (uint32_t)page[ps - 2] << 16 | (uint32_t)page[ps - 1] << 24;
+  assert(crc != 0 && crc == crc32c(0, page, ps - TABLE_LEAF_CRC_SIZE));
+
+  // Validated once, then trusted for as long as the page stays loaded
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(leaf_state(p, root) == PAGER_PAGE_UNCHECKED);
+  assert(tblmgr_get(p, ids[3], out) == TABLE_OK);
+  assert(leaf_state(p, root) == PAGER_PAGE_TRUSTED);
+  make_record(rec, 3);
+  assert(tblmgr_get(p, ids[3], out) == TABLE_OK && memcmp(rec, out, 128) == 0);
+  pager_close(p);
+
+  // Paranoid mode never trusts a page
+  PagerConfig cfg = { .paranoid = true };
+  p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+  assert(tblmgr_get(p, ids[3], out) == TABLE_OK);
+  assert(leaf_state(p, root) == PAGER_PAGE_UNCHECKED);
+  pager_close(p);
+
+  // A flipped record byte passes the layout checks but not the checksum,
+  // through the pool and through the mapping alike
+  uint8_t b = 0;
+  const long at = (long)(root * ps + ps / 2);
+  file_bytes(tmp, at, &b, 1, false);
+  b ^= 0x40;
+  file_bytes(tmp, at, &b, 1, true);
+  for (int mapped = 0; mapped < 2; mapped++) {
+    cfg = (PagerConfig){ .read_only = mapped, .use_mmap = mapped };
+    p = NULL;
+    assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+    assert(tblmgr_get(p, ids[0], out) == TABLE_E_CORRUPT);
+    assert(leaf_state(p, root) == PAGER_PAGE_CORRUPT);
+    assert(tblmgr_validate_all(p, root) == TABLE_E_CORRUPT);
+    ScanCtx sc = {0};
+    assert(tblmgr_scan(p, root, count_and_check_cb, &sc) == TABLE_E_CORRUPT && sc.seen == 0);
+    pager_close(p);
+  }
+
+  // No checksum recorded (0): the page is only checked for layout
+  memset(page + ps - 4, 0, 4);
+  file_bytes(tmp, (long)(root * ps + ps - 4), page + ps - 4, 4, true);
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(tblmgr_get(p, ids[0], out) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK);
+  // ... and gets one again at the next write-back
+  make_record(rec, 99);
+  assert(tblmgr_update(p, ids[1], rec) == TABLE_OK);
+  pager_close(p);
+  file_bytes(tmp, (long)(root * ps), page, ps, false);
+  assert(page[ps - 1] | page[ps - 2] | page[ps - 3] | page[ps - 4]);
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(tblmgr_get(p, ids[1], out) == TABLE_OK && memcmp(rec, out, 128) == 0);
+  pager_close(p);
+
+  free(page);
+  remove(tmp);
+}
+
+// ---- transactions ------------------------------------------------------------
+static uint8_t* slurp_file(const char* path, long* len) {
+  FILE* f = fopen(path, "rb");
+  assert(f);
+  assert(fseek(f, 0, SEEK_END) == 0);
+  *len = ftell(f);
+  uint8_t* b = malloc((size_t)*len);
+  assert(b);
+  rewind(f);
+  assert(fread(b, 1, (size_t)*len, f) == (size_t)*len);
+  fclose(f);
+  return b;
+}
+
+// The file starts with want[0..len) (and ends there too unless `grown`)
+static bool file_is(const char* path, const uint8_t* want, long len, bool grown) {
+  long n = 0;
+  uint8_t* b = slurp_file(path, &n);
+  const bool same = (grown ? n >= len : n == len) && memcmp(b, want, (size_t)len) == 0;
+  free(b);
+  return same;
+}
+
+static size_t tag_hits(Pager* p, uint32_t meta, uint32_t tag, uint64_t* out_id) {
+  FindCtx c = { 0, 0 };
+  assert(hidx_find(p, meta, &tag, find_one_cb, &c) == TABLE_OK);
+  if (out_id) *out_id = c.id;
+  return c.hits;
+}
+
+// One batch job: re-key rows [0, 50), append 2 leaves of rows, delete [60, 70)
+static void txn_job(Pager* p, uint32_t root, const uint64_t* ids, uint32_t n, uint32_t cap) {
+  uint8_t rec[128];
+  for (uint32_t i = 0; i < 50; i++) {
+    make_record(rec, 100000 + i);
+    assert(tblmgr_update(p, ids[i], rec) == TABLE_OK);
+  }
+  for (uint32_t i = 0; i < 2 * cap; i++) {
+    make_record(rec, n + i);
+    assert(tblmgr_insert(p, root, rec, NULL) == TABLE_OK);
+  }
+  for (uint32_t i = 60; i < 70; i++) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  assert(tblmgr_vacuum(p, root, NULL, NULL) == TABLE_OK);
+}
+
+// Row count of a table as another thread sees it
+typedef struct {
+  Pager*   p;
+  uint32_t root;
+  uint64_t count;
+} TxnCountCtx;
+
+static void* txn_counter(void* arg) {
+  TxnCountCtx* c = arg;
+  assert(tblmgr_count(c->p, c->root, &c->count) == TABLE_OK);
+  return NULL;
+}
+
+static int txn_rows_cb(const void* rec, uint64_t id, void* ud) {
+  (void)rec; (void)id;
+  atomic_fetch_add((_Atomic size_t*)ud, 1);
+  return 0;
+}
+
+static void test_transactions(void) {
+  const char* tmp = "tests/tmp_tblmgr_txn.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+  assert(tblmgr_txn_begin(p) == TABLE_E_INVAL && "needs the log");
+  pager_close(p);
+  PagerConfig cfg = { .wal = true };
+  p = NULL;
+  assert(pager_open_ex(tmp, &cfg, &p) == PAGER_OK && p);
+
+  const uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  enum { CAP = 31, N = 4 * CAP };
+  uint8_t* recs = malloc((size_t)N * 128);
+  uint64_t ids[N];
+  assert(recs);
+  for (uint32_t i = 0; i < N; i++) make_record(recs + (size_t)i * 128, i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t meta = 0;
+  assert(hidx_create(p, root, &tag, &meta) == TABLE_OK);
+
+  assert(tblmgr_txn_commit(p) == TABLE_E_INVAL && tblmgr_txn_abort(p) == TABLE_E_INVAL);
+  assert(pager_checkpoint(p) == PAGER_OK);   // everything above, into the file
+  assert(tblmgr_txn_begin(p) == TABLE_OK);
+  long len = 0;
+  uint8_t* before = slurp_file(tmp, &len);
+  assert(tblmgr_txn_begin(p) == TABLE_E_INVAL);
+
+  // Nothing reaches the file until the end (new pages only grow it); an
+  // abort undoes all of it
+  txn_job(p, root, ids, N, CAP);
+  assert(tag_hits(p, meta, 100000, NULL) == 1 && tag_hits(p, meta, 0, NULL) == 0);
+  assert(file_is(tmp, before, len, true));
+
+  // Other threads still count the rows of begin; a parallel scan started
+  // by the transaction sees its changes
+  TxnCountCtx cc = { .p = p, .root = root };
+  pthread_t t;
+  assert(pthread_create(&t, NULL, txn_counter, &cc) == 0);
+  pthread_join(t, NULL);
+  assert(cc.count == N);
+  _Atomic size_t rows = 0;
+  TblParallelScan par = { .threads = 4, .callback = txn_rows_cb, .user_data = (void*)&rows };
+  assert(tblmgr_scan_parallel(p, root, &par) == TABLE_OK && atomic_load(&rows) == N + 2 * CAP - 10);
+  assert(tblmgr_txn_abort(p) == TABLE_OK);
+  assert(file_is(tmp, before, len, false));
+
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  uint64_t count = 0;
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == N);
+  uint8_t rec[128];
+  uint64_t id = 0;
+  for (uint32_t i = 0; i < N; i++) {
+    assert(tblmgr_get(p, ids[i], rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+    assert(tag_hits(p, meta, i, &id) == 1 && id == ids[i]);
+  }
+  assert(tag_hits(p, meta, 100000, NULL) == 0 && tag_hits(p, meta, N, NULL) == 0);
+
+  // Commit: the same job lands whole, and survives a reopen
+  assert(tblmgr_txn_begin(p) == TABLE_OK);
+  txn_job(p, root, ids, N, CAP);
+  assert(tblmgr_txn_commit(p) == TABLE_OK);
+  pager_close(p);
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == N + 2 * CAP - 10);
+  assert(tag_hits(p, meta, 100049, &id) == 1 && id == ids[49] && tag_hits(p, meta, 49, NULL) == 0);
+  assert(tag_hits(p, meta, N + 2 * CAP - 1, NULL) == 1 && tag_hits(p, meta, 65, NULL) == 0);
+  assert(tblmgr_get(p, ids[70], rec) == TABLE_OK && memcmp(rec, recs + 70 * 128, 128) == 0);
+  pager_close(p);
+  free(before);
+  free(recs);
+  remove(tmp);
+}
+
+// ---- packed leaves: vacuum PACK folds full leaves into compressed pages -----
+// Archival rows: u32 tag, short NUL-padded strings, a small age
+static void make_cold_record(uint8_t rec[128], uint32_t tag) {
+  static const char* cities[] = { "Paris", "Lyon", "Tokyo", "Oslo" };
+  memset(rec, 0, 128);
+  rec[0] = (uint8_t)(tag & 0xFF);
+  rec[1] = (uint8_t)((tag >> 8) & 0xFF);
+  rec[2] = (uint8_t)((tag >> 16) & 0xFF);
+  rec[3] = (uint8_t)((tag >> 24) & 0xFF);
+  snprintf((char*)rec + 4, 28, "user%u", tag);
+  rec[32] = (uint8_t)(20 + tag % 50);
+  memcpy(rec + 33, cities[tag % 4], strlen(cities[tag % 4]));
+}
+
+static uint64_t remapped(const RemapLog* log, uint64_t id) {
+  for (size_t k = 0; k < log->n; k++)
+    if (log->old_id[k] == id) return log->new_id[k];
+  return id;
+}
+
+static void test_packed_leaves(void) {
+  const char* tmp = "tests/tmp_tblmgr_packed.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+
+  const uint32_t root = pager_page_count(p);
+  assert(tblmgr_create(p, root) == TABLE_OK);
+  enum { CAP = 31, N = 12 * CAP };
+  uint8_t* recs = malloc((size_t)N * 128);
+  uint64_t* ids = malloc(N * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) make_cold_record(recs + (size_t)i * 128, i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t meta = 0;
+  assert(hidx_create(p, root, &tag, &meta) == TABLE_OK);
+
+  // Leaf 4 loses three rows and stays a plain leaf; the root and the tail
+  // are never packed
+  bool kept[N];
+  for (uint32_t i = 0; i < N; i++) {
+    kept[i] = i < 4 * CAP || i >= 4 * CAP + 3;
+    if (!kept[i]) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  }
+  const uint32_t in_use = pager_page_count(p) - pager_free_count(p);
+
+  RemapLog log = { .n = 0 };
+  TblVacuum opts = { .mode = TBLMGR_VACUUM_PACK, .remap = remap_cb, .user_data = &log };
+  TblVacuumStats st;
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_OK);
+  assert(st.leaves_packed == 1 && st.records_moved == log.n && log.n > 0);
+  assert(pager_page_count(p) - pager_free_count(p) <= in_use - 8);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+
+  uint64_t count = 0;
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == N - 3);
+  uint8_t rec[128];
+  uint64_t id = 0;
+  for (uint32_t i = 0; i < N; i++) {
+    if (!kept[i]) { assert(tag_hits(p, meta, i, NULL) == 0); continue; }
+    ids[i] = remapped(&log, ids[i]);
+    assert(tblmgr_get(p, ids[i], rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+    assert(tag_hits(p, meta, i, &id) == 1 && id == ids[i]);
+  }
+
+  // Scans see the packed rows like any other
+  IdList all = { malloc(N * sizeof(uint64_t)), 0 };
+  assert(all.ids);
+  assert(tblmgr_scan(p, root, collect_cb, &all) == TABLE_OK && all.n == N - 3);
+  free(all.ids);
+
+  // Leaf 1 went first: its rows are packed now
+  const uint32_t packed = TABLE_ID_PAGE(ids[CAP]);
+  assert(TABLE_ID_PAGE(ids[2 * CAP]) == packed);
+
+  // Deletes and updates work in place; an update that no longer compresses
+  // is refused and changes nothing
+  assert(tblmgr_delete(p, ids[CAP]) == TABLE_OK);
+  assert(tblmgr_get(p, ids[CAP], rec) == TABLE_E_INVAL && tag_hits(p, meta, CAP, NULL) == 0);
+  make_cold_record(rec, 90000);
+  assert(tblmgr_update(p, ids[CAP + 1], rec) == TABLE_OK);
+  assert(tag_hits(p, meta, 90000, &id) == 1 && id == ids[CAP + 1] && tag_hits(p, meta, CAP + 1, NULL) == 0);
+  int full = 0;
+  for (uint32_t i = 2 * CAP; i < 4 * CAP && !full; i++) {
+    make_record(rec, 50000 + i);
+    const int rc = tblmgr_update(p, ids[i], rec);
+    assert(rc == TABLE_OK || rc == TABLE_E_FULL);
+    if (rc == TABLE_E_FULL) {
+      full = 1;
+      assert(tblmgr_get(p, ids[i], rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+      assert(tag_hits(p, meta, i, NULL) == 1 && tag_hits(p, meta, 50000 + i, NULL) == 0);
+    }
+  }
+  assert(full && "incompressible updates overflow the page");
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+
+  // New rows go to plain leaves; a second pass leaves the packed page be
+  assert(tblmgr_insert_batch(p, root, recs, 2 * CAP, NULL) == TABLE_OK);
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_OK);
+  opts.mode = TBLMGR_VACUUM_COMPACT;
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  const uint64_t rows = count - 1 + 2 * CAP;
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == rows);
+  pager_close(p);
+
+  // The packed page survives a reopen and is checksummed like a leaf
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  const uint64_t probe = remapped(&log, ids[3 * CAP]);
+  assert(tblmgr_get(p, probe, rec) == TABLE_OK);
+  const size_t ps = pager_page_size(p);
+  const long page_off = (long)TABLE_ID_PAGE(probe) * (long)ps;
+  pager_close(p);
+  uint8_t b = 0;
+  file_bytes(tmp, page_off + (long)ps - 1, &b, 1, false);
+  b ^= 0x01;
+  file_bytes(tmp, page_off + (long)ps - 1, &b, 1, true);
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK);
+  assert(tblmgr_get(p, probe, rec) == TABLE_E_CORRUPT);
+  pager_close(p);
+  free(recs);
+  free(ids);
+  remove(tmp);
+}
+
+// ---- PAX leaves: records stored by column -----------------------------------
+typedef struct {
+  const TblFields* fields;
+  size_t           rows;
+  uint64_t         tags;     // sum of the tags seen
+} FieldScan;
+
+// Bytes outside the asked fields read as zero (the scan buffer starts so)
+static int field_scan_cb(const void* rec, uint64_t id, void* ud) {
+  (void)id;
+  FieldScan* s = (FieldScan*)ud;
+  const uint8_t* r = (const uint8_t*)rec;
+  for (unsigned k = 0; k < 128; k++)
+    if (!(s->fields->bytes[k / 64] >> (k % 64) & 1u)) assert(r[k] == 0);
+  s->tags += (uint32_t)r[0] | (uint32_t)r[1] << 8 | (uint32_t)r[2] << 16 | (uint32_t)r[3] << 24;
+  s->rows++;
+  return 0;
+}
+
+static int par_rows_cb(const void* rec, uint64_t id, void* ud) {
+  (void)id;
+  const uint8_t* r = (const uint8_t*)rec;
+  assert(r[4] == 0);                      // name not asked for
+  atomic_fetch_add((_Atomic size_t*)ud, 1);
+  return 0;
+}
+
+static void test_pax_table(void) {
+  const char* tmp = "tests/tmp_tblmgr_pax.db";
+  assert(copy_file("tests/fixtures/valid.db", tmp) == 0);
+  Pager* p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK && p);
+
+  // tag, name, age, city; the rest of the record is one more column
+  PaxLayout layout;
+  pax_layout_init(&layout);
+  assert(pax_layout_add(&layout, 0, 4) == TABLE_OK && pax_layout_add(&layout, 4, 28) == TABLE_OK);
+  assert(pax_layout_add(&layout, 32, 1) == TABLE_OK && pax_layout_add(&layout, 33, 16) == TABLE_OK);
+  const uint32_t root = pager_page_count(p);
+  assert(tblmgr_create_pax(p, root, &layout) == TABLE_OK);
+  assert(tblmgr_create_pax(p, root, &layout) == TABLE_OK);   // same layout: idempotent
+  PaxLayout other = layout;
+  assert(pax_layout_add(&other, 100, 4) == TABLE_OK);
+  assert(tblmgr_create_pax(p, root, &other) == TABLE_E_INVAL);
+  assert(tblmgr_create(p, root) == TABLE_E_INVAL);
+
+  enum { CAP = 31, N = 10 * CAP + 7 };
+  uint8_t* recs = malloc((size_t)N * 128);
+  uint64_t* ids = malloc(N * sizeof *ids);
+  assert(recs && ids);
+  for (uint32_t i = 0; i < N; i++) make_cold_record(recs + (size_t)i * 128, i);
+  assert(tblmgr_insert_batch(p, root, recs, N, ids) == TABLE_OK);
+  const IndexKey tag = { .name = "tag", .off = 0, .len = 4, .type = INDEX_KEY_U32 };
+  uint32_t meta = 0;
+  assert(hidx_create(p, root, &tag, &meta) == TABLE_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+
+  uint8_t rec[128];
+  uint8_t* page = malloc(pager_page_size(p));
+  assert(page);
+  assert(pager_read(p, TABLE_ID_PAGE(ids[N - 1]), page) == PAGER_OK);
+  assert(tbl_get_kind(page) == TABLE_PAGE_KIND_PAX && tbl_get_capacity(page) == CAP);
+  PaxLayout have;
+  pax_layout_of(page, &have);
+  assert(have.n == 5 && memcmp(have.start, layout.start, 5) == 0);
+  for (uint32_t i = 0; i < N; i++) {
+    assert(tblmgr_get(p, ids[i], rec) == TABLE_OK && memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+    assert(tag_hits(p, meta, i, NULL) == 1);
+  }
+
+  // A filtered scan tests the minipages; the same rows as a filter of the records
+  TblPred where;
+  pred_init(&where);
+  PredTerm t;
+  memset(&t, 0, sizeof t);
+  t.off = 33; t.len = 16; t.type = INDEX_KEY_STR; t.op = PRED_PREFIX; t.n = 4;
+  memcpy(t.a, "Lyon", 4);
+  assert(pred_add(&where, &t) == TABLE_OK);
+  memset(&t, 0, sizeof t);
+  t.off = 32; t.len = 1; t.type = INDEX_KEY_U8; t.op = PRED_LT; t.a[0] = 40;
+  assert(pred_add(&where, &t) == TABLE_OK);
+  IdList hits = { malloc(N * sizeof(uint64_t)), 0 };
+  assert(hits.ids);
+  assert(tblmgr_scan_where(p, root, &where, collect_cb, &hits) == TABLE_OK);
+  size_t want = 0;
+  for (uint32_t i = 0; i < N; i++)
+    if (pred_match(&where, recs + (size_t)i * 128)) assert(hits.ids[want++] == ids[i]);
+  assert(want > 0 && hits.n == want);
+
+  // Only the asked columns are assembled
+  TblFields fields = { { 0, 0 } };
+  tblmgr_fields_add(&fields, 0, 4);
+  tblmgr_fields_add(&fields, 33, 16);
+  FieldScan fs = { &fields, 0, 0 };
+  assert(tblmgr_scan_fields(p, root, NULL, &fields, field_scan_cb, &fs) == TABLE_OK);
+  assert(fs.rows == N && fs.tags == (uint64_t)N * (N - 1) / 2);
+  fs = (FieldScan){ &fields, 0, 0 };
+  assert(tblmgr_scan_fields(p, root, &where, &fields, field_scan_cb, &fs) == TABLE_OK && fs.rows == want);
+
+  _Atomic size_t par_rows = 0;
+  TblParallelScan par = { .threads = 3, .callback = par_rows_cb, .user_data = (void*)&par_rows,
+                          .where = &where, .fields = &fields };
+  assert(tblmgr_scan_parallel(p, root, &par) == TABLE_OK && atomic_load(&par_rows) == want);
+
+  // Updates and deletes write every column; indexes follow
+  make_cold_record(rec, 90000);
+  assert(tblmgr_update(p, ids[40], rec) == TABLE_OK);
+  assert(tag_hits(p, meta, 90000, NULL) == 1 && tag_hits(p, meta, 40, NULL) == 0);
+  uint8_t back[128];
+  assert(tblmgr_get(p, ids[40], back) == TABLE_OK && memcmp(back, rec, 128) == 0);
+  for (uint32_t i = CAP; i < 3 * CAP; i++)
+    if (i != 40) assert(tblmgr_delete(p, ids[i]) == TABLE_OK);
+  assert(tblmgr_get(p, ids[CAP], rec) == TABLE_E_INVAL);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+
+  // Packing is for row leaves; compacting moves PAX records like any other
+  TblVacuumStats st;
+  TblVacuum opts = { .mode = TBLMGR_VACUUM_PACK };
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_E_INVAL);
+  RemapLog log = { .n = 0 };
+  opts = (TblVacuum){ .mode = TBLMGR_VACUUM_COMPACT, .remap = remap_cb, .user_data = &log };
+  assert(tblmgr_vacuum(p, root, &opts, &st) == TABLE_OK && st.records_moved > 0 && log.n == st.records_moved);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  for (uint32_t i = 0; i < N; i++) {
+    if (i >= CAP && i < 3 * CAP && i != 40) continue;
+    ids[i] = remapped(&log, ids[i]);
+    assert(tblmgr_get(p, ids[i], rec) == TABLE_OK);
+    if (i != 40) assert(memcmp(rec, recs + (size_t)i * 128, 128) == 0);
+  }
+  uint64_t count = 0;
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == N - 2 * CAP + 1);
+
+  // New rows fill the freed slots and new leaves with the root's layout
+  assert(tblmgr_insert_batch(p, root, recs, 3 * CAP, NULL) == TABLE_OK);
+  assert(tblmgr_count(p, root, &count) == TABLE_OK && count == N + CAP + 1);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  pager_close(p);
+
+  // The minipages are checksummed like a leaf
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK);
+  assert(tblmgr_validate_all(p, root) == TABLE_OK && hidx_validate(p, meta) == TABLE_OK);
+  const uint64_t probe = ids[N - 1];
+  assert(tblmgr_get(p, probe, rec) == TABLE_OK && memcmp(rec, recs + (size_t)(N - 1) * 128, 128) == 0);
+  const size_t ps = pager_page_size(p);
+  const long page_off = (long)TABLE_ID_PAGE(probe) * (long)ps;
+  pager_close(p);
+  uint8_t b = 0;
+  file_bytes(tmp, page_off + 200, &b, 1, false);
+  b ^= 0x01;
+  file_bytes(tmp, page_off + 200, &b, 1, true);
+  p = NULL;
+  assert(pager_open(tmp, &p) == PAGER_OK);
+  assert(tblmgr_get(p, probe, rec) == TABLE_E_CORRUPT);
+  pager_close(p);
+  free(hits.ids);
+  free(page);
+  free(recs);
+  free(ids);
+  remove(tmp);
+}
+
 int main(void) {
   test_table_manager_e2e();
+  test_insert_batch();
+  test_large_pages();
+  test_scan_parallel();
+  test_readers_during_insert();
+  test_snapshot_scans();
+  test_insert_reuses_freed_page();
+  test_fsm_rebuilt_for_legacy_table();
+  test_vacuum();
+  test_wide_ids();
+  test_batch_index_failure();
+  test_vacuum_index_failure();
+  test_snapshot_index_lookups();
+  test_version1_file();
+  test_page_checksums();
+  test_transactions();
+  test_packed_leaves();
+  test_pax_table();
   printf("All table_manager tests passed.\n");
   return 0;
 }
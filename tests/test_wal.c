@@ -0,0 +1,415 @@
+#define _POSIX_C_SOURCE 200809L
+// tests/test_wal.c
+// Write-ahead log: frame format, recovery after a simulated crash, group
+// commit and checkpoints (through the Pager in WAL mode).
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pager.h"
+#include "wal.h"
+#include "crc32c.h"
+
+#define PS PAGER_PAGE_SIZE
+#define FRAME_BYTES (WAL_FRAME_HDR_SIZE + PS)
+
+// ---- helpers ----------------------------------------------------------------
+static int copy_file(const char* src, const char* dst) {
+  FILE* in = fopen(src, "rb");
+  if (!in) return -1;
+  FILE* out = fopen(dst, "wb");
+  if (!out) { fclose(in); return -1; }
+  char buf[1 << 15];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof buf, in)) > 0) {
+    if (fwrite(buf, 1, n, out) != n) { fclose(in); fclose(out); return -1; }
+  }
+  fclose(in);
+  fclose(out);
+  return 0;
+}
+
+static long file_size(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static void remove_db(const char* db) {
+  char wal[256];
+  snprintf(wal, sizeof wal, "%s-wal", db);
+  remove(db);
+  remove(wal);
+}
+
+// "Crash": snapshot the database and its log as they are on disk right now,
+// while the pager is still open.
+static void crash_copy(const char* db, const char* dst) {
+  char src_wal[256], dst_wal[256];
+  snprintf(src_wal, sizeof src_wal, "%s-wal", db);
+  snprintf(dst_wal, sizeof dst_wal, "%s-wal", dst);
+  remove_db(dst);
+  assert(copy_file(db, dst) == 0);
+  assert(copy_file(src_wal, dst_wal) == 0);
+}
+
+static void fill_page(Pager* p, uint32_t page_no, uint8_t v) {
+  uint8_t buf[PS];
+  memset(buf, v, sizeof buf);
+  assert(pager_write(p, page_no, buf) == PAGER_OK);
+}
+
+static uint8_t page_byte(Pager* p, uint32_t page_no) {
+  const void* page = NULL;
+  assert(pager_pin(p, page_no, &page) == PAGER_OK);
+  uint8_t v = ((const uint8_t*)page)[PS - 1];
+  assert(pager_unpin(p, page, false) == PAGER_OK);
+  return v;
+}
+
+// ---- tests -----------------------------------------------------------------
+static void test_crc32c_check_value(void) {
+  assert(crc32c(0, "123456789", 9) == 0xE3069283u);
+  // Chunked updates give the same result
+  uint32_t c = crc32c(0, "1234", 4);
+  assert(crc32c(c, "56789", 5) == 0xE3069283u);
+}
+
+// Bit-at-a-time reference for the table-driven and hardware paths
+static uint32_t crc32c_bitwise(const uint8_t* p, size_t len) {
+  uint32_t c = 0xFFFFFFFFu;
+  while (len--) {
+    c ^= *p++;
+    for (int k = 0; k < 8; k++) c = (c & 1u) ? (c >> 1) ^ 0x82F63B78u : (c >> 1);
+  }
+  return ~c;
+}
+
+static void test_crc32c_paths_agree(void) {
+  assert(crc32c_portable(0, "123456789", 9) == 0xE3069283u);
+  uint8_t buf[320];
+  for (size_t i = 0; i < sizeof buf; i++) buf[i] = (uint8_t)(i * 131u + 7u);
+  // Every alignment and tail length of the 8-byte strides
+  for (size_t off = 0; off < 8; off++) {
+    for (size_t len = 0; len + off <= sizeof buf; len += (len < 40 ? 1 : 37)) {
+      const uint32_t want = crc32c_bitwise(buf + off, len);
+      assert(crc32c(0, buf + off, len) == want);
+      assert(crc32c_portable(0, buf + off, len) == want);
+      // Split updates: hardware and software halves chain
+      const size_t half = len / 2;
+      assert(crc32c_portable(crc32c(0, buf + off, half), buf + off + half, len - half) == want);
+    }
+  }
+}
+
+static void test_recover_committed(void) {
+  const char* db = "tests/tmp_wal_commit.db";
+  const char* crash = "tests/tmp_wal_commit_crash.db";
+  remove_db(db);
+
+  PagerConfig cfg = { .wal = true, .wal_group_commit = 1 };
+  Pager* p = NULL;
+  assert(pager_open_ex(db, &cfg, &p) == PAGER_OK && p);
+
+  uint32_t first = 0;
+  assert(pager_alloc_pages(p, 3, &first) == PAGER_OK && first == 1);
+  fill_page(p, 1, 0x11);
+  fill_page(p, 2, 0x22);
+  fill_page(p, 3, 0x33);
+  assert(pager_commit(p) == PAGER_OK);
+
+  // 3 data frames + the header commit frame; the database file is untouched
+  char wal[256];
+  snprintf(wal, sizeof wal, "%s-wal", db);
+  assert(file_size(wal) == WAL_HDR_SIZE + 4 * FRAME_BYTES);
+
+  crash_copy(db, crash);
+  pager_close(p);
+
+  // A read-only open must not replay the log: it refuses, writing nothing
+  char crash_wal[256];
+  snprintf(crash_wal, sizeof crash_wal, "%s-wal", crash);
+  const long db_size = file_size(crash), wal_size = file_size(crash_wal);
+  PagerConfig ro = { .read_only = true };
+  p = NULL;
+  assert(pager_open_ex(crash, &ro, &p) == PAGER_E_RECOVERY && p == NULL);
+  assert(file_size(crash) == db_size && file_size(crash_wal) == wal_size);
+
+  // Recovery: the committed transaction is replayed, the log removed
+  assert(pager_open(crash, &p) == PAGER_OK && p);
+  assert(pager_page_count(p) == 4);
+  assert(page_byte(p, 1) == 0x11);
+  assert(page_byte(p, 3) == 0x33);
+  pager_close(p);
+  assert(file_size(crash_wal) < 0 && "log is removed after recovery in direct mode");
+
+  // Recovered, the file opens read-only
+  p = NULL;
+  assert(pager_open_ex(crash, &ro, &p) == PAGER_OK && p);
+  assert(pager_page_count(p) == 4 && page_byte(p, 2) == 0x22);
+  pager_close(p);
+
+  // Clean close checkpointed and removed the original log too
+  assert(file_size(wal) < 0);
+  p = NULL;
+  assert(pager_open(db, &p) == PAGER_OK && p);
+  assert(pager_page_count(p) == 4 && page_byte(p, 2) == 0x22);
+  pager_close(p);
+
+  remove_db(db);
+  remove_db(crash);
+}
+
+static void test_uncommitted_ignored(void) {
+  const char* db = "tests/tmp_wal_uncommitted.db";
+  const char* crash = "tests/tmp_wal_uncommitted_crash.db";
+  remove_db(db);
+
+  // Tiny pool: dirty pages are evicted into the log before any commit.
+  PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES, .wal = true };
+  Pager* p = NULL;
+  assert(pager_open_ex(db, &cfg, &p) == PAGER_OK && p);
+
+  uint32_t first = 0;
+  assert(pager_alloc_page(p, &first) == PAGER_OK);
+  fill_page(p, first, 0xA1);
+  assert(pager_sync(p) == PAGER_OK);   // committed + durable
+
+  const uint32_t N = 40;
+  assert(pager_alloc_pages(p, N, &first) == PAGER_OK);
+  for (uint32_t i = 0; i < N; i++)
+    fill_page(p, first + i, 0xB2);
+  fill_page(p, 1, 0xC3);
+
+  // Evicted frames are readable through the pager before the commit
+  assert(page_byte(p, first) == 0xB2);
+
+  crash_copy(db, crash);
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open(crash, &p) == PAGER_OK && p);
+  assert(pager_page_count(p) == 2 && "uncommitted allocation is rolled back");
+  assert(page_byte(p, 1) == 0xA1 && "uncommitted frame is ignored");
+  pager_close(p);
+
+  remove_db(db);
+  remove_db(crash);
+}
+
+static void test_torn_tail(void) {
+  const char* db = "tests/tmp_wal_torn.db";
+  const char* crash = "tests/tmp_wal_torn_crash.db";
+  const char* crash2 = "tests/tmp_wal_torn_crash2.db";
+  remove_db(db);
+
+  PagerConfig cfg = { .wal = true };
+  Pager* p = NULL;
+  assert(pager_open_ex(db, &cfg, &p) == PAGER_OK && p);
+
+  uint32_t no = 0;
+  assert(pager_alloc_page(p, &no) == PAGER_OK);
+  fill_page(p, no, 0x01);
+  assert(pager_commit(p) == PAGER_OK);
+  fill_page(p, no, 0x02);
+  assert(pager_commit(p) == PAGER_OK);
+  assert(pager_sync(p) == PAGER_OK);
+
+  crash_copy(db, crash);
+  crash_copy(db, crash2);
+  pager_close(p);
+
+  // Cut the second commit frame in half: only the first commit survives
+  char crash_wal[256];
+  snprintf(crash_wal, sizeof crash_wal, "%s-wal", crash);
+  assert(file_size(crash_wal) == WAL_HDR_SIZE + 4 * FRAME_BYTES);
+  assert(truncate(crash_wal, WAL_HDR_SIZE + 3 * FRAME_BYTES + FRAME_BYTES / 2) == 0);
+
+  p = NULL;
+  assert(pager_open(crash, &p) == PAGER_OK && p);
+  assert(page_byte(p, 1) == 0x01);
+  pager_close(p);
+
+  // A flipped byte in the second transaction is caught by the checksum too
+  snprintf(crash_wal, sizeof crash_wal, "%s-wal", crash2);
+  FILE* f = fopen(crash_wal, "r+b");
+  assert(f);
+  assert(fseek(f, WAL_HDR_SIZE + 2 * FRAME_BYTES + WAL_FRAME_HDR_SIZE + 100, SEEK_SET) == 0);
+  fputc(0x5A, f);
+  fclose(f);
+
+  p = NULL;
+  assert(pager_open(crash2, &p) == PAGER_OK && p);
+  assert(page_byte(p, 1) == 0x01);
+  pager_close(p);
+
+  remove_db(db);
+  remove_db(crash);
+  remove_db(crash2);
+}
+
+static void test_wal_reopen_drops_pending(void) {
+  const char* path = "tests/tmp_wal_raw.db-wal";
+  remove(path);
+
+  uint8_t page[PS];
+  memset(page, 0x7E, sizeof page);
+
+  Wal* w = NULL;
+  assert(wal_open(path, PS, &w) == PAGER_OK && w);
+  assert(wal_append(w, 5, page, 0) == PAGER_OK);
+  assert(wal_append(w, 0, page, 9) == PAGER_OK);
+  assert(wal_append(w, 6, page, 0) == PAGER_OK);   // never committed
+
+  uint32_t frame = 0;
+  assert(wal_find(w, 6, &frame) && frame == 2);
+  assert(wal_committed_frames(w) == 2 && wal_frame_count(w) == 3);
+  assert(wal_checkpoint(w, 0) == PAGER_E_INVAL && "pending frames block a checkpoint");
+  wal_close(w, false);
+
+  w = NULL;
+  assert(wal_open(path, PS, &w) == PAGER_OK && w);
+  assert(wal_frame_count(w) == 2);
+  assert(wal_commit_page_count(w) == 9);
+  assert(wal_find(w, 5, &frame) && frame == 0);
+  assert(!wal_find(w, 6, NULL));
+  wal_close(w, true);
+  assert(file_size(path) < 0);
+}
+
+static void test_wal_rollback(void) {
+  const char* path = "tests/tmp_wal_rollback.db-wal";
+  remove(path);
+
+  uint8_t page[PS];
+  memset(page, 0x7E, sizeof page);
+
+  Wal* w = NULL;
+  assert(wal_open(path, PS, &w) == PAGER_OK && w);
+  assert(wal_rollback(w) == PAGER_OK && "nothing to drop");
+  assert(wal_append(w, 5, page, 0) == PAGER_OK);
+  assert(wal_append(w, 0, page, 9) == PAGER_OK);
+  assert(wal_append(w, 5, page, 0) == PAGER_OK);   // aborted below
+  assert(wal_append(w, 6, page, 0) == PAGER_OK);
+
+  uint32_t frame = 0;
+  assert(wal_find(w, 5, &frame) && frame == 2);
+  assert(wal_rollback(w) == PAGER_OK);
+  assert(wal_frame_count(w) == 2 && wal_committed_frames(w) == 2);
+  assert(wal_find(w, 5, &frame) && frame == 0 && "back to the committed image");
+  assert(!wal_find(w, 6, NULL));
+  assert(file_size(path) == WAL_HDR_SIZE + 2 * FRAME_BYTES);
+
+  // The next transaction goes where the dropped one was
+  assert(wal_append(w, 6, page, 0) == PAGER_OK);
+  assert(wal_append(w, 0, page, 10) == PAGER_OK);
+  assert(wal_find(w, 6, &frame) && frame == 2);
+  assert(wal_committed_frames(w) == 4 && wal_frame_count(w) == 4);
+  wal_close(w, true);
+}
+
+// A transaction larger than the pool: its evicted pages reach the log before
+// the commit, and a crash before the commit frame drops them all
+static void test_txn_crash(void) {
+  const char* db = "tests/tmp_wal_txn.db";
+  const char* crash = "tests/tmp_wal_txn_crash.db";
+  const char* crash2 = "tests/tmp_wal_txn_crash2.db";
+  remove_db(db);
+
+  PagerConfig cfg = { .cache_pages = PAGER_MIN_CACHE_PAGES, .wal = true };
+  Pager* p = NULL;
+  assert(pager_open_ex(db, &cfg, &p) == PAGER_OK && p);
+  uint32_t first = 0;
+  assert(pager_alloc_page(p, &first) == PAGER_OK);
+  fill_page(p, first, 0xA1);
+  assert(pager_sync(p) == PAGER_OK);
+
+  const uint32_t N = 40;
+  assert(pager_txn_begin(p) == PAGER_OK);
+  assert(pager_alloc_pages(p, N, &first) == PAGER_OK);
+  for (uint32_t i = 0; i < N; i++)
+    fill_page(p, first + i, 0xB2);
+  fill_page(p, 1, 0xC3);
+  char wal[256];
+  snprintf(wal, sizeof wal, "%s-wal", db);
+  assert(file_size(wal) > WAL_HDR_SIZE + 2 * FRAME_BYTES && "spilled to the log");
+  assert(page_byte(p, first) == 0xB2);
+
+  crash_copy(db, crash);
+  assert(pager_txn_commit(p) == PAGER_OK);
+  crash_copy(db, crash2);
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open(crash, &p) == PAGER_OK && p);
+  assert(pager_page_count(p) == 2 && page_byte(p, 1) == 0xA1);
+  pager_close(p);
+
+  p = NULL;
+  assert(pager_open(crash2, &p) == PAGER_OK && p);
+  assert(pager_page_count(p) == 2 + N && page_byte(p, 1) == 0xC3);
+  assert(page_byte(p, first) == 0xB2 && page_byte(p, first + N - 1) == 0xB2);
+  pager_close(p);
+
+  remove_db(db);
+  remove_db(crash);
+  remove_db(crash2);
+}
+
+static void test_checkpoint_and_autocheckpoint(void) {
+  const char* db = "tests/tmp_wal_ckpt.db";
+  remove_db(db);
+  char wal[256];
+  snprintf(wal, sizeof wal, "%s-wal", db);
+
+  PagerConfig cfg = { .wal = true, .wal_group_commit = 4, .wal_autocheckpoint = 8 };
+  Pager* p = NULL;
+  assert(pager_open_ex(db, &cfg, &p) == PAGER_OK && p);
+
+  uint32_t no = 0;
+  assert(pager_alloc_page(p, &no) == PAGER_OK);
+
+  // Each commit logs 2 frames (page 1 + header): the log never reaches 8 + 2
+  for (int i = 0; i < 20; i++) {
+    fill_page(p, no, (uint8_t)i);
+    assert(pager_commit(p) == PAGER_OK);
+    assert(file_size(wal) < WAL_HDR_SIZE + 10 * FRAME_BYTES);
+  }
+  assert(page_byte(p, no) == 19);
+
+  // Nothing dirty: a commit appends nothing
+  long before = file_size(wal);
+  assert(pager_commit(p) == PAGER_OK);
+  assert(file_size(wal) == before);
+
+  assert(pager_checkpoint(p) == PAGER_OK);
+  assert(file_size(wal) == WAL_HDR_SIZE && "checkpoint empties the log");
+
+  // Checkpointed data lives in the database file itself
+  FILE* f = fopen(db, "rb");
+  assert(f);
+  assert(fseek(f, (long)no * PS + PS - 1, SEEK_SET) == 0);
+  assert(fgetc(f) == 19);
+  fclose(f);
+
+  pager_close(p);
+  assert(file_size(wal) < 0);
+  remove_db(db);
+}
+
+int main(void) {
+  test_crc32c_check_value();
+  test_crc32c_paths_agree();
+  test_recover_committed();
+  test_uncommitted_ignored();
+  test_torn_tail();
+  test_wal_reopen_drops_pending();
+  test_wal_rollback();
+  test_txn_crash();
+  test_checkpoint_and_autocheckpoint();
+  printf("All WAL tests passed.\n");
+  return 0;
+}